@@ -9,19 +9,27 @@
 #include "src/battery/BATTERIES.h"
 #include "src/charger/CHARGERS.h"
 #include "src/communication/Transmitter.h"
+#include "src/communication/can/can_replay.h"
 #include "src/communication/can/comm_can.h"
 #include "src/communication/contactorcontrol/comm_contactorcontrol.h"
 #include "src/communication/equipmentstopbutton/comm_equipmentstopbutton.h"
 #include "src/communication/nvm/comm_nvm.h"
 #include "src/communication/precharge_control/precharge_control.h"
 #include "src/communication/rs485/comm_rs485.h"
+#include "src/datalayer/cell_array.h"
 #include "src/datalayer/datalayer.h"
+#include "src/datalayer/datalayer_snapshot.h"
+#include "src/datalayer/history.h"
+#include "src/datalayer/pack_array.h"
 #include "src/devboard/display/display.h"
 #include "src/devboard/mqtt/mqtt.h"
 #include "src/devboard/sdcard/sdcard.h"
+#include "src/devboard/utils/event_journal.h"
 #include "src/devboard/utils/events.h"
 #include "src/devboard/utils/led_handler.h"
 #include "src/devboard/utils/logging.h"
+#include "src/devboard/utils/millis64.h"
+#include "src/devboard/utils/perf_stats.h"
 #include "src/devboard/utils/time_meas.h"
 #include "src/devboard/utils/timer.h"
 #include "src/devboard/utils/types.h"
@@ -50,6 +58,7 @@ TaskHandle_t main_loop_task;
 TaskHandle_t connectivity_loop_task;
 TaskHandle_t logging_loop_task;
 TaskHandle_t mqtt_loop_task;
+TaskHandle_t journal_loop_task;
 
 Logging logging;
 
@@ -58,9 +67,14 @@ std::string mqtt_password;  //TODO, move?
 std::string http_username;  //TODO, move?
 std::string http_password;  //TODO, move?
 
-static std::list<Transmitter*> transmitters;
-void register_transmitter(Transmitter* transmitter) {
-  transmitters.push_back(transmitter);
+struct TransmitterRegistration {
+  Transmitter* transmitter;
+  int8_t perf_slot;
+};
+
+static std::list<TransmitterRegistration> transmitters;
+void register_transmitter(Transmitter* transmitter, const char* name) {
+  transmitters.push_back({transmitter, perf_register_transmitter(name)});
   DEBUG_PRINTF("transmitter registered, total: %d\n", transmitters.size());
 }
 
@@ -126,64 +140,25 @@ void logging_loop(void*) {
   }
 }
 
-void check_interconnect_available(uint8_t batteryNumber) {
-
-  if (batteryNumber == 2) {
-    if (datalayer.battery.status.voltage_dV == 0 || datalayer.battery2.status.voltage_dV == 0) {
-      return;  // Both voltage values need to be available to start check
-    }
-    uint16_t voltage_diff_battery2_towards_main =
-        abs(datalayer.battery.status.voltage_dV - datalayer.battery2.status.voltage_dV);
-    uint8_t secondsOutOfVoltageSyncBattery2 = 0;
-
-    if (voltage_diff_battery2_towards_main <= 15) {  // If we are within 1.5V between the batteries
-      clear_event(EVENT_VOLTAGE_DIFFERENCE);
-      secondsOutOfVoltageSyncBattery2 = 0;
-      if (datalayer.battery.status.bms_status == FAULT) {
-        // If main battery is in fault state, disengage the second battery
-        datalayer.system.status.battery2_allowed_contactor_closing = false;
-      } else {  // If main battery is OK, allow second battery to join
-        datalayer.system.status.battery2_allowed_contactor_closing = true;
-      }
-    } else {  //Voltage between the two packs is too large
-      set_event(EVENT_VOLTAGE_DIFFERENCE, (uint8_t)(voltage_diff_battery2_towards_main / 10));
-
-      //If we start to drift out of sync between the two packs for more than 10 seconds, open contactors
-      if (secondsOutOfVoltageSyncBattery2 < 10) {
-        secondsOutOfVoltageSyncBattery2++;
-      } else {
-        datalayer.system.status.battery2_allowed_contactor_closing = false;
-      }
-    }
-  }
+/* Erasing a journal sector stalls both cores for tens of ms, see event_journal.h. It is done while the contactors
+ * are open or not allowed to close, when a delay of the frames keeping them closed does no harm. Startup is such a
+ * moment. One sector per pass, until most of the journal is erased ahead. With the contactors closed for longer than
+ * those sectors last, further records are dropped and counted in journal_records_dropped.
+ */
+static bool journal_erase_allowed() {
+  const DATALAYER_SYSTEM_STATUS_TYPE& status = datalayer.system.status;
+  return !status.battery_allows_contactor_closing || !status.inverter_allows_contactor_closing ||
+         status.contactors_engaged == 2 || datalayer.system.info.equipment_stop_active;
+}
 
-  if (batteryNumber == 3) {
-    if (datalayer.battery.status.voltage_dV == 0 || datalayer.battery3.status.voltage_dV == 0) {
-      return;  // Both voltage values need to be available to start check
-    }
-    uint16_t voltage_diff_battery3_towards_main =
-        abs(datalayer.battery.status.voltage_dV - datalayer.battery3.status.voltage_dV);
-    uint8_t secondsOutOfVoltageSyncBattery3 = 0;
-
-    if (voltage_diff_battery3_towards_main <= 15) {  // If we are within 1.5V between the batteries
-      clear_event(EVENT_VOLTAGE_DIFFERENCE);
-      secondsOutOfVoltageSyncBattery3 = 0;
-      if (datalayer.battery.status.bms_status == FAULT) {
-        // If main battery is in fault state, disengage the second battery
-        datalayer.system.status.battery3_allowed_contactor_closing = false;
-      } else {  // If main battery is OK, allow second battery to join
-        datalayer.system.status.battery3_allowed_contactor_closing = true;
-      }
-    } else {  //Voltage between the two packs is too large
-      set_event(EVENT_VOLTAGE_DIFFERENCE, (uint8_t)(voltage_diff_battery3_towards_main / 10));
-
-      //If we start to drift out of sync between the two packs for more than 10 seconds, open contactors
-      if (secondsOutOfVoltageSyncBattery3 < 10) {
-        secondsOutOfVoltageSyncBattery3++;
-      } else {
-        datalayer.system.status.battery3_allowed_contactor_closing = false;
-      }
+void journal_loop(void*) {
+  while (true) {
+    if (journal_erase_allowed()) {
+      event_journal.erase_ahead(1);
     }
+    event_journal.flush();
+    datalayer.system.status.journal_records_dropped = event_journal.dropped();
+    delay(INTERVAL_200_MS);
   }
 }
 
@@ -206,185 +181,8 @@ void update_calculated_values(unsigned long currentMillis) {
     datalayer.battery.settings.max_remote_set_discharge_dA = 0;
   }
 
-  /* Calculate allowed charge/discharge currents*/
-  if (datalayer.battery.status.voltage_dV > 10) {
-    // Only update value when we have voltage available to avoid div0. TODO: This should be based on nominal voltage
-    datalayer.battery.status.max_charge_current_dA =
-        ((datalayer.battery.status.max_charge_power_W * 100) / datalayer.battery.status.voltage_dV);
-    datalayer.battery.status.max_discharge_current_dA =
-        ((datalayer.battery.status.max_discharge_power_W * 100) / datalayer.battery.status.voltage_dV);
-  }
-
-  /* Apply remote restrictions if set*/
-  if (datalayer.battery.settings.remote_settings_limit_charge) {
-    if (datalayer.battery.status.max_charge_current_dA > datalayer.battery.settings.max_remote_set_charge_dA) {
-      datalayer.battery.status.max_charge_current_dA = datalayer.battery.settings.max_remote_set_charge_dA;
-    }
-  } else {
-    /* Restrict values from user settings if needed*/
-    if (datalayer.battery.status.max_charge_current_dA > datalayer.battery.settings.max_user_set_charge_dA) {
-      datalayer.battery.status.max_charge_current_dA = datalayer.battery.settings.max_user_set_charge_dA;
-      datalayer.battery.settings.user_settings_limit_charge = true;
-    } else {
-      datalayer.battery.settings.user_settings_limit_charge = false;
-    }
-  }
-
-  /* Apply remote restrictions if set*/
-  if (datalayer.battery.settings.remote_settings_limit_discharge) {
-    if (datalayer.battery.status.max_discharge_current_dA > datalayer.battery.settings.max_remote_set_charge_dA) {
-      datalayer.battery.status.max_discharge_current_dA = datalayer.battery.settings.max_remote_set_discharge_dA;
-    }
-  } else {
-    /* Restrict values from user settings if needed*/
-    if (datalayer.battery.status.max_discharge_current_dA > datalayer.battery.settings.max_user_set_discharge_dA) {
-      datalayer.battery.status.max_discharge_current_dA = datalayer.battery.settings.max_user_set_discharge_dA;
-      datalayer.battery.settings.user_settings_limit_discharge = true;
-    } else {
-      datalayer.battery.settings.user_settings_limit_discharge = false;
-    }
-  }
-
-  /* Calculate active power based on voltage and current*/
-  datalayer.battery.status.active_power_W =
-      (datalayer.battery.status.current_dA * (datalayer.battery.status.voltage_dV / 100));
-  /* Calculate if battery or inverter is limiting factor*/
-
-  if (datalayer.battery.status.current_dA == 0) {  //Battery idle
-    if (datalayer.battery.status.max_discharge_current_dA > 0) {
-      //We allow discharge, but inverter does nothing. Inverter is limiting
-      datalayer.battery.settings.inverter_limits_discharge = true;
-    } else {
-      datalayer.battery.settings.inverter_limits_discharge = false;
-    }
-    if (datalayer.battery.status.max_charge_current_dA > 0) {
-      //We allow charge, but inverter does nothing. Inverter is limiting
-      datalayer.battery.settings.inverter_limits_charge = true;
-    } else {
-      datalayer.battery.settings.inverter_limits_charge = false;
-    }
-  } else if (datalayer.battery.status.current_dA < 0) {  //Battery discharging
-    if (-datalayer.battery.status.current_dA < datalayer.battery.status.max_discharge_current_dA) {
-      datalayer.battery.settings.inverter_limits_discharge = true;
-    } else {
-      datalayer.battery.settings.inverter_limits_discharge = false;
-    }
-  } else {  // > 0 Battery charging
-    //If actual current is smaller than max we allow, inverter is limiting factor
-    if (datalayer.battery.status.current_dA < datalayer.battery.status.max_charge_current_dA) {
-      datalayer.battery.settings.inverter_limits_charge = true;
-    } else {
-      datalayer.battery.settings.inverter_limits_charge = false;
-    }
-  }
-
-  if (battery2) {
-    /* Calculate active power based on voltage and current for battery 2*/
-    datalayer.battery2.status.active_power_W =
-        (datalayer.battery2.status.current_dA * (datalayer.battery2.status.voltage_dV / 100));
-  }
-  if (battery3) {
-    /* Calculate active power based on voltage and current for battery 2*/
-    datalayer.battery3.status.active_power_W =
-        (datalayer.battery3.status.current_dA * (datalayer.battery3.status.voltage_dV / 100));
-  }
-
-  if (datalayer.battery.settings.soc_scaling_active) {
-    /** SOC Scaling
-   * A static version of a stochastic oscillator. The scaled SoC is calculated as:
-   * 
-   *     10000 * (real_soc - min_percentage)
-   * ---------------------------------------
-   *     (max_percentage - min_percentage)
-   * 
-   * And scaled capacity is:
-   * 
-   *     reported_total_capacity_Wh = total_capacity_Wh * (max - min) / 10000
-   *     reported_remaining_capacity_Wh = reported_total_capacity_Wh * scaled_soc / 10000
-   */
-    // Compute delta_pct and clamped_soc
-    int32_t delta_pct = datalayer.battery.settings.max_percentage - datalayer.battery.settings.min_percentage;
-    int32_t clamped_soc = CONSTRAIN(datalayer.battery.status.real_soc, datalayer.battery.settings.min_percentage,
-                                    datalayer.battery.settings.max_percentage);
-    int32_t scaled_soc = 0;
-    int32_t scaled_total_capacity = 0;
-    if (delta_pct != 0) {  //Safeguard against division by 0
-      scaled_soc = 10000 * (clamped_soc - datalayer.battery.settings.min_percentage) / delta_pct;
-    }
-
-    datalayer.battery.status.reported_soc = scaled_soc;
-
-    // If battery info is valid
-    if (datalayer.battery.info.total_capacity_Wh > 0 && datalayer.battery.status.real_soc > 0) {
-      // Scale total usable capacity
-      scaled_total_capacity = (datalayer.battery.info.total_capacity_Wh * delta_pct) / 10000;
-      datalayer.battery.info.reported_total_capacity_Wh = scaled_total_capacity;
-
-      // Scale remaining capacity based on scaled SOC
-      datalayer.battery.status.reported_remaining_capacity_Wh = (scaled_total_capacity * scaled_soc) / 10000;
-
-    } else {
-      // Fallback if scaling cannot be performed
-      datalayer.battery.info.reported_total_capacity_Wh = datalayer.battery.info.total_capacity_Wh;
-      datalayer.battery.status.reported_remaining_capacity_Wh = datalayer.battery.status.remaining_capacity_Wh;
-    }
-
-    if (battery2) {
-      // If battery info is valid
-      if (datalayer.battery2.info.total_capacity_Wh > 0 && datalayer.battery.status.real_soc > 0) {
-
-        datalayer.battery2.info.reported_total_capacity_Wh = scaled_total_capacity;
-        // Scale remaining capacity based on scaled SOC
-        datalayer.battery2.status.reported_remaining_capacity_Wh = (scaled_total_capacity * scaled_soc) / 10000;
-
-      } else {
-        // Fallback if scaling cannot be performed
-        datalayer.battery2.info.reported_total_capacity_Wh = datalayer.battery2.info.total_capacity_Wh;
-        datalayer.battery2.status.reported_remaining_capacity_Wh = datalayer.battery2.status.remaining_capacity_Wh;
-      }
-
-      //Since we are running double battery, the scaled value of battery1 becomes the sum of battery1+battery2
-      //This way the inverter connected to the system sees both batteries as one large battery
-      datalayer.battery.info.reported_total_capacity_Wh += datalayer.battery2.info.reported_total_capacity_Wh;
-      datalayer.battery.status.reported_remaining_capacity_Wh +=
-          datalayer.battery2.status.reported_remaining_capacity_Wh;
-    }
-
-  } else {  // soc_scaling_active == false. No SOC window wanted. Set scaled to same as real.
-    datalayer.battery.status.reported_soc = datalayer.battery.status.real_soc;
-    datalayer.battery.status.reported_remaining_capacity_Wh = datalayer.battery.status.remaining_capacity_Wh;
-    datalayer.battery.info.reported_total_capacity_Wh = datalayer.battery.info.total_capacity_Wh;
-
-    if (battery2) {
-      datalayer.battery2.status.reported_soc = datalayer.battery2.status.real_soc;
-      datalayer.battery2.status.reported_remaining_capacity_Wh = datalayer.battery2.status.remaining_capacity_Wh;
-      datalayer.battery2.info.reported_total_capacity_Wh = datalayer.battery2.info.total_capacity_Wh;
-    }
-  }
-
-  if (battery2) {
-    // Perform extra SOC sanity checks on double battery setups
-    if (datalayer.battery.status.real_soc < 100) {  //If this battery is under 1.00%, use this as SOC instead of average
-      datalayer.battery.status.reported_soc = datalayer.battery.status.real_soc;
-      datalayer.battery.status.reported_remaining_capacity_Wh = datalayer.battery.status.remaining_capacity_Wh;
-    }
-    if (datalayer.battery2.status.real_soc <
-        100) {  //If this battery is under 1.00%, use this as SOC instead of average
-      datalayer.battery.status.reported_soc = datalayer.battery2.status.real_soc;
-      datalayer.battery.status.reported_remaining_capacity_Wh = datalayer.battery2.status.remaining_capacity_Wh;
-    }
-
-    if (datalayer.battery.status.real_soc >
-        9900) {  //If this battery is over 99.00%, use this as SOC instead of average
-      datalayer.battery.status.reported_soc = datalayer.battery.status.real_soc;
-      datalayer.battery.status.reported_remaining_capacity_Wh = datalayer.battery.status.remaining_capacity_Wh;
-    }
-    if (datalayer.battery2.status.real_soc >
-        9900) {  //If this battery is over 99.00%, use this as SOC instead of average
-      datalayer.battery.status.reported_soc = datalayer.battery2.status.real_soc;
-      datalayer.battery.status.reported_remaining_capacity_Wh = datalayer.battery2.status.remaining_capacity_Wh;
-    }
-  }
+  // Current limits, SOC scaling and the joining of the other batteries to the main one
+  battery_packs.update();
 }
 
 void check_reset_reason() {
@@ -452,6 +250,9 @@ void core_loop(void*) {
 
     START_TIME_MEASUREMENT(all);
     START_TIME_MEASUREMENT(comm);
+    // Histograms of the stages, only recorded when performance measurement is active
+    const uint32_t loop_start_cycles = perf_cycles();
+    uint32_t stage_start_cycles = loop_start_cycles;
 
     monitor_equipment_stop_button();
 
@@ -460,10 +261,12 @@ void core_loop(void*) {
     receive_rs485();  // Process serial2 RS485 interface
 
     END_TIME_MEASUREMENT_MAX(comm, datalayer.system.status.time_comm_us);
+    stage_start_cycles = perf_record_stage(PERF_STAGE_COMM, stage_start_cycles);
 
     START_TIME_MEASUREMENT(ota);
     ElegantOTA.loop();
     END_TIME_MEASUREMENT_MAX(ota, datalayer.system.status.time_ota_us);
+    stage_start_cycles = perf_record_stage(PERF_STAGE_OTA, stage_start_cycles);
 
     // Process
     currentMillis = millis();
@@ -471,6 +274,7 @@ void core_loop(void*) {
       if ((currentMillis - previousMillis10ms >= INTERVAL_10_MS_DELAYED) &&
           (milliseconds(currentMillis) > esp32hal->BOOTUP_TIME())) {
         set_event(EVENT_TASK_OVERRUN, (currentMillis - previousMillis10ms));
+        perf_count_task_overrun();
       }
       previousMillis10ms = currentMillis;
       if (datalayer.system.info.performance_measurement_active) {
@@ -485,6 +289,7 @@ void core_loop(void*) {
       if (datalayer.system.info.performance_measurement_active) {
         END_TIME_MEASUREMENT_MAX(10ms, datalayer.system.status.time_10ms_us);
       }
+      stage_start_cycles = perf_record_stage(PERF_STAGE_10MS, stage_start_cycles);
     }
 
     if (currentMillis - previousMillisUpdateVal >= INTERVAL_1_S) {
@@ -501,13 +306,13 @@ void core_loop(void*) {
 
       if (battery2) {
         battery2->update_values();
-        check_interconnect_available(2);
       }
       if (battery3) {
         battery3->update_values();
-        check_interconnect_available(3);
       }
+      publish_cell_statistics(currentMillis);
       update_calculated_values(currentMillis);
+      record_history(millis64());
       update_machineryprotection();  // Check safeties
 
       // Update values heading towards inverter
@@ -515,18 +320,29 @@ void core_loop(void*) {
         inverter->update_values();
       }
 
+      // Hand the values of this round to the webserver, MQTT and display
+      publish_datalayer_snapshot();
+
       if (datalayer.system.info.performance_measurement_active) {
         END_TIME_MEASUREMENT_MAX(values, datalayer.system.status.time_values_us);
       }
+      stage_start_cycles = perf_record_stage(PERF_STAGE_VALUES, stage_start_cycles);
     }
     if (datalayer.system.info.performance_measurement_active) {
       START_TIME_MEASUREMENT(cantx);
     }
 
     // Let all transmitter objects send their messages
-    for (auto& transmitter : transmitters) {
-      transmitter->transmit(currentMillis);
+    for (auto& registration : transmitters) {
+      const uint32_t start_cycles = perf_cycles();
+      registration.transmitter->transmit(currentMillis);
+      perf_record_transmitter(registration.perf_slot, start_cycles);
     }
+    send_can_replay_frames();
+    // Send what they queued, paced to the bus, along with the periodic frames that are due
+    service_can_tx(currentMillis);
+    perf_record_stage(PERF_STAGE_CANTX, stage_start_cycles);
+    perf_record_stage(PERF_STAGE_CORE_TASK, loop_start_cycles);
 
     if (datalayer.system.info.performance_measurement_active) {
       END_TIME_MEASUREMENT_MAX(cantx, datalayer.system.status.time_cantx_us);
@@ -565,8 +381,10 @@ void mqtt_loop(void*) {
 
   while (true) {
     START_TIME_MEASUREMENT(mqtt);
+    const uint32_t start_cycles = perf_cycles();
     mqtt_client_loop();
     END_TIME_MEASUREMENT_MAX(mqtt, datalayer.system.status.mqtt_task_10s_max_us);
+    perf_record_stage(PERF_STAGE_MQTT, start_cycles);
     esp_task_wdt_reset();  // Reset watchdog
     delay(1);
   }
@@ -583,8 +401,15 @@ void setup() {
 
   init_events();
 
+  // Events set before the journal task starts wait in its queue
+  init_event_journal();
+
   init_stored_settings();
 
+  if (datalayer.system.info.performance_measurement_active) {
+    perf_stats_init();
+  }
+
   if (wifi_enabled) {
     xTaskCreatePinnedToCore((TaskFunction_t)&connectivity_loop, "connectivity_loop", 4096, NULL, TASK_CONNECTIVITY_PRIO,
                             &connectivity_loop_task, esp32hal->WIFICORE());
@@ -646,6 +471,11 @@ void setup() {
                             esp32hal->WIFICORE());
   }
 
+  if (event_journal.ready()) {
+    xTaskCreatePinnedToCore((TaskFunction_t)&journal_loop, "journal_loop", 3072, NULL, TASK_JOURNAL_PRIO,
+                            &journal_loop_task, esp32hal->WIFICORE());
+  }
+
   xTaskCreatePinnedToCore((TaskFunction_t)&core_loop, "core_loop", 4096, NULL, TASK_CORE_PRIO, &main_loop_task,
                           esp32hal->CORE_FUNCTION_CORE());
 
@@ -1,5 +1,7 @@
 #include "BATTERIES.h"
+#include "../communication/contactorcontrol/comm_contactorcontrol.h"
 #include "../datalayer/datalayer_extended.h"
+#include "../datalayer/pack_array.h"
 #include "CanBattery.h"
 #include "RS485Battery.h"
 
@@ -307,6 +309,21 @@ void setup_battery() {
       battery3->setup();
     }
   }
+
+  // The batteries the inverter sees as one, the main battery first
+  battery_packs.clear();
+  // Without contactor control for them, the other batteries close their contactors themselves
+  battery_packs.add(datalayer.battery, nullptr);
+  if (battery2) {
+    battery_packs.add(datalayer.battery2, &datalayer.system.status.battery2_allowed_contactor_closing,
+                      contactor_control_enabled_double_battery ? &datalayer.system.status.contactors_battery2_engaged
+                                                               : nullptr);
+  }
+  if (battery3) {
+    battery_packs.add(datalayer.battery3, &datalayer.system.status.battery3_allowed_contactor_closing,
+                      contactor_control_enabled_double_battery ? &datalayer.system.status.contactors_battery3_engaged
+                                                               : nullptr);
+  }
 }
 
 /* User-selected Nissan LEAF settings */
@@ -30,7 +30,7 @@ class BmwI3Battery : public CanBattery {
   }
 
   virtual void setup(void);
-  virtual void handle_incoming_can_frame(CAN_frame rx_frame);
+  virtual void handle_incoming_can_frame(const CAN_frame& rx_frame);
   virtual void update_values();
   virtual void transmit_can(unsigned long currentMillis);
   static constexpr const char* Name = "BMW i3";
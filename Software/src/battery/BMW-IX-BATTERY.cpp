@@ -255,7 +255,7 @@ void BmwIXBattery::parseDTCResponse() {
   datalayer_extended.bmwix.dtc_read_in_progress = false;
 }
 
-void BmwIXBattery::handleISOTPFrame(CAN_frame& rx_frame) {
+void BmwIXBattery::handleISOTPFrame(const CAN_frame& rx_frame) {
   uint8_t pciByte = rx_frame.data.u8[1];  // e.g., 0x10, 0x21, etc.
   uint8_t pciType = pciByte >> 4;         // top nibble => 0=SF,1=FF,2=CF,3=FC
 
@@ -554,7 +554,7 @@ void BmwIXBattery::update_values() {  //This function maps all the values fetche
   }
 }
 
-void BmwIXBattery::handle_incoming_can_frame(CAN_frame rx_frame) {
+void BmwIXBattery::handle_incoming_can_frame(const CAN_frame& rx_frame) {
   battery_awake = true;
   switch (rx_frame.ID) {
     case 0x12B8D087:
@@ -21,7 +21,7 @@ class BmwIXBattery : public CanBattery {
   BmwIXBattery() : renderer(*this) {}
 
   virtual void setup(void);
-  virtual void handle_incoming_can_frame(CAN_frame rx_frame);
+  virtual void handle_incoming_can_frame(const CAN_frame& rx_frame);
   virtual void update_values();
   virtual void transmit_can(unsigned long currentMillis);
   BatteryHtmlRenderer& get_status_renderer() { return renderer; }
@@ -676,7 +676,7 @@ CAN_frame BMWiX_49C = {.FD = true,
   bool storeUDSPayload(const uint8_t* payload, uint8_t length);
   bool isUDSMessageComplete();
   void parseDTCResponse();
-  void handleISOTPFrame(CAN_frame& rx_frame);
+  void handleISOTPFrame(const CAN_frame& rx_frame);
   void processCompletedUDSResponse();
   CAN_frame generate_433_datetime_message();
   CAN_frame generate_442_time_counter_message();
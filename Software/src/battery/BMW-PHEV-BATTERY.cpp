@@ -4,27 +4,10 @@
 #include "../communication/can/comm_can.h"
 #include "../datalayer/datalayer.h"
 #include "../datalayer/datalayer_extended.h"
+#include "../devboard/utils/crc.h"
 #include "../devboard/utils/events.h"
 #include "../devboard/utils/logging.h"
 
-const unsigned char crc8_table[256] =
-    {  // CRC8_SAE_J1850_ZER0 formula,0x1D Poly,initial value 0x3F,Final XOR value varies
-        0x00, 0x1D, 0x3A, 0x27, 0x74, 0x69, 0x4E, 0x53, 0xE8, 0xF5, 0xD2, 0xCF, 0x9C, 0x81, 0xA6, 0xBB, 0xCD, 0xD0,
-        0xF7, 0xEA, 0xB9, 0xA4, 0x83, 0x9E, 0x25, 0x38, 0x1F, 0x02, 0x51, 0x4C, 0x6B, 0x76, 0x87, 0x9A, 0xBD, 0xA0,
-        0xF3, 0xEE, 0xC9, 0xD4, 0x6F, 0x72, 0x55, 0x48, 0x1B, 0x06, 0x21, 0x3C, 0x4A, 0x57, 0x70, 0x6D, 0x3E, 0x23,
-        0x04, 0x19, 0xA2, 0xBF, 0x98, 0x85, 0xD6, 0xCB, 0xEC, 0xF1, 0x13, 0x0E, 0x29, 0x34, 0x67, 0x7A, 0x5D, 0x40,
-        0xFB, 0xE6, 0xC1, 0xDC, 0x8F, 0x92, 0xB5, 0xA8, 0xDE, 0xC3, 0xE4, 0xF9, 0xAA, 0xB7, 0x90, 0x8D, 0x36, 0x2B,
-        0x0C, 0x11, 0x42, 0x5F, 0x78, 0x65, 0x94, 0x89, 0xAE, 0xB3, 0xE0, 0xFD, 0xDA, 0xC7, 0x7C, 0x61, 0x46, 0x5B,
-        0x08, 0x15, 0x32, 0x2F, 0x59, 0x44, 0x63, 0x7E, 0x2D, 0x30, 0x17, 0x0A, 0xB1, 0xAC, 0x8B, 0x96, 0xC5, 0xD8,
-        0xFF, 0xE2, 0x26, 0x3B, 0x1C, 0x01, 0x52, 0x4F, 0x68, 0x75, 0xCE, 0xD3, 0xF4, 0xE9, 0xBA, 0xA7, 0x80, 0x9D,
-        0xEB, 0xF6, 0xD1, 0xCC, 0x9F, 0x82, 0xA5, 0xB8, 0x03, 0x1E, 0x39, 0x24, 0x77, 0x6A, 0x4D, 0x50, 0xA1, 0xBC,
-        0x9B, 0x86, 0xD5, 0xC8, 0xEF, 0xF2, 0x49, 0x54, 0x73, 0x6E, 0x3D, 0x20, 0x07, 0x1A, 0x6C, 0x71, 0x56, 0x4B,
-        0x18, 0x05, 0x22, 0x3F, 0x84, 0x99, 0xBE, 0xA3, 0xF0, 0xED, 0xCA, 0xD7, 0x35, 0x28, 0x0F, 0x12, 0x41, 0x5C,
-        0x7B, 0x66, 0xDD, 0xC0, 0xE7, 0xFA, 0xA9, 0xB4, 0x93, 0x8E, 0xF8, 0xE5, 0xC2, 0xDF, 0x8C, 0x91, 0xB6, 0xAB,
-        0x10, 0x0D, 0x2A, 0x37, 0x64, 0x79, 0x5E, 0x43, 0xB2, 0xAF, 0x88, 0x95, 0xC6, 0xDB, 0xFC, 0xE1, 0x5A, 0x47,
-        0x60, 0x7D, 0x2E, 0x33, 0x14, 0x09, 0x7F, 0x62, 0x45, 0x58, 0x0B, 0x16, 0x31, 0x2C, 0x97, 0x8A, 0xAD, 0xB0,
-        0xE3, 0xFE, 0xD9, 0xC4};
-
 /*
 INFO
 
@@ -125,14 +108,6 @@ bool BmwPhevBattery::isStale(int16_t currentValue, uint16_t& lastValue, unsigned
   return (currentTime - lastChangeTime >= STALE_PERIOD);
 }
 
-static uint8_t calculateCRC(CAN_frame rx_frame, uint8_t length, uint8_t initial_value) {
-  uint8_t crc = initial_value;
-  for (uint8_t j = 1; j < length; j++) {  //start at 1, since 0 is the CRC
-    crc = crc8_table[(crc ^ static_cast<uint8_t>(rx_frame.data.u8[j])) % 256];
-  }
-  return crc;
-}
-
 static uint8_t increment_uds_req_id_counter(uint8_t index, int numReqs) {
   index++;
   if (index >= numReqs) {
@@ -425,7 +400,7 @@ void BmwPhevBattery::update_values() {  //This function maps all the values fetc
     datalayer.battery.info.min_cell_voltage_mV = MIN_CELL_VOLTAGE_MV;
   }
 }
-void BmwPhevBattery::handle_incoming_can_frame(CAN_frame rx_frame) {
+void BmwPhevBattery::handle_incoming_can_frame(const CAN_frame& rx_frame) {
 
   //battery_awake = true; //look for specific messages
   switch (rx_frame.ID) {
@@ -816,8 +791,7 @@ void BmwPhevBattery::transmit_can(unsigned long currentMillis) {
         //BMW_10B.data.u8[1] = 0xD0;  // Close contactors v2
       }
 
-      BMW_10B.data.u8[1] = ((BMW_10B.data.u8[1] & 0xF0) + alive_counter_20ms);
-      BMW_10B.data.u8[0] = calculateCRC(BMW_10B, 3, 0x3F);
+      e2e_profile1_protect(BMW_10B, alive_counter_20ms, 3, 0x3F);
 
       alive_counter_20ms = increment_alive_counter(alive_counter_20ms);
 
@@ -838,7 +812,7 @@ void BmwPhevBattery::transmit_can(unsigned long currentMillis) {
 
       // Send 0x12F Terminal Status - counter cycles 0x20->0x2E (15 values)
       BMW_12F.data.u8[1] = 0x20 + alive_counter_100ms;
-      BMW_12F.data.u8[0] = calculateCRC(BMW_12F, BMW_12F.DLC, 0x3F);
+      BMW_12F.data.u8[0] = e2e_profile1_crc(BMW_12F, BMW_12F.DLC, 0x3F);
 
       transmit_can_frame(&BMW_12F);
 
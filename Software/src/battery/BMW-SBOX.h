@@ -11,7 +11,8 @@ class BmwSbox : public CanShunt {
  public:
   void setup();
   void transmit_can(unsigned long currentMillis);
-  void handle_incoming_can_frame(CAN_frame rx_frame);
+  void handle_incoming_can_frame(const CAN_frame& rx_frame);
+  CanIdFilter can_id_filter() { return {.min_id = 0x200, .max_id = 0x220}; }
   static constexpr const char* Name = "BMW SBOX";
 
  private:
@@ -312,7 +312,7 @@ void BydAttoBattery::
   }
 }
 
-void BydAttoBattery::handle_incoming_can_frame(CAN_frame rx_frame) {
+void BydAttoBattery::handle_incoming_can_frame(const CAN_frame& rx_frame) {
   switch (rx_frame.ID) {
     case 0x244:
       datalayer_battery->status.CAN_battery_still_alive = CAN_STILL_ALIVE;
@@ -43,7 +43,7 @@ class BydAttoBattery : public CanBattery {
   }
 
   virtual void setup(void);
-  virtual void handle_incoming_can_frame(CAN_frame rx_frame);
+  virtual void handle_incoming_can_frame(const CAN_frame& rx_frame);
   virtual void update_values();
   virtual void transmit_can(unsigned long currentMillis);
 
@@ -265,7 +265,7 @@ void ChademoBattery::process_vehicle_vendor_ID(CAN_frame rx_frame) {
       ((rx_frame.data.u8[2] << 8) | rx_frame.data.u8[1]);  //Actually more bytes, but not needed for our purpose
 }
 
-void ChademoBattery::handle_incoming_can_frame(CAN_frame rx_frame) {
+void ChademoBattery::handle_incoming_can_frame(const CAN_frame& rx_frame) {
 
   // CHADEMO coexists with a CAN-based shunt. Only process CHADEMO-specific IDs
   // 202 is unknown
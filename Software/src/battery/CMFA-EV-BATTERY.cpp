@@ -81,7 +81,7 @@ void CmfaEvBattery::
   }
 }
 
-void CmfaEvBattery::handle_incoming_can_frame(CAN_frame rx_frame) {
+void CmfaEvBattery::handle_incoming_can_frame(const CAN_frame& rx_frame) {
   switch (rx_frame.ID) {  //These frames are transmitted by the battery
     case 0x127:           //10ms , Same structure as old Zoe 0x155 message!
       datalayer_battery->status.CAN_battery_still_alive = CAN_STILL_ALIVE;
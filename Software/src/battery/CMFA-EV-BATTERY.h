@@ -29,7 +29,7 @@ class CmfaEvBattery : public CanBattery {
   void reset_DTC() { UserRequestDTCclear = true; }
 
   virtual void setup(void);
-  virtual void handle_incoming_can_frame(CAN_frame rx_frame);
+  virtual void handle_incoming_can_frame(const CAN_frame& rx_frame);
   virtual void update_values();
   virtual void transmit_can(unsigned long currentMillis);
   static constexpr const char* Name = "CMFA platform, 27 kWh battery";
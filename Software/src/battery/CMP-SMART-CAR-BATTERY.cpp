@@ -78,7 +78,7 @@ void CmpSmartCarBattery::update_values() {
   datalayer_extended.stellantisCMPsmart.rcd_line_active = rcd_line_active;
 }
 
-bool checksum_OK(CAN_frame& rx_frame, uint8_t magic_byte) {
+bool checksum_OK(const CAN_frame& rx_frame, uint8_t magic_byte) {
   // Sum all data nibbles from bytes 0-6 (excluding last byte)
   uint8_t sum = 0;
 
@@ -149,7 +149,7 @@ uint8_t calculate_checksum432(CAN_frame& rx_frame) {
   return calculated_checksum;
 }
 
-void CmpSmartCarBattery::handle_incoming_can_frame(CAN_frame rx_frame) {
+void CmpSmartCarBattery::handle_incoming_can_frame(const CAN_frame& rx_frame) {
   switch (rx_frame.ID) {
     case 0x205:  //10ms
       datalayer.battery.status.CAN_battery_still_alive = CAN_STILL_ALIVE;
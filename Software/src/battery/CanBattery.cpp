@@ -5,8 +5,8 @@ CanBattery::CanBattery(CAN_Speed speed) : CanBattery(can_config.battery, speed)
 CanBattery::CanBattery(CAN_Interface interface, CAN_Speed speed) {
   can_interface = interface;
   initial_speed = speed;
-  register_transmitter(this);
-  register_can_receiver(this, can_interface, speed);
+  register_transmitter(this, "battery");
+  register_can_receiver(this, can_interface, "battery", speed);
 }
 
 bool CanBattery::change_can_speed(CAN_Speed speed) {
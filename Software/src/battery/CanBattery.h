@@ -11,14 +11,14 @@
 // Abstract base class for batteries using the CAN bus
 class CanBattery : public Battery, Transmitter, CanReceiver {
  public:
-  virtual void handle_incoming_can_frame(CAN_frame rx_frame) = 0;
+  virtual void handle_incoming_can_frame(const CAN_frame& rx_frame) = 0;
   virtual void transmit_can(unsigned long currentMillis) = 0;
 
   const char* interface_name() { return getCANInterfaceName(can_interface); }
 
   void transmit(unsigned long currentMillis) { transmit_can(currentMillis); }
 
-  void receive_can_frame(CAN_frame* frame) { handle_incoming_can_frame(*frame); }
+  void receive_can_frame(const CAN_frame& frame) { handle_incoming_can_frame(frame); }
 
  protected:
   CAN_Interface can_interface;
@@ -30,7 +30,7 @@ class CanBattery : public Battery, Transmitter, CanReceiver {
   bool change_can_speed(CAN_Speed speed);
   void reset_can_speed();
 
-  void transmit_can_frame(const CAN_frame* frame) { transmit_can_frame_to_interface(frame, can_interface); }
+  void transmit_can_frame(const CAN_frame* frame) { queue_can_frame(frame, can_interface); }
 };
 
 #endif
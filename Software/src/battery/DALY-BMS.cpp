@@ -83,6 +83,8 @@ void DalyBms::setup(void) {  // Performs one time setup at startup
   }
 
   Serial2.begin(baud_rate(), SERIAL_8N1, rx_pin, tx_pin);
+  // 0xA5, address, command, payload length, 8 payload bytes, checksum
+  init_rs485_framing(Serial2, Rs485FrameFormat::length_prefixed(0xA5, 3, 5, 13));
 }
 
 uint8_t calculate_checksum(uint8_t buff[12]) {
@@ -186,28 +188,20 @@ void DalyBms::transmit_rs485(unsigned long currentMillis) {
   }
 }
 
-void DalyBms::receive() {
-  static uint8_t recv_buff[13] = {0};
-  static uint8_t recv_len = 0;
-
-  while (Serial2.available()) {
-    recv_buff[recv_len] = Serial2.read();
-
-    recv_len++;
-
-    if (((recv_len > 0) && (recv_buff[0] != 0xA5)) || ((recv_len > 1) && (recv_buff[1] != 0x01)) ||
-        ((recv_len > 2) && ((recv_buff[2] < 0x90) || (recv_buff[2] > 0x98))) ||
-        ((recv_len > 3) && (recv_buff[3] != 8)) ||
-        ((recv_len > 12) && (recv_buff[12] != calculate_checksum(recv_buff)))) {
-      dump_buff("dropping partial rx: ", recv_buff, recv_len);
-      recv_len = 0;
-    }
-
-    if (recv_len > 12) {
-      dump_buff("decoding successfull rx: ", recv_buff, recv_len);
-      decode_packet(recv_buff[2], &recv_buff[4]);
-      recv_len = 0;
-      lastPacket = millis();
-    }
+void DalyBms::receive_frame(const uint8_t* frame, size_t length) {
+  uint8_t recv_buff[13];
+  if (length != sizeof(recv_buff)) {
+    return;  // Payload length other than 8
   }
+  memcpy(recv_buff, frame, length);
+
+  if ((recv_buff[1] != 0x01) || (recv_buff[2] < 0x90) || (recv_buff[2] > 0x98) ||
+      (recv_buff[12] != calculate_checksum(recv_buff))) {
+    dump_buff("dropping invalid rx: ", recv_buff, length);
+    return;
+  }
+
+  dump_buff("decoding successfull rx: ", recv_buff, length);
+  decode_packet(recv_buff[2], &recv_buff[4]);
+  lastPacket = millis();
 }
@@ -8,7 +8,7 @@ class DalyBms : public RS485Battery {
   void setup();
   void update_values();
   void transmit_rs485(unsigned long currentMillis);
-  void receive();
+  void receive_frame(const uint8_t* frame, size_t length);
   static constexpr const char* Name = "DALY RS485";
 
  private:
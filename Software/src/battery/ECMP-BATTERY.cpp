@@ -1,5 +1,7 @@
 #include "ECMP-BATTERY.h"
+#include <Arduino.h>
 #include "../communication/can/comm_can.h"
+#include "../datalayer/cell_array.h"
 #include "../datalayer/datalayer.h"
 #include "../datalayer/datalayer_extended.h"  //For More Battery Info page
 #include "../devboard/utils/events.h"
@@ -59,25 +61,7 @@ void EcmpBattery::update_values() {
 
     datalayer.battery.status.temperature_max_dC = battery_highestTemperature * 10;
 
-    // Initialize min and max, lets find which cells are min and max!
-    uint16_t min_cell_mv_value = std::numeric_limits<uint16_t>::max();
-    uint16_t max_cell_mv_value = 0;
-    // Loop to find the min and max while ignoring zero values
-    for (uint8_t i = 0; i < datalayer.battery.info.number_of_cells; ++i) {
-      uint16_t voltage_mV = datalayer.battery.status.cell_voltages_mV[i];
-      if (voltage_mV != 0) {  // Skip unread values (0)
-        min_cell_mv_value = std::min(min_cell_mv_value, voltage_mV);
-        max_cell_mv_value = std::max(max_cell_mv_value, voltage_mV);
-      }
-    }
-    // If all array values are 0, reset min/max to 3700
-    if (min_cell_mv_value == std::numeric_limits<uint16_t>::max()) {
-      min_cell_mv_value = 3700;
-      max_cell_mv_value = 3700;
-    }
-
-    datalayer.battery.status.cell_min_voltage_mV = min_cell_mv_value;
-    datalayer.battery.status.cell_max_voltage_mV = max_cell_mv_value;
+    // The highest and lowest cell voltage are found by the cell array as the cells come in
   } else {  //Some variant of the 50/75kWh battery that is not using the eCMP CAN mappings.
     // For these batteries we need to use the OBD2 PID polled values
 
@@ -230,7 +214,7 @@ void EcmpBattery::update_values() {
   }
 }
 
-void EcmpBattery::handle_incoming_can_frame(CAN_frame rx_frame) {
+void EcmpBattery::handle_incoming_can_frame(const CAN_frame& rx_frame) {
   switch (rx_frame.ID) {
     case 0x2D4:  //MysteryVan 50/75kWh platform (TBMU 100ms periodic)
       datalayer.battery.status.CAN_battery_still_alive = CAN_STILL_ALIVE;
@@ -678,7 +662,7 @@ void EcmpBattery::handle_incoming_can_frame(CAN_frame rx_frame) {
       cellvoltages[105] = (rx_frame.data.u8[2] << 8) | rx_frame.data.u8[3];
       cellvoltages[106] = (rx_frame.data.u8[4] << 8) | rx_frame.data.u8[5];
       cellvoltages[107] = (rx_frame.data.u8[6] << 8) | rx_frame.data.u8[7];
-      memcpy(datalayer.battery.status.cell_voltages_mV, cellvoltages, 108 * sizeof(uint16_t));
+      battery_cells.set_voltages(0, cellvoltages, 108, millis());
       break;
     case 0x694:  // Poll reply
       datalayer.battery.status.CAN_battery_still_alive = CAN_STILL_ALIVE;
@@ -1,5 +1,6 @@
 #include "FORD-MACH-E-BATTERY.h"
 #include <Arduino.h>
+#include "../datalayer/cell_array.h"
 #include "../datalayer/datalayer.h"
 #include "../devboard/utils/events.h"
 #include "../devboard/utils/logging.h"
@@ -28,36 +29,13 @@ void FordMachEBattery::update_values() {
     datalayer.battery.status.max_charge_power_W =
         RAMPDOWNPOWERALLOWED * (1 - ((battery_soc / 10) - RAMPDOWN_SOC) / (1000.0 - RAMPDOWN_SOC));
     //If the cellvoltages start to reach overvoltage, only allow a small amount of power in
-    if (maximum_cellvoltage_mV > (MAX_CELL_VOLTAGE_MV - FLOAT_START_MV)) {
+    if (datalayer.battery.status.cell_max_voltage_mV > (MAX_CELL_VOLTAGE_MV - FLOAT_START_MV)) {
       datalayer.battery.status.max_charge_power_W = FLOAT_MAX_POWER_W;
     }
   } else {  // No limits, max charging power allowed
     datalayer.battery.status.max_charge_power_W = datalayer.battery.status.override_charge_power_W;
   }
 
-  maximum_cellvoltage_mV = datalayer.battery.status.cell_voltages_mV[0];
-  minimum_cellvoltage_mV = datalayer.battery.status.cell_voltages_mV[0];
-
-  // Loop through the array to find min and max cellvoltages, ignoring 0 values
-  for (uint8_t i = 0; i < datalayer.battery.info.number_of_cells; i++) {
-    if (datalayer.battery.status.cell_voltages_mV[i] > 1000) {  // Ignore unavailable values
-      if (datalayer.battery.status.cell_voltages_mV[i] < minimum_cellvoltage_mV) {
-        minimum_cellvoltage_mV = datalayer.battery.status.cell_voltages_mV[i];
-      }
-      if (datalayer.battery.status.cell_voltages_mV[i] > maximum_cellvoltage_mV) {
-        maximum_cellvoltage_mV = datalayer.battery.status.cell_voltages_mV[i];
-      }
-    }
-  }
-
-  if (maximum_cellvoltage_mV > 0) {
-    datalayer.battery.status.cell_max_voltage_mV = maximum_cellvoltage_mV;
-  }
-
-  if (minimum_cellvoltage_mV > 0) {
-    datalayer.battery.status.cell_min_voltage_mV = minimum_cellvoltage_mV;
-  }
-
   // Initialize highest and lowest to the first element
   maximum_temperature = cell_temperature[0];
   minimum_temperature = cell_temperature[0];
@@ -89,7 +67,7 @@ void FordMachEBattery::update_values() {
   }
 }
 
-void FordMachEBattery::handle_incoming_can_frame(CAN_frame rx_frame) {
+void FordMachEBattery::handle_incoming_can_frame(const CAN_frame& rx_frame) {
   switch (rx_frame.ID) {  //These frames are transmitted by the battery
     case 0x07a:           //10ms
       datalayer.battery.status.CAN_battery_still_alive = CAN_STILL_ALIVE;
@@ -173,7 +151,8 @@ void FordMachEBattery::handle_incoming_can_frame(CAN_frame rx_frame) {
           voltage = (rx_frame.data.u8[6] << 4) | (rx_frame.data.u8[7] >> 4);
         }
 
-        datalayer.battery.status.cell_voltages_mV[start_index + i] = voltage + 1000;
+        // 0 is no reading, left out of the cell statistics
+        battery_cells.set_voltage(start_index + i, voltage == 0 ? 0 : voltage + 1000, millis());
       }
       break;
     }
@@ -182,8 +161,7 @@ void FordMachEBattery::handle_incoming_can_frame(CAN_frame rx_frame) {
       if ((rx_frame.data.u8[0] == 0xFF) && (rx_frame.data.u8[1] == 0xE0)) {
         datalayer.battery.info.number_of_cells = 94;
       } else {  //96S battery
-        datalayer.battery.status.cell_voltages_mV[95] =
-            ((rx_frame.data.u8[0] << 4) | (rx_frame.data.u8[1] >> 4)) + 1000;
+        battery_cells.set_voltage(95, ((rx_frame.data.u8[0] << 4) | (rx_frame.data.u8[1] >> 4)) + 1000, millis());
         datalayer.battery.info.number_of_cells = 96;
       }
 
@@ -370,5 +348,6 @@ void FordMachEBattery::setup(void) {  // Performs one time setup at startup
   datalayer.battery.info.max_design_voltage_dV =
       MAX_PACK_VOLTAGE_96S_DV;  //Startup in extreme end of max voltage diff allowed
   datalayer.battery.info.min_design_voltage_dV = MIN_PACK_VOLTAGE_94S_DV;
+  battery_cells.set_refresh_period(INTERVAL_1_S);  // 0x490 to 0x4a3 are sent once per second
   datalayer.system.status.battery_allows_contactor_closing = true;
 }
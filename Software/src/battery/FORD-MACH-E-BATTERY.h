@@ -6,7 +6,7 @@
 class FordMachEBattery : public CanBattery {
  public:
   virtual void setup(void);
-  virtual void handle_incoming_can_frame(CAN_frame rx_frame);
+  virtual void handle_incoming_can_frame(const CAN_frame& rx_frame);
   virtual void update_values();
   virtual void transmit_can(unsigned long currentMillis);
   static constexpr const char* Name = "Ford Mustang Mach-E battery";
@@ -40,8 +40,6 @@ class FordMachEBattery : public CanBattery {
   uint16_t battery_soh = 99;
   uint16_t battery_voltage = 370;
   int16_t battery_current = 0;
-  uint16_t maximum_cellvoltage_mV = 3700;
-  uint16_t minimum_cellvoltage_mV = 3700;
 
   uint8_t counter_30ms = 0;
   uint8_t counter_8_30ms = 0;
@@ -1,6 +1,7 @@
 #include "KIA-64FD-BATTERY.h"
 #include "../communication/can/comm_can.h"
 #include "../datalayer/datalayer.h"
+#include "../devboard/utils/crc.h"
 #include "../devboard/utils/events.h"
 #include "../devboard/utils/logging.h"
 #include "../system_settings.h"
@@ -73,12 +74,8 @@ void write_cell_voltages(CAN_frame rx_frame, int start, int length, int startCel
   }
 }
 
-uint8_t Kia64FDBattery::calculateCRC(CAN_frame rx_frame, uint8_t length, uint8_t initial_value) {
-  uint8_t crc = initial_value;
-  for (uint8_t j = 1; j < length; j++) {  //start at 1, since 0 is the CRC
-    crc = crc8_table[(crc ^ static_cast<uint8_t>(rx_frame.data.u8[j])) % 256];
-  }
-  return crc;
+uint8_t Kia64FDBattery::calculateCRC(const CAN_frame& rx_frame, uint8_t length, uint8_t initial_value) {
+  return e2e_profile1_crc(rx_frame, length, initial_value);
 }
 
 void Kia64FDBattery::update_values() {
@@ -132,7 +129,7 @@ void Kia64FDBattery::update_values() {
   }
 }
 
-void Kia64FDBattery::handle_incoming_can_frame(CAN_frame rx_frame) {
+void Kia64FDBattery::handle_incoming_can_frame(const CAN_frame& rx_frame) {
   startedUp = true;
   switch (rx_frame.ID) {
     case 0x055:
@@ -2,6 +2,7 @@
 #include <Arduino.h>
 #include "../communication/can/comm_can.h"
 #include "../datalayer/datalayer.h"
+#include "../devboard/utils/crc.h"
 #include "../devboard/utils/events.h"
 #include "../devboard/utils/logging.h"
 #include "../system_settings.h"
@@ -104,12 +105,8 @@ void KiaEGmpBattery::set_voltage_minmax_limits() {
   }
 }
 
-uint8_t KiaEGmpBattery::calculateCRC(CAN_frame rx_frame, uint8_t length, uint8_t initial_value) {
-  uint8_t crc = initial_value;
-  for (uint8_t j = 1; j < length; j++) {  //start at 1, since 0 is the CRC
-    crc = crc8_table[(crc ^ static_cast<uint8_t>(rx_frame.data.u8[j])) % 256];
-  }
-  return crc;
+uint8_t KiaEGmpBattery::calculateCRC(const CAN_frame& rx_frame, uint8_t length, uint8_t initial_value) {
+  return e2e_profile1_crc(rx_frame, length, initial_value);
 }
 
 void KiaEGmpBattery::update_values() {
@@ -196,7 +193,7 @@ int KiaEGmpBattery::get_batRelay() const {
   return batteryRelay;
 }
 
-void KiaEGmpBattery::handle_incoming_can_frame(CAN_frame rx_frame) {
+void KiaEGmpBattery::handle_incoming_can_frame(const CAN_frame& rx_frame) {
   startedUp = true;
   switch (rx_frame.ID) {
     case 0x055:
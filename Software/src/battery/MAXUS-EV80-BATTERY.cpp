@@ -36,7 +36,7 @@ void MaxusEV80Battery::
   //datalayer.battery.status.temperature_max_dC;
 }
 
-void MaxusEV80Battery::handle_incoming_can_frame(CAN_frame rx_frame) {
+void MaxusEV80Battery::handle_incoming_can_frame(const CAN_frame& rx_frame) {
   switch (rx_frame.ID) {
     case 0x1805F301:  //3C,0A,34,35,00,00,00,00,
       datalayer.battery.status.CAN_battery_still_alive = CAN_STILL_ALIVE;
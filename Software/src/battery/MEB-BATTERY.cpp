@@ -4,8 +4,10 @@
 #include <cstring>    //For unit test
 #include "../communication/can/comm_can.h"
 #include "../communication/can/obd.h"
+#include "../datalayer/cell_array.h"
 #include "../datalayer/datalayer.h"
 #include "../datalayer/datalayer_extended.h"  //For "More battery info" webpage
+#include "../devboard/utils/crc.h"
 #include "../devboard/utils/events.h"
 #include "../devboard/utils/logging.h"
 
@@ -31,171 +33,141 @@ const int RX_0x5CA = 0x0800;
 const int RX_0x0CF = 0x1000;
 const int RX_DEFAULT = 0xE000;
 
-/** Calculate the CRC checksum for VAG CAN Messages
- *
- * The method used is described in Chapter "7.2.1.2 8-bit 0x2F polynomial CRC Calculation".
- * CRC Parameters:
- *     0x2F - Polynomial
- *     0xFF - Initial Value
- *     0xFF - XOR Output
- * 
- * @see https://github.com/crasbe/VW-OnBoard-Charger
- * @see https://github.com/colinoflynn/crcbeagle for CRC hacking :)
- * @see https://github.com/commaai/opendbc/blob/master/can/common.cc#L110
- * @see https://www.autosar.org/fileadmin/user_upload/standards/classic/4-3/AUTOSAR_SWS_CRCLibrary.pdf
- * @see https://web.archive.org/web/20221105210302/https://www.autosar.org/fileadmin/user_upload/standards/classic/4-3/AUTOSAR_SWS_CRCLibrary.pdf
+/** VAG magic bytes, the AUTOSAR E2E profile 2 data ID list of each CAN message with CRC. The alive counter
+ * in the low nibble of byte 1 selects the byte that goes into the CRC.
  */
-uint8_t vw_crc_calc(uint8_t* inputBytes, uint8_t length, uint32_t address) {
-
-  const uint8_t poly = 0x2F;
-  const uint8_t xor_output = 0xFF;
-  // VAG Magic Bytes
-  const uint8_t MB0040[16] = {0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40,
-                              0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40};
-  const uint8_t MB00C0[16] = {0x2f, 0x44, 0x72, 0xd3, 0x07, 0xf2, 0x39, 0x09,
-                              0x8d, 0x6f, 0x57, 0x20, 0x37, 0xf9, 0x9b, 0xfa};
-  const uint8_t MB00CF[16] = {0xee, 0x80, 0x6e, 0x4e, 0x29, 0xc6, 0x92, 0xc0,
-                              0x65, 0xaa, 0x3a, 0xa1, 0x8f, 0xcd, 0xe6, 0x90};
-  const uint8_t MB00FC[16] = {0x77, 0x5c, 0xa0, 0x89, 0x4b, 0x7c, 0xbb, 0xd6,
-                              0x1f, 0x6c, 0x4f, 0xf6, 0x20, 0x2b, 0x43, 0xdd};
-  const uint8_t MB00FD[16] = {0xb4, 0xef, 0xf8, 0x49, 0x1e, 0xe5, 0xc2, 0xc0,
-                              0x97, 0x19, 0x3c, 0xc9, 0xf1, 0x98, 0xd6, 0x61};
-  const uint8_t MB0097[16] = {0x3C, 0x54, 0xCF, 0xA3, 0x81, 0x93, 0x0B, 0xC7,
-                              0x3E, 0xDF, 0x1C, 0xB0, 0xA7, 0x25, 0xD3, 0xD8};
-  const uint8_t MB00F7[16] = {0x5F, 0xA0, 0x44, 0xD0, 0x63, 0x59, 0x5B, 0xA2,
-                              0x68, 0x04, 0x90, 0x87, 0x52, 0x12, 0xB4, 0x9E};
-  const uint8_t MB0124[16] = {0x12, 0x7E, 0x34, 0x16, 0x25, 0x8F, 0x8E, 0x35,
-                              0xBA, 0x7F, 0xEA, 0x59, 0x4C, 0xF0, 0x88, 0x15};
-  const uint8_t MB0153[16] = {0x03, 0x13, 0x23, 0x7a, 0x40, 0x51, 0x68, 0xba,
-                              0xa8, 0xbe, 0x55, 0x02, 0x11, 0x31, 0x76, 0xec};
-  const uint8_t MB014C[16] = {0x16, 0x35, 0x59, 0x15, 0x9a, 0x2a, 0x97, 0xb8,
-                              0x0e, 0x4e, 0x30, 0xcc, 0xb3, 0x07, 0x01, 0xad};
-  const uint8_t MB0187[16] = {0x7F, 0xED, 0x17, 0xC2, 0x7C, 0xEB, 0x44, 0x21,
-                              0x01, 0xFA, 0xDB, 0x15, 0x4A, 0x6B, 0x23, 0x05};
-  const uint8_t MB03A6[16] = {0xB6, 0x1C, 0xC1, 0x23, 0x6D, 0x8B, 0x0C, 0x51,
-                              0x38, 0x32, 0x24, 0xA8, 0x3F, 0x3A, 0xA4, 0x02};
-  const uint8_t MB03AF[16] = {0x94, 0x6A, 0xB5, 0x38, 0x8A, 0xB4, 0xAB, 0x27,
-                              0xCB, 0x22, 0x88, 0xEF, 0xA3, 0xE1, 0xD0, 0xBB};
-  const uint8_t MB03BE[16] = {0x1f, 0x28, 0xc6, 0x85, 0xe6, 0xf8, 0xb0, 0x19,
-                              0x5b, 0x64, 0x35, 0x21, 0xe4, 0xf7, 0x9c, 0x24};
-  const uint8_t MB03C0[16] = {0xc3, 0xc3, 0xc3, 0xc3, 0xc3, 0xc3, 0xc3, 0xc3,
-                              0xc3, 0xc3, 0xc3, 0xc3, 0xc3, 0xc3, 0xc3, 0xc3};
-  const uint8_t MB0503[16] = {0xed, 0xd6, 0x96, 0x63, 0xa5, 0x12, 0xd5, 0x9a,
-                              0x1e, 0x0d, 0x24, 0xcd, 0x8c, 0xa6, 0x2f, 0x41};
-  const uint8_t MB0578[16] = {0x48, 0x48, 0x48, 0x48, 0x48, 0x48, 0x48, 0x48,
-                              0x48, 0x48, 0x48, 0x48, 0x48, 0x48, 0x48, 0x48};
-  const uint8_t MB05A2[16] = {0xeb, 0x4c, 0x44, 0xaf, 0x21, 0x8d, 0x01, 0x58,
-                              0xfa, 0x93, 0xdb, 0x89, 0x15, 0x10, 0x4a, 0x61};
-  const uint8_t MB05CA[16] = {0x43, 0x43, 0x43, 0x43, 0x43, 0x43, 0x43, 0x43,
-                              0x43, 0x43, 0x43, 0x43, 0x43, 0x43, 0x43, 0x43};
-  const uint8_t MB0641[16] = {0x47, 0x47, 0x47, 0x47, 0x47, 0x47, 0x47, 0x47,
-                              0x47, 0x47, 0x47, 0x47, 0x47, 0x47, 0x47, 0x47};
-  const uint8_t MB06A3[16] = {0xC1, 0x8B, 0x38, 0xA8, 0xA4, 0x27, 0xEB, 0xC8,
-                              0xEF, 0x05, 0x9A, 0xBB, 0x39, 0xF7, 0x80, 0xA7};
-  const uint8_t MB06A4[16] = {0xC7, 0xD8, 0xF1, 0xC4, 0xE3, 0x5E, 0x9A, 0xE2,
-                              0xA1, 0xCB, 0x02, 0x4F, 0x57, 0x4E, 0x8E, 0xE4};
-  const uint8_t MB16A954A6[16] = {0x79, 0xB9, 0x67, 0xAD, 0xD5, 0xF7, 0x70, 0xAA,
-                                  0x44, 0x61, 0x5A, 0xDC, 0x26, 0xB4, 0xD2, 0xC3};
-
-  uint8_t crc = 0xFF;
-  uint8_t magicByte = 0x00;
-  uint8_t counter = inputBytes[1] & 0x0F;  // only the low byte of the couner is relevant
+static const uint8_t MB0040[16] = {0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40,
+                                   0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40};
+static const uint8_t MB00C0[16] = {0x2f, 0x44, 0x72, 0xd3, 0x07, 0xf2, 0x39, 0x09,
+                                   0x8d, 0x6f, 0x57, 0x20, 0x37, 0xf9, 0x9b, 0xfa};
+static const uint8_t MB00CF[16] = {0xee, 0x80, 0x6e, 0x4e, 0x29, 0xc6, 0x92, 0xc0,
+                                   0x65, 0xaa, 0x3a, 0xa1, 0x8f, 0xcd, 0xe6, 0x90};
+static const uint8_t MB00FC[16] = {0x77, 0x5c, 0xa0, 0x89, 0x4b, 0x7c, 0xbb, 0xd6,
+                                   0x1f, 0x6c, 0x4f, 0xf6, 0x20, 0x2b, 0x43, 0xdd};
+static const uint8_t MB00FD[16] = {0xb4, 0xef, 0xf8, 0x49, 0x1e, 0xe5, 0xc2, 0xc0,
+                                   0x97, 0x19, 0x3c, 0xc9, 0xf1, 0x98, 0xd6, 0x61};
+static const uint8_t MB0097[16] = {0x3C, 0x54, 0xCF, 0xA3, 0x81, 0x93, 0x0B, 0xC7,
+                                   0x3E, 0xDF, 0x1C, 0xB0, 0xA7, 0x25, 0xD3, 0xD8};
+static const uint8_t MB00F7[16] = {0x5F, 0xA0, 0x44, 0xD0, 0x63, 0x59, 0x5B, 0xA2,
+                                   0x68, 0x04, 0x90, 0x87, 0x52, 0x12, 0xB4, 0x9E};
+static const uint8_t MB0124[16] = {0x12, 0x7E, 0x34, 0x16, 0x25, 0x8F, 0x8E, 0x35,
+                                   0xBA, 0x7F, 0xEA, 0x59, 0x4C, 0xF0, 0x88, 0x15};
+static const uint8_t MB0153[16] = {0x03, 0x13, 0x23, 0x7a, 0x40, 0x51, 0x68, 0xba,
+                                   0xa8, 0xbe, 0x55, 0x02, 0x11, 0x31, 0x76, 0xec};
+static const uint8_t MB014C[16] = {0x16, 0x35, 0x59, 0x15, 0x9a, 0x2a, 0x97, 0xb8,
+                                   0x0e, 0x4e, 0x30, 0xcc, 0xb3, 0x07, 0x01, 0xad};
+static const uint8_t MB0187[16] = {0x7F, 0xED, 0x17, 0xC2, 0x7C, 0xEB, 0x44, 0x21,
+                                   0x01, 0xFA, 0xDB, 0x15, 0x4A, 0x6B, 0x23, 0x05};
+static const uint8_t MB03A6[16] = {0xB6, 0x1C, 0xC1, 0x23, 0x6D, 0x8B, 0x0C, 0x51,
+                                   0x38, 0x32, 0x24, 0xA8, 0x3F, 0x3A, 0xA4, 0x02};
+static const uint8_t MB03AF[16] = {0x94, 0x6A, 0xB5, 0x38, 0x8A, 0xB4, 0xAB, 0x27,
+                                   0xCB, 0x22, 0x88, 0xEF, 0xA3, 0xE1, 0xD0, 0xBB};
+static const uint8_t MB03BE[16] = {0x1f, 0x28, 0xc6, 0x85, 0xe6, 0xf8, 0xb0, 0x19,
+                                   0x5b, 0x64, 0x35, 0x21, 0xe4, 0xf7, 0x9c, 0x24};
+static const uint8_t MB03C0[16] = {0xc3, 0xc3, 0xc3, 0xc3, 0xc3, 0xc3, 0xc3, 0xc3,
+                                   0xc3, 0xc3, 0xc3, 0xc3, 0xc3, 0xc3, 0xc3, 0xc3};
+static const uint8_t MB0503[16] = {0xed, 0xd6, 0x96, 0x63, 0xa5, 0x12, 0xd5, 0x9a,
+                                   0x1e, 0x0d, 0x24, 0xcd, 0x8c, 0xa6, 0x2f, 0x41};
+static const uint8_t MB0578[16] = {0x48, 0x48, 0x48, 0x48, 0x48, 0x48, 0x48, 0x48,
+                                   0x48, 0x48, 0x48, 0x48, 0x48, 0x48, 0x48, 0x48};
+static const uint8_t MB05A2[16] = {0xeb, 0x4c, 0x44, 0xaf, 0x21, 0x8d, 0x01, 0x58,
+                                   0xfa, 0x93, 0xdb, 0x89, 0x15, 0x10, 0x4a, 0x61};
+static const uint8_t MB05CA[16] = {0x43, 0x43, 0x43, 0x43, 0x43, 0x43, 0x43, 0x43,
+                                   0x43, 0x43, 0x43, 0x43, 0x43, 0x43, 0x43, 0x43};
+static const uint8_t MB0641[16] = {0x47, 0x47, 0x47, 0x47, 0x47, 0x47, 0x47, 0x47,
+                                   0x47, 0x47, 0x47, 0x47, 0x47, 0x47, 0x47, 0x47};
+static const uint8_t MB06A3[16] = {0xC1, 0x8B, 0x38, 0xA8, 0xA4, 0x27, 0xEB, 0xC8,
+                                   0xEF, 0x05, 0x9A, 0xBB, 0x39, 0xF7, 0x80, 0xA7};
+static const uint8_t MB06A4[16] = {0xC7, 0xD8, 0xF1, 0xC4, 0xE3, 0x5E, 0x9A, 0xE2,
+                                   0xA1, 0xCB, 0x02, 0x4F, 0x57, 0x4E, 0x8E, 0xE4};
+static const uint8_t MB16A954A6[16] = {0x79, 0xB9, 0x67, 0xAD, 0xD5, 0xF7, 0x70, 0xAA,
+                                       0x44, 0x61, 0x5A, 0xDC, 0x26, 0xB4, 0xD2, 0xC3};
+
+static const uint8_t* vw_data_ids(uint32_t address) {
+  static const uint8_t UNKNOWN[16] = {0};
 
   switch (address) {
     case 0x0040:  // Airbag
-      magicByte = MB0040[counter];
-      break;
+      return MB0040;
     case 0x00C0:  //
-      magicByte = MB00C0[counter];
-      break;
+      return MB00C0;
     case 0x00CF:  //BMS
-      magicByte = MB00CF[counter];
-      break;
+      return MB00CF;
     case 0x00FC:
-      magicByte = MB00FC[counter];
-      break;
+      return MB00FC;
     case 0x00FD:
-      magicByte = MB00FD[counter];
-      break;
+      return MB00FD;
     case 0x0097:  // ??
-      magicByte = MB0097[counter];
-      break;
+      return MB0097;
     case 0x00F7:  // ??
-      magicByte = MB00F7[counter];
-      break;
+      return MB00F7;
     case 0x0124:  // ??
-      magicByte = MB0124[counter];
-      break;
+      return MB0124;
     case 0x014C:  // Motor
-      magicByte = MB014C[counter];
-      break;
+      return MB014C;
     case 0x0153:  // HYB30
-      magicByte = MB0153[counter];
-      break;
+      return MB0153;
     case 0x0187:  // EV_Gearshift "Gear" selection data for EVs with no gearbox
-      magicByte = MB0187[counter];
-      break;
+      return MB0187;
     case 0x03A6:  // ??
-      magicByte = MB03A6[counter];
-      break;
+      return MB03A6;
     case 0x03AF:  // ??
-      magicByte = MB03AF[counter];
-      break;
+      return MB03AF;
     case 0x03BE:  // Motor
-      magicByte = MB03BE[counter];
-      break;
+      return MB03BE;
     case 0x03C0:  // Klemmen status
-      magicByte = MB03C0[counter];
-      break;
+      return MB03C0;
     case 0x0503:  // HVK
-      magicByte = MB0503[counter];
-      break;
+      return MB0503;
     case 0x0578:  // BMS DC
-      magicByte = MB0578[counter];
-      break;
+      return MB0578;
     case 0x05A2:  // BMS
-      magicByte = MB05A2[counter];
-      break;
+      return MB05A2;
     case 0x05CA:  // BMS
-      magicByte = MB05CA[counter];
-      break;
+      return MB05CA;
     case 0x0641:  // Motor
-      magicByte = MB0641[counter];
-      break;
+      return MB0641;
     case 0x06A3:  // ??
-      magicByte = MB06A3[counter];
-      break;
+      return MB06A3;
     case 0x06A4:  // ??
-      magicByte = MB06A4[counter];
-      break;
+      return MB06A4;
     case 0x16A954A6:
-      magicByte = MB16A954A6[counter];
-      break;
+      return MB16A954A6;
     default:  // this won't lead to correct CRC checksums
       logging.println("Checksum request unknown");
-      magicByte = 0x00;
-      break;
+      return UNKNOWN;
   }
+}
 
-  for (uint8_t i = 1; i < length + 1; i++) {
-    // We skip the empty CRC position and start at the timer
-    // The last element is the VAG magic byte for address 0x187 depending on the counter value.
-    if (i < length)
-      crc ^= inputBytes[i];
-    else
-      crc ^= magicByte;
-
-    for (uint8_t j = 0; j < 8; j++) {
-      if (crc & 0x80)
-        crc = (crc << 1) ^ poly;
-      else
-        crc = (crc << 1);
-    }
-  }
+/** Calculate the CRC checksum for VAG CAN Messages
+ *
+ * The method used is described in Chapter "7.2.1.2 8-bit 0x2F polynomial CRC Calculation".
+ * CRC Parameters:
+ *     0x2F - Polynomial
+ *     0xFF - Initial Value
+ *     0xFF - XOR Output
+ * 
+ * @see https://github.com/crasbe/VW-OnBoard-Charger
+ * @see https://github.com/colinoflynn/crcbeagle for CRC hacking :)
+ * @see https://github.com/commaai/opendbc/blob/master/can/common.cc#L110
+ * @see https://www.autosar.org/fileadmin/user_upload/standards/classic/4-3/AUTOSAR_SWS_CRCLibrary.pdf
+ * @see https://web.archive.org/web/20221105210302/https://www.autosar.org/fileadmin/user_upload/standards/classic/4-3/AUTOSAR_SWS_CRCLibrary.pdf
+ */
+static uint8_t vw_crc_calc(const CAN_frame& frame) {
+  return e2e_profile2_crc(frame, frame.DLC, vw_data_ids(frame.ID));
+}
 
-  crc ^= xor_output;
+// Set alive counter and CRC of a frame before sending it
+static void vw_e2e_protect(CAN_frame& frame, uint8_t counter) {
+  e2e_profile2_protect(frame, counter, vw_data_ids(frame.ID));
+}
 
-  return crc;
+static uint16_t be16(const uint8_t* value) {
+  return (value[0] << 8) | value[1];
+}
+
+static int32_t be32(const uint8_t* value) {
+  return (value[0] << 24) | (value[1] << 16) | (value[2] << 8) | value[3];
 }
 
 void MebBattery::
@@ -241,9 +213,6 @@ void MebBattery::
   // datalayer.battery.status.temperature_max_dC = actual_temperature_highest_C*5 -400;  // We use the value below, because it has better accuracy
   datalayer_battery->status.temperature_max_dC = (battery_max_temp * 10) / 64;
 
-  //Map all cell voltages to the global array
-  memcpy(datalayer_battery->status.cell_voltages_mV, cellvoltages_polled, 108 * sizeof(uint16_t));
-
   if (service_disconnect_switch_missing) {
     set_event(EVENT_HVIL_FAILURE, 1);
   } else {
@@ -306,7 +275,7 @@ void MebBattery::
   datalayer_extended.meb.charging_active = charging_active;
 }
 
-void MebBattery::handle_incoming_can_frame(CAN_frame rx_frame) {
+void MebBattery::handle_incoming_can_frame(const CAN_frame& rx_frame) {
   last_can_msg_timestamp = millis();
   if (first_can_msg == 0) {
     logging.printf("MEB: First CAN msg received\n");
@@ -320,8 +289,7 @@ void MebBattery::handle_incoming_can_frame(CAN_frame rx_frame) {
     case 0x5A2:
     case 0x5CA:
     case 0x16A954A6:
-      if (rx_frame.data.u8[0] !=
-          vw_crc_calc(rx_frame.data.u8, rx_frame.DLC, rx_frame.ID)) {  //If CRC does not match calc
+      if (rx_frame.data.u8[0] != vw_crc_calc(rx_frame)) {  //If CRC does not match calc
         datalayer.battery.status.CAN_error_counter++;
         logging.printf("MEB: Msg 0x%04X CRC error\n", rx_frame.ID);
         return;
@@ -753,111 +721,8 @@ void MebBattery::handle_incoming_can_frame(CAN_frame rx_frame) {
         BMS_voltage = ((rx_frame.data.u8[7] << 4) + ((rx_frame.data.u8[6] & 0xF0) >> 4));
       }
       break;
-    case 0x1C42007B:                      // Reply from battery
-      if (rx_frame.data.u8[0] == 0x10) {  //PID header
-        transmit_can_frame(&MEB_ACK_FRAME);
-      }
-      if (rx_frame.DLC == 8) {
-        pid_reply = (rx_frame.data.u8[2] << 8) + rx_frame.data.u8[3];
-      } else {  //12 or 24bit message has reply in other location
-        pid_reply = (rx_frame.data.u8[3] << 8) + rx_frame.data.u8[4];
-      }
-
-      switch (pid_reply) {
-        case PID_SOC:
-          battery_soc_polled = rx_frame.data.u8[4] * 4;  // 135*4 = 54.0%
-          break;
-        case PID_VOLTAGE:
-          battery_voltage_polled = ((rx_frame.data.u8[4] << 8) | rx_frame.data.u8[5]);
-          break;
-        case PID_CURRENT:  // IDLE 0A: 00 08 62 1E 3D (00 02) 49 F0 39 AA AA
-          battery_current_polled = ((rx_frame.data.u8[5] << 8) | rx_frame.data.u8[6]);  //TODO: right bits?
-          break;
-        case PID_MAX_TEMP:
-          battery_max_temp = ((rx_frame.data.u8[4] << 8) | rx_frame.data.u8[5]);
-          break;
-        case PID_MIN_TEMP:
-          battery_min_temp = ((rx_frame.data.u8[4] << 8) | rx_frame.data.u8[5]);
-          break;
-        // Note: PID_TEMP_POINT_1 to PID_TEMP_POINT_18 are handled in the default case.
-        case PID_MAX_CHARGE_VOLTAGE:
-          battery_max_charge_voltage = ((rx_frame.data.u8[4] << 8) | rx_frame.data.u8[5]);
-          break;
-        case PID_MIN_DISCHARGE_VOLTAGE:
-          battery_min_discharge_voltage = ((rx_frame.data.u8[4] << 8) | rx_frame.data.u8[5]);
-          break;
-        case PID_ENERGY_COUNTERS:
-          // int32_t ah_discharge = ((rx_frame.data.u8[5] << 24) | (rx_frame.data.u8[6] << 16) | (rx_frame.data.u8[7] << 8) |rx_frame.data.u8[8]);
-          // int32_t ah_charge = ((rx_frame.data.u8[9] << 24) | (rx_frame.data.u8[10] << 16) | (rx_frame.data.u8[11] << 8) |rx_frame.data.u8[12]);
-          kwh_charge = ((rx_frame.data.u8[13] << 24) | (rx_frame.data.u8[14] << 16) | (rx_frame.data.u8[15] << 8) |
-                        rx_frame.data.u8[16]);
-          kwh_discharge = ((rx_frame.data.u8[17] << 24) | (rx_frame.data.u8[18] << 16) | (rx_frame.data.u8[19] << 8) |
-                           rx_frame.data.u8[20]);
-          // logging.printf("ah_dis:%.3f ah_ch:%.3f kwh_dis:%.3f kwh_ch:%.3f\n", ah_discharge*0.00182044545, ah_charge*0.00182044545,
-          // kwh_discharge*0.00011650853, kwh_charge*0.00011650853);
-          datalayer.battery.status.total_discharged_battery_Wh = kwh_discharge * 0.11650853;
-          datalayer.battery.status.total_charged_battery_Wh = kwh_charge * 0.11650853;
-          break;
-        case PID_ALLOWED_CHARGE_POWER:
-          battery_allowed_charge_power = ((rx_frame.data.u8[4] << 8) | rx_frame.data.u8[5]);
-          break;
-        case PID_ALLOWED_DISCHARGE_POWER:
-          battery_allowed_discharge_power = ((rx_frame.data.u8[4] << 8) | rx_frame.data.u8[5]);
-          break;
-        // Note: most PID_CELLVOLTAGE_CELL_* responses are handled in the default case.
-        // Certain specific cases are handled here as they are used to establish the number of cells.
-        case PID_CELLVOLTAGE_CELL_85:
-          tempval = ((rx_frame.data.u8[4] << 8) | rx_frame.data.u8[5]);
-          if (tempval != 0xFFE) {
-            cellvoltages_polled[84] = (tempval + 1000);
-          } else {  // Cell 85 unavailable. We have a 84S battery (48kWh)
-            datalayer.battery.info.number_of_cells = 84;
-            nof_cells_determined = true;
-            datalayer.battery.info.max_design_voltage_dV = MAX_PACK_VOLTAGE_84S_DV;
-            datalayer.battery.info.min_design_voltage_dV = MIN_PACK_VOLTAGE_84S_DV;
-          }
-          break;
-        case PID_CELLVOLTAGE_CELL_97:
-          tempval = ((rx_frame.data.u8[4] << 8) | rx_frame.data.u8[5]);
-          if (tempval != 0xFFE) {
-            cellvoltages_polled[96] = (tempval + 1000);
-          } else {  // Cell 97 unavailable. We have a 96S battery (55kWh) (Unless already specified as 84S)
-            if (datalayer.battery.info.number_of_cells == 84) {
-              // Do nothing, we already identified it as 84S
-            } else {
-              datalayer.battery.info.number_of_cells = 96;
-              nof_cells_determined = true;
-              datalayer.battery.info.max_design_voltage_dV = MAX_PACK_VOLTAGE_96S_DV;
-              datalayer.battery.info.min_design_voltage_dV = MIN_PACK_VOLTAGE_96S_DV;
-            }
-          }
-          break;
-        case PID_CELLVOLTAGE_CELL_108:
-          tempval = ((rx_frame.data.u8[4] << 8) | rx_frame.data.u8[5]);
-          nof_cells_determined = true;  // This is placed outside of the if, to make
-          // sure we only take the shortcuts to determine the number of cells once.
-          if (tempval != 0xFFE) {
-            cellvoltages_polled[107] = (tempval + 1000);
-            datalayer.battery.info.number_of_cells = 108;
-            datalayer.battery.info.max_design_voltage_dV = MAX_PACK_VOLTAGE_108S_DV;
-            datalayer.battery.info.min_design_voltage_dV = MIN_PACK_VOLTAGE_108S_DV;
-          }
-          break;
-        default:
-          if (pid_reply >= PID_TEMP_POINT_1 && pid_reply <= PID_TEMP_POINT_18) {
-            datalayer_extended.meb.temp_points[pid_reply - PID_TEMP_POINT_1] =
-                (((rx_frame.data.u8[4] << 8) | rx_frame.data.u8[5]) / 8.f) - 40;
-          } else if (pid_reply >= PID_CELLVOLTAGE_CELL_1 && pid_reply <= PID_CELLVOLTAGE_CELL_108) {
-            // The general case for cell voltages (some specific cases handled above)
-            tempval = ((rx_frame.data.u8[4] << 8) | rx_frame.data.u8[5]);
-            if (tempval != 0xFFE) {
-              cellvoltages_polled[pid_reply - PID_CELLVOLTAGE_CELL_1] = (tempval + 1000);
-            }
-          }
-
-          break;
-      }
-
+    case 0x1C42007B:  // Reply from battery
+      poll_transport.handle_frame(rx_frame, millis());
       break;
     case 0x18DAF105:
       handle_obd_frame(rx_frame, can_interface);
@@ -891,61 +756,6 @@ void MebBattery::transmit_can(unsigned long currentMillis) {
       hv_requested = false;
     }
   }
-  // Send 10ms CAN Message
-  if (currentMillis - previousMillis10ms >= INTERVAL_10_MS) {
-    previousMillis10ms = currentMillis;
-
-    MEB_0FC.data.u8[1] = ((MEB_0FC.data.u8[1] & 0xF0) | counter_10ms);
-    MEB_0FC.data.u8[0] = vw_crc_calc(MEB_0FC.data.u8, MEB_0FC.DLC, MEB_0FC.ID);
-
-    counter_10ms = (counter_10ms + 1) % 16;  //Goes from 0-1-2-3...15-0-1-2-3..
-
-    transmit_can_frame(&MEB_0FC);  // Required for contactor closing
-  }
-  // Send 20ms CAN Message
-  if (currentMillis - previousMillis20ms >= INTERVAL_20_MS) {
-    previousMillis20ms = currentMillis;
-
-    MEB_0FD.data.u8[1] = ((MEB_0FD.data.u8[1] & 0xF0) | counter_20ms);
-    MEB_0FD.data.u8[0] = vw_crc_calc(MEB_0FD.data.u8, MEB_0FD.DLC, MEB_0FD.ID);
-
-    counter_20ms = (counter_20ms + 1) % 16;  //Goes from 0-1-2-3...15-0-1-2-3..
-
-    transmit_can_frame(&MEB_0FD);  // Required for contactor closing
-  }
-  // Send 40ms CAN Message
-  if (currentMillis - previousMillis40ms >= INTERVAL_40_MS) {
-    previousMillis40ms = currentMillis;
-
-    /* Handle content for 0x040 message */
-    /* Airbag message, needed for BMS to function */
-    MEB_040.data.u8[7] = counter_040;
-    MEB_040.data.u8[1] = ((MEB_040.data.u8[1] & 0xF0) | counter_40ms);
-    MEB_040.data.u8[0] = vw_crc_calc(MEB_040.data.u8, MEB_040.DLC, MEB_040.ID);
-    counter_40ms = (counter_40ms + 1) % 16;  //Goes from 0-1-2-3...15-0-1-2-3..
-    if (toggle) {
-      counter_040 = (counter_040 + 1) % 256;  // Increment only on every other pass
-    }
-    toggle = !toggle;  // Flip the toggle each time the code block is executed
-
-    transmit_can_frame(&MEB_040);  // Airbag message - Needed for contactor closing
-  }
-  // Send 50ms CAN Message
-  if (currentMillis - previousMillis50ms >= INTERVAL_50_MS) {
-    previousMillis50ms = currentMillis;
-
-    /* Handle content for 0x0C0 message */
-    /* BMS needs to see this EM1 message. Content located in frame5&6 especially (can be static?)*/
-    /* Also the voltage seen externally to battery is in frame 7&8. At least for the 62kWh ID3 version does not seem to matter, but we send it anyway. */
-    MEB_0C0.data.u8[1] = ((MEB_0C0.data.u8[1] & 0xF0) | counter_50ms);
-    MEB_0C0.data.u8[7] = ((datalayer.battery.status.voltage_dV / 10) * 4) & 0x00FF;
-    MEB_0C0.data.u8[8] =
-        ((MEB_0C0.data.u8[8] & 0xF0) | ((((datalayer.battery.status.voltage_dV / 10) * 4) >> 8) & 0x0F));
-    MEB_0C0.data.u8[0] = vw_crc_calc(MEB_0C0.data.u8, MEB_0C0.DLC, MEB_0C0.ID);
-    counter_50ms = (counter_50ms + 1) % 16;  //Goes from 0-1-2-3...15-0-1-2-3..
-
-    transmit_can_frame(&MEB_0C0);  //  Needed for contactor closing
-  }
   // Send 100ms CAN Message
   if (currentMillis - previousMillis100ms >= INTERVAL_100_MS) {
     previousMillis100ms = currentMillis;
@@ -1019,8 +829,7 @@ void MebBattery::transmit_can(unsigned long currentMillis) {
       MEB_503.data.u8[3] = 0;
       MEB_503.data.u8[5] = 0x80;  // Bordnetz Inactive
     }
-    MEB_503.data.u8[1] = ((MEB_503.data.u8[1] & 0xF0) | counter_100ms);
-    MEB_503.data.u8[0] = vw_crc_calc(MEB_503.data.u8, MEB_503.DLC, MEB_503.ID);
+    vw_e2e_protect(MEB_503, counter_100ms);
 
     //Bidirectional charging message
     MEB_272.data.u8[1] =
@@ -1031,14 +840,11 @@ void MebBattery::transmit_can(unsigned long currentMillis) {
 
     //Klemmen status
     MEB_3C0.data.u8[2] = 0x02;  //bit to signal that KL_15 is ON // Always 0 in start4.log
-    MEB_3C0.data.u8[1] = ((MEB_3C0.data.u8[1] & 0xF0) | counter_100ms);
-    MEB_3C0.data.u8[0] = vw_crc_calc(MEB_3C0.data.u8, MEB_3C0.DLC, MEB_3C0.ID);
+    vw_e2e_protect(MEB_3C0, counter_100ms);
 
-    MEB_3BE.data.u8[1] = ((MEB_3BE.data.u8[1] & 0xF0) | counter_100ms);
-    MEB_3BE.data.u8[0] = vw_crc_calc(MEB_3BE.data.u8, MEB_3BE.DLC, MEB_3BE.ID);
+    vw_e2e_protect(MEB_3BE, counter_100ms);
 
-    MEB_14C.data.u8[1] = ((MEB_14C.data.u8[1] & 0xF0) | counter_100ms);
-    MEB_14C.data.u8[0] = vw_crc_calc(MEB_14C.data.u8, MEB_14C.DLC, MEB_14C.ID);
+    vw_e2e_protect(MEB_14C, counter_100ms);
 
     counter_100ms = (counter_100ms + 1) % 16;  //Goes from 0-1-2-3...15-0-1-2-3..
     transmit_can_frame(&MEB_503);
@@ -1060,148 +866,20 @@ void MebBattery::transmit_can(unsigned long currentMillis) {
     transmit_can_frame(&MEB_1B0000B9);
     transmit_can_frame(&MEB_1B000010);
     transmit_can_frame(&MEB_1B000046);
-
-    switch (poll_pid) {
-      case PID_SOC:
-        MEB_POLLING_FRAME.data.u8[2] = (uint8_t)(PID_SOC >> 8);  // High byte
-        MEB_POLLING_FRAME.data.u8[3] = (uint8_t)PID_SOC;         // Low byte
-        poll_pid = PID_VOLTAGE;
-        break;
-      case PID_VOLTAGE:
-        MEB_POLLING_FRAME.data.u8[2] = (uint8_t)(PID_VOLTAGE >> 8);
-        MEB_POLLING_FRAME.data.u8[3] = (uint8_t)PID_VOLTAGE;
-        poll_pid = PID_CURRENT;
-        break;
-      case PID_CURRENT:
-        MEB_POLLING_FRAME.data.u8[2] = (uint8_t)(PID_CURRENT >> 8);
-        MEB_POLLING_FRAME.data.u8[3] = (uint8_t)PID_CURRENT;
-        poll_pid = PID_MAX_TEMP;
-        break;
-      case PID_MAX_TEMP:
-        MEB_POLLING_FRAME.data.u8[2] = (uint8_t)(PID_MAX_TEMP >> 8);
-        MEB_POLLING_FRAME.data.u8[3] = (uint8_t)PID_MAX_TEMP;
-        poll_pid = PID_MIN_TEMP;
-        break;
-      case PID_MIN_TEMP:
-        MEB_POLLING_FRAME.data.u8[2] = (uint8_t)(PID_MIN_TEMP >> 8);
-        MEB_POLLING_FRAME.data.u8[3] = (uint8_t)PID_MIN_TEMP;
-        poll_pid = PID_TEMP_POINT_1;
-        break;
-      case PID_TEMP_POINT_1:
-      case PID_TEMP_POINT_2:
-      case PID_TEMP_POINT_3:
-      case PID_TEMP_POINT_4:
-      case PID_TEMP_POINT_5:
-      case PID_TEMP_POINT_6:
-      case PID_TEMP_POINT_7:
-      case PID_TEMP_POINT_8:
-      case PID_TEMP_POINT_9:
-      case PID_TEMP_POINT_10:
-      case PID_TEMP_POINT_11:
-      case PID_TEMP_POINT_12:
-      case PID_TEMP_POINT_13:
-      case PID_TEMP_POINT_14:
-      case PID_TEMP_POINT_15:
-      case PID_TEMP_POINT_16:
-      case PID_TEMP_POINT_17:
-        MEB_POLLING_FRAME.data.u8[2] = (uint8_t)(poll_pid >> 8);
-        MEB_POLLING_FRAME.data.u8[3] = (uint8_t)poll_pid;
-        poll_pid = poll_pid + 1;
-        break;
-      case PID_TEMP_POINT_18:
-        MEB_POLLING_FRAME.data.u8[2] = (uint8_t)(poll_pid >> 8);
-        MEB_POLLING_FRAME.data.u8[3] = (uint8_t)poll_pid;
-        poll_pid = PID_MAX_CHARGE_VOLTAGE;
-        break;
-      case PID_MAX_CHARGE_VOLTAGE:
-        MEB_POLLING_FRAME.data.u8[2] = (uint8_t)(PID_MAX_CHARGE_VOLTAGE >> 8);
-        MEB_POLLING_FRAME.data.u8[3] = (uint8_t)PID_MAX_CHARGE_VOLTAGE;
-        poll_pid = PID_MIN_DISCHARGE_VOLTAGE;
-        break;
-      case PID_MIN_DISCHARGE_VOLTAGE:
-        MEB_POLLING_FRAME.data.u8[2] = (uint8_t)(PID_MIN_DISCHARGE_VOLTAGE >> 8);
-        MEB_POLLING_FRAME.data.u8[3] = (uint8_t)PID_MIN_DISCHARGE_VOLTAGE;
-        poll_pid = PID_ENERGY_COUNTERS;
-        break;
-      case PID_ENERGY_COUNTERS:
-        MEB_POLLING_FRAME.data.u8[2] = (uint8_t)(PID_ENERGY_COUNTERS >> 8);
-        MEB_POLLING_FRAME.data.u8[3] = (uint8_t)PID_ENERGY_COUNTERS;
-        poll_pid = PID_ALLOWED_CHARGE_POWER;
-        break;
-      case PID_ALLOWED_CHARGE_POWER:
-        MEB_POLLING_FRAME.data.u8[2] = (uint8_t)(PID_ALLOWED_CHARGE_POWER >> 8);
-        MEB_POLLING_FRAME.data.u8[3] = (uint8_t)PID_ALLOWED_CHARGE_POWER;
-        poll_pid = PID_ALLOWED_DISCHARGE_POWER;
-        break;
-      case PID_ALLOWED_DISCHARGE_POWER:
-        MEB_POLLING_FRAME.data.u8[2] = (uint8_t)(PID_ALLOWED_DISCHARGE_POWER >> 8);
-        MEB_POLLING_FRAME.data.u8[3] = (uint8_t)PID_ALLOWED_DISCHARGE_POWER;
-        poll_pid = PID_CELLVOLTAGE_CELL_1;  // Start polling cell voltages
-        break;
-      // Cell Voltage Cases.
-      // Most of these are handled in the default case.
-      case PID_CELLVOLTAGE_CELL_1:
-        MEB_POLLING_FRAME.data.u8[2] = (uint8_t)(PID_CELLVOLTAGE_CELL_1 >> 8);
-        MEB_POLLING_FRAME.data.u8[3] = (uint8_t)PID_CELLVOLTAGE_CELL_1;
-        poll_pid = PID_CELLVOLTAGE_CELL_2;
-        break;
-      case PID_CELLVOLTAGE_CELL_84:
-        MEB_POLLING_FRAME.data.u8[3] = (uint8_t)PID_CELLVOLTAGE_CELL_84;
-        if (datalayer.battery.info.number_of_cells > 84) {
-          if (nof_cells_determined) {
-            poll_pid = PID_CELLVOLTAGE_CELL_85;
-          } else {
-            poll_pid = PID_CELLVOLTAGE_CELL_97;
-          }
-        } else {
-          poll_pid = PID_SOC;
-        }
-        break;
-      case PID_CELLVOLTAGE_CELL_96:
-        MEB_POLLING_FRAME.data.u8[3] = (uint8_t)PID_CELLVOLTAGE_CELL_96;
-        if (datalayer.battery.info.number_of_cells > 96)
-          poll_pid = PID_CELLVOLTAGE_CELL_97;
-        else
-          poll_pid = PID_SOC;
-        break;
-      case PID_CELLVOLTAGE_CELL_108:
-        MEB_POLLING_FRAME.data.u8[3] = (uint8_t)PID_CELLVOLTAGE_CELL_108;
-        poll_pid = PID_SOC;
-        break;
-      default:
-        if (poll_pid >= PID_CELLVOLTAGE_CELL_1 && poll_pid <= PID_CELLVOLTAGE_CELL_108) {
-          // The general case for cell voltages (some specific cases handled above)
-          MEB_POLLING_FRAME.data.u8[3] = (uint8_t)poll_pid;
-          // Poll the next cell next
-          poll_pid = poll_pid + 1;
-        } else {
-          // Out-of-range PID, go back to the start
-          poll_pid = PID_SOC;
-        }
-        break;
-    }
-    if (first_can_msg > 0 && currentMillis > first_can_msg + 1000) {
-      transmit_can_frame(&MEB_POLLING_FRAME);
-    }
   }
 
-  // Send 500ms CAN Message
-  if (currentMillis - previousMillis500ms >= INTERVAL_500_MS) {
-    previousMillis500ms = currentMillis;
-
-    transmit_can_frame(&MEB_16A954B4);  //eTM, Cooling valves and pumps for BMS
-    transmit_can_frame(&MEB_569);       // Battery heating requests
-    transmit_can_frame(&MEB_1A55552B);  //Climate, heatpump and priorities
-    transmit_can_frame(&MEB_1A555548);  //ORU, OTA update message for reserving battery
-    transmit_can_frame(&MEB_16A954FB);  //Climate, request to BMS for starting preconditioning
+  // Diagnostic polling, the next request goes out as soon as the BMS has answered the previous one
+  if (first_can_msg > 0 && currentMillis > first_can_msg + 1000) {
+    poller.service(currentMillis);
   }
+  poll_client.service(currentMillis);
+  poll_transport.service(currentMillis);
 
   //Send 1s CANFD message
   if (currentMillis - previousMillis1s >= INTERVAL_1_S) {
     previousMillis1s = currentMillis;
 
-    MEB_641.data.u8[1] = ((MEB_641.data.u8[1] & 0xF0) | counter_1000ms);
-    MEB_641.data.u8[0] = vw_crc_calc(MEB_641.data.u8, MEB_641.DLC, MEB_641.ID);
+    vw_e2e_protect(MEB_641, counter_1000ms);
 
     MEB_1A5555A6.data.u8[2] = 0x7F;  //Outside temperature, factor 0.5, offset -50
 
@@ -1273,4 +951,140 @@ void MebBattery::setup(void) {  // Performs one time setup at startup
   datalayer.battery.info.max_cell_voltage_mV = MAX_CELL_VOLTAGE_MV;
   datalayer.battery.info.min_cell_voltage_mV = MIN_CELL_VOLTAGE_MV;
   datalayer.battery.info.max_cell_voltage_deviation_mV = MAX_CELL_DEVIATION_MV;
+  // The BMS reports the highest and lowest cell voltage itself, the cells are polled less often
+  cell_array(*datalayer_battery).keep_reported_extremes();
+  cell_array(*datalayer_battery).set_refresh_period(CELL_VOLTAGE_POLL_MS);
+
+  // Fixed rate messages, sent by the CAN TX scheduler. The counters and checksums are filled in right before sending.
+  // 10ms, 20ms, 40ms and 50ms messages are required for contactor closing
+  schedule_can_frame(&MEB_0FC, can_interface, INTERVAL_10_MS, CanTxPriority::High, [this] {
+    vw_e2e_protect(MEB_0FC, counter_10ms);
+    counter_10ms = (counter_10ms + 1) % 16;  //Goes from 0-1-2-3...15-0-1-2-3..
+    return true;
+  });
+  schedule_can_frame(&MEB_0FD, can_interface, INTERVAL_20_MS, CanTxPriority::High, [this] {
+    vw_e2e_protect(MEB_0FD, counter_20ms);
+    counter_20ms = (counter_20ms + 1) % 16;  //Goes from 0-1-2-3...15-0-1-2-3..
+    return true;
+  });
+  schedule_can_frame(&MEB_040, can_interface, INTERVAL_40_MS, CanTxPriority::High, [this] {
+    /* Airbag message, needed for BMS to function */
+    MEB_040.data.u8[7] = counter_040;
+    vw_e2e_protect(MEB_040, counter_40ms);
+    counter_40ms = (counter_40ms + 1) % 16;  //Goes from 0-1-2-3...15-0-1-2-3..
+    if (toggle) {
+      counter_040 = (counter_040 + 1) % 256;  // Increment only on every other pass
+    }
+    toggle = !toggle;  // Flip the toggle each time the message is sent
+    return true;
+  });
+  schedule_can_frame(&MEB_0C0, can_interface, INTERVAL_50_MS, CanTxPriority::High, [this] {
+    /* BMS needs to see this EM1 message. Content located in frame5&6 especially (can be static?)*/
+    /* Also the voltage seen externally to battery is in frame 7&8. At least for the 62kWh ID3 version does not seem to matter, but we send it anyway. */
+    MEB_0C0.data.u8[1] = ((MEB_0C0.data.u8[1] & 0xF0) | counter_50ms);
+    MEB_0C0.data.u8[7] = ((datalayer.battery.status.voltage_dV / 10) * 4) & 0x00FF;
+    MEB_0C0.data.u8[8] =
+        ((MEB_0C0.data.u8[8] & 0xF0) | ((((datalayer.battery.status.voltage_dV / 10) * 4) >> 8) & 0x0F));
+    MEB_0C0.data.u8[0] = vw_crc_calc(MEB_0C0);
+    counter_50ms = (counter_50ms + 1) % 16;  //Goes from 0-1-2-3...15-0-1-2-3..
+    return true;
+  });
+
+  schedule_can_frame(&MEB_16A954B4, can_interface, INTERVAL_500_MS, CanTxPriority::Low);  //eTM, Cooling valves, pumps
+  schedule_can_frame(&MEB_569, can_interface, INTERVAL_500_MS, CanTxPriority::Low);       // Battery heating requests
+  schedule_can_frame(&MEB_1A55552B, can_interface, INTERVAL_500_MS, CanTxPriority::Low);  //Climate, heatpump
+  schedule_can_frame(&MEB_1A555548, can_interface, INTERVAL_500_MS, CanTxPriority::Low);  //ORU, OTA update reservation
+  schedule_can_frame(&MEB_16A954FB, can_interface, INTERVAL_500_MS, CanTxPriority::Low);  //Climate, preconditioning
+
+  // Values polled from the BMS. The values the control loop runs on are kept fresh, the cell voltages and
+  // temperature points are refreshed in the time left. The cell voltages are polled first, to find out the
+  // number of cells in the pack.
+  poll_transport.add(&poll_session);
+  cell_voltage_row =
+      poller.add({"Cell voltages", PID_CELLVOLTAGE_CELL_1, 108, 2, CELL_VOLTAGE_POLL_MS, PollPriority::Normal,
+                  [this](uint16_t pid, const uint8_t* value, size_t) {
+                    handle_cell_voltage(pid - PID_CELLVOLTAGE_CELL_1, be16(value));
+                  }});
+  poller.add({"SOC", PID_SOC, 1, 1, 1000, PollPriority::High, [this](uint16_t, const uint8_t* value, size_t) {
+                battery_soc_polled = value[0] * 4;  // 135*4 = 54.0%
+              }});
+  poller.add({"Voltage", PID_VOLTAGE, 1, 2, 1000, PollPriority::High,
+              [this](uint16_t, const uint8_t* value, size_t) { battery_voltage_polled = be16(value); }});
+  // IDLE 0A: 00 08 62 1E 3D (00 02) 49 F0 39 AA AA, TODO: right bits?
+  poller.add({"Current", PID_CURRENT, 1, 2, 1000, PollPriority::High,
+              [this](uint16_t, const uint8_t* value, size_t) { battery_current_polled = be16(value); }});
+  poller.add({"Allowed charge power", PID_ALLOWED_CHARGE_POWER, 1, 2, 1000, PollPriority::High,
+              [this](uint16_t, const uint8_t* value, size_t) { battery_allowed_charge_power = be16(value); }});
+  poller.add({"Allowed discharge power", PID_ALLOWED_DISCHARGE_POWER, 1, 2, 1000, PollPriority::High,
+              [this](uint16_t, const uint8_t* value, size_t) { battery_allowed_discharge_power = be16(value); }});
+  poller.add({"Max temperature", PID_MAX_TEMP, 1, 2, 2000, PollPriority::Normal,
+              [this](uint16_t, const uint8_t* value, size_t) { battery_max_temp = be16(value); }});
+  poller.add({"Min temperature", PID_MIN_TEMP, 1, 2, 2000, PollPriority::Normal,
+              [this](uint16_t, const uint8_t* value, size_t) { battery_min_temp = be16(value); }});
+  poller.add({"Max charge voltage", PID_MAX_CHARGE_VOLTAGE, 1, 2, 5000, PollPriority::Normal,
+              [this](uint16_t, const uint8_t* value, size_t) { battery_max_charge_voltage = be16(value); }});
+  poller.add({"Min discharge voltage", PID_MIN_DISCHARGE_VOLTAGE, 1, 2, 5000, PollPriority::Normal,
+              [this](uint16_t, const uint8_t* value, size_t) { battery_min_discharge_voltage = be16(value); }});
+  poller.add({"Temperature points", PID_TEMP_POINT_1, 18, 2, 10000, PollPriority::Low,
+              [](uint16_t pid, const uint8_t* value, size_t) {
+                datalayer_extended.meb.temp_points[pid - PID_TEMP_POINT_1] = (be16(value) / 8.f) - 40;
+              }});
+  poller.add({"Energy counters", PID_ENERGY_COUNTERS, 1, 16, 60000, PollPriority::Low,
+              [this](uint16_t, const uint8_t* value, size_t) {
+                // int32_t ah_discharge = be32(value);
+                // int32_t ah_charge = be32(value + 4);
+                kwh_charge = be32(value + 8);
+                kwh_discharge = be32(value + 12);
+                // logging.printf("ah_dis:%.3f ah_ch:%.3f kwh_dis:%.3f kwh_ch:%.3f\n", ah_discharge*0.00182044545, ah_charge*0.00182044545,
+                // kwh_discharge*0.00011650853, kwh_charge*0.00011650853);
+                datalayer.battery.status.total_discharged_battery_Wh = kwh_discharge * 0.11650853;
+                datalayer.battery.status.total_charged_battery_Wh = kwh_charge * 0.11650853;
+              }});
+}
+
+IsoTpConfig MebBattery::diagnostic_config() {
+  IsoTpConfig config;
+  config.tx_id = 0x1C40007B;
+  config.rx_id = 0x1C42007B;
+  config.ext_ID = true;
+  config.FD = true;
+  config.padding = 0x55;
+  return config;
+}
+
+void MebBattery::handle_cell_voltage(uint8_t cell, uint16_t value) {
+  if (value != 0xFFE) {
+    cell_array(*datalayer_battery).set_voltage(cell, value + 1000, millis());
+  }
+  if (nof_cells_determined) {
+    return;
+  }
+  // Cells the pack does not have read 0xFFE
+  if (cell == 84 && value == 0xFFE) {  // Cell 85 unavailable. We have a 84S battery (48kWh)
+    set_number_of_cells(84);
+  } else if (cell == 96 && value == 0xFFE) {  // Cell 97 unavailable. We have a 96S battery (55kWh)
+    set_number_of_cells(96);
+  } else if (cell == 107) {
+    if (value != 0xFFE) {
+      set_number_of_cells(108);
+    }
+    nof_cells_determined = true;
+  }
+}
+
+void MebBattery::set_number_of_cells(uint8_t cells) {
+  datalayer.battery.info.number_of_cells = cells;
+  nof_cells_determined = true;
+  if (cells == 84) {
+    datalayer.battery.info.max_design_voltage_dV = MAX_PACK_VOLTAGE_84S_DV;
+    datalayer.battery.info.min_design_voltage_dV = MIN_PACK_VOLTAGE_84S_DV;
+  } else if (cells == 96) {
+    datalayer.battery.info.max_design_voltage_dV = MAX_PACK_VOLTAGE_96S_DV;
+    datalayer.battery.info.min_design_voltage_dV = MIN_PACK_VOLTAGE_96S_DV;
+  } else {
+    datalayer.battery.info.max_design_voltage_dV = MAX_PACK_VOLTAGE_108S_DV;
+    datalayer.battery.info.min_design_voltage_dV = MIN_PACK_VOLTAGE_108S_DV;
+  }
+  // No need to ask for the cells the pack does not have
+  poller.limit(cell_voltage_row, cells);
 }
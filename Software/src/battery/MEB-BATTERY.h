@@ -1,5 +1,6 @@
 #ifndef MEB_BATTERY_H
 #define MEB_BATTERY_H
+#include "../communication/can/poll_scheduler.h"
 #include "CanBattery.h"
 #include "MEB-HTML.h"
 
@@ -19,7 +20,7 @@ class MebBattery : public CanBattery {
   }
 
   virtual void setup(void);
-  virtual void handle_incoming_can_frame(CAN_frame rx_frame);
+  virtual void handle_incoming_can_frame(const CAN_frame& rx_frame);
   virtual void update_values();
   virtual void transmit_can(unsigned long currentMillis);
   bool supports_real_BMS_status() { return true; }
@@ -29,7 +30,7 @@ class MebBattery : public CanBattery {
   BatteryHtmlRenderer& get_status_renderer() { return renderer; }
 
  private:
-  MebHtmlRenderer renderer;
+  MebHtmlRenderer renderer{poller};
 
   DATALAYER_BATTERY_TYPE* datalayer_battery;
   DATALAYER_INFO_MEB* datalayer_meb;
@@ -43,6 +44,7 @@ class MebBattery : public CanBattery {
   static const int MAX_CELL_DEVIATION_MV = 150;
   static const int MAX_CELL_VOLTAGE_MV = 4250;  //Battery is put into emergency stop if one cell goes over this value
   static const int MIN_CELL_VOLTAGE_MV = 2700;  //Battery is put into emergency stop if one cell goes below this value
+  static const int CELL_VOLTAGE_POLL_MS = 10000;  //Target refresh period of the polled cell voltages
   static const int PID_SOC = 0x028C;
   static const int PID_VOLTAGE = 0x1E3B;
   static const int PID_CURRENT = 0x1E3D;
@@ -180,13 +182,8 @@ class MebBattery : public CanBattery {
   static const int PID_TEMP_POINT_17 = 0x1EBE;
   static const int PID_TEMP_POINT_18 = 0x1EBF;
 
-  unsigned long previousMillis10ms = 0;   // will store last time a 10ms CAN Message was send
-  unsigned long previousMillis20ms = 0;   // will store last time a 20ms CAN Message was send
-  unsigned long previousMillis40ms = 0;   // will store last time a 40ms CAN Message was send
-  unsigned long previousMillis50ms = 0;   // will store last time a 50ms CAN Message was send
   unsigned long previousMillis100ms = 0;  // will store last time a 100ms CAN Message was send
   unsigned long previousMillis200ms = 0;  // will store last time a 200ms CAN Message was send
-  unsigned long previousMillis500ms = 0;  // will store last time a 200ms CAN Message was send
   unsigned long previousMillis1s = 0;     // will store last time a 1s CAN Message was send
 
   bool toggle = false;
@@ -201,9 +198,7 @@ class MebBattery : public CanBattery {
   uint8_t counter_0F7 = 0;
   uint8_t counter_3b5 = 0;
 
-  uint32_t poll_pid = PID_CELLVOLTAGE_CELL_85;  // We start here to quickly determine the cell size of the pack.
   bool nof_cells_determined = false;
-  uint32_t pid_reply = 0;
   uint16_t battery_soc_polled = 0;
   uint16_t battery_voltage_polled = 1480;
   int16_t battery_current_polled = 0;
@@ -213,8 +208,6 @@ class MebBattery : public CanBattery {
   uint16_t battery_min_discharge_voltage = 0;
   uint16_t battery_allowed_charge_power = 0;
   uint16_t battery_allowed_discharge_power = 0;
-  uint16_t cellvoltages_polled[108];
-  uint16_t tempval = 0;
   uint8_t BMS_16A954A6_CRC = 0;
   uint8_t BMS_5A2_counter = 0;
   uint8_t BMS_5CA_counter = 0;
@@ -369,16 +362,6 @@ class MebBattery : public CanBattery {
 #define DC_FASTCHARGE_LS1 0x80
 #define DC_FASTCHARGE_LS2 0xC0
 
-  CAN_frame MEB_POLLING_FRAME = {.FD = true,
-                                 .ext_ID = true,
-                                 .DLC = 8,
-                                 .ID = 0x1C40007B,  // SOC 02 8C
-                                 .data = {0x03, 0x22, 0x02, 0x8C, 0x55, 0x55, 0x55, 0x55}};
-  static constexpr CAN_frame MEB_ACK_FRAME = {.FD = true,
-                                              .ext_ID = true,
-                                              .DLC = 8,
-                                              .ID = 0x1C40007B,  // Ack
-                                              .data = {0x30, 0x00, 0x00, 0x55, 0x55, 0x55, 0x55, 0x55}};
   //Messages needed for contactor closing
   CAN_frame MEB_040 = {.FD = true,  // Airbag
                        .ext_ID = false,
@@ -516,6 +499,18 @@ class MebBattery : public CanBattery {
                0xFF, 0xFF, 0x00, 0xFF, 0xFF, 0x25, 0x00, 0x02, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFE}};
 
   uint32_t can_msg_received = 0;
+
+  // Diagnostic polling of the BMS, the values polled are listed in setup()
+  uint8_t poll_buffer[256];
+  IsoTpSession poll_session{diagnostic_config(), poll_buffer, sizeof(poll_buffer)};
+  IsoTpTransport poll_transport{[this](const CAN_frame& frame) { transmit_can_frame(&frame); }};
+  UdsClient poll_client{poll_session};
+  PollScheduler poller{poll_client};
+  size_t cell_voltage_row = 0;
+
+  static IsoTpConfig diagnostic_config();
+  void handle_cell_voltage(uint8_t cell, uint16_t value);
+  void set_number_of_cells(uint8_t cells);
 };
 
 #endif
@@ -1,12 +1,19 @@
 #ifndef _MEB_HTML_H
 #define _MEB_HTML_H
 
+#include <Arduino.h>
+#include "../communication/can/poll_scheduler.h"
 #include "../datalayer/datalayer.h"
 #include "../datalayer/datalayer_extended.h"
 #include "../devboard/webserver/BatteryHtmlRenderer.h"
 
 class MebHtmlRenderer : public BatteryHtmlRenderer {
+ private:
+  const PollScheduler& poller;
+
  public:
+  MebHtmlRenderer(const PollScheduler& p) : poller(p) {}
+
   String get_status_html() {
     String content;
 
@@ -286,6 +293,17 @@ class MebHtmlRenderer : public BatteryHtmlRenderer {
     content += "<h4>Total discharged: " + String(datalayer.battery.status.total_discharged_battery_Wh / 1000.0, 1) +
                " kWh</h4>";
 
+    // How fresh the polled values are, against the period they are polled for
+    const uint32_t now = millis();
+    for (size_t i = 0; i < poller.rows(); i++) {
+      const uint32_t age = poller.row_age_ms(i, now);
+      const uint32_t achieved = poller.row_achieved_period_ms(i);
+      content += "<h4>" + String(poller.row(i).name) + ": ";
+      content += age == POLL_NEVER ? String("not read yet") : String(age / 1000.f, 1) + " s old";
+      content += ", read every " + (achieved > 0 ? String(achieved / 1000.f, 1) + " s" : String("-"));
+      content += " (target " + String(poller.row(i).period_ms / 1000.f, 1) + " s)</h4>";
+    }
+
     return content;
   }
 };
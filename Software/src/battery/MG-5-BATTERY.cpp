@@ -33,7 +33,7 @@ void Mg5Battery::
   //datalayer.battery.status.temperature_max_dC;
 }
 
-void Mg5Battery::handle_incoming_can_frame(CAN_frame rx_frame) {
+void Mg5Battery::handle_incoming_can_frame(const CAN_frame& rx_frame) {
   switch (rx_frame.ID) {
     case 0x171:  //Following messages were detected on a MG5 battery BMS
       datalayer.battery.status.CAN_battery_still_alive = CAN_STILL_ALIVE;  // Let system know battery is sending CAN
@@ -121,7 +121,7 @@ void MgHsPHEVBattery::update_soc(uint16_t soc_times_ten) {
   }
 }
 
-void MgHsPHEVBattery::handle_incoming_can_frame(CAN_frame rx_frame) {
+void MgHsPHEVBattery::handle_incoming_can_frame(const CAN_frame& rx_frame) {
   switch (rx_frame.ID) {
     case 0x173:
       // Contains cell min/max voltages
@@ -28,7 +28,7 @@ class NissanLeafBattery : public CanBattery {
   }
 
   virtual void setup(void);
-  virtual void handle_incoming_can_frame(CAN_frame rx_frame);
+  virtual void handle_incoming_can_frame(const CAN_frame& rx_frame);
   virtual void update_values();
   virtual void transmit_can(unsigned long currentMillis);
 
@@ -44,7 +44,7 @@ class NissanLeafBattery : public CanBattery {
   BatteryHtmlRenderer& get_status_renderer() { return renderer; }
   static constexpr const char* Name = "Nissan LEAF battery";
 
-  uint8_t calculate_crc(CAN_frame& frame);
+  uint8_t calculate_crc(const CAN_frame& frame);
 
  private:
   static const int MAX_PACK_VOLTAGE_DV = 4040;  //5000 = 500.0V
@@ -55,7 +55,7 @@ class NissanLeafBattery : public CanBattery {
 
   NissanLeafHtmlRenderer renderer;
 
-  bool is_message_corrupt(CAN_frame rx_frame);
+  bool is_message_corrupt(const CAN_frame& rx_frame);
   void clearSOH(void);
 
   DATALAYER_BATTERY_TYPE* datalayer_battery;
@@ -139,20 +139,6 @@ class NissanLeafBattery : public CanBattery {
   // There are also two more groups: group 61, which replies with lots of CAN messages (up to 48); here we
   // found the SOH value, and group 84 that replies with the HV battery production serial.
 
-  uint8_t crctable[256] = {
-      0,   133, 143, 10,  155, 30,  20,  145, 179, 54,  60,  185, 40,  173, 167, 34,  227, 102, 108, 233, 120, 253,
-      247, 114, 80,  213, 223, 90,  203, 78,  68,  193, 67,  198, 204, 73,  216, 93,  87,  210, 240, 117, 127, 250,
-      107, 238, 228, 97,  160, 37,  47,  170, 59,  190, 180, 49,  19,  150, 156, 25,  136, 13,  7,   130, 134, 3,
-      9,   140, 29,  152, 146, 23,  53,  176, 186, 63,  174, 43,  33,  164, 101, 224, 234, 111, 254, 123, 113, 244,
-      214, 83,  89,  220, 77,  200, 194, 71,  197, 64,  74,  207, 94,  219, 209, 84,  118, 243, 249, 124, 237, 104,
-      98,  231, 38,  163, 169, 44,  189, 56,  50,  183, 149, 16,  26,  159, 14,  139, 129, 4,   137, 12,  6,   131,
-      18,  151, 157, 24,  58,  191, 181, 48,  161, 36,  46,  171, 106, 239, 229, 96,  241, 116, 126, 251, 217, 92,
-      86,  211, 66,  199, 205, 72,  202, 79,  69,  192, 81,  212, 222, 91,  121, 252, 246, 115, 226, 103, 109, 232,
-      41,  172, 166, 35,  178, 55,  61,  184, 154, 31,  21,  144, 1,   132, 142, 11,  15,  138, 128, 5,   148, 17,
-      27,  158, 188, 57,  51,  182, 39,  162, 168, 45,  236, 105, 99,  230, 119, 242, 248, 125, 95,  218, 208, 85,
-      196, 65,  75,  206, 76,  201, 195, 70,  215, 82,  88,  221, 255, 122, 112, 245, 100, 225, 235, 110, 175, 42,
-      32,  165, 52,  177, 187, 62,  28,  153, 147, 22,  135, 2,   8,   141};
-
   //Nissan LEAF battery parameters from constantly sent CAN
   uint8_t LEAF_battery_Type = ZE0_BATTERY;
   bool battery_can_alive = false;
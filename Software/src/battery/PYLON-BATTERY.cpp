@@ -36,7 +36,7 @@ void PylonBattery::update_values() {
   datalayer_battery->info.min_design_voltage_dV = discharge_cutoff_voltage;
 }
 
-void PylonBattery::handle_incoming_can_frame(CAN_frame rx_frame) {
+void PylonBattery::handle_incoming_can_frame(const CAN_frame& rx_frame) {
   switch (rx_frame.ID) {
     case 0x7310:
     case 0x7311:
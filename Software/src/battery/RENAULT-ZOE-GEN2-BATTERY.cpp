@@ -3,6 +3,7 @@
 #include "../communication/can/comm_can.h"
 #include "../datalayer/datalayer.h"
 #include "../datalayer/datalayer_extended.h"  //For "More battery info" webpage
+#include "../devboard/utils/crc.h"
 #include "../devboard/utils/events.h"
 
 /* TODO
@@ -22,15 +23,11 @@ https://github.com/ljames28/Renault-Zoe-PH2-ZE50-Canbus-LBC-Information?tab=read
 https://github.com/fesch/CanZE/tree/master/app/src/main/assets/ZOE_Ph2
 */
 
-uint8_t RenaultZoeGen2Battery::calculate_crc_zoe(CAN_frame& rx_frame, uint8_t crc_xor) {
-  uint8_t crc = 0;  //init value 0x00
-  for (uint8_t j = 0; j < 7; j++) {
-    crc = crctable[(crc ^ static_cast<uint8_t>(rx_frame.data.u8[j])) & 0xFF];
-  }
-  return crc ^ crc_xor;
+uint8_t RenaultZoeGen2Battery::calculate_crc_zoe(const CAN_frame& rx_frame, uint8_t crc_xor) {
+  return Crc8SaeJ1850Zero::calculate(rx_frame.data.u8, 7) ^ crc_xor;
 }
 
-bool RenaultZoeGen2Battery::is_message_corrupt(CAN_frame rx_frame, uint8_t crc_xor) {
+bool RenaultZoeGen2Battery::is_message_corrupt(const CAN_frame& rx_frame, uint8_t crc_xor) {
   uint8_t crc = calculate_crc_zoe(rx_frame, crc_xor);
   return crc != rx_frame.data.u8[7];
 }
@@ -128,7 +125,7 @@ void RenaultZoeGen2Battery::update_values() {
   datalayer_extended.zoePH2.battery_soc_max = battery_soc_max;
 }
 
-void RenaultZoeGen2Battery::handle_incoming_can_frame(CAN_frame rx_frame) {
+void RenaultZoeGen2Battery::handle_incoming_can_frame(const CAN_frame& rx_frame) {
   switch (rx_frame.ID) {
     case 0x0F8:
       datalayer_battery->status.CAN_battery_still_alive = CAN_STILL_ALIVE;
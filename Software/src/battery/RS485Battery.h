@@ -17,7 +17,7 @@ class RS485Battery : public Battery, Transmitter, Rs485Receiver {
   void transmit(unsigned long currentMillis) { transmit_rs485(currentMillis); }
 
   RS485Battery() {
-    register_transmitter(this);
+    register_transmitter(this, "battery");
     register_receiver(this);
   }
 };
@@ -2,6 +2,7 @@
 #include <cstring>  //For unit test
 #include "../communication/can/comm_can.h"
 #include "../datalayer/datalayer.h"
+#include "../devboard/utils/crc.h"
 #include "../devboard/utils/events.h"
 
 /* Credits go to maciek16c for these findings!
@@ -13,21 +14,8 @@ TODO: Tweak temperature values once more data is known about them
 TODO: Check if CRC function works like it should. This enables checking for corrupt messages
 */
 
-static uint8_t CalculateCRC8(CAN_frame rx_frame) {
-  int crc = 0;
-
-  for (uint8_t framepos = 0; framepos < 8; framepos++) {
-    crc ^= rx_frame.data.u8[framepos];
-
-    for (uint8_t j = 0; j < 8; j++) {
-      if ((crc & 0x80) != 0) {
-        crc = (crc << 1) ^ 0x1;
-      } else {
-        crc <<= 1;
-      }
-    }
-  }
-  return (uint8_t)crc;
+static uint8_t CalculateCRC8(const CAN_frame& rx_frame) {
+  return Crc8SantaFe::calculate(rx_frame.data.u8, 8);
 }
 
 void SantaFePhevBattery::
@@ -61,7 +49,7 @@ void SantaFePhevBattery::
   }
 }
 
-void SantaFePhevBattery::handle_incoming_can_frame(CAN_frame rx_frame) {
+void SantaFePhevBattery::handle_incoming_can_frame(const CAN_frame& rx_frame) {
   switch (rx_frame.ID) {
     case 0x1FF:
       datalayer_battery->status.CAN_battery_still_alive = CAN_STILL_ALIVE;
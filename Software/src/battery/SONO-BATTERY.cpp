@@ -33,7 +33,7 @@ void SonoBattery::
   datalayer.battery.status.temperature_max_dC = temperatureMax;
 }
 
-void SonoBattery::handle_incoming_can_frame(CAN_frame rx_frame) {
+void SonoBattery::handle_incoming_can_frame(const CAN_frame& rx_frame) {
   switch (rx_frame.ID) {
     case 0x100:
       datalayer.battery.status.CAN_battery_still_alive = CAN_STILL_ALIVE;
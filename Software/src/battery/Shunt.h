@@ -15,7 +15,7 @@ class CanShunt : public Transmitter, CanReceiver {
  public:
   virtual void setup() = 0;
   virtual void transmit_can(unsigned long currentMillis) = 0;
-  virtual void handle_incoming_can_frame(CAN_frame rx_frame) = 0;
+  virtual void handle_incoming_can_frame(const CAN_frame& rx_frame) = 0;
 
   // The name of the comm interface the shunt is using.
   virtual const char* interface_name() { return getCANInterfaceName(can_config.shunt); }
@@ -26,18 +26,18 @@ class CanShunt : public Transmitter, CanReceiver {
     }
   }
 
-  void receive_can_frame(CAN_frame* frame) { handle_incoming_can_frame(*frame); }
+  void receive_can_frame(const CAN_frame& frame) { handle_incoming_can_frame(frame); }
 
  protected:
   CAN_Interface can_interface;
 
   CanShunt() {
     can_interface = can_config.shunt;
-    register_transmitter(this);
-    register_can_receiver(this, can_interface);
+    register_transmitter(this, "shunt");
+    register_can_receiver(this, can_interface, "shunt");
   }
 
-  void transmit_can_frame(CAN_frame* frame) { transmit_can_frame_to_interface(frame, can_interface); }
+  void transmit_can_frame(CAN_frame* frame) { queue_can_frame(frame, can_interface); }
 };
 
 extern std::vector<ShuntType> supported_shunt_types();
@@ -1,6 +1,8 @@
 #include "TESLA-BATTERY.h"
+#include <Arduino.h>
 #include <cstring>  //For unit test
 #include "../communication/can/comm_can.h"
+#include "../datalayer/cell_array.h"
 #include "../datalayer/datalayer.h"
 #include "../datalayer/datalayer_extended.h"  //For Advanced Battery Insights webpage
 #include "../devboard/utils/events.h"
@@ -877,7 +879,7 @@ void TeslaBattery::
                  (battery_dcdcLvBusVolt * 0.0390625), (battery_dcdcLvOutputCurrent * 0.1));
 }
 
-void TeslaBattery::handle_incoming_can_frame(CAN_frame rx_frame) {
+void TeslaBattery::handle_incoming_can_frame(const CAN_frame& rx_frame) {
   static uint8_t mux = 0;
   static uint16_t temp = 0;
   static bool mux0_read = false;
@@ -1230,11 +1232,11 @@ void TeslaBattery::handle_incoming_can_frame(CAN_frame rx_frame) {
       {
         // Example, frame3=0x89,frame2=0x1D = 35101 / 10 = 3510mV
         volts = ((rx_frame.data.u8[3] << 8) | rx_frame.data.u8[2]) / 10;
-        datalayer.battery.status.cell_voltages_mV[mux * 3] = volts;
+        battery_cells.set_voltage(mux * 3, volts, millis());
         volts = ((rx_frame.data.u8[5] << 8) | rx_frame.data.u8[4]) / 10;
-        datalayer.battery.status.cell_voltages_mV[1 + mux * 3] = volts;
+        battery_cells.set_voltage(1 + mux * 3, volts, millis());
         volts = ((rx_frame.data.u8[7] << 8) | rx_frame.data.u8[6]) / 10;
-        datalayer.battery.status.cell_voltages_mV[2 + mux * 3] = volts;
+        battery_cells.set_voltage(2 + mux * 3, volts, millis());
 
         // Track the max value of mux. If we've seen two 0 values for mux, we've probably gathered all
         // cell voltages. Then, 2 + mux_max * 3 + 1 is the number of cell voltages.
@@ -2364,6 +2366,9 @@ void TeslaModel3YBattery::setup(void) {  // Performs one time setup at startup
     *allows_contactor_closing = true;
   }
 
+  // The BMS reports the highest and lowest cell voltage itself
+  battery_cells.keep_reported_extremes();
+
   //0x7FF GTW CAN frame values
   //Mux1
   write_signal_value(&TESLA_7FF_Mux1, 16, 16, user_selected_tesla_GTW_country, false);
@@ -2396,6 +2401,9 @@ void TeslaModelSXBattery::setup(void) {
     *allows_contactor_closing = true;
   }
 
+  // The BMS reports the highest and lowest cell voltage itself
+  battery_cells.keep_reported_extremes();
+
   strncpy(datalayer.system.info.battery_protocol, Name, 63);
   datalayer.system.info.battery_protocol[63] = '\0';
   datalayer.battery.info.max_design_voltage_dV = MAX_PACK_VOLTAGE_SX_NCMA;
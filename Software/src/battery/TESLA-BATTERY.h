@@ -18,7 +18,7 @@ class TeslaBattery : public CanBattery {
   // Use the default constructor to create the first or single battery.
   TeslaBattery() { allows_contactor_closing = &datalayer.system.status.battery_allows_contactor_closing; }
 
-  virtual void handle_incoming_can_frame(CAN_frame rx_frame);
+  virtual void handle_incoming_can_frame(const CAN_frame& rx_frame);
   virtual void update_values();
   virtual void transmit_can(unsigned long currentMillis);
 
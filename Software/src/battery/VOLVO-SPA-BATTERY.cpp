@@ -90,7 +90,7 @@ void VolvoSpaBattery::
   }
 }
 
-void VolvoSpaBattery::handle_incoming_can_frame(CAN_frame rx_frame) {
+void VolvoSpaBattery::handle_incoming_can_frame(const CAN_frame& rx_frame) {
   switch (rx_frame.ID) {
     case 0x3A:
       datalayer.battery.status.CAN_battery_still_alive = CAN_STILL_ALIVE;
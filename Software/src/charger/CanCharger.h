@@ -8,6 +8,8 @@
 #include "../devboard/safety/safety.h"
 #include "../devboard/utils/types.h"
 
+#include <vector>
+
 enum class ChargerType { None, NissanLeaf, ChevyVolt, Highest };
 
 extern ChargerType user_selected_charger_type;
@@ -46,7 +48,7 @@ class Charger {
 // Base class for chargers on a CAN bus
 class CanCharger : public Charger, Transmitter, CanReceiver {
  public:
-  virtual void map_can_frame_to_variable(CAN_frame rx_frame) = 0;
+  virtual void map_can_frame_to_variable(const CAN_frame& rx_frame) = 0;
   virtual void transmit_can(unsigned long currentMillis) = 0;
 
   void transmit(unsigned long currentMillis) {
@@ -55,7 +57,7 @@ class CanCharger : public Charger, Transmitter, CanReceiver {
     }
   }
 
-  void receive_can_frame(CAN_frame* frame) { map_can_frame_to_variable(*frame); }
+  void receive_can_frame(const CAN_frame& frame) { map_can_frame_to_variable(frame); }
 
   CAN_Interface interface() { return can_interface; }
 
@@ -64,11 +66,11 @@ class CanCharger : public Charger, Transmitter, CanReceiver {
 
   CanCharger(ChargerType type) : Charger(type) {
     can_interface = can_config.charger;
-    register_transmitter(this);
-    register_can_receiver(this, can_interface);
+    register_transmitter(this, "charger");
+    register_can_receiver(this, can_interface, "charger");
   }
 
-  void transmit_can_frame(CAN_frame* frame) { transmit_can_frame_to_interface(frame, can_interface); }
+  void transmit_can_frame(CAN_frame* frame) { queue_can_frame(frame, can_interface); }
 };
 
 #endif
@@ -6,6 +6,8 @@ class Transmitter {
   virtual void transmit(unsigned long currentMillis) = 0;
 };
 
-void register_transmitter(Transmitter* transmitter);
+// Register a transmitter to be called by the core task. The name (e.g. "battery") labels its execution time
+// statistics.
+void register_transmitter(Transmitter* transmitter, const char* name);
 
 #endif
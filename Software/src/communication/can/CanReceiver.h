@@ -3,9 +3,34 @@
 
 #include "../../devboard/utils/types.h"
 
+// Acceptance filter for the CAN IDs a receiver is interested in.
+// Frames outside of [min_id, max_id] are dropped before the receiver is called. If a bitmap is given,
+// standard (11-bit) IDs are additionally only accepted when their bit is set. The bitmap must stay valid
+// for the lifetime of the receiver, typically a static const array of CAN_ID_BITMAP_BYTES bytes.
+#define CAN_ID_BITMAP_BYTES (0x800 / 8)
+
+struct CanIdFilter {
+  uint32_t min_id = 0;
+  uint32_t max_id = 0x1FFFFFFF;
+  const uint8_t* std_id_bitmap = nullptr;
+
+  bool accepts(uint32_t id, bool ext_ID) const {
+    if (id < min_id || id > max_id) {
+      return false;
+    }
+    if (std_id_bitmap != nullptr && !ext_ID) {
+      return id < 0x800 && (std_id_bitmap[id >> 3] & (1 << (id & 7)));
+    }
+    return true;
+  }
+};
+
 class CanReceiver {
  public:
-  virtual void receive_can_frame(CAN_frame* rx_frame) = 0;
+  virtual void receive_can_frame(const CAN_frame& rx_frame) = 0;
+
+  // Override to limit which frames are passed to receive_can_frame. Queried once when CAN is initialized.
+  virtual CanIdFilter can_id_filter() { return CanIdFilter(); }
 };
 
 #endif
@@ -0,0 +1,261 @@
+#include "can_replay.h"
+#include <algorithm>
+#include <vector>
+#include "../../datalayer/datalayer.h"
+#include "../../devboard/sdcard/can_log_format.h"
+#include "../../devboard/sdcard/sdcard.h"
+#include "../../devboard/utils/logging.h"
+#include "../../system_settings.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/ringbuf.h"
+#include "freertos/task.h"
+
+// Frames handed from the replay task to the core task, which queues them on the TX scheduler of their
+// interface. The CAN drivers are only called from the core task.
+#define CAN_REPLAY_QUEUE_SIZE 4096
+// Frames moved to the TX schedulers per core loop tick, the TX queue of an interface holds CAN_TX_QUEUE_SIZE
+#define CAN_REPLAY_FRAMES_PER_TICK 8
+// How long the replay task waits for room in the queue before it drops a frame
+#define CAN_REPLAY_QUEUE_WAIT_MS 10
+// Longest single wait for the next frame, and how much later than the timer the wait gives up on it
+#define CAN_REPLAY_MAX_WAIT_US 1000000
+#define CAN_REPLAY_TIMER_MARGIN_MS 10
+
+struct ReplayQueuedFrame {
+  CAN_Interface interface;
+  CAN_frame frame;
+};
+
+// The loaded log as binary records, see can_log_format.h. Parsed once when loaded, so the replay task only
+// has to copy each record into a frame.
+static std::vector<uint8_t> replay_log;
+static CanLogParser replay_parser;
+static CanReplayStats stats;
+
+static TaskHandle_t replay_task_handle = NULL;
+static esp_timer_handle_t replay_timer = NULL;
+static RingbufHandle_t replay_queue = NULL;
+static volatile bool replay_running = false;
+static volatile bool replay_stop_requested = false;
+
+bool can_replay_load_begin() {
+  if (replay_running) {
+    return false;
+  }
+  replay_log.clear();
+  replay_parser.reset();
+  stats = CanReplayStats();
+  return true;
+}
+
+bool can_replay_load_chunk(const uint8_t* data, size_t length) {
+  if (replay_running || stats.log_truncated) {
+    return false;
+  }
+  if (!replay_parser.feed(data, length, replay_log, CAN_REPLAY_MAX_LOG_SIZE)) {
+    stats.log_truncated = true;
+    return false;
+  }
+  return true;
+}
+
+void can_replay_load_end() {
+  if (!stats.log_truncated && !replay_parser.finish(replay_log, CAN_REPLAY_MAX_LOG_SIZE)) {
+    stats.log_truncated = true;
+  }
+  replay_log.shrink_to_fit();
+
+  stats.lines_skipped = replay_parser.skipped();
+  stats.frames_loaded = 0;
+  CAN_log_record record;
+  for (size_t pos = 0; pos < replay_log.size();
+       pos += can_log_decode(replay_log.data() + pos, replay_log.size() - pos, record)) {
+    stats.frames_loaded++;
+  }
+
+  logging.printf("CAN replay: %u frames loaded, %u lines skipped%s\n", stats.frames_loaded, stats.lines_skipped,
+                 stats.log_truncated ? ", log truncated" : "");
+}
+
+bool can_replay_load_sd_log() {
+  if (!can_replay_load_begin()) {
+    return false;
+  }
+
+  pause_can_writing();
+  File file = SD_MMC.open(CAN_LOG_FILE, FILE_READ);
+  if (!file) {
+    resume_can_writing();
+    return false;
+  }
+  uint8_t chunk[512];
+  int length;
+  while ((length = file.read(chunk, sizeof(chunk))) > 0 && can_replay_load_chunk(chunk, length)) {}
+  file.close();
+  resume_can_writing();
+
+  can_replay_load_end();
+  return true;
+}
+
+static void replay_timer_callback(void* arg) {
+  xTaskNotifyGive(replay_task_handle);
+}
+
+// Sleep until the esp_timer time target_us. Returns false if the replay was stopped meanwhile.
+static bool wait_until(int64_t target_us) {
+  int64_t delay_us;
+  while (!replay_stop_requested && (delay_us = target_us - esp_timer_get_time()) > 0) {
+    // At most a second at a time, the notification may also come from can_replay_stop or a late timer
+    const int64_t step_us = std::min<int64_t>(delay_us, CAN_REPLAY_MAX_WAIT_US);
+    if (esp_timer_start_once(replay_timer, step_us) == ESP_OK) {
+      if (ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(step_us / 1000 + CAN_REPLAY_TIMER_MARGIN_MS)) == 0) {
+        esp_timer_stop(replay_timer);  // Never fired, not to wake a later wait
+      }
+    } else {
+      // Without the timer, sleep in whole ticks
+      ulTaskNotifyTake(pdTRUE, std::max<TickType_t>(pdMS_TO_TICKS(step_us / 1000), 1));
+    }
+  }
+  return !replay_stop_requested;
+}
+
+static void replay_log_once(uint64_t& jitter_sum_us) {
+  CAN_log_record record;
+  ReplayQueuedFrame queued = {};
+  int64_t start_us = esp_timer_get_time();
+  uint64_t first_timestamp_us = 0;
+  uint64_t last_timestamp_us = 0;
+  size_t pos = 0;
+
+  while (pos < replay_log.size()) {
+    const bool first_frame = pos == 0;
+    pos += can_log_decode(replay_log.data() + pos, replay_log.size() - pos, record);
+
+    if (first_frame || record.timestamp_us < last_timestamp_us) {
+      // First frame, or the log continues after a reboot, send it right away
+      start_us = esp_timer_get_time();
+      first_timestamp_us = record.timestamp_us;
+    }
+    last_timestamp_us = record.timestamp_us;
+
+    const int64_t target_us = start_us + (int64_t)(record.timestamp_us - first_timestamp_us);
+    if (!wait_until(target_us)) {
+      return;
+    }
+
+    const uint32_t late_us = (uint32_t)(esp_timer_get_time() - target_us);
+    jitter_sum_us += late_us;
+    stats.jitter_max_us = std::max(stats.jitter_max_us, late_us);
+
+    CAN_Interface interface = datalayer.system.info.can_replay_interface == CAN_REPLAY_INTERFACE_FROM_LOG
+                                  ? (CAN_Interface)record.interface
+                                  : (CAN_Interface)datalayer.system.info.can_replay_interface;
+    queued.frame.FD = (record.flags & CAN_LOG_FLAG_FD) != 0;
+    if (queued.frame.FD && interface != CANFD_NATIVE && interface != CANFD_ADDON_MCP2518) {
+      stats.frames_dropped++;
+      continue;
+    }
+    queued.interface = interface;
+    queued.frame.ext_ID = (record.flags & CAN_LOG_FLAG_EXT_ID) != 0;
+    queued.frame.ID = record.id;
+    queued.frame.DLC = record.dlc;
+    memcpy(queued.frame.data.u8, record.data, record.dlc);
+
+    // Sent by the core task, within a tick unless the replay outpaces the bus
+    if (xRingbufferSend(replay_queue, &queued, sizeof(queued), pdMS_TO_TICKS(CAN_REPLAY_QUEUE_WAIT_MS)) != pdTRUE) {
+      stats.frames_dropped++;
+      continue;
+    }
+    stats.frames_sent++;
+    stats.jitter_avg_us = jitter_sum_us / stats.frames_sent;
+  }
+}
+
+static void can_replay_task(void* param) {
+  uint64_t jitter_sum_us = 0;
+
+  do {
+    replay_log_once(jitter_sum_us);
+  } while (datalayer.system.info.loop_playback && !replay_stop_requested);
+
+  logging.printf("CAN replay: %u frames sent, late by %u us on average and %u us at most\n", stats.frames_sent,
+                 stats.jitter_avg_us, stats.jitter_max_us);
+
+  replay_running = false;
+  replay_task_handle = NULL;
+  vTaskDelete(NULL);
+}
+
+bool can_replay_start() {
+  // Prevent multiple replay tasks from being created
+  if (replay_running || replay_log.empty()) {
+    return false;
+  }
+
+  if (replay_timer == NULL) {
+    const esp_timer_create_args_t timer_args = {
+        .callback = &replay_timer_callback, .arg = NULL, .dispatch_method = ESP_TIMER_TASK, .name = "can_replay"};
+    if (esp_timer_create(&timer_args, &replay_timer) != ESP_OK) {
+      return false;
+    }
+  }
+
+  if (replay_queue == NULL) {
+    replay_queue = xRingbufferCreate(CAN_REPLAY_QUEUE_SIZE, RINGBUF_TYPE_NOSPLIT);
+    if (replay_queue == NULL) {
+      return false;
+    }
+  }
+
+  stats.frames_sent = 0;
+  stats.frames_dropped = 0;
+  stats.jitter_avg_us = 0;
+  stats.jitter_max_us = 0;
+  replay_stop_requested = false;
+  replay_running = true;
+
+  if (xTaskCreatePinnedToCore(can_replay_task, "CAN_Replay", 4096, NULL, TASK_CAN_REPLAY_PRIO, &replay_task_handle,
+                              1) != pdPASS) {
+    replay_running = false;
+    return false;
+  }
+  return true;
+}
+
+void can_replay_stop() {
+  datalayer.system.info.loop_playback = false;
+  if (replay_running) {
+    replay_stop_requested = true;
+    // Wake the task if it is waiting for the next frame
+    esp_timer_stop(replay_timer);
+    TaskHandle_t task = replay_task_handle;
+    if (task != NULL) {
+      xTaskNotifyGive(task);
+    }
+  }
+}
+
+void send_can_replay_frames() {
+  if (replay_queue == NULL) {
+    return;
+  }
+  size_t size;
+  ReplayQueuedFrame* queued;
+  for (int i = 0; i < CAN_REPLAY_FRAMES_PER_TICK; i++) {
+    if ((queued = (ReplayQueuedFrame*)xRingbufferReceive(replay_queue, &size, 0)) == nullptr) {
+      break;
+    }
+    queue_can_frame(&queued->frame, queued->interface);
+    vRingbufferReturnItem(replay_queue, queued);
+  }
+}
+
+bool can_replay_running() {
+  return replay_running;
+}
+
+const CanReplayStats& can_replay_stats() {
+  return stats;
+}
@@ -0,0 +1,41 @@
+#ifndef _CAN_REPLAY_H_
+#define _CAN_REPLAY_H_
+
+#include "comm_can.h"
+
+// Value of datalayer.system.info.can_replay_interface to send each frame on the interface it was logged on
+#define CAN_REPLAY_INTERFACE_FROM_LOG 0xFF
+
+// Upper limit for the parsed log kept in RAM, about 2700 classic CAN frames
+#define CAN_REPLAY_MAX_LOG_SIZE (64 * 1024)
+
+struct CanReplayStats {
+  uint32_t frames_loaded = 0;
+  uint32_t lines_skipped = 0;   // Lines or records in the log that could not be parsed
+  bool log_truncated = false;   // The log did not fit in CAN_REPLAY_MAX_LOG_SIZE
+  uint32_t frames_sent = 0;     // Frames sent in the current or last replay
+  uint32_t frames_dropped = 0;  // CAN-FD frames for a classic CAN interface, or frames the core task fell behind on
+  uint32_t jitter_avg_us = 0;   // How late frames were handed to the core task compared to the log timing
+  uint32_t jitter_max_us = 0;
+};
+
+// Loading a log, a text (candump/webserver log) or binary (SD card log) log is parsed once while it is
+// received in chunks. Not possible while a replay is running.
+bool can_replay_load_begin();
+bool can_replay_load_chunk(const uint8_t* data, size_t length);
+void can_replay_load_end();
+// Load the binary CAN log from SD card
+bool can_replay_load_sd_log();
+
+// Replays the loaded log in a separate task, over again while datalayer.system.info.loop_playback is set. The
+// task keeps the log timing, the core task sends the frames.
+bool can_replay_start();
+void can_replay_stop();
+bool can_replay_running();
+
+// Hands the frames of a running replay to the TX schedulers, called by the core task before service_can_tx
+void send_can_replay_frames();
+
+const CanReplayStats& can_replay_stats();
+
+#endif  // _CAN_REPLAY_H_
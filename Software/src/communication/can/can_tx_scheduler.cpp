@@ -0,0 +1,215 @@
+#include "can_tx_scheduler.h"
+
+#include <algorithm>
+
+// Delimiters, ACK, end of frame and interframe space
+static const uint16_t CAN_FRAME_TAIL_BITS = 13;
+// Bit stuffing adds up to one bit per four, with ordinary data it is closer to one per eight
+static const uint16_t CAN_STUFF_RATIO = 8;
+// The bus time one service may catch up on, so frames held back by a slow tick go out in a limited burst
+static const uint32_t CAN_TX_BURST_MS = 2;
+// Window of the bus load figure
+static const uint32_t CAN_TX_LOAD_WINDOW_MS = 1000;
+
+uint16_t can_frame_bits(const CAN_frame& frame, uint8_t data_rate_factor) {
+  // Start of frame, identifier, control bits and data length code
+  const uint16_t header = frame.ext_ID ? 39 : 19;
+  const uint16_t data = 8 * frame.DLC;
+
+  if (!frame.FD || data_rate_factor <= 1) {
+    const uint16_t stuffed = header + data + 15;  // With the CRC
+    return stuffed + stuffed / CAN_STUFF_RATIO + CAN_FRAME_TAIL_BITS;
+  }
+
+  // The bit rate switches after the control bits and back at the CRC delimiter
+  const uint16_t arbitration = header - 4;
+  const uint16_t data_phase = 4 + data + (frame.DLC > 16 ? 21 : 17);
+  return arbitration + arbitration / CAN_STUFF_RATIO +
+         (data_phase + data_phase / CAN_STUFF_RATIO + data_rate_factor - 1) / data_rate_factor + CAN_FRAME_TAIL_BITS;
+}
+
+static int32_t elapsed(uint32_t now, uint32_t since) {
+  return (int32_t)(now - since);
+}
+
+void CanTxScheduler::set_speed(uint16_t kbps, uint8_t factor) {
+  speed_kbps = std::max<uint16_t>(kbps, 1);
+  data_rate_factor = std::max<uint8_t>(factor, 1);
+  budget_bits = std::min(budget_bits, max_budget_bits());
+}
+
+int32_t CanTxScheduler::max_budget_bits() const {
+  return (int32_t)(CAN_TX_BURST_MS * speed_kbps);
+}
+
+bool CanTxScheduler::schedule(const CAN_frame* frame, uint16_t period_ms, CanTxPriority priority, UpdateFunction update,
+                              int16_t phase_ms) {
+  if (periodic_used >= CAN_TX_MAX_PERIODIC || frame == nullptr || period_ms == 0) {
+    return false;
+  }
+  Periodic& entry = periodic[periodic_used];
+  entry.frame = frame;
+  entry.update = std::move(update);
+  entry.period = period_ms;
+  // Frames registered together would otherwise all come due on the same tick
+  entry.phase = phase_ms == CAN_TX_AUTO_PHASE ? periodic_used % period_ms : phase_ms % period_ms;
+  entry.priority = priority;
+  entry.pending = false;
+  entry.updated = false;
+  entry.next_due = last_service_ms + entry.phase;
+  periodic_used++;
+  return true;
+}
+
+bool CanTxScheduler::queue(const CAN_frame& frame, CanTxPriority priority) {
+  if (queued_count >= CAN_TX_QUEUE_SIZE) {
+    tx_stats.dropped++;
+    return false;
+  }
+  for (Queued& slot : queued) {
+    if (!slot.used) {
+      slot.frame = frame;
+      slot.sequence = next_sequence++;
+      slot.queued_at = last_service_ms;
+      slot.priority = priority;
+      slot.used = true;
+      queued_count++;
+      break;
+    }
+  }
+  return true;
+}
+
+void CanTxScheduler::start(uint32_t now_ms) {
+  started = true;
+  last_service_ms = now_ms;
+  load_window_start = now_ms;
+  budget_bits = max_budget_bits();
+  for (uint16_t i = 0; i < periodic_used; i++) {
+    periodic[i].next_due = now_ms + periodic[i].phase;
+  }
+  for (Queued& slot : queued) {
+    slot.queued_at = now_ms;
+  }
+}
+
+void CanTxScheduler::mark_due(uint32_t now_ms) {
+  for (uint16_t i = 0; i < periodic_used; i++) {
+    Periodic& entry = periodic[i];
+    const int32_t late = elapsed(now_ms, entry.next_due);
+    if (late < 0) {
+      continue;
+    }
+    // Instances that came due since the last look, only the latest of them is sent
+    const uint32_t periods = (uint32_t)late / entry.period + 1;
+    tx_stats.deadline_misses += entry.pending ? periods : periods - 1;
+    entry.due = entry.next_due + (periods - 1) * entry.period;
+    entry.next_due += periods * entry.period;
+    entry.pending = true;
+    entry.updated = false;
+  }
+}
+
+// Sends the most urgent waiting frame. Returns false if there was none or the driver did not take it.
+bool CanTxScheduler::send_next() {
+  Periodic* best_periodic = nullptr;
+  for (uint16_t i = 0; i < periodic_used; i++) {
+    Periodic& entry = periodic[i];
+    if (entry.pending &&
+        (best_periodic == nullptr || entry.priority < best_periodic->priority ||
+         (entry.priority == best_periodic->priority && elapsed(entry.due, best_periodic->due) < 0))) {
+      best_periodic = &entry;
+    }
+  }
+
+  Queued* best_queued = nullptr;
+  if (queued_count > 0) {
+    for (Queued& slot : queued) {
+      if (slot.used && (best_queued == nullptr || slot.priority < best_queued->priority ||
+                        (slot.priority == best_queued->priority &&
+                         elapsed(slot.sequence, best_queued->sequence) < 0))) {
+        best_queued = &slot;
+      }
+    }
+  }
+
+  if (best_periodic != nullptr && best_queued != nullptr) {
+    // Frames of the same priority go out in the order they became due, queued ones first on a tie
+    if (best_queued->priority < best_periodic->priority ||
+        (best_queued->priority == best_periodic->priority &&
+         elapsed(best_queued->queued_at, best_periodic->due) <= 0)) {
+      best_periodic = nullptr;
+    } else {
+      best_queued = nullptr;
+    }
+  }
+
+  const CAN_frame* frame;
+  if (best_periodic != nullptr) {
+    if (!best_periodic->updated) {
+      best_periodic->updated = true;
+      if (best_periodic->update && !best_periodic->update()) {
+        best_periodic->pending = false;  // Not wanted this period
+        return true;
+      }
+    }
+    frame = best_periodic->frame;
+  } else if (best_queued != nullptr) {
+    frame = &best_queued->frame;
+  } else {
+    return false;
+  }
+
+  if (!send(*frame)) {
+    tx_stats.retries++;
+    return false;
+  }
+
+  const uint16_t bits = can_frame_bits(*frame, data_rate_factor);
+  budget_bits -= bits;
+  load_bits += bits;
+  tx_stats.frames_sent++;
+  if (best_periodic != nullptr) {
+    best_periodic->pending = false;
+  } else {
+    best_queued->used = false;
+    queued_count--;
+  }
+  return true;
+}
+
+void CanTxScheduler::update_load(uint32_t now_ms) {
+  const int32_t window = elapsed(now_ms, load_window_start);
+  if (window < (int32_t)CAN_TX_LOAD_WINDOW_MS) {
+    return;
+  }
+  const uint64_t capacity = (uint64_t)speed_kbps * window;
+  tx_stats.bus_load_pct = (uint8_t)std::min<uint64_t>((uint64_t)load_bits * 100 / capacity, 100);
+  load_bits = 0;
+  load_window_start = now_ms;
+}
+
+void CanTxScheduler::service(uint32_t now_ms) {
+  if (!started) {
+    start(now_ms);
+  } else {
+    const int32_t since_last = std::clamp<int32_t>(elapsed(now_ms, last_service_ms), 0, CAN_TX_LOAD_WINDOW_MS);
+    budget_bits = std::min<int32_t>(budget_bits + since_last * speed_kbps, max_budget_bits());
+    last_service_ms = now_ms;
+  }
+
+  mark_due(now_ms);
+
+  // A frame longer than what is left still goes out, the next ticks pay for it
+  while (budget_bits > 0 && send_next()) {
+  }
+
+  uint16_t depth = queued_count;
+  for (uint16_t i = 0; i < periodic_used; i++) {
+    depth += periodic[i].pending;
+  }
+  tx_stats.queue_depth = depth;
+  tx_stats.queue_high_water = std::max(tx_stats.queue_high_water, depth);
+
+  update_load(now_ms);
+}
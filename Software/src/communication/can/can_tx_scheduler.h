@@ -0,0 +1,116 @@
+#ifndef _CAN_TX_SCHEDULER_H_
+#define _CAN_TX_SCHEDULER_H_
+
+#include <stdint.h>
+#include <functional>
+#include "../../devboard/utils/types.h"
+
+enum class CanTxPriority : uint8_t { High, Normal, Low };
+
+// Let the scheduler spread a periodic frame against the ones registered before it
+#define CAN_TX_AUTO_PHASE -1
+
+#define CAN_TX_MAX_PERIODIC 48
+#define CAN_TX_QUEUE_SIZE 32
+
+struct CanTxStats {
+  uint32_t frames_sent = 0;
+  // Frames waiting to be sent after the last service, and the most seen since boot
+  uint16_t queue_depth = 0;
+  uint16_t queue_high_water = 0;
+  // Periodic frames that were still waiting when they came due again, that period was skipped
+  uint32_t deadline_misses = 0;
+  // Sends refused by a full transmit buffer, the frame is tried again on the next tick
+  uint32_t retries = 0;
+  // Queued frames lost because the queue was full
+  uint32_t dropped = 0;
+  // Share of the last second the bus was busy with frames sent and received
+  uint8_t bus_load_pct = 0;
+};
+
+// Length of a frame on the bus in arbitration bit times, with the average bit stuffing. The data phase of CAN FD
+// frames is counted at data_rate_factor times the arbitration bit rate.
+uint16_t can_frame_bits(const CAN_frame& frame, uint8_t data_rate_factor = 1);
+
+/* Sends the frames of one CAN interface. Frames are either registered to go out periodically, or queued to go out
+ * once. Each tick service() sends what is due, highest priority and oldest first, but no more than the bus can carry
+ * in the time since the last tick. That spreads the frames the integrations produce at once over the following
+ * ticks, instead of handing the driver a burst that overflows its transmit buffer.
+ */
+class CanTxScheduler {
+ public:
+  // Hands a frame to the driver, false if its transmit buffer is full
+  using SendFunction = std::function<bool(const CAN_frame&)>;
+  // Called right before a periodic frame is sent, to fill in counters and checksums. Return false to skip this period.
+  using UpdateFunction = std::function<bool()>;
+
+  CanTxScheduler(uint16_t speed_kbps, SendFunction send) : speed_kbps(speed_kbps), send(std::move(send)) {}
+
+  void set_speed(uint16_t kbps, uint8_t data_rate_factor = 1);
+
+  // Send frame every period_ms, phase_ms after the first service. The frame is read when it is sent, so the caller
+  // keeps it alive and may change it in between. Returns false if the table is full.
+  bool schedule(const CAN_frame* frame, uint16_t period_ms, CanTxPriority priority = CanTxPriority::Normal,
+                UpdateFunction update = nullptr, int16_t phase_ms = CAN_TX_AUTO_PHASE);
+  // Send a copy of frame once. Returns false if the queue is full and the frame was dropped.
+  bool queue(const CAN_frame& frame, CanTxPriority priority = CanTxPriority::Normal);
+
+  // Count a received frame towards the bus load
+  void note_received(const CAN_frame& frame) { load_bits += can_frame_bits(frame, data_rate_factor); }
+
+  void service(uint32_t now_ms);
+
+  const CanTxStats& stats() const { return tx_stats; }
+  uint16_t periodic_count() const { return periodic_used; }
+
+ private:
+  struct Periodic {
+    const CAN_frame* frame;
+    UpdateFunction update;
+    uint32_t next_due;
+    uint32_t due;  // Of the instance waiting to be sent
+    uint16_t period;
+    uint16_t phase;
+    CanTxPriority priority;
+    bool pending;
+    bool updated;  // The update function ran for the waiting instance
+  };
+
+  struct Queued {
+    CAN_frame frame;
+    uint32_t sequence;
+    uint32_t queued_at;
+    CanTxPriority priority;
+    bool used;
+  };
+
+  uint16_t speed_kbps;
+  uint8_t data_rate_factor = 1;
+  SendFunction send;
+
+  Periodic periodic[CAN_TX_MAX_PERIODIC];
+  uint16_t periodic_used = 0;
+  bool started = false;
+
+  // Free slots are reused, the sequence number keeps the queuing order
+  Queued queued[CAN_TX_QUEUE_SIZE] = {};
+  uint16_t queued_count = 0;
+  uint32_t next_sequence = 0;
+
+  // Bits the bus can still carry this tick
+  int32_t budget_bits = 0;
+  uint32_t last_service_ms = 0;
+
+  uint32_t load_bits = 0;
+  uint32_t load_window_start = 0;
+
+  CanTxStats tx_stats;
+
+  void start(uint32_t now_ms);
+  void mark_due(uint32_t now_ms);
+  bool send_next();
+  void update_load(uint32_t now_ms);
+  int32_t max_budget_bits() const;
+};
+
+#endif
@@ -8,11 +8,12 @@
 #include "src/devboard/safety/safety.h"
 #include "src/devboard/sdcard/sdcard.h"
 #include "src/devboard/utils/logging.h"
+#include "src/devboard/utils/perf_stats.h"
+#include "src/devboard/utils/web_log.h"
 
 #include <esp_private/periph_ctrl.h>
 
 #include <algorithm>
-#include <map>
 
 // The spare ESP32 SPI buses are called HSPI and VSPI, whereas on a ESP32S3
 // they are called FSPI and HSPI.
@@ -31,22 +32,65 @@ volatile CAN_Configuration can_config = {.battery = CAN_NATIVE,
                                          .charger = CAN_NATIVE,
                                          .shunt = CAN_NATIVE};
 
+// Upper limit of receivers sharing one interface (up to three batteries, inverter, charger and shunt)
+#define MAX_CAN_RECEIVERS_PER_INTERFACE 8
+
 struct CanReceiverRegistration {
   CanReceiver* receiver;
   CAN_Speed speed;
+  CanIdFilter filter;
+  int8_t perf_slot;
+};
+
+// Flat dispatch table per interface. Filled by register_can_receiver, the filters are frozen by init_CAN.
+struct CanDispatchTable {
+  CanReceiverRegistration entries[MAX_CAN_RECEIVERS_PER_INTERFACE];
+  uint8_t count = 0;
+  // Union of all receiver ID ranges, anything outside is dropped without looking at the receivers
+  uint32_t min_id = 0;
+  uint32_t max_id = 0x1FFFFFFF;
 };
 
-static std::multimap<CAN_Interface, CanReceiverRegistration> can_receivers;
+static CanDispatchTable can_receivers[NO_CAN_INTERFACE];
+
+static bool has_can_receivers(CAN_Interface interface) {
+  return can_receivers[interface].count > 0;
+}
 
 volatile bool send_ok_native = 0;
 volatile bool send_ok_2515 = 0;
 volatile bool send_ok_2518 = 0;
 
-void map_can_frame_to_variable(CAN_frame* rx_frame, CAN_Interface interface);
+void map_can_frame_to_variable(const CAN_frame* rx_frame, CAN_Interface interface);
+static void set_can_tx_speed(CAN_Interface interface, CAN_Speed speed);
+
+void register_can_receiver(CanReceiver* receiver, CAN_Interface interface, const char* name, CAN_Speed speed) {
+  if (interface >= NO_CAN_INTERFACE) {
+    return;  // Component is configured for a non-CAN interface
+  }
+  CanDispatchTable& table = can_receivers[interface];
+  if (table.count >= MAX_CAN_RECEIVERS_PER_INTERFACE) {
+    logging.printf("Too many CAN receivers on %s, ignoring registration\n", getCANInterfaceName(interface));
+    return;
+  }
+  table.entries[table.count++] = {receiver, speed, CanIdFilter(), perf_register_receiver(name)};
+  DEBUG_PRINTF("CAN receiver registered on %s, total: %d\n", getCANInterfaceName(interface), table.count);
+}
 
-void register_can_receiver(CanReceiver* receiver, CAN_Interface interface, CAN_Speed speed) {
-  can_receivers.insert({interface, {receiver, speed}});
-  DEBUG_PRINTF("CAN receiver registered, total: %d\n", can_receivers.size());
+// Fetch the acceptance filters of all registered receivers, after construction has completed
+static void freeze_can_receivers() {
+  for (auto& table : can_receivers) {
+    if (table.count == 0) {
+      continue;
+    }
+    table.min_id = 0x1FFFFFFF;
+    table.max_id = 0;
+    for (uint8_t i = 0; i < table.count; i++) {
+      table.entries[i].filter = table.entries[i].receiver->can_id_filter();
+      table.min_id = std::min(table.min_id, table.entries[i].filter.min_id);
+      table.max_id = std::max(table.max_id, table.entries[i].filter.max_id);
+    }
+  }
 }
 
 uint32_t init_native_can(CAN_Speed speed, gpio_num_t tx_pin, gpio_num_t rx_pin);
@@ -71,9 +115,19 @@ bool use_canfd_as_can = false;
 bool native_can_initialized = false;
 //CAN logging filter settings
 uint16_t user_selected_CAN_ID_cutoff_filter = 0;  //Messages below this ID will not be logged in webserver
+//Maximum number of frames handled per interface each core loop tick
+uint8_t user_selected_can_rx_frames_per_tick = CAN_RX_FRAMES_PER_TICK;
 
 bool init_CAN() {
 
+  freeze_can_receivers();
+
+  for (int i = 0; i < NO_CAN_INTERFACE; i++) {
+    if (has_can_receivers((CAN_Interface)i)) {
+      set_can_tx_speed((CAN_Interface)i, can_receivers[i].entries[0].speed);
+    }
+  }
+
   if (user_selected_can_addon_crystal_frequency_mhz > 0) {
     QUARTZ_FREQUENCY = user_selected_can_addon_crystal_frequency_mhz * 1000000UL;
   } else {
@@ -88,8 +142,7 @@ bool init_CAN() {
     quartz_fd_frequency = ACAN2517FDSettings::OSC_40MHz;
   }
 
-  auto nativeIt = can_receivers.find(CAN_NATIVE);
-  if (nativeIt != can_receivers.end()) {
+  if (has_can_receivers(CAN_NATIVE)) {
     auto se_pin = esp32hal->CAN_SE_PIN();
     auto tx_pin = esp32hal->CAN_TX_PIN();
     auto rx_pin = esp32hal->CAN_RX_PIN();
@@ -106,7 +159,7 @@ bool init_CAN() {
       return false;
     }
 
-    const uint32_t errorCode = init_native_can(nativeIt->second.speed, tx_pin, rx_pin);
+    const uint32_t errorCode = init_native_can(can_receivers[CAN_NATIVE].entries[0].speed, tx_pin, rx_pin);
     if (errorCode == 0) {
       native_can_initialized = true;
       logging.println("Native Can ok");
@@ -135,8 +188,7 @@ bool init_CAN() {
     }
   }
 
-  auto addonIt = can_receivers.find(CAN_ADDON_MCP2515);
-  if (addonIt != can_receivers.end()) {
+  if (has_can_receivers(CAN_ADDON_MCP2515)) {
     auto cs_pin = esp32hal->MCP2515_CS();
     auto int_pin = esp32hal->MCP2515_INT();
     auto sck_pin = esp32hal->MCP2515_SCK();
@@ -166,7 +218,7 @@ bool init_CAN() {
     SPI2515.begin(sck_pin, miso_pin, mosi_pin);
 
     // CAN bit rate 250 or 500 kb/s
-    auto bitRate = (int)addonIt->second.speed * 1000UL;
+    auto bitRate = (int)can_receivers[CAN_ADDON_MCP2515].entries[0].speed * 1000UL;
 
     settings2515 = new ACAN2515Settings(QUARTZ_FREQUENCY, bitRate);
     settings2515->mRequestedMode = ACAN2515Settings::NormalMode;
@@ -181,12 +233,10 @@ bool init_CAN() {
     }
   }
 
-  auto fdNativeIt = can_receivers.find(CANFD_NATIVE);
-  auto fdAddonIt = can_receivers.find(CANFD_ADDON_MCP2518);
-
-  if (fdNativeIt != can_receivers.end() || fdAddonIt != can_receivers.end()) {
+  if (has_can_receivers(CANFD_NATIVE) || has_can_receivers(CANFD_ADDON_MCP2518)) {
 
-    auto speed = (fdNativeIt != can_receivers.end()) ? fdNativeIt->second.speed : fdAddonIt->second.speed;
+    auto speed = has_can_receivers(CANFD_NATIVE) ? can_receivers[CANFD_NATIVE].entries[0].speed
+                                                 : can_receivers[CANFD_ADDON_MCP2518].entries[0].speed;
 
     auto cs_pin = esp32hal->MCP2517_CS();
     auto int_pin = esp32hal->MCP2517_INT();
@@ -239,16 +289,8 @@ bool init_CAN() {
   return true;
 }
 
-void transmit_can_frame_to_interface(const CAN_frame* tx_frame, CAN_Interface interface) {
-  if (!allowed_to_send_CAN) {
-    return;
-  }
-  print_can_frame(*tx_frame, interface, frameDirection(MSG_TX));
-
-  if (datalayer.system.info.CAN_SD_logging_active) {
-    add_can_frame_to_buffer(*tx_frame, frameDirection(MSG_TX));
-  }
-
+// Hand a frame to the driver of the interface. Returns false if its transmit buffer is full.
+static bool try_send_can_frame(const CAN_frame* tx_frame, CAN_Interface interface) {
   switch (interface) {
     case CAN_NATIVE: {
 
@@ -264,7 +306,8 @@ void transmit_can_frame_to_interface(const CAN_frame* tx_frame, CAN_Interface in
       if (!send_ok_native) {
         datalayer.system.info.can_native_send_fail = true;
       }
-    } break;
+      return send_ok_native;
+    }
     case CAN_ADDON_MCP2515: {
       //Struct with ACAN2515 library format, needed to use the MCP2515 library for CAN2
       CANMessage MCP2515Frame;
@@ -280,7 +323,8 @@ void transmit_can_frame_to_interface(const CAN_frame* tx_frame, CAN_Interface in
       if (!send_ok_2515) {
         datalayer.system.info.can_2515_send_fail = true;
       }
-    } break;
+      return send_ok_2515;
+    }
     case CANFD_NATIVE:
     case CANFD_ADDON_MCP2518: {
       CANFDMessage MCP2518Frame;
@@ -299,10 +343,99 @@ void transmit_can_frame_to_interface(const CAN_frame* tx_frame, CAN_Interface in
       if (!send_ok_2518) {
         datalayer.system.info.can_2518_send_fail = true;
       }
-    } break;
+      return send_ok_2518;
+    }
     default:
       // Invalid interface sent with function call. TODO: Raise event that coders messed up
-      break;
+      return true;
+  }
+}
+
+static void log_sent_can_frame(const CAN_frame* tx_frame, CAN_Interface interface) {
+  print_can_frame(*tx_frame, interface, frameDirection(MSG_TX));
+
+  if (datalayer.system.info.CAN_SD_logging_active) {
+    add_can_frame_to_buffer(*tx_frame, interface, frameDirection(MSG_TX));
+  }
+}
+
+void transmit_can_frame_to_interface(const CAN_frame* tx_frame, CAN_Interface interface) {
+  if (!allowed_to_send_CAN) {
+    return;
+  }
+  log_sent_can_frame(tx_frame, interface);
+  try_send_can_frame(tx_frame, interface);
+}
+
+// One TX scheduler per interface, created when a frame is first queued or registered for it
+static CanTxScheduler* can_tx_schedulers[NO_CAN_INTERFACE] = {};
+
+// Called by the scheduler of an interface. A refused frame stays with the scheduler and is tried again.
+static bool send_scheduled_can_frame(const CAN_frame& tx_frame, CAN_Interface interface) {
+  if (!allowed_to_send_CAN) {
+    return true;  // Dropped, the same as frames sent directly while sending is paused
+  }
+  if (!try_send_can_frame(&tx_frame, interface)) {
+    return false;
+  }
+  log_sent_can_frame(&tx_frame, interface);
+  return true;
+}
+
+static CanTxScheduler* can_tx_scheduler(CAN_Interface interface) {
+  if (interface >= NO_CAN_INTERFACE) {
+    return nullptr;  // Component is configured for a non-CAN interface
+  }
+  if (can_tx_schedulers[interface] == nullptr) {
+    can_tx_schedulers[interface] =
+        new CanTxScheduler((uint16_t)CAN_Speed::CAN_SPEED_500KBPS,
+                           [interface](const CAN_frame& frame) { return send_scheduled_can_frame(frame, interface); });
+  }
+  return can_tx_schedulers[interface];
+}
+
+// The scheduler paces frames by the bus time they take, which depends on the bit rates of the interface
+static void set_can_tx_speed(CAN_Interface interface, CAN_Speed speed) {
+  const bool fd = (interface == CANFD_NATIVE || interface == CANFD_ADDON_MCP2518) && !use_canfd_as_can;
+  can_tx_scheduler(interface)->set_speed((uint16_t)speed, fd ? 4 : 1);
+}
+
+void queue_can_frame(const CAN_frame* tx_frame, CAN_Interface interface, CanTxPriority priority) {
+  CanTxScheduler* scheduler = can_tx_scheduler(interface);
+  if (scheduler != nullptr) {
+    // The queue only fills up while the driver refuses frames, which already raised the send failure event
+    scheduler->queue(*tx_frame, priority);
+  }
+}
+
+bool schedule_can_frame(const CAN_frame* frame, CAN_Interface interface, uint16_t period_ms, CanTxPriority priority,
+                        CanTxScheduler::UpdateFunction update, int16_t phase_ms) {
+  CanTxScheduler* scheduler = can_tx_scheduler(interface);
+  if (scheduler == nullptr || !scheduler->schedule(frame, period_ms, priority, std::move(update), phase_ms)) {
+    logging.printf("Could not schedule CAN frame %X on %s\n", frame->ID, getCANInterfaceName(interface));
+    return false;
+  }
+  return true;
+}
+
+void service_can_tx(unsigned long currentMillis) {
+  for (int i = 0; i < NO_CAN_INTERFACE; i++) {
+    CanTxScheduler* scheduler = can_tx_schedulers[i];
+    if (scheduler == nullptr) {
+      continue;
+    }
+    scheduler->service(currentMillis);
+
+    const CanTxStats& stats = scheduler->stats();
+    DATALAYER_CAN_TX_STATS_TYPE& tx_stats = datalayer.system.status.can_tx_stats[i];
+    tx_stats.active = true;
+    tx_stats.frames_sent = stats.frames_sent;
+    tx_stats.queue_depth = stats.queue_depth;
+    tx_stats.queue_high_water = stats.queue_high_water;
+    tx_stats.deadline_misses = stats.deadline_misses;
+    tx_stats.retries = stats.retries;
+    tx_stats.dropped = stats.dropped;
+    tx_stats.bus_load_pct = stats.bus_load_pct;
   }
 }
 
@@ -321,32 +454,74 @@ void receive_can() {
   }
 }
 
-void receive_frame_can_native() {  // This section checks if we have a complete CAN message incoming on native CAN port
-  CANMessage frame;
+// Effective per tick RX budget, a setting of 0 would stall reception so at least one frame is always taken
+static uint16_t rx_budget() {
+  return std::max<uint16_t>(user_selected_can_rx_frames_per_tick, 1);
+}
 
-  if (ACAN_ESP32::can.available()) {
-    if (ACAN_ESP32::can.receive(frame)) {
+// Update the receive statistics of an interface after a drain pass
+static void update_rx_stats(CAN_Interface interface, uint16_t received, bool budget_exhausted, uint32_t overflows,
+                            uint32_t peak_count, uint16_t queue_size) {
+  DATALAYER_CAN_RX_STATS_TYPE& stats = datalayer.system.status.can_rx_stats[interface];
+  stats.frames_received += received;
+  stats.overflows += overflows;
+  stats.queue_size = queue_size;
+  if (budget_exhausted) {
+    stats.budget_exhausted++;
+  }
+  // Driver peak counts report size + 1 after an overflow
+  peak_count = std::min<uint32_t>(peak_count, queue_size);
+  if (peak_count > stats.queue_high_water) {
+    stats.queue_high_water = peak_count;
+  }
+}
 
-      CAN_frame rx_frame;
-      rx_frame.ID = frame.id;
-      rx_frame.ext_ID = frame.ext;
-      rx_frame.DLC = frame.len;
-      for (uint8_t i = 0; i < frame.len && i < 8; i++) {
-        rx_frame.data.u8[i] = frame.data[i];
-      }
+void receive_frame_can_native() {  // This section checks if we have complete CAN messages incoming on native CAN port
+  CANMessage frame;
+  const uint16_t budget = rx_budget();
+  uint16_t received = 0;
+
+  while (received < budget && ACAN_ESP32::can.available()) {
+    if (!ACAN_ESP32::can.receive(frame)) {
+      break;
+    }
+    received++;
 
-      //message incoming, pass it on to the handler
-      map_can_frame_to_variable(&rx_frame, CAN_NATIVE);
+    CAN_frame rx_frame;
+    rx_frame.ID = frame.id;
+    rx_frame.ext_ID = frame.ext;
+    rx_frame.DLC = frame.len;
+    for (uint8_t i = 0; i < frame.len && i < 8; i++) {
+      rx_frame.data.u8[i] = frame.data[i];
     }
+
+    //message incoming, pass it on to the handler
+    map_can_frame_to_variable(&rx_frame, CAN_NATIVE);
+  }
+
+  const uint16_t queue_size = ACAN_ESP32::can.driverReceiveBufferSize();
+  const uint16_t peak_count = ACAN_ESP32::can.driverReceiveBufferPeakCount();
+  update_rx_stats(CAN_NATIVE, received, received == budget && ACAN_ESP32::can.available(), peak_count > queue_size,
+                  peak_count, queue_size);
+  // The peak count latches an overflow, reset it so the next overflow is counted separately
+  if (peak_count > queue_size) {
+    ACAN_ESP32::can.resetDriverReceiveBufferPeakCount();
   }
 }
 
-void receive_frame_can_addon() {  // This section checks if we have a complete CAN message incoming on add-on CAN port
+void receive_frame_can_addon() {  // This section checks if we have complete CAN messages incoming on add-on CAN port
   CAN_frame rx_frame;             // Struct with our CAN format
   CANMessage MCP2515frame;        // Struct with ACAN2515 library format, needed to use the MCP2515 library
+  const uint16_t budget = rx_budget();
+  uint16_t received = 0;
+
+  // The MCP2515 driver does not flag overflows, a full queue means incoming frames are being dropped
+  const uint16_t queue_size = can2515->receiveBufferSize();
+  const bool queue_full = can2515->receiveBufferCount() >= queue_size;
 
-  if (can2515->available()) {
+  while (received < budget && can2515->available()) {
     can2515->receive(MCP2515frame);
+    received++;
 
     rx_frame.ID = MCP2515frame.id;
     rx_frame.ext_ID = MCP2515frame.ext;
@@ -358,13 +533,19 @@ void receive_frame_can_addon() {  // This section checks if we have a complete C
     //message incoming, pass it on to the handler
     map_can_frame_to_variable(&rx_frame, CAN_ADDON_MCP2515);
   }
+
+  update_rx_stats(CAN_ADDON_MCP2515, received, received == budget && can2515->available(), queue_full,
+                  can2515->receiveBufferPeakCount(), queue_size);
 }
 
-void receive_frame_canfd_addon() {  // This section checks if we have a complete CAN-FD message incoming
+void receive_frame_canfd_addon() {  // This section checks if we have complete CAN-FD messages incoming
   CANFDMessage MCP2518frame;
-  int count = 0;
-  while (canfd->available() && count++ < 16) {
+  const uint16_t budget = rx_budget();
+  uint16_t received = 0;
+
+  while (received < budget && canfd->available()) {
     canfd->receive(MCP2518frame);
+    received++;
 
     CAN_frame rx_frame;
     rx_frame.ID = MCP2518frame.id;
@@ -375,10 +556,18 @@ void receive_frame_canfd_addon() {  // This section checks if we have a complete
     map_can_frame_to_variable(&rx_frame, CANFD_ADDON_MCP2518);
     map_can_frame_to_variable(&rx_frame, CANFD_NATIVE);
   }
+
+  // Frames lost in the MCP2518 hardware FIFO are counted by the driver, take them over and restart its count
+  const uint8_t hardware_overflows = canfd->hardwareReceiveBufferOverflowCount();
+  if (hardware_overflows > 0) {
+    canfd->resetHardwareReceiveBufferOverflowCount();
+  }
+  update_rx_stats(CANFD_ADDON_MCP2518, received, received == budget && canfd->available(), hardware_overflows,
+                  canfd->driverReceiveBufferPeakCount(), settings2517->mDriverReceiveFIFOSize);
 }
 
 // Support functions
-void print_can_frame(CAN_frame frame, CAN_Interface interface, frameDirection msgDir) {
+void print_can_frame(const CAN_frame& frame, CAN_Interface interface, frameDirection msgDir) {
 
   if (datalayer.system.info.CAN_usb_logging_active) {
     uint8_t i = 0;
@@ -412,7 +601,7 @@ void print_can_frame(CAN_frame frame, CAN_Interface interface, frameDirection ms
   }
 }
 
-void map_can_frame_to_variable(CAN_frame* rx_frame, CAN_Interface interface) {
+void map_can_frame_to_variable(const CAN_frame* rx_frame, CAN_Interface interface) {
   if (interface !=
       CANFD_NATIVE) {  //Avoid printing twice due to receive_frame_canfd_addon sending to both FD interfaces
     //TODO: This check can be removed later when refactored to use inline functions for logging
@@ -423,56 +612,37 @@ void map_can_frame_to_variable(CAN_frame* rx_frame, CAN_Interface interface) {
     if (interface !=
         CANFD_NATIVE) {  //Avoid printing twice due to receive_frame_canfd_addon sending to both FD interfaces
       //TODO: This check can be removed later when refactored to use inline functions for logging
-      add_can_frame_to_buffer(*rx_frame, frameDirection(MSG_RX));
+      add_can_frame_to_buffer(*rx_frame, interface, frameDirection(MSG_RX));
     }
   }
 
-  // Send the frame to all the receivers registered for this interface.
-  auto receivers = can_receivers.equal_range(interface);
-
-  for (auto it = receivers.first; it != receivers.second; ++it) {
-    auto& receiver = it->second;
-    receiver.receiver->receive_can_frame(rx_frame);
+  if (can_tx_schedulers[interface] != nullptr) {
+    can_tx_schedulers[interface]->note_received(*rx_frame);
   }
-}
-
-void dump_can_frame(CAN_frame& frame, CAN_Interface interface, frameDirection msgDir) {
-  char* message_string = datalayer.system.info.logged_can_messages;
-  int offset = datalayer.system.info.logged_can_messages_offset;  // Keeps track of the current position in the buffer
-  size_t message_string_size = sizeof(datalayer.system.info.logged_can_messages);
 
-  if (offset + 128 > sizeof(datalayer.system.info.logged_can_messages)) {
-    // Not enough space, reset and start from the beginning
-    offset = 0;
+  // Send the frame to all the receivers registered for this interface that accept its ID.
+  const CanDispatchTable& table = can_receivers[interface];
+  if (rx_frame->ID < table.min_id || rx_frame->ID > table.max_id) {
+    return;
   }
-  unsigned long currentTime = millis();
-  // Add timestamp
-  offset += snprintf(message_string + offset, message_string_size - offset, "(%lu.%03lu) ", currentTime / 1000,
-                     currentTime % 1000);
-
-  // Add direction. Multiplying the interface by two ensures that SavvyCAN puts TX and RX in a different bus.
-  offset += snprintf(message_string + offset, message_string_size - offset, "%s%d ", (msgDir == MSG_RX) ? "RX" : "TX",
-                     (int)(interface * 2) + (msgDir == MSG_RX ? 0 : 1));
-
-  // Add ID and DLC
-  offset += snprintf(message_string + offset, message_string_size - offset, "%lX [%u] ", frame.ID, frame.DLC);
 
-  // Add data bytes
-  for (uint8_t i = 0; i < frame.DLC; i++) {
-    if (i < frame.DLC - 1) {
-      offset += snprintf(message_string + offset, message_string_size - offset, "%02X ", frame.data.u8[i]);
-    } else {
-      offset += snprintf(message_string + offset, message_string_size - offset, "%02X", frame.data.u8[i]);
+  for (uint8_t i = 0; i < table.count; i++) {
+    const CanReceiverRegistration& entry = table.entries[i];
+    if (entry.filter.accepts(rx_frame->ID, rx_frame->ext_ID)) {
+      const uint32_t start_cycles = perf_cycles();
+      entry.receiver->receive_can_frame(*rx_frame);
+      perf_record_receiver(entry.perf_slot, start_cycles);
     }
   }
-  // Add linebreak
-  offset += snprintf(message_string + offset, message_string_size - offset, "\n");
+}
 
-  datalayer.system.info.logged_can_messages_offset = offset;  // Update offset in buffer
+void dump_can_frame(const CAN_frame& frame, CAN_Interface interface, frameDirection msgDir) {
+  // Stored as binary record, the webserver formats it only if the log is looked at
+  web_log_can_frame(frame, interface, msgDir);
 }
 
 void stop_can() {
-  if (can_receivers.find(CAN_NATIVE) != can_receivers.end()) {
+  if (has_can_receivers(CAN_NATIVE)) {
     ACAN_ESP32::can.end();
   }
 
@@ -488,7 +658,7 @@ void stop_can() {
 }
 
 void restart_can() {
-  if (can_receivers.find(CAN_NATIVE) != can_receivers.end()) {
+  if (has_can_receivers(CAN_NATIVE)) {
     ACAN_ESP32::can.begin(*settingsespcan);
   }
 
@@ -536,6 +706,7 @@ bool change_can_speed(CAN_Interface interface, CAN_Speed speed) {
       logging.println(errorCode, HEX);
       return false;
     }
+    set_can_tx_speed(interface, speed);
     return true;
   }
 
@@ -2,18 +2,23 @@
 #define _COMM_CAN_H_
 
 #include "../../devboard/utils/types.h"
+#include "can_tx_scheduler.h"
 
 extern bool use_canfd_as_can;
 extern uint8_t user_selected_can_addon_crystal_frequency_mhz;
 extern uint8_t user_selected_canfd_addon_crystal_frequency_mhz;
 extern uint16_t user_selected_CAN_ID_cutoff_filter;
+extern uint8_t user_selected_can_rx_frames_per_tick;
 
-void dump_can_frame(CAN_frame& frame, CAN_Interface interface, frameDirection msgDir);
+void dump_can_frame(const CAN_frame& frame, CAN_Interface interface, frameDirection msgDir);
+// Send a frame right away, bypassing the TX scheduler. Only for callers that keep their own timing (CAN replay).
 void transmit_can_frame_to_interface(const CAN_frame* tx_frame, CAN_Interface interface);
 
 //These defines are not used if user updates values via Settings page
 #define CRYSTAL_FREQUENCY_MHZ 8
 #define CANFD_ADDON_CRYSTAL_FREQUENCY_MHZ ACAN2517FDSettings::OSC_40MHz
+// Maximum number of frames drained from each CAN interface per core loop tick
+#define CAN_RX_FRAMES_PER_TICK 32
 
 class CanReceiver;
 
@@ -41,7 +46,8 @@ enum class CAN_Speed {
 // Register a receiver object for a given CAN interface.
 // By default receivers expect the CAN interface to be operated at "fast" speed.
 // If halfSpeed is true, half speed is used.
-void register_can_receiver(CanReceiver* receiver, CAN_Interface interface,
+// The name (e.g. "battery") labels the execution time statistics of the receiver.
+void register_can_receiver(CanReceiver* receiver, CAN_Interface interface, const char* name,
                            CAN_Speed speed = CAN_Speed::CAN_SPEED_500KBPS);
 
 /**
@@ -63,7 +69,8 @@ bool init_CAN();
 void receive_can();
 
 /**
- * @brief Receive CAN messages from CAN tranceiver natively installed on Lilygo hardware
+ * @brief Receive CAN messages from CAN tranceiver natively installed on Lilygo hardware.
+ * Drains up to user_selected_can_rx_frames_per_tick frames per call.
  *
  * @param[in] void
  *
@@ -72,7 +79,8 @@ void receive_can();
 void receive_frame_can_native();
 
 /**
- * @brief Receive CAN messages from CAN addon chip
+ * @brief Receive CAN messages from CAN addon chip.
+ * Drains up to user_selected_can_rx_frames_per_tick frames per call.
  *
  * @param[in] void
  *
@@ -81,7 +89,8 @@ void receive_frame_can_native();
 void receive_frame_can_addon();
 
 /**
- * @brief Receive CAN messages from CANFD addon chip
+ * @brief Receive CAN messages from CANFD addon chip.
+ * Drains up to user_selected_can_rx_frames_per_tick frames per call.
  *
  * @param[in] void
  *
@@ -96,7 +105,49 @@ void receive_frame_canfd_addon();
  *
  * @return void
  */
-void print_can_frame(CAN_frame frame, CAN_Interface interface, frameDirection msgDir);
+void print_can_frame(const CAN_frame& frame, CAN_Interface interface, frameDirection msgDir);
+
+/**
+ * @brief Queue a copy of a frame to be sent once by the TX scheduler of the interface.
+ * The frame goes out during this or one of the next core loop ticks, depending on the priority and on the bus time
+ * left. If the driver transmit buffer is full it is tried again the next tick.
+ *
+ * @param[in] tx_frame Frame to send, may be changed or reused as soon as the call returns
+ * @param[in] interface CAN interface to send on
+ * @param[in] priority Frames of higher priority are sent first
+ *
+ * @return void
+ */
+void queue_can_frame(const CAN_frame* tx_frame, CAN_Interface interface,
+                     CanTxPriority priority = CanTxPriority::Normal);
+
+/**
+ * @brief Register a frame to be sent every period_ms by the TX scheduler of the interface.
+ * The frame is read when it is sent, so it must stay alive. Its contents can be changed at any time, or in the update
+ * function which is called right before each send.
+ *
+ * @param[in] frame Frame to send
+ * @param[in] interface CAN interface to send on
+ * @param[in] period_ms Time between two sends
+ * @param[in] priority Frames of higher priority are sent first
+ * @param[in] update Called before each send, returns false to skip that period. May be nullptr.
+ * @param[in] phase_ms Offset of the sends within the period, CAN_TX_AUTO_PHASE spreads the registered frames
+ *
+ * @return true if the frame was registered, false if the table of periodic frames is full
+ */
+bool schedule_can_frame(const CAN_frame* frame, CAN_Interface interface, uint16_t period_ms,
+                        CanTxPriority priority = CanTxPriority::Normal,
+                        CanTxScheduler::UpdateFunction update = nullptr, int16_t phase_ms = CAN_TX_AUTO_PHASE);
+
+/**
+ * @brief Send the queued and periodic frames that are due on all interfaces.
+ * Called by the core task each tick, after the transmitters have run.
+ *
+ * @param[in] currentMillis Current time in milliseconds
+ *
+ * @return void
+ */
+void service_can_tx(unsigned long currentMillis);
 
 // Stop/pause CAN communication for all interfaces
 void stop_can();
@@ -0,0 +1,323 @@
+#include "isotp.h"
+#include <string.h>
+#include <algorithm>
+
+// Protocol control information, the high nibble of the first byte
+#define PCI_SINGLE 0x0
+#define PCI_FIRST 0x1
+#define PCI_CONSECUTIVE 0x2
+#define PCI_FLOW_CONTROL 0x3
+
+#define FLOW_CONTINUE 0x0
+#define FLOW_WAIT 0x1
+#define FLOW_OVERFLOW 0x2
+
+#define CLASSIC_FRAME_LENGTH 8
+
+static bool time_reached(uint32_t now_ms, uint32_t due_ms) {
+  return (int32_t)(now_ms - due_ms) >= 0;
+}
+
+// STmin as sent in flow control frames
+static uint8_t st_min_to_ms(uint8_t st_min) {
+  if (st_min <= 0x7F) {
+    return st_min;
+  }
+  if (st_min >= 0xF1 && st_min <= 0xF9) {
+    return 1;  // 100 to 900 us, rounded up to the millisecond ticks
+  }
+  return 0x7F;  // Reserved values count as the longest gap
+}
+
+// Starts a frame to the ECU, returns where its payload goes, past the address extension
+uint8_t* IsoTpSession::new_frame(CAN_frame& frame) const {
+  frame = {};
+  frame.ID = cfg.tx_id;
+  frame.ext_ID = cfg.ext_ID;
+  frame.FD = cfg.FD;
+  frame.DLC = CLASSIC_FRAME_LENGTH;
+  memset(frame.data.u8, cfg.padding, CLASSIC_FRAME_LENGTH);
+  uint8_t* data = frame.data.u8;
+  if (cfg.tx_extension != ISOTP_NO_EXTENSION) {
+    *data++ = cfg.tx_extension;
+  }
+  return data;
+}
+
+bool IsoTpSession::send(const uint8_t* data, size_t length, uint32_t now_ms) {
+  if (tx_state != TxState::Idle || length == 0 || length > ISOTP_MAX_CLASSIC_LENGTH || !send_frame) {
+    return false;
+  }
+
+  CAN_frame frame;
+  uint8_t* payload = new_frame(frame);
+  const size_t room = frame.data.u8 + CLASSIC_FRAME_LENGTH - payload;
+  if (length < room) {
+    payload[0] = (PCI_SINGLE << 4) | length;
+    memcpy(payload + 1, data, length);
+    send_frame(frame);
+    finish_send(IsoTpResult::Ok, now_ms);
+    return true;
+  }
+
+  payload[0] = (PCI_FIRST << 4) | (length >> 8);
+  payload[1] = length & 0xFF;
+  memcpy(payload + 2, data, room - 2);
+  send_frame(frame);
+
+  tx_state = TxState::WaitFlowControl;
+  tx_data = data;
+  tx_length = length;
+  tx_position = room - 2;
+  tx_sequence = 1;
+  tx_waits = 0;
+  tx_due_ms = now_ms + cfg.timeout_ms;
+  return true;
+}
+
+void IsoTpSession::send_consecutive(uint32_t now_ms) {
+  CAN_frame frame;
+  uint8_t* payload = new_frame(frame);
+  const size_t room = frame.data.u8 + CLASSIC_FRAME_LENGTH - payload - 1;
+  const size_t chunk = std::min(room, tx_length - tx_position);
+  payload[0] = (PCI_CONSECUTIVE << 4) | tx_sequence;
+  memcpy(payload + 1, tx_data + tx_position, chunk);
+  send_frame(frame);
+  tx_position += chunk;
+  tx_sequence = (tx_sequence + 1) & 0x0F;
+
+  if (tx_position == tx_length) {
+    finish_send(IsoTpResult::Ok, now_ms);
+  } else if (tx_block_size != 0 && --tx_block_left == 0) {
+    tx_state = TxState::WaitFlowControl;
+    tx_due_ms = now_ms + cfg.timeout_ms;
+  } else {
+    tx_due_ms = now_ms + tx_st_min_ms;
+  }
+}
+
+void IsoTpSession::finish_send(IsoTpResult result, uint32_t now_ms) {
+  tx_state = TxState::Idle;
+  tx_data = nullptr;
+  if (result == IsoTpResult::Ok) {
+    session_stats.sent++;
+    tx_done_ms = now_ms;
+    awaiting_response = true;
+  } else if (result == IsoTpResult::Timeout) {
+    session_stats.timeouts++;
+  } else {
+    session_stats.errors++;
+  }
+  if (sent_done) {
+    sent_done(result, now_ms);
+  }
+}
+
+void IsoTpSession::send_flow_control(uint8_t status) {
+  CAN_frame frame;
+  uint8_t* payload = new_frame(frame);
+  payload[0] = (PCI_FLOW_CONTROL << 4) | status;
+  payload[1] = cfg.block_size;
+  payload[2] = cfg.st_min_ms;
+  send_frame(frame);
+}
+
+void IsoTpSession::finish_receive(IsoTpResult result, size_t length, uint32_t now_ms) {
+  rx_active = false;
+  if (result == IsoTpResult::Ok) {
+    session_stats.received++;
+    if (awaiting_response) {
+      awaiting_response = false;
+      session_stats.last_latency_ms = std::min<uint32_t>(now_ms - tx_done_ms, UINT16_MAX);
+      session_stats.max_latency_ms = std::max(session_stats.max_latency_ms, session_stats.last_latency_ms);
+    }
+  } else if (result == IsoTpResult::Timeout) {
+    session_stats.timeouts++;
+  } else {
+    session_stats.errors++;
+  }
+  if (received) {
+    received(result, length, now_ms);
+  }
+}
+
+void IsoTpSession::receive_single(const uint8_t* data, size_t length, uint32_t now_ms) {
+  size_t message_length = data[0] & 0x0F;
+  const uint8_t* payload = data + 1;
+  if (message_length == 0 && length > CLASSIC_FRAME_LENGTH) {
+    message_length = data[1];  // CAN FD single frames have the length in the next byte
+    payload = data + 2;
+  }
+  if (message_length == 0 || payload + message_length > data + length) {
+    return;  // Not a valid single frame, ignored as the standard asks
+  }
+
+  // A new message ends the one under way
+  if (message_length > rx_size) {
+    finish_receive(IsoTpResult::Overflow, 0, now_ms);
+    return;
+  }
+  memcpy(rx_buffer, payload, message_length);
+  finish_receive(IsoTpResult::Ok, message_length, now_ms);
+}
+
+void IsoTpSession::receive_first(const uint8_t* data, size_t length, uint32_t now_ms) {
+  size_t header = 2;
+  size_t message_length = ((data[0] & 0x0F) << 8) | data[1];
+  if (message_length == 0 && length >= 6) {
+    header = 6;  // Messages over 4095 bytes have a 32 bit length
+    message_length = ((uint32_t)data[2] << 24) | ((uint32_t)data[3] << 16) | (data[4] << 8) | data[5];
+  }
+  if (length <= header) {
+    return;
+  }
+  if (message_length > rx_size) {
+    send_flow_control(FLOW_OVERFLOW);
+    finish_receive(IsoTpResult::Overflow, 0, now_ms);
+    return;
+  }
+
+  rx_received = std::min(length - header, message_length);
+  memcpy(rx_buffer, data + header, rx_received);
+  rx_expected = message_length;
+  if (rx_received == rx_expected) {
+    finish_receive(IsoTpResult::Ok, rx_expected, now_ms);
+    return;
+  }
+  rx_active = true;
+  rx_sequence = 1;
+  rx_block_left = cfg.block_size;
+  rx_deadline_ms = now_ms + cfg.timeout_ms;
+  send_flow_control(FLOW_CONTINUE);
+}
+
+void IsoTpSession::receive_consecutive(const uint8_t* data, size_t length, uint32_t now_ms) {
+  if (!rx_active) {
+    return;
+  }
+  if ((data[0] & 0x0F) != rx_sequence) {
+    finish_receive(IsoTpResult::WrongSequence, 0, now_ms);
+    return;
+  }
+  rx_sequence = (rx_sequence + 1) & 0x0F;
+
+  const size_t chunk = std::min(length - 1, rx_expected - rx_received);
+  memcpy(rx_buffer + rx_received, data + 1, chunk);
+  rx_received += chunk;
+  rx_deadline_ms = now_ms + cfg.timeout_ms;
+  if (rx_received == rx_expected) {
+    finish_receive(IsoTpResult::Ok, rx_expected, now_ms);
+  } else if (cfg.block_size != 0 && --rx_block_left == 0) {
+    rx_block_left = cfg.block_size;
+    send_flow_control(FLOW_CONTINUE);
+  }
+}
+
+void IsoTpSession::receive_flow_control(const uint8_t* data, size_t length, uint32_t now_ms) {
+  if (tx_state != TxState::WaitFlowControl || length < 3) {
+    return;
+  }
+  switch (data[0] & 0x0F) {
+    case FLOW_CONTINUE:
+      tx_state = TxState::Sending;
+      tx_block_size = data[1];
+      tx_block_left = data[1];
+      tx_st_min_ms = st_min_to_ms(data[2]);
+      tx_due_ms = now_ms;
+      break;
+    case FLOW_WAIT:
+      if (++tx_waits > ISOTP_MAX_WAITS) {
+        finish_send(IsoTpResult::Aborted, now_ms);
+      } else {
+        tx_due_ms = now_ms + cfg.timeout_ms;
+      }
+      break;
+    default:
+      finish_send(IsoTpResult::Overflow, now_ms);
+      break;
+  }
+}
+
+bool IsoTpSession::handle_frame(const CAN_frame& frame, uint32_t now_ms) {
+  if (frame.ID != cfg.rx_id) {
+    return false;
+  }
+  const uint8_t* data = frame.data.u8;
+  size_t length = frame.DLC;
+  if (cfg.rx_extension != ISOTP_NO_EXTENSION) {
+    if (length == 0 || data[0] != cfg.rx_extension) {
+      return false;
+    }
+    data++;
+    length--;
+  }
+  if (length < 2) {
+    return true;  // Too short for any frame with content
+  }
+
+  switch (data[0] >> 4) {
+    case PCI_SINGLE:
+      receive_single(data, length, now_ms);
+      break;
+    case PCI_FIRST:
+      receive_first(data, length, now_ms);
+      break;
+    case PCI_CONSECUTIVE:
+      receive_consecutive(data, length, now_ms);
+      break;
+    case PCI_FLOW_CONTROL:
+      receive_flow_control(data, length, now_ms);
+      break;
+  }
+  return true;
+}
+
+void IsoTpSession::service(uint32_t now_ms) {
+  if (rx_active && time_reached(now_ms, rx_deadline_ms)) {
+    finish_receive(IsoTpResult::Timeout, 0, now_ms);
+  }
+
+  if (tx_state == TxState::WaitFlowControl && time_reached(now_ms, tx_due_ms)) {
+    finish_send(IsoTpResult::Timeout, now_ms);
+  }
+  for (int i = 0; i < ISOTP_FRAMES_PER_SERVICE; i++) {
+    if (tx_state != TxState::Sending || !time_reached(now_ms, tx_due_ms)) {
+      break;
+    }
+    send_consecutive(now_ms);
+    if (tx_st_min_ms != 0) {
+      break;  // The gap is at least a tick
+    }
+  }
+}
+
+void IsoTpSession::abort() {
+  tx_state = TxState::Idle;
+  tx_data = nullptr;
+  rx_active = false;
+  awaiting_response = false;
+}
+
+bool IsoTpTransport::add(IsoTpSession* session) {
+  if (session_count == ISOTP_MAX_SESSIONS) {
+    return false;
+  }
+  session->set_sender(send);
+  sessions[session_count++] = session;
+  return true;
+}
+
+bool IsoTpTransport::handle_frame(const CAN_frame& frame, uint32_t now_ms) {
+  for (uint8_t i = 0; i < session_count; i++) {
+    if (sessions[i]->handle_frame(frame, now_ms)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void IsoTpTransport::service(uint32_t now_ms) {
+  for (uint8_t i = 0; i < session_count; i++) {
+    sessions[i]->service(now_ms);
+  }
+}
@@ -0,0 +1,146 @@
+#ifndef _ISOTP_H_
+#define _ISOTP_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <functional>
+#include "../../devboard/utils/types.h"
+
+/* ISO 15765-2 (ISO-TP) transport for diagnostic requests and responses.
+ *
+ * A session is one pair of CAN IDs to and from an ECU. Received messages are copied straight from the frames
+ * into a buffer the caller provides. First frames are answered with a flow control frame asking for
+ * block_size consecutive frames at least st_min_ms apart. Messages sent that do not fit a single frame go out
+ * as consecutive frames, paced by the flow control the ECU answers with.
+ *
+ * Frames of any length up to 64 bytes are accepted, so CAN FD responses work too. Frames sent are 8 bytes
+ * long, marked FD if the session is.
+ *
+ * An IsoTpTransport hands the received frames of one CAN interface to its sessions, and has them send and
+ * time out in service(), called every tick.
+ */
+
+#define ISOTP_MAX_SESSIONS 4           // Per transport
+#define ISOTP_TIMEOUT_MS 1000          // N_Bs and N_Cr, for the next flow control or consecutive frame
+#define ISOTP_MAX_WAITS 10             // Flow control frames asking to wait before the send is given up
+#define ISOTP_FRAMES_PER_SERVICE 8     // Consecutive frames sent per tick at most, not to flood the queue
+#define ISOTP_MAX_CLASSIC_LENGTH 4095  // Longest message sent, the first frame sent has a 12 bit length
+#define ISOTP_NO_EXTENSION -1
+
+enum class IsoTpResult : uint8_t { Ok, Timeout, WrongSequence, Overflow, Aborted };
+
+struct IsoTpConfig {
+  uint32_t tx_id = 0;  // Frames to the ECU
+  uint32_t rx_id = 0;  // Frames from the ECU
+  bool ext_ID = false;
+  bool FD = false;
+  // Extended addressing, the address of the receiver goes first in each frame
+  int16_t tx_extension = ISOTP_NO_EXTENSION;
+  int16_t rx_extension = ISOTP_NO_EXTENSION;
+  uint8_t block_size = 0;  // Consecutive frames the ECU sends between flow control frames, 0 for all
+  uint8_t st_min_ms = 0;   // Gap the ECU leaves between consecutive frames
+  uint8_t padding = 0xAA;
+  uint16_t timeout_ms = ISOTP_TIMEOUT_MS;
+};
+
+struct IsoTpStats {
+  uint32_t received = 0;  // Messages
+  uint32_t sent = 0;
+  uint32_t timeouts = 0;
+  // Wrong sequence numbers, messages too long for the buffer and sends refused by the ECU
+  uint32_t errors = 0;
+  // From the end of a message sent to the end of the next one received
+  uint16_t last_latency_ms = 0;
+  uint16_t max_latency_ms = 0;
+};
+
+class IsoTpSession {
+ public:
+  using SendFunction = std::function<void(const CAN_frame&)>;
+  // A message was received into the buffer, or its reception failed and length is 0
+  using ReceiveFunction = std::function<void(IsoTpResult result, size_t length, uint32_t now_ms)>;
+  using SentFunction = std::function<void(IsoTpResult result, uint32_t now_ms)>;
+
+  IsoTpSession(const IsoTpConfig& config, uint8_t* buffer, size_t size)
+      : cfg(config), rx_buffer(buffer), rx_size(size) {}
+
+  void set_sender(SendFunction send) { send_frame = std::move(send); }
+  void on_receive(ReceiveFunction receive) { received = std::move(receive); }
+  void on_sent(SentFunction sent) { sent_done = std::move(sent); }
+
+  // Starts sending a message, data is read until the send completes. Returns false if a send is under way or
+  // the message is too long.
+  bool send(const uint8_t* data, size_t length, uint32_t now_ms);
+  // Returns false if the frame is not for this session
+  bool handle_frame(const CAN_frame& frame, uint32_t now_ms);
+  // Sends the consecutive frames due and times out the transfers under way
+  void service(uint32_t now_ms);
+  // Drops the transfers under way without calling back
+  void abort();
+
+  bool sending() const { return tx_state != TxState::Idle; }
+  bool receiving() const { return rx_active; }
+  const uint8_t* buffer() const { return rx_buffer; }
+  const IsoTpConfig& config() const { return cfg; }
+  const IsoTpStats& stats() const { return session_stats; }
+
+ private:
+  enum class TxState : uint8_t { Idle, WaitFlowControl, Sending };
+
+  IsoTpConfig cfg;
+  uint8_t* rx_buffer;
+  size_t rx_size;
+  SendFunction send_frame;
+  ReceiveFunction received;
+  SentFunction sent_done;
+  IsoTpStats session_stats;
+
+  TxState tx_state = TxState::Idle;
+  const uint8_t* tx_data = nullptr;
+  size_t tx_length = 0;
+  size_t tx_position = 0;
+  uint8_t tx_sequence = 0;
+  uint8_t tx_block_size = 0;
+  uint8_t tx_block_left = 0;
+  uint8_t tx_st_min_ms = 0;
+  uint8_t tx_waits = 0;
+  uint32_t tx_due_ms = 0;  // Next consecutive frame, or the timeout while waiting for flow control
+  uint32_t tx_done_ms = 0;
+  bool awaiting_response = false;
+
+  bool rx_active = false;
+  size_t rx_expected = 0;
+  size_t rx_received = 0;
+  uint8_t rx_sequence = 0;
+  uint8_t rx_block_left = 0;
+  uint32_t rx_deadline_ms = 0;
+
+  uint8_t* new_frame(CAN_frame& frame) const;
+  void send_flow_control(uint8_t status);
+  void send_consecutive(uint32_t now_ms);
+  void finish_send(IsoTpResult result, uint32_t now_ms);
+  void finish_receive(IsoTpResult result, size_t length, uint32_t now_ms);
+  void receive_single(const uint8_t* data, size_t length, uint32_t now_ms);
+  void receive_first(const uint8_t* data, size_t length, uint32_t now_ms);
+  void receive_consecutive(const uint8_t* data, size_t length, uint32_t now_ms);
+  void receive_flow_control(const uint8_t* data, size_t length, uint32_t now_ms);
+};
+
+// The sessions of one CAN interface
+class IsoTpTransport {
+ public:
+  explicit IsoTpTransport(IsoTpSession::SendFunction send) : send(std::move(send)) {}
+
+  // The session is kept by the caller. Returns false if the transport has no room for it.
+  bool add(IsoTpSession* session);
+  // Returns false if no session took the frame
+  bool handle_frame(const CAN_frame& frame, uint32_t now_ms);
+  void service(uint32_t now_ms);
+
+ private:
+  IsoTpSession::SendFunction send;
+  IsoTpSession* sessions[ISOTP_MAX_SESSIONS] = {};
+  uint8_t session_count = 0;
+};
+
+#endif
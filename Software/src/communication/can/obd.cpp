@@ -23,7 +23,7 @@ void show_dtc(uint8_t byte0, uint8_t byte1) {
   logging.printf("%c%d\n", letter, ((byte0 & 0x3F) << 8) | byte1);
 }
 
-void handle_obd_frame(CAN_frame& rx_frame, CAN_Interface interface) {
+void handle_obd_frame(const CAN_frame& rx_frame, CAN_Interface interface) {
   if (rx_frame.data.u8[1] == 0x7F) {
     const char* error_str = "?";
     switch (rx_frame.data.u8[3]) {  // See https://automotive.wiki/index.php/ISO_14229
@@ -125,21 +125,21 @@ void transmit_obd_can_frame(unsigned int address, CAN_Interface interface, bool
   static int cnt = 0;
   switch (cnt) {
     case 2:
-      transmit_can_frame_to_interface(&OBD_frame, interface);  // DTC TP-ISO
+      queue_can_frame(&OBD_frame, interface, CanTxPriority::Low);  // DTC TP-ISO
       break;
     case 3:
       OBD_frame.data.u8[1] = 0x07;
-      transmit_can_frame_to_interface(&OBD_frame, interface);  // DTC TP-ISO
+      queue_can_frame(&OBD_frame, interface, CanTxPriority::Low);  // DTC TP-ISO
       break;
     case 4:
       OBD_frame.data.u8[1] = 0x0A;
-      transmit_can_frame_to_interface(&OBD_frame, interface);  // DTC TP-ISO
+      queue_can_frame(&OBD_frame, interface, CanTxPriority::Low);  // DTC TP-ISO
       break;
     case 5:
       OBD_frame.data.u8[0] = 0x02;
       OBD_frame.data.u8[1] = 0x01;
       OBD_frame.data.u8[2] = 0x1C;
-      transmit_can_frame_to_interface(&OBD_frame, interface);  // DTC TP-ISO
+      queue_can_frame(&OBD_frame, interface, CanTxPriority::Low);  // DTC TP-ISO
       break;
   }
   cnt++;
@@ -0,0 +1,138 @@
+#include "poll_scheduler.h"
+#include <algorithm>
+
+// Response to ReadDataByIdentifier: service ID and identifier, then the value
+static const size_t VALUE_OFFSET = 3;
+
+size_t PollScheduler::add(const PollItem& item) {
+  items.push_back({item, (uint16_t)states.size(), item.count});
+  states.resize(states.size() + item.count);
+  return items.size() - 1;
+}
+
+void PollScheduler::limit(size_t row, uint8_t count) {
+  items[row].active = std::min(count, items[row].item.count);
+}
+
+void PollScheduler::service(uint32_t now_ms) {
+  now = now_ms;
+  size_t row;
+  uint8_t offset;
+  while (client.pending() < depth && pick(row, offset)) {
+    request(row, offset);
+  }
+}
+
+bool PollScheduler::pick(size_t& row, uint8_t& offset) const {
+  bool found = false;
+  PollPriority best_priority = PollPriority::Low;
+  uint32_t best_lateness = 0;  // Time since the last attempt, in 1/256 of the period
+
+  for (size_t r = 0; r < items.size(); r++) {
+    const Row& candidate = items[r];
+    if (found && candidate.item.priority < best_priority) {
+      continue;
+    }
+    for (uint8_t o = 0; o < candidate.active; o++) {
+      const State& state = states[candidate.first_state + o];
+      if (state.pending) {
+        continue;
+      }
+      uint32_t lateness = UINT32_MAX;  // Never asked for
+      if (state.attempted) {
+        const uint32_t elapsed = now - state.attempted_ms;
+        if (elapsed < candidate.item.period_ms) {
+          continue;
+        }
+        lateness = std::min<uint64_t>(((uint64_t)elapsed << 8) / std::max<uint16_t>(candidate.item.period_ms, 1),
+                                      UINT32_MAX - 1);
+      }
+      if (!found || candidate.item.priority > best_priority || lateness > best_lateness) {
+        found = true;
+        best_priority = candidate.item.priority;
+        best_lateness = lateness;
+        row = r;
+        offset = o;
+      }
+    }
+  }
+  return found;
+}
+
+void PollScheduler::request(size_t row, uint8_t offset) {
+  State& state = states[items[row].first_state + offset];
+  const uint16_t identifier = items[row].item.identifier + offset;
+  // Small enough a capture for std::function to hold without allocating
+  const uint32_t key = (row << 8) | offset;
+  const bool queued = client.read_data_by_identifier(
+      identifier, [this, key](UdsResult result, const uint8_t* data, size_t length) {
+        handle_response(key >> 8, key & 0xFF, result, data, length);
+      });
+  // A refused request is tried again after the period, not to spin on a full queue
+  state.attempted = true;
+  state.attempted_ms = now;
+  state.pending = queued;
+  poll_stats.requests += queued;
+}
+
+void PollScheduler::handle_response(size_t row, uint8_t offset, UdsResult result, const uint8_t* data,
+                                    size_t length) {
+  const PollItem& item = items[row].item;
+  State& state = states[items[row].first_state + offset];
+  state.pending = false;
+  if (result != UdsResult::Positive) {
+    poll_stats.failures++;
+    return;
+  }
+  poll_stats.responses++;
+  if (length < VALUE_OFFSET + item.length) {
+    poll_stats.malformed++;
+    return;
+  }
+
+  if (state.updated) {
+    const uint16_t interval = std::min<uint32_t>(now - state.updated_ms, UINT16_MAX);
+    state.interval_ms = state.interval_ms == 0 ? interval : (3 * state.interval_ms + interval) / 4;
+  }
+  state.updated = true;
+  state.updated_ms = now;
+  if (item.parse) {
+    item.parse(item.identifier + offset, data + VALUE_OFFSET, length - VALUE_OFFSET);
+  }
+}
+
+uint32_t PollScheduler::row_age_ms(size_t index, uint32_t now_ms) const {
+  const Row& row = items[index];
+  uint32_t oldest = 0;
+  for (uint8_t o = 0; o < row.active; o++) {
+    const State& state = states[row.first_state + o];
+    if (!state.updated) {
+      return POLL_NEVER;
+    }
+    oldest = std::max(oldest, now_ms - state.updated_ms);
+  }
+  return oldest;
+}
+
+uint32_t PollScheduler::row_achieved_period_ms(size_t index) const {
+  const Row& row = items[index];
+  uint32_t sum = 0;
+  for (uint8_t o = 0; o < row.active; o++) {
+    const uint16_t interval = states[row.first_state + o].interval_ms;
+    if (interval == 0) {
+      return 0;
+    }
+    sum += interval;
+  }
+  return row.active > 0 ? sum / row.active : 0;
+}
+
+uint32_t PollScheduler::age_ms(uint16_t identifier, uint32_t now_ms) const {
+  for (const Row& row : items) {
+    if (identifier >= row.item.identifier && identifier < row.item.identifier + row.item.count) {
+      const State& state = states[row.first_state + identifier - row.item.identifier];
+      return state.updated ? now_ms - state.updated_ms : POLL_NEVER;
+    }
+  }
+  return POLL_NEVER;
+}
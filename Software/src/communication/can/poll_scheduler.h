@@ -0,0 +1,97 @@
+#ifndef _POLL_SCHEDULER_H_
+#define _POLL_SCHEDULER_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <functional>
+#include <vector>
+#include "uds_client.h"
+
+/* Polls the values of a battery with UDS ReadDataByIdentifier requests, from a table the battery fills in
+ * setup().
+ *
+ * Each row of the table is a run of consecutive identifiers that share a target refresh period, a priority
+ * and a parser, such as the voltages of all cells. Whenever the UDS client has room, the scheduler asks for
+ * the identifier that is due with the highest priority, the most overdue first. The client is kept depth
+ * requests ahead, so the next request goes out as soon as the ECU has answered the previous one, and nothing
+ * is sent while every value is fresh.
+ *
+ * The time since each value was refreshed, and the period actually achieved, are kept to show staleness.
+ */
+
+#define POLL_DEPTH 2  // Requests queued in the client ahead of the ECU
+#define POLL_NEVER UINT32_MAX
+
+enum class PollPriority : uint8_t { Low, Normal, High };
+
+struct PollItem {
+  // The value after the identifier, length is the least number of bytes the parser reads
+  using ParseFunction = std::function<void(uint16_t identifier, const uint8_t* value, size_t length)>;
+
+  const char* name;
+  uint16_t identifier;  // First of the row
+  uint8_t count;        // Consecutive identifiers in the row
+  uint8_t length;
+  uint16_t period_ms;  // Target refresh period
+  PollPriority priority;
+  ParseFunction parse;
+};
+
+struct PollStats {
+  uint32_t requests = 0;
+  uint32_t responses = 0;
+  uint32_t failures = 0;   // Negative responses and timeouts, the value is asked for again after its period
+  uint32_t malformed = 0;  // Responses shorter than the row length
+};
+
+class PollScheduler {
+ public:
+  explicit PollScheduler(UdsClient& client, uint8_t depth = POLL_DEPTH) : client(client), depth(depth) {}
+
+  // Returns the index of the row
+  size_t add(const PollItem& item);
+  // Polls only the first count identifiers of a row, e.g. once the number of cells is known
+  void limit(size_t row, uint8_t count);
+
+  // Queues the requests due, call every tick
+  void service(uint32_t now_ms);
+
+  size_t rows() const { return items.size(); }
+  const PollItem& row(size_t index) const { return items[index].item; }
+  uint8_t row_count(size_t index) const { return items[index].active; }
+  // Time since the stalest value of the row was refreshed, POLL_NEVER if one never was
+  uint32_t row_age_ms(size_t index, uint32_t now_ms) const;
+  // Average time between refreshes of the values of the row, 0 until they have been refreshed twice
+  uint32_t row_achieved_period_ms(size_t index) const;
+  uint32_t age_ms(uint16_t identifier, uint32_t now_ms) const;
+  const PollStats& stats() const { return poll_stats; }
+
+ private:
+  struct Row {
+    PollItem item;
+    uint16_t first_state;  // Index of the state of the first identifier
+    uint8_t active;
+  };
+
+  struct State {
+    uint32_t attempted_ms = 0;
+    uint32_t updated_ms = 0;
+    uint16_t interval_ms = 0;  // Smoothed time between refreshes
+    bool attempted = false;
+    bool updated = false;
+    bool pending = false;
+  };
+
+  UdsClient& client;
+  uint8_t depth;
+  std::vector<Row> items;
+  std::vector<State> states;
+  uint32_t now = 0;
+  PollStats poll_stats;
+
+  bool pick(size_t& row, uint8_t& offset) const;
+  void request(size_t row, uint8_t offset);
+  void handle_response(size_t row, uint8_t offset, UdsResult result, const uint8_t* data, size_t length);
+};
+
+#endif
@@ -0,0 +1,118 @@
+#include "uds_client.h"
+#include <string.h>
+#include <algorithm>
+
+UdsClient::UdsClient(IsoTpSession& session) : session(session) {
+  session.on_receive([this](IsoTpResult result, size_t length, uint32_t now_ms) {
+    handle_response(result, length, now_ms);
+  });
+  session.on_sent([this](IsoTpResult result, uint32_t now_ms) {
+    if (result != IsoTpResult::Ok && in_flight) {
+      complete(UdsResult::TransportError, nullptr, 0, now_ms);
+    }
+  });
+}
+
+bool UdsClient::request(const uint8_t* data, size_t length, ResponseFunction on_response, uint16_t timeout_ms) {
+  if (length == 0 || length > UDS_MAX_REQUEST_LENGTH || queued == UDS_QUEUE_SIZE) {
+    client_stats.dropped++;
+    return false;
+  }
+  Request& request = queue[(queue_start + queued) % UDS_QUEUE_SIZE];
+  memcpy(request.data, data, length);
+  request.length = length;
+  request.timeout_ms = timeout_ms;
+  request.on_response = std::move(on_response);
+  queued++;
+  return true;
+}
+
+bool UdsClient::read_data_by_identifier(uint16_t identifier, ResponseFunction on_response, uint16_t timeout_ms) {
+  const uint8_t data[] = {UDS_READ_DATA_BY_IDENTIFIER, (uint8_t)(identifier >> 8), (uint8_t)(identifier & 0xFF)};
+  return request(data, sizeof(data), std::move(on_response), timeout_ms);
+}
+
+void UdsClient::service(uint32_t now_ms) {
+  if (in_flight && (int32_t)(now_ms - deadline_ms) >= 0) {
+    session.abort();
+    complete(UdsResult::Timeout, nullptr, 0, now_ms);
+  }
+
+  if (!in_flight && queued > 0) {
+    const Request& request = queue[queue_start];
+    if (session.send(request.data, request.length, now_ms)) {
+      in_flight = true;
+      sent_ms = now_ms;
+      deadline_ms = now_ms + request.timeout_ms;
+      client_stats.requests++;
+    }
+  }
+}
+
+// Responses to requests that timed out earlier may still come in
+bool UdsClient::matches(const Request& request, const uint8_t* response, size_t length) const {
+  if (response[0] == UDS_NEGATIVE_RESPONSE) {
+    return length >= 3 && response[1] == request.data[0];
+  }
+  if (response[0] != request.data[0] + UDS_POSITIVE_RESPONSE_OFFSET) {
+    return false;
+  }
+  if (request.data[0] == UDS_READ_DATA_BY_IDENTIFIER && request.length >= 3) {
+    return length >= 3 && response[1] == request.data[1] && response[2] == request.data[2];
+  }
+  return true;
+}
+
+void UdsClient::handle_response(IsoTpResult result, size_t length, uint32_t now_ms) {
+  if (!in_flight) {
+    return;
+  }
+  if (result != IsoTpResult::Ok) {
+    complete(UdsResult::TransportError, nullptr, 0, now_ms);
+    return;
+  }
+
+  const uint8_t* response = session.buffer();
+  if (length == 0 || !matches(queue[queue_start], response, length)) {
+    return;
+  }
+  if (response[0] != UDS_NEGATIVE_RESPONSE) {
+    complete(UdsResult::Positive, response, length, now_ms);
+  } else if (response[2] == UDS_NRC_RESPONSE_PENDING) {
+    deadline_ms = now_ms + UDS_PENDING_TIMEOUT_MS;
+  } else {
+    client_stats.last_negative_code = response[2];
+    complete(UdsResult::Negative, response, length, now_ms);
+  }
+}
+
+void UdsClient::complete(UdsResult result, const uint8_t* data, size_t length, uint32_t now_ms) {
+  switch (result) {
+    case UdsResult::Positive:
+      client_stats.positive++;
+      break;
+    case UdsResult::Negative:
+      client_stats.negative++;
+      break;
+    case UdsResult::Timeout:
+      client_stats.timeouts++;
+      break;
+    case UdsResult::TransportError:
+      client_stats.transport_errors++;
+      break;
+  }
+  if (result == UdsResult::Positive || result == UdsResult::Negative) {
+    client_stats.last_latency_ms = std::min<uint32_t>(now_ms - sent_ms, UINT16_MAX);
+    client_stats.max_latency_ms = std::max(client_stats.max_latency_ms, client_stats.last_latency_ms);
+  }
+
+  // Taken off the queue first, so that the callback can queue the next request
+  ResponseFunction on_response = std::move(queue[queue_start].on_response);
+  queue[queue_start].on_response = nullptr;
+  queue_start = (queue_start + 1) % UDS_QUEUE_SIZE;
+  queued--;
+  in_flight = false;
+  if (on_response) {
+    on_response(result, data, length);
+  }
+}
@@ -0,0 +1,84 @@
+#ifndef _UDS_CLIENT_H_
+#define _UDS_CLIENT_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <functional>
+#include "isotp.h"
+
+/* UDS (ISO 14229) requests over an ISO-TP session.
+ *
+ * Requests are queued and sent one at a time, the next one going out as soon as the response to the previous
+ * one has arrived or timed out. Each response is handed to the callback given with its request, so nothing
+ * waits on the ECU. An ECU answering "response pending" gets UDS_PENDING_TIMEOUT_MS more.
+ */
+
+#define UDS_QUEUE_SIZE 8
+#define UDS_MAX_REQUEST_LENGTH 16
+#define UDS_TIMEOUT_MS 1000          // From sending a request to its response
+#define UDS_PENDING_TIMEOUT_MS 5000  // P2*, after the ECU asked for more time
+
+#define UDS_READ_DATA_BY_IDENTIFIER 0x22
+#define UDS_NEGATIVE_RESPONSE 0x7F
+#define UDS_POSITIVE_RESPONSE_OFFSET 0x40
+#define UDS_NRC_RESPONSE_PENDING 0x78
+
+enum class UdsResult : uint8_t { Positive, Negative, Timeout, TransportError };
+
+struct UdsStats {
+  uint32_t requests = 0;
+  uint32_t positive = 0;
+  uint32_t negative = 0;
+  uint32_t timeouts = 0;
+  uint32_t transport_errors = 0;
+  uint32_t dropped = 0;  // Requests refused because the queue was full
+  uint8_t last_negative_code = 0;
+  // From sending a request to its response
+  uint16_t last_latency_ms = 0;
+  uint16_t max_latency_ms = 0;
+};
+
+class UdsClient {
+ public:
+  // The response as received, service ID first. For negative responses it is 0x7F, the service ID and the
+  // response code. data is only valid during the call.
+  using ResponseFunction = std::function<void(UdsResult result, const uint8_t* data, size_t length)>;
+
+  explicit UdsClient(IsoTpSession& session);
+
+  // Queues a request. Returns false if the queue is full or the request too long.
+  bool request(const uint8_t* data, size_t length, ResponseFunction on_response, uint16_t timeout_ms = UDS_TIMEOUT_MS);
+  bool read_data_by_identifier(uint16_t identifier, ResponseFunction on_response,
+                               uint16_t timeout_ms = UDS_TIMEOUT_MS);
+
+  // Sends the next request and times out the one waiting for a response
+  void service(uint32_t now_ms);
+
+  // Requests queued, including the one waiting for a response
+  size_t pending() const { return queued; }
+  bool idle() const { return queued == 0; }
+  const UdsStats& stats() const { return client_stats; }
+
+ private:
+  struct Request {
+    uint8_t data[UDS_MAX_REQUEST_LENGTH];
+    uint8_t length;
+    uint16_t timeout_ms;
+    ResponseFunction on_response;
+  };
+
+  IsoTpSession& session;
+  Request queue[UDS_QUEUE_SIZE];
+  uint8_t queue_start = 0;
+  uint8_t queued = 0;
+  bool in_flight = false;
+  uint32_t sent_ms = 0;
+  uint32_t deadline_ms = 0;
+  UdsStats client_stats;
+
+  bool matches(const Request& request, const uint8_t* response, size_t length) const;
+  void handle_response(IsoTpResult result, size_t length, uint32_t now_ms);
+  void complete(UdsResult result, const uint8_t* data, size_t length, uint32_t now_ms);
+};
+
+#endif
@@ -1,4 +1,6 @@
 #include "comm_nvm.h"
+#include <algorithm>
+#include <vector>
 #include "../../battery/BATTERIES.h"
 #include "../../battery/Battery.h"
 #include "../../battery/Shunt.h"
@@ -10,16 +12,227 @@
 #include "../contactorcontrol/comm_contactorcontrol.h"
 #include "../equipmentstopbutton/comm_equipmentstopbutton.h"
 #include "../precharge_control/precharge_control.h"
+#include "freertos/semphr.h"
+#include "settings_store.h"
+
+#define SETTINGS_NAMESPACE "batterySettings"
 
 // Parameters
-Preferences settings;  // Store user settings
+static SettingsShadow shadow;  // Copy of the user settings in NVS
+static bool shadow_loaded = false;
+
+/* The settings are read and changed by the core task, the MQTT task and the webserver. A store that changes
+ * them holds this mutex from its construction until it has written them, the reads of a read only store each
+ * take it for a moment. Recursive, for a task reading through a store while it holds another one.
+ */
+static StaticSemaphore_t settings_mutex_buffer;
+static SemaphoreHandle_t settings_mutex = xSemaphoreCreateRecursiveMutexStatic(&settings_mutex_buffer);
+
+class SettingsLock {
+ public:
+  SettingsLock() { xSemaphoreTakeRecursive(settings_mutex, portMAX_DELAY); }
+  ~SettingsLock() { xSemaphoreGiveRecursive(settings_mutex); }
+  SettingsLock(const SettingsLock&) = delete;
+  SettingsLock& operator=(const SettingsLock&) = delete;
+};
+
+static bool write_settings() {
+  std::vector<uint8_t> blob(SETTINGS_BLOB_MAX_SIZE);
+  const size_t length = shadow.encode(blob.data(), blob.size());
+  if (length == 0) {
+    return false;
+  }
+  Preferences preferences;
+  if (!preferences.begin(SETTINGS_NAMESPACE, false)) {
+    return false;
+  }
+  const bool written = preferences.putBytes(SETTINGS_BLOB_KEY, blob.data(), length) == length;
+  preferences.end();
+  return written;
+}
+
+static void load_settings() {
+  if (shadow_loaded) {
+    return;
+  }
+  shadow_loaded = true;
+
+  Preferences preferences;
+  if (!preferences.begin(SETTINGS_NAMESPACE, false)) {
+    set_event(EVENT_PERSISTENT_SAVE_INFO, 0);
+    return;
+  }
+  const size_t length = preferences.getBytesLength(SETTINGS_BLOB_KEY);
+  if (length > 0 && length <= SETTINGS_BLOB_MAX_SIZE) {
+    std::vector<uint8_t> blob(length);
+    if (preferences.getBytes(SETTINGS_BLOB_KEY, blob.data(), length) == length && shadow.decode(blob.data(), length)) {
+      preferences.end();
+      return;
+    }
+  }
+
+  // No blob yet, or a damaged one: take over the separate entries older firmware stored the settings in
+  for (size_t i = 0; i < SETTING_COUNT; i++) {
+    const SettingDefinition& definition = SETTING_DEFINITIONS[i];
+    if (!preferences.isKey(definition.name)) {
+      continue;
+    }
+    switch (definition.type) {
+      case SettingType::UInt:
+        shadow.set_number(i, preferences.getUInt(definition.name));
+        break;
+      case SettingType::Int:
+        shadow.set_number(i, preferences.getInt(definition.name));
+        break;
+      case SettingType::Bool:
+        shadow.set_number(i, preferences.getBool(definition.name));
+        break;
+      case SettingType::String:
+        shadow.set_string(i, preferences.getString(definition.name).c_str());
+        break;
+    }
+  }
+  preferences.end();
+  if (!write_settings()) {
+    set_event(EVENT_PERSISTENT_SAVE_INFO, 1);
+  }
+}
+
+// Settings missing from SETTINGS_LIST are read and written directly, logged so that they get added
+static int find_setting(const char* name) {
+  load_settings();
+  const int index = SettingsShadow::find(name);
+  if (index < 0) {
+    DEBUG_PRINTF("Setting %s is not in SETTINGS_LIST\n", name);
+  }
+  return index;
+}
+
+BatteryEmulatorSettingsStore::BatteryEmulatorSettingsStore(bool readOnly) : readOnly(readOnly) {
+  if (!readOnly) {
+    xSemaphoreTakeRecursive(settings_mutex, portMAX_DELAY);
+  }
+  SettingsLock lock;
+  load_settings();
+}
+
+BatteryEmulatorSettingsStore::~BatteryEmulatorSettingsStore() {
+  if (readOnly) {
+    return;
+  }
+  if (settingsUpdated && !write_settings()) {
+    set_event(EVENT_PERSISTENT_SAVE_INFO, 1);
+  }
+  xSemaphoreGiveRecursive(settings_mutex);
+}
+
+void BatteryEmulatorSettingsStore::clearAll() {
+  if (readOnly) {
+    return;
+  }
+  // The separate entries of older firmware go as well, so that they are not taken over again
+  Preferences preferences;
+  if (preferences.begin(SETTINGS_NAMESPACE, false)) {
+    preferences.clear();
+    preferences.end();
+  }
+  shadow.clear();
+  settingsUpdated = true;
+}
+
+uint32_t BatteryEmulatorSettingsStore::getUInt(const char* name, uint32_t defaultValue) {
+  SettingsLock lock;
+  const int index = find_setting(name);
+  if (index < 0) {
+    Preferences preferences;
+    preferences.begin(SETTINGS_NAMESPACE, true);
+    const uint32_t value = preferences.getUInt(name, defaultValue);
+    preferences.end();
+    return value;
+  }
+  return shadow.get_number(index, defaultValue);
+}
+
+void BatteryEmulatorSettingsStore::saveUInt(const char* name, uint32_t value) {
+  if (readOnly) {
+    return;
+  }
+  const int index = find_setting(name);
+  if (index < 0) {
+    Preferences preferences;
+    preferences.begin(SETTINGS_NAMESPACE, false);
+    settingsUpdated = settingsUpdated || preferences.getUInt(name, ~value) != value;
+    preferences.putUInt(name, value);
+    preferences.end();
+    return;
+  }
+  settingsUpdated = shadow.set_number(index, value) || settingsUpdated;
+}
+
+int32_t BatteryEmulatorSettingsStore::getInt(const char* name, int32_t defaultValue) {
+  return (int32_t)getUInt(name, (uint32_t)defaultValue);
+}
+
+void BatteryEmulatorSettingsStore::saveInt(const char* name, int32_t value) {
+  saveUInt(name, (uint32_t)value);
+}
+
+bool BatteryEmulatorSettingsStore::settingExists(const char* name) {
+  SettingsLock lock;
+  const int index = find_setting(name);
+  if (index < 0) {
+    Preferences preferences;
+    preferences.begin(SETTINGS_NAMESPACE, true);
+    const bool exists = preferences.isKey(name);
+    preferences.end();
+    return exists;
+  }
+  return shadow.exists(index);
+}
+
+bool BatteryEmulatorSettingsStore::getBool(const char* name, bool defaultValue) {
+  return getUInt(name, defaultValue) != 0;
+}
+
+void BatteryEmulatorSettingsStore::saveBool(const char* name, bool value) {
+  saveUInt(name, value);
+}
+
+String BatteryEmulatorSettingsStore::getString(const char* name, const char* defaultValue) {
+  SettingsLock lock;
+  const int index = find_setting(name);
+  if (index < 0) {
+    Preferences preferences;
+    preferences.begin(SETTINGS_NAMESPACE, true);
+    const String value = preferences.getString(name, String(defaultValue));
+    preferences.end();
+    return value;
+  }
+  return String(shadow.get_string(index, defaultValue));
+}
+
+void BatteryEmulatorSettingsStore::saveString(const char* name, const char* value) {
+  if (readOnly) {
+    return;
+  }
+  const int index = find_setting(name);
+  if (index < 0) {
+    Preferences preferences;
+    preferences.begin(SETTINGS_NAMESPACE, false);
+    settingsUpdated = settingsUpdated || preferences.getString(name) != String(value);
+    preferences.putString(name, value);
+    preferences.end();
+    return;
+  }
+  settingsUpdated = shadow.set_string(index, value) || settingsUpdated;
+}
 
 // Initialization functions
 
 void init_stored_settings() {
   static uint32_t temp = 0;
   //  ATTENTION ! The maximum length for settings keys is 15 characters
-  settings.begin("batterySettings", false);
+  BatteryEmulatorSettingsStore settings(true);
 
   // Always get the equipment stop status
   datalayer.system.info.equipment_stop_active = settings.getBool("EQUIPMENT_STOP", false);
@@ -97,6 +310,8 @@ void init_stored_settings() {
   user_selected_inverter_deye_workaround = settings.getBool("DEYEBYD", false);
   user_selected_can_addon_crystal_frequency_mhz = settings.getUInt("CANFREQ", 8);
   user_selected_canfd_addon_crystal_frequency_mhz = settings.getUInt("CANFDFREQ", 40);
+  user_selected_can_rx_frames_per_tick =
+      std::clamp<uint32_t>(settings.getUInt("CANRXBUDGET", CAN_RX_FRAMES_PER_TICK), 1, UINT8_MAX);
   user_selected_LEAF_interlock_mandatory = settings.getBool("INTERLOCKREQ", false);
   user_selected_use_estimated_SOC = settings.getBool("SOCESTIMATED", false);
   user_selected_tesla_digital_HVIL = settings.getBool("DIGITALHVIL", false);
@@ -106,7 +321,7 @@ void init_stored_settings() {
   user_selected_tesla_GTW_chassisType = settings.getUInt("GTWCHASSIS", 0);
   user_selected_tesla_GTW_packEnergy = settings.getUInt("GTWPACK", 0);
 
-  auto readIf = [](const char* settingName) {
+  auto readIf = [&settings](const char* settingName) {
     auto batt1If = (comm_interface)settings.getUInt(settingName, (int)comm_interface::CanNative);
     switch (batt1If) {
       case comm_interface::CanNative:
@@ -174,6 +389,11 @@ void init_stored_settings() {
   mqtt_timeout_ms = settings.getUInt("MQTTTIMEOUT", 2000);
   ha_autodiscovery_enabled = settings.getBool("HADISC", false);
   mqtt_transmit_all_cellvoltages = settings.getBool("MQTTCELLV", false);
+  mqtt_compact_cellvoltages = settings.getBool("MQTTCELLPACK", false);
+  mqtt_publish_on_change = settings.getBool("MQTTDELTA", false);
+  mqtt_cell_deadband_mV = settings.getUInt("MQTTCELLDB", 5);
+  mqtt_soc_deadband_pptt = settings.getUInt("MQTTSOCDB", 10);
+  mqtt_heartbeat_s = settings.getUInt("MQTTHEARTBEAT", 60);
   custom_hostname = settings.getString("HOSTNAME").c_str();
 
   static_IP_enabled = settings.getBool("STATICIP", false);
@@ -194,53 +414,25 @@ void init_stored_settings() {
   mqtt_port = settings.getUInt("MQTTPORT", 0);
   mqtt_user = settings.getString("MQTTUSER").c_str();
   mqtt_password = settings.getString("MQTTPASSWORD").c_str();
-
-  settings.end();
 }
 
 void store_settings_equipment_stop() {
-  settings.begin("batterySettings", false);
-  settings.putBool("EQUIPMENT_STOP", datalayer.system.info.equipment_stop_active);
-  settings.end();
+  BatteryEmulatorSettingsStore settings;
+  settings.saveBool("EQUIPMENT_STOP", datalayer.system.info.equipment_stop_active);
 }
 
 void store_settings() {
   //  ATTENTION ! The maximum length for settings keys is 15 characters
-  if (!settings.begin("batterySettings", false)) {
-    set_event(EVENT_PERSISTENT_SAVE_INFO, 0);
-    return;
-  }
-
-  if (!settings.putUInt("BATTERY_WH_MAX", datalayer.battery.info.total_capacity_Wh)) {
-    set_event(EVENT_PERSISTENT_SAVE_INFO, 3);
-  }
-  if (!settings.putBool("USE_SCALED_SOC", datalayer.battery.settings.soc_scaling_active)) {
-    set_event(EVENT_PERSISTENT_SAVE_INFO, 4);
-  }
-  if (!settings.putUInt("MAXPERCENTAGE", datalayer.battery.settings.max_percentage / 10)) {
-    set_event(EVENT_PERSISTENT_SAVE_INFO, 5);
-  }
-  if (!settings.putInt("MINPERCENTAGE", datalayer.battery.settings.min_percentage / 10)) {
-    set_event(EVENT_PERSISTENT_SAVE_INFO, 6);
-  }
-  if (!settings.putUInt("MAXCHARGEAMP", datalayer.battery.settings.max_user_set_charge_dA)) {
-    set_event(EVENT_PERSISTENT_SAVE_INFO, 7);
-  }
-  if (!settings.putUInt("MAXDISCHARGEAMP", datalayer.battery.settings.max_user_set_discharge_dA)) {
-    set_event(EVENT_PERSISTENT_SAVE_INFO, 8);
-  }
-  if (!settings.putBool("USEVOLTLIMITS", datalayer.battery.settings.user_set_voltage_limits_active)) {
-    set_event(EVENT_PERSISTENT_SAVE_INFO, 9);
-  }
-  if (!settings.putUInt("TARGETCHVOLT", datalayer.battery.settings.max_user_set_charge_voltage_dV)) {
-    set_event(EVENT_PERSISTENT_SAVE_INFO, 10);
-  }
-  if (!settings.putUInt("TARGETDISCHVOLT", datalayer.battery.settings.max_user_set_discharge_voltage_dV)) {
-    set_event(EVENT_PERSISTENT_SAVE_INFO, 11);
-  }
-  if (!settings.putUInt("BMSRESETDUR", datalayer.battery.settings.user_set_bms_reset_duration_ms)) {
-    set_event(EVENT_PERSISTENT_SAVE_INFO, 13);
-  }
+  BatteryEmulatorSettingsStore settings;
 
-  settings.end();  // Close preferences handle
+  settings.saveUInt("BATTERY_WH_MAX", datalayer.battery.info.total_capacity_Wh);
+  settings.saveBool("USE_SCALED_SOC", datalayer.battery.settings.soc_scaling_active);
+  settings.saveUInt("MAXPERCENTAGE", datalayer.battery.settings.max_percentage / 10);
+  settings.saveInt("MINPERCENTAGE", datalayer.battery.settings.min_percentage / 10);
+  settings.saveUInt("MAXCHARGEAMP", datalayer.battery.settings.max_user_set_charge_dA);
+  settings.saveUInt("MAXDISCHARGEAMP", datalayer.battery.settings.max_user_set_discharge_dA);
+  settings.saveBool("USEVOLTLIMITS", datalayer.battery.settings.user_set_voltage_limits_active);
+  settings.saveUInt("TARGETCHVOLT", datalayer.battery.settings.max_user_set_charge_voltage_dV);
+  settings.saveUInt("TARGETDISCHVOLT", datalayer.battery.settings.max_user_set_discharge_voltage_dV);
+  settings.saveUInt("BMSRESETDUR", datalayer.battery.settings.user_set_bms_reset_duration_ms);
 }
@@ -3,7 +3,6 @@
 
 #include <Preferences.h>
 #include <WString.h>
-#include <limits>
 #include "../../datalayer/datalayer.h"
 #include "../../devboard/utils/events.h"
 #include "../../devboard/utils/logging.h"
@@ -36,57 +35,35 @@ void store_settings_equipment_stop();
  */
 void store_settings();
 
-// Wraps the Preferences object begin/end calls, so that the scope of this object
-// runs them automatically (via constructor/destructor).
+// Reads and changes the settings through the in RAM copy, see settings_store.h. When this object goes out of
+// scope the settings are written to NVS in one go, if any of them changed. A store that is not read only keeps
+// the stores of other tasks waiting until then, so it is kept for a short time only.
 class BatteryEmulatorSettingsStore {
  public:
-  BatteryEmulatorSettingsStore(bool readOnly = false) {
-    if (!settings.begin("batterySettings", readOnly)) {
-      set_event(EVENT_PERSISTENT_SAVE_INFO, 0);
-    }
-  }
+  BatteryEmulatorSettingsStore(bool readOnly = false);
+  ~BatteryEmulatorSettingsStore();
 
-  ~BatteryEmulatorSettingsStore() { settings.end(); }
+  void clearAll();
 
-  void clearAll() {
-    settings.clear();
-    settingsUpdated = true;
-  }
+  uint32_t getUInt(const char* name, uint32_t defaultValue);
+  void saveUInt(const char* name, uint32_t value);
 
-  uint32_t getUInt(const char* name, uint32_t defaultValue) { return settings.getUInt(name, defaultValue); }
+  int32_t getInt(const char* name, int32_t defaultValue);
+  void saveInt(const char* name, int32_t value);
 
-  void saveUInt(const char* name, uint32_t value) {
-    auto oldValue = settings.getUInt(name, std::numeric_limits<uint32_t>::max());
-    settings.putUInt(name, value);
-    settingsUpdated = settingsUpdated || value != oldValue;
-  }
+  bool settingExists(const char* name);
 
-  bool settingExists(const char* name) { return settings.isKey(name); }
+  bool getBool(const char* name, bool defaultValue = false);
+  void saveBool(const char* name, bool value);
 
-  bool getBool(const char* name, bool defaultValue = false) { return settings.getBool(name, defaultValue); }
-
-  void saveBool(const char* name, bool value) {
-    auto oldValue = settings.getBool(name, false);
-    settings.putBool(name, value);
-    settingsUpdated = settingsUpdated || value != oldValue;
-  }
-
-  String getString(const char* name) { return settings.getString(name, String()); }
-
-  String getString(const char* name, const char* defaultValue) {
-    return settings.getString(name, String(defaultValue));
-  }
-
-  void saveString(const char* name, const char* value) {
-    auto oldValue = settings.getString(name);
-    settings.putString(name, value);
-    settingsUpdated = settingsUpdated || String(value) != oldValue;
-  }
+  String getString(const char* name) { return getString(name, ""); }
+  String getString(const char* name, const char* defaultValue);
+  void saveString(const char* name, const char* value);
 
   bool were_settings_updated() const { return settingsUpdated; }
 
  private:
-  Preferences settings;
+  bool readOnly;
 
   // To track if settings were updated
   bool settingsUpdated = false;
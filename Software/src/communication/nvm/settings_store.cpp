@@ -0,0 +1,187 @@
+#include "settings_store.h"
+#include <string.h>
+#include "../../devboard/utils/crc.h"
+
+#define SETTING_DEFINITION(name, type) {#name, SettingType::type},
+const SettingDefinition SETTING_DEFINITIONS[SETTING_COUNT] = {SETTINGS_LIST(SETTING_DEFINITION)};
+
+int SettingsShadow::find(const char* name) {
+  for (size_t i = 0; i < SETTING_COUNT; i++) {
+    if (strcmp(SETTING_DEFINITIONS[i].name, name) == 0) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+uint32_t SettingsShadow::get_number(int index, uint32_t default_value) const {
+  return values[index].present ? values[index].number : default_value;
+}
+
+const char* SettingsShadow::get_string(int index, const char* default_value) const {
+  return values[index].present ? values[index].text.c_str() : default_value;
+}
+
+bool SettingsShadow::set_number(int index, uint32_t value) {
+  Value& stored = values[index];
+  const bool changed = !stored.present || stored.number != value;
+  stored.present = true;
+  stored.number = value;
+  return changed;
+}
+
+bool SettingsShadow::set_string(int index, const char* value) {
+  Value& stored = values[index];
+  const bool changed = !stored.present || stored.text != value;
+  stored.present = true;
+  stored.text = value;
+  return changed;
+}
+
+void SettingsShadow::clear() {
+  for (auto& value : values) {
+    value = Value();
+  }
+}
+
+// Bounds checked little endian writing and reading of the blob
+class BlobWriter {
+ public:
+  BlobWriter(uint8_t* buffer, size_t size) : buffer(buffer), size(size) {}
+  void bytes(const void* data, size_t length) {
+    if (used + length > size) {
+      overflow = true;
+      return;
+    }
+    memcpy(buffer + used, data, length);
+    used += length;
+  }
+  void u8(uint8_t value) { bytes(&value, 1); }
+  void u16(uint16_t value) {
+    u8(value & 0xFF);
+    u8(value >> 8);
+  }
+  void u32(uint32_t value) {
+    u16(value & 0xFFFF);
+    u16(value >> 16);
+  }
+
+  uint8_t* buffer;
+  size_t size;
+  size_t used = 0;
+  bool overflow = false;
+};
+
+class BlobReader {
+ public:
+  BlobReader(const uint8_t* data, size_t length) : data(data), length(length) {}
+  const uint8_t* bytes(size_t count) {
+    if (position + count > length) {
+      position = length;
+      underflow = true;
+      return nullptr;
+    }
+    const uint8_t* start = data + position;
+    position += count;
+    return start;
+  }
+  uint8_t u8() {
+    const uint8_t* byte = bytes(1);
+    return byte != nullptr ? *byte : 0;
+  }
+  uint16_t u16() {
+    const uint16_t low = u8();
+    return low | (u8() << 8);
+  }
+  uint32_t u32() {
+    const uint32_t low = u16();
+    return low | ((uint32_t)u16() << 16);
+  }
+
+  const uint8_t* data;
+  size_t length;
+  size_t position = 0;
+  bool underflow = false;
+};
+
+size_t SettingsShadow::encode(uint8_t* buffer, size_t size) const {
+  uint16_t count = 0;
+  for (const auto& value : values) {
+    count += value.present;
+  }
+
+  BlobWriter blob(buffer, size);
+  blob.u32(SETTINGS_BLOB_MAGIC);
+  blob.u8(SETTINGS_BLOB_VERSION);
+  blob.u8(0);
+  blob.u16(count);
+  for (size_t i = 0; i < SETTING_COUNT; i++) {
+    if (!values[i].present) {
+      continue;
+    }
+    const SettingDefinition& definition = SETTING_DEFINITIONS[i];
+    blob.u8(strlen(definition.name));
+    blob.bytes(definition.name, strlen(definition.name));
+    blob.u8((uint8_t)definition.type);
+    if (definition.type == SettingType::String) {
+      const uint16_t length = values[i].text.size() < UINT16_MAX ? values[i].text.size() : UINT16_MAX;
+      blob.u16(length);
+      blob.bytes(values[i].text.data(), length);
+    } else {
+      blob.u32(values[i].number);
+    }
+  }
+  if (blob.overflow || blob.used + 4 > size) {
+    return 0;
+  }
+  blob.u32(Crc32::calculate(buffer, blob.used));
+  return blob.used;
+}
+
+bool SettingsShadow::decode(const uint8_t* data, size_t length) {
+  clear();
+  if (length < 12 || Crc32::calculate(data, length - 4) != BlobReader(data + length - 4, 4).u32()) {
+    return false;
+  }
+  BlobReader blob(data, length - 4);
+  if (blob.u32() != SETTINGS_BLOB_MAGIC || blob.u8() != SETTINGS_BLOB_VERSION) {
+    return false;
+  }
+  blob.u8();
+  const uint16_t count = blob.u16();
+
+  for (uint16_t i = 0; i < count; i++) {
+    const uint8_t key_length = blob.u8();
+    const uint8_t* key = blob.bytes(key_length);
+    const SettingType type = (SettingType)blob.u8();
+    uint32_t number = 0;
+    const uint8_t* text = nullptr;
+    uint16_t text_length = 0;
+    if (type == SettingType::String) {
+      text_length = blob.u16();
+      text = blob.bytes(text_length);
+    } else {
+      number = blob.u32();
+    }
+    if (blob.underflow) {
+      break;
+    }
+
+    // Settings unknown to this firmware, or that changed type, are dropped
+    const int index = find(std::string(reinterpret_cast<const char*>(key), key_length).c_str());
+    if (index < 0 || SETTING_DEFINITIONS[index].type != type) {
+      continue;
+    }
+    values[index].present = true;
+    if (type == SettingType::String) {
+      values[index].text.assign(reinterpret_cast<const char*>(text), text_length);
+    } else {
+      values[index].number = number;
+    }
+  }
+  if (blob.underflow || blob.position != blob.length) {
+    clear();
+    return false;
+  }
+  return true;
+}
@@ -0,0 +1,188 @@
+#ifndef _SETTINGS_STORE_H_
+#define _SETTINGS_STORE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+
+/* In RAM copy of the settings kept in NVS, see BatteryEmulatorSettingsStore.
+ *
+ * The settings are stored together as one blob, so that startup reads them with a single NVS read and saving
+ * the settings page is a single NVS write, made only if a setting changed. The blob has a version and a CRC-32.
+ * Each setting is stored with its key, so settings added or removed by other firmware versions do not move the
+ * others.
+ *
+ * The keys are those the settings used as separate NVS entries before, the first startup with the blob reads
+ * the separate entries once and leaves them in place.
+ *
+ * Blob layout, all numbers little endian:
+ *   magic u32, version u8, 0 u8, number of settings u16
+ *   per setting: key length u8, key, SettingType u8, then u32 for numbers or u16 length and text for strings
+ *   CRC-32 u32 of all the bytes before it
+ */
+
+#define SETTINGS_BLOB_KEY "SETTINGSBLOB"
+#define SETTINGS_BLOB_MAGIC 0x53454542  // "BEES"
+#define SETTINGS_BLOB_VERSION 1
+#define SETTINGS_BLOB_MAX_SIZE 4096
+
+enum class SettingType : uint8_t { UInt, Int, Bool, String };
+
+//  ATTENTION ! The maximum length for settings keys is 15 characters
+#define SETTINGS_LIST(XX)     \
+  XX(APNAME, String)          \
+  XX(APPASSWORD, String)      \
+  XX(BATT2COMM, UInt)         \
+  XX(BATT3COMM, UInt)         \
+  XX(BATTCHEM, UInt)          \
+  XX(BATTCOMM, UInt)          \
+  XX(BATTCVMAX, UInt)         \
+  XX(BATTCVMIN, UInt)         \
+  XX(BATTERY_WH_MAX, UInt)    \
+  XX(BATTPVMAX, UInt)         \
+  XX(BATTPVMIN, UInt)         \
+  XX(BATTTYPE, UInt)          \
+  XX(BMSRESETDUR, UInt)       \
+  XX(CANFDASCAN, Bool)        \
+  XX(CANFDFREQ, UInt)         \
+  XX(CANFREQ, UInt)           \
+  XX(CANLOGSD, Bool)          \
+  XX(CANLOGUSB, Bool)         \
+  XX(CANRXBUDGET, UInt)       \
+  XX(CHGCOMM, UInt)           \
+  XX(CHGPOWER, UInt)          \
+  XX(CHGTYPE, UInt)           \
+  XX(CNTCTRL, Bool)           \
+  XX(CNTCTRLDBL, Bool)        \
+  XX(CNTCTRLTRI, Bool)        \
+  XX(DBLBTR, Bool)            \
+  XX(DCHGPOWER, UInt)         \
+  XX(DEYEBYD, Bool)           \
+  XX(DIGITALHVIL, Bool)       \
+  XX(EQSTOP, UInt)            \
+  XX(EQUIPMENT_STOP, Bool)    \
+  XX(EXTPRECHARGE, Bool)      \
+  XX(GATEWAY1, UInt)          \
+  XX(GATEWAY2, UInt)          \
+  XX(GATEWAY3, UInt)          \
+  XX(GATEWAY4, UInt)          \
+  XX(GPIOOPT1, UInt)          \
+  XX(GTWCHASSIS, UInt)        \
+  XX(GTWCOUNTRY, UInt)        \
+  XX(GTWMAPREG, UInt)         \
+  XX(GTWPACK, UInt)           \
+  XX(GTWRHD, Bool)            \
+  XX(HADEVICEID, String)      \
+  XX(HADISC, Bool)            \
+  XX(HOSTNAME, String)        \
+  XX(INTERLOCKREQ, Bool)      \
+  XX(INVAHCAPACITY, UInt)     \
+  XX(INVBTYPE, UInt)          \
+  XX(INVCAPACITY, UInt)       \
+  XX(INVCELLS, UInt)          \
+  XX(INVCELLSPER, UInt)       \
+  XX(INVCOMM, UInt)           \
+  XX(INVICNT, Bool)           \
+  XX(INVMODULES, UInt)        \
+  XX(INVTYPE, UInt)           \
+  XX(INVVLEVEL, UInt)         \
+  XX(LEDMODE, UInt)           \
+  XX(LOCALIP1, UInt)          \
+  XX(LOCALIP2, UInt)          \
+  XX(LOCALIP3, UInt)          \
+  XX(LOCALIP4, UInt)          \
+  XX(MAXCHARGEAMP, UInt)      \
+  XX(MAXDISCHARGEAMP, UInt)   \
+  XX(MAXPERCENTAGE, UInt)     \
+  XX(MAXPRETIME, UInt)        \
+  XX(MINPERCENTAGE, Int)      \
+  XX(MQTTCELLDB, UInt)        \
+  XX(MQTTCELLPACK, Bool)      \
+  XX(MQTTCELLV, Bool)         \
+  XX(MQTTDELTA, Bool)         \
+  XX(MQTTDEVICENAME, String)  \
+  XX(MQTTENABLED, Bool)       \
+  XX(MQTTHEARTBEAT, UInt)     \
+  XX(MQTTOBJIDPREFIX, String) \
+  XX(MQTTPASSWORD, String)    \
+  XX(MQTTPORT, UInt)          \
+  XX(MQTTSERVER, String)      \
+  XX(MQTTSOCDB, UInt)         \
+  XX(MQTTTIMEOUT, UInt)       \
+  XX(MQTTTOPIC, String)       \
+  XX(MQTTTOPICS, Bool)        \
+  XX(MQTTUSER, String)        \
+  XX(NCCONTACTOR, Bool)       \
+  XX(NOINVDISC, Bool)         \
+  XX(PASSWORD, String)        \
+  XX(PERBMSRESET, Bool)       \
+  XX(PERFPROFILE, Bool)       \
+  XX(PRECHGMS, UInt)          \
+  XX(PWMCNTCTRL, Bool)        \
+  XX(PWMFREQ, UInt)           \
+  XX(PWMHOLD, UInt)           \
+  XX(PYLONOFFSET, Bool)       \
+  XX(PYLONORDER, Bool)        \
+  XX(PYLONSEND, UInt)         \
+  XX(REMBMSRESET, Bool)       \
+  XX(SDLOGENABLED, Bool)      \
+  XX(SHUNTCOMM, UInt)         \
+  XX(SHUNTTYPE, UInt)         \
+  XX(SOCESTIMATED, Bool)      \
+  XX(SOFAR_ID, UInt)          \
+  XX(SSID, String)            \
+  XX(STATICIP, Bool)          \
+  XX(SUBNET1, UInt)           \
+  XX(SUBNET2, UInt)           \
+  XX(SUBNET3, UInt)           \
+  XX(SUBNET4, UInt)           \
+  XX(TARGETCHVOLT, UInt)      \
+  XX(TARGETDISCHVOLT, UInt)   \
+  XX(TRIBTR, Bool)            \
+  XX(USBENABLED, Bool)        \
+  XX(USEVOLTLIMITS, Bool)     \
+  XX(USE_SCALED_SOC, Bool)    \
+  XX(WEBENABLED, Bool)        \
+  XX(WIFIAPENABLED, Bool)     \
+  XX(WIFICHANNEL, UInt)
+
+struct SettingDefinition {
+  const char* name;
+  SettingType type;
+};
+
+#define SETTING_COUNT_ONE(name, type) +1
+constexpr size_t SETTING_COUNT = 0 SETTINGS_LIST(SETTING_COUNT_ONE);
+
+extern const SettingDefinition SETTING_DEFINITIONS[SETTING_COUNT];
+
+class SettingsShadow {
+ public:
+  // Index of a setting in SETTING_DEFINITIONS, -1 if it is not there
+  static int find(const char* name);
+
+  bool exists(int index) const { return values[index].present; }
+  // Numbers, Int and Bool included, as stored
+  uint32_t get_number(int index, uint32_t default_value) const;
+  const char* get_string(int index, const char* default_value) const;
+
+  // Return true if the value differs from the one held before
+  bool set_number(int index, uint32_t value);
+  bool set_string(int index, const char* value);
+  void clear();
+
+  // Returns the length of the blob, 0 if it does not fit
+  size_t encode(uint8_t* buffer, size_t size) const;
+  // Returns false if the blob is damaged or of another version, the shadow is left empty then
+  bool decode(const uint8_t* data, size_t length);
+
+ private:
+  struct Value {
+    bool present = false;
+    uint32_t number = 0;
+    std::string text;
+  };
+  Value values[SETTING_COUNT];
+};
+
+#endif
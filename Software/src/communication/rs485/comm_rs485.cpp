@@ -1,9 +1,30 @@
 #include "comm_rs485.h"
 #include <Arduino.h>
+#include "../../datalayer/datalayer.h"
 #include "../../devboard/hal/hal.h"
+#include "esp_timer.h"
+#include "freertos/ringbuf.h"
 
+#include <atomic>
 #include <list>
 
+// Frames waiting for the core task, each preceded by the time it was completed
+#define RS485_FRAME_QUEUE_SIZE 2048
+
+struct Rs485QueuedFrame {
+  int64_t completed_us;
+  uint8_t data[RS485_MAX_FRAME_LENGTH];
+};
+
+static HardwareSerial* framed_serial = nullptr;
+static Rs485Framer* framer = nullptr;
+static bool idle_framing = false;
+static RingbufHandle_t frame_queue = nullptr;
+static Rs485QueuedFrame queued_frame;
+// Written by the UART event task, copied into the datalayer by the core task
+static std::atomic<uint32_t> framing_errors{0};
+static std::atomic<uint32_t> overruns{0};
+
 bool init_rs485() {
 
   auto en_pin = esp32hal->RS485_EN_PIN();
@@ -38,10 +59,82 @@ bool init_rs485() {
 
 static std::list<Rs485Receiver*> receivers;
 
+static void queue_frame() {
+  queued_frame.completed_us = esp_timer_get_time();
+  memcpy(queued_frame.data, framer->frame(), framer->frame_length());
+  const size_t size = offsetof(Rs485QueuedFrame, data) + framer->frame_length();
+  if (xRingbufferSend(frame_queue, &queued_frame, size, 0) != pdTRUE) {
+    overruns++;  // The core task is not keeping up
+  }
+}
+
+// Runs on the UART event task whenever bytes arrived, or the line went idle for Timeout framing
+static void on_rs485_data() {
+  int byte;
+  while ((byte = framed_serial->read()) >= 0) {
+    if (framer->push(byte)) {
+      queue_frame();
+    }
+  }
+  if (idle_framing && framer->idle()) {
+    queue_frame();
+  }
+  framing_errors = framer->framing_errors();
+}
+
+static void on_rs485_error(hardwareSerial_error_t error) {
+  if (error == UART_BUFFER_FULL_ERROR || error == UART_FIFO_OVF_ERROR) {
+    overruns++;
+  }
+}
+
+bool init_rs485_framing(HardwareSerial& serial, const Rs485FrameFormat& format) {
+  frame_queue = xRingbufferCreate(RS485_FRAME_QUEUE_SIZE, RINGBUF_TYPE_NOSPLIT);
+  if (frame_queue == nullptr) {
+    DEBUG_PRINTF("Failed to create RS485 frame queue\n");
+    return false;
+  }
+  framer = new Rs485Framer(format);
+  framed_serial = &serial;
+  idle_framing = format.framing == Rs485Framing::Timeout;
+  datalayer.system.status.rs485_stats.active = true;
+
+  // Idle after 4 characters of silence. Timeout framing is only called then, so the framer sees the gap.
+  serial.setRxTimeout(4);
+  serial.onReceiveError(on_rs485_error);
+  serial.onReceive(on_rs485_data, idle_framing);
+  return true;
+}
+
+static void dispatch_frames() {
+  DATALAYER_RS485_STATS_TYPE& stats = datalayer.system.status.rs485_stats;
+  size_t size;
+  Rs485QueuedFrame* frame;
+
+  while ((frame = (Rs485QueuedFrame*)xRingbufferReceive(frame_queue, &size, 0)) != nullptr) {
+    const uint32_t latency_us = esp_timer_get_time() - frame->completed_us;
+    stats.frames_received++;
+    stats.latency_last_us = latency_us;
+    if (latency_us > stats.latency_max_us) {
+      stats.latency_max_us = latency_us;
+    }
+    for (auto& receiver : receivers) {
+      receiver->receive_frame(frame->data, size - offsetof(Rs485QueuedFrame, data));
+    }
+    vRingbufferReturnItem(frame_queue, frame);
+  }
+
+  stats.framing_errors = framing_errors;
+  stats.overruns = overruns;
+}
+
 void receive_rs485() {
   for (auto& receiver : receivers) {
     receiver->receive();
   }
+  if (frame_queue) {
+    dispatch_frames();
+  }
 }
 
 void register_receiver(Rs485Receiver* receiver) {
@@ -1,6 +1,12 @@
 #ifndef _COMM_RS485_H_
 #define _COMM_RS485_H_
 
+#include <stddef.h>
+#include <stdint.h>
+#include "rs485_framer.h"
+
+class HardwareSerial;
+
 /**
  * @brief Initialization of RS485
  *
@@ -10,14 +16,29 @@
  */
 bool init_rs485();
 
+/**
+ * @brief Assemble frames from the bytes of serial as they are received, instead of polling for them
+ *
+ * The UART event task splits the received bytes into frames, which are handed to receive_frame() of the
+ * registered receivers by the next receive_rs485() call. Call after serial.begin().
+ *
+ * @param[in] serial The port the receivers talk on
+ * @param[in] format How frames are delimited
+ *
+ * @return false if the frame queue could not be allocated
+ */
+bool init_rs485_framing(HardwareSerial& serial, const Rs485FrameFormat& format);
+
 // Defines an interface for any object that needs to receive a signal to handle RS485 comm.
-// Can be extended later for more complex operation.
 class Rs485Receiver {
  public:
-  virtual void receive() = 0;
+  // Called every core loop pass, e.g. for timeouts
+  virtual void receive() {}
+  // Called for each complete frame, once init_rs485_framing has been called
+  virtual void receive_frame(const uint8_t* frame, size_t length) {}
 };
 
-// Forwards the call to all registered RS485 receivers
+// Forwards the call to all registered RS485 receivers, and hands them the frames received since the last call
 void receive_rs485();
 
 // Registers the given object as a receiver.
@@ -0,0 +1,72 @@
+#include "rs485_framer.h"
+
+size_t Rs485Framer::max_length() const {
+  return format.max_length < RS485_MAX_FRAME_LENGTH ? format.max_length : RS485_MAX_FRAME_LENGTH;
+}
+
+bool Rs485Framer::complete() {
+  length = fill;
+  fill = 0;
+  return true;
+}
+
+bool Rs485Framer::push(uint8_t byte) {
+  length = 0;
+
+  if (format.framing == Rs485Framing::Length && fill == 0) {
+    if (byte != format.sync) {
+      // Not the start of a frame, skip to the next sync byte and count the run of noise once
+      if (!skipping) {
+        errors++;
+        skipping = true;
+      }
+      return false;
+    }
+    skipping = false;
+  }
+  if (fill == max_length()) {
+    errors++;  // Frame too long, drop it and start over
+    fill = 0;
+    if (format.framing == Rs485Framing::Length && byte != format.sync) {
+      skipping = true;
+      return false;
+    }
+  }
+  buffer[fill++] = byte;
+
+  switch (format.framing) {
+    case Rs485Framing::Delimiter:
+      if (byte == format.delimiter) {
+        return complete();
+      }
+      break;
+    case Rs485Framing::Length:
+      if (fill > format.length_offset) {
+        const size_t expected = buffer[format.length_offset] + format.length_overhead;
+        if (expected > max_length()) {
+          errors++;  // Garbled length, resynchronize
+          fill = 0;
+          skipping = true;
+        } else if (fill == expected) {
+          return complete();
+        }
+      }
+      break;
+    case Rs485Framing::Timeout:
+      break;
+  }
+  return false;
+}
+
+bool Rs485Framer::idle() {
+  length = 0;
+  if (fill == 0) {
+    return false;
+  }
+  if (format.framing == Rs485Framing::Timeout) {
+    return complete();
+  }
+  errors++;  // The rest of the frame never came
+  fill = 0;
+  return false;
+}
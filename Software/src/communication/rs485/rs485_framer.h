@@ -0,0 +1,62 @@
+#ifndef _RS485_FRAMER_H_
+#define _RS485_FRAMER_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+enum class Rs485Framing {
+  Delimiter,  // A frame ends with the delimiter byte, which is part of the frame
+  Length,     // A frame starts with the sync byte and holds its payload length at a fixed offset
+  Timeout     // A frame ends when the line goes idle
+};
+
+struct Rs485FrameFormat {
+  Rs485Framing framing;
+  uint16_t max_length;
+  uint8_t delimiter;        // Delimiter only
+  uint8_t sync;             // Length only, bytes before the sync byte are dropped
+  uint8_t length_offset;    // Length only, position of the payload length byte
+  uint8_t length_overhead;  // Length only, number of bytes in a frame besides the payload
+
+  static Rs485FrameFormat delimited(uint8_t delimiter, uint16_t max_length) {
+    return {Rs485Framing::Delimiter, max_length, delimiter, 0, 0, 0};
+  }
+  static Rs485FrameFormat length_prefixed(uint8_t sync, uint8_t length_offset, uint8_t length_overhead,
+                                          uint16_t max_length) {
+    return {Rs485Framing::Length, max_length, 0, sync, length_offset, length_overhead};
+  }
+  static Rs485FrameFormat idle_terminated(uint16_t max_length) {
+    return {Rs485Framing::Timeout, max_length, 0, 0, 0, 0};
+  }
+};
+
+#define RS485_MAX_FRAME_LENGTH 300
+
+// Assembles the bytes received on the RS485 port into frames
+class Rs485Framer {
+ public:
+  explicit Rs485Framer(const Rs485FrameFormat& format) : format(format) {}
+
+  // Add a received byte. Returns true if it completed a frame, which is then available until the next call.
+  bool push(uint8_t byte);
+  // The line went idle. Completes a frame for Timeout framing, drops a partial frame otherwise.
+  bool idle();
+
+  const uint8_t* frame() const { return buffer; }
+  size_t frame_length() const { return length; }
+  // Number of partial frames dropped, and of frames that were longer than max_length
+  uint32_t framing_errors() const { return errors; }
+
+ private:
+  Rs485FrameFormat format;
+  uint8_t buffer[RS485_MAX_FRAME_LENGTH];
+  size_t fill = 0;
+  size_t length = 0;
+  uint32_t errors = 0;
+  bool skipping = false;
+
+  size_t max_length() const;
+  bool complete();
+};
+
+#endif
@@ -0,0 +1,164 @@
+#include "cell_array.h"
+#include <math.h>
+#include <algorithm>
+
+CellArray battery_cells(datalayer.battery);
+CellArray battery2_cells(datalayer.battery2);
+CellArray battery3_cells(datalayer.battery3);
+
+CellArray& cell_array(DATALAYER_BATTERY_TYPE& battery) {
+  if (&battery == &datalayer.battery2) {
+    return battery2_cells;
+  }
+  if (&battery == &datalayer.battery3) {
+    return battery3_cells;
+  }
+  return battery_cells;
+}
+
+void publish_cell_statistics(uint32_t now_ms) {
+  battery_cells.publish(now_ms);
+  battery2_cells.publish(now_ms);
+  battery3_cells.publish(now_ms);
+}
+
+void CellArray::set_voltage(uint16_t cell, uint16_t voltage_mV, uint32_t now_ms) {
+  if (cell >= MAX_AMOUNT_CELLS) {
+    return;
+  }
+  written = true;
+  updated[cell] = true;
+  updated_ms[cell] = now_ms;
+
+  uint16_t& stored = battery.status.cell_voltages_mV[cell];
+  const uint16_t old = stored;
+  stored = voltage_mV;
+  // Cells beyond number_of_cells are counted once the number changes, which rebuilds the statistics
+  if (old == voltage_mV || cell >= cells) {
+    return;
+  }
+
+  // The highest cell going down or the lowest going up may leave another cell the highest or lowest
+  if ((cell == max_index && (voltage_mV < old || voltage_mV == 0)) ||
+      (cell == min_index && (voltage_mV > old || voltage_mV == 0))) {
+    extremes_valid = false;
+  }
+  if (old != 0) {
+    remove(old);
+  }
+  if (voltage_mV != 0) {
+    add(cell, voltage_mV);
+  }
+}
+
+void CellArray::set_voltages(uint16_t first, const uint16_t* voltages_mV, uint16_t count, uint32_t now_ms) {
+  for (uint16_t i = 0; i < count; i++) {
+    set_voltage(first + i, voltages_mV[i], now_ms);
+  }
+}
+
+void CellArray::set_balancing(uint16_t cell, bool active) {
+  if (cell >= MAX_AMOUNT_CELLS || battery.status.cell_balancing_status[cell] == active) {
+    return;
+  }
+  battery.status.cell_balancing_status[cell] = active;
+  if (cell < cells) {
+    balancing = active ? balancing + 1 : balancing - 1;
+  }
+}
+
+void CellArray::publish(uint32_t now_ms) {
+  const uint16_t number = std::min<uint16_t>(battery.info.number_of_cells, MAX_AMOUNT_CELLS);
+  if (!written || number != cells) {
+    cells = number;
+    rebuild();
+  } else if (!extremes_valid) {
+    find_extremes();
+  }
+
+  DATALAYER_BATTERY_STATUS_TYPE& status = battery.status;
+  status.cells_balancing = balancing;
+  if (measured > 0) {
+    status.cell_max_voltage_index = max_index;
+    status.cell_min_voltage_index = min_index;
+    status.cell_mean_voltage_mV = (sum + measured / 2) / measured;
+    // n * sum(x^2) - sum(x)^2 is n^2 times the variance, exact in 64 bits for up to MAX_AMOUNT_CELLS cells
+    const uint64_t scaled_variance = measured * sum_of_squares - (uint64_t)sum * sum;
+    status.cell_voltage_stddev_dmV = lroundf(sqrtf((float)scaled_variance) * 10 / measured);
+    if (written && set_extremes) {
+      status.cell_max_voltage_mV = status.cell_voltages_mV[max_index];
+      status.cell_min_voltage_mV = status.cell_voltages_mV[min_index];
+    }
+  } else {
+    status.cell_max_voltage_index = 0;
+    status.cell_min_voltage_index = 0;
+    status.cell_mean_voltage_mV = 0;
+    status.cell_voltage_stddev_dmV = 0;
+  }
+
+  uint16_t stale_cells = 0;
+  if (written) {
+    for (uint16_t i = 0; i < cells; i++) {
+      stale_cells += stale(i, now_ms);
+    }
+  }
+  status.cells_stale = stale_cells;
+}
+
+bool CellArray::stale(uint16_t cell, uint32_t now_ms) const {
+  return cell >= MAX_AMOUNT_CELLS || !updated[cell] || now_ms - updated_ms[cell] >= stale_ms;
+}
+
+void CellArray::rebuild() {
+  measured = 0;
+  balancing = 0;
+  sum = 0;
+  sum_of_squares = 0;
+  for (uint16_t i = 0; i < cells; i++) {
+    if (battery.status.cell_voltages_mV[i] != 0) {
+      add(i, battery.status.cell_voltages_mV[i]);
+    }
+    balancing += battery.status.cell_balancing_status[i];
+  }
+  find_extremes();
+}
+
+void CellArray::find_extremes() {
+  const uint16_t* voltages = battery.status.cell_voltages_mV;
+  bool found = false;
+  for (uint16_t i = 0; i < cells; i++) {
+    if (voltages[i] == 0) {
+      continue;
+    }
+    if (!found || voltages[i] > voltages[max_index]) {
+      max_index = i;
+    }
+    if (!found || voltages[i] < voltages[min_index]) {
+      min_index = i;
+    }
+    found = true;
+  }
+  extremes_valid = true;
+}
+
+void CellArray::add(uint16_t cell, uint16_t voltage_mV) {
+  measured++;
+  sum += voltage_mV;
+  sum_of_squares += (uint32_t)voltage_mV * voltage_mV;
+  if (!extremes_valid) {
+    return;
+  }
+  const uint16_t* voltages = battery.status.cell_voltages_mV;
+  if (measured == 1 || voltage_mV > voltages[max_index]) {
+    max_index = cell;
+  }
+  if (measured == 1 || voltage_mV < voltages[min_index]) {
+    min_index = cell;
+  }
+}
+
+void CellArray::remove(uint16_t voltage_mV) {
+  measured--;
+  sum -= voltage_mV;
+  sum_of_squares -= (uint32_t)voltage_mV * voltage_mV;
+}
@@ -0,0 +1,81 @@
+#ifndef _CELL_ARRAY_H_
+#define _CELL_ARRAY_H_
+
+#include <stdint.h>
+#include "datalayer.h"
+
+/* The cell voltages and balancing flags of one battery, with the statistics of the pack kept up to date as they
+ * are written: the highest and lowest cell and their index, the mean and standard deviation, the number of cells
+ * balancing and the cells not updated for the stale time.
+ *
+ * Batteries write their cells with set_voltage() and set_balancing(), which store them in the datalayer as
+ * before. Each write adjusts the statistics, a full rescan is only needed when the highest or lowest cell moves
+ * towards the others, and then only once. The core task publishes the statistics into battery.status after
+ * update_values, so safety, MQTT and the webserver read them instead of looping over the cells.
+ *
+ * Batteries still writing cell_voltages_mV directly get their statistics from a rescan on each publish. Their
+ * cell_max_voltage_mV and cell_min_voltage_mV are left as the battery set them.
+ *
+ * A cell voltage of 0 means the cell has not been measured, it is left out of the statistics.
+ *
+ * A cell not updated for CELL_STALE_PERIODS times the period the battery refreshes its cells in is counted in
+ * cells_stale. Batteries set their period with set_refresh_period(), the others get CELL_STALE_DEFAULT_MS.
+ */
+
+#define CELL_STALE_PERIODS 3
+#define CELL_STALE_DEFAULT_MS 10000
+
+class CellArray {
+ public:
+  explicit CellArray(DATALAYER_BATTERY_TYPE& battery) : battery(battery) {}
+
+  void set_voltage(uint16_t cell, uint16_t voltage_mV, uint32_t now_ms);
+  void set_voltages(uint16_t first, const uint16_t* voltages_mV, uint16_t count, uint32_t now_ms);
+  void set_balancing(uint16_t cell, bool active);
+
+  // For batteries whose BMS reports the highest and lowest cell voltage, these are kept in cell_max_voltage_mV and
+  // cell_min_voltage_mV instead of the ones of the cells
+  void keep_reported_extremes() { set_extremes = false; }
+
+  // How often the battery sends or is polled for all of its cells
+  void set_refresh_period(uint32_t period_ms) { stale_ms = CELL_STALE_PERIODS * period_ms; }
+
+  // Writes the statistics into battery.status
+  void publish(uint32_t now_ms);
+
+  // Not updated for the stale time, or never
+  bool stale(uint16_t cell, uint32_t now_ms) const;
+
+ private:
+  DATALAYER_BATTERY_TYPE& battery;
+  bool written = false;  // Cells are written through set_voltage, not directly
+  bool set_extremes = true;
+  uint32_t stale_ms = CELL_STALE_DEFAULT_MS;
+  bool extremes_valid = false;  // Highest and lowest cell known without a rescan
+  uint16_t cells = 0;           // number_of_cells the statistics are for
+  uint16_t measured = 0;
+  uint16_t balancing = 0;
+  uint16_t max_index = 0;
+  uint16_t min_index = 0;
+  uint32_t sum = 0;
+  uint64_t sum_of_squares = 0;
+  uint32_t updated_ms[MAX_AMOUNT_CELLS] = {};
+  bool updated[MAX_AMOUNT_CELLS] = {};
+
+  void rebuild();
+  void find_extremes();
+  void add(uint16_t cell, uint16_t voltage_mV);
+  void remove(uint16_t voltage_mV);
+};
+
+extern CellArray battery_cells;
+extern CellArray battery2_cells;
+extern CellArray battery3_cells;
+
+// The cells of datalayer.battery, battery2 or battery3
+CellArray& cell_array(DATALAYER_BATTERY_TYPE& battery);
+
+// Publishes the statistics of all batteries, called by the core task after update_values
+void publish_cell_statistics(uint32_t now_ms);
+
+#endif
@@ -76,6 +76,17 @@ struct DATALAYER_BATTERY_STATUS_TYPE {
   uint16_t cell_max_voltage_mV = 3700;
   /** Minimum cell voltage currently measured in the pack, in mV */
   uint16_t cell_min_voltage_mV = 3700;
+  /** Cells with the highest and lowest voltage, indexes into cell_voltages_mV */
+  uint16_t cell_max_voltage_index = 0;
+  uint16_t cell_min_voltage_index = 0;
+  /** Mean of the measured cell voltages, in mV */
+  uint16_t cell_mean_voltage_mV = 0;
+  /** Standard deviation of the measured cell voltages, in 0.1 mV. 25 = 2.5 mV */
+  uint16_t cell_voltage_stddev_dmV = 0;
+  /** Number of cells balancing */
+  uint16_t cells_balancing = 0;
+  /** Number of cells not updated for the stale time of CellArray. Only known for batteries writing cells through it */
+  uint16_t cells_stale = 0;
   /** The "real" SOC reported from the battery, in integer-percent x 100. 9550 = 95.50% */
   uint16_t real_soc;
   /** The SOC reported to the inverter, in integer-percent x 100. 9550 = 95.50%.
@@ -251,17 +262,60 @@ struct DATALAYER_SHUNT_TYPE {
   bool available = false;
 };
 
+struct DATALAYER_CAN_RX_STATS_TYPE {
+  /** Number of frames received on this interface since boot */
+  uint32_t frames_received = 0;
+  /** Number of times the driver receive queue was found full or overflowed, frames were dropped */
+  uint32_t overflows = 0;
+  /** Number of core loop ticks where the RX budget ran out before the receive queue was empty */
+  uint32_t budget_exhausted = 0;
+  /** Highest number of frames seen waiting in the driver receive queue since boot */
+  uint16_t queue_high_water = 0;
+  /** Size of the driver receive queue, 0 if interface is not in use */
+  uint16_t queue_size = 0;
+};
+
+struct DATALAYER_CAN_TX_STATS_TYPE {
+  /** True if frames are sent on this interface through the TX scheduler */
+  bool active = false;
+  /** Number of frames handed to the driver since boot */
+  uint32_t frames_sent = 0;
+  /** Number of periodic frames still waiting to be sent when they were due again */
+  uint32_t deadline_misses = 0;
+  /** Number of sends refused by a full driver transmit buffer and tried again */
+  uint32_t retries = 0;
+  /** Number of queued frames dropped because the TX queue was full */
+  uint32_t dropped = 0;
+  /** Frames waiting to be sent after the last core loop tick */
+  uint16_t queue_depth = 0;
+  /** Highest number of frames waiting to be sent since boot */
+  uint16_t queue_high_water = 0;
+  /** Share of the last second the bus was busy with frames sent and received, in percent */
+  uint8_t bus_load_pct = 0;
+};
+
+struct DATALAYER_RS485_STATS_TYPE {
+  /** True if the RS485 port is read by the framing layer */
+  bool active = false;
+  /** Number of frames received since boot */
+  uint32_t frames_received = 0;
+  /** Number of partial or overlong frames dropped */
+  uint32_t framing_errors = 0;
+  /** Number of times received bytes or frames were lost because a buffer was full */
+  uint32_t overruns = 0;
+  /** Time from the end of the last frame until the core task handled it, in microseconds */
+  uint32_t latency_last_us = 0;
+  /** Longest time from the end of a frame until the core task handled it since boot, in microseconds */
+  uint32_t latency_max_us = 0;
+};
+
 struct DATALAYER_SYSTEM_INFO_TYPE {
-  /** array with incoming CAN messages, for displaying on webserver */
-  char logged_can_messages[15000] = {0};
   /** array with type of battery used, for displaying on webserver */
   char battery_protocol[64] = {0};
   /** array with type of battery used, for displaying on webserver */
   char shunt_protocol[64] = {0};
   /** array with type of inverter brand used, for displaying on webserver */
   char inverter_brand[8] = {0};
-
-  size_t logged_can_messages_offset = 0;
   /** ESP32 main CPU temperature, for displaying on webserver and for safeties */
   float CPU_temperature = 0;
 
@@ -334,6 +388,17 @@ struct DATALAYER_SYSTEM_STATUS_TYPE {
    */
   int64_t time_snap_cantx_us = 0;
 
+  /** Receive statistics per CAN interface, indexed by CAN_Interface */
+  DATALAYER_CAN_RX_STATS_TYPE can_rx_stats[NO_CAN_INTERFACE];
+  /** Transmit statistics per CAN interface, indexed by CAN_Interface */
+  DATALAYER_CAN_TX_STATS_TYPE can_tx_stats[NO_CAN_INTERFACE];
+  /** Receive statistics of the RS485 port */
+  DATALAYER_RS485_STATS_TYPE rs485_stats;
+  /** Number of CAN frames not logged to SD card because the logging task could not keep up */
+  uint32_t can_sd_frames_dropped = 0;
+  /** Number of events not recorded in the event journal, because no erased flash was left or the queue was full */
+  uint32_t journal_records_dropped = 0;
+
   /** uint8_t */
   /** A counter set each time a new message comes from inverter.
    * This value then gets decremented every second. Incase we reach 0
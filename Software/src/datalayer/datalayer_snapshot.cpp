@@ -0,0 +1,24 @@
+#include "datalayer_snapshot.h"
+#include "../devboard/utils/seqlock.h"
+
+static Seqlock<DATALAYER_SNAPSHOT_TYPE> snapshot_lock;
+// Assembled here rather than on the stack of the core task
+static DATALAYER_SNAPSHOT_TYPE staging;
+
+void publish_datalayer_snapshot() {
+  staging.battery = datalayer.battery;
+  staging.battery2 = datalayer.battery2;
+  staging.battery3 = datalayer.battery3;
+  staging.shunt = datalayer.shunt;
+  staging.charger = datalayer.charger;
+  staging.system.status = datalayer.system.status;
+  snapshot_lock.publish(staging);
+}
+
+void read_datalayer_snapshot(DATALAYER_SNAPSHOT_TYPE& snapshot) {
+  snapshot_lock.read(snapshot);
+}
+
+uint32_t datalayer_snapshot_version() {
+  return snapshot_lock.version();
+}
@@ -0,0 +1,31 @@
+#ifndef _DATALAYER_SNAPSHOT_H_
+#define _DATALAYER_SNAPSHOT_H_
+
+#include "datalayer.h"
+
+/* Copy of the measured values for the webserver, MQTT and display, which run on the other core than the core
+ * task. Reading datalayer directly from there can mix two updates, e.g. the voltage of one and the current of
+ * the next. The core task publishes the snapshot after each round of update_values, readers always get values
+ * of the same round. datalayer.system.info is not included, it holds settings and the CAN message log.
+ */
+struct DATALAYER_SNAPSHOT_TYPE {
+  DATALAYER_BATTERY_TYPE battery;
+  DATALAYER_BATTERY_TYPE battery2;
+  DATALAYER_BATTERY_TYPE battery3;
+  DATALAYER_SHUNT_TYPE shunt;
+  DATALAYER_CHARGER_TYPE charger;
+  struct {
+    DATALAYER_SYSTEM_STATUS_TYPE status;
+  } system;
+};
+
+/** Copy the current datalayer values into the snapshot. Only called by the core task. */
+void publish_datalayer_snapshot();
+
+/** Get the values last published. Does not block the core task. */
+void read_datalayer_snapshot(DATALAYER_SNAPSHOT_TYPE& snapshot);
+
+/** Number of snapshots published so far, to tell if there are new values without reading them. */
+uint32_t datalayer_snapshot_version();
+
+#endif
@@ -0,0 +1,43 @@
+#include "history.h"
+#include <algorithm>
+#include "datalayer.h"
+
+static_assert(MAX_AMOUNT_CELLS <= TIME_SERIES_MAX_CHANNELS, "A cell history sample holds all cells");
+
+static uint8_t pack_storage[HISTORY_PACK_BYTES];
+static uint8_t cell_storage[HISTORY_CELL_BYTES];
+
+TimeSeries pack_history(pack_storage, sizeof(pack_storage));
+TimeSeries cell_history(cell_storage, sizeof(cell_storage), TIME_SERIES_CORRELATED);
+
+#define PACK_CHANNEL_NAME(name) #name,
+const char* const pack_history_names[HISTORY_PACK_CHANNEL_COUNT] = {HISTORY_PACK_CHANNELS(PACK_CHANNEL_NAME)};
+
+static bool cells_recorded = false;
+static uint64_t cells_recorded_ms = 0;
+// The cell sample, kept off the stack of the core task, the only one recording
+static int32_t cell_voltages[MAX_AMOUNT_CELLS];
+
+void record_history(uint64_t now_ms) {
+  const DATALAYER_BATTERY_STATUS_TYPE& status = datalayer.battery.status;
+#define PACK_CHANNEL_VALUE(name) status.name,
+  const int32_t pack[] = {HISTORY_PACK_CHANNELS(PACK_CHANNEL_VALUE)};
+  pack_history.append(now_ms, pack, sizeof(pack) / sizeof(pack[0]));
+
+  const uint16_t cells = std::min<uint16_t>(datalayer.battery.info.number_of_cells, MAX_AMOUNT_CELLS);
+  if (cells == 0 || (cells_recorded && now_ms - cells_recorded_ms < HISTORY_CELL_INTERVAL_MS)) {
+    return;
+  }
+  for (uint16_t i = 0; i < cells; i++) {
+    cell_voltages[i] = status.cell_voltages_mV[i];
+  }
+  cell_history.append(now_ms, cell_voltages, cells);
+  cells_recorded = true;
+  cells_recorded_ms = now_ms;
+}
+
+void clear_history() {
+  pack_history.clear();
+  cell_history.clear();
+  cells_recorded = false;
+}
@@ -0,0 +1,39 @@
+#ifndef _HISTORY_H_
+#define _HISTORY_H_
+
+#include <stdint.h>
+#include "../devboard/utils/time_series.h"
+
+/* History of the main battery in RAM, see time_series.h: the pack values once per second, and the cell voltages
+ * once per minute. Served by the webserver on /api/history.
+ */
+
+#define HISTORY_PACK_BYTES (48 * 1024)
+#define HISTORY_CELL_BYTES (16 * 1024)
+#define HISTORY_CELL_INTERVAL_MS 60000
+
+// Fields of datalayer.battery.status recorded once per second
+#define HISTORY_PACK_CHANNELS(X) \
+  X(voltage_dV)                  \
+  X(current_dA)                  \
+  X(real_soc)                    \
+  X(reported_soc)                \
+  X(temperature_min_dC)          \
+  X(temperature_max_dC)          \
+  X(cell_min_voltage_mV)         \
+  X(cell_max_voltage_mV)
+#define HISTORY_COUNT_CHANNEL(name) +1
+#define HISTORY_PACK_CHANNEL_COUNT (0 HISTORY_PACK_CHANNELS(HISTORY_COUNT_CHANNEL))
+
+extern TimeSeries pack_history;
+extern TimeSeries cell_history;
+// Column names of pack_history
+extern const char* const pack_history_names[HISTORY_PACK_CHANNEL_COUNT];
+
+// Called by the core task once per second, after the values of the batteries have been updated
+void record_history(uint64_t now_ms);
+
+// Drops all samples
+void clear_history();
+
+#endif
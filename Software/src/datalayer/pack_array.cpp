@@ -0,0 +1,250 @@
+#include "pack_array.h"
+#include <stdlib.h>
+#include <algorithm>
+#include "../devboard/utils/events.h"
+#include "../devboard/utils/value_mapping.h"
+
+PackArray battery_packs;
+
+void PackArray::clear() {
+  count = 0;
+  pack_totals = PackTotals();
+}
+
+bool PackArray::add(DATALAYER_BATTERY_TYPE& battery, bool* allowed_contactor_closing,
+                    const bool* contactors_engaged) {
+  if (count == MAX_PACKS) {
+    return false;
+  }
+  packs[count++] = {&battery, allowed_contactor_closing, contactors_engaged, 0, 0};
+  return true;
+}
+
+bool PackArray::is_joined(Pack& pack) {
+  if (pack.allowed_contactor_closing == nullptr) {
+    return true;  // The main pack
+  }
+  if (!*pack.allowed_contactor_closing) {
+    pack.seconds_allowed = 0;
+    return false;
+  }
+  if (pack.contactors_engaged != nullptr) {
+    return *pack.contactors_engaged;
+  }
+  if (pack.seconds_allowed < PACK_JOIN_DELAY_S) {
+    pack.seconds_allowed++;
+  }
+  return pack.seconds_allowed >= PACK_JOIN_DELAY_S;
+}
+
+void PackArray::update() {
+  if (count == 0) {
+    return;
+  }
+  check_interconnect();
+  limit_currents();
+  scale_soc();
+}
+
+void PackArray::check_interconnect() {
+  const DATALAYER_BATTERY_TYPE& main = *packs[0].battery;
+  bool out_of_sync = false;
+  bool checked = false;
+  pack_totals.max_voltage_difference_dV = 0;
+
+  for (uint8_t i = 1; i < count; i++) {
+    Pack& pack = packs[i];
+    if (main.status.voltage_dV == 0 || pack.battery->status.voltage_dV == 0) {
+      continue;  // Both voltage values need to be available to start check
+    }
+    checked = true;
+    const uint16_t difference_dV = abs(main.status.voltage_dV - pack.battery->status.voltage_dV);
+
+    if (difference_dV <= PACK_SYNC_VOLTAGE_DV) {
+      pack.seconds_out_of_sync = 0;
+      // If main battery is in fault state, disengage the other batteries
+      *pack.allowed_contactor_closing = main.status.bms_status != FAULT;
+    } else {  //Voltage between the two packs is too large
+      out_of_sync = true;
+      pack_totals.max_voltage_difference_dV = std::max(pack_totals.max_voltage_difference_dV, difference_dV);
+      //If we start to drift out of sync between the two packs for more than 10 seconds, open contactors
+      if (pack.seconds_out_of_sync < PACK_OUT_OF_SYNC_S) {
+        pack.seconds_out_of_sync++;
+      } else {
+        *pack.allowed_contactor_closing = false;
+      }
+    }
+  }
+
+  if (out_of_sync) {
+    set_event(EVENT_VOLTAGE_DIFFERENCE, (uint8_t)std::min(pack_totals.max_voltage_difference_dV / 10, 255));
+  } else if (checked) {
+    clear_event(EVENT_VOLTAGE_DIFFERENCE);
+  }
+}
+
+void PackArray::limit_currents() {
+  uint16_t weakest_charge_dA = UINT16_MAX;
+  uint16_t weakest_discharge_dA = UINT16_MAX;
+  uint32_t weakest_charge_W = UINT32_MAX;
+  uint32_t weakest_discharge_W = UINT32_MAX;
+  pack_totals.joined = 0;
+
+  for (uint8_t i = 0; i < count; i++) {
+    DATALAYER_BATTERY_STATUS_TYPE& status = packs[i].battery->status;
+    if (status.voltage_dV > 10) {
+      // Only update value when we have voltage available to avoid div0. TODO: This should be based on nominal voltage
+      status.max_charge_current_dA = ((status.max_charge_power_W * 100) / status.voltage_dV);
+      status.max_discharge_current_dA = ((status.max_discharge_power_W * 100) / status.voltage_dV);
+    }
+    /* Calculate active power based on voltage and current*/
+    status.active_power_W = (status.current_dA * (status.voltage_dV / 100));
+
+    // Packs without a voltage are not measuring, they are left out rather than stopping all packs
+    if (is_joined(packs[i]) && (i == 0 || status.voltage_dV > 10)) {
+      pack_totals.joined++;
+      weakest_charge_dA = std::min(weakest_charge_dA, status.max_charge_current_dA);
+      weakest_discharge_dA = std::min(weakest_discharge_dA, status.max_discharge_current_dA);
+      weakest_charge_W = std::min(weakest_charge_W, status.max_charge_power_W);
+      weakest_discharge_W = std::min(weakest_discharge_W, status.max_discharge_power_W);
+    }
+  }
+  pack_totals.max_charge_power_W = std::min<uint64_t>((uint64_t)weakest_charge_W * pack_totals.joined, UINT32_MAX);
+  pack_totals.max_discharge_power_W =
+      std::min<uint64_t>((uint64_t)weakest_discharge_W * pack_totals.joined, UINT32_MAX);
+
+  DATALAYER_BATTERY_TYPE& main = *packs[0].battery;
+  if (pack_totals.joined > 1) {
+    main.status.max_charge_current_dA = std::min<uint32_t>(weakest_charge_dA * pack_totals.joined, UINT16_MAX);
+    main.status.max_discharge_current_dA =
+        std::min<uint32_t>(weakest_discharge_dA * pack_totals.joined, UINT16_MAX);
+  }
+
+  /* Apply remote restrictions if set*/
+  if (main.settings.remote_settings_limit_charge) {
+    if (main.status.max_charge_current_dA > main.settings.max_remote_set_charge_dA) {
+      main.status.max_charge_current_dA = main.settings.max_remote_set_charge_dA;
+    }
+  } else {
+    /* Restrict values from user settings if needed*/
+    if (main.status.max_charge_current_dA > main.settings.max_user_set_charge_dA) {
+      main.status.max_charge_current_dA = main.settings.max_user_set_charge_dA;
+      main.settings.user_settings_limit_charge = true;
+    } else {
+      main.settings.user_settings_limit_charge = false;
+    }
+  }
+
+  /* Apply remote restrictions if set*/
+  if (main.settings.remote_settings_limit_discharge) {
+    if (main.status.max_discharge_current_dA > main.settings.max_remote_set_discharge_dA) {
+      main.status.max_discharge_current_dA = main.settings.max_remote_set_discharge_dA;
+    }
+  } else {
+    /* Restrict values from user settings if needed*/
+    if (main.status.max_discharge_current_dA > main.settings.max_user_set_discharge_dA) {
+      main.status.max_discharge_current_dA = main.settings.max_user_set_discharge_dA;
+      main.settings.user_settings_limit_discharge = true;
+    } else {
+      main.settings.user_settings_limit_discharge = false;
+    }
+  }
+
+  /* Calculate if battery or inverter is limiting factor*/
+  if (main.status.current_dA == 0) {  //Battery idle
+    //We allow charge or discharge, but inverter does nothing. Inverter is limiting
+    main.settings.inverter_limits_discharge = main.status.max_discharge_current_dA > 0;
+    main.settings.inverter_limits_charge = main.status.max_charge_current_dA > 0;
+  } else if (main.status.current_dA < 0) {  //Battery discharging
+    main.settings.inverter_limits_discharge = -main.status.current_dA < main.status.max_discharge_current_dA;
+  } else {  // > 0 Battery charging
+    //If actual current is smaller than max we allow, inverter is limiting factor
+    main.settings.inverter_limits_charge = main.status.current_dA < main.status.max_charge_current_dA;
+  }
+}
+
+void PackArray::scale_soc() {
+  DATALAYER_BATTERY_TYPE& main = *packs[0].battery;
+  const DATALAYER_BATTERY_SETTINGS_TYPE& settings = main.settings;
+  uint32_t reported_total_Wh = 0;
+  uint32_t reported_remaining_Wh = 0;
+  uint64_t weighted_soc = 0;
+  const DATALAYER_BATTERY_TYPE* emptiest = packs[0].battery;
+  const DATALAYER_BATTERY_TYPE* fullest = packs[0].battery;
+  pack_totals.total_capacity_Wh = 0;
+  pack_totals.remaining_capacity_Wh = 0;
+  pack_totals.packs = count;
+
+  for (uint8_t i = 0; i < count; i++) {
+    DATALAYER_BATTERY_TYPE& pack = *packs[i].battery;
+    if (settings.soc_scaling_active) {
+      /** SOC Scaling
+       * A static version of a stochastic oscillator. The scaled SoC is calculated as:
+       *
+       *     10000 * (real_soc - min_percentage)
+       * ---------------------------------------
+       *     (max_percentage - min_percentage)
+       *
+       * And scaled capacity is:
+       *
+       *     reported_total_capacity_Wh = total_capacity_Wh * (max - min) / 10000
+       *     reported_remaining_capacity_Wh = reported_total_capacity_Wh * scaled_soc / 10000
+       */
+      const int32_t delta_pct = settings.max_percentage - settings.min_percentage;
+      const int32_t clamped_soc = CONSTRAIN(pack.status.real_soc, settings.min_percentage, settings.max_percentage);
+      int32_t scaled_soc = 0;
+      if (delta_pct != 0) {  //Safeguard against division by 0
+        scaled_soc = 10000 * (clamped_soc - settings.min_percentage) / delta_pct;
+      }
+      pack.status.reported_soc = scaled_soc;
+
+      // If battery info is valid
+      if (pack.info.total_capacity_Wh > 0 && pack.status.real_soc > 0) {
+        // Scale total usable capacity
+        pack.info.reported_total_capacity_Wh = (pack.info.total_capacity_Wh * delta_pct) / 10000;
+        // Scale remaining capacity based on scaled SOC
+        pack.status.reported_remaining_capacity_Wh = (pack.info.reported_total_capacity_Wh * scaled_soc) / 10000;
+      } else {
+        // Fallback if scaling cannot be performed
+        pack.info.reported_total_capacity_Wh = pack.info.total_capacity_Wh;
+        pack.status.reported_remaining_capacity_Wh = pack.status.remaining_capacity_Wh;
+      }
+    } else {  // soc_scaling_active == false. No SOC window wanted. Set scaled to same as real.
+      pack.status.reported_soc = pack.status.real_soc;
+      pack.status.reported_remaining_capacity_Wh = pack.status.remaining_capacity_Wh;
+      pack.info.reported_total_capacity_Wh = pack.info.total_capacity_Wh;
+    }
+
+    pack_totals.total_capacity_Wh += pack.info.total_capacity_Wh;
+    pack_totals.remaining_capacity_Wh += pack.status.remaining_capacity_Wh;
+    reported_total_Wh += pack.info.reported_total_capacity_Wh;
+    reported_remaining_Wh += pack.status.reported_remaining_capacity_Wh;
+    weighted_soc += (uint64_t)pack.status.reported_soc * pack.info.reported_total_capacity_Wh;
+    if (pack.status.real_soc < emptiest->status.real_soc) {
+      emptiest = &pack;
+    }
+    if (pack.status.real_soc > fullest->status.real_soc) {
+      fullest = &pack;
+    }
+  }
+
+  if (count == 1) {
+    return;
+  }
+
+  //The main battery reports the sum of all batteries, so the inverter sees them as one large battery
+  main.info.reported_total_capacity_Wh = reported_total_Wh;
+  main.status.reported_remaining_capacity_Wh = reported_remaining_Wh;
+  if (reported_total_Wh > 0) {
+    main.status.reported_soc = weighted_soc / reported_total_Wh;
+  }
+
+  // Perform extra SOC sanity checks on multi battery setups
+  if (fullest->status.real_soc > 9900) {  //If a battery is over 99.00%, use this as SOC instead of average
+    main.status.reported_soc = fullest->status.real_soc;
+    main.status.reported_remaining_capacity_Wh = fullest->status.remaining_capacity_Wh;
+  } else if (emptiest->status.real_soc < 100) {  //If a battery is under 1.00%, use this as SOC instead of average
+    main.status.reported_soc = emptiest->status.real_soc;
+    main.status.reported_remaining_capacity_Wh = emptiest->status.remaining_capacity_Wh;
+  }
+}
@@ -0,0 +1,76 @@
+#ifndef _PACK_ARRAY_H_
+#define _PACK_ARRAY_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include "datalayer.h"
+
+/* The battery packs the inverter sees as one battery. The first pack is the main pack, the others join it in
+ * parallel once their contactors are closed.
+ *
+ * update() runs once per second after update_values of all batteries, in one pass over the packs:
+ * - Interconnect: a pack within PACK_SYNC_VOLTAGE_DV of the main pack may join it, unless the main pack is in
+ *   fault. A joined pack drifting out of sync for PACK_OUT_OF_SYNC_S seconds is let go.
+ * - Current limits: each pack's power limits are turned into current limits. The main pack gets the limits of the
+ *   weakest joined pack times the number of joined packs, as parallel packs do not share current evenly, and then
+ *   the user and remote limits. A pack only counts while its contactors are closed, before that all of the
+ *   current would flow through the packs already joined.
+ * - Power limits: the same, weakest joined pack times the number of joined packs, in totals(). The power limits in
+ *   each pack's status stay its own, the safety checks compare them with the power of that pack.
+ * - SOC and capacity: each pack is scaled to the SOC window of the main pack's settings. The main pack reports the
+ *   sum of the capacities and the SOC weighted by capacity. A pack nearly empty or full is reported as it is, so
+ *   the inverter stops before any pack is over- or undercharged.
+ */
+
+#define MAX_PACKS 8
+#define PACK_SYNC_VOLTAGE_DV 15  // Packs within 1.5 V of the main pack may join it
+#define PACK_OUT_OF_SYNC_S 10    // Seconds a joined pack may be out of sync before it is let go
+#define PACK_JOIN_DELAY_S 5      // Seconds a pack closing its own contactors is allowed to before it counts as joined
+
+struct PackTotals {
+  uint32_t total_capacity_Wh = 0;  // Of all packs, before SOC scaling
+  uint32_t remaining_capacity_Wh = 0;
+  uint16_t max_voltage_difference_dV = 0;  // Of the packs not joined yet or drifting, towards the main pack
+  uint8_t packs = 0;
+  uint8_t joined = 0;  // The main pack and the packs with their contactors closed
+  // Limits of the packs together, for inverters working with power instead of current
+  uint32_t max_charge_power_W = 0;
+  uint32_t max_discharge_power_W = 0;
+};
+
+class PackArray {
+ public:
+  void clear();
+  // The first pack added is the main pack, which has no allowed_contactor_closing. contactors_engaged tells when
+  // the contactors of the pack are closed, nullptr if the pack closes them itself: it then counts as closed
+  // PACK_JOIN_DELAY_S seconds after it was allowed to. Returns false when full.
+  bool add(DATALAYER_BATTERY_TYPE& battery, bool* allowed_contactor_closing, const bool* contactors_engaged = nullptr);
+  size_t size() const { return count; }
+
+  void update();
+
+  const PackTotals& totals() const { return pack_totals; }
+
+ private:
+  struct Pack {
+    DATALAYER_BATTERY_TYPE* battery;
+    bool* allowed_contactor_closing;
+    const bool* contactors_engaged;
+    uint8_t seconds_out_of_sync;
+    uint8_t seconds_allowed;
+  };
+
+  Pack packs[MAX_PACKS];
+  uint8_t count = 0;
+  PackTotals pack_totals;
+
+  // Counts the seconds a pack closing its own contactors has been allowed to, call once per update
+  bool is_joined(Pack& pack);
+  void check_interconnect();
+  void limit_currents();
+  void scale_soc();
+};
+
+extern PackArray battery_packs;
+
+#endif
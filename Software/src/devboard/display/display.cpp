@@ -12,6 +12,7 @@ void update_display() {}
 
 #include "../../battery/BATTERIES.h"
 #include "../../datalayer/datalayer.h"
+#include "../../datalayer/datalayer_snapshot.h"
 #include "../utils/events.h"
 #include "../utils/logging.h"
 #include "fonts.h"
@@ -30,7 +31,6 @@ i2c_master_bus_handle_t bus_handle;
 i2c_master_dev_handle_t dev_handle;
 bool display_initialized = false;
 unsigned long lastUpdateMillis = 0;
-static std::vector<EventData> order_events;
 
 static esp_err_t i2c_write(const uint8_t* data, size_t len) {
   return i2c_master_transmit(dev_handle, data, len, 1000 / portTICK_PERIOD_MS);
@@ -339,28 +339,22 @@ int scroll_x = 0;
 static void print_events(int row, int count) {
   char buf[22];
 
-  // Collect all events
-  order_events.clear();
-  for (int i = 0; i < EVENT_NOF_EVENTS; i++) {
-    auto event_pointer = get_event_pointer((EVENTS_ENUM_TYPE)i);
-    if (event_pointer->occurences > 0) {
-      order_events.push_back({static_cast<EVENTS_ENUM_TYPE>(i), event_pointer});
-    }
-  }
-  // Sort events by timestamp
-  std::sort(order_events.begin(), order_events.end(), compareEventsByTimestampDesc);
   uint64_t current_timestamp = millis64();
   int longest_event_str = 0;
 
+  // Newest first
+  EVENTS_ENUM_TYPE order[EVENT_NOF_EVENTS];
+  const int listed = get_events_newest_first(order, MAX(count, 0));
   int i;
-  for (i = 0; i < order_events.size() && i < count; i++) {
+  for (i = 0; i < listed; i++) {
+    const EVENTS_ENUM_TYPE event_handle = order[i];
     memset(buf, ' ', sizeof(buf));
 
-    auto ev = order_events[i];
-    uint64_t elapsed = MAX((int64_t)(current_timestamp - ev.event_pointer->timestamp), 0);
+    const EVENTS_STRUCT_TYPE* event_pointer = get_event_pointer(event_handle);
+    uint64_t elapsed = MAX((int64_t)(current_timestamp - event_pointer->timestamp), 0);
     print_interval(buf, elapsed);
 
-    const char* event_str = get_event_enum_string(ev.event_handle);
+    const char* event_str = get_event_enum_string(event_handle);
     int event_str_len = strlen(event_str);
     longest_event_str = MAX(longest_event_str, event_str_len);
 
@@ -368,7 +362,7 @@ static void print_events(int row, int count) {
     cpy(buf + 4, event_str + MIN(MAX(scroll_x - PRE_SCROLL, 0), MAX(event_str_len - 17, 0)));
 
     // Error-level events are highlighted
-    write_text(0, i + row, buf, get_event_level() == EVENT_LEVEL_ERROR && ev.event_pointer->level == EVENT_LEVEL_ERROR);
+    write_text(0, i + row, buf, get_event_level() == EVENT_LEVEL_ERROR && event_pointer->level == EVENT_LEVEL_ERROR);
   }
 
   // Clear remaining lines
@@ -421,12 +415,16 @@ void update_display() {
   const int PAGE_TIME = 3;
   static int phase = 0;
 
+  // Values of one update round, see datalayer_snapshot.h
+  static DATALAYER_SNAPSHOT_TYPE snapshot;
+  read_datalayer_snapshot(snapshot);
+
   // Print the battery status(es) first
   int y = 0;
-  print_battery_status(y, datalayer.battery.status, 1, phase >> PAGE_TIME);
+  print_battery_status(y, snapshot.battery.status, 1, phase >> PAGE_TIME);
   y += 2;
   if (battery2) {
-    print_battery_status(y, datalayer.battery2.status, 2, phase >> PAGE_TIME);
+    print_battery_status(y, snapshot.battery2.status, 2, phase >> PAGE_TIME);
     y++;
   }
   y++;
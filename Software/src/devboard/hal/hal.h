@@ -4,6 +4,7 @@
 #include <soc/gpio_num.h>
 #include <chrono>
 #include <unordered_map>
+#include <vector>
 #include "../../../src/communication/nvm/comm_nvm.h"
 #include "../../../src/devboard/utils/events.h"
 #include "../../../src/devboard/utils/logging.h"
@@ -2,13 +2,18 @@
 #include <Arduino.h>
 #include <WiFi.h>
 #include <freertos/FreeRTOS.h>
+#include <cmath>
 #include <src/communication/nvm/comm_nvm.h>
 #include <list>
 #include "../../battery/BATTERIES.h"
 #include "../../communication/contactorcontrol/comm_contactorcontrol.h"
 #include "../../datalayer/datalayer.h"
+#include "../../datalayer/datalayer_snapshot.h"
 #include "../../lib/bblanchon-ArduinoJson/ArduinoJson.h"
+#include "../utils/deadband_tracker.h"
 #include "../utils/events.h"
+#include "../utils/json_writer.h"
+#include "../utils/perf_stats.h"
 #include "../utils/timer.h"
 #include "mqtt.h"
 #include "mqtt_client.h"
@@ -16,6 +21,11 @@
 bool mqtt_enabled = false;
 bool ha_autodiscovery_enabled = false;
 bool mqtt_transmit_all_cellvoltages = false;
+bool mqtt_compact_cellvoltages = false;
+bool mqtt_publish_on_change = false;
+uint16_t mqtt_cell_deadband_mV = 5;
+uint16_t mqtt_soc_deadband_pptt = 10;
+uint16_t mqtt_heartbeat_s = 60;
 uint16_t mqtt_timeout_ms = 2000;
 
 const int mqtt_port_default = 0;
@@ -42,9 +52,22 @@ const char* ha_device_id =
 
 esp_mqtt_client_config_t mqtt_cfg;
 esp_mqtt_client_handle_t client;
-char mqtt_msg[MQTT_MSG_BUFFER_SIZE];
+// Payload of the message being published, written in place by the JSON writer
+static char mqtt_msg[MQTT_MSG_BUFFER_SIZE];
+static JsonWriter json(mqtt_msg, sizeof(mqtt_msg));
 MyTimer publish_global_timer(5000);  //publish timer
 MyTimer check_global_timer(800);     // check timmer - low-priority MQTT checks, where responsiveness is not critical.
+MyTimer publish_heartbeat_timer(60000);  // full refresh when publishing on change, set from mqtt_heartbeat_s
+static bool full_refresh_due = true;     // after (re)connecting
+
+// Enough for the values of two batteries and the emulator, further ones are published every round
+#define MQTT_INFO_FIELDS 64
+
+// What was last published on change: the info values by (key, suffix), and the cells of each battery
+static std::vector<std::pair<const char*, const char*>> info_fields;
+static DeadbandTracker info_published;
+static DeadbandTracker cell_voltages_published[2];
+static DeadbandTracker cell_balancing_published[2];
 bool client_started = false;
 static String lwt_topic = "";
 
@@ -53,15 +76,30 @@ static String object_id_prefix = "";
 static String device_name = "";
 static String device_id = "";
 
+// Topics of the published values and the commands, built once by init_mqtt
+static String info_topic = "";
+static String spec_data_topic[2];
+static String balancing_data_topic[2];
+static String events_topic = "";
+static String perf_topic = "";
+static String command_topic_prefix = "";
+
+// Longest Home Assistant discovery topic
+#define MQTT_TOPIC_BUFFER_SIZE 128
+
 static bool publish_common_info(void);
 static bool publish_cell_voltages(void);
 static bool publish_cell_balancing(void);
 static bool publish_events(void);
+static bool publish_performance(void);
+
+static bool publish_common_info_changes(void);
+static bool publish_cell_changes(void);
 
 /** Publish global values and call callbacks for specific modules */
 static void publish_values(void) {
 
-  if (mqtt_publish((topic_name + "/status").c_str(), "online", false) == false) {
+  if (mqtt_publish(lwt_topic.c_str(), "online", false) == false) {
     return;
   }
 
@@ -73,6 +111,12 @@ static void publish_values(void) {
     return;
   }
 
+  if (datalayer.system.info.performance_measurement_active) {
+    if (publish_performance() == false) {
+      return;
+    }
+  }
+
   if (mqtt_transmit_all_cellvoltages) {
     if (publish_cell_voltages() == false) {
       return;
@@ -86,6 +130,30 @@ static void publish_values(void) {
   }
 }
 
+/** Publish only what changed, see mqtt_publish_on_change. Events are always sent once, when they occur. */
+static void publish_changed_values(void) {
+  if (publish_events() == false) {
+    return;
+  }
+
+  if (publish_common_info_changes() == false) {
+    return;
+  }
+
+  if (mqtt_transmit_all_cellvoltages) {
+    publish_cell_changes();
+  }
+}
+
+// The next round of changes publishes every value
+static void forget_published_values(void) {
+  info_published.forget_all();
+  for (int i = 0; i < 2; i++) {
+    cell_voltages_published[i].forget_all();
+    cell_balancing_published[i].forget_all();
+  }
+}
+
 static bool ha_common_info_published = false;
 static bool ha_cell_voltages_published = false;
 static bool ha_events_published = false;
@@ -120,6 +188,7 @@ SensorConfig batterySensorConfigTemplate[] = {
     {"cell_max_voltage", "Cell Max Voltage", "", "V", "voltage", always},
     {"cell_min_voltage", "Cell Min Voltage", "", "V", "voltage", always},
     {"cell_voltage_delta", "Cell Voltage Delta", "", "mV", "voltage", always},
+    {"cell_voltage_stddev", "Cell Voltage Std Dev", "", "mV", "voltage", always},
     {"battery_voltage", "Battery Voltage", "", "V", "voltage", always},
     {"total_capacity", "Battery Total Capacity", "", "Wh", "energy", always},
     {"remaining_capacity", "Battery Remaining Capacity (scaled)", "", "Wh", "energy", always},
@@ -129,6 +198,7 @@ SensorConfig batterySensorConfigTemplate[] = {
     {"charged_energy", "Battery Charged Energy", "", "Wh", "energy", supports_charged},
     {"discharged_energy", "Battery Discharged Energy", "", "Wh", "energy", supports_charged},
     {"balancing_active_cells", "Balancing Active Cells", "", "", "", always},
+    {"stale_cells", "Stale Cells", "", "", "", always},
     {"balancing_status", "Balancing Status", "", "", "", always}};
 
 SensorConfig globalSensorConfigTemplate[] = {{"bms_status", "BMS Status", "", "", "", always},
@@ -167,47 +237,53 @@ SensorConfig buttonConfigs[] = {{"BMSRESET", "Reset BMS", nullptr, nullptr, null
                                 {"RESTART", "Restart Battery Emulator", nullptr, nullptr, nullptr, nullptr},
                                 {"STOP", "Open Contactors", nullptr, nullptr, nullptr, nullptr}};
 
-static String generateCommonInfoAutoConfigTopic(const char* object_id) {
-  return "homeassistant/sensor/" + topic_name + "/" + String(object_id) + "/config";
-}
-
-static String generateCellVoltageAutoConfigTopic(int cell_number, String battery_suffix) {
-  return "homeassistant/sensor/" + topic_name + "/cell_voltage" + battery_suffix + String(cell_number) + "/config";
-}
-
-static String generateEventsAutoConfigTopic(const char* object_id) {
-  return "homeassistant/sensor/" + topic_name + "/" + String(object_id) + "/config";
-}
-
-static String generateButtonAutoConfigTopic(const char* subtype) {
-  return "homeassistant/button/" + topic_name + "/" + String(subtype) + "/config";
+static void build_topics() {
+  lwt_topic = topic_name + "/status";
+  info_topic = topic_name + "/info";
+  spec_data_topic[0] = topic_name + "/spec_data";
+  spec_data_topic[1] = topic_name + "/spec_data_2";
+  balancing_data_topic[0] = topic_name + "/balancing_data";
+  balancing_data_topic[1] = topic_name + "/balancing_data_2";
+  events_topic = topic_name + "/events";
+  perf_topic = topic_name + "/perf";
+  command_topic_prefix = topic_name + "/command/";
 }
 
-void set_common_discovery_attributes(JsonDocument& doc) {
-  doc["device"]["identifiers"][0] = device_id;
-  doc["device"]["manufacturer"] = "DalaTech";
-  doc["device"]["model"] = "BatteryEmulator";
-  doc["device"]["name"] = device_name;
-  doc["availability"][0]["topic"] = lwt_topic;
-  doc["payload_available"] = "online";
-  doc["payload_not_available"] = "offline";
-  doc["enabled_by_default"] = true;
+// Home Assistant discovery topic of a sensor or button, written to buffer
+static const char* discovery_topic(char* buffer, const char* component, const char* object_id) {
+  snprintf(buffer, MQTT_TOPIC_BUFFER_SIZE, "homeassistant/%s/%s/%s/config", component, topic_name.c_str(),
+           object_id);
+  return buffer;
 }
 
-void set_battery_voltage_attributes(JsonDocument& doc, int i, int cellNumber, const String& state_topic,
-                                    const String& object_id_prefix, const String& battery_name_suffix) {
-  doc["name"] = "Battery" + battery_name_suffix + " Cell Voltage " + String(cellNumber);
-  doc["object_id"] = object_id_prefix + "battery_voltage_cell" + String(cellNumber);
-  doc["unique_id"] = topic_name + object_id_prefix + "_battery_voltage_cell" + String(cellNumber);
-  doc["device_class"] = "voltage";
-  doc["state_class"] = "measurement";
-  doc["state_topic"] = state_topic;
-  doc["unit_of_measurement"] = "V";
-  doc["value_template"] = "{{ value_json.cell_voltages[" + String(i) + "] }}";
+static void add_common_discovery_attributes(JsonWriter& json) {
+  json.begin_object("device");
+  json.begin_array("identifiers");
+  json.element_string(device_id.c_str());
+  json.end_array();
+  json.add_string("manufacturer", "DalaTech");
+  json.add_string("model", "BatteryEmulator");
+  json.add_string("name", device_name.c_str());
+  json.end_object();
+  json.begin_array("availability");
+  json.begin_object();
+  json.add_string("topic", lwt_topic.c_str());
+  json.end_object();
+  json.end_array();
+  json.add_string("payload_available", "online");
+  json.add_string("payload_not_available", "offline");
+  json.add_bool("enabled_by_default", true);
 }
 
-static String generateButtonTopic(const char* subtype) {
-  return topic_name + "/command/" + String(subtype);
+// Sends the JSON written since the last json.reset()
+static bool publish_json(const char* topic, bool retain) {
+  if (json.overflowed()) {
+    // Never send a cut off message, sending the next ones still makes sense
+    logging.printf("MQTT msg for %s does not fit in %d bytes, not sent\n", topic, MQTT_MSG_BUFFER_SIZE);
+    return true;
+  }
+  int msg_id = esp_mqtt_client_publish(client, topic, json.c_str(), json.length(), MQTT_QOS, retain);
+  return msg_id > -1;
 }
 
 static const char* get_balancing_status_text(balancing_status_enum status) {
@@ -225,333 +301,508 @@ static const char* get_balancing_status_text(balancing_status_enum status) {
   }
 }
 
-void set_battery_attributes(JsonDocument& doc, const DATALAYER_BATTERY_TYPE& battery, const String& suffix,
-                            bool supports_charged) {
-  doc["SOC" + suffix] = ((float)battery.status.reported_soc) / 100.0f;
-  doc["SOC_real" + suffix] = ((float)battery.status.real_soc) / 100.0f;
-  doc["state_of_health" + suffix] = ((float)battery.status.soh_pptt) / 100.0f;
-  doc["temperature_min" + suffix] = ((float)((int16_t)battery.status.temperature_min_dC)) / 10.0f;
-  doc["temperature_max" + suffix] = ((float)((int16_t)battery.status.temperature_max_dC)) / 10.0f;
-  doc["cpu_temp" + suffix] = datalayer.system.info.CPU_temperature;
-  doc["stat_batt_power" + suffix] = ((float)((int32_t)battery.status.active_power_W));
-  doc["battery_current" + suffix] = ((float)((int16_t)battery.status.current_dA)) / 10.0f;
-  doc["battery_voltage" + suffix] = ((float)battery.status.voltage_dV) / 10.0f;
+// Values published on the info topic, in their datalayer units, e.g. the SOC of 5123 pptt with 2 decimals is 51.23
+class InfoValues {
+ public:
+  // band is how far the value may move unpublished when publishing on change
+  virtual void fixed(const char* key, const char* suffix, int32_t value, uint8_t decimals, Deadband band) = 0;
+  virtual void text(const char* key, const char* suffix, const char* value) = 0;
+};
+
+static const Deadband EXACT = {0, 0};
+
+static void battery_values(InfoValues& values, const DATALAYER_BATTERY_TYPE& battery, const char* suffix,
+                           bool supports_charged) {
+  const Deadband soc = {mqtt_soc_deadband_pptt, 0};
+  const Deadband cell = {mqtt_cell_deadband_mV, 0};
+  values.fixed("SOC", suffix, battery.status.reported_soc, 2, soc);
+  values.fixed("SOC_real", suffix, battery.status.real_soc, 2, soc);
+  values.fixed("state_of_health", suffix, battery.status.soh_pptt, 2, {10, 0});
+  values.fixed("temperature_min", suffix, battery.status.temperature_min_dC, 1, {5, 0});
+  values.fixed("temperature_max", suffix, battery.status.temperature_max_dC, 1, {5, 0});
+  if (!std::isnan(datalayer.system.info.CPU_temperature)) {
+    values.fixed("cpu_temp", suffix, std::lround(datalayer.system.info.CPU_temperature * 10), 1, {10, 0});
+  }
+  values.fixed("stat_batt_power", suffix, battery.status.active_power_W, 0, {50, 20});
+  values.fixed("battery_current", suffix, battery.status.current_dA, 1, {5, 20});
+  values.fixed("battery_voltage", suffix, battery.status.voltage_dV, 1, {5, 0});
   if (battery.info.number_of_cells != 0u && battery.status.cell_voltages_mV[battery.info.number_of_cells - 1] != 0u) {
-    doc["cell_max_voltage" + suffix] = ((float)battery.status.cell_max_voltage_mV) / 1000.0f;
-    doc["cell_min_voltage" + suffix] = ((float)battery.status.cell_min_voltage_mV) / 1000.0f;
-    doc["cell_voltage_delta" + suffix] =
-        ((float)battery.status.cell_max_voltage_mV) - ((float)battery.status.cell_min_voltage_mV);
+    values.fixed("cell_max_voltage", suffix, battery.status.cell_max_voltage_mV, 3, cell);
+    values.fixed("cell_min_voltage", suffix, battery.status.cell_min_voltage_mV, 3, cell);
+    values.fixed("cell_voltage_delta", suffix,
+                 (int32_t)battery.status.cell_max_voltage_mV - (int32_t)battery.status.cell_min_voltage_mV, 0, cell);
+    values.fixed("cell_voltage_stddev", suffix, battery.status.cell_voltage_stddev_dmV, 1, {10, 0});
   }
-  doc["total_capacity" + suffix] = ((float)battery.info.total_capacity_Wh);
-  doc["remaining_capacity_real" + suffix] = ((float)battery.status.remaining_capacity_Wh);
-  doc["remaining_capacity" + suffix] = ((float)battery.status.reported_remaining_capacity_Wh);
-  doc["max_discharge_power" + suffix] = ((float)battery.status.max_discharge_power_W);
-  doc["max_charge_power" + suffix] = ((float)battery.status.max_charge_power_W);
+  values.fixed("total_capacity", suffix, battery.info.total_capacity_Wh, 0, EXACT);
+  values.fixed("remaining_capacity_real", suffix, battery.status.remaining_capacity_Wh, 0, {50, 5});
+  values.fixed("remaining_capacity", suffix, battery.status.reported_remaining_capacity_Wh, 0, {50, 5});
+  values.fixed("max_discharge_power", suffix, battery.status.max_discharge_power_W, 0, {100, 20});
+  values.fixed("max_charge_power", suffix, battery.status.max_charge_power_W, 0, {100, 20});
 
   if (supports_charged) {
-    if (datalayer.battery.status.total_charged_battery_Wh != 0 &&
-        datalayer.battery.status.total_discharged_battery_Wh != 0) {
-      doc["charged_energy" + suffix] = ((float)datalayer.battery.status.total_charged_battery_Wh);
-      doc["discharged_energy" + suffix] = ((float)datalayer.battery.status.total_discharged_battery_Wh);
+    if (battery.status.total_charged_battery_Wh != 0 && battery.status.total_discharged_battery_Wh != 0) {
+      values.fixed("charged_energy", suffix, battery.status.total_charged_battery_Wh, 0, {100, 0});
+      values.fixed("discharged_energy", suffix, battery.status.total_discharged_battery_Wh, 0, {100, 0});
     }
   }
 
   // Add balancing data
-  uint16_t active_cells = 0;
-  if (battery.info.number_of_cells != 0u) {
-    for (size_t i = 0; i < battery.info.number_of_cells; ++i) {
-      if (battery.status.cell_balancing_status[i]) {
-        active_cells++;
-      }
+  values.fixed("balancing_active_cells", suffix, battery.status.cells_balancing, 0, EXACT);
+  values.fixed("stale_cells", suffix, battery.status.cells_stale, 0, EXACT);
+  values.text("balancing_status", suffix, get_balancing_status_text(battery.status.balancing_status));
+}
+
+static void info_values(InfoValues& values, const DATALAYER_SNAPSHOT_TYPE& snapshot) {
+  values.text("bms_status", nullptr, getBMSStatus(snapshot.battery.status.bms_status).c_str());
+  values.text("pause_status", nullptr, get_emulator_pause_status().c_str());
+
+  //only publish these values if BMS is active and we are comunication  with the battery (can send CAN messages to the battery)
+  if (snapshot.battery.status.CAN_battery_still_alive && allowed_to_send_CAN && esp32hal->system_booted_up()) {
+    battery_values(values, snapshot.battery, nullptr, battery->supports_charged_energy());
+  }
+
+  if (battery2) {
+    //only publish these values if BMS is active and we are comunication  with the battery (can send CAN messages to the battery)
+    if (snapshot.battery2.status.CAN_battery_still_alive && allowed_to_send_CAN && esp32hal->system_booted_up()) {
+      battery_values(values, snapshot.battery2, "_2", battery2->supports_charged_energy());
     }
   }
-  doc["balancing_active_cells" + suffix] = active_cells;
-  doc["balancing_status" + suffix] = get_balancing_status_text(battery.status.balancing_status);
+
+  values.text("event_level", nullptr, get_event_level_string(get_event_level()));
+  values.text("emulator_status", nullptr, get_emulator_status_string(get_emulator_status()));
 }
 
-static std::vector<EventData> order_events;
+// All values as one object on the info topic
+class InfoJson : public InfoValues {
+ public:
+  void fixed(const char* key, const char* suffix, int32_t value, uint8_t decimals, Deadband band) override {
+    json.add_fixed(key, suffix, value, decimals);
+  }
+  void text(const char* key, const char* suffix, const char* value) override { json.add_string(key, suffix, value); }
+};
 
-static bool publish_common_info(void) {
-  static JsonDocument doc;
-  static String state_topic = topic_name + "/info";
+/* Values that moved beyond their deadband, each on a sub-topic of the info topic named like its key, e.g.
+ * BE/info/SOC_2, as plain text and retained.
+ */
+class InfoChanges : public InfoValues {
+ public:
+  bool sent_all = true;
 
-  //  if(ha_autodiscovery_enabled) {
+  void fixed(const char* key, const char* suffix, int32_t value, uint8_t decimals, Deadband band) override {
+    const size_t slot = field_slot(key, suffix);
+    if (!info_published.changed(slot, value, band)) {
+      return;
+    }
+    char text[16];
+    JsonWriter number(text, sizeof(text));
+    number.element_fixed(value, decimals);
+    send(slot, key, suffix, text);
+  }
 
-  if (ha_autodiscovery_enabled && !ha_common_info_published) {
-    for (auto& config : sensorConfigs) {
-      if (!config.condition(battery)) {
-        continue;
-      }
+  void text(const char* key, const char* suffix, const char* value) override {
+    // Compared by hash, a change of text is always published
+    uint32_t hash = 2166136261u;
+    for (const char* c = value; *c; c++) {
+      hash = (hash ^ (uint8_t)*c) * 16777619u;
+    }
+    const size_t slot = field_slot(key, suffix);
+    if (info_published.changed(slot, (int32_t)hash, EXACT)) {
+      send(slot, key, suffix, value);
+    }
+  }
 
-      doc["name"] = config.name;
-      doc["state_topic"] = state_topic;
-      doc["unique_id"] = topic_name + "_" + String(config.object_id);
-      doc["object_id"] = object_id_prefix + String(config.object_id);
-      doc["value_template"] = config.value_template;
-      if (config.unit != nullptr && strlen(config.unit) > 0) {
-        doc["unit_of_measurement"] = config.unit;
-      }
-      if (config.device_class != nullptr && strlen(config.device_class) > 0) {
-        doc["device_class"] = config.device_class;
-        doc["state_class"] = "measurement";
+ private:
+  // The keys are string literals, so a field is found by its pointers
+  static size_t field_slot(const char* key, const char* suffix) {
+    for (size_t i = 0; i < info_fields.size(); i++) {
+      if (info_fields[i].first == key && info_fields[i].second == suffix) {
+        return i;
       }
-      set_common_discovery_attributes(doc);
-      serializeJson(doc, mqtt_msg);
-      if (mqtt_publish(generateCommonInfoAutoConfigTopic(config.object_id).c_str(), mqtt_msg, true)) {
-        ha_common_info_published = true;
-      } else {
-        return false;
-      }
-      doc.clear();
     }
+    info_fields.emplace_back(key, suffix);
+    return info_fields.size() - 1;
+  }
 
-  } else {
-    doc["bms_status"] = getBMSStatus(datalayer.battery.status.bms_status);
-    doc["pause_status"] = get_emulator_pause_status();
-
-    //only publish these values if BMS is active and we are comunication  with the battery (can send CAN messages to the battery)
-    if (datalayer.battery.status.CAN_battery_still_alive && allowed_to_send_CAN && esp32hal->system_booted_up()) {
-      set_battery_attributes(doc, datalayer.battery, "", battery->supports_charged_energy());
+  void send(size_t slot, const char* key, const char* suffix, const char* value) {
+    char topic[MQTT_TOPIC_BUFFER_SIZE];
+    snprintf(topic, sizeof(topic), "%s/%s%s", info_topic.c_str(), key, suffix != nullptr ? suffix : "");
+    if (!sent_all || !mqtt_publish(topic, value, true)) {
+      info_published.forget(slot);  // Sent with the next round
+      sent_all = false;
     }
+  }
+};
 
-    if (battery2) {
-      //only publish these values if BMS is active and we are comunication  with the battery (can send CAN messages to the battery)
-      if (datalayer.battery2.status.CAN_battery_still_alive && allowed_to_send_CAN && esp32hal->system_booted_up()) {
-        set_battery_attributes(doc, datalayer.battery2, "_2", battery2->supports_charged_energy());
-      }
-    }
+// Values of one update round, see datalayer_snapshot.h
+static DATALAYER_SNAPSHOT_TYPE snapshot;
 
-    doc["event_level"] = get_event_level_string(get_event_level());
-    doc["emulator_status"] = get_emulator_status_string(get_emulator_status());
+static bool publish_common_info_discovery(void) {
+  char topic[MQTT_TOPIC_BUFFER_SIZE];
+  char id[MQTT_TOPIC_BUFFER_SIZE];
+  for (auto& config : sensorConfigs) {
+    if (!config.condition(battery)) {
+      continue;
+    }
 
-    serializeJson(doc, mqtt_msg);
-    if (mqtt_publish(state_topic.c_str(), mqtt_msg, false) == false) {
-      logging.println("Common info MQTT msg could not be sent");
+    json.reset();
+    json.begin_object();
+    json.add_string("name", config.name);
+    if (mqtt_publish_on_change) {
+      snprintf(id, sizeof(id), "%s/%s", info_topic.c_str(), config.object_id);
+      json.add_string("state_topic", id);
+      json.add_string("value_template", "{{ value }}");
+    } else {
+      json.add_string("state_topic", info_topic.c_str());
+      json.add_string("value_template", config.value_template);
+    }
+    snprintf(id, sizeof(id), "%s_%s", topic_name.c_str(), config.object_id);
+    json.add_string("unique_id", id);
+    snprintf(id, sizeof(id), "%s%s", object_id_prefix.c_str(), config.object_id);
+    json.add_string("object_id", id);
+    if (config.unit != nullptr && strlen(config.unit) > 0) {
+      json.add_string("unit_of_measurement", config.unit);
+    }
+    if (config.device_class != nullptr && strlen(config.device_class) > 0) {
+      json.add_string("device_class", config.device_class);
+      json.add_string("state_class", "measurement");
+    }
+    add_common_discovery_attributes(json);
+    json.end_object();
+    if (publish_json(discovery_topic(topic, "sensor", config.object_id), true)) {
+      ha_common_info_published = true;
+    } else {
       return false;
     }
-    doc.clear();
   }
   return true;
 }
 
-static bool publish_cell_voltages(void) {
-  static JsonDocument doc;
-  static String state_topic = topic_name + "/spec_data";
-  static String state_topic_2 = topic_name + "/spec_data_2";
+static bool publish_common_info(void) {
+  if (ha_autodiscovery_enabled && !ha_common_info_published) {
+    return publish_common_info_discovery();
+  }
 
-  if (ha_autodiscovery_enabled) {
-    bool failed_to_publish = false;
-    if (ha_cell_voltages_published == false) {
-
-      // If the cell voltage number isn't initialized...
-      if (datalayer.battery.info.number_of_cells != 0u) {
-
-        for (int i = 0; i < datalayer.battery.info.number_of_cells; i++) {
-          int cellNumber = i + 1;
-          set_battery_voltage_attributes(doc, i, cellNumber, state_topic, object_id_prefix, "");
-          set_common_discovery_attributes(doc);
-
-          serializeJson(doc, mqtt_msg, sizeof(mqtt_msg));
-          if (mqtt_publish(generateCellVoltageAutoConfigTopic(cellNumber, "").c_str(), mqtt_msg, true) == false) {
-            failed_to_publish = true;
-            return false;
-          }
-        }
-        doc.clear();  // clear after sending autoconfig
-      }
+  read_datalayer_snapshot(snapshot);
 
-      if (battery2) {
-        // TODO: Combine this identical block with the previous one.
-        // If the cell voltage number isn't initialized...
-        if (datalayer.battery2.info.number_of_cells != 0u) {
-
-          for (int i = 0; i < datalayer.battery.info.number_of_cells; i++) {
-            int cellNumber = i + 1;
-            set_battery_voltage_attributes(doc, i, cellNumber, state_topic_2, object_id_prefix + "2_", " 2");
-            set_common_discovery_attributes(doc);
-
-            serializeJson(doc, mqtt_msg, sizeof(mqtt_msg));
-            if (mqtt_publish(generateCellVoltageAutoConfigTopic(cellNumber, "_2_").c_str(), mqtt_msg, true) == false) {
-              failed_to_publish = true;
-              return false;
-            }
-          }
-          doc.clear();  // clear after sending autoconfig
-        }
-      }
+  json.reset();
+  json.begin_object();
+  InfoJson values;
+  info_values(values, snapshot);
+  json.end_object();
+
+  if (publish_json(info_topic.c_str(), false) == false) {
+    logging.println("Common info MQTT msg could not be sent");
+    return false;
+  }
+  return true;
+}
+
+static bool publish_common_info_changes(void) {
+  if (ha_autodiscovery_enabled && !ha_common_info_published) {
+    return publish_common_info_discovery();
+  }
+
+  read_datalayer_snapshot(snapshot);
+
+  InfoChanges values;
+  info_values(values, snapshot);
+  if (!values.sent_all) {
+    logging.println("Common info MQTT msg could not be sent");
+  }
+  return values.sent_all;
+}
+
+// Discovery of the voltage sensor of each cell. index is 0 for the first battery and 1 for the second.
+static bool publish_cell_voltage_discovery(const DATALAYER_BATTERY_TYPE& battery, int index) {
+  // Names used before the two batteries shared this code, kept so Home Assistant finds the same entities
+  const char* name_suffix = index == 0 ? "" : " 2";
+  const char* id_suffix = index == 0 ? "" : "2_";
+  const char* topic_suffix = index == 0 ? "" : "_2_";
+  char topic[MQTT_TOPIC_BUFFER_SIZE];
+  char text[MQTT_TOPIC_BUFFER_SIZE];
+
+  for (int i = 0; i < battery.info.number_of_cells; i++) {
+    const int cellNumber = i + 1;
+    json.reset();
+    json.begin_object();
+    snprintf(text, sizeof(text), "Battery%s Cell Voltage %d", name_suffix, cellNumber);
+    json.add_string("name", text);
+    snprintf(text, sizeof(text), "%s%sbattery_voltage_cell%d", object_id_prefix.c_str(), id_suffix, cellNumber);
+    json.add_string("object_id", text);
+    snprintf(text, sizeof(text), "%s%s%s_battery_voltage_cell%d", topic_name.c_str(), object_id_prefix.c_str(),
+             id_suffix, cellNumber);
+    json.add_string("unique_id", text);
+    json.add_string("device_class", "voltage");
+    json.add_string("state_class", "measurement");
+    json.add_string("unit_of_measurement", "V");
+    if (mqtt_publish_on_change) {
+      snprintf(text, sizeof(text), "%s/cell%d", spec_data_topic[index].c_str(), cellNumber);
+      json.add_string("state_topic", text);
+      json.add_string("value_template", "{{ value }}");
+    } else if (mqtt_compact_cellvoltages) {
+      json.add_string("state_topic", spec_data_topic[index].c_str());
+      snprintf(text, sizeof(text), "{{ (value_json.cell_min_mV + value_json.cell_offsets_mV[%d]) / 1000 }}", i);
+      json.add_string("value_template", text);
+    } else {
+      json.add_string("state_topic", spec_data_topic[index].c_str());
+      snprintf(text, sizeof(text), "{{ value_json.cell_voltages[%d] }}", i);
+      json.add_string("value_template", text);
     }
-    if (failed_to_publish == false) {
-      ha_cell_voltages_published = true;
+    add_common_discovery_attributes(json);
+    json.end_object();
+
+    snprintf(text, sizeof(text), "cell_voltage%s%d", topic_suffix, cellNumber);
+    if (publish_json(discovery_topic(topic, "sensor", text), true) == false) {
+      return false;
     }
   }
+  return true;
+}
 
+static bool publish_cell_voltages(const DATALAYER_BATTERY_TYPE& battery, int index) {
+  const uint16_t cells = battery.info.number_of_cells;
   // If cell voltages have been populated...
-  if (datalayer.battery.info.number_of_cells != 0u &&
-      datalayer.battery.status.cell_voltages_mV[datalayer.battery.info.number_of_cells - 1] != 0u) {
+  if (cells == 0u || battery.status.cell_voltages_mV[cells - 1] == 0u) {
+    return true;
+  }
 
-    JsonArray cell_voltages = doc["cell_voltages"].to<JsonArray>();
-    for (size_t i = 0; i < datalayer.battery.info.number_of_cells; ++i) {
-      cell_voltages.add(((float)datalayer.battery.status.cell_voltages_mV[i]) / 1000.0f);
+  json.reset();
+  json.begin_object();
+  if (mqtt_compact_cellvoltages) {
+    // Whole millivolts above the lowest cell, mostly one or two digits per cell instead of five
+    uint16_t min_mV = battery.status.cell_voltages_mV[0];
+    for (uint16_t i = 1; i < cells; ++i) {
+      min_mV = std::min(min_mV, battery.status.cell_voltages_mV[i]);
     }
+    json.add("cell_min_mV", min_mV);
+    json.begin_array("cell_offsets_mV");
+    for (uint16_t i = 0; i < cells; ++i) {
+      json.element(battery.status.cell_voltages_mV[i] - min_mV);
+    }
+  } else {
+    json.begin_array("cell_voltages");
+    for (uint16_t i = 0; i < cells; ++i) {
+      json.element_fixed(battery.status.cell_voltages_mV[i], 3);
+    }
+  }
+  json.end_array();
+  json.end_object();
 
-    serializeJson(doc, mqtt_msg, sizeof(mqtt_msg));
+  if (!publish_json(spec_data_topic[index].c_str(), false)) {
+    logging.println("Cell voltage MQTT msg could not be sent");
+    return false;
+  }
+  return true;
+}
 
-    if (!mqtt_publish(state_topic.c_str(), mqtt_msg, false)) {
-      logging.println("Cell voltage MQTT msg could not be sent");
+static bool publish_cell_voltage_discovery(void) {
+  if (ha_autodiscovery_enabled && ha_cell_voltages_published == false) {
+    if (publish_cell_voltage_discovery(datalayer.battery, 0) == false) {
       return false;
     }
-    doc.clear();
+    if (battery2 && publish_cell_voltage_discovery(datalayer.battery2, 1) == false) {
+      return false;
+    }
+    ha_cell_voltages_published = true;
+  }
+  return true;
+}
+
+static bool publish_cell_voltages(void) {
+  if (publish_cell_voltage_discovery() == false) {
+    return false;
   }
 
+  if (publish_cell_voltages(datalayer.battery, 0) == false) {
+    return false;
+  }
   if (battery2) {
-    // If cell voltages have been populated...
-    if (datalayer.battery2.info.number_of_cells != 0u &&
-        datalayer.battery2.status.cell_voltages_mV[datalayer.battery2.info.number_of_cells - 1] != 0u) {
+    return publish_cell_voltages(datalayer.battery2, 1);
+  }
+  return true;
+}
 
-      JsonArray cell_voltages = doc["cell_voltages"].to<JsonArray>();
-      for (size_t i = 0; i < datalayer.battery2.info.number_of_cells; ++i) {
-        cell_voltages.add(((float)datalayer.battery2.status.cell_voltages_mV[i]) / 1000.0f);
-      }
+static bool publish_cell_balancing(const DATALAYER_BATTERY_TYPE& battery, int index) {
+  // If cell balancing data is available...
+  if (battery.info.number_of_cells == 0u) {
+    return true;
+  }
 
-      serializeJson(doc, mqtt_msg, sizeof(mqtt_msg));
+  json.reset();
+  json.begin_object();
+  json.begin_array("cell_balancing");
+  for (size_t i = 0; i < battery.info.number_of_cells; ++i) {
+    json.element_bool(battery.status.cell_balancing_status[i]);
+  }
+  json.end_array();
+  json.end_object();
 
-      if (!mqtt_publish(state_topic_2.c_str(), mqtt_msg, false)) {
-        logging.println("Cell voltage MQTT msg could not be sent");
-        return false;
-      }
-      doc.clear();
-    }
+  if (!publish_json(balancing_data_topic[index].c_str(), false)) {
+    logging.println("Cell balancing MQTT msg could not be sent");
+    return false;
   }
   return true;
 }
 
 static bool publish_cell_balancing(void) {
-  static JsonDocument doc;
-  static String state_topic = topic_name + "/balancing_data";
-  static String state_topic_2 = topic_name + "/balancing_data_2";
+  if (publish_cell_balancing(datalayer.battery, 0) == false) {
+    return false;
+  }
+  // Handle second battery if available
+  if (battery2) {
+    return publish_cell_balancing(datalayer.battery2, 1);
+  }
+  return true;
+}
 
-  // If cell balancing data is available...
-  if (datalayer.battery.info.number_of_cells != 0u) {
+/* The cells of a battery whose voltage moved beyond the cell deadband or whose balancing changed, each on a
+ * sub-topic like BE/spec_data/cell12 and BE/balancing_data_2/cell3, as plain text and retained.
+ */
+static bool publish_cell_changes(const DATALAYER_BATTERY_TYPE& battery, int index) {
+  const uint16_t cells = battery.info.number_of_cells;
+  char topic[MQTT_TOPIC_BUFFER_SIZE];
+  char text[16];
 
-    JsonArray cell_balancing = doc["cell_balancing"].to<JsonArray>();
-    for (size_t i = 0; i < datalayer.battery.info.number_of_cells; ++i) {
-      cell_balancing.add(datalayer.battery.status.cell_balancing_status[i]);
+  // If cell voltages have been populated...
+  if (cells != 0u && battery.status.cell_voltages_mV[cells - 1] != 0u) {
+    const Deadband band = {mqtt_cell_deadband_mV, 0};
+    for (uint16_t i = 0; i < cells; ++i) {
+      if (!cell_voltages_published[index].changed(i, battery.status.cell_voltages_mV[i], band)) {
+        continue;
+      }
+      JsonWriter number(text, sizeof(text));
+      number.element_fixed(battery.status.cell_voltages_mV[i], 3);
+      snprintf(topic, sizeof(topic), "%s/cell%d", spec_data_topic[index].c_str(), i + 1);
+      if (!mqtt_publish(topic, text, true)) {
+        cell_voltages_published[index].forget(i);
+        logging.println("Cell voltage MQTT msg could not be sent");
+        return false;
+      }
     }
+  }
 
-    serializeJson(doc, mqtt_msg, sizeof(mqtt_msg));
-
-    if (!mqtt_publish(state_topic.c_str(), mqtt_msg, false)) {
+  for (uint16_t i = 0; i < cells; ++i) {
+    if (!cell_balancing_published[index].changed(i, battery.status.cell_balancing_status[i], EXACT)) {
+      continue;
+    }
+    snprintf(topic, sizeof(topic), "%s/cell%d", balancing_data_topic[index].c_str(), i + 1);
+    if (!mqtt_publish(topic, battery.status.cell_balancing_status[i] ? "true" : "false", true)) {
+      cell_balancing_published[index].forget(i);
       logging.println("Cell balancing MQTT msg could not be sent");
       return false;
     }
-    doc.clear();
   }
+  return true;
+}
 
-  // Handle second battery if available
+static bool publish_cell_changes(void) {
+  if (publish_cell_voltage_discovery() == false) {
+    return false;
+  }
+  if (publish_cell_changes(datalayer.battery, 0) == false) {
+    return false;
+  }
   if (battery2) {
-    if (datalayer.battery2.info.number_of_cells != 0u) {
-
-      JsonArray cell_balancing = doc["cell_balancing"].to<JsonArray>();
-      for (size_t i = 0; i < datalayer.battery2.info.number_of_cells; ++i) {
-        cell_balancing.add(datalayer.battery2.status.cell_balancing_status[i]);
-      }
-
-      serializeJson(doc, mqtt_msg, sizeof(mqtt_msg));
-
-      if (!mqtt_publish(state_topic_2.c_str(), mqtt_msg, false)) {
-        logging.println("Cell balancing MQTT msg could not be sent");
-        return false;
-      }
-      doc.clear();
-    }
+    return publish_cell_changes(datalayer.battery2, 1);
   }
   return true;
 }
 
 bool publish_events() {
-  static JsonDocument doc;
-  static String state_topic = topic_name + "/events";
   if (ha_autodiscovery_enabled && !ha_events_published) {
-
-    doc["name"] = "Event";
-    doc["state_topic"] = state_topic;
-    doc["unique_id"] = topic_name + "_event";
-    doc["object_id"] = object_id_prefix + "event";
-    doc["value_template"] =
+    char topic[MQTT_TOPIC_BUFFER_SIZE];
+    char id[MQTT_TOPIC_BUFFER_SIZE];
+
+    json.reset();
+    json.begin_object();
+    json.add_string("name", "Event");
+    json.add_string("state_topic", events_topic.c_str());
+    snprintf(id, sizeof(id), "%s_event", topic_name.c_str());
+    json.add_string("unique_id", id);
+    snprintf(id, sizeof(id), "%sevent", object_id_prefix.c_str());
+    json.add_string("object_id", id);
+    json.add_string(
+        "value_template",
         "{{ value_json.event_type ~ ' (c:' ~ value_json.count ~ ',m:' ~  value_json.millis ~ ') ' ~ value_json.message "
-        "}}";
-    doc["json_attributes_topic"] = state_topic;
-    doc["json_attributes_template"] = "{{ value_json | tojson }}";
-    set_common_discovery_attributes(doc);
-    serializeJson(doc, mqtt_msg);
-    if (mqtt_publish(generateEventsAutoConfigTopic("event").c_str(), mqtt_msg, true)) {
+        "}}");
+    json.add_string("json_attributes_topic", events_topic.c_str());
+    json.add_string("json_attributes_template", "{{ value_json | tojson }}");
+    add_common_discovery_attributes(json);
+    json.end_object();
+    if (publish_json(discovery_topic(topic, "sensor", "event"), true)) {
       ha_events_published = true;
     } else {
       return false;
     }
-
-    doc.clear();
   } else {
-    const EVENTS_STRUCT_TYPE* event_pointer;
-
-    //clear the vector
-    order_events.clear();
-    // Collect all events
-    for (int i = 0; i < EVENT_NOF_EVENTS; i++) {
-      event_pointer = get_event_pointer((EVENTS_ENUM_TYPE)i);
-      if (event_pointer->occurences > 0 && !event_pointer->MQTTpublished) {
-        order_events.push_back({static_cast<EVENTS_ENUM_TYPE>(i), event_pointer});
+    EVENTS_ENUM_TYPE order[EVENT_NOF_EVENTS];
+    const size_t count = get_events_newest_first(order, EVENT_NOF_EVENTS);
+    // Oldest first, in the order they happened
+    for (size_t i = count; i-- > 0;) {
+      const EVENTS_ENUM_TYPE event_handle = order[i];
+      const EVENTS_STRUCT_TYPE* event_pointer = get_event_pointer(event_handle);
+      if (event_pointer->MQTTpublished) {
+        continue;
       }
-    }
-    // Sort events by timestamp
-    std::sort(order_events.begin(), order_events.end(), compareEventsByTimestampAsc);
-
-    for (const auto& event : order_events) {
-
-      EVENTS_ENUM_TYPE event_handle = event.event_handle;
-      event_pointer = event.event_pointer;
-
-      doc["event_type"] = String(get_event_enum_string(event_handle));
-      doc["severity"] = String(get_event_level_string(event_handle));
-      doc["count"] = String(event_pointer->occurences);
-      doc["data"] = String(event_pointer->data);
-      doc["message"] = get_event_message_string(event_handle);
-      doc["millis"] = String(event_pointer->timestamp);
 
-      serializeJson(doc, mqtt_msg);
-      if (!mqtt_publish(state_topic.c_str(), mqtt_msg, false)) {
+      // The numbers were always sent as strings
+      char number[21];
+      json.reset();
+      json.begin_object();
+      json.add_string("event_type", get_event_enum_string(event_handle));
+      json.add_string("severity", get_event_level_string(event_handle));
+      snprintf(number, sizeof(number), "%u", (unsigned)event_pointer->occurences);
+      json.add_string("count", number);
+      snprintf(number, sizeof(number), "%u", (unsigned)event_pointer->data);
+      json.add_string("data", number);
+      json.add_string("message", get_event_message_string(event_handle).c_str());
+      snprintf(number, sizeof(number), "%llu", (unsigned long long)event_pointer->timestamp);
+      json.add_string("millis", number);
+      json.end_object();
+
+      if (!publish_json(events_topic.c_str(), false)) {
         logging.println("Common info MQTT msg could not be sent");
         return false;
       } else {
         set_event_MQTTpublished(event_handle);
       }
-      doc.clear();
-      //clear the vector
-      order_events.clear();
     }
   }
   return true;
 }
 
+/** Execution time statistics of the core task, see perf_stats.h */
+static bool publish_performance(void) {
+  if (perf_stats_serialize(mqtt_msg, sizeof(mqtt_msg)) == 0) {
+    logging.println("Performance MQTT msg too large");
+    return true;
+  }
+  return mqtt_publish(perf_topic.c_str(), mqtt_msg, false);
+}
+
 static bool publish_buttons_discovery(void) {
   if (ha_autodiscovery_enabled) {
     if (ha_buttons_published == false) {
       logging.println("Publishing buttons discovery");
 
-      static JsonDocument doc;
+      char topic[MQTT_TOPIC_BUFFER_SIZE];
+      char text[MQTT_TOPIC_BUFFER_SIZE];
       for (int i = 0; i < sizeof(buttonConfigs) / sizeof(buttonConfigs[0]); i++) {
         SensorConfig& config = buttonConfigs[i];
-        doc["name"] = config.name;
-        doc["unique_id"] = object_id_prefix + config.object_id;
-        doc["command_topic"] = generateButtonTopic(config.object_id);
-        set_common_discovery_attributes(doc);
-        serializeJson(doc, mqtt_msg);
-        if (mqtt_publish(generateButtonAutoConfigTopic(config.object_id).c_str(), mqtt_msg, true)) {
+        json.reset();
+        json.begin_object();
+        json.add_string("name", config.name);
+        snprintf(text, sizeof(text), "%s%s", object_id_prefix.c_str(), config.object_id);
+        json.add_string("unique_id", text);
+        snprintf(text, sizeof(text), "%s%s", command_topic_prefix.c_str(), config.object_id);
+        json.add_string("command_topic", text);
+        add_common_discovery_attributes(json);
+        json.end_object();
+        if (publish_json(discovery_topic(topic, "button", config.object_id), true)) {
           ha_buttons_published = true;
         } else {
           return false;
         }
-        doc.clear();
       }
     }
   }
@@ -559,41 +810,48 @@ static bool publish_buttons_discovery(void) {
 }
 
 static void subscribe() {
-  esp_mqtt_client_subscribe(client, (topic_name + "/command/+").c_str(), 1);
+  esp_mqtt_client_subscribe(client, (command_topic_prefix + "+").c_str(), 1);
 }
 
-void mqtt_message_received(char* topic_raw, int topic_len, char* data, int data_len) {
+// True if the received topic, which is not zero terminated, is the topic of the command
+static bool is_command_topic(const char* topic, int topic_len, const char* command) {
+  const size_t prefix_len = command_topic_prefix.length();
+  const size_t command_len = strlen(command);
+  return (size_t)topic_len == prefix_len + command_len &&
+         strncmp(topic, command_topic_prefix.c_str(), prefix_len) == 0 &&
+         strncmp(topic + prefix_len, command, command_len) == 0;
+}
 
-  char* topic = strndup(topic_raw, topic_len);
+void mqtt_message_received(char* topic, int topic_len, char* data, int data_len) {
 
   logging.printf("MQTT message arrived: [%.*s]\n", topic_len, topic);
 
   if (remote_bms_reset) {
-    if (strcmp(topic, generateButtonTopic("BMSRESET").c_str()) == 0) {
+    if (is_command_topic(topic, topic_len, "BMSRESET")) {
       logging.println("Triggering BMS reset");
       start_bms_reset();
     }
   }
 
-  if (strcmp(topic, generateButtonTopic("PAUSE").c_str()) == 0) {
+  if (is_command_topic(topic, topic_len, "PAUSE")) {
     setBatteryPause(true, false);
   }
 
-  if (strcmp(topic, generateButtonTopic("RESUME").c_str()) == 0) {
+  if (is_command_topic(topic, topic_len, "RESUME")) {
     setBatteryPause(false, false, false);
   }
 
-  if (strcmp(topic, generateButtonTopic("RESTART").c_str()) == 0) {
+  if (is_command_topic(topic, topic_len, "RESTART")) {
     setBatteryPause(true, true, true, false);
     delay(1000);
     ESP.restart();
   }
 
-  if (strcmp(topic, generateButtonTopic("STOP").c_str()) == 0) {
+  if (is_command_topic(topic, topic_len, "STOP")) {
     setBatteryPause(true, false, true);
   }
 
-  if (strcmp(topic, generateButtonTopic("SET_LIMITS").c_str()) == 0) {
+  if (is_command_topic(topic, topic_len, "SET_LIMITS")) {
     JsonDocument doc;
     char* data_str = strndup(data, data_len);
     deserializeJson(doc, data_str);
@@ -624,8 +882,6 @@ void mqtt_message_received(char* topic_raw, int topic_len, char* data, int data_
 
     free(data_str);
   }
-
-  free(topic);
 }
 
 static void mqtt_event_handler(void* handler_args, esp_event_base_t base, int32_t event_id, void* event_data) {
@@ -637,6 +893,7 @@ static void mqtt_event_handler(void* handler_args, esp_event_base_t base, int32_
 
       publish_buttons_discovery();
       subscribe();
+      full_refresh_due = true;
       logging.println("MQTT connected");
       break;
     case MQTT_EVENT_DISCONNECTED:
@@ -718,7 +975,16 @@ bool init_mqtt(void) {
   mqtt_cfg.credentials.client_id = clientId.c_str();
   mqtt_cfg.credentials.username = mqtt_user.c_str();
   mqtt_cfg.credentials.authentication.password = mqtt_password.c_str();
-  lwt_topic = topic_name + "/status";
+  build_topics();
+  if (mqtt_publish_on_change) {
+    info_fields.reserve(MQTT_INFO_FIELDS);
+    info_published.resize(MQTT_INFO_FIELDS);
+    for (int i = 0; i < 2; i++) {
+      cell_voltages_published[i].resize(MAX_AMOUNT_CELLS);
+      cell_balancing_published[i].resize(MAX_AMOUNT_CELLS);
+    }
+    publish_heartbeat_timer.set_interval(mqtt_heartbeat_s * 1000ul);
+  }
   mqtt_cfg.session.last_will.topic = lwt_topic.c_str();
   mqtt_cfg.session.last_will.qos = 1;
   mqtt_cfg.session.last_will.retain = true;
@@ -751,7 +1017,18 @@ void mqtt_client_loop(void) {
 
     if (publish_global_timer.elapsed())  // Every 5s
     {
-      publish_values();
+      if (!mqtt_publish_on_change) {
+        publish_values();
+      } else {
+        if (full_refresh_due || publish_heartbeat_timer.elapsed()) {
+          // Everything, also the values that only moved within their deadband
+          full_refresh_due = false;
+          publish_heartbeat_timer.reset();
+          forget_published_values();
+          publish_values();
+        }
+        publish_changed_values();
+      }
     }
   }
 }
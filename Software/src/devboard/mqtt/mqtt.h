@@ -37,13 +37,21 @@
 #include <Arduino.h>
 #include <string>
 #include <vector>
+#include "../../system_settings.h"
 
-#define MQTT_MSG_BUFFER_SIZE (1024)
+// Largest message published, the voltages or balancing states of all cells of the biggest supported pack
+#define MQTT_MSG_BUFFER_SIZE (MAX_AMOUNT_CELLS * 8 + 512)
 
 extern const char* version_number;  // The current software version, used for mqtt
 
 extern bool mqtt_enabled;
 extern bool mqtt_transmit_all_cellvoltages;
+extern bool mqtt_compact_cellvoltages;
+// Publish each value on its own sub-topic when it changes beyond its deadband, everything every mqtt_heartbeat_s
+extern bool mqtt_publish_on_change;
+extern uint16_t mqtt_cell_deadband_mV;
+extern uint16_t mqtt_soc_deadband_pptt;
+extern uint16_t mqtt_heartbeat_s;
 extern uint16_t mqtt_timeout_ms;
 extern bool ha_autodiscovery_enabled;
 extern std::string mqtt_server;
@@ -55,8 +63,6 @@ extern const char* mqtt_object_id_prefix;
 extern const char* mqtt_device_name;
 extern const char* ha_device_id;
 
-extern char mqtt_msg[MQTT_MSG_BUFFER_SIZE];
-
 bool init_mqtt(void);
 void mqtt_client_loop(void);
 bool mqtt_publish(const char* topic, const char* mqtt_msg, bool retain);
@@ -0,0 +1,325 @@
+#include "can_log_format.h"
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+
+size_t can_log_encode(const CAN_frame& frame, CAN_Interface interface, frameDirection direction, uint64_t timestamp_us,
+                      CAN_log_record& record) {
+  const uint8_t dlc = frame.DLC > 64 ? 64 : frame.DLC;
+  const size_t size = can_log_record_size(dlc);
+
+  record.timestamp_us = timestamp_us;
+  record.id = frame.ID;
+  record.interface = (uint8_t)interface;
+  record.direction = (uint8_t)direction;
+  record.flags = (frame.ext_ID ? CAN_LOG_FLAG_EXT_ID : 0) | (frame.FD ? CAN_LOG_FLAG_FD : 0);
+  record.dlc = dlc;
+  memcpy(record.data, frame.data.u8, dlc);
+  // Zero the padding so the log does not contain stale stack contents
+  memset(record.data + dlc, 0, size - CAN_LOG_RECORD_HEADER_SIZE - dlc);
+
+  return size;
+}
+
+size_t can_log_decode(const uint8_t* buffer, size_t length, CAN_log_record& record) {
+  if (length < CAN_LOG_RECORD_HEADER_SIZE) {
+    return 0;
+  }
+  memcpy(&record, buffer, CAN_LOG_RECORD_HEADER_SIZE);
+  if (record.dlc > 64 || record.direction > MSG_TX || record.interface >= NO_CAN_INTERFACE) {
+    return SIZE_MAX;
+  }
+  const size_t size = can_log_record_size(record.dlc);
+  if (length < size) {
+    return 0;
+  }
+  memcpy(record.data, buffer + CAN_LOG_RECORD_HEADER_SIZE, record.dlc);
+  return size;
+}
+
+size_t can_log_format_text(const CAN_log_record& record, char* out, size_t out_size) {
+  static const char hex[] = "0123456789ABCDEF";
+
+  if (out_size < CAN_LOG_MAX_TEXT_LINE) {
+    return 0;
+  }
+
+  // Multiplying the interface by two ensures that SavvyCAN puts TX and RX in a different bus.
+  const char* format =
+      (record.flags & CAN_LOG_FLAG_EXT_ID) ? "(%lu.%06lu) %s%d %08lX [%u]" : "(%lu.%06lu) %s%d %03lX [%u]";
+  int length = snprintf(out, out_size, format, (unsigned long)(record.timestamp_us / 1000000),
+                        (unsigned long)(record.timestamp_us % 1000000), record.direction == MSG_RX ? "RX" : "TX",
+                        record.interface * 2 + record.direction, (unsigned long)record.id, record.dlc);
+  if (length < 0) {
+    return 0;
+  }
+
+  char* p = out + length;
+  for (uint8_t i = 0; i < record.dlc; i++) {
+    *p++ = ' ';
+    *p++ = hex[record.data[i] >> 4];
+    *p++ = hex[record.data[i] & 0x0F];
+  }
+  *p++ = '\n';
+  *p = '\0';
+
+  return p - out;
+}
+
+static int hex_value(char c) {
+  if (c >= '0' && c <= '9') {
+    return c - '0';
+  }
+  if (c >= 'A' && c <= 'F') {
+    return c - 'A' + 10;
+  }
+  if (c >= 'a' && c <= 'f') {
+    return c - 'a' + 10;
+  }
+  return -1;
+}
+
+static bool is_digit(char c) {
+  return c >= '0' && c <= '9';
+}
+
+static const char* skip_spaces(const char* p, const char* end) {
+  while (p < end && (*p == ' ' || *p == '\t' || *p == '\r')) {
+    p++;
+  }
+  return p;
+}
+
+bool can_log_parse_text(const char* line, size_t length, CAN_log_record& record) {
+  const char* end = line + length;
+  const char* p = skip_spaces(line, end);
+
+  // Timestamp "(seconds.fraction)", the fraction is read digit by digit to keep microsecond precision
+  if (p == end || *p != '(') {
+    return false;
+  }
+  p++;
+  if (p == end || !is_digit(*p)) {
+    return false;
+  }
+  uint64_t seconds = 0;
+  while (p < end && is_digit(*p)) {
+    seconds = seconds * 10 + (*p++ - '0');
+  }
+  uint32_t micros = 0;
+  if (p < end && *p == '.') {
+    p++;
+    for (uint32_t scale = 100000; p < end && is_digit(*p); p++) {
+      micros += (*p - '0') * scale;
+      scale /= 10;
+    }
+  }
+  if (p == end || *p != ')') {
+    return false;
+  }
+  p = skip_spaces(p + 1, end);
+
+  // Bus tag, RX<n> or TX<n> where n is interface * 2 + direction
+  const char* tag = p;
+  while (p < end && *p != ' ') {
+    p++;
+  }
+  record.interface = CAN_NATIVE;
+  record.direction = MSG_RX;
+  if (p - tag >= 3 && (tag[0] == 'R' || tag[0] == 'T') && tag[1] == 'X') {
+    int bus = 0;
+    const char* digit = tag + 2;
+    while (digit < p && is_digit(*digit)) {
+      bus = bus * 10 + (*digit++ - '0');
+    }
+    if (digit == p && bus / 2 < NO_CAN_INTERFACE) {
+      record.interface = bus / 2;
+      record.direction = tag[0] == 'R' ? MSG_RX : MSG_TX;
+    }
+  }
+  p = skip_spaces(p, end);
+
+  // ID in hex
+  uint32_t id = 0;
+  int id_digits = 0;
+  for (int value; p < end && (value = hex_value(*p)) >= 0; p++) {
+    id = (id << 4) | value;
+    id_digits++;
+  }
+  if (id_digits == 0 || id_digits > 8 || id > 0x1FFFFFFF) {
+    return false;
+  }
+  p = skip_spaces(p, end);
+
+  // DLC "[n]"
+  if (p == end || *p != '[') {
+    return false;
+  }
+  p++;
+  unsigned int dlc = 0;
+  if (p == end || !is_digit(*p)) {
+    return false;
+  }
+  while (p < end && is_digit(*p)) {
+    dlc = dlc * 10 + (*p++ - '0');
+  }
+  if (p == end || *p != ']' || dlc > 64) {
+    return false;
+  }
+  p++;
+
+  for (unsigned int i = 0; i < dlc; i++) {
+    p = skip_spaces(p, end);
+    int high = p < end ? hex_value(*p) : -1;
+    if (high < 0) {
+      return false;  // Fewer data bytes than the DLC says
+    }
+    p++;
+    int low = p < end ? hex_value(*p) : -1;
+    if (low < 0) {
+      record.data[i] = high;
+    } else {
+      record.data[i] = (high << 4) | low;
+      p++;
+    }
+  }
+
+  record.timestamp_us = seconds * 1000000 + micros;
+  record.id = id;
+  record.flags = (id_digits > 3 || id > 0x7FF ? CAN_LOG_FLAG_EXT_ID : 0) | (dlc > 8 ? CAN_LOG_FLAG_FD : 0);
+  record.dlc = dlc;
+  return true;
+}
+
+void CanLogParser::reset() {
+  format = Format::Unknown;
+  pending_length = 0;
+  line_too_long = false;
+  skipped_count = 0;
+}
+
+bool CanLogParser::add_record(const CAN_log_record& record, std::vector<uint8_t>& records, size_t max_size) {
+  const size_t size = can_log_record_size(record.dlc);
+  if (records.size() + size > max_size) {
+    return false;
+  }
+  const uint8_t* bytes = (const uint8_t*)&record;
+  records.insert(records.end(), bytes, bytes + CAN_LOG_RECORD_HEADER_SIZE + record.dlc);
+  records.resize(records.size() + size - CAN_LOG_RECORD_HEADER_SIZE - record.dlc, 0);
+  return true;
+}
+
+bool CanLogParser::flush_pending(std::vector<uint8_t>& records, size_t max_size) {
+  CAN_log_record record;
+
+  if (format == Format::Binary) {
+    size_t offset = 0;
+    size_t used;
+    while ((used = can_log_decode(pending + offset, pending_length - offset, record)) != 0) {
+      if (used == SIZE_MAX) {
+        // There is no way to find the next record again, ignore the rest of the log
+        skipped_count++;
+        format = Format::Invalid;
+        pending_length = 0;
+        return true;
+      }
+      if (!add_record(record, records, max_size)) {
+        return false;
+      }
+      offset += used;
+    }
+    memmove(pending, pending + offset, pending_length - offset);
+    pending_length -= offset;
+    return true;
+  }
+
+  // Text, pending holds one line without the newline
+  const char* line = (const char*)pending;
+  const char* start = skip_spaces(line, line + pending_length);
+  bool ok = true;
+  if (line_too_long) {
+    skipped_count++;
+  } else if (can_log_parse_text(line, pending_length, record)) {
+    ok = add_record(record, records, max_size);
+  } else if (start < line + pending_length && *start == '(') {
+    skipped_count++;  // Looks like a frame but could not be parsed
+  }
+  pending_length = 0;
+  line_too_long = false;
+  return ok;
+}
+
+bool CanLogParser::feed(const uint8_t* data, size_t length, std::vector<uint8_t>& records, size_t max_size) {
+  while (length > 0) {
+    switch (format) {
+      case Format::Unknown:
+        pending[pending_length++] = *data++;
+        length--;
+        if (pending[pending_length - 1] != (uint8_t)CAN_LOG_MAGIC[pending_length - 1]) {
+          // Not a binary log, run what has been collected so far through the text parser
+          uint8_t start[CAN_LOG_MAGIC_SIZE];
+          const size_t start_length = pending_length;
+          memcpy(start, pending, start_length);
+          pending_length = 0;
+          format = Format::Text;
+          if (!feed(start, start_length, records, max_size)) {
+            return false;
+          }
+        } else if (pending_length == CAN_LOG_MAGIC_SIZE) {
+          pending_length = 0;
+          format = Format::Binary;
+        }
+        break;
+      case Format::Text: {
+        const uint8_t c = *data++;
+        length--;
+        if (c == '\n') {
+          if (!flush_pending(records, max_size)) {
+            return false;
+          }
+        } else if (pending_length < sizeof(pending)) {
+          pending[pending_length++] = c;
+        } else {
+          line_too_long = true;
+        }
+        break;
+      }
+      case Format::Binary: {
+        const size_t chunk = std::min(length, sizeof(pending) - pending_length);
+        memcpy(pending + pending_length, data, chunk);
+        pending_length += chunk;
+        data += chunk;
+        length -= chunk;
+        if (!flush_pending(records, max_size)) {
+          return false;
+        }
+        break;
+      }
+      case Format::Invalid:
+        return true;
+    }
+  }
+  return true;
+}
+
+bool CanLogParser::finish(std::vector<uint8_t>& records, size_t max_size) {
+  if (format == Format::Unknown) {
+    // Shorter than the binary header, can only be a text log
+    uint8_t start[CAN_LOG_MAGIC_SIZE];
+    const size_t start_length = pending_length;
+    memcpy(start, pending, start_length);
+    pending_length = 0;
+    format = Format::Text;
+    if (!feed(start, start_length, records, max_size)) {
+      return false;
+    }
+  }
+  if (format == Format::Text && (pending_length > 0 || line_too_long)) {
+    return flush_pending(records, max_size);
+  }
+  if (format == Format::Binary && pending_length > 0) {
+    skipped_count++;  // Log ends with a partial record
+    pending_length = 0;
+  }
+  return true;
+}
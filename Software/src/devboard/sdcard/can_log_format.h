@@ -0,0 +1,91 @@
+#ifndef CAN_LOG_FORMAT_H
+#define CAN_LOG_FORMAT_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+#include "../utils/types.h"
+
+/* Binary CAN log format used for logging to SD card.
+ *
+ * A log file starts with the 8 byte CAN_LOG_MAGIC, followed by records. Each record is the 16 byte
+ * header of CAN_log_record followed by the payload, padded up to a multiple of 8 bytes. A classic CAN
+ * frame therefore takes 24 bytes, a 64 byte CAN-FD frame 80 bytes. All fields are little endian.
+ */
+
+#define CAN_LOG_MAGIC "BECANLG1"
+#define CAN_LOG_MAGIC_SIZE 8
+
+#define CAN_LOG_FLAG_EXT_ID 0x01
+#define CAN_LOG_FLAG_FD 0x02
+
+#define CAN_LOG_RECORD_HEADER_SIZE 16
+#define CAN_LOG_MAX_RECORD_SIZE (CAN_LOG_RECORD_HEADER_SIZE + 64)
+
+// Longest text line produced by can_log_format_text, 64 data bytes in hex plus timestamp, tag and ID
+#define CAN_LOG_MAX_TEXT_LINE 256
+
+struct CAN_log_record {
+  uint64_t timestamp_us;
+  uint32_t id;
+  uint8_t interface;  // CAN_Interface the frame was seen on
+  uint8_t direction;  // frameDirection
+  uint8_t flags;      // CAN_LOG_FLAG_xxx
+  uint8_t dlc;        // Number of payload bytes, 0-64
+  uint8_t data[64];
+};
+
+static_assert(offsetof(CAN_log_record, data) == CAN_LOG_RECORD_HEADER_SIZE, "CAN log record header must be packed");
+
+// Number of bytes a record with dlc payload bytes occupies in the log
+inline size_t can_log_record_size(uint8_t dlc) {
+  return CAN_LOG_RECORD_HEADER_SIZE + ((dlc + 7u) & ~7u);
+}
+
+// Fill record from a frame. Returns the number of bytes of record to write to the log.
+size_t can_log_encode(const CAN_frame& frame, CAN_Interface interface, frameDirection direction, uint64_t timestamp_us,
+                      CAN_log_record& record);
+
+// Parse one record from buffer. Returns the number of bytes consumed, or 0 if buffer holds less than a full
+// record. Returns SIZE_MAX if the data at buffer is not a valid record.
+size_t can_log_decode(const uint8_t* buffer, size_t length, CAN_log_record& record);
+
+// Format a record as a candump/SavvyCAN text line including the trailing newline, e.g.
+// "(12.345678) RX0 1DB [8] 00 11 22 33 44 55 66 77". The bus number is interface * 2 for RX and
+// interface * 2 + 1 for TX, same as the webserver CAN log. Standard IDs are written with 3 hex digits,
+// extended IDs with 8, so the ID type survives the conversion. Returns the length written.
+size_t can_log_format_text(const CAN_log_record& record, char* out, size_t out_size);
+
+// Parse a text line as written by can_log_format_text or the webserver CAN log. The timestamp may have
+// any number of decimals. An RX<n>/TX<n> tag gives the interface and direction, any other tag is read as
+// received on CAN_NATIVE. IDs longer than 3 hex digits or above 0x7FF are extended. Returns false for
+// comments, empty lines and lines that are not CAN frames.
+bool can_log_parse_text(const char* line, size_t length, CAN_log_record& record);
+
+// Converts a text or binary CAN log into binary records while it is being received in chunks of any
+// size, e.g. from a file upload. Binary logs are recognized by CAN_LOG_MAGIC.
+class CanLogParser {
+ public:
+  void reset();
+  // Append the records found in data to records. Returns false, and stops, if records would grow beyond
+  // max_size bytes.
+  bool feed(const uint8_t* data, size_t length, std::vector<uint8_t>& records, size_t max_size);
+  // Handle a last line without newline at the end of the log
+  bool finish(std::vector<uint8_t>& records, size_t max_size);
+  // Number of lines or records that could not be parsed
+  uint32_t skipped() const { return skipped_count; }
+
+ private:
+  enum class Format { Unknown, Text, Binary, Invalid };
+
+  Format format = Format::Unknown;
+  uint8_t pending[CAN_LOG_MAX_TEXT_LINE];
+  size_t pending_length = 0;
+  bool line_too_long = false;
+  uint32_t skipped_count = 0;
+
+  bool flush_pending(std::vector<uint8_t>& records, size_t max_size);
+  bool add_record(const CAN_log_record& record, std::vector<uint8_t>& records, size_t max_size);
+};
+
+#endif
@@ -1,6 +1,9 @@
 #include "sdcard.h"
+#include "esp_timer.h"
 #include "freertos/ringbuf.h"
 
+#include <algorithm>
+
 File can_log_file;
 File log_file;
 RingbufHandle_t can_bufferHandle;
@@ -10,6 +13,12 @@ bool can_logging_paused = false;
 bool can_file_open = false;
 bool delete_can_file = false;
 
+// Frames are collected into blocks and written to the card in one go
+static uint8_t can_block[CAN_LOG_BLOCK_SIZE];
+static size_t can_block_fill = 0;
+static size_t can_file_size = 0;
+static unsigned long can_last_flush_ms = 0;
+
 bool logging_paused = false;
 bool log_file_open = false;
 bool delete_log_file = false;
@@ -23,8 +32,6 @@ void delete_can_log() {
 
 void resume_can_writing() {
   can_logging_paused = false;
-  can_log_file = SD_MMC.open(CAN_LOG_FILE, FILE_APPEND);
-  can_file_open = true;
 }
 
 void pause_can_writing() {
@@ -51,70 +58,144 @@ void pause_log_writing() {
   logging_paused = true;
 }
 
-void add_can_frame_to_buffer(CAN_frame frame, frameDirection msgDir) {
+void add_can_frame_to_buffer(const CAN_frame& frame, CAN_Interface interface, frameDirection msgDir) {
 
   if (!sd_card_active)
     return;
 
-  unsigned long currentTime = millis();
-  static char messagestr_buffer[32];
-  size_t size = 0;
-  size = snprintf(messagestr_buffer + size, sizeof(messagestr_buffer) - size, "(%lu.%03lu) %s %lX [%u] ",
-                  currentTime / 1000, currentTime % 1000, (msgDir == MSG_RX ? "RX0" : "TX1"), frame.ID, frame.DLC);
+  CAN_log_record record;
+  const size_t size = can_log_encode(frame, interface, msgDir, esp_timer_get_time(), record);
 
-  if (xRingbufferSend(can_bufferHandle, &messagestr_buffer, size, pdMS_TO_TICKS(2)) != pdTRUE) {
-    logging.println("Failed to send message to can ring buffer!");
-    return;
+  // Never block the core task, if the logging task can not keep up the frame is dropped and counted
+  if (xRingbufferSend(can_bufferHandle, &record, size, 0) != pdTRUE) {
+    datalayer.system.status.can_sd_frames_dropped++;
   }
+}
 
-  uint8_t i = 0;
-  for (i = 0; i < frame.DLC; i++) {
-    if (i < frame.DLC - 1)
-      size = snprintf(messagestr_buffer, sizeof(messagestr_buffer), "%02X ", frame.data.u8[i]);
-    else
-      size = snprintf(messagestr_buffer, sizeof(messagestr_buffer), "%02X\n", frame.data.u8[i]);
-
-    if (xRingbufferSend(can_bufferHandle, &messagestr_buffer, size, pdMS_TO_TICKS(2)) != pdTRUE) {
-      logging.println("Failed to send message to can ring buffer!");
-      return;
-    }
+static void open_can_log_file() {
+  can_log_file = SD_MMC.open(CAN_LOG_FILE, FILE_APPEND);
+  can_file_open = true;
+  can_file_size = can_log_file.size();
+  if (can_file_size == 0) {
+    can_file_size = can_log_file.write((const uint8_t*)CAN_LOG_MAGIC, CAN_LOG_MAGIC_SIZE);
   }
 }
 
+static void write_can_block_to_sdcard() {
+  can_file_size += can_log_file.write(can_block, can_block_fill);
+  can_block_fill = 0;
+}
+
 void write_can_frame_to_sdcard() {
 
   if (!sd_card_active)
     return;
 
+  if (can_logging_paused) {
+    if (can_file_open) {
+      if (can_block_fill > 0) {
+        write_can_block_to_sdcard();
+      }
+      can_log_file.close();
+      can_file_open = false;
+    }
+    if (delete_can_file) {
+      SD_MMC.remove(CAN_LOG_FILE);
+      can_block_fill = 0;
+      delete_can_file = false;
+      can_logging_paused = false;
+    }
+  } else if (can_file_open == false) {
+    open_can_log_file();
+  }
+
+  // Fill the block up to the next block aligned file position, so that full blocks are written sector aligned
+  const size_t block_limit =
+      can_block_fill + CAN_LOG_BLOCK_SIZE - ((can_file_size + can_block_fill) % CAN_LOG_BLOCK_SIZE);
+
   size_t receivedMessageSize;
-  uint8_t* buffer = (uint8_t*)xRingbufferReceive(can_bufferHandle, &receivedMessageSize, pdMS_TO_TICKS(10));
+  uint8_t* buffer = (uint8_t*)xRingbufferReceiveUpTo(can_bufferHandle, &receivedMessageSize, pdMS_TO_TICKS(10),
+                                                     block_limit - can_block_fill);
 
   if (buffer != NULL) {
-
-    if (can_logging_paused) {
-      if (can_file_open) {
-        can_log_file.close();
-        can_file_open = false;
-      }
-      if (delete_can_file) {
-        SD_MMC.remove(CAN_LOG_FILE);
-        delete_can_file = false;
-        can_logging_paused = false;
-      }
-      vRingbufferReturnItem(can_bufferHandle, (void*)buffer);
-      return;
+    if (!can_logging_paused) {
+      memcpy(can_block + can_block_fill, buffer, receivedMessageSize);
+      can_block_fill += receivedMessageSize;
     }
+    // Frames arriving while the log is being exported or deleted are discarded
+    vRingbufferReturnItem(can_bufferHandle, (void*)buffer);
+  }
 
-    if (can_file_open == false) {
-      can_log_file = SD_MMC.open(CAN_LOG_FILE, FILE_APPEND);
-      can_file_open = true;
-    }
+  if (!can_file_open) {
+    return;
+  }
 
-    can_log_file.write(buffer, receivedMessageSize);
+  const unsigned long currentMillis = millis();
+  const bool flush_due = currentMillis - can_last_flush_ms >= CAN_LOG_FLUSH_INTERVAL_MS;
+
+  if (can_block_fill == block_limit || (flush_due && can_block_fill > 0)) {
+    write_can_block_to_sdcard();
+  }
+
+  if (flush_due) {
     can_log_file.flush();
+    can_last_flush_ms = currentMillis;
+  }
+}
 
-    vRingbufferReturnItem(can_bufferHandle, (void*)buffer);
+bool CanLogTextExport::open() {
+  file = SD_MMC.open(CAN_LOG_FILE, FILE_READ);
+  if (!file) {
+    return false;
+  }
+  char magic[CAN_LOG_MAGIC_SIZE];
+  if (file.read((uint8_t*)magic, CAN_LOG_MAGIC_SIZE) != CAN_LOG_MAGIC_SIZE ||
+      memcmp(magic, CAN_LOG_MAGIC, CAN_LOG_MAGIC_SIZE) != 0) {
+    file.close();
+    return false;
+  }
+  return true;
+}
+
+bool CanLogTextExport::next_line() {
+  CAN_log_record record;
+  size_t used = can_log_decode(input + input_pos, input_fill - input_pos, record);
+
+  if (used == 0) {
+    // Record continues beyond what has been read, move the remainder to the front and read more
+    memmove(input, input + input_pos, input_fill - input_pos);
+    input_fill -= input_pos;
+    input_pos = 0;
+    input_fill += file.read(input + input_fill, sizeof(input) - input_fill);
+    used = can_log_decode(input, input_fill, record);
+  }
+
+  if (used == 0 || used == SIZE_MAX) {
+    return false;  // End of log, or a record cut short by a power loss
   }
+
+  input_pos += used;
+  line_length = can_log_format_text(record, line, sizeof(line));
+  line_pos = 0;
+  return true;
+}
+
+size_t CanLogTextExport::read(uint8_t* buffer, size_t max_length) {
+  size_t written = 0;
+
+  while (written < max_length && !done) {
+    if (line_pos == line_length && !next_line()) {
+      done = true;
+      file.close();
+      break;
+    }
+    size_t chunk = std::min(line_length - line_pos, max_length - written);
+    memcpy(buffer + written, line + line_pos, chunk);
+    line_pos += chunk;
+    written += chunk;
+  }
+
+  return written;
 }
 
 void add_log_to_buffer(const uint8_t* buffer, size_t size) {
@@ -157,7 +238,7 @@ void write_log_to_sdcard() {
 void init_logging_buffers() {
 
   if (datalayer.system.info.CAN_SD_logging_active) {
-    can_bufferHandle = xRingbufferCreate(32 * 1024, RINGBUF_TYPE_BYTEBUF);
+    can_bufferHandle = xRingbufferCreate(CAN_LOG_RING_BUFFER_SIZE, RINGBUF_TYPE_BYTEBUF);
     if (can_bufferHandle == NULL) {
       logging.println("Failed to create CAN ring buffer!");
       return;
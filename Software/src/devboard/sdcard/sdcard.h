@@ -3,10 +3,16 @@
 
 #include <SD_MMC.h>
 #include "../../communication/can/comm_can.h"
+#include "can_log_format.h"
 #include "../hal/hal.h"
 #include "../utils/events.h"
 
-#define CAN_LOG_FILE "/canlog.txt"
+#define CAN_LOG_FILE "/canlog.bin"
+// Size of the blocks the CAN log is written in, a multiple of the SD card sector size
+#define CAN_LOG_BLOCK_SIZE 4096
+// Time between flushes of the CAN log file, limits how much is lost on power loss
+#define CAN_LOG_FLUSH_INTERVAL_MS 1000
+#define CAN_LOG_RING_BUFFER_SIZE (32 * 1024)
 #define LOG_FILE "/log.txt"
 
 void init_logging_buffers();
@@ -14,7 +20,8 @@ void init_logging_buffers();
 bool init_sdcard();
 void log_sdcard_details();
 
-void add_can_frame_to_buffer(CAN_frame frame, frameDirection msgDir);
+// Queue a frame for the binary CAN log, see can_log_format.h. Called from the core task, never blocks.
+void add_can_frame_to_buffer(const CAN_frame& frame, CAN_Interface interface, frameDirection msgDir);
 void write_can_frame_to_sdcard();
 
 void pause_can_writing();
@@ -24,6 +31,26 @@ void delete_log();
 void resume_log_writing();
 void pause_log_writing();
 
+// Reads the binary CAN log from SD card and converts it to candump text on the fly, for the webserver export
+class CanLogTextExport {
+ public:
+  bool open();
+  // Fill buffer with up to max_length bytes of text. Returns 0 when the whole log has been read.
+  size_t read(uint8_t* buffer, size_t max_length);
+
+ private:
+  File file;
+  uint8_t input[512];
+  size_t input_fill = 0;
+  size_t input_pos = 0;
+  char line[CAN_LOG_MAX_TEXT_LINE];
+  size_t line_length = 0;
+  size_t line_pos = 0;
+  bool done = false;
+
+  bool next_line();
+};
+
 void add_log_to_buffer(const uint8_t* buffer, size_t size);
 void write_log_to_sdcard();
 
@@ -0,0 +1,169 @@
+#ifndef __CAN_SIGNAL_H__
+#define __CAN_SIGNAL_H__
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include "types.h"
+
+/* Signals of a CAN message described like in a DBC file: start bit, length, byte order, signedness and scaling.
+ * The description is all template parameters, so pack() and unpack() compile down to the shifts and stores that
+ * would otherwise be written by hand for each byte.
+ *
+ * Bits are numbered as in DBC files, bit 0 is the least significant bit of byte 0 and bit 63 the most significant
+ * bit of byte 7. For little endian (Intel) signals the start bit is the least significant bit, for big endian
+ * (Motorola) signals it is the most significant one.
+ *
+ * The values in datalayer are integers, so the scaling is integer too: physical = raw * FACTOR / DIVISOR + OFFSET.
+ * Values outside the range of the signal wrap, the same as storing them byte by byte did.
+ */
+enum class CanByteOrder { LittleEndian, BigEndian };
+
+// Position of the next less (Motorola) or more (Intel) significant bit in the sawtooth DBC numbering
+constexpr uint16_t can_signal_next_bit(uint16_t position, CanByteOrder order) {
+  if (order == CanByteOrder::LittleEndian) {
+    return position + 1;
+  }
+  return position % 8 == 0 ? position + 15 : position - 1;
+}
+
+constexpr uint16_t can_signal_last_bit(uint16_t start, uint8_t length, CanByteOrder order) {
+  for (int i = 1; i < length; i++) {
+    start = can_signal_next_bit(start, order);
+  }
+  return start;
+}
+
+template <uint16_t START_BIT, uint8_t LENGTH, CanByteOrder ORDER, bool SIGNED = false, int32_t FACTOR = 1,
+          int32_t DIVISOR = 1, int32_t OFFSET = 0>
+struct CanSignal {
+  static_assert(LENGTH >= 1 && LENGTH <= 32, "Signals are 1 to 32 bits long");
+  static_assert(FACTOR != 0 && DIVISOR != 0, "Scaling must not be zero");
+  static_assert(can_signal_last_bit(START_BIT, LENGTH, ORDER) < sizeof(CAN_frame::data) * 8,
+                "Signal does not fit in a CAN frame");
+
+  static constexpr uint32_t MASK = LENGTH == 32 ? 0xFFFFFFFF : ((uint32_t)1 << LENGTH) - 1;
+
+  // Raw value of a physical one, cut to the length of the signal
+  static constexpr uint32_t encode(int64_t value) { return (uint32_t)((value - OFFSET) * DIVISOR / FACTOR) & MASK; }
+
+  static constexpr int64_t decode(uint32_t raw) {
+    int64_t value = raw & MASK;
+    if (SIGNED && (raw & ((uint32_t)1 << (LENGTH - 1)))) {
+      value -= (int64_t)1 << LENGTH;
+    }
+    return value * FACTOR / DIVISOR + OFFSET;
+  }
+
+  static constexpr void set_raw(uint8_t* data, uint32_t raw) {
+    if constexpr (BYTE_ALIGNED) {
+      for (int i = 0; i < LENGTH / 8; i++) {
+        const int shift = ORDER == CanByteOrder::BigEndian ? LENGTH - 8 * (i + 1) : 8 * i;
+        data[START_BIT / 8 + i] = (uint8_t)(raw >> shift);
+      }
+    } else {
+      uint16_t position = START_BIT;
+      for (int i = 0; i < LENGTH; i++) {
+        // Intel signals go up from the least significant bit, Motorola ones down from the most significant bit
+        const int bit = ORDER == CanByteOrder::BigEndian ? LENGTH - 1 - i : i;
+        const uint8_t value = (uint8_t)(1 << (position % 8));
+        if ((raw >> bit) & 1) {
+          data[position / 8] |= value;
+        } else {
+          data[position / 8] &= (uint8_t)~value;
+        }
+        position = can_signal_next_bit(position, ORDER);
+      }
+    }
+  }
+
+  static constexpr uint32_t get_raw(const uint8_t* data) {
+    uint32_t raw = 0;
+    if constexpr (BYTE_ALIGNED) {
+      for (int i = 0; i < LENGTH / 8; i++) {
+        const int shift = ORDER == CanByteOrder::BigEndian ? LENGTH - 8 * (i + 1) : 8 * i;
+        raw |= (uint32_t)data[START_BIT / 8 + i] << shift;
+      }
+    } else {
+      uint16_t position = START_BIT;
+      for (int i = 0; i < LENGTH; i++) {
+        const int bit = ORDER == CanByteOrder::BigEndian ? LENGTH - 1 - i : i;
+        raw |= (uint32_t)((data[position / 8] >> (position % 8)) & 1) << bit;
+        position = can_signal_next_bit(position, ORDER);
+      }
+    }
+    return raw;
+  }
+
+  static constexpr void pack(uint8_t* data, int64_t value) { set_raw(data, encode(value)); }
+  static void pack(CAN_frame& frame, int64_t value) { pack(frame.data.u8, value); }
+
+  static constexpr int64_t unpack(const uint8_t* data) { return decode(get_raw(data)); }
+  static int64_t unpack(const CAN_frame& frame) { return unpack(frame.data.u8); }
+
+ private:
+  // Whole bytes, which can be stored without looking at single bits
+  static constexpr bool BYTE_ALIGNED =
+      LENGTH % 8 == 0 && START_BIT % 8 == (ORDER == CanByteOrder::BigEndian ? 7 : 0);
+};
+
+// Signal of whole bytes starting at BYTE, which is how most inverter protocols lay out their values
+template <uint8_t BYTE, uint8_t BYTES, CanByteOrder ORDER, bool SIGNED = false, int32_t FACTOR = 1,
+          int32_t DIVISOR = 1, int32_t OFFSET = 0>
+using CanField = CanSignal<ORDER == CanByteOrder::BigEndian ? BYTE * 8 + 7 : BYTE * 8, BYTES * 8, ORDER, SIGNED,
+                           FACTOR, DIVISOR, OFFSET>;
+
+template <uint8_t BYTE, uint8_t BYTES = 2, bool SIGNED = false, int32_t FACTOR = 1, int32_t DIVISOR = 1,
+          int32_t OFFSET = 0>
+using CanFieldBE = CanField<BYTE, BYTES, CanByteOrder::BigEndian, SIGNED, FACTOR, DIVISOR, OFFSET>;
+
+template <uint8_t BYTE, uint8_t BYTES = 2, bool SIGNED = false, int32_t FACTOR = 1, int32_t DIVISOR = 1,
+          int32_t OFFSET = 0>
+using CanFieldLE = CanField<BYTE, BYTES, CanByteOrder::LittleEndian, SIGNED, FACTOR, DIVISOR, OFFSET>;
+
+// The signals of one message, packed from values given in the same order
+template <typename... Signals>
+struct CanMessage {
+  static constexpr size_t COUNT = sizeof...(Signals);
+
+  template <typename... Values>
+  static constexpr void pack(uint8_t* data, Values... values) {
+    static_assert(sizeof...(Values) == COUNT, "One value per signal");
+    (Signals::pack(data, (int64_t)values), ...);
+  }
+};
+
+/* Packs a message into a frame only when the values changed since the last time, most of them stay the same from
+ * one update to the next. The signal bytes of the frame must not be written anywhere else, call invalidate() if
+ * they were. encode_as() packs another layout of the same values, e.g. one picked at runtime by byte order.
+ */
+template <typename Message>
+class CanFrameEncoder {
+ public:
+  // Returns true if the frame was packed
+  template <typename... Values>
+  bool encode(CAN_frame& frame, Values... values) {
+    return encode_as<Message>(frame, values...);
+  }
+
+  template <typename Layout, typename... Values>
+  bool encode_as(CAN_frame& frame, Values... values) {
+    static_assert(Layout::COUNT == Message::COUNT, "Layouts of an encoder have the same values");
+    const int64_t current[Message::COUNT] = {(int64_t)values...};
+    if (valid && memcmp(current, last, sizeof(last)) == 0) {
+      return false;
+    }
+    memcpy(last, current, sizeof(last));
+    valid = true;
+    Layout::pack(frame.data.u8, values...);
+    return true;
+  }
+
+  void invalidate() { valid = false; }
+
+ private:
+  int64_t last[Message::COUNT] = {};
+  bool valid = false;
+};
+
+#endif
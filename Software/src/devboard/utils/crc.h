@@ -0,0 +1,127 @@
+#ifndef __CRC_H__
+#define __CRC_H__
+
+#include <stddef.h>
+#include <stdint.h>
+#include <array>
+#include "types.h"
+
+/* Table driven CRC, parameterized like the CRC catalogue (Rocksoft model): polynomial, initial value, whether
+ * input and output are reflected, and the final XOR. The 256 entry table is generated at compile time and,
+ * being constexpr, ends up in flash. One table exists per algorithm no matter how many integrations use it.
+ *
+ * calculate() gives the CRC of a complete buffer. For CRCs over data that is not contiguous, or that starts
+ * from another value than Init, use start()/update()/finish().
+ */
+template <typename T, T Poly, T Init, bool Reflect, T XorOut>
+class Crc {
+ public:
+  static constexpr T calculate(const uint8_t* data, size_t length) { return finish(update(start(), data, length)); }
+
+  // Register value before the first byte. For reflected algorithms the register holds the bits reversed.
+  static constexpr T start(T init = Init) { return Reflect ? reflect(init) : init; }
+
+  static constexpr T update(T crc, uint8_t byte) {
+    if (Reflect) {
+      return (T)((WIDTH > 8 ? crc >> 8 : 0) ^ table[(uint8_t)(crc ^ byte)]);
+    }
+    return (T)((WIDTH > 8 ? crc << 8 : 0) ^ table[(uint8_t)((crc >> (WIDTH - 8)) ^ byte)]);
+  }
+
+  static constexpr T update(T crc, const uint8_t* data, size_t length) {
+    for (size_t i = 0; i < length; i++) {
+      crc = update(crc, data[i]);
+    }
+    return crc;
+  }
+
+  static constexpr T finish(T crc) { return crc ^ XorOut; }
+
+ private:
+  static constexpr int WIDTH = sizeof(T) * 8;
+  static constexpr T TOP_BIT = (T)1 << (WIDTH - 1);
+
+  static constexpr T reflect(T value) {
+    T reflected = 0;
+    for (int i = 0; i < WIDTH; i++) {
+      reflected = (T)((reflected << 1) | ((value >> i) & 1));
+    }
+    return reflected;
+  }
+
+  static constexpr std::array<T, 256> make_table() {
+    std::array<T, 256> result{};
+    for (int i = 0; i < 256; i++) {
+      T crc = Reflect ? (T)i : (T)((T)i << (WIDTH - 8));
+      if (Reflect) {
+        for (int bit = 0; bit < 8; bit++) {
+          crc = (crc & 1) ? (T)((crc >> 1) ^ reflect(Poly)) : (T)(crc >> 1);
+        }
+      } else {
+        for (int bit = 0; bit < 8; bit++) {
+          crc = (crc & TOP_BIT) ? (T)((crc << 1) ^ Poly) : (T)(crc << 1);
+        }
+      }
+      result[i] = crc;
+    }
+    return result;
+  }
+
+  static constexpr std::array<T, 256> table = make_table();
+};
+
+// CRC-8/SAE-J1850-ZERO, poly 0x1D. Kia/Hyundai, BMW and Renault Zoe.
+using Crc8SaeJ1850Zero = Crc<uint8_t, 0x1D, 0x00, false, 0x00>;
+// CRC-8/AUTOSAR (8H2F), poly 0x2F. Volkswagen MEB and Geely.
+using Crc8Autosar = Crc<uint8_t, 0x2F, 0xFF, false, 0xFF>;
+// Poly 0x85, used by Nissan Leaf battery and charger.
+using Crc8Nissan = Crc<uint8_t, 0x85, 0x00, false, 0x00>;
+// CRC-8/MAXIM-DOW, poly 0x31 reflected. BMW S-Box.
+using Crc8Maxim = Crc<uint8_t, 0x31, 0x00, true, 0x00>;
+// Poly 0x01, used by Hyundai Santa Fe PHEV.
+using Crc8SantaFe = Crc<uint8_t, 0x01, 0x00, false, 0x00>;
+// CRC-16/MODBUS, poly 0x8005 reflected. Sungrow Modbus-over-CAN.
+using Crc16Modbus = Crc<uint16_t, 0x8005, 0xFFFF, true, 0x0000>;
+// CRC-32/ISO-HDLC, poly 0x04C11DB7 reflected. The event journal in flash.
+using Crc32 = Crc<uint32_t, 0x04C11DB7, 0xFFFFFFFF, true, 0xFFFFFFFF>;
+
+/* AUTOSAR E2E style protection of CAN frames, as used by MEB, BMW and Kia/Hyundai. The CRC is in byte 0 and
+ * a 4 bit alive counter in the low nibble of byte 1. The CRC covers bytes 1 up to length and some per
+ * message constant (data ID), so a frame copied onto another ID fails the check.
+ */
+
+// Profile 2 (MEB): CRC-8/AUTOSAR over bytes 1 to length-1, followed by one data ID byte selected by the
+// counter from data_ids, a list of 16 bytes per message ID.
+inline uint8_t e2e_profile2_crc(const CAN_frame& frame, uint8_t length, const uint8_t* data_ids) {
+  uint8_t crc = Crc8Autosar::start();
+  if (length > 1) {
+    crc = Crc8Autosar::update(crc, frame.data.u8 + 1, length - 1);
+  }
+  crc = Crc8Autosar::update(crc, data_ids[frame.data.u8[1] & 0x0F]);
+  return Crc8Autosar::finish(crc);
+}
+
+// Profile 1 variant (BMW, Kia/Hyundai): CRC-8/SAE-J1850-ZERO over bytes 1 to length-1, with the data ID
+// as initial value.
+inline uint8_t e2e_profile1_crc(const CAN_frame& frame, uint8_t length, uint8_t data_id) {
+  return length > 1 ? Crc8SaeJ1850Zero::update(data_id, frame.data.u8 + 1, length - 1) : data_id;
+}
+
+// Put the alive counter in the low nibble of byte 1
+inline void e2e_set_counter(CAN_frame& frame, uint8_t counter) {
+  frame.data.u8[1] = (frame.data.u8[1] & 0xF0) | (counter & 0x0F);
+}
+
+// Set counter and CRC of a profile 2 frame before sending it
+inline void e2e_profile2_protect(CAN_frame& frame, uint8_t counter, const uint8_t* data_ids) {
+  e2e_set_counter(frame, counter);
+  frame.data.u8[0] = e2e_profile2_crc(frame, frame.DLC, data_ids);
+}
+
+// Set counter and CRC of a profile 1 frame before sending it. The CRC covers the first length bytes.
+inline void e2e_profile1_protect(CAN_frame& frame, uint8_t counter, uint8_t length, uint8_t data_id) {
+  e2e_set_counter(frame, counter);
+  frame.data.u8[0] = e2e_profile1_crc(frame, length, data_id);
+}
+
+#endif
@@ -0,0 +1,37 @@
+#include "deadband_tracker.h"
+
+void DeadbandTracker::resize(size_t slots) {
+  last.assign(slots, 0);
+  published.assign(slots, false);
+}
+
+bool DeadbandTracker::changed(size_t slot, int32_t value, Deadband band) {
+  if (slot >= last.size()) {
+    return true;  // Not tracked, always published
+  }
+  if (published[slot]) {
+    const int64_t previous = last[slot];
+    const uint64_t difference = value > previous ? value - previous : previous - value;
+    const uint64_t magnitude = previous < 0 ? -previous : previous;
+    uint64_t threshold = magnitude * band.relative_permille / 1000;
+    if (threshold < band.absolute) {
+      threshold = band.absolute;
+    }
+    if (difference == 0 || difference < threshold) {
+      return false;
+    }
+  }
+  last[slot] = value;
+  published[slot] = true;
+  return true;
+}
+
+void DeadbandTracker::forget(size_t slot) {
+  if (slot < published.size()) {
+    published[slot] = false;
+  }
+}
+
+void DeadbandTracker::forget_all() {
+  published.assign(published.size(), false);
+}
@@ -0,0 +1,42 @@
+#ifndef __DEADBAND_TRACKER_H__
+#define __DEADBAND_TRACKER_H__
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+/* How far a value may move from the last published one before it is published again. The larger of the absolute
+ * and the relative band applies, e.g. {50, 20} for a power in W ignores changes up to 50 W or 2 %. {0, 0} publishes
+ * every change.
+ */
+struct Deadband {
+  uint32_t absolute;
+  uint16_t relative_permille;
+};
+
+/* Remembers the last published value of a fixed number of slots, e.g. one per cell, to publish values only when
+ * they have moved beyond their deadband. A value is compared with the last one published, not the last one seen, so
+ * slow drift is published once it adds up.
+ */
+class DeadbandTracker {
+ public:
+  // Allocates all slots, none published yet
+  void resize(size_t slots);
+  size_t size() const { return last.size(); }
+
+  /* Returns true if the slot has not been published yet or value is outside the deadband around the last published
+   * value, and takes value as the published one. Call forget() if it could not be sent after all.
+   */
+  bool changed(size_t slot, int32_t value, Deadband band);
+
+  // The slot is reported as changed next time, e.g. after a failed publish
+  void forget(size_t slot);
+  // All slots are reported as changed next time, for a full refresh
+  void forget_all();
+
+ private:
+  std::vector<int32_t> last;
+  std::vector<bool> published;
+};
+
+#endif  // __DEADBAND_TRACKER_H__
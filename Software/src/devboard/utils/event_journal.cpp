@@ -0,0 +1,321 @@
+#include "event_journal.h"
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include "crc.h"
+#include "events.h"
+
+#ifndef UNIT_TEST
+#include "esp_partition.h"
+#include "logging.h"
+#endif
+
+EventJournal event_journal;
+
+static uint32_t record_crc(const JournalRecord& record) {
+  return Crc32::calculate(reinterpret_cast<const uint8_t*>(&record), offsetof(JournalRecord, crc));
+}
+
+bool EventJournal::read_slot(uint32_t slot, JournalRecord& record) const {
+  return flash->read(slot * JOURNAL_RECORD_SIZE, &record, sizeof(record)) && record.magic == JOURNAL_MAGIC &&
+         record.crc == record_crc(record);
+}
+
+bool EventJournal::slot_blank(uint32_t slot) const {
+  uint8_t bytes[JOURNAL_RECORD_SIZE];
+  if (!flash->read(slot * JOURNAL_RECORD_SIZE, bytes, sizeof(bytes))) {
+    return false;
+  }
+  return std::all_of(bytes, bytes + sizeof(bytes), [](uint8_t byte) { return byte == 0xFF; });
+}
+
+bool EventJournal::sector_blank(uint32_t sector) const {
+  for (uint32_t slot = sector * JOURNAL_RECORDS_PER_SECTOR; slot < (sector + 1) * JOURNAL_RECORDS_PER_SECTOR; slot++) {
+    if (!slot_blank(slot)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+uint32_t EventJournal::next_sector() const {
+  const uint32_t sector = head / JOURNAL_RECORDS_PER_SECTOR;
+  return head % JOURNAL_RECORDS_PER_SECTOR == 0 ? sector : (sector + 1) % sectors;
+}
+
+bool EventJournal::begin(JournalFlash* journal_flash) {
+  flash = nullptr;
+  sectors = std::min<uint32_t>(journal_flash->size() / JOURNAL_SECTOR_SIZE, JOURNAL_MAX_SECTORS);
+  if (sectors < 2) {
+    return false;  // Erasing the only sector would lose the whole journal
+  }
+  flash = journal_flash;
+
+  // The sectors are filled in turn, so the first records tell which sector was written last and which one
+  // holds the oldest records
+  JournalRecord record;
+  uint32_t newest_sector = 0;
+  uint32_t newest_sequence = 0;
+  uint32_t oldest_sequence = 0;
+  empty = true;
+  for (uint32_t sector = 0; sector < sectors; sector++) {
+    if (!read_slot(sector * JOURNAL_RECORDS_PER_SECTOR, record)) {
+      continue;
+    }
+    if (empty || record.sequence > newest_sequence) {
+      newest_sector = sector;
+      newest_sequence = record.sequence;
+    }
+    if (empty || record.sequence < oldest_sequence) {
+      tail_sector = sector;
+      oldest_sequence = record.sequence;
+    }
+    empty = false;
+  }
+
+  if (empty) {
+    head = 0;
+    tail_sector = 0;
+    next_sequence = 0;
+    boot_number = 0;
+  } else {
+    // Then only the sector written last is read. Torn records may sit between valid ones.
+    JournalRecord last;
+    uint32_t last_slot = newest_sector * JOURNAL_RECORDS_PER_SECTOR;
+    read_slot(last_slot, last);
+    for (uint32_t slot = last_slot + 1; slot < (newest_sector + 1) * JOURNAL_RECORDS_PER_SECTOR; slot++) {
+      if (read_slot(slot, record) && record.sequence > last.sequence) {
+        last = record;
+        last_slot = slot;
+      }
+    }
+    head = (last_slot + 1) % slots();
+    next_sequence = last.sequence + 1;
+    boot_number = last.boot + 1;
+  }
+
+  // Sectors left erased ahead by the last boot, or never used
+  erased_sectors = 0;
+  while (erased_sectors < reserve() && sector_blank((next_sector() + erased_sectors) % sectors)) {
+    erased_sectors++;
+  }
+  return true;
+}
+
+
+void EventJournal::add(const JournalRecord& record) {
+  portENTER_CRITICAL(&lock);
+  if (queued < JOURNAL_QUEUE_SIZE) {
+    queue[(queue_start + queued) % JOURNAL_QUEUE_SIZE] = record;
+    queued++;
+  } else {
+    dropped_records++;
+  }
+  portEXIT_CRITICAL(&lock);
+}
+
+size_t EventJournal::flush() {
+  if (flash == nullptr) {
+    return 0;
+  }
+
+  size_t written = 0;
+  JournalRecord record;
+  while (true) {
+    // Only taken off the queue once written, add() only appends
+    portENTER_CRITICAL(&lock);
+    const bool any = queued > 0;
+    if (any) {
+      record = queue[queue_start];
+    }
+    portEXIT_CRITICAL(&lock);
+    if (!any) {
+      break;
+    }
+
+    record.magic = JOURNAL_MAGIC;
+    record.sequence = next_sequence;
+    record.boot = boot_number;
+    record.crc = record_crc(record);
+    const WriteResult result = write_record(record);
+    if (result == WriteResult::NoErasedSector) {
+      break;  // Waits for erase_ahead()
+    }
+
+    portENTER_CRITICAL(&lock);
+    queue_start = (queue_start + 1) % JOURNAL_QUEUE_SIZE;
+    queued--;
+    portEXIT_CRITICAL(&lock);
+    if (result == WriteResult::Written) {
+      next_sequence++;
+      written++;
+    } else {
+      failed_writes++;
+    }
+  }
+  return written;
+}
+
+bool EventJournal::erase_ahead(uint32_t max_erases) {
+  if (flash == nullptr) {
+    return true;
+  }
+  // The reserve leaves at least the sector written last
+  uint32_t erases = 0;
+  while (erased_sectors < reserve()) {
+    const uint32_t sector = (next_sector() + erased_sectors) % sectors;
+    if (!sector_blank(sector)) {
+      if (erases == max_erases) {
+        break;
+      }
+      if (!flash->erase_sector(sector * JOURNAL_SECTOR_SIZE)) {
+        return false;
+      }
+      erases++;
+    }
+    // The journal came round to the oldest records
+    if (!empty && sector == tail_sector) {
+      tail_sector = (sector + 1) % sectors;
+    }
+    erased_sectors++;
+  }
+  return true;
+}
+
+EventJournal::WriteResult EventJournal::write_record(const JournalRecord& record) {
+  for (int attempt = 0; attempt < JOURNAL_WRITE_ATTEMPTS; attempt++) {
+    const uint32_t slot = head;
+    const bool new_sector = slot % JOURNAL_RECORDS_PER_SECTOR == 0;
+    // Entering a sector, which erase_ahead() must have erased
+    if (new_sector && erased_sectors == 0) {
+      return WriteResult::NoErasedSector;
+    }
+    head = (head + 1) % slots();
+    if (new_sector) {
+      erased_sectors--;
+    } else if (!slot_blank(slot)) {
+      continue;  // Torn by a reset while it was written
+    }
+
+    const uint32_t offset = slot * JOURNAL_RECORD_SIZE;
+    JournalRecord check;
+    if (flash->write(offset, &record, sizeof(record)) && flash->read(offset, &check, sizeof(check)) &&
+        memcmp(&check, &record, sizeof(record)) == 0) {
+      empty = false;
+      return WriteResult::Written;
+    }
+  }
+  return WriteResult::Failed;
+}
+
+EventJournal::Cursor EventJournal::oldest() const {
+  Cursor cursor;
+  if (flash == nullptr || empty) {
+    return cursor;
+  }
+  cursor.slot = tail_sector * JOURNAL_RECORDS_PER_SECTOR;
+  cursor.left = (head + slots() - cursor.slot) % slots();
+  if (cursor.left == 0) {
+    cursor.left = slots();  // Full, the next record erases the oldest sector
+  }
+  return cursor;
+}
+
+bool EventJournal::read(Cursor& cursor, JournalRecord& record) const {
+  while (cursor.left > 0) {
+    const uint32_t slot = cursor.slot;
+    cursor.slot = (cursor.slot + 1) % slots();
+    cursor.left--;
+    if (read_slot(slot, record)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+JournalTextExport::JournalTextExport(const EventJournal& journal) : journal(journal), cursor(journal.oldest()) {}
+
+bool JournalTextExport::next_line() {
+  if (header) {
+    header = false;
+    line_length = snprintf(line, sizeof(line),
+                           "boot,sequence,millis,event,level,data,voltage_dV,current_dA,soc_pptt,cell_min_mV,"
+                           "cell_max_mV\n");
+    line_pos = 0;
+    return true;
+  }
+
+  JournalRecord record;
+  if (!journal.read(cursor, record)) {
+    return false;
+  }
+  // Records of a firmware with other events show the number
+  char event[12];
+  const char* event_name = event;
+  if (record.event < EVENT_NOF_EVENTS) {
+    event_name = get_event_enum_string(static_cast<EVENTS_ENUM_TYPE>(record.event));
+  } else {
+    snprintf(event, sizeof(event), "%u", record.event);
+  }
+  const char* level_name = "";
+  if (record.level <= EVENT_LEVEL_UPDATE) {
+    level_name = get_event_level_string(static_cast<EVENTS_LEVEL_TYPE>(record.level));
+  }
+  const int length = snprintf(line, sizeof(line), "%u,%lu,%llu,%s,%s,%u,%u,%d,%u,%u,%u\n", record.boot,
+                              (unsigned long)record.sequence, (unsigned long long)record.timestamp, event_name,
+                              level_name, record.data, record.voltage_dV, record.current_dA, record.soc_pptt,
+                              record.cell_min_mV, record.cell_max_mV);
+  line_length = std::min<size_t>(length > 0 ? length : 0, sizeof(line) - 1);
+  line_pos = 0;
+  return true;
+}
+
+size_t JournalTextExport::read(uint8_t* buffer, size_t max_length) {
+  size_t written = 0;
+
+  while (written < max_length) {
+    if (line_pos == line_length && !next_line()) {
+      break;
+    }
+    size_t chunk = std::min(line_length - line_pos, max_length - written);
+    memcpy(buffer + written, line + line_pos, chunk);
+    line_pos += chunk;
+    written += chunk;
+  }
+  return written;
+}
+
+#ifndef UNIT_TEST
+class PartitionFlash : public JournalFlash {
+ public:
+  explicit PartitionFlash(const esp_partition_t* partition) : partition(partition) {}
+  uint32_t size() const override { return partition->size; }
+  bool read(uint32_t offset, void* data, size_t length) override {
+    return esp_partition_read(partition, offset, data, length) == ESP_OK;
+  }
+  bool write(uint32_t offset, const void* data, size_t length) override {
+    return esp_partition_write(partition, offset, data, length) == ESP_OK;
+  }
+  bool erase_sector(uint32_t offset) override {
+    return esp_partition_erase_range(partition, offset, JOURNAL_SECTOR_SIZE) == ESP_OK;
+  }
+
+ private:
+  const esp_partition_t* partition;
+};
+
+void init_event_journal() {
+  const esp_partition_t* partition =
+      esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_DATA_SPIFFS, NULL);
+  if (partition == nullptr) {
+    logging.println("No partition for the event journal");
+    return;
+  }
+  static PartitionFlash partition_flash(partition);
+  if (!event_journal.begin(&partition_flash)) {
+    logging.println("Event journal partition too small");
+    return;
+  }
+  logging.printf("Event journal opened, boot %u\n", event_journal.boot());
+}
+#endif
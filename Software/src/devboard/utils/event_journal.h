@@ -0,0 +1,151 @@
+#ifndef __EVENT_JOURNAL_H__
+#define __EVENT_JOURNAL_H__
+
+#include <stddef.h>
+#include <stdint.h>
+#include <algorithm>
+#include "freertos/FreeRTOS.h"
+
+/* Journal of event occurrences kept in flash, so that what led up to a reset can still be read after it.
+ *
+ * The journal is a ring of fixed size records over the sectors of a flash partition. The sectors are used in
+ * turn and a sector is erased only when the journal comes round to it again, which spreads the erases evenly.
+ * Each record carries a CRC. A record torn by a reset while it was written fails the check and is skipped, the
+ * slot is not written again until its sector is erased.
+ *
+ * At startup begin() looks at the first record of each sector to find the one written last, and then only
+ * reads that sector. Records are queued by add() from any task, including the core task, and written by
+ * flush() from a low priority task.
+ *
+ * While the flash is written or erased the cache is disabled on both CPUs, so every task running from flash
+ * stalls, wherever the writing task runs. Writing a record takes about a millisecond. Erasing a sector takes
+ * tens of ms, up to a few hundred, so flush() never erases: erase_ahead() keeps the next sectors erased, and is
+ * called at a moment chosen for it. Records arriving when no erased sector is left wait in the queue, and are
+ * dropped once it is full.
+ *
+ * Most of the ring is kept erased, all but 1/JOURNAL_KEPT_FRACTION of the sectors, so that a long time without a
+ * moment to erase can still be recorded. The records of the erased sectors are lost, the journal then holds the
+ * kept sectors and what was written since.
+ */
+
+#define JOURNAL_SECTOR_SIZE 4096
+#define JOURNAL_RECORD_SIZE 32
+#define JOURNAL_RECORDS_PER_SECTOR (JOURNAL_SECTOR_SIZE / JOURNAL_RECORD_SIZE)
+#define JOURNAL_MAX_SECTORS 32    // Caps the time begin() takes on large partitions
+#define JOURNAL_QUEUE_SIZE 16     // Records waiting for flush(), further ones are dropped
+#define JOURNAL_WRITE_ATTEMPTS 4  // Slots tried for one record before giving up on it
+#define JOURNAL_KEPT_FRACTION 4   // 1 in this many sectors keeps its records when the others are erased ahead
+#define JOURNAL_MAGIC 0xA7
+#define JOURNAL_TEXT_LINE 128
+
+struct __attribute__((packed)) JournalRecord {
+  uint8_t magic;
+  uint8_t event;  // EVENTS_ENUM_TYPE of the firmware that wrote the record
+  uint8_t data;
+  uint8_t level;
+  uint32_t sequence;   // Counts up over all boots, set by flush()
+  uint64_t timestamp;  // millis64() within the boot
+  uint16_t boot;       // Counts up with each startup, set by flush()
+  // Battery when the event was set
+  uint16_t voltage_dV;
+  int16_t current_dA;
+  uint16_t soc_pptt;
+  uint16_t cell_min_mV;
+  uint16_t cell_max_mV;
+  uint32_t crc;  // CRC-32 of the bytes above
+};
+static_assert(sizeof(JournalRecord) == JOURNAL_RECORD_SIZE, "Records must fill the sectors exactly");
+
+// Storage of the journal, offsets are from the start of the partition. Erased bytes read as 0xFF.
+class JournalFlash {
+ public:
+  virtual ~JournalFlash() = default;
+  virtual uint32_t size() const = 0;
+  virtual bool read(uint32_t offset, void* data, size_t length) = 0;
+  virtual bool write(uint32_t offset, const void* data, size_t length) = 0;
+  virtual bool erase_sector(uint32_t offset) = 0;
+};
+
+class EventJournal {
+ public:
+  struct Cursor {
+    uint32_t slot = 0;
+    uint32_t left = 0;  // Slots still to look at
+  };
+
+  // Finds the end of the journal. Returns false if the flash is too small to hold one.
+  bool begin(JournalFlash* journal_flash);
+  bool ready() const { return flash != nullptr; }
+
+  // Queues a record, the sequence, boot and CRC are filled in when it is written
+  void add(const JournalRecord& record);
+  // Writes the queued records, as far as there are erased slots for them. Returns the number written.
+  size_t flush();
+  // Erases the sectors the next records go to, until reserve() of them are erased or max_erases sectors have
+  // been erased by this call. Erasing the oldest sector drops its records. Returns false if an erase failed.
+  bool erase_ahead(uint32_t max_erases = UINT32_MAX);
+  // Sectors ready for the next records
+  uint32_t erased() const { return erased_sectors; }
+  // Sectors erase_ahead() keeps erased, the others hold the newest records
+  uint32_t reserve() const { return sectors - std::max<uint32_t>(sectors / JOURNAL_KEPT_FRACTION, 1); }
+
+  uint16_t boot() const { return boot_number; }
+  uint32_t dropped() const { return dropped_records; }
+  uint32_t failed() const { return failed_writes; }
+
+  // Reading, oldest record first. The records flushed while reading may or may not be included.
+  Cursor oldest() const;
+  bool read(Cursor& cursor, JournalRecord& record) const;
+
+ private:
+  JournalFlash* flash = nullptr;
+  uint32_t sectors = 0;
+  uint32_t head = 0;  // Slot the next record goes to
+  uint32_t tail_sector = 0;
+  uint32_t erased_sectors = 0;  // Erased sectors from next_sector() on
+  bool empty = true;
+  uint32_t next_sequence = 0;
+  uint16_t boot_number = 0;
+
+  JournalRecord queue[JOURNAL_QUEUE_SIZE];
+  uint8_t queue_start = 0;
+  uint8_t queued = 0;
+  uint32_t dropped_records = 0;
+  uint32_t failed_writes = 0;
+  portMUX_TYPE lock = portMUX_INITIALIZER_UNLOCKED;
+
+  enum class WriteResult { Written, Failed, NoErasedSector };
+
+  uint32_t slots() const { return sectors * JOURNAL_RECORDS_PER_SECTOR; }
+  // Sector the head enters next, the one it is at the start of or the one after
+  uint32_t next_sector() const;
+  bool read_slot(uint32_t slot, JournalRecord& record) const;
+  bool slot_blank(uint32_t slot) const;
+  bool sector_blank(uint32_t sector) const;
+  WriteResult write_record(const JournalRecord& record);
+};
+
+// Streams the journal as CSV, for chunked webserver responses
+class JournalTextExport {
+ public:
+  explicit JournalTextExport(const EventJournal& journal);
+  // Fill buffer with up to max_length bytes of text. Returns 0 when the end of the journal has been reached.
+  size_t read(uint8_t* buffer, size_t max_length);
+
+ private:
+  const EventJournal& journal;
+  EventJournal::Cursor cursor;
+  bool header = true;
+  char line[JOURNAL_TEXT_LINE];
+  size_t line_length = 0;
+  size_t line_pos = 0;
+
+  bool next_line();
+};
+
+extern EventJournal event_journal;
+
+// Opens the journal on the data partition of type spiffs, which the firmware has no file system on
+void init_event_journal();
+
+#endif
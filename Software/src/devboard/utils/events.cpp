@@ -1,24 +1,56 @@
 #include "events.h"
 #include <Arduino.h>
+#include <string.h>
 #include "../../datalayer/datalayer.h"
 #include "../../devboard/hal/hal.h"
 #include "../../devboard/utils/logging.h"
+#include "event_journal.h"
+#include "freertos/FreeRTOS.h"
+#include "log_ring.h"
+
+// The links below are event numbers, with EVENT_NOF_EVENTS for none
+static_assert(EVENT_NOF_EVENTS < 256, "Event numbers must fit a byte");
+#define NO_EVENT EVENT_NOF_EVENTS
 
 typedef struct {
   EVENTS_STRUCT_TYPE entries[EVENT_NOF_EVENTS];
   EVENTS_LEVEL_TYPE level;
+  // Number of active events of each level, the level is the highest one with any
+  uint8_t active_per_level[EVENT_LEVEL_UPDATE + 1];
+  // Events that occurred, as a list ordered by timestamp
+  uint8_t newer[EVENT_NOF_EVENTS];
+  uint8_t older[EVENT_NOF_EVENTS];
+  uint8_t newest;
+  uint8_t oldest;
 } EVENT_TYPE;
 
+// An occurrence as stored in the history ring
+struct __attribute__((packed)) EventHistoryRecord {
+  uint64_t timestamp;
+  uint8_t event;
+  uint8_t data;
+};
+
 /* Local variables */
 static EVENT_TYPE events;
 static const char* EVENTS_ENUM_TYPE_STRING[] = {EVENTS_ENUM_TYPE(GENERATE_STRING)};
 static const char* EVENTS_LEVEL_TYPE_STRING[] = {EVENTS_LEVEL_TYPE(GENERATE_STRING)};
 static const char* EMULATOR_STATUS_STRING[] = {EMULATOR_STATUS(GENERATE_STRING)};
+static LogRing<EVENT_HISTORY_SIZE> history;
+/* Events are set and cleared by the core task and the connectivity tasks. The states, the counts per level, the
+ * list and the history only change together under this lock, and readers of the list take a copy under it.
+ */
+static portMUX_TYPE events_lock = portMUX_INITIALIZER_UNLOCKED;
 
 /* Local function prototypes */
 static void set_event(EVENTS_ENUM_TYPE event, uint8_t data, bool latched);
 static void update_event_level(void);
 static void update_bms_status(void);
+static bool is_active(EVENTS_STATE_TYPE state);
+static void set_state(EVENTS_ENUM_TYPE event, EVENTS_STATE_TYPE state);
+static void recount_active_events(void);
+static void unlink_event(EVENTS_ENUM_TYPE event);
+static void clear_event_list(void);
 
 /* Initialization function */
 void init_events(void) {
@@ -135,6 +167,11 @@ void init_events(void) {
   events.entries[EVENT_GPIO_CONFLICT].level = EVENT_LEVEL_ERROR;
   events.entries[EVENT_GPIO_NOT_DEFINED].level = EVENT_LEVEL_ERROR;
   events.entries[EVENT_BATTERY_TEMP_DEVIATION_HIGH].level = EVENT_LEVEL_WARNING;
+
+  portENTER_CRITICAL(&events_lock);
+  clear_event_list();
+  recount_active_events();
+  portEXIT_CRITICAL(&events_lock);
 }
 
 void set_event(EVENTS_ENUM_TYPE event, uint8_t data) {
@@ -146,14 +183,17 @@ void set_event_latched(EVENTS_ENUM_TYPE event, uint8_t data) {
 }
 
 void clear_event(EVENTS_ENUM_TYPE event) {
+  portENTER_CRITICAL(&events_lock);
   if (events.entries[event].state == EVENT_STATE_ACTIVE) {
-    events.entries[event].state = EVENT_STATE_INACTIVE;
+    set_state(event, EVENT_STATE_INACTIVE);
     update_event_level();
     update_bms_status();
   }
+  portEXIT_CRITICAL(&events_lock);
 }
 
 void reset_all_events() {
+  portENTER_CRITICAL(&events_lock);
   for (uint16_t i = 0; i < EVENT_NOF_EVENTS; i++) {
     events.entries[i].data = 0;
     events.entries[i].state = EVENT_STATE_INACTIVE;
@@ -161,12 +201,16 @@ void reset_all_events() {
     events.entries[i].occurences = 0;
     events.entries[i].MQTTpublished = false;  // Not published by default
   }
-  events.level = EVENT_LEVEL_INFO;
+  clear_event_list();
+  recount_active_events();
   update_bms_status();
+  portEXIT_CRITICAL(&events_lock);
 }
 
 void set_event_MQTTpublished(EVENTS_ENUM_TYPE event) {
+  portENTER_CRITICAL(&events_lock);
   events.entries[event].MQTTpublished = true;
+  portEXIT_CRITICAL(&events_lock);
 }
 
 String get_event_message_string(EVENTS_ENUM_TYPE event) {
@@ -407,14 +451,48 @@ const char* get_event_level_string(EVENTS_ENUM_TYPE event) {
 }
 
 const char* get_event_level_string(EVENTS_LEVEL_TYPE event_level) {
-  // Return the event level but skip "EVENT_LEVEL_TYPE_" that should always be first
-  return EVENTS_LEVEL_TYPE_STRING[event_level] + 17;
+  // Return the event level but skip "EVENT_LEVEL_" that should always be first
+  return EVENTS_LEVEL_TYPE_STRING[event_level] + 12;
 }
 
 const EVENTS_STRUCT_TYPE* get_event_pointer(EVENTS_ENUM_TYPE event) {
   return &events.entries[event];
 }
 
+size_t get_events_newest_first(EVENTS_ENUM_TYPE* out, size_t max) {
+  size_t count = 0;
+  portENTER_CRITICAL(&events_lock);
+  for (uint8_t event = events.newest; event != NO_EVENT && count < max; event = events.older[event]) {
+    out[count++] = (EVENTS_ENUM_TYPE)event;
+  }
+  portEXIT_CRITICAL(&events_lock);
+  return count;
+}
+
+size_t get_event_history(uint32_t since, EVENT_OCCURRENCE_TYPE* out, size_t max, uint32_t& next) {
+  auto cursor = history.oldest();
+  EventHistoryRecord record;
+  size_t length;
+  uint32_t sequence;
+  size_t count = 0;
+  next = history.end_sequence();
+  if (since > next) {
+    since = 0;  // Asked by a page loaded before a reboot, start over
+  }
+  while (count < max && history.read(cursor, &record, sizeof(record), length, sequence)) {
+    if (sequence < since || length != sizeof(record)) {
+      continue;
+    }
+    out[count].sequence = sequence;
+    out[count].timestamp = record.timestamp;
+    out[count].event = (EVENTS_ENUM_TYPE)record.event;
+    out[count].data = record.data;
+    count++;
+    next = sequence + 1;
+  }
+  return count;
+}
+
 EVENTS_LEVEL_TYPE get_event_level(void) {
   return events.level;
 }
@@ -448,25 +526,62 @@ static void set_event(EVENTS_ENUM_TYPE event, uint8_t data, bool latched) {
     event = EVENT_UNKNOWN_EVENT_SET;
   }
 
-  // If the event is already set, no reason to continue
-  if ((events.entries[event].state != EVENT_STATE_ACTIVE) &&
-      (events.entries[event].state != EVENT_STATE_ACTIVE_LATCHED)) {
-    events.entries[event].occurences++;
+  const uint64_t timestamp = millis64();
+
+  portENTER_CRITICAL(&events_lock);
+  // If the event is already set, it is not a new occurrence
+  const bool occurred = !is_active(events.entries[event].state);
+  if (occurred) {
+    if (events.entries[event].occurences < UINT16_MAX) {
+      events.entries[event].occurences++;
+    }
     events.entries[event].MQTTpublished = false;
 
-    DEBUG_PRINTF("Event: %s\n", get_event_message_string(event).c_str());
+    const EventHistoryRecord record = {timestamp, (uint8_t)event, data};
+    history.append(&record, sizeof(record));
   }
 
   // We should set the event, update event info
-  events.entries[event].timestamp = millis64();
+  events.entries[event].timestamp = timestamp;
   events.entries[event].data = data;
   // Check if the event is latching
-  events.entries[event].state = latched ? EVENT_STATE_ACTIVE_LATCHED : EVENT_STATE_ACTIVE;
+  set_state(event, latched ? EVENT_STATE_ACTIVE_LATCHED : EVENT_STATE_ACTIVE);
 
-  // Update event level, only upwards. Downward changes are done in Software.ino:loop()
+  // Latest timestamp, so the event goes first in the list
+  if (events.newest != event) {
+    unlink_event(event);
+    events.older[event] = events.newest;
+    events.newer[event] = NO_EVENT;
+    if (events.newest != NO_EVENT) {
+      events.newer[events.newest] = event;
+    } else {
+      events.oldest = event;
+    }
+    events.newest = event;
+  }
+
+  // Update event level, only upwards
   events.level = (EVENTS_LEVEL_TYPE)max(events.level, events.entries[event].level);
 
   update_bms_status();
+  const EVENTS_LEVEL_TYPE level = events.entries[event].level;
+  portEXIT_CRITICAL(&events_lock);
+
+  if (occurred) {
+    JournalRecord journal_record = {};
+    journal_record.event = event;
+    journal_record.data = data;
+    journal_record.level = level;
+    journal_record.timestamp = timestamp;
+    journal_record.voltage_dV = datalayer.battery.status.voltage_dV;
+    journal_record.current_dA = datalayer.battery.status.current_dA;
+    journal_record.soc_pptt = datalayer.battery.status.real_soc;
+    journal_record.cell_min_mV = datalayer.battery.status.cell_min_voltage_mV;
+    journal_record.cell_max_mV = datalayer.battery.status.cell_max_voltage_mV;
+    event_journal.add(journal_record);
+
+    DEBUG_PRINTF("Event: %s\n", get_event_message_string(event).c_str());
+  }
 }
 
 static void update_bms_status(void) {
@@ -487,22 +602,67 @@ static void update_bms_status(void) {
   }
 }
 
-// Function to compare events by timestamp descending
-bool compareEventsByTimestampDesc(const EventData& a, const EventData& b) {
-  return a.event_pointer->timestamp > b.event_pointer->timestamp;
+static bool is_active(EVENTS_STATE_TYPE state) {
+  return (state == EVENT_STATE_ACTIVE) || (state == EVENT_STATE_ACTIVE_LATCHED);
+}
+
+// Changes the state of an event and keeps the count of active events per level
+static void set_state(EVENTS_ENUM_TYPE event, EVENTS_STATE_TYPE state) {
+  const bool was_active = is_active(events.entries[event].state);
+  events.entries[event].state = state;
+  if (is_active(state) && !was_active) {
+    events.active_per_level[events.entries[event].level]++;
+  } else if (!is_active(state) && was_active) {
+    events.active_per_level[events.entries[event].level]--;
+  }
 }
 
-// Function to compare events by timestamp ascending
-bool compareEventsByTimestampAsc(const EventData& a, const EventData& b) {
-  return a.event_pointer->timestamp < b.event_pointer->timestamp;
+// After the levels or states were set directly
+static void recount_active_events(void) {
+  memset(events.active_per_level, 0, sizeof(events.active_per_level));
+  for (uint8_t i = 0u; i < EVENT_NOF_EVENTS; i++) {
+    if (is_active(events.entries[i].state)) {
+      events.active_per_level[events.entries[i].level]++;
+    }
+  }
+  update_event_level();
 }
 
 static void update_event_level(void) {
   EVENTS_LEVEL_TYPE temporary_level = EVENT_LEVEL_INFO;
-  for (uint8_t i = 0u; i < EVENT_NOF_EVENTS; i++) {
-    if ((events.entries[i].state == EVENT_STATE_ACTIVE) || (events.entries[i].state == EVENT_STATE_ACTIVE_LATCHED)) {
-      temporary_level = (EVENTS_LEVEL_TYPE)max(events.entries[i].level, temporary_level);
+  for (int level = EVENT_LEVEL_UPDATE; level > EVENT_LEVEL_INFO; level--) {
+    if (events.active_per_level[level] > 0) {
+      temporary_level = (EVENTS_LEVEL_TYPE)level;
+      break;
     }
   }
   events.level = temporary_level;
 }
+
+static void unlink_event(EVENTS_ENUM_TYPE event) {
+  const uint8_t newer = events.newer[event];
+  const uint8_t older = events.older[event];
+  if (newer != NO_EVENT) {
+    events.older[newer] = older;
+  } else if (events.newest == event) {
+    events.newest = older;
+  }
+  if (older != NO_EVENT) {
+    events.newer[older] = newer;
+  } else if (events.oldest == event) {
+    events.oldest = newer;
+  }
+  events.newer[event] = NO_EVENT;
+  events.older[event] = NO_EVENT;
+}
+
+// Forgets the order of the events and their history, with events_lock held
+static void clear_event_list(void) {
+  for (uint8_t i = 0u; i < EVENT_NOF_EVENTS; i++) {
+    events.newer[i] = NO_EVENT;
+    events.older[i] = NO_EVENT;
+  }
+  events.newest = NO_EVENT;
+  events.oldest = NO_EVENT;
+  history.clear();
+}
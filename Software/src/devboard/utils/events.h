@@ -2,6 +2,7 @@
 #define __EVENTS_H__
 
 #include <WString.h>
+#include <stddef.h>
 #include <stdint.h>
 #include "millis64.h"
 #include "types.h"
@@ -150,17 +151,22 @@ typedef enum {
 typedef struct {
   uint64_t timestamp;
   uint8_t data;             // Custom data passed when setting the event, for example cell number for under voltage
-  uint8_t occurences;       // Number of occurrences since startup
+  uint16_t occurences;      // Number of occurrences since startup, stops at the maximum
   EVENTS_LEVEL_TYPE level;  // Event level, i.e. ERROR/WARNING...
   EVENTS_STATE_TYPE state;  // Event state, i.e. ACTIVE/INACTIVE...
   bool MQTTpublished;
 } EVENTS_STRUCT_TYPE;
 
-// Define a struct to hold event data
-struct EventData {
-  EVENTS_ENUM_TYPE event_handle;
-  const EVENTS_STRUCT_TYPE* event_pointer;
-};
+// One occurrence of an event, see get_event_history()
+typedef struct {
+  uint32_t sequence;  // Counts up with each occurrence since startup
+  uint64_t timestamp;
+  EVENTS_ENUM_TYPE event;
+  uint8_t data;
+} EVENT_OCCURRENCE_TYPE;
+
+// Bytes kept for the history of occurrences, about 20 bytes each
+#define EVENT_HISTORY_SIZE 2048
 
 const char* get_event_enum_string(EVENTS_ENUM_TYPE event);
 String get_event_message_string(EVENTS_ENUM_TYPE event);
@@ -180,7 +186,15 @@ void set_event_MQTTpublished(EVENTS_ENUM_TYPE event);
 
 const EVENTS_STRUCT_TYPE* get_event_pointer(EVENTS_ENUM_TYPE event);
 
-bool compareEventsByTimestampAsc(const EventData& a, const EventData& b);
-bool compareEventsByTimestampDesc(const EventData& a, const EventData& b);
+/* Copies the events that occurred since startup into out, ordered by the time they were last set, newest first,
+ * at most max of them. Returns the number copied. The list changes as other tasks set events, so it is only read
+ * as a copy.
+ */
+size_t get_events_newest_first(EVENTS_ENUM_TYPE* out, size_t max);
+
+/* Copies the occurrences numbered since onwards into out, oldest first, at most max of them. The oldest ones are
+ * dropped when the history is full. Returns the number copied, next gets the number to ask for next time.
+ */
+size_t get_event_history(uint32_t since, EVENT_OCCURRENCE_TYPE* out, size_t max, uint32_t& next);
 
 #endif  // __MYTIMER_H__
@@ -0,0 +1,193 @@
+#include "json_writer.h"
+
+#include <math.h>
+
+JsonWriter::JsonWriter(char* buffer, size_t size) : buffer(buffer), size(size) {
+  reset();
+}
+
+void JsonWriter::reset() {
+  used = 0;
+  overflow = size == 0;
+  needs_comma = false;
+  if (size > 0) {
+    buffer[0] = '\0';
+  }
+}
+
+void JsonWriter::put(char c) {
+  if (overflow) {
+    return;
+  }
+  if (used + 1 >= size) {
+    overflow = true;
+    return;
+  }
+  buffer[used++] = c;
+  buffer[used] = '\0';
+}
+
+void JsonWriter::put(const char* text) {
+  while (*text) {
+    put(*text++);
+  }
+}
+
+void JsonWriter::put_escaped(const char* text) {
+  static const char hex[] = "0123456789abcdef";
+  put('"');
+  for (; *text; text++) {
+    const unsigned char c = *text;
+    if (c == '"' || c == '\\') {
+      put('\\');
+      put(c);
+    } else if (c == '\n') {
+      put("\\n");
+    } else if (c < 0x20) {
+      put("\\u00");
+      put(hex[c >> 4]);
+      put(hex[c & 0x0F]);
+    } else {
+      put(c);
+    }
+  }
+  put('"');
+}
+
+void JsonWriter::put_unsigned(uint32_t value) {
+  char digits[10];
+  int count = 0;
+  do {
+    digits[count++] = '0' + value % 10;
+    value /= 10;
+  } while (value > 0);
+  while (count > 0) {
+    put(digits[--count]);
+  }
+}
+
+void JsonWriter::put_fixed(int32_t value, uint8_t decimals) {
+  uint32_t magnitude = value < 0 ? 0 - (uint32_t)value : (uint32_t)value;
+  if (value < 0) {
+    put('-');
+  }
+  uint32_t scale = 1;
+  for (uint8_t i = 0; i < decimals; i++) {
+    scale *= 10;
+  }
+  put_unsigned(magnitude / scale);
+  uint32_t fraction = magnitude % scale;
+  if (fraction == 0) {
+    return;
+  }
+  // Trailing zeros of the fraction are dropped, leading ones kept
+  uint8_t digits = decimals;
+  while (fraction % 10 == 0) {
+    fraction /= 10;
+    digits--;
+  }
+  char text[10];
+  for (int i = digits - 1; i >= 0; i--) {
+    text[i] = '0' + fraction % 10;
+    fraction /= 10;
+  }
+  put('.');
+  for (uint8_t i = 0; i < digits; i++) {
+    put(text[i]);
+  }
+}
+
+void JsonWriter::start_value(const char* key, const char* suffix) {
+  if (needs_comma) {
+    put(',');
+  }
+  needs_comma = true;
+  if (key != nullptr) {
+    put('"');
+    put(key);
+    if (suffix != nullptr) {
+      put(suffix);
+    }
+    put("\":");
+  }
+}
+
+void JsonWriter::begin_object(const char* key, const char* suffix) {
+  start_value(key, suffix);
+  put('{');
+  needs_comma = false;
+}
+
+void JsonWriter::end_object() {
+  put('}');
+  needs_comma = true;
+}
+
+void JsonWriter::begin_array(const char* key, const char* suffix) {
+  start_value(key, suffix);
+  put('[');
+  needs_comma = false;
+}
+
+void JsonWriter::end_array() {
+  put(']');
+  needs_comma = true;
+}
+
+void JsonWriter::add(const char* key, const char* suffix, int32_t value) {
+  start_value(key, suffix);
+  put_fixed(value, 0);
+}
+
+void JsonWriter::add_unsigned(const char* key, const char* suffix, uint32_t value) {
+  start_value(key, suffix);
+  put_unsigned(value);
+}
+
+void JsonWriter::add_fixed(const char* key, const char* suffix, int32_t value, uint8_t decimals) {
+  start_value(key, suffix);
+  put_fixed(value, decimals);
+}
+
+void JsonWriter::add_float(const char* key, const char* suffix, float value, uint8_t decimals) {
+  start_value(key, suffix);
+  if (isnan(value) || isinf(value)) {
+    put("null");  // Not representable in JSON
+    return;
+  }
+  int32_t scale = 1;
+  for (uint8_t i = 0; i < decimals; i++) {
+    scale *= 10;
+  }
+  put_fixed((int32_t)lroundf(value * scale), decimals);
+}
+
+void JsonWriter::add_bool(const char* key, const char* suffix, bool value) {
+  start_value(key, suffix);
+  put(value ? "true" : "false");
+}
+
+void JsonWriter::add_string(const char* key, const char* suffix, const char* value) {
+  start_value(key, suffix);
+  put_escaped(value);
+}
+
+void JsonWriter::element(int32_t value) {
+  start_value(nullptr, nullptr);
+  put_fixed(value, 0);
+}
+
+void JsonWriter::element_fixed(int32_t value, uint8_t decimals) {
+  start_value(nullptr, nullptr);
+  put_fixed(value, decimals);
+}
+
+void JsonWriter::element_bool(bool value) {
+  start_value(nullptr, nullptr);
+  put(value ? "true" : "false");
+}
+
+void JsonWriter::element_string(const char* value) {
+  start_value(nullptr, nullptr);
+  put_escaped(value);
+}
@@ -0,0 +1,65 @@
+#ifndef __JSON_WRITER_H__
+#define __JSON_WRITER_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* Writes JSON straight into a caller provided buffer, without building a document or allocating. Keys are given as
+ * a name and a suffix (e.g. "SOC" and "_2") so they need no concatenation. Values in datalayer units are written as
+ * fixed point numbers, e.g. add_fixed("voltage", 3712, 3) gives "voltage":3.712.
+ *
+ * If the buffer runs out the writer stops writing and overflowed() is set, the text is then incomplete and must not
+ * be used. The text is always zero terminated.
+ */
+class JsonWriter {
+ public:
+  JsonWriter(char* buffer, size_t size);
+
+  // Start over with an empty buffer
+  void reset();
+
+  void begin_object(const char* key = nullptr, const char* suffix = nullptr);
+  void end_object();
+  void begin_array(const char* key = nullptr, const char* suffix = nullptr);
+  void end_array();
+
+  void add(const char* key, const char* suffix, int32_t value);
+  void add(const char* key, int32_t value) { add(key, nullptr, value); }
+  void add_unsigned(const char* key, const char* suffix, uint32_t value);
+  void add_unsigned(const char* key, uint32_t value) { add_unsigned(key, nullptr, value); }
+  // value / 10^decimals, without trailing zeros
+  void add_fixed(const char* key, const char* suffix, int32_t value, uint8_t decimals);
+  void add_fixed(const char* key, int32_t value, uint8_t decimals) { add_fixed(key, nullptr, value, decimals); }
+  void add_float(const char* key, const char* suffix, float value, uint8_t decimals);
+  void add_bool(const char* key, const char* suffix, bool value);
+  void add_bool(const char* key, bool value) { add_bool(key, nullptr, value); }
+  void add_string(const char* key, const char* suffix, const char* value);
+  void add_string(const char* key, const char* value) { add_string(key, nullptr, value); }
+
+  // Array elements
+  void element(int32_t value);
+  void element_fixed(int32_t value, uint8_t decimals);
+  void element_bool(bool value);
+  void element_string(const char* value);
+
+  const char* c_str() const { return buffer; }
+  size_t length() const { return used; }
+  bool overflowed() const { return overflow; }
+
+ private:
+  char* buffer;
+  size_t size;
+  size_t used = 0;
+  bool overflow = false;
+  // A value was written at the current nesting level, the next one needs a comma
+  bool needs_comma = false;
+
+  void put(char c);
+  void put(const char* text);
+  void put_escaped(const char* text);
+  void put_fixed(int32_t value, uint8_t decimals);
+  void put_unsigned(uint32_t value);
+  void start_value(const char* key, const char* suffix);
+};
+
+#endif
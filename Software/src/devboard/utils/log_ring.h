@@ -0,0 +1,136 @@
+#ifndef __LOG_RING_H__
+#define __LOG_RING_H__
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <algorithm>
+#include <atomic>
+
+/* Ring of variable length records for the webserver logs. New records overwrite the oldest ones, and each
+ * record gets a sequence number, so that a reader can continue where it stopped ("since sequence N") and knows
+ * how many records it missed.
+ *
+ * One writer at a time: if several tasks append, they have to serialize the calls to append() and clear().
+ * Readers do not lock and never hold up the writer. A reader copies a record and then checks that the writer
+ * did not start overwriting it meanwhile, if it did the reader skips ahead to the oldest record still present.
+ * Any number of readers can follow the ring, each with its own cursor.
+ *
+ * A record takes a two word header (sequence number, length) followed by the payload rounded up to 32 bits.
+ * The ring is stored as relaxed atomic words, which makes reading it while it is written well defined.
+ */
+template <size_t SIZE_BYTES>
+class LogRing {
+  static_assert(SIZE_BYTES % 4 == 0 && (SIZE_BYTES & (SIZE_BYTES - 1)) == 0, "Ring size must be a power of two");
+
+ public:
+  static constexpr size_t HEADER_WORDS = 2;
+  // Largest payload of a single record
+  static constexpr size_t MAX_RECORD = SIZE_BYTES / 4;
+
+  struct Cursor {
+    uint32_t position = 0;  // In words since the ring was created
+    uint32_t sequence = 0;  // Sequence number expected next
+  };
+
+  // Append a record, returns its sequence number. Payloads longer than MAX_RECORD are cut.
+  uint32_t append(const void* data, size_t length) {
+    length = std::min(length, MAX_RECORD);
+    const uint32_t words = HEADER_WORDS + (length + 3) / 4;
+    uint32_t head_position = head.load(std::memory_order_relaxed);
+    uint32_t tail_position = tail.load(std::memory_order_relaxed);
+
+    // Drop the oldest records until the new one fits, and tell readers before overwriting them
+    if (head_position + words - tail_position > WORDS) {
+      do {
+        tail_position += record_words(ring[(tail_position + 1) & MASK].load(std::memory_order_relaxed));
+      } while (head_position + words - tail_position > WORDS);
+      tail.store(tail_position, std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_release);
+    }
+
+    const uint32_t sequence = next_sequence.load(std::memory_order_relaxed);
+    ring[head_position & MASK].store(sequence, std::memory_order_relaxed);
+    ring[(head_position + 1) & MASK].store(length, std::memory_order_relaxed);
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    for (size_t offset = 0; offset < length; offset += 4) {
+      uint32_t word = 0;
+      memcpy(&word, bytes + offset, std::min<size_t>(4, length - offset));
+      ring[(head_position + HEADER_WORDS + offset / 4) & MASK].store(word, std::memory_order_relaxed);
+    }
+
+    head.store(head_position + words, std::memory_order_release);
+    // After head, so a reader that sees this sequence number also finds the record
+    next_sequence.store(sequence + 1, std::memory_order_release);
+    return sequence;
+  }
+
+  // Drop all records. Like append(), only one task at a time.
+  void clear() {
+    const uint32_t head_position = head.load(std::memory_order_relaxed);
+    tail.store(head_position, std::memory_order_release);
+  }
+
+  // Cursor at the oldest record
+  Cursor oldest() const {
+    Cursor cursor;
+    cursor.position = tail.load(std::memory_order_acquire);
+    cursor.sequence = 0;
+    return cursor;
+  }
+
+  // Sequence number the next record will get
+  uint32_t end_sequence() const { return next_sequence.load(std::memory_order_acquire); }
+
+  /* Copy the record at cursor into out and advance the cursor. Returns false if there is no newer record.
+   * The payload is cut to out_size, length gets the full length. sequence gets the number of the record, which
+   * is above cursor.sequence if records were overwritten before the reader got to them.
+   */
+  bool read(Cursor& cursor, void* out, size_t out_size, size_t& length, uint32_t& sequence) const {
+    while (true) {
+      const uint32_t head_position = head.load(std::memory_order_acquire);
+      if (cursor.position == head_position) {
+        return false;
+      }
+      const uint32_t tail_position = tail.load(std::memory_order_acquire);
+      if ((int32_t)(cursor.position - tail_position) < 0 || (int32_t)(head_position - cursor.position) < 0) {
+        cursor.position = tail_position;  // Overwritten, or the ring was cleared
+        continue;
+      }
+
+      sequence = ring[cursor.position & MASK].load(std::memory_order_relaxed);
+      length = ring[(cursor.position + 1) & MASK].load(std::memory_order_relaxed);
+      if (length > MAX_RECORD) {
+        length = 0;  // Overwritten while reading the header, checked below
+      }
+      const size_t copy = std::min(length, out_size);
+      uint8_t* bytes = static_cast<uint8_t*>(out);
+      for (size_t offset = 0; offset < copy; offset += 4) {
+        const uint32_t word =
+            ring[(cursor.position + HEADER_WORDS + offset / 4) & MASK].load(std::memory_order_relaxed);
+        memcpy(bytes + offset, &word, std::min<size_t>(4, copy - offset));
+      }
+
+      std::atomic_thread_fence(std::memory_order_acquire);
+      if ((int32_t)(cursor.position - tail.load(std::memory_order_relaxed)) < 0) {
+        continue;  // The writer got to this record while it was copied
+      }
+      cursor.position += record_words(length);
+      cursor.sequence = sequence + 1;
+      return true;
+    }
+  }
+
+ private:
+  static constexpr uint32_t WORDS = SIZE_BYTES / 4;
+  static constexpr uint32_t MASK = WORDS - 1;
+
+  static uint32_t record_words(uint32_t length) { return HEADER_WORDS + (length + 3) / 4; }
+
+  std::atomic<uint32_t> ring[WORDS] = {};
+  std::atomic<uint32_t> head{0};
+  std::atomic<uint32_t> tail{0};
+  std::atomic<uint32_t> next_sequence{0};
+};
+
+#endif
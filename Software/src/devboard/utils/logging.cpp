@@ -1,44 +1,27 @@
 #include "logging.h"
 #include "../../datalayer/datalayer.h"
 #include "../sdcard/sdcard.h"
+#include "web_log.h"
 
 #define MAX_LINE_LENGTH_PRINTF 128
 #define MAX_LENGTH_TIME_STR 14
 
 bool previous_message_was_newline = true;
 
-void Logging::add_timestamp(size_t size) {
+void Logging::add_timestamp() {
   // Check if any logging is enabled at runtime
   if (!datalayer.system.info.web_logging_active && !datalayer.system.info.usb_logging_active) {
     return;
   }
 
-  int offset = datalayer.system.info.logged_can_messages_offset;  // Keeps track of the current position in the buffer
-  size_t message_string_size = sizeof(datalayer.system.info.logged_can_messages);
   unsigned long currentTime = millis();
-  char* timestr;
-  static char timestr_buffer[MAX_LENGTH_TIME_STR];
+  char timestr[MAX_LENGTH_TIME_STR];
 
-  if (datalayer.system.info.web_logging_active) {
-    if (!datalayer.system.info.can_logging_active) {
-      /* If web debug is active and can logging is inactive, 
-       * we use the debug logging memory directly for writing the timestring */
-      if (offset + size + MAX_LENGTH_TIME_STR > message_string_size) {
-        offset = 0;
-      }
-      timestr = datalayer.system.info.logged_can_messages + offset;
-    } else {
-      timestr = timestr_buffer;
-    }
-  } else {
-    timestr = timestr_buffer;
-  }
-
-  offset += min(MAX_LENGTH_TIME_STR - 1,
-                snprintf(timestr, MAX_LENGTH_TIME_STR, "%8lu.%03lu ", currentTime / 1000, currentTime % 1000));
+  size_t size = min(MAX_LENGTH_TIME_STR - 1,
+                    snprintf(timestr, MAX_LENGTH_TIME_STR, "%8lu.%03lu ", currentTime / 1000, currentTime % 1000));
 
-  if (datalayer.system.info.web_logging_active && !datalayer.system.info.can_logging_active) {
-    datalayer.system.info.logged_can_messages_offset = offset;  // Update offset in buffer
+  if (datalayer.system.info.web_logging_active) {
+    web_log_text(timestr, size);
   }
 
   // LOG_TO_SD remains as compile-time option for now
@@ -58,7 +41,7 @@ size_t Logging::write(const uint8_t* buffer, size_t size) {
   }
 
   if (previous_message_was_newline) {
-    add_timestamp(size);
+    add_timestamp();
   }
 
 #ifdef LOG_TO_SD
@@ -69,16 +52,8 @@ size_t Logging::write(const uint8_t* buffer, size_t size) {
     Serial.write(buffer, size);
   }
 
-  if (datalayer.system.info.web_logging_active && !datalayer.system.info.can_logging_active) {
-    char* message_string = datalayer.system.info.logged_can_messages;
-    int offset = datalayer.system.info.logged_can_messages_offset;  // Keeps track of the current position in the buffer
-    size_t message_string_size = sizeof(datalayer.system.info.logged_can_messages);
-
-    if (offset + size > message_string_size) {
-      offset = 0;
-    }
-    memcpy(message_string + offset, buffer, size);
-    datalayer.system.info.logged_can_messages_offset = offset + size;  // Update offset in buffer
+  if (datalayer.system.info.web_logging_active) {
+    web_log_text((const char*)buffer, size);
   }
 
   previous_message_was_newline = buffer[size - 1] == '\n';
@@ -92,30 +67,10 @@ void Logging::printf(const char* fmt, ...) {
   }
 
   if (previous_message_was_newline) {
-    add_timestamp(MAX_LINE_LENGTH_PRINTF);
+    add_timestamp();
   }
 
-  char* message_string = datalayer.system.info.logged_can_messages;
-  size_t message_string_size = sizeof(datalayer.system.info.logged_can_messages);
-  int offset = datalayer.system.info.logged_can_messages_offset;  // Keeps track of the current position in the buffer
-  static char buffer[MAX_LINE_LENGTH_PRINTF];
-  char* message_buffer;
-
-  if (datalayer.system.info.web_logging_active) {
-    if (!datalayer.system.info.can_logging_active) {
-      /* If web debug is active and can logging is inactive, 
-       * we use the debug logging memory directly for writing the output */
-      if (offset + MAX_LINE_LENGTH_PRINTF > message_string_size) {
-        // Not enough space, reset and start from the beginning
-        offset = 0;
-      }
-      message_buffer = message_string + offset;
-    } else {
-      message_buffer = buffer;
-    }
-  } else {
-    message_buffer = buffer;
-  }
+  char message_buffer[MAX_LINE_LENGTH_PRINTF];
 
   va_list args;
   va_start(args, fmt);
@@ -130,10 +85,8 @@ void Logging::printf(const char* fmt, ...) {
     Serial.write(message_buffer, size);
   }
 
-  if (datalayer.system.info.web_logging_active && !datalayer.system.info.can_logging_active) {
-    // Data was already added to buffer, just move offset
-    datalayer.system.info.logged_can_messages_offset =
-        offset + size;  // Keeps track of the current position in the buffer
+  if (datalayer.system.info.web_logging_active) {
+    web_log_text(message_buffer, size);
   }
 
   previous_message_was_newline = message_buffer[size - 1] == '\n';
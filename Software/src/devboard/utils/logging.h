@@ -10,7 +10,7 @@
 // Real implementation for production
 
 class Logging : public Print {
-  void add_timestamp(size_t size);
+  void add_timestamp();
 
  public:
   virtual size_t write(const uint8_t* buffer, size_t size);
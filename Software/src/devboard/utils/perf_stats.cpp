@@ -0,0 +1,189 @@
+#include "perf_stats.h"
+#include <stdio.h>
+#include <string.h>
+#include "../../lib/bblanchon-ArduinoJson/ArduinoJson.h"
+
+#ifdef UNIT_TEST
+#include <chrono>
+#else
+#include <Arduino.h>
+#endif
+
+struct PerfComponent {
+  const char* name;
+  uint8_t instance;
+};
+
+struct PerfComponents {
+  PerfComponent entries[PERF_MAX_COMPONENTS];
+  uint8_t count = 0;
+};
+
+static const char* const stage_names[PERF_STAGE_COUNT] = {"comm", "ota", "10ms", "values", "cantx", "core", "mqtt"};
+
+// Stages first, then the transmitter slots and the receiver slots
+static CycleHistogram* histograms = nullptr;
+static PerfComponents transmitters;
+static PerfComponents receivers;
+static uint32_t task_overruns = 0;
+
+uint32_t CycleHistogram::count() const {
+  uint32_t total = 0;
+  for (int i = 0; i < BUCKETS; i++) {
+    total += counts[i];
+  }
+  return total;
+}
+
+uint32_t CycleHistogram::percentile(uint8_t percent) const {
+  // The histogram may be recorded into meanwhile, so use the counts as seen while walking them
+  const uint32_t total = count();
+  if (total == 0) {
+    return 0;
+  }
+  const uint64_t rank = ((uint64_t)total * percent + 99) / 100;
+  uint64_t seen = 0;
+  for (int i = 0; i < BUCKETS; i++) {
+    seen += counts[i];
+    if (seen >= rank && seen > 0) {
+      const uint64_t end = bucket_start(i + 1) - 1;
+      return end < max_value ? (uint32_t)end : max_value;
+    }
+  }
+  return max_value;
+}
+
+void CycleHistogram::reset() {
+  memset(counts, 0, sizeof(counts));
+  max_value = 0;
+}
+
+uint64_t CycleHistogram::bucket_start(int index) {
+  if (index < (1 << SUB_BUCKET_BITS)) {
+    return index;
+  }
+  const int octave = index >> SUB_BUCKET_BITS;
+  const uint64_t sub = index & ((1 << SUB_BUCKET_BITS) - 1);
+  return ((1ull << SUB_BUCKET_BITS) | sub) << (octave - 1);
+}
+
+#ifdef UNIT_TEST
+// On the host nanoseconds stand in for cycles
+uint32_t perf_cycles() {
+  return (uint32_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+static uint32_t cycles_per_us() {
+  return 1000;
+}
+#else
+static uint32_t cycles_per_us() {
+  return getCpuFrequencyMhz();
+}
+#endif
+
+void perf_stats_init() {
+  if (histograms == nullptr) {
+    histograms = new CycleHistogram[PERF_STAGE_COUNT + 2 * PERF_MAX_COMPONENTS];
+  }
+}
+
+bool perf_stats_active() {
+  return histograms != nullptr;
+}
+
+static int8_t register_component(PerfComponents& components, const char* name) {
+  if (components.count >= PERF_MAX_COMPONENTS) {
+    return -1;
+  }
+  uint8_t instance = 1;
+  for (uint8_t i = 0; i < components.count; i++) {
+    if (strcmp(components.entries[i].name, name) == 0) {
+      instance++;
+    }
+  }
+  components.entries[components.count] = {name, instance};
+  return components.count++;
+}
+
+int8_t perf_register_transmitter(const char* name) {
+  return register_component(transmitters, name);
+}
+
+int8_t perf_register_receiver(const char* name) {
+  return register_component(receivers, name);
+}
+
+uint32_t perf_record_stage(PerfStage stage, uint32_t start_cycles) {
+  const uint32_t now = perf_cycles();
+  if (histograms) {
+    histograms[stage].record(now - start_cycles);
+  }
+  return now;
+}
+
+void perf_record_transmitter(int8_t slot, uint32_t start_cycles) {
+  if (histograms && slot >= 0) {
+    histograms[PERF_STAGE_COUNT + slot].record(perf_cycles() - start_cycles);
+  }
+}
+
+void perf_record_receiver(int8_t slot, uint32_t start_cycles) {
+  if (histograms && slot >= 0) {
+    histograms[PERF_STAGE_COUNT + PERF_MAX_COMPONENTS + slot].record(perf_cycles() - start_cycles);
+  }
+}
+
+void perf_count_task_overrun() {
+  task_overruns++;
+}
+
+static float to_us(uint32_t cycles, uint32_t per_us) {
+  // Two decimals are plenty, and keep the message short
+  return (float)(uint32_t)((uint64_t)cycles * 100 / per_us) / 100;
+}
+
+static void add_histogram(JsonObject parent, const char* name, const CycleHistogram& histogram, uint32_t per_us) {
+  JsonArray values = parent[name].to<JsonArray>();
+  values.add(histogram.count());
+  values.add(to_us(histogram.percentile(50), per_us));
+  values.add(to_us(histogram.percentile(99), per_us));
+  values.add(to_us(histogram.max(), per_us));
+}
+
+static void add_components(JsonObject parent, const PerfComponents& components, const CycleHistogram* first,
+                           uint32_t per_us) {
+  char name[24];
+  for (uint8_t i = 0; i < components.count; i++) {
+    const PerfComponent& component = components.entries[i];
+    if (component.instance > 1) {
+      snprintf(name, sizeof(name), "%s%u", component.name, component.instance);
+    } else {
+      snprintf(name, sizeof(name), "%s", component.name);
+    }
+    add_histogram(parent, name, first[i], per_us);
+  }
+}
+
+size_t perf_stats_serialize(char* buffer, size_t size) {
+  JsonDocument doc;
+  doc["overruns"] = task_overruns;
+
+  if (histograms) {
+    const uint32_t per_us = cycles_per_us();
+    JsonObject stages = doc["stages"].to<JsonObject>();
+    for (int i = 0; i < PERF_STAGE_COUNT; i++) {
+      add_histogram(stages, stage_names[i], histograms[i], per_us);
+    }
+    add_components(doc["tx"].to<JsonObject>(), transmitters, histograms + PERF_STAGE_COUNT, per_us);
+    add_components(doc["rx"].to<JsonObject>(), receivers, histograms + PERF_STAGE_COUNT + PERF_MAX_COMPONENTS,
+                   per_us);
+  }
+
+  if (measureJson(doc) >= size) {
+    return 0;
+  }
+  return serializeJson(doc, buffer, size);
+}
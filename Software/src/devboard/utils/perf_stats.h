@@ -0,0 +1,102 @@
+#ifndef __PERF_STATS_H__
+#define __PERF_STATS_H__
+
+#include <stddef.h>
+#include <stdint.h>
+#ifndef UNIT_TEST
+#include "esp_cpu.h"
+#endif
+
+/* Execution time histograms of the core task stages and of each registered transmitter and CAN receiver,
+ * kept while performance measurement is enabled (PERFPROFILE). Times are measured with the CPU cycle counter.
+ *
+ * The histograms are allocated by perf_stats_init() and cover the whole uptime, unlike the maxima in the
+ * datalayer which restart every 10 s. When performance measurement is disabled nothing is allocated and
+ * recording returns right away.
+ */
+
+/* Fixed size histogram with logarithmic buckets: values below 4 have a bucket each, above that every power of
+ * two is split into 4 buckets. A percentile is therefore known to within 25 %, over the whole 32 bit range.
+ */
+class CycleHistogram {
+ public:
+  static const int SUB_BUCKET_BITS = 2;
+  static const int BUCKETS = (32 - SUB_BUCKET_BITS + 1) << SUB_BUCKET_BITS;
+
+  void record(uint32_t value) {
+    counts[bucket(value)]++;
+    if (value > max_value) {
+      max_value = value;
+    }
+  }
+
+  uint32_t count() const;
+  uint32_t max() const { return max_value; }
+  // Upper end of the bucket holding the given percentile, but never more than max(). 0 if empty.
+  uint32_t percentile(uint8_t percent) const;
+  void reset();
+
+  static int bucket(uint32_t value) {
+    if (value < (1u << SUB_BUCKET_BITS)) {
+      return value;
+    }
+    const int msb = 31 - __builtin_clz(value);
+    const int sub = (value >> (msb - SUB_BUCKET_BITS)) & ((1 << SUB_BUCKET_BITS) - 1);
+    return ((msb - SUB_BUCKET_BITS + 1) << SUB_BUCKET_BITS) | sub;
+  }
+  // Smallest value falling into the bucket. BUCKETS gives the end of the range, 2^32.
+  static uint64_t bucket_start(int index);
+
+ private:
+  uint32_t counts[BUCKETS] = {};
+  uint32_t max_value = 0;
+};
+
+enum PerfStage {
+  PERF_STAGE_COMM,       // CAN and RS485 receive
+  PERF_STAGE_OTA,        // ElegantOTA loop
+  PERF_STAGE_10MS,       // LED, contactors and precharge
+  PERF_STAGE_VALUES,     // update_values of battery and inverter, safety checks
+  PERF_STAGE_CANTX,      // All transmitters
+  PERF_STAGE_CORE_TASK,  // One iteration of the core task
+  PERF_STAGE_MQTT,       // One iteration of the MQTT task
+  PERF_STAGE_COUNT
+};
+
+// Transmitters and CAN receivers that get a histogram each, further ones are not measured
+#define PERF_MAX_COMPONENTS 6
+
+#ifdef UNIT_TEST
+uint32_t perf_cycles();
+#else
+// Cycle counter of the calling core. Only differences taken on the same core make sense.
+inline uint32_t perf_cycles() {
+  return esp_cpu_get_cycle_count();
+}
+#endif
+
+// Allocate the histograms. Call once during setup, when performance measurement is enabled.
+void perf_stats_init();
+
+bool perf_stats_active();
+
+// Give a transmitter or receiver its histogram slot, under the name of the component (e.g. "battery").
+// A second component of the same name is numbered, like battery2. Returns -1 when all slots are taken.
+int8_t perf_register_transmitter(const char* name);
+int8_t perf_register_receiver(const char* name);
+
+// Record the time since start_cycles. Returns the current cycle count, to be used as start of the next stage.
+uint32_t perf_record_stage(PerfStage stage, uint32_t start_cycles);
+void perf_record_transmitter(int8_t slot, uint32_t start_cycles);
+void perf_record_receiver(int8_t slot, uint32_t start_cycles);
+
+// Counted also when performance measurement is disabled, like the event itself
+void perf_count_task_overrun();
+
+/* Write the statistics as JSON, times in us:
+ * {"overruns":3,"stages":{"comm":[count,p50,p99,max],...},"tx":{"battery":[...],...},"rx":{...}}
+ * Returns the length written, 0 if the buffer was too small.
+ */
+size_t perf_stats_serialize(char* buffer, size_t size);
+
+#endif
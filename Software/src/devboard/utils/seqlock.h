@@ -0,0 +1,83 @@
+#ifndef __SEQLOCK_H__
+#define __SEQLOCK_H__
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <atomic>
+#include <type_traits>
+
+/* Lock-free publication of a value from a single writer to any number of readers, e.g. from the core task to
+ * the tasks on the other core. The writer never waits. A reader copies the value and starts over if a publish
+ * happened meanwhile, so it always gets a value written in one piece.
+ *
+ * Two copies are kept and the sequence number tells readers which one to use, the writer only updates the other
+ * one. A reader that interrupts the writer on the same core thus completes its copy, instead of spinning on a
+ * half written value until the writer gets to run again.
+ *
+ * The copies are stored as relaxed atomic words, which makes reading them while they are written well defined.
+ */
+template <typename T>
+class Seqlock {
+  static_assert(std::is_trivially_copyable<T>::value, "Seqlock values are copied bytewise");
+  static_assert(sizeof(T) % sizeof(uint32_t) == 0, "Seqlock values are copied as 32 bit words");
+
+ public:
+  Seqlock() {
+    const T initial = T();
+    store(copies[0], initial);
+    store(copies[1], initial);
+  }
+
+  // Only one task may publish
+  void publish(const T& value) {
+    uint32_t seq = sequence.load(std::memory_order_relaxed);
+    for (int copy = 0; copy < 2; copy++) {
+      // Odd sequence numbers send readers to copy 1 while copy 0 is written, even ones to copy 0
+      sequence.store(++seq, std::memory_order_release);
+      std::atomic_thread_fence(std::memory_order_release);
+      store(copies[copy], value);
+    }
+  }
+
+  void read(T& value) const {
+    uint32_t seq;
+    do {
+      seq = sequence.load(std::memory_order_acquire);
+      load(copies[seq & 1], value);
+      std::atomic_thread_fence(std::memory_order_acquire);
+    } while (sequence.load(std::memory_order_relaxed) != seq);
+  }
+
+  // Number of publishes so far
+  uint32_t version() const { return sequence.load(std::memory_order_acquire) / 2; }
+
+ private:
+  static const size_t WORDS = sizeof(T) / sizeof(uint32_t);
+
+  struct Copy {
+    std::atomic<uint32_t> words[WORDS];
+  };
+
+  static void store(Copy& copy, const T& value) {
+    const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&value);
+    for (size_t i = 0; i < WORDS; i++) {
+      uint32_t word;
+      memcpy(&word, bytes + i * sizeof(word), sizeof(word));
+      copy.words[i].store(word, std::memory_order_relaxed);
+    }
+  }
+
+  static void load(const Copy& copy, T& value) {
+    uint8_t* bytes = reinterpret_cast<uint8_t*>(&value);
+    for (size_t i = 0; i < WORDS; i++) {
+      const uint32_t word = copy.words[i].load(std::memory_order_relaxed);
+      memcpy(bytes + i * sizeof(word), &word, sizeof(word));
+    }
+  }
+
+  std::atomic<uint32_t> sequence{0};
+  Copy copies[2];
+};
+
+#endif
@@ -0,0 +1,339 @@
+#include "time_series.h"
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+
+static_assert(TIME_SERIES_MAX_CHANNELS <= UINT8_MAX, "The number of channels is stored in one byte");
+// The longest record, a timestamp and all values changing by the most they can, fits into an empty block. The
+// difference of two changes of 32 bit values takes 35 bits, 5 bytes as a varint.
+static_assert(10 + 5 * TIME_SERIES_MAX_CHANNELS <= TIME_SERIES_BLOCK_DATA, "Records must fit into a block");
+
+static uint64_t zigzag(int64_t value) {
+  return ((uint64_t)value << 1) ^ (uint64_t)(value >> 63);
+}
+
+static int64_t unzigzag(uint64_t value) {
+  return (int64_t)(value >> 1) ^ -(int64_t)(value & 1);
+}
+
+static bool put_varint(uint8_t* data, size_t& position, uint64_t value) {
+  do {
+    if (position == TIME_SERIES_BLOCK_DATA) {
+      return false;
+    }
+    data[position++] = (value & 0x7F) | (value > 0x7F ? 0x80 : 0);
+    value >>= 7;
+  } while (value != 0);
+  return true;
+}
+
+static bool get_varint(const uint8_t* data, size_t& position, size_t end, uint64_t& value) {
+  value = 0;
+  for (int shift = 0; shift < 64; shift += 7) {
+    if (position == end) {
+      return false;
+    }
+    const uint8_t byte = data[position++];
+    value |= (uint64_t)(byte & 0x7F) << shift;
+    if (!(byte & 0x80)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+TimeSeries::TimeSeries(uint8_t* storage, size_t size, uint8_t flags)
+    : storage(storage), blocks(size / TIME_SERIES_BLOCK_SIZE), flags(flags) {}
+
+bool TimeSeries::append(uint64_t timestamp_ms, const int32_t* values, uint8_t channels) {
+  if (blocks == 0 || channels == 0 || channels > TIME_SERIES_MAX_CHANNELS) {
+    return false;
+  }
+  // A record not fitting into the head block any more is encoded again as the first one of a new block
+  if (!open || channels != head.channels || !encode(timestamp_ms, values, channels)) {
+    start_block(timestamp_ms, channels);
+    encode(timestamp_ms, values, channels);
+  }
+  series_stats.records++;
+  return true;
+}
+
+void TimeSeries::clear() {
+  portENTER_CRITICAL(&lock);
+  first_sequence = end_sequence;
+  portEXIT_CRITICAL(&lock);
+  open = false;
+}
+
+uint32_t TimeSeries::oldest() const {
+  portENTER_CRITICAL(&lock);
+  const uint32_t sequence = first_sequence;
+  portEXIT_CRITICAL(&lock);
+  return sequence;
+}
+
+uint32_t TimeSeries::end() const {
+  portENTER_CRITICAL(&lock);
+  const uint32_t sequence = end_sequence;
+  portEXIT_CRITICAL(&lock);
+  return sequence;
+}
+
+bool TimeSeries::copy_block(uint32_t sequence, uint8_t* block) const {
+  bool copied = false;
+  portENTER_CRITICAL(&lock);
+  if ((int32_t)(sequence - first_sequence) >= 0 && (int32_t)(end_sequence - sequence) > 0) {
+    const uint8_t* source = slot(sequence);
+    TimeSeriesBlockHeader header;
+    memcpy(&header, source, sizeof(header));
+    memcpy(block, source, sizeof(header) + header.used);
+    copied = true;
+  }
+  portEXIT_CRITICAL(&lock);
+  return copied;
+}
+
+void TimeSeries::start_block(uint64_t timestamp_ms, uint8_t channels) {
+  head = {};
+  head.first_ms = timestamp_ms;
+  head.last_ms = timestamp_ms;
+  head.sequence = end_sequence;
+  head.channels = channels;
+  head.flags = flags;
+
+  portENTER_CRITICAL(&lock);
+  if (end_sequence - first_sequence == blocks) {
+    first_sequence++;
+    series_stats.dropped_blocks++;
+  }
+  end_sequence++;
+  memcpy(slot(head.sequence), &head, sizeof(head));
+  portEXIT_CRITICAL(&lock);
+
+  open = true;
+  series_stats.blocks++;
+  series_stats.bytes += sizeof(head);
+}
+
+bool TimeSeries::encode(uint64_t timestamp_ms, const int32_t* values, uint8_t channels) {
+  // Written past head.used, which readers do not copy until the header says so
+  uint8_t* data = slot(head.sequence) + sizeof(head);
+  size_t position = head.used;
+  const int64_t delta_ms = head.records == 0 ? 0 : (int64_t)(timestamp_ms - head.last_ms);
+  if (head.records > 0 && !put_varint(data, position, zigzag(delta_ms - last_delta_ms))) {
+    return false;
+  }
+  // The first record of a block against values of 0
+  if (head.records == 0) {
+    memset(last_values, 0, channels * sizeof(int32_t));
+  }
+  const bool correlated = flags & TIME_SERIES_CORRELATED;
+  auto residual = [&](uint8_t i) {
+    const int64_t change = (int64_t)values[i] - last_values[i];
+    return correlated && i > 0 ? change - ((int64_t)values[i - 1] - last_values[i - 1]) : change;
+  };
+  for (uint8_t i = 0; i < channels;) {
+    const int64_t difference = residual(i);
+    if (difference != 0) {
+      if (!put_varint(data, position, zigzag(difference))) {
+        return false;
+      }
+      i++;
+      continue;
+    }
+    // A run of unchanged values as a 0 and the length of the run
+    uint8_t run = 1;
+    while (i + run < channels && residual(i + run) == 0) {
+      run++;
+    }
+    if (!put_varint(data, position, 0) || !put_varint(data, position, run - 1)) {
+      return false;
+    }
+    i += run;
+  }
+
+  series_stats.bytes += position - head.used;
+  head.used = position;
+  head.records++;
+  head.last_ms = timestamp_ms;
+  last_delta_ms = delta_ms;
+  memcpy(last_values, values, channels * sizeof(int32_t));
+  portENTER_CRITICAL(&lock);
+  memcpy(slot(head.sequence), &head, sizeof(head));
+  portEXIT_CRITICAL(&lock);
+  return true;
+}
+
+void TimeSeriesDecoder::start(const uint8_t* block) {
+  memcpy(&block_header, block, sizeof(block_header));
+  data = block + sizeof(block_header);
+  position = 0;
+  record = 0;
+  delta_ms = 0;
+  timestamp = block_header.first_ms;
+}
+
+bool TimeSeriesDecoder::next() {
+  if (data == nullptr || record == block_header.records || block_header.channels > TIME_SERIES_MAX_CHANNELS) {
+    return false;
+  }
+  const size_t end = std::min<size_t>(block_header.used, TIME_SERIES_BLOCK_DATA);
+  uint64_t value;
+  if (record > 0) {
+    if (!get_varint(data, position, end, value)) {
+      return false;
+    }
+    delta_ms += unzigzag(value);
+    timestamp += delta_ms;
+  }
+  if (record == 0) {
+    memset(record_values, 0, sizeof(record_values));
+  }
+  const bool correlated = block_header.flags & TIME_SERIES_CORRELATED;
+  int64_t change = 0;  // Of the channel before
+  for (uint16_t i = 0; i < block_header.channels;) {
+    if (!get_varint(data, position, end, value)) {
+      return false;
+    }
+    if (value != 0) {
+      change = unzigzag(value) + (correlated ? change : 0);
+      record_values[i++] += change;
+      continue;
+    }
+    uint64_t run;
+    if (!get_varint(data, position, end, run) || i + run + 1 > block_header.channels) {
+      return false;
+    }
+    change = correlated ? change : 0;
+    for (uint64_t n = 0; n <= run; n++) {
+      record_values[i++] += change;
+    }
+  }
+  record++;
+  return true;
+}
+
+TimeSeriesExport::TimeSeriesExport(const TimeSeries& series, uint64_t from_ms, uint64_t to_ms,
+                                   TimeSeriesFormat format, const char* const* names, const char* column_prefix)
+    : series(series),
+      from_ms(from_ms),
+      to_ms(to_ms),
+      format(format),
+      names(names),
+      column_prefix(column_prefix),
+      sequence(series.oldest()) {}
+
+bool TimeSeriesExport::load_block() {
+  while (!done) {
+    // Skip ahead over the blocks dropped meanwhile
+    const uint32_t oldest = series.oldest();
+    if ((int32_t)(sequence - oldest) < 0) {
+      sequence = oldest;
+    }
+    if (sequence == series.end() || !series.copy_block(sequence, block)) {
+      return false;
+    }
+    sequence++;
+
+    decoder.start(block);
+    const TimeSeriesBlockHeader& header = decoder.header();
+    if (header.first_ms > to_ms) {
+      done = true;
+    } else if (header.last_ms >= from_ms && header.records > 0) {
+      block_pos = 0;
+      block_length = sizeof(header) + header.used;
+      return true;
+    }
+  }
+  return false;
+}
+
+bool TimeSeriesExport::next_record() {
+  while (!done) {
+    if (!block_loaded && !load_block()) {
+      return false;
+    }
+    block_loaded = true;
+    if (!decoder.next()) {
+      block_loaded = false;
+      continue;
+    }
+    if (decoder.timestamp_ms() > to_ms) {
+      done = true;
+    } else if (decoder.timestamp_ms() >= from_ms) {
+      return true;
+    }
+  }
+  return false;
+}
+
+bool TimeSeriesExport::next_text() {
+  if (column == columns) {  // Start of a line
+    if (!record_ready && !next_record()) {
+      return false;
+    }
+    // A header line first, and again when the number of channels changes, e.g. with the number of cells
+    const uint16_t channels = decoder.header().channels;
+    header_line = channels != header_channels;
+    header_channels = channels;
+    record_ready = header_line;  // The values follow the header line
+    column = 0;
+    columns = channels + 1;
+  }
+
+  const char separator = column + 1 == columns ? '\n' : ',';
+  int length;
+  if (header_line) {
+    if (column == 0) {
+      length = snprintf(text, sizeof(text), "millis%c", separator);
+    } else if (names) {
+      length = snprintf(text, sizeof(text), "%s%c", names[column - 1], separator);
+    } else {
+      length = snprintf(text, sizeof(text), "%s%u%c", column_prefix, column, separator);
+    }
+  } else if (column == 0) {
+    length = snprintf(text, sizeof(text), "%llu%c", (unsigned long long)decoder.timestamp_ms(), separator);
+  } else {
+    length = snprintf(text, sizeof(text), "%ld%c", (long)decoder.values()[column - 1], separator);
+  }
+  text_length = std::min<size_t>(length > 0 ? length : 0, sizeof(text) - 1);
+  text_pos = 0;
+  column++;
+  return true;
+}
+
+size_t TimeSeriesExport::read_binary(uint8_t* buffer, size_t max_length) {
+  size_t written = 0;
+
+  while (written < max_length) {
+    if (!block_loaded || block_pos == block_length) {
+      block_loaded = load_block();
+      if (!block_loaded) {
+        break;
+      }
+    }
+    const size_t chunk = std::min(block_length - block_pos, max_length - written);
+    memcpy(buffer + written, block + block_pos, chunk);
+    block_pos += chunk;
+    written += chunk;
+  }
+  return written;
+}
+
+size_t TimeSeriesExport::read(uint8_t* buffer, size_t max_length) {
+  if (format == TimeSeriesFormat::Binary) {
+    return read_binary(buffer, max_length);
+  }
+  size_t written = 0;
+
+  while (written < max_length) {
+    if (text_pos == text_length && !next_text()) {
+      break;
+    }
+    const size_t chunk = std::min(text_length - text_pos, max_length - written);
+    memcpy(buffer + written, text + text_pos, chunk);
+    text_pos += chunk;
+    written += chunk;
+  }
+  return written;
+}
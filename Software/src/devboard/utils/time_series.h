@@ -0,0 +1,159 @@
+#ifndef __TIME_SERIES_H__
+#define __TIME_SERIES_H__
+
+#include <stddef.h>
+#include <stdint.h>
+#include "freertos/FreeRTOS.h"
+
+/* Compressed history of samples of up to TIME_SERIES_MAX_CHANNELS integer values, in a fixed amount of RAM.
+ *
+ * The storage is a ring of blocks. When the ring is full the oldest block is dropped as a whole. A block starts
+ * with a header and its first record, which holds the values as they are. Each following record holds the
+ * change since the record before:
+ * - the timestamp as the change in the interval (delta-of-delta), 0 when the samples come at a steady pace,
+ * - each value as the difference to its previous value, or a run of values that did not change as a 0 followed
+ *   by the length of the run less one.
+ * All are zig-zag encoded, so that small negative numbers stay small, and written as varints, 7 bits per byte.
+ * A sample at the usual interval with no value changed takes three bytes. A block holds samples with the same
+ * number of channels only, a sample with another number starts a new block.
+ *
+ * For channels that move together, e.g. the cells of a pack, TIME_SERIES_CORRELATED stores the change of each
+ * value as the difference to the change of the channel before, so that all cells rising by the same amount
+ * take one run.
+ *
+ * One task appends, any task reads. Readers copy a whole block at a time, and only the part of the head block
+ * written before the copy. The lock is held for the copy and for updating a block header, never while encoding.
+ */
+
+#define TIME_SERIES_BLOCK_SIZE 1024
+#define TIME_SERIES_MAX_CHANNELS 192
+#define TIME_SERIES_CORRELATED 0x01  // Flag of TimeSeriesBlockHeader
+
+// As stored and as sent by the binary export, little endian
+struct __attribute__((packed)) TimeSeriesBlockHeader {
+  uint64_t first_ms;
+  uint64_t last_ms;
+  uint32_t sequence;  // Counts up with each block started
+  uint16_t used;      // Bytes of records after the header
+  uint16_t records;
+  uint8_t channels;
+  uint8_t flags;
+};
+
+#define TIME_SERIES_BLOCK_DATA (TIME_SERIES_BLOCK_SIZE - sizeof(TimeSeriesBlockHeader))
+
+struct TimeSeriesStats {
+  uint32_t records = 0;  // Appended since the start, including the ones dropped since
+  uint32_t blocks = 0;   // Started
+  uint32_t dropped_blocks = 0;
+  uint64_t bytes = 0;  // Of the records and block headers appended
+};
+
+class TimeSeries {
+ public:
+  // Uses as many whole blocks as fit into size bytes of storage
+  TimeSeries(uint8_t* storage, size_t size, uint8_t flags = 0);
+
+  // Returns false if channels is 0 or above TIME_SERIES_MAX_CHANNELS, or the storage holds no block
+  bool append(uint64_t timestamp_ms, const int32_t* values, uint8_t channels);
+  void clear();
+
+  const TimeSeriesStats& stats() const { return series_stats; }
+  size_t capacity_blocks() const { return blocks; }
+
+  // Sequence numbers of the blocks held, oldest() up to but not including end()
+  uint32_t oldest() const;
+  uint32_t end() const;
+  // Copies the block with this sequence number into block, TIME_SERIES_BLOCK_SIZE bytes. Returns false if the
+  // block has been dropped or not been started yet.
+  bool copy_block(uint32_t sequence, uint8_t* block) const;
+
+ private:
+  uint8_t* storage;
+  size_t blocks;
+  uint8_t flags;
+  uint32_t first_sequence = 0;
+  uint32_t end_sequence = 0;
+  mutable portMUX_TYPE lock = portMUX_INITIALIZER_UNLOCKED;
+
+  // The head block as the writer knows it, and the previous record to encode the next one against
+  bool open = false;
+  TimeSeriesBlockHeader head = {};
+  int64_t last_delta_ms = 0;
+  int32_t last_values[TIME_SERIES_MAX_CHANNELS];
+  TimeSeriesStats series_stats;
+
+  uint8_t* slot(uint32_t sequence) const { return storage + (sequence % blocks) * TIME_SERIES_BLOCK_SIZE; }
+  void start_block(uint64_t timestamp_ms, uint8_t channels);
+  bool encode(uint64_t timestamp_ms, const int32_t* values, uint8_t channels);
+};
+
+// Decodes the records of a block copied by TimeSeries::copy_block, oldest first
+class TimeSeriesDecoder {
+ public:
+  void start(const uint8_t* block);
+  bool next();
+
+  const TimeSeriesBlockHeader& header() const { return block_header; }
+  uint64_t timestamp_ms() const { return timestamp; }
+  const int32_t* values() const { return record_values; }
+
+ private:
+  const uint8_t* data = nullptr;
+  TimeSeriesBlockHeader block_header = {};
+  size_t position = 0;
+  uint16_t record = 0;
+  uint64_t timestamp = 0;
+  int64_t delta_ms = 0;
+  int32_t record_values[TIME_SERIES_MAX_CHANNELS];
+};
+
+enum class TimeSeriesFormat { Csv, Binary };
+
+/* Streams the samples from from_ms up to to_ms, for chunked webserver responses. As CSV, with a column
+ * millis followed by one per channel, named by names or, without names, by column_prefix and the channel number
+ * counted from 1. As binary, the blocks holding samples of the range one after another, each as its header
+ * followed by header.used bytes of records, for decoding on the host with TimeSeriesDecoder.
+ *
+ * Blocks dropped while streaming are skipped, samples appended while streaming may or may not be included.
+ */
+class TimeSeriesExport {
+ public:
+  TimeSeriesExport(const TimeSeries& series, uint64_t from_ms, uint64_t to_ms, TimeSeriesFormat format,
+                   const char* const* names, const char* column_prefix);
+  // Fill buffer with up to max_length bytes. Returns 0 when the end of the range has been reached.
+  size_t read(uint8_t* buffer, size_t max_length);
+
+ private:
+  const TimeSeries& series;
+  const uint64_t from_ms;
+  const uint64_t to_ms;
+  const TimeSeriesFormat format;
+  const char* const* names;
+  const char* column_prefix;
+
+  uint8_t block[TIME_SERIES_BLOCK_SIZE];
+  uint32_t sequence = 0;
+  bool block_loaded = false;
+  bool done = false;
+  TimeSeriesDecoder decoder;
+  size_t block_pos = 0;  // Binary: bytes of the block sent
+  size_t block_length = 0;
+
+  // CSV: the line being written a field at a time, a header line before the first record of each channel count
+  bool record_ready = false;
+  uint16_t header_channels = 0;  // Of the last header line, none yet
+  bool header_line = false;
+  uint16_t column = 0;
+  uint16_t columns = 0;
+  char text[32];
+  size_t text_length = 0;
+  size_t text_pos = 0;
+
+  bool load_block();
+  bool next_record();
+  bool next_text();
+  size_t read_binary(uint8_t* buffer, size_t max_length);
+};
+
+#endif
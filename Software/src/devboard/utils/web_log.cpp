@@ -0,0 +1,107 @@
+#include "web_log.h"
+#include <string.h>
+#include <algorithm>
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "log_ring.h"
+
+typedef LogRing<WEB_CAN_LOG_SIZE> CanLogRing;
+typedef LogRing<WEB_DEBUG_LOG_SIZE> DebugLogRing;
+
+static CanLogRing can_ring;
+static DebugLogRing debug_ring;
+// The core task, the CAN replay task and the tasks that print debug messages all append
+static portMUX_TYPE web_log_lock = portMUX_INITIALIZER_UNLOCKED;
+
+void web_log_can_frame(const CAN_frame& frame, CAN_Interface interface, frameDirection direction) {
+  CAN_log_record record;
+  const size_t size = can_log_encode(frame, interface, direction, esp_timer_get_time(), record);
+  portENTER_CRITICAL(&web_log_lock);
+  can_ring.append(&record, size);
+  portEXIT_CRITICAL(&web_log_lock);
+}
+
+void web_log_text(const char* text, size_t length) {
+  // Cut into records that fit the line buffer of WebLogTextExport
+  while (length > 0) {
+    const size_t chunk = std::min<size_t>(length, CAN_LOG_MAX_TEXT_LINE);
+    portENTER_CRITICAL(&web_log_lock);
+    debug_ring.append(text, chunk);
+    portEXIT_CRITICAL(&web_log_lock);
+    text += chunk;
+    length -= chunk;
+  }
+}
+
+void web_log_clear(WebLog log) {
+  portENTER_CRITICAL(&web_log_lock);
+  if (log == WebLog::Can) {
+    can_ring.clear();
+  } else {
+    debug_ring.clear();
+  }
+  portEXIT_CRITICAL(&web_log_lock);
+}
+
+WebLogTextExport::WebLogTextExport(WebLog log, uint32_t since) : log(log), since(since) {
+  if (log == WebLog::Can) {
+    end = can_ring.end_sequence();
+    position = can_ring.oldest().position;
+  } else {
+    end = debug_ring.end_sequence();
+    position = debug_ring.oldest().position;
+  }
+  if (this->since > end) {
+    this->since = 0;  // Asked by a page loaded before a reboot, start over
+  }
+}
+
+bool WebLogTextExport::next_line() {
+  size_t length;
+  uint32_t sequence;
+
+  if (log == WebLog::Can) {
+    CanLogRing::Cursor cursor{position, since};
+    uint8_t buffer[CAN_LOG_MAX_RECORD_SIZE];
+    CAN_log_record record;
+    do {
+      if (!can_ring.read(cursor, buffer, sizeof(buffer), length, sequence) || sequence >= end) {
+        return false;
+      }
+    } while (sequence < since);
+    position = cursor.position;
+    const size_t used = can_log_decode(buffer, std::min(length, sizeof(buffer)), record);
+    if (used == 0 || used == SIZE_MAX) {
+      line_length = 0;
+    } else {
+      line_length = can_log_format_text(record, line, sizeof(line));
+    }
+  } else {
+    DebugLogRing::Cursor cursor{position, since};
+    do {
+      if (!debug_ring.read(cursor, line, sizeof(line), length, sequence) || sequence >= end) {
+        return false;
+      }
+    } while (sequence < since);
+    position = cursor.position;
+    line_length = std::min(length, sizeof(line));
+  }
+  line_pos = 0;
+  return true;
+}
+
+size_t WebLogTextExport::read(uint8_t* buffer, size_t max_length) {
+  size_t written = 0;
+
+  while (written < max_length) {
+    if (line_pos == line_length && !next_line()) {
+      break;
+    }
+    size_t chunk = std::min(line_length - line_pos, max_length - written);
+    memcpy(buffer + written, line + line_pos, chunk);
+    line_pos += chunk;
+    written += chunk;
+  }
+
+  return written;
+}
@@ -0,0 +1,45 @@
+#ifndef __WEB_LOG_H__
+#define __WEB_LOG_H__
+
+#include <stddef.h>
+#include <stdint.h>
+#include "../sdcard/can_log_format.h"
+#include "types.h"
+
+/* Logs shown by the webserver, kept in RAM. The CAN log stores frames in the binary format of can_log_format.h
+ * and formats them as text only when a page or export reads them. The debug log stores the text written by
+ * Logging. Both are rings of records that any task can append to, while the webserver reads them without
+ * holding up the writers.
+ */
+
+#define WEB_CAN_LOG_SIZE 8192
+#define WEB_DEBUG_LOG_SIZE 8192
+
+enum class WebLog { Can, Debug };
+
+void web_log_can_frame(const CAN_frame& frame, CAN_Interface interface, frameDirection direction);
+void web_log_text(const char* text, size_t length);
+void web_log_clear(WebLog log);
+
+// Streams the text of a log from the records numbered since onwards, for chunked webserver responses
+class WebLogTextExport {
+ public:
+  WebLogTextExport(WebLog log, uint32_t since = 0);
+  // Fill buffer with up to max_length bytes of text. Returns 0 when the end of the log has been reached.
+  size_t read(uint8_t* buffer, size_t max_length);
+  // Where to continue next time, records appended after the export started are not included
+  uint32_t next_sequence() const { return end; }
+
+ private:
+  WebLog log;
+  uint32_t since;
+  uint32_t end;
+  uint32_t position;
+  char line[CAN_LOG_MAX_TEXT_LINE];
+  size_t line_length = 0;
+  size_t line_pos = 0;
+
+  bool next_line();
+};
+
+#endif
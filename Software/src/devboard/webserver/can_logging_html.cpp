@@ -2,12 +2,12 @@
 #include <Arduino.h>
 #include "../../communication/can/comm_can.h"
 #include "../../datalayer/datalayer.h"
+#include "../utils/web_log.h"
 #include "index_html.h"
 
 String can_logger_processor(void) {
   if (!datalayer.system.info.can_logging_active) {
-    datalayer.system.info.logged_can_messages_offset = 0;
-    datalayer.system.info.logged_can_messages[0] = '\0';
+    web_log_clear(WebLog::Can);
   }
   datalayer.system.info.can_logging_active =
       true;  // Signal to main loop that we should log messages. Disabled by default for performance reasons
@@ -38,31 +38,36 @@ String can_logger_processor(void) {
   content += "<button onclick='stopLoggingAndGoToMainPage()'>Stop &amp; Back to main page</button>";
   content += "</div>";
 
-  // Start a new block for the CAN messages
-  content += "<div style='background-color: #303E47; padding: 20px; border-radius: 15px'>";
-
-  // Check for messages
-  if (datalayer.system.info.logged_can_messages[0] == 0) {
-    content += "CAN logger started! Refresh page to display incoming(RX) and outgoing(TX) messages";
-  } else {
-    // Split the messages using the newline character
-    String messages = String(datalayer.system.info.logged_can_messages);
-    int startIndex = 0;
-    int endIndex = messages.indexOf('\n');
-    while (endIndex != -1) {
-      // Extract a single message and wrap it in a styled div
-      String singleMessage = messages.substring(startIndex, endIndex);
-      content += "<div class='can-message'>" + singleMessage + "</div>";
-      startIndex = endIndex + 1;  // Move past the newline character
-      endIndex = messages.indexOf('\n', startIndex);
-    }
-  }
-
+  // Start a new block for the CAN messages, filled in by the script below as they are logged
+  content += "<div id='canMessages' style='background-color: #303E47; padding: 20px; border-radius: 15px'>";
+  content += "CAN logger started! Incoming(RX) and outgoing(TX) messages will show up here";
   content += "</div>";
 
   // Add JavaScript for navigation and configuration
   content += "<script>";
-  content += "function refreshPage(){ location.reload(true); }";
+  // Fetch the messages logged since the last poll, and keep the newest 500 on the page
+  content += "var nextSeq = 0; var started = false; var polling = false;";
+  content += "function refreshPage() {";
+  content += "  if (polling) return;";
+  content += "  polling = true;";
+  content += "  fetch('/can_log_data?since=' + nextSeq).then(function(response) {";
+  content += "    nextSeq = response.headers.get('X-Next-Seq') || nextSeq;";
+  content += "    return response.text();";
+  content += "  }).then(function(text) {";
+  content += "    var block = document.getElementById('canMessages');";
+  content += "    var lines = text.split('\\n');";
+  content += "    for (var i = 0; i < lines.length; i++) {";
+  content += "      if (lines[i].length == 0) continue;";
+  content += "      if (!started) { block.innerHTML = ''; started = true; }";
+  content += "      var div = document.createElement('div');";
+  content += "      div.className = 'can-message';";
+  content += "      div.textContent = lines[i];";
+  content += "      block.appendChild(div);";
+  content += "    }";
+  content += "    while (block.childElementCount > 500) block.removeChild(block.firstElementChild);";
+  content += "  }).finally(function() { polling = false; });";
+  content += "}";
+  content += "refreshPage(); setInterval(refreshPage, 1000);";
   content += "function exportLog() { window.location.href = '/export_can_log'; }";
 #ifdef LOG_CAN_TO_SD
   content += "function deleteLogFile() { window.location.href = '/delete_can_log'; }";
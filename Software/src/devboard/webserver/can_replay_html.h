@@ -3,14 +3,20 @@
 
 #include <Arduino.h>
 #include <string>
+#include "html_stream.h"
 
 /**
- * @brief Replaces placeholder with content section in web page
+ * @brief Adds the parts of the CAN replay page, and starts logging CAN messages
  *
- * @param[in] var
+ * @param[in] page
+ */
+void can_replay_page(HtmlPageStream& page);
+
+/**
+ * @brief Loaded log, replay progress and timing accuracy as one line of text
  *
  * @return String
  */
-String can_replay_processor(void);
+String can_replay_status(void);
 
 #endif
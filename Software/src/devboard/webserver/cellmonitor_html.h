@@ -1,15 +0,0 @@
-#ifndef CELLMONITOR_H
-#define CELLMONITOR_H
-
-#include <WString.h>
-
-/**
- * @brief Replaces placeholder with content section in web page
- *
- * @param[in] var
- *
- * @return String
- */
-String cellmonitor_processor(const String& var);
-
-#endif
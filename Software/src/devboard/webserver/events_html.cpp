@@ -1,8 +1,11 @@
 #include "events_html.h"
+#include <array>
 #include <limits>
 #include "../../datalayer/datalayer.h"
+#include "../../devboard/utils/json_writer.h"
 #include "../../devboard/utils/logging.h"
 #include "../../devboard/utils/millis64.h"
+#include "index_html.h"
 
 const char EVENTS_HTML_START[] = R"=====(
 <style>body{background-color:#000;color:#fff}.event-log{display:flex;flex-direction:column}.event{display:flex;flex-wrap:wrap;border:1px solid #fff;padding:10px}.event>div{flex:1;min-width:100px;word-break:break-word}</style><div style="background-color:#303e47;padding:10px;margin-bottom:10px;border-radius:25px"><div class="event-log"><div class="event" style="background-color:#1e2c33;font-weight:700"><div>Event Type</div><div>Severity</div><div>Last Event</div><div>Count</div><div>Data</div><div>Message</div></div>
@@ -12,61 +15,85 @@ const char EVENTS_HTML_END[] = R"=====(
 <style> button { background-color: #505E67; color: white; border: none; padding: 10px 20px; margin-bottom: 20px; cursor: pointer; border-radius: 10px; }
 button:hover { background-color: #3A4A52; }</style>
 <button onclick="askClear()">Clear all events</button>
+<button onclick="window.location.href='/api/journal'">Download journal</button>
 <button onclick="home()">Back to main page</button>
 <style>.event:nth-child(even){background-color:#455a64}.event:nth-child(odd){background-color:#394b52}</style>
 <script>function showEvent(){document.querySelectorAll(".event").forEach(function(e){var n=e.querySelector(".sec-ago");n&&(n.innerText=new Date(Number(BigInt(Date.now()) - BigInt(n.innerText))).toLocaleString())})}function askClear(){window.confirm("Are you sure you want to clear all events?")&&(window.location.href="/clearevents")}function home(){window.location.href="/"}window.onload=function(){showEvent()}
 </script>
 )=====";
 
-static std::vector<EventData> order_events;
+void events_page(HtmlPageStream& page) {
+  page.add(index_html_header);
+  // Page format
+  page.add(EVENTS_HTML_START);
 
-String events_processor(const String& var) {
-  if (var == "X") {
-    String content = "";
-    content.reserve(5000);
-    // Page format
-    content.concat(FPSTR(EVENTS_HTML_START));
-    const EVENTS_STRUCT_TYPE* event_pointer;
-
-    //clear the vector
-    order_events.clear();
-    // Collect all events
-    for (int i = 0; i < EVENT_NOF_EVENTS; i++) {
-      event_pointer = get_event_pointer((EVENTS_ENUM_TYPE)i);
-      if (event_pointer->occurences > 0) {
-        order_events.push_back({static_cast<EVENTS_ENUM_TYPE>(i), event_pointer});
-      }
+  // The order of the events is taken on the first turn and then the rows are written a few at a time
+  page.add([order = std::array<EVENTS_ENUM_TYPE, EVENT_NOF_EVENTS>(), rows = size_t(0), row = size_t(0),
+            current_timestamp = uint64_t(0)](HtmlWriter& out) mutable {
+    if (row == 0 && rows == 0) {
+      // Newest first
+      rows = get_events_newest_first(order.data(), order.size());
+      current_timestamp = millis64();
     }
-    // Sort events by timestamp
-    std::sort(order_events.begin(), order_events.end(), compareEventsByTimestampDesc);
-    uint64_t current_timestamp = millis64();
 
-    // Generate HTML and debug output
-    for (const auto& event : order_events) {
-      EVENTS_ENUM_TYPE event_handle = event.event_handle;
-      event_pointer = event.event_pointer;
+    for (; row < rows; row++) {
+      EVENTS_ENUM_TYPE event_handle = order[row];
+      const EVENTS_STRUCT_TYPE* event_pointer = get_event_pointer(event_handle);
+      const size_t row_start = out.length();
 
-      content.concat("<div class='event'>");
-      content.concat("<div>" + String(get_event_enum_string(event_handle)) + "</div>");
-      content.concat("<div>" + String(get_event_level_string(event_handle)) + "</div>");
+      out.print("<div class='event'>");
+      out.printf("<div>%s</div>", get_event_enum_string(event_handle));
+      out.printf("<div>%s</div>", get_event_level_string(event_handle));
       // Frontend expects to see time difference (in ms) from now to event
-      content.concat("<div class='sec-ago'>" + String(current_timestamp - event_pointer->timestamp) + "</div>");
-      content.concat("<div>" + String(event_pointer->occurences) + "</div>");
-      content.concat("<div>" + String(event_pointer->data) + "</div>");
-      content.concat("<div>" + get_event_message_string(event_handle) + "</div>");
-      content.concat("</div>");  // End of event row
+      out.print("<div class='sec-ago'>");
+      out.print(current_timestamp - event_pointer->timestamp);
+      out.print("</div><div>");
+      out.print(event_pointer->occurences);
+      out.print("</div><div>");
+      out.print(event_pointer->data);
+      out.print("</div><div>");
+      out.print(get_event_message_string(event_handle));
+      out.print("</div></div>");  // End of event row
+
+      if (out.overflowed() && row_start > 0) {
+        out.rewind(row_start);
+        return false;  // This row goes first next turn
+      }
     }
+    return true;
+  });
+
+  page.add(EVENTS_HTML_END);
+  page.add(index_html_footer);
+}
+
+size_t events_history_json(char* buffer, size_t size, uint32_t since, uint32_t& next) {
+  EVENT_OCCURRENCE_TYPE occurrences[EVENTS_HISTORY_PAGE];
+  const size_t count = get_event_history(since, occurrences, EVENTS_HISTORY_PAGE, next);
+  const uint64_t current_timestamp = millis64();
 
-    //clear the vector
-    order_events.clear();
-    content.concat(FPSTR(EVENTS_HTML_END));
-    return content;
+  JsonWriter json(buffer, size);
+  json.begin_object();
+  json.add("v", EVENTS_HISTORY_VERSION);
+  json.begin_array("events");
+  for (size_t i = 0; i < count; i++) {
+    const uint64_t age = current_timestamp - occurrences[i].timestamp;
+    json.begin_object();
+    json.add_unsigned("seq", occurrences[i].sequence);
+    json.add_string("type", get_event_enum_string(occurrences[i].event));
+    json.add_string("severity", get_event_level_string(occurrences[i].event));
+    json.add_unsigned("age", age < UINT32_MAX ? (uint32_t)age : UINT32_MAX);
+    json.add_unsigned("data", occurrences[i].data);
+    json.end_object();
   }
-  return String();
+  json.end_array();
+  json.end_object();
+  return json.overflowed() ? 0 : json.length();
 }
 
 /* Script for displaying event log before it gets minified
 <button onclick="askClear()">Clear all events</button>
+<button onclick="window.location.href='/api/journal'">Download journal</button>
 <button onclick="home()">Back to main page</button>
 <style>
     .event:nth-child(even) {
@@ -2,17 +2,34 @@
 #define EVENTS_H
 
 #include <Arduino.h>
-#include <algorithm>
-#include <vector>
 #include "../utils/events.h"
+#include "html_stream.h"
 
 /**
- * @brief Replaces placeholder with content section in web page
+ * @brief Adds the parts of the event log page
  *
- * @param[in] var
+ * @param[in] page
+ */
+void events_page(HtmlPageStream& page);
+
+/* /api/events?since=n lists the occurrences of events numbered n onwards, oldest first and at most
+ * EVENTS_HISTORY_PAGE of them, the page asks again with the X-Next-Seq header of the response:
+ *   {"v":1,"events":[{"seq":12,"type":"EVENT_WIFI_CONNECT","severity":"INFO","age":5230,"data":0}, ...]}
+ * age is the time since the occurrence in ms.
+ */
+#define EVENTS_HISTORY_VERSION 1
+#define EVENTS_HISTORY_PAGE 12
+
+/**
+ * @brief Writes a page of the /api/events JSON
+ *
+ * @param[out] buffer
+ * @param[in] size
+ * @param[in] since Sequence number of the first occurrence wanted
+ * @param[out] next Sequence number to ask for next
  *
- * @return String
+ * @return size_t Length of the JSON, 0 if it did not fit
  */
-String events_processor(const String& var);
+size_t events_history_json(char* buffer, size_t size, uint32_t since, uint32_t& next);
 
 #endif
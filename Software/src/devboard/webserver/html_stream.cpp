@@ -0,0 +1,152 @@
+#include "html_stream.h"
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+
+HtmlWriter::HtmlWriter(char* buffer, size_t size) : buffer(buffer), size(size) {
+  reset();
+}
+
+void HtmlWriter::reset() {
+  used = 0;
+  overflow = false;
+  buffer[0] = '\0';
+}
+
+void HtmlWriter::rewind(size_t length) {
+  if (length < used) {
+    used = length;
+    buffer[used] = '\0';
+  }
+  overflow = false;
+}
+
+void HtmlWriter::print(const char* text) {
+  const size_t length = strlen(text);
+  const size_t count = std::min(length, room());
+  memcpy(buffer + used, text, count);
+  used += count;
+  buffer[used] = '\0';
+  if (count < length) {
+    overflow = true;
+  }
+}
+
+void HtmlWriter::print(char c) {
+  const char text[2] = {c, '\0'};
+  print(text);
+}
+
+void HtmlWriter::print_signed(int64_t value) {
+  char text[24];
+  snprintf(text, sizeof(text), "%lld", (long long)value);
+  print(text);
+}
+
+void HtmlWriter::print_unsigned(uint64_t value) {
+  char text[24];
+  snprintf(text, sizeof(text), "%llu", (unsigned long long)value);
+  print(text);
+}
+
+void HtmlWriter::print(double value, uint8_t decimals) {
+  char text[32];
+  snprintf(text, sizeof(text), "%.*f", decimals, value);
+  print(text);
+}
+
+void HtmlWriter::printf(const char* format, ...) {
+  va_list args;
+  va_start(args, format);
+  const int length = vsnprintf(buffer + used, room() + 1, format, args);
+  va_end(args);
+  if (length < 0) {
+    buffer[used] = '\0';
+    return;
+  }
+  if ((size_t)length > room()) {
+    overflow = true;
+    used = size - 1;
+  } else {
+    used += length;
+  }
+}
+
+void HtmlWriter::print_escaped(const char* text) {
+  for (; *text; text++) {
+    switch (*text) {
+      case '&':
+        print("&amp;");
+        break;
+      case '<':
+        print("&lt;");
+        break;
+      case '>':
+        print("&gt;");
+        break;
+      case '\"':
+        print("&quot;");
+        break;
+      case '\'':
+        print("&#39;");
+        break;
+      default:
+        print(*text);
+        break;
+    }
+  }
+}
+
+void HtmlPageStream::add(const char* text) {
+  items.push_back({text, strlen(text), nullptr});
+}
+
+void HtmlPageStream::add(Part part) {
+  items.push_back({nullptr, 0, part});
+}
+
+bool HtmlPageStream::next() {
+  while (next_item < items.size()) {
+    Item& item = items[next_item];
+    if (item.text != nullptr) {
+      next_item++;
+      pending = item.text;
+      pending_length = item.length;
+    } else {
+      writer.reset();
+      const bool done = item.part(writer);
+      if (writer.overflowed()) {
+        overflow_count++;
+      }
+      // A function that has nothing more to say is done, whatever it returned
+      if (done || writer.length() == 0) {
+        next_item++;
+      }
+      pending = buffer;
+      pending_length = writer.length();
+    }
+    pending_pos = 0;
+    if (pending_length > 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+size_t HtmlPageStream::read(uint8_t* out, size_t max_length) {
+  size_t written = 0;
+
+  while (written < max_length) {
+    if (pending_pos == pending_length && !next()) {
+      break;
+    }
+    size_t chunk = std::min(pending_length - pending_pos, max_length - written);
+    memcpy(out + written, pending + pending_pos, chunk);
+    pending_pos += chunk;
+    written += chunk;
+  }
+
+  return written;
+}
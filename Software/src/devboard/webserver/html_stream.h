@@ -0,0 +1,102 @@
+#ifndef __HTML_STREAM_H__
+#define __HTML_STREAM_H__
+
+#include <WString.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <functional>
+#include <type_traits>
+#include <vector>
+
+/* Writes text into a caller provided buffer. Text beyond the end is dropped and overflowed() is set, the buffer is
+ * always zero terminated.
+ */
+class HtmlWriter {
+ public:
+  HtmlWriter(char* buffer, size_t size);
+
+  // Start over with an empty buffer
+  void reset();
+
+  void print(const char* text);
+  void print(const String& text) { print(text.c_str()); }
+  void print(char c);
+  template <typename T>
+  typename std::enable_if<std::is_integral<T>::value>::type print(T value) {
+    if (std::is_signed<T>::value) {
+      print_signed(value);
+    } else {
+      print_unsigned(value);
+    }
+  }
+  // Like String(value, decimals)
+  void print(double value, uint8_t decimals);
+  void printf(const char* format, ...) __attribute__((format(printf, 2, 3)));
+  // With &, <, >, " and ' written as entities, like html_escape()
+  void print_escaped(const char* text);
+
+  // Drops the text after the first length characters and the overflow, e.g. to move an entry of a list that did
+  // not fit anymore to the next turn
+  void rewind(size_t length);
+
+  const char* c_str() const { return buffer; }
+  size_t length() const { return used; }
+  size_t room() const { return size - 1 - used; }
+  bool overflowed() const { return overflow; }
+
+ private:
+  char* buffer;
+  size_t size;
+  size_t used;
+  bool overflow;
+
+  void print_signed(int64_t value);
+  void print_unsigned(uint64_t value);
+};
+
+// Largest dynamic part of a page, e.g. the values of one battery
+#define HTML_STREAM_BUFFER_SIZE 1536
+
+/* A web page sent with a chunked response, without building it in memory first. The page is a list of parts:
+ * static text, e.g. CSS or JavaScript in flash, copied straight into the response, and functions that write the
+ * dynamic content into a small buffer when their turn comes. A function returns false to be called again once its
+ * text is sent, e.g. to write a long list a few entries at a time while room() allows.
+ *
+ * Each function is called once per turn, so everything it writes comes from the same moment.
+ */
+class HtmlPageStream {
+ public:
+  typedef std::function<bool(HtmlWriter&)> Part;
+
+  HtmlPageStream() : writer(buffer, sizeof(buffer)) {}
+  HtmlPageStream(const HtmlPageStream&) = delete;
+  HtmlPageStream& operator=(const HtmlPageStream&) = delete;
+
+  void add(const char* text);
+  void add(Part part);
+
+  // Fill buffer with up to max_length bytes of the page. Returns 0 when the whole page has been read.
+  size_t read(uint8_t* buffer, size_t max_length);
+
+  // Turns of a function that did not fit the buffer and were cut off
+  uint16_t overflows() const { return overflow_count; }
+
+ private:
+  struct Item {
+    const char* text;
+    size_t length;
+    Part part;
+  };
+  std::vector<Item> items;
+  size_t next_item = 0;
+  const char* pending = nullptr;
+  size_t pending_length = 0;
+  size_t pending_pos = 0;
+  uint16_t overflow_count = 0;
+  char buffer[HTML_STREAM_BUFFER_SIZE];
+  HtmlWriter writer;
+
+  bool next();
+};
+
+#endif  // __HTML_STREAM_H__
@@ -27,5 +27,6 @@ function reboot() {
 extern const char index_html[];
 extern const char index_html_header[];
 extern const char index_html_footer[];
+extern const char common_javascript[];
 
 #endif  // INDEX_HTML_H
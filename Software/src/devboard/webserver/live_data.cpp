@@ -0,0 +1,109 @@
+#include "live_data.h"
+#include <string.h>
+#include "../utils/json_writer.h"
+
+static const char* bms_status_name(bms_status_enum status) {
+  switch (status) {
+    case ACTIVE:
+      return "OK";
+    case UPDATING:
+      return "UPDATING";
+    case FAULT:
+      return "FAULT";
+    case INACTIVE:
+      return "INACTIVE";
+    case STANDBY:
+      return "STANDBY";
+    default:
+      return "??";
+  }
+}
+
+static void add_battery(JsonWriter& json, const DATALAYER_BATTERY_TYPE& battery) {
+  json.begin_object();
+  json.add_fixed("soc", battery.status.real_soc, 2);
+  json.add_fixed("soc_reported", battery.status.reported_soc, 2);
+  json.add_fixed("soh", battery.status.soh_pptt, 2);
+  json.add_fixed("voltage", battery.status.voltage_dV, 1);
+  json.add_fixed("current", battery.status.current_dA, 1);
+  json.add("power", battery.status.active_power_W);
+  json.add_fixed("temp_min", battery.status.temperature_min_dC, 1);
+  json.add_fixed("temp_max", battery.status.temperature_max_dC, 1);
+  json.add_fixed("cell_min", battery.status.cell_min_voltage_mV, 3);
+  json.add_fixed("cell_max", battery.status.cell_max_voltage_mV, 3);
+  json.add_unsigned("cell_min_index", battery.status.cell_min_voltage_index);
+  json.add_unsigned("cell_max_index", battery.status.cell_max_voltage_index);
+  json.add_fixed("cell_mean", battery.status.cell_mean_voltage_mV, 3);
+  json.add_fixed("cell_stddev", battery.status.cell_voltage_stddev_dmV, 1);
+  json.add_unsigned("cells_balancing", battery.status.cells_balancing);
+  json.add_unsigned("cells_stale", battery.status.cells_stale);
+  json.add_unsigned("max_charge_power", battery.status.max_charge_power_W);
+  json.add_unsigned("max_discharge_power", battery.status.max_discharge_power_W);
+  json.add_unsigned("remaining_capacity", battery.status.remaining_capacity_Wh);
+  json.add_unsigned("total_capacity", battery.info.total_capacity_Wh);
+  json.add_unsigned("cells", battery.info.number_of_cells);
+  json.add_string("status", bms_status_name(battery.status.bms_status));
+  json.add_bool("balancing", battery.status.balancing_status == BALANCING_STATUS_ACTIVE);
+  json.end_object();
+}
+
+size_t live_data_json(char* buffer, size_t size, const DATALAYER_SNAPSHOT_TYPE& snapshot, uint8_t batteries) {
+  JsonWriter json(buffer, size);
+  json.begin_object();
+  json.add("v", LIVE_DATA_VERSION);
+  json.add_unsigned("contactors", snapshot.system.status.contactors_engaged);
+  json.add_bool("inverter_allows_closing", snapshot.system.status.inverter_allows_contactor_closing);
+  json.begin_array("batteries");
+  add_battery(json, snapshot.battery);
+  if (batteries >= 2) {
+    add_battery(json, snapshot.battery2);
+  }
+  if (batteries >= 3) {
+    add_battery(json, snapshot.battery3);
+  }
+  json.end_array();
+  json.end_object();
+  return json.overflowed() ? 0 : json.length();
+}
+
+size_t live_cells_pack(uint8_t* buffer, size_t size, const DATALAYER_BATTERY_TYPE& battery, uint8_t number) {
+  const uint16_t cells = battery.info.number_of_cells < MAX_AMOUNT_CELLS ? battery.info.number_of_cells
+                                                                         : MAX_AMOUNT_CELLS;
+  const size_t length = LIVE_CELLS_HEADER_SIZE + cells * 2 + (cells + 7) / 8;
+  if (length > size) {
+    return 0;
+  }
+
+  buffer[0] = LIVE_CELLS_VERSION;
+  buffer[1] = number;
+  buffer[2] = battery.status.balancing_status == BALANCING_STATUS_ACTIVE ? LIVE_CELLS_FLAG_BALANCING_ACTIVE : 0;
+  buffer[3] = 0;
+  buffer[4] = cells & 0xFF;
+  buffer[5] = cells >> 8;
+
+  uint8_t* voltages = buffer + LIVE_CELLS_HEADER_SIZE;
+  uint8_t* balancing = voltages + cells * 2;
+  memset(balancing, 0, (cells + 7) / 8);
+  for (uint16_t i = 0; i < cells; i++) {
+    voltages[i * 2] = battery.status.cell_voltages_mV[i] & 0xFF;
+    voltages[i * 2 + 1] = battery.status.cell_voltages_mV[i] >> 8;
+    if (battery.status.cell_balancing_status[i]) {
+      balancing[i / 8] |= 1 << (i % 8);
+    }
+  }
+  return length;
+}
+
+uint32_t ChangeSequence::update(const void* data, size_t length) {
+  // FNV-1a
+  uint32_t new_hash = 2166136261u;
+  const uint8_t* bytes = static_cast<const uint8_t*>(data);
+  for (size_t i = 0; i < length; i++) {
+    new_hash = (new_hash ^ bytes[i]) * 16777619u;
+  }
+  if (seq == 0 || new_hash != hash) {
+    hash = new_hash;
+    seq++;
+  }
+  return seq;
+}
@@ -0,0 +1,70 @@
+#ifndef __LIVE_DATA_H__
+#define __LIVE_DATA_H__
+
+#include <stddef.h>
+#include <stdint.h>
+#include "../../datalayer/datalayer_snapshot.h"
+
+/* Measured values for the web pages to poll, instead of reloading a page built on the server. The pages ask with
+ * the sequence number of the values they have and get 304 Not Modified until the values change, see
+ * ChangeSequence.
+ *
+ * /api/live is JSON, "v" is the format version and is raised when fields change meaning or are removed:
+ *   {"v":1,"contactors":1,"inverter_allows_closing":true,"batteries":[{"soc":55.12,"soc_reported":55.12,
+ *    "soh":99,"voltage":371.2,"current":-1.5,"power":-557,"temp_min":21.5,"temp_max":22,"cell_min":3.712,
+ *    "cell_max":3.718,"cell_min_index":17,"cell_max_index":80,"cell_mean":3.715,"cell_stddev":1.4,
+ *    "cells_balancing":0,"cells_stale":0,"max_charge_power":5000,"max_discharge_power":5000,
+ *    "remaining_capacity":33000,"total_capacity":60000,"cells":96,"status":"OK","balancing":false}, ...]}
+ *
+ * /api/cells?battery=n is binary, the cells of one battery, all numbers little endian:
+ *   byte 0     LIVE_CELLS_VERSION
+ *   byte 1     battery number, 1 to 3
+ *   byte 2     LIVE_CELLS_FLAG_* bits
+ *   byte 3     0
+ *   byte 4-5   number of cells n
+ *   6 + 2 * i  voltage of cell i in mV, 0 if not read yet
+ *   then       (n + 7) / 8 bytes with a bit per cell, least significant bit first, set while the cell is balancing
+ */
+
+#define LIVE_DATA_VERSION 1
+#define LIVE_CELLS_VERSION 1
+#define LIVE_CELLS_HEADER_SIZE 6
+#define LIVE_CELLS_FLAG_BALANCING_ACTIVE 0x01  // balancing_status, for batteries without per-cell data
+#define LIVE_CELLS_MAX_SIZE (LIVE_CELLS_HEADER_SIZE + MAX_AMOUNT_CELLS * 2 + (MAX_AMOUNT_CELLS + 7) / 8)
+
+/**
+ * @brief Writes the /api/live JSON
+ *
+ * @param[out] buffer
+ * @param[in] size
+ * @param[in] snapshot
+ * @param[in] batteries Number of batteries configured, 1 to 3
+ *
+ * @return size_t Length of the JSON, 0 if it did not fit
+ */
+size_t live_data_json(char* buffer, size_t size, const DATALAYER_SNAPSHOT_TYPE& snapshot, uint8_t batteries);
+
+/**
+ * @brief Packs the cells of one battery for /api/cells
+ *
+ * @param[out] buffer
+ * @param[in] size
+ * @param[in] battery
+ * @param[in] number Battery number, 1 to 3
+ *
+ * @return size_t Length of the data, 0 if it did not fit
+ */
+size_t live_cells_pack(uint8_t* buffer, size_t size, const DATALAYER_BATTERY_TYPE& battery, uint8_t number);
+
+// Sequence number of a resource, counts up each time its content differs from the last time
+class ChangeSequence {
+ public:
+  uint32_t update(const void* data, size_t length);
+  uint32_t sequence() const { return seq; }
+
+ private:
+  uint32_t hash = 0;
+  uint32_t seq = 0;
+};
+
+#endif
@@ -514,6 +514,26 @@ String raw_settings_processor(const String& var, BatteryEmulatorSettingsStore& s
     return settings.getBool("MQTTCELLV") ? "checked" : "";
   }
 
+  if (var == "MQTTCELLPACK") {
+    return settings.getBool("MQTTCELLPACK") ? "checked" : "";
+  }
+
+  if (var == "MQTTDELTA") {
+    return settings.getBool("MQTTDELTA") ? "checked" : "";
+  }
+
+  if (var == "MQTTCELLDB") {
+    return String(settings.getUInt("MQTTCELLDB", 5));
+  }
+
+  if (var == "MQTTSOCDB") {
+    return String(settings.getUInt("MQTTSOCDB", 10));
+  }
+
+  if (var == "MQTTHEARTBEAT") {
+    return String(settings.getUInt("MQTTHEARTBEAT", 60));
+  }
+
   if (var == "HADEVICEID") {
     return settings.getString("HADEVICEID");
   }
@@ -748,6 +768,10 @@ String raw_settings_processor(const String& var, BatteryEmulatorSettingsStore& s
     return String(settings.getUInt("CANFDFREQ", 40));
   }
 
+  if (var == "CANRXBUDGET") {
+    return String(settings.getUInt("CANRXBUDGET", CAN_RX_FRAMES_PER_TICK));
+  }
+
   if (var == "PRECHGMS") {
     return String(settings.getUInt("PRECHGMS", 100));
   }
@@ -1333,6 +1357,11 @@ const char* getCANInterfaceName(CAN_Interface interface) {
         <input type='number' name='CANFDFREQ' value="%CANFDFREQ%" 
         min="0" max="1000" step="1"
         title="Configure this if you are using a custom add-on CAN board. Integers only" />
+
+        <label>CAN RX frames per tick: </label>
+        <input type='number' name='CANRXBUDGET' value="%CANRXBUDGET%" 
+        min="1" max="255" step="1"
+        title="Maximum number of CAN frames handled per interface each millisecond. Raise if the CAN RX statistics report overflows" />
         
         <label>Equipment stop button: </label><select name='EQSTOP'>
         %EQSTOP%  
@@ -1480,6 +1509,22 @@ const char* getCANInterfaceName(CAN_Interface interface) {
         min="1" max="60000" step="1"
         title="Timeout in milliseconds (1-60000)" />
         <label>Send all cellvoltages via MQTT: </label><input type='checkbox' name='MQTTCELLV' value='on' %MQTTCELLV% />
+        <label>Compact cellvoltages (mV above lowest cell): </label>
+        <input type='checkbox' name='MQTTCELLPACK' value='on' %MQTTCELLPACK% />
+        <label>Publish values on change: </label>
+        <input type='checkbox' name='MQTTDELTA' value='on' %MQTTDELTA% />
+        <label>On change, cell voltage deadband mV: </label>
+        <input name='MQTTCELLDB' type='number' value="%MQTTCELLDB%" 
+        min="0" max="1000" step="1"
+        title="Cell voltage change in mV that is published (0-1000)" />
+        <label>On change, SOC deadband in 0.01 percent: </label>
+        <input name='MQTTSOCDB' type='number' value="%MQTTSOCDB%" 
+        min="0" max="10000" step="1"
+        title="SOC change in hundredths of a percent that is published (0-10000)" />
+        <label>On change, publish everything every s: </label>
+        <input name='MQTTHEARTBEAT' type='number' value="%MQTTHEARTBEAT%" 
+        min="5" max="3600" step="1"
+        title="Seconds between full refreshes (5-3600)" />
         <label>Remote BMS reset via MQTT allowed: </label>
         <input type='checkbox' name='REMBMSRESET' value='on' %REMBMSRESET% />
         <label>Customized MQTT topics: </label>
@@ -0,0 +1,296 @@
+#include "web_assets.h"
+#include <stdint.h>
+#include <stdio.h>
+#include "index_html.h"
+
+static const char MAIN_PAGE_CSS[] = R"rawliteral(
+body { background-color: black; color: white; }
+button { background-color: #505E67; color: white; border: none; padding: 10px 20px; margin-bottom: 20px; cursor: pointer; border-radius: 10px; }
+button:hover { background-color: #3A4A52; }
+h2 { font-size: 1.2em; margin: 0.3em 0 0.5em 0; }
+h4 { margin: 0.6em 0; line-height: 1.2; }
+.tooltip .tooltiptext {
+  visibility: hidden;
+  width: 200px;
+  background-color: #3A4A52;
+  color: white;
+  text-align: center;
+  border-radius: 6px;
+  padding: 8px;
+  position: absolute;
+  z-index: 1;
+  margin-left: -100px;
+  opacity: 0;
+  transition: opacity 0.3s;
+  font-size: 0.9em;
+  font-weight: normal;
+  line-height: 1.4;
+}
+.tooltip:hover .tooltiptext { visibility: visible; opacity: 1; }
+.tooltip-icon { color: #505E67; cursor: help; }
+)rawliteral";
+
+static const char CELLMONITOR_CSS[] = R"rawliteral(
+body { background-color: black; color: white; }
+button { background-color: #505E67; color: white; border: none; padding: 10px 20px; margin-bottom: 20px; cursor: pointer; border-radius: 10px; }
+button:hover { background-color: #3A4A52; }
+.container { display: flex; flex-wrap: wrap; justify-content: space-around; }
+.cell { padding: 10px; border: 1px solid white; text-align: center; }
+.low-voltage { color: red; }
+.voltage-values { margin-bottom: 10px; }
+#graph, #graph2, #graph3 { display: flex; align-items: flex-end; height: 200px; border: 1px solid #ccc; position: relative; }
+.bar { margin: 0 0px; background-color: blue; display: inline-block; position: relative; cursor: pointer; border: 1px solid white; }
+#valueDisplay, #valueDisplay2, #valueDisplay3 { text-align: left; font-weight: bold; margin-top: 10px; }
+)rawliteral";
+
+// The page only has the layout, the cells are fetched from /api/cells (see live_data.h) every second. Each battery
+// gets a block the first time its cells arrive, the bars are scaled from margin mV below the lowest cell to margin mV
+// above the highest one onto margin to height px.
+static const char CELLMONITOR_HTML[] = INDEX_HTML_HEADER R"rawliteral(
+<link rel='stylesheet' href='/cellmonitor.css'>
+<button onclick='home()'>Back to main page</button>
+<div id='batteries'></div>
+<button onclick='home()'>Back to main page</button>
+<script src='/cellmonitor.js'></script>
+)rawliteral" INDEX_HTML_FOOTER
+
+static const char CELLMONITOR_JS[] = R"rawliteral(
+function home() { window.location.href = '/'; }
+function map(value, fromLow, fromHigh, toLow, toHigh) {
+  return (value - fromLow) * (toHigh - toLow) / (fromHigh - fromLow) + toLow;
+}
+const layouts = [
+  { n: '', color: '#303E47', margin: 20, height: 200, title: '' },
+  { n: '2', color: '#303E41', margin: 20, height: 200, title: 'Battery #2<br>' },
+  { n: '3', color: '#313e41ff', margin: 30, height: 300, title: 'Battery #3<br>' },
+];
+const seq = [0, 0, 0];
+const absent = [false, false, false];
+function legend(color, background, text, margin) {
+  return `<span style='color: ${color}; background-color: ${background}; font-weight: bold; padding: 2px 8px; ` +
+    `border-radius: 4px; margin-right: ${margin}px;'>${text}</span>`;
+}
+function block(layout) {
+  let div = document.getElementById('block' + layout.n);
+  if (!div) {
+    div = document.createElement('div');
+    div.id = 'block' + layout.n;
+    div.style.cssText = `background-color: ${layout.color}; padding: 10px; margin-bottom: 10px; border-radius: 50px`;
+    document.getElementById('batteries').appendChild(div);
+  }
+  return div;
+}
+function parseCells(buffer) {
+  const view = new DataView(buffer);
+  const count = view.getUint16(4, true);
+  const cells = { count: count, balancingActive: (view.getUint8(2) & 1) == 1, data: [], balancing: [] };
+  for (let i = 0; i < count; i++) {
+    const mV = view.getUint16(6 + i * 2, true);
+    if (mV == 0) {
+      continue;
+    }
+    cells.data.push(mV);
+    cells.balancing.push(((view.getUint8(6 + count * 2 + (i >> 3)) >> (i & 7)) & 1) == 1);
+  }
+  return cells;
+}
+function showCells(index, cells) {
+  const layout = layouts[index];
+  const n = layout.n;
+  const data = cells.data;
+  const balancing = cells.balancing;
+  const balancingNow = index == 0 && cells.balancingActive;
+  let html = `<div id='voltageValues${n}' class='voltage-values'></div><div id='cellContainer${n}' class='container'>` +
+    `</div><div id='graph${n}'></div><div id='valueDisplay${n}'>Value: ...</div>` + legend('white', 'blue', 'Idle', 15);
+  if (balancing.includes(true)) {
+    html += legend('black', '#00FFFF', 'Balancing', 15);
+  } else if (balancingNow) {
+    html += legend('black', '#ff9900ff', 'Balancing is active now!', 15);
+  }
+  block(layout).innerHTML = html + legend('white', 'red', 'Min/Max', 0);
+
+  const voltVal = document.getElementById('voltageValues' + n);
+  if (data.length == 0) {
+    voltVal.textContent = cells.count > 0 ? `${cells.count} cells configured, but cellvoltages not yet read`
+                                          : 'Amount of cells unknown. Cellvoltages not yet read';
+    return;
+  }
+  const graphContainer = document.getElementById('graph' + n);
+  const valueDisplay = document.getElementById('valueDisplay' + n);
+  const cellContainer = document.getElementById('cellContainer' + n);
+  const min = Math.min(...data);
+  const max = Math.max(...data);
+  const min_index = data.indexOf(min);
+  const max_index = data.indexOf(max);
+  data.forEach((mV, index) => {
+    const cell = document.createElement('div');
+    cell.className = 'cell';
+    cell.id = `cellIndex${n}${index}`;
+    let cellContent = `Cell ${index + 1}<br>${mV} mV`;
+    if (mV < 3000) {
+      cellContent = `<span class='low-voltage'>${cellContent}</span>`;
+    }
+    cell.innerHTML = cellContent;
+    cell.addEventListener('mouseenter', () => {
+      let bar = document.getElementById(`barIndex${n}${index}`);
+      valueDisplay.textContent = `Value: ${mV}`;
+      bar.style.backgroundColor = balancing[index] ? '#80FFFF' : 'lightblue';
+      cell.style.backgroundColor = balancing[index] ? '#006666' : 'blue';
+    });
+    cell.addEventListener('mouseleave', () => {
+      let bar = document.getElementById(`barIndex${n}${index}`);
+      bar.style.backgroundColor = balancing[index] ? '#00FFFF' : 'blue';
+      cell.style.removeProperty('background-color');
+    });
+    cellContainer.appendChild(cell);
+  });
+  data.forEach((mV, index) => {
+    const bar = document.createElement('div');
+    bar.className = 'bar';
+    bar.id = `barIndex${n}${index}`;
+    bar.style.height = `${map(mV, min - layout.margin, max + layout.margin, layout.margin, layout.height)}px`;
+    bar.style.width = `${750 / data.length}px`;
+    bar.style.backgroundColor = balancing[index] ? '#00FFFF' : 'blue';
+    bar.style.borderColor = balancing[index] ? '#00FFFF' : 'white';
+    const cell = document.getElementById(`cellIndex${n}${index}`);
+    if (index == min_index || index == max_index) {
+      cell.style.borderColor = 'red';
+      bar.style.borderColor = 'red';
+    }
+    bar.addEventListener('mouseenter', () => {
+      valueDisplay.textContent = `Value: ${mV}` + (balancing[index] ? ' (balancing)' : '');
+      bar.style.backgroundColor = balancing[index] ? '#80FFFF' : 'lightblue';
+      cell.style.backgroundColor = balancing[index] ? '#006666' : 'blue';
+    });
+    bar.addEventListener('mouseleave', () => {
+      valueDisplay.textContent = 'Value: ...';
+      bar.style.backgroundColor = balancing[index] ? '#00FFFF' : 'blue';
+      cell.style.removeProperty('background-color');
+    });
+    graphContainer.appendChild(bar);
+  });
+  voltVal.innerHTML = `${layout.title}Max Voltage : ${max} mV<br>Min Voltage: ${min} mV<br>Voltage Deviation: ` +
+    `${max - min} mV${balancingNow ? ' (Battery is balancing now!)' : ''}`;
+}
+// Only changed cells are sent, the server answers 304 while the page has the latest ones
+function update(index) {
+  if (absent[index]) {
+    return;
+  }
+  fetch(`/api/cells?battery=${index + 1}` + (seq[index] ? `&since=${seq[index]}` : ''))
+    .then(response => {
+      if (response.status == 404) {
+        absent[index] = true;
+      }
+      if (response.status != 200) {
+        return;
+      }
+      seq[index] = Number(response.headers.get('X-Next-Seq'));
+      return response.arrayBuffer().then(buffer => showCells(index, parseCells(buffer)));
+    })
+    .catch(error => console.error('Error:', error));
+}
+function updateAll() { layouts.forEach((layout, index) => update(index)); }
+updateAll();
+setInterval(updateAll, 1000);
+)rawliteral";
+
+static const char CAN_REPLAY_JS[] = R"rawliteral(
+const fileInput = document.getElementById('file-input');
+const uploadBtn = document.getElementById('upload-btn');
+const fileContent = document.getElementById('file-content');
+let selectedFile = null;
+fileInput.addEventListener('change', () => { selectedFile = fileInput.files[0]; });
+uploadBtn.addEventListener('click', () => {
+  if (!selectedFile) { alert('Please select a file first!'); return; }
+  const formData = new FormData();
+  formData.append('file', selectedFile);
+  const xhr = new XMLHttpRequest();
+  xhr.open('POST', '/import_can_log', true);
+  xhr.onload = () => {
+    if (xhr.status === 200) {
+      alert('File uploaded successfully!');
+      const reader = new FileReader();
+      reader.onload = function (e) { fileContent.textContent = e.target.result; };
+      reader.readAsText(selectedFile);
+      updateReplayStatus();
+    } else {
+      alert('Upload failed! ' + xhr.responseText);
+    }
+  };
+  xhr.send(formData);
+});
+function startReplay() {
+  let loop = document.getElementById('loopCheckbox').checked ? 1 : 0;
+  fetch('/startReplay?loop=' + loop, { method: 'GET' })
+    .then(response => response.text())
+    .then(data => {
+      console.log(data);
+      document.getElementById('statusIndicator').innerText = 'Running...';
+      document.getElementById('statusIndicator').style.color = 'green';
+      if (loop === 0) {
+        setTimeout(() => {
+          document.getElementById('statusIndicator').innerText = 'Completed';
+          document.getElementById('statusIndicator').style.color = 'white';
+        }, 5000);
+      }
+    })
+    .catch(error => console.error('Error:', error));
+}
+function stopReplay() {
+  fetch('/stopReplay', { method: 'GET' })
+    .then(response => response.text())
+    .then(data => {
+      console.log(data);
+      document.getElementById('statusIndicator').innerText = 'Stopped';
+      document.getElementById('statusIndicator').style.color = 'red';
+    })
+    .catch(error => console.error('Error:', error));
+}
+function sendCANSelection() {
+  var selectedInterface = document.getElementById('canInterface').value;
+  var xhr = new XMLHttpRequest();
+  xhr.open('GET', '/setCANInterface?interface=' + selectedInterface, true);
+  xhr.onreadystatechange = function() {
+    if (xhr.readyState === 4) {
+      if (xhr.status === 200) {
+        alert('Success: ' + xhr.responseText);
+      } else {
+        alert('Error: ' + xhr.responseText);
+      }
+    }
+  };
+  xhr.send();
+}
+function updateReplayStatus() {
+  fetch('/replayStatus').then(response => response.text())
+    .then(data => { document.getElementById('replayStatus').innerText = data; });
+}
+function loadSDReplay() {
+  fetch('/loadSDReplay').then(response => response.text())
+    .then(data => { document.getElementById('replayStatus').innerText = data; });
+}
+setInterval(updateReplayStatus, 1000);
+function home() { window.location.href = '/'; }
+)rawliteral";
+
+WebAsset main_page_css = {"/main.css", "text/css", MAIN_PAGE_CSS, sizeof(MAIN_PAGE_CSS) - 1, ""};
+WebAsset cellmonitor_css = {"/cellmonitor.css", "text/css", CELLMONITOR_CSS, sizeof(CELLMONITOR_CSS) - 1, ""};
+WebAsset cellmonitor_page = {"/cellmonitor", "text/html", CELLMONITOR_HTML, sizeof(CELLMONITOR_HTML) - 1, ""};
+WebAsset cellmonitor_js = {"/cellmonitor.js", "text/javascript", CELLMONITOR_JS, sizeof(CELLMONITOR_JS) - 1, ""};
+WebAsset can_replay_js = {"/canreplay.js", "text/javascript", CAN_REPLAY_JS, sizeof(CAN_REPLAY_JS) - 1, ""};
+
+WebAsset* const web_assets[] = {&main_page_css, &cellmonitor_page, &cellmonitor_css, &cellmonitor_js,
+                                   &can_replay_js};
+const size_t web_assets_count = sizeof(web_assets) / sizeof(web_assets[0]);
+
+const char* web_asset_etag(WebAsset& asset) {
+  if (asset.etag[0] == '\0') {
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < asset.length; i++) {
+      hash = (hash ^ (uint8_t)asset.content[i]) * 16777619u;
+    }
+    snprintf(asset.etag, sizeof(asset.etag), "\"%08x\"", (unsigned)hash);
+  }
+  return asset.etag;
+}
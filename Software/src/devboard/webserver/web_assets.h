@@ -0,0 +1,31 @@
+#ifndef WEB_ASSETS_H
+#define WEB_ASSETS_H
+
+#include <stddef.h>
+
+/* Pages, style sheets and scripts that are the same on every page view, served separately so the browser can cache
+ * them. Pages that are only a layout get their values from the live data API, see live_data.h.
+ * The ETag is a hash of the content, so a firmware update with changed content is picked up on the next view.
+ */
+struct WebAsset {
+  const char* path;
+  const char* content_type;
+  const char* content;
+  size_t length;
+  // "<hash>" with quotes as sent in the ETag header, see web_asset_etag()
+  char etag[11];
+};
+
+extern WebAsset main_page_css;
+extern WebAsset cellmonitor_page;
+extern WebAsset cellmonitor_css;
+extern WebAsset cellmonitor_js;
+extern WebAsset can_replay_js;
+
+extern WebAsset* const web_assets[];
+extern const size_t web_assets_count;
+
+// The ETag of the asset, computed on first use
+const char* web_asset_etag(WebAsset& asset);
+
+#endif  // WEB_ASSETS_H
@@ -1,22 +1,29 @@
 #include "webserver.h"
 #include <Preferences.h>
+#include <algorithm>
 #include <ctime>
 #include <vector>
 #include "../../battery/BATTERIES.h"
 #include "../../battery/Battery.h"
 #include "../../charger/CHARGERS.h"
+#include "../../communication/can/can_replay.h"
 #include "../../communication/can/comm_can.h"
 #include "../../communication/contactorcontrol/comm_contactorcontrol.h"
 #include "../../communication/equipmentstopbutton/comm_equipmentstopbutton.h"
 #include "../../communication/nvm/comm_nvm.h"
 #include "../../datalayer/datalayer.h"
 #include "../../datalayer/datalayer_extended.h"
+#include "../../datalayer/datalayer_snapshot.h"
+#include "../../datalayer/history.h"
 #include "../../inverter/INVERTERS.h"
 #include "../../lib/bblanchon-ArduinoJson/ArduinoJson.h"
 #include "../sdcard/sdcard.h"
+#include "../utils/event_journal.h"
 #include "../utils/events.h"
 #include "../utils/led_handler.h"
+#include "../utils/perf_stats.h"
 #include "../utils/timer.h"
+#include "../utils/web_log.h"
 #include "esp_task_wdt.h"
 #include "html_escape.h"
 
@@ -35,146 +42,182 @@ unsigned long ota_progress_millis = 0;
 #include "advanced_battery_html.h"
 #include "can_logging_html.h"
 #include "can_replay_html.h"
-#include "cellmonitor_html.h"
 #include "debug_logging_html.h"
 #include "events_html.h"
 #include "index_html.h"
+#include "live_data.h"
 #include "settings_html.h"
+#include "web_assets.h"
 
 MyTimer ota_timeout_timer = MyTimer(15000);
 bool ota_active = false;
 
 const char get_firmware_info_html[] = R"rawliteral(%X%)rawliteral";
 
-String importedLogs = "";      // Store the uploaded logfile contents in RAM
-bool isReplayRunning = false;  // Global flag to track replay state
-
 // True when user has updated settings that need a reboot to be effective.
 bool settingsUpdated = false;
 
-CAN_frame currentFrame = {.FD = true, .ext_ID = false, .DLC = 64, .ID = 0x12F, .data = {0}};
-
 void handleFileUpload(AsyncWebServerRequest* request, String filename, size_t index, uint8_t* data, size_t len,
                       bool final) {
   if (!index) {
-    importedLogs = "";  // Clear previous logs
-    logging.printf("Receiving file: %s\n", filename.c_str());
+    // Previous log is replaced, the new one is parsed while it is received
+    if (!can_replay_load_begin()) {
+      logging.println("Upload rejected, CAN replay running");
+    } else {
+      logging.printf("Receiving file: %s\n", filename.c_str());
+    }
   }
 
-  // Append received data to the string (RAM storage)
-  importedLogs += String((char*)data).substring(0, len);
+  if (!can_replay_running()) {
+    can_replay_load_chunk(data, len);
+  }
 
   if (final) {
+    if (can_replay_running()) {
+      request->send(409, "text/plain", "Stop the CAN replay before uploading a new log");
+      return;
+    }
+    can_replay_load_end();
     logging.println("Upload Complete!");
     request->send(200, "text/plain", "File uploaded successfully");
   }
 }
 
-void canReplayTask(void* param) {
-  std::vector<String> messages;
-  messages.reserve(1000);  // Pre-allocate memory to reduce fragmentation
-
-  if (!importedLogs.isEmpty()) {
-    int lastIndex = 0;
-
-    while (true) {
-      int nextIndex = importedLogs.indexOf("\n", lastIndex);
-      if (nextIndex == -1) {
-        messages.push_back(importedLogs.substring(lastIndex));
-        break;
-      }
-      messages.push_back(importedLogs.substring(lastIndex, nextIndex));
-      lastIndex = nextIndex + 1;
+void def_route_with_auth(const char* uri, AsyncWebServer& serv, WebRequestMethodComposite method,
+                         std::function<void(AsyncWebServerRequest*)> handler) {
+  serv.on(uri, method, [handler](AsyncWebServerRequest* request) {
+    if (webserver_auth && !request->authenticate(http_username.c_str(), http_password.c_str())) {
+      return request->requestAuthentication();
     }
+    handler(request);
+  });
+}
 
-    do {
-      float firstTimestamp = -1.0f;
-      float lastTimestamp = 0.0f;
-      bool firstMessageSent = false;  // Track first message
-
-      for (size_t i = 0; i < messages.size(); i++) {
-        String line = messages[i];
-        line.trim();
-        if (line.length() == 0)
-          continue;
-
-        int timeStart = line.indexOf("(") + 1;
-        int timeEnd = line.indexOf(")");
-        if (timeStart == 0 || timeEnd == -1)
-          continue;
-
-        float currentTimestamp = line.substring(timeStart, timeEnd).toFloat();
+// Streams a RAM log from record since onwards, the records are formatted as text while sending
+static AsyncWebServerResponse* begin_web_log_response(AsyncWebServerRequest* request, WebLog log, uint32_t since) {
+  auto log_export = std::make_shared<WebLogTextExport>(log, since);
+  AsyncWebServerResponse* response = request->beginChunkedResponse(
+      "text/plain", [log_export](uint8_t* buffer, size_t maxLen, size_t index) -> size_t {
+        return log_export->read(buffer, maxLen);
+      });
+  // The log pages ask for the records from here on with their next poll
+  response->addHeader("X-Next-Seq", String(log_export->next_sequence()));
+  return response;
+}
 
-        if (firstTimestamp < 0) {
-          firstTimestamp = currentTimestamp;
+/* Sends a page built by build with a chunked response, the page is written while sending. With performance
+ * measurement active the size, time to first byte and heap used while sending are logged once it is done.
+ */
+static void send_page(AsyncWebServerRequest* request, const char* name, void (*build)(HtmlPageStream&)) {
+  auto page = std::make_shared<HtmlPageStream>();
+  build(*page);
+
+  const uint32_t start_us = micros();
+  const uint32_t free_heap_at_start = ESP.getFreeHeap();
+  uint32_t first_byte_us = 0;
+  uint32_t min_free_heap = free_heap_at_start;
+  size_t total = 0;
+  request->send(request->beginChunkedResponse(
+      "text/html", [=](uint8_t* buffer, size_t maxLen, size_t index) mutable -> size_t {
+        const size_t length = page->read(buffer, maxLen);
+        if (!datalayer.system.info.performance_measurement_active) {
+          return length;
         }
-
-        // Send first message immediately
-        if (!firstMessageSent) {
-          firstMessageSent = true;
-          firstTimestamp = currentTimestamp;  // Adjust reference time
-        } else {
-          // Delay only if this isn't the first message
-          float deltaT = (currentTimestamp - lastTimestamp) * 1000;
-          vTaskDelay((int)deltaT / portTICK_PERIOD_MS);
+        if (index == 0) {
+          first_byte_us = micros() - start_us;
         }
+        min_free_heap = std::min(min_free_heap, ESP.getFreeHeap());
+        total += length;
+        if (length == 0) {
+          logging.printf("Web page %s: %u bytes, first byte after %u us, heap used %u bytes, %u parts cut off\n", name,
+                         (unsigned)total, (unsigned)first_byte_us, (unsigned)(free_heap_at_start - min_free_heap),
+                         (unsigned)page->overflows());
+        }
+        return length;
+      }));
+}
 
-        lastTimestamp = currentTimestamp;
-
-        int interfaceStart = timeEnd + 2;
-        int interfaceEnd = line.indexOf(" ", interfaceStart);
-        if (interfaceEnd == -1)
-          continue;
-
-        int idStart = interfaceEnd + 1;
-        int idEnd = line.indexOf(" [", idStart);
-        if (idStart == -1 || idEnd == -1)
-          continue;
-
-        String messageID = line.substring(idStart, idEnd);
-        int dlcStart = idEnd + 2;
-        int dlcEnd = line.indexOf("]", dlcStart);
-        if (dlcEnd == -1)
-          continue;
-
-        String dlc = line.substring(dlcStart, dlcEnd);
-        int dataStart = dlcEnd + 2;
-        String dataBytes = line.substring(dataStart);
+// Static files with an ETag, the browser asks again on each view and gets 304 Not Modified while they are unchanged
+static void def_asset_routes(AsyncWebServer& serv) {
+  for (size_t i = 0; i < web_assets_count; i++) {
+    WebAsset* asset = web_assets[i];
+    def_route_with_auth(asset->path, serv, HTTP_GET, [asset](AsyncWebServerRequest* request) {
+      const char* etag = web_asset_etag(*asset);
+      if (request->hasHeader("If-None-Match") && request->header("If-None-Match") == etag) {
+        request->send(304);
+        return;
+      }
+      AsyncWebServerResponse* response =
+          request->beginResponse(200, asset->content_type, (const uint8_t*)asset->content, asset->length);
+      response->addHeader("ETag", etag);
+      response->addHeader("Cache-Control", "no-cache");
+      request->send(response);
+    });
+  }
+}
 
-        currentFrame.ID = strtol(messageID.c_str(), NULL, 16);
-        currentFrame.DLC = dlc.toInt();
+static uint32_t since_parameter(AsyncWebServerRequest* request) {
+  return request->hasParam("since") ? request->getParam("since")->value().toInt() : 0;
+}
 
-        int byteIndex = 0;
-        char* token = strtok((char*)dataBytes.c_str(), " ");
-        while (token != NULL && byteIndex < currentFrame.DLC) {
-          currentFrame.data.u8[byteIndex++] = strtol(token, NULL, 16);
-          token = strtok(NULL, " ");
-        }
+/* Values for /api/live and /api/cells, see live_data.h. They are rendered once per update round of the core task
+ * and shared by all clients.
+ */
+static struct {
+  DATALAYER_SNAPSHOT_TYPE snapshot;
+  uint32_t snapshot_version = UINT32_MAX;
+  char json[2048];  // Room for three batteries
+  size_t json_length = 0;
+  ChangeSequence json_sequence;
+  uint8_t cells[3][LIVE_CELLS_MAX_SIZE];
+  size_t cells_length[3] = {};
+  ChangeSequence cells_sequence[3];
+} live;
+
+static uint8_t battery_count() {
+  return battery3 ? 3 : battery2 ? 2 : 1;
+}
 
-        currentFrame.FD = (datalayer.system.info.can_replay_interface == CANFD_NATIVE) ||
-                          (datalayer.system.info.can_replay_interface == CANFD_ADDON_MCP2518);
-        currentFrame.ext_ID = (currentFrame.ID > 0x7F0);
+static void refresh_live_data() {
+  const uint32_t version = datalayer_snapshot_version();
+  if (version == live.snapshot_version) {
+    return;
+  }
+  live.snapshot_version = version;
+  read_datalayer_snapshot(live.snapshot);
 
-        transmit_can_frame_to_interface(&currentFrame, (CAN_Interface)datalayer.system.info.can_replay_interface);
-      }
-    } while (datalayer.system.info.loop_playback);
+  const uint8_t batteries = battery_count();
+  live.json_length = live_data_json(live.json, sizeof(live.json), live.snapshot, batteries);
+  live.json_sequence.update(live.json, live.json_length);
 
-    messages.clear();          // Free vector memory
-    messages.shrink_to_fit();  // Release excess memory
+  const DATALAYER_BATTERY_TYPE* packs[3] = {&live.snapshot.battery, &live.snapshot.battery2, &live.snapshot.battery3};
+  for (uint8_t i = 0; i < batteries; i++) {
+    live.cells_length[i] = live_cells_pack(live.cells[i], sizeof(live.cells[i]), *packs[i], i + 1);
+    live.cells_sequence[i].update(live.cells[i], live.cells_length[i]);
   }
+}
 
-  isReplayRunning = false;  // Mark replay as stopped
-  vTaskDelete(NULL);
+/* A response with a copy of data. beginResponse() with a pointer sends from the buffer itself as the client
+ * acknowledges, so the buffer could be written again by the next request while this one is still sending.
+ */
+static AsyncResponseStream* begin_copied_response(AsyncWebServerRequest* request, const char* content_type,
+                                                  const uint8_t* data, size_t length) {
+  AsyncResponseStream* response = request->beginResponseStream(content_type, length);
+  response->write(data, length);
+  return response;
 }
 
-void def_route_with_auth(const char* uri, AsyncWebServer& serv, WebRequestMethodComposite method,
-                         std::function<void(AsyncWebServerRequest*)> handler) {
-  serv.on(uri, method, [handler](AsyncWebServerRequest* request) {
-    if (webserver_auth && !request->authenticate(http_username.c_str(), http_password.c_str())) {
-      return request->requestAuthentication();
-    }
-    handler(request);
-  });
+// Sends data with its sequence number, or 304 if the page already has it
+static void send_live_data(AsyncWebServerRequest* request, const char* content_type, const uint8_t* data, size_t length,
+                           const ChangeSequence& sequence) {
+  if (request->hasParam("since") && since_parameter(request) == sequence.sequence()) {
+    request->send(304);
+    return;
+  }
+  AsyncWebServerResponse* response = begin_copied_response(request, content_type, data, length);
+  response->addHeader("X-Next-Seq", String(sequence.sequence()));
+  response->addHeader("Cache-Control", "no-store");
+  request->send(response);
 }
 
 void init_webserver() {
@@ -186,9 +229,96 @@ void init_webserver() {
     request->send(200, "application/json", get_firmware_info_html, get_firmware_info_processor);
   });
 
+  // Execution time statistics of the core task as JSON, see perf_stats.h
+  def_route_with_auth("/perf", server, HTTP_GET, [](AsyncWebServerRequest* request) {
+    static char json[1024];
+    if (perf_stats_serialize(json, sizeof(json)) == 0) {
+      request->send(500, "text/plain", "Statistics too large");
+      return;
+    }
+    request->send(200, "application/json", json);
+  });
+
+  // Measured values for the pages to poll, see live_data.h
+  def_route_with_auth("/api/live", server, HTTP_GET, [](AsyncWebServerRequest* request) {
+    refresh_live_data();
+    if (live.json_length == 0) {
+      request->send(500, "text/plain", "Values too large");
+      return;
+    }
+    send_live_data(request, "application/json", (const uint8_t*)live.json, live.json_length, live.json_sequence);
+  });
+
+  def_route_with_auth("/api/cells", server, HTTP_GET, [](AsyncWebServerRequest* request) {
+    refresh_live_data();
+    const int number = request->hasParam("battery") ? request->getParam("battery")->value().toInt() : 1;
+    if (number < 1 || number > battery_count()) {
+      request->send(404, "text/plain", "No such battery");
+      return;
+    }
+    send_live_data(request, "application/octet-stream", live.cells[number - 1], live.cells_length[number - 1],
+                   live.cells_sequence[number - 1]);
+  });
+
+  // Occurrences of events, a page at a time, see events_html.h
+  def_route_with_auth("/api/events", server, HTTP_GET, [](AsyncWebServerRequest* request) {
+    static char json[2048];
+    uint32_t next;
+    const size_t length = events_history_json(json, sizeof(json), since_parameter(request), next);
+    if (length == 0) {
+      request->send(500, "text/plain", "Events too large");
+      return;
+    }
+    AsyncWebServerResponse* response =
+        begin_copied_response(request, "application/json", (const uint8_t*)json, length);
+    response->addHeader("X-Next-Seq", String(next));
+    response->addHeader("Cache-Control", "no-store");
+    request->send(response);
+  });
+
+  // Journal of events in flash as CSV, oldest first, see event_journal.h
+  def_route_with_auth("/api/journal", server, HTTP_GET, [](AsyncWebServerRequest* request) {
+    if (!event_journal.ready()) {
+      request->send(404, "text/plain", "No event journal");
+      return;
+    }
+    auto journal_export = std::make_shared<JournalTextExport>(event_journal);
+    AsyncWebServerResponse* response = request->beginChunkedResponse(
+        "text/csv", [journal_export](uint8_t* buffer, size_t maxLen, size_t index) -> size_t {
+          return journal_export->read(buffer, maxLen);
+        });
+    response->addHeader("Content-Disposition", "attachment; filename=\"event_journal.csv\"");
+    request->send(response);
+  });
+
+  /* History of the main battery from RAM, see history.h. series is pack (default) or cells, from and to limit the
+   * range in milliseconds since startup, format is csv (default) or bin for the compressed blocks as stored.
+   */
+  def_route_with_auth("/api/history", server, HTTP_GET, [](AsyncWebServerRequest* request) {
+    const bool cells = request->hasParam("series") && request->getParam("series")->value() == "cells";
+    const bool binary = request->hasParam("format") && request->getParam("format")->value() == "bin";
+    const uint64_t from_ms =
+        request->hasParam("from") ? strtoull(request->getParam("from")->value().c_str(), nullptr, 10) : 0;
+    const uint64_t to_ms =
+        request->hasParam("to") ? strtoull(request->getParam("to")->value().c_str(), nullptr, 10) : UINT64_MAX;
+    auto history_export = std::make_shared<TimeSeriesExport>(
+        cells ? cell_history : pack_history, from_ms, to_ms,
+        binary ? TimeSeriesFormat::Binary : TimeSeriesFormat::Csv, cells ? nullptr : pack_history_names, "cell_");
+    AsyncWebServerResponse* response = request->beginChunkedResponse(
+        binary ? "application/octet-stream" : "text/csv",
+        [history_export](uint8_t* buffer, size_t maxLen, size_t index) -> size_t {
+          return history_export->read(buffer, maxLen);
+        });
+    response->addHeader("Cache-Control", "no-store");
+    request->send(response);
+  });
+
   // Route for root / web page
   def_route_with_auth("/", server, HTTP_GET,
-                      [](AsyncWebServerRequest* request) { request->send(200, "text/html", index_html, processor); });
+                      [](AsyncWebServerRequest* request) { send_page(request, "/", main_page); });
+
+  // Cell monitor page, style sheets and scripts of the pages
+  def_asset_routes(server);
 
   // Route for going to settings web page
   def_route_with_auth("/settings", server, HTTP_GET, [](AsyncWebServerRequest* request) {
@@ -211,31 +341,47 @@ void init_webserver() {
 
   // Route for going to CAN replay web page
   def_route_with_auth("/canreplay", server, HTTP_GET, [](AsyncWebServerRequest* request) {
-    request->send(request->beginResponse(200, "text/html", can_replay_processor()));
+    send_page(request, "/canreplay", can_replay_page);
   });
 
   def_route_with_auth("/startReplay", server, HTTP_GET, [](AsyncWebServerRequest* request) {
-    // Prevent multiple replay tasks from being created
-    if (isReplayRunning) {
+    if (can_replay_running()) {
       request->send(400, "text/plain", "Replay already running!");
       return;
     }
 
     datalayer.system.info.loop_playback = request->hasParam("loop") && request->getParam("loop")->value().toInt() == 1;
-    isReplayRunning = true;  // Set flag before starting task
-
-    xTaskCreatePinnedToCore(canReplayTask, "CAN_Replay", 8192, NULL, 1, NULL, 1);
 
+    if (!can_replay_start()) {
+      request->send(400, "text/plain", "No CAN log loaded!");
+      return;
+    }
     request->send(200, "text/plain", "CAN replay started!");
   });
 
   // Route for stopping the CAN replay
   def_route_with_auth("/stopReplay", server, HTTP_GET, [](AsyncWebServerRequest* request) {
-    datalayer.system.info.loop_playback = false;
+    can_replay_stop();
 
     request->send(200, "text/plain", "CAN replay stopped!");
   });
 
+  // Route for CAN replay progress and timing accuracy
+  def_route_with_auth("/replayStatus", server, HTTP_GET, [](AsyncWebServerRequest* request) {
+    request->send(200, "text/plain", can_replay_status());
+  });
+
+  if (datalayer.system.info.CAN_SD_logging_active) {
+    // Route for loading the CAN log on SD card for replay
+    def_route_with_auth("/loadSDReplay", server, HTTP_GET, [](AsyncWebServerRequest* request) {
+      if (!can_replay_load_sd_log()) {
+        request->send(400, "text/plain", "Could not load CAN log from SD card");
+        return;
+      }
+      request->send(200, "text/plain", can_replay_status());
+    });
+  }
+
   // Route to handle setting the CAN interface for CAN replay
   def_route_with_auth("/setCANInterface", server, HTTP_GET, [](AsyncWebServerRequest* request) {
     if (request->hasParam("interface")) {
@@ -262,6 +408,17 @@ void init_webserver() {
     });
   }
 
+  // Define the handlers the log pages poll for new lines
+  server.on("/can_log_data", HTTP_GET, [](AsyncWebServerRequest* request) {
+    request->send(begin_web_log_response(request, WebLog::Can, since_parameter(request)));
+  });
+
+  if (datalayer.system.info.web_logging_active) {
+    server.on("/log_data", HTTP_GET, [](AsyncWebServerRequest* request) {
+      request->send(begin_web_log_response(request, WebLog::Debug, since_parameter(request)));
+    });
+  }
+
   // Define the handler to stop can logging
   server.on("/stop_can_logging", HTTP_GET, [](AsyncWebServerRequest* request) {
     datalayer.system.info.can_logging_active = false;
@@ -277,10 +434,25 @@ void init_webserver() {
       handleFileUpload);
 
   if (datalayer.system.info.CAN_SD_logging_active) {
-    // Define the handler to export can log
+    // Define the handler to export can log, converted from the binary log to candump text while sending
     server.on("/export_can_log", HTTP_GET, [](AsyncWebServerRequest* request) {
+      auto log_export = std::make_shared<CanLogTextExport>();
+      if (!log_export->open()) {
+        request->send(200, "text/plain", "No logs available.");
+        return;
+      }
+      AsyncWebServerResponse* response = request->beginChunkedResponse(
+          "text/plain", [log_export](uint8_t* buffer, size_t maxLen, size_t index) -> size_t {
+            return log_export->read(buffer, maxLen);
+          });
+      response->addHeader("Content-Disposition", "attachment; filename=\"canlog.txt\"");
+      request->send(response);
+    });
+
+    // Define the handler to export the raw binary can log, see can_log_format.h for the format
+    server.on("/export_can_log_bin", HTTP_GET, [](AsyncWebServerRequest* request) {
       pause_can_writing();
-      request->send(SD_MMC, CAN_LOG_FILE, String(), true);
+      request->send(SD_MMC, CAN_LOG_FILE, "application/octet-stream", true);
       resume_can_writing();
     });
 
@@ -292,11 +464,6 @@ void init_webserver() {
   } else {
     // Define the handler to export can log
     server.on("/export_can_log", HTTP_GET, [](AsyncWebServerRequest* request) {
-      String logs = String(datalayer.system.info.logged_can_messages);
-      if (logs.length() == 0) {
-        logs = "No logs available.";
-      }
-
       // Get the current time
       time_t now = time(nullptr);
       struct tm timeinfo;
@@ -311,8 +478,7 @@ void init_webserver() {
         strcpy(filename, "battery_emulator_can_log.txt");
       }
 
-      // Use request->send with dynamic headers
-      AsyncWebServerResponse* response = request->beginResponse(200, "text/plain", logs);
+      AsyncWebServerResponse* response = begin_web_log_response(request, WebLog::Can, 0);
       response->addHeader("Content-Disposition", String("attachment; filename=\"") + String(filename) + "\"");
       request->send(response);
     });
@@ -334,11 +500,6 @@ void init_webserver() {
   } else {
     // Define the handler to export debug log
     server.on("/export_log", HTTP_GET, [](AsyncWebServerRequest* request) {
-      String logs = String(datalayer.system.info.logged_can_messages);
-      if (logs.length() == 0) {
-        logs = "No logs available.";
-      }
-
       // Get the current time
       time_t now = time(nullptr);
       struct tm timeinfo;
@@ -353,21 +514,15 @@ void init_webserver() {
         strcpy(filename, "battery_emulator_log.txt");
       }
 
-      // Use request->send with dynamic headers
-      AsyncWebServerResponse* response = request->beginResponse(200, "text/plain", logs);
+      AsyncWebServerResponse* response = begin_web_log_response(request, WebLog::Debug, 0);
       response->addHeader("Content-Disposition", String("attachment; filename=\"") + String(filename) + "\"");
       request->send(response);
     });
   }
 
-  // Route for going to cellmonitor web page
-  def_route_with_auth("/cellmonitor", server, HTTP_GET, [](AsyncWebServerRequest* request) {
-    request->send(200, "text/html", index_html, cellmonitor_processor);
-  });
-
   // Route for going to event log web page
   def_route_with_auth("/events", server, HTTP_GET, [](AsyncWebServerRequest* request) {
-    request->send(200, "text/html", index_html, events_processor);
+    send_page(request, "/events", events_page);
   });
 
   // Route for clearing all events
@@ -399,7 +554,7 @@ void init_webserver() {
       "REMBMSRESET",   "EXTPRECHARGE", "USBENABLED",  "CANLOGUSB",    "WEBENABLED",   "CANFDASCAN",   "CANLOGSD",
       "WIFIAPENABLED", "MQTTENABLED",  "NOINVDISC",   "HADISC",       "MQTTTOPICS",   "MQTTCELLV",    "INVICNT",
       "GTWRHD",        "DIGITALHVIL",  "PERFPROFILE", "INTERLOCKREQ", "SOCESTIMATED", "PYLONOFFSET",  "PYLONORDER",
-      "DEYEBYD",       "NCCONTACTOR",  "TRIBTR",      "CNTCTRLTRI",
+      "DEYEBYD",       "NCCONTACTOR",  "TRIBTR",      "CNTCTRLTRI",   "MQTTCELLPACK", "MQTTDELTA",
   };
 
   // Handles the form POST from UI to save settings of the common image
@@ -537,6 +692,12 @@ void init_webserver() {
       } else if (p->name() == "MQTTTIMEOUT") {
         auto port = atoi(p->value().c_str());
         settings.saveUInt("MQTTTIMEOUT", port);
+      } else if (p->name() == "MQTTCELLDB") {
+        settings.saveUInt("MQTTCELLDB", atoi(p->value().c_str()));
+      } else if (p->name() == "MQTTSOCDB") {
+        settings.saveUInt("MQTTSOCDB", atoi(p->value().c_str()));
+      } else if (p->name() == "MQTTHEARTBEAT") {
+        settings.saveUInt("MQTTHEARTBEAT", atoi(p->value().c_str()));
       } else if (p->name() == "MQTTOBJIDPREFIX") {
         settings.saveString("MQTTOBJIDPREFIX", p->value().c_str());
       } else if (p->name() == "MQTTDEVICENAME") {
@@ -573,6 +734,10 @@ void init_webserver() {
       } else if (p->name() == "CANFDFREQ") {
         auto type = atoi(p->value().c_str());
         settings.saveUInt("CANFDFREQ", type);
+      } else if (p->name() == "CANRXBUDGET") {
+        // Kept in a uint8_t, larger values would wrap around
+        auto type = std::clamp(atoi(p->value().c_str()), 1, UINT8_MAX);
+        settings.saveUInt("CANRXBUDGET", type);
       } else if (p->name() == "PRECHGMS") {
         auto type = atoi(p->value().c_str());
         settings.saveUInt("PRECHGMS", type);
@@ -901,719 +1066,996 @@ String get_uptime() {
          " minutes, " + (String)remaining_seconds + " seconds";
 }
 
-String processor(const String& var) {
-  if (var == "X") {
-    String content = "";
-    content += "<style>";
-    content += "body { background-color: black; color: white; }";
-    content +=
-        "button { background-color: #505E67; color: white; border: none; padding: 10px 20px; margin-bottom: 20px; "
-        "cursor: pointer; border-radius: 10px; }";
-    content += "button:hover { background-color: #3A4A52; }";
-    content += "h2 { font-size: 1.2em; margin: 0.3em 0 0.5em 0; }";
-    content += "h4 { margin: 0.6em 0; line-height: 1.2; }";
-    //content += ".tooltip { position: relative; display: inline-block; }";
-    content += ".tooltip .tooltiptext {";
-    content += "  visibility: hidden;";
-    content += "  width: 200px;";
-    content += "  background-color: #3A4A52;";  // Matching your button hover color
-    content += "  color: white;";
-    content += "  text-align: center;";
-    content += "  border-radius: 6px;";
-    content += "  padding: 8px;";
-    content += "  position: absolute;";
-    content += "  z-index: 1;";
-    content += "  margin-left: -100px;";
-    content += "  opacity: 0;";
-    content += "  transition: opacity 0.3s;";
-    content += "  font-size: 0.9em;";
-    content += "  font-weight: normal;";
-    content += "  line-height: 1.4;";
-    content += "}";
-    content += ".tooltip:hover .tooltiptext { visibility: visible; opacity: 1; }";
-    content += ".tooltip-icon { color: #505E67; cursor: help; }";  // Matching your button color
-    content += "</style>";
-
-    // Compact header
-    content += "<h2>Battery Emulator</h2>";
-
-    // Start content block
-    content += "<div style='background-color: #303E47; padding: 10px; margin-bottom: 10px; border-radius: 50px'>";
-    content += "<h4>Software: " + String(version_number);
+template <typename T>  // This function makes power values appear as W when under 1000, and kW when over
+static void print_power(HtmlWriter& out, T value, const char* unit, int precision) {
+  if (std::is_same<T, float>::value || std::is_same<T, uint16_t>::value || std::is_same<T, uint32_t>::value) {
+    float convertedValue = static_cast<float>(value);
+
+    if (convertedValue >= 1000.0f || convertedValue <= -1000.0f) {
+      out.print(convertedValue / 1000.0f, precision);
+      out.print(" kW");
+    } else {
+      out.print(convertedValue, 0);
+      out.print(" W");
+    }
+  }
+
+  out.print(unit);
+}
+
+template <typename T>
+static void print_power_line(HtmlWriter& out, const char* label, T value, const char* unit, int precision,
+                             const char* color = "white") {
+  out.printf("<h4 style='color: %s;'>%s: ", color, label);
+  print_power(out, value, unit, precision);
+  out.print("</h4>");
+}
+
+// Hardware, uptime and, when performance measurement is active, the task timings
+static bool write_system_info(HtmlWriter& out, const DATALAYER_SNAPSHOT_TYPE& snapshot) {
+  // Compact header
+  out.print("<h2>Battery Emulator</h2>");
+
+  // Start content block
+  out.print("<div style='background-color: #303E47; padding: 10px; margin-bottom: 10px; border-radius: 50px'>");
+  out.print("<h4>Software: ");
+  out.print(version_number);
 
 // Show hardware used:
 #ifdef HW_LILYGO
-    content += " Hardware: LilyGo T-CAN485";
+  out.print(" Hardware: LilyGo T-CAN485");
 #endif  // HW_LILYGO
 #ifdef HW_LILYGO2CAN
-    content += " Hardware: LilyGo T_2CAN";
+  out.print(" Hardware: LilyGo T_2CAN");
 #endif  // HW_LILYGO2CAN
 #ifdef HW_STARK
-    content += " Hardware: Stark CMR Module";
+  out.print(" Hardware: Stark CMR Module");
 #endif  // HW_STARK
-    content += " @ " + String(datalayer.system.info.CPU_temperature, 1) + " &deg;C</h4>";
-    content += "<h4>Uptime: " + get_uptime() + "</h4>";
-    if (datalayer.system.info.performance_measurement_active) {
-      // Load information
-      content += "<h4>Core task max load: " + String(datalayer.system.status.core_task_max_us) + " us</h4>";
-      content +=
-          "<h4>Core task max load last 10 s: " + String(datalayer.system.status.core_task_10s_max_us) + " us</h4>";
-      content +=
-          "<h4>MQTT function (MQTT task) max load last 10 s: " + String(datalayer.system.status.mqtt_task_10s_max_us) +
-          " us</h4>";
-      content +=
-          "<h4>WIFI function (MQTT task) max load last 10 s: " + String(datalayer.system.status.wifi_task_10s_max_us) +
-          " us</h4>";
-      content += "<h4>Max load @ worst case execution of core task:</h4>";
-      content += "<h4>10ms function timing: " + String(datalayer.system.status.time_snap_10ms_us) + " us</h4>";
-      content += "<h4>Values function timing: " + String(datalayer.system.status.time_snap_values_us) + " us</h4>";
-      content += "<h4>CAN/serial RX function timing: " + String(datalayer.system.status.time_snap_comm_us) + " us</h4>";
-      content += "<h4>CAN TX function timing: " + String(datalayer.system.status.time_snap_cantx_us) + " us</h4>";
-      content += "<h4>OTA function timing: " + String(datalayer.system.status.time_snap_ota_us) + " us</h4>";
-    }
+  out.print(" @ ");
+  out.print(datalayer.system.info.CPU_temperature, 1);
+  out.print(" &deg;C</h4>");
+  out.print("<h4>Uptime: ");
+  out.print(get_uptime());
+  out.print("</h4>");
+  if (datalayer.system.info.performance_measurement_active) {
+    // Load information
+    out.print("<h4>Core task max load: ");
+    out.print(snapshot.system.status.core_task_max_us);
+    out.print(" us</h4>");
+    out.print("<h4>Core task max load last 10 s: ");
+    out.print(snapshot.system.status.core_task_10s_max_us);
+    out.print(" us</h4>");
+    out.print("<h4>MQTT function (MQTT task) max load last 10 s: ");
+    out.print(snapshot.system.status.mqtt_task_10s_max_us);
+    out.print(" us</h4>");
+    out.print("<h4>WIFI function (MQTT task) max load last 10 s: ");
+    out.print(snapshot.system.status.wifi_task_10s_max_us);
+    out.print(" us</h4>");
+    out.print("<h4>Max load @ worst case execution of core task:</h4>");
+    out.print("<h4>10ms function timing: ");
+    out.print(snapshot.system.status.time_snap_10ms_us);
+    out.print(" us</h4>");
+    out.print("<h4>Values function timing: ");
+    out.print(snapshot.system.status.time_snap_values_us);
+    out.print(" us</h4>");
+    out.print("<h4>CAN/serial RX function timing: ");
+    out.print(snapshot.system.status.time_snap_comm_us);
+    out.print(" us</h4>");
+    out.print("<h4>CAN TX function timing: ");
+    out.print(snapshot.system.status.time_snap_cantx_us);
+    out.print(" us</h4>");
+    out.print("<h4>OTA function timing: ");
+    out.print(snapshot.system.status.time_snap_ota_us);
+    out.print(" us</h4>");
+    out.print("<h4><a href='/perf'>Timing distribution since boot (JSON)</a></h4>");
+  }
+  return true;
+}
 
-    wl_status_t status = WiFi.status();
-    // Display ssid of network connected to and, if connected to the WiFi, its own IP
-    content += "<h4>SSID: " + html_escape(ssid.c_str());
-    if (status == WL_CONNECTED) {
-      // Get and display the signal strength (RSSI) and channel
-      content += " RSSI:" + String(WiFi.RSSI()) + " dBm Ch: " + String(WiFi.channel());
+// CAN and RS485 statistics of the performance measurement
+static bool write_comm_stats(HtmlWriter& out, const DATALAYER_SNAPSHOT_TYPE& snapshot) {
+  if (!datalayer.system.info.performance_measurement_active) {
+    return true;
+  }
+  for (int i = 0; i < NO_CAN_INTERFACE; i++) {
+    const DATALAYER_CAN_RX_STATS_TYPE& rx_stats = snapshot.system.status.can_rx_stats[i];
+    if (rx_stats.queue_size == 0) {
+      continue;  // Interface not in use
     }
-    content += "</h4>";
-    if (status == WL_CONNECTED) {
-      content += "<h4>Hostname: " + html_escape(WiFi.getHostname()) + "</h4>";
-      content += "<h4>IP: " + WiFi.localIP().toString() + "</h4>";
-    } else {
-      content += "<h4>Wifi state: " + getConnectResultString(status) + "</h4>";
+    out.print("<h4>");
+    out.print(getCANInterfaceName((CAN_Interface)i));
+    out.print(" RX: ");
+    out.print(rx_stats.frames_received);
+    out.print(" frames, queue peak ");
+    out.print(rx_stats.queue_high_water);
+    out.print("/");
+    out.print(rx_stats.queue_size);
+    out.print(", overflows ");
+    out.print(rx_stats.overflows);
+    out.print(", budget exhausted ");
+    out.print(rx_stats.budget_exhausted);
+    out.print("</h4>");
+  }
+  for (int i = 0; i < NO_CAN_INTERFACE; i++) {
+    const DATALAYER_CAN_TX_STATS_TYPE& tx_stats = snapshot.system.status.can_tx_stats[i];
+    if (!tx_stats.active) {
+      continue;
     }
-    // Close the block
-    content += "</div>";
-
-    if (inverter || battery || charger || user_selected_shunt_type != ShuntType::None) {
-      // Start a new block with a specific background color
-      content += "<div style='background-color: #333; padding: 10px; margin-bottom: 10px; border-radius: 50px'>";
-
-      // Display which components are used
-      if (inverter) {
-        content += "<h4 style='color: white;'>Inverter protocol: ";
-        content += inverter->name();
-        content += " ";
-        content += datalayer.system.info.inverter_brand;
-        content += "</h4>";
-      }
-
-      if (battery) {
-        content += "<h4 style='color: white;'>Battery protocol: ";
-        content += datalayer.system.info.battery_protocol;
-        if (battery3) {
-          content += " (Triple battery)";
-        } else if (battery2) {
-          content += " (Double battery)";
-        }
-        if (datalayer.battery.info.chemistry == battery_chemistry_enum::LFP) {
-          content += " (LFP)";
-        }
-        content += "</h4>";
-      }
-
-      if (user_selected_shunt_type != ShuntType::None) {
-        content += "<h4 style='color: white;'>Shunt protocol: ";
-        content += datalayer.system.info.shunt_protocol;
-        content += "</h4>";
-      }
+    out.print("<h4>");
+    out.print(getCANInterfaceName((CAN_Interface)i));
+    out.print(" TX: ");
+    out.print(tx_stats.frames_sent);
+    out.print(" frames, queue ");
+    out.print(tx_stats.queue_depth);
+    out.print(" (peak ");
+    out.print(tx_stats.queue_high_water);
+    out.print("), deadline misses ");
+    out.print(tx_stats.deadline_misses);
+    out.print(", retries ");
+    out.print(tx_stats.retries);
+    out.print(", dropped ");
+    out.print(tx_stats.dropped);
+    out.print(", bus load ");
+    out.print(tx_stats.bus_load_pct);
+    out.print("%</h4>");
+  }
+  const DATALAYER_RS485_STATS_TYPE& rs485_stats = snapshot.system.status.rs485_stats;
+  if (rs485_stats.active) {
+    out.print("<h4>RS485 RX: ");
+    out.print(rs485_stats.frames_received);
+    out.print(" frames, framing errors ");
+    out.print(rs485_stats.framing_errors);
+    out.print(", overruns ");
+    out.print(rs485_stats.overruns);
+    out.print(", latency ");
+    out.print(rs485_stats.latency_last_us);
+    out.print(" us (max ");
+    out.print(rs485_stats.latency_max_us);
+    out.print(" us)</h4>");
+  }
+  if (datalayer.system.info.CAN_SD_logging_active) {
+    out.print("<h4>CAN frames dropped from SD log: ");
+    out.print(snapshot.system.status.can_sd_frames_dropped);
+    out.print("</h4>");
+  }
+  if (snapshot.system.status.journal_records_dropped > 0) {
+    out.print("<h4>Events dropped from the event journal: ");
+    out.print(snapshot.system.status.journal_records_dropped);
+    out.print("</h4>");
+  }
+  return true;
+}
 
-      if (charger) {
-        content += "<h4 style='color: white;'>Charger protocol: ";
-        content += charger->name();
-        content += "</h4>";
-      }
+static bool write_wifi_info(HtmlWriter& out) {
+  wl_status_t status = WiFi.status();
+  // Display ssid of network connected to and, if connected to the WiFi, its own IP
+  out.print("<h4>SSID: ");
+  out.print(html_escape(ssid.c_str()));
+  if (status == WL_CONNECTED) {
+    // Get and display the signal strength (RSSI) and channel
+    out.print(" RSSI:");
+    out.print(WiFi.RSSI());
+    out.print(" dBm Ch: ");
+    out.print(WiFi.channel());
+  }
+  out.print("</h4>");
+  if (status == WL_CONNECTED) {
+    out.print("<h4>Hostname: ");
+    out.print(html_escape(WiFi.getHostname()));
+    out.print("</h4>");
+    out.print("<h4>IP: ");
+    out.print(WiFi.localIP().toString());
+    out.print("</h4>");
+  } else {
+    out.print("<h4>Wifi state: ");
+    out.print(getConnectResultString(status));
+    out.print("</h4>");
+  }
+  // Close the block
+  out.print("</div>");
+  return true;
+}
 
-      // Close the block
-      content += "</div>";
+// Protocols used
+static bool write_components(HtmlWriter& out, const DATALAYER_SNAPSHOT_TYPE& snapshot) {
+  if (inverter || battery || charger || user_selected_shunt_type != ShuntType::None) {
+    // Start a new block with a specific background color
+    out.print("<div style='background-color: #333; padding: 10px; margin-bottom: 10px; border-radius: 50px'>");
+
+    // Display which components are used
+    if (inverter) {
+      out.print("<h4 style='color: white;'>Inverter protocol: ");
+      out.print(inverter->name());
+      out.print(" ");
+      out.print(datalayer.system.info.inverter_brand);
+      out.print("</h4>");
     }
 
     if (battery) {
-      if (battery2) {
-        // Start a new block with a specific background color. Color changes depending on BMS status
-        content += "<div style='display: flex; width: 100%;'>";
-        content += "<div style='flex: 1; background-color: ";
-      } else {
-        // Start a new block with a specific background color. Color changes depending on system status
-        content += "<div style='background-color: ";
+      out.print("<h4 style='color: white;'>Battery protocol: ");
+      out.print(datalayer.system.info.battery_protocol);
+      if (battery3) {
+        out.print(" (Triple battery)");
+      } else if (battery2) {
+        out.print(" (Double battery)");
       }
-
-      switch (get_emulator_status()) {
-        case EMULATOR_STATUS::STATUS_OK:
-          content += "#2D3F2F;";
-          break;
-        case EMULATOR_STATUS::STATUS_WARNING:
-          content += "#F5CC00;";
-          break;
-        case EMULATOR_STATUS::STATUS_ERROR:
-          content += "#A70107;";
-          break;
-        case EMULATOR_STATUS::STATUS_UPDATING:
-          content += "#2B35AF;";  // Blue in test mode
-          break;
-      }
-
-      // Add the common style properties
-      content += "padding: 10px; margin-bottom: 10px; border-radius: 50px;'>";
-
-      // Display battery statistics within this block
-      float socRealFloat =
-          static_cast<float>(datalayer.battery.status.real_soc) / 100.0f;  // Convert to float and divide by 100
-      float socScaledFloat =
-          static_cast<float>(datalayer.battery.status.reported_soc) / 100.0f;  // Convert to float and divide by 100
-      float sohFloat =
-          static_cast<float>(datalayer.battery.status.soh_pptt) / 100.0f;  // Convert to float and divide by 100
-      float voltageFloat =
-          static_cast<float>(datalayer.battery.status.voltage_dV) / 10.0f;  // Convert to float and divide by 10
-      float currentFloat =
-          static_cast<float>(datalayer.battery.status.current_dA) / 10.0f;  // Convert to float and divide by 10
-      float powerFloat = static_cast<float>(datalayer.battery.status.active_power_W);                // Convert to float
-      float tempMaxFloat = static_cast<float>(datalayer.battery.status.temperature_max_dC) / 10.0f;  // Convert to float
-      float tempMinFloat = static_cast<float>(datalayer.battery.status.temperature_min_dC) / 10.0f;  // Convert to float
-      float maxCurrentChargeFloat =
-          static_cast<float>(datalayer.battery.status.max_charge_current_dA) / 10.0f;  // Convert to float
-      float maxCurrentDischargeFloat =
-          static_cast<float>(datalayer.battery.status.max_discharge_current_dA) / 10.0f;  // Convert to float
-      uint16_t cell_delta_mv =
-          datalayer.battery.status.cell_max_voltage_mV - datalayer.battery.status.cell_min_voltage_mV;
-
-      if (datalayer.battery.settings.soc_scaling_active)
-        content += "<h4 style='color: white;'>Scaled SOC: " + String(socScaledFloat, 2) +
-                   "&percnt; (real: " + String(socRealFloat, 2) + "&percnt;)</h4>";
-      else
-        content += "<h4 style='color: white;'>SOC: " + String(socRealFloat, 2) + "&percnt;</h4>";
-
-      content += "<h4 style='color: white;'>SOH: " + String(sohFloat, 2) + "&percnt;</h4>";
-      content += "<h4 style='color: white;'>Voltage: " + String(voltageFloat, 1) +
-                 " V &nbsp; Current: " + String(currentFloat, 1) + " A</h4>";
-      content += formatPowerValue("Power", powerFloat, "", 1);
-
-      if (datalayer.battery.settings.soc_scaling_active)
-        content += "<h4 style='color: white;'>Scaled total capacity: " +
-                   formatPowerValue(datalayer.battery.info.reported_total_capacity_Wh, "h", 1) +
-                   " (real: " + formatPowerValue(datalayer.battery.info.total_capacity_Wh, "h", 1) + ")</h4>";
-      else
-        content += formatPowerValue("Total capacity", datalayer.battery.info.total_capacity_Wh, "h", 1);
-
-      if (datalayer.battery.settings.soc_scaling_active)
-        content += "<h4 style='color: white;'>Scaled remaining capacity: " +
-                   formatPowerValue(datalayer.battery.status.reported_remaining_capacity_Wh, "h", 1) +
-                   " (real: " + formatPowerValue(datalayer.battery.status.remaining_capacity_Wh, "h", 1) + ")</h4>";
-      else
-        content += formatPowerValue("Remaining capacity", datalayer.battery.status.remaining_capacity_Wh, "h", 1);
-
-      if (datalayer.system.info.equipment_stop_active) {
-        content +=
-            formatPowerValue("Max discharge power", datalayer.battery.status.max_discharge_power_W, "", 1, "red");
-        content += formatPowerValue("Max charge power", datalayer.battery.status.max_charge_power_W, "", 1, "red");
-        content += "<h4 style='color: red;'>Max discharge current: " + String(maxCurrentDischargeFloat, 1) + " A</h4>";
-        content += "<h4 style='color: red;'>Max charge current: " + String(maxCurrentChargeFloat, 1) + " A</h4>";
-      } else {
-        content += formatPowerValue("Max discharge power", datalayer.battery.status.max_discharge_power_W, "", 1);
-        content += formatPowerValue("Max charge power", datalayer.battery.status.max_charge_power_W, "", 1);
-        content += "<h4 style='color: white;'>Max discharge current: " + String(maxCurrentDischargeFloat, 1) + " A";
-        if (datalayer.battery.settings.remote_settings_limit_discharge) {
-          content += " (Remote)</h4>";
-        } else if (datalayer.battery.settings.user_settings_limit_discharge) {
-          content += " (Manual)</h4>";
-        } else {
-          content += " (BMS)</h4>";
-        }
-        content += "<h4 style='color: white;'>Max charge current: " + String(maxCurrentChargeFloat, 1) + " A";
-        if (datalayer.battery.settings.remote_settings_limit_charge) {
-          content += " (Remote)</h4>";
-        } else if (datalayer.battery.settings.user_settings_limit_charge) {
-          content += " (Manual)</h4>";
-        } else {
-          content += " (BMS)</h4>";
-        }
+      if (snapshot.battery.info.chemistry == battery_chemistry_enum::LFP) {
+        out.print(" (LFP)");
       }
+      out.print("</h4>");
+    }
 
-      content += "<h4>Cell min/max: " + String(datalayer.battery.status.cell_min_voltage_mV) + " mV / " +
-                 String(datalayer.battery.status.cell_max_voltage_mV) + " mV</h4>";
-      if (cell_delta_mv > datalayer.battery.info.max_cell_voltage_deviation_mV) {
-        content += "<h4 style='color: red;'>Cell delta: " + String(cell_delta_mv) + " mV</h4>";
-      } else {
-        content += "<h4>Cell delta: " + String(cell_delta_mv) + " mV</h4>";
-      }
-      content += "<h4>Temperature min/max: " + String(tempMinFloat, 1) + " &deg;C / " + String(tempMaxFloat, 1) +
-                 " &deg;C</h4>";
+    if (user_selected_shunt_type != ShuntType::None) {
+      out.print("<h4 style='color: white;'>Shunt protocol: ");
+      out.print(datalayer.system.info.shunt_protocol);
+      out.print("</h4>");
+    }
 
-      content += "<h4>System status: ";
-      switch (datalayer.battery.status.bms_status) {
-        case ACTIVE:
-          content += String("OK");
-          break;
-        case UPDATING:
-          content += String("UPDATING");
-          break;
-        case FAULT:
-          content += String("FAULT");
-          break;
-        case INACTIVE:
-          content += String("INACTIVE");
-          break;
-        case STANDBY:
-          content += String("STANDBY");
-          break;
-        default:
-          content += String("??");
-          break;
-      }
-      content += "</h4>";
-
-      if (battery && battery->supports_real_BMS_status()) {
-        content += "<h4>Battery BMS status: ";
-        switch (datalayer.battery.status.real_bms_status) {
-          case BMS_ACTIVE:
-            content += String("OK");
-            break;
-          case BMS_FAULT:
-            content += String("FAULT");
-            break;
-          case BMS_DISCONNECTED:
-            content += String("DISCONNECTED");
-            break;
-          case BMS_STANDBY:
-            content += String("STANDBY");
-            break;
-          default:
-            content += String("??");
-            break;
-        }
-        content += "</h4>";
-      }
+    if (charger) {
+      out.print("<h4 style='color: white;'>Charger protocol: ");
+      out.print(charger->name());
+      out.print("</h4>");
+    }
 
-      if (datalayer.battery.status.current_dA == 0) {
-        content += "<h4>Battery idle</h4>";
-      } else if (datalayer.battery.status.current_dA < 0) {
-        content += "<h4>Battery discharging!";
-        if (datalayer.battery.settings.inverter_limits_discharge) {
-          content += " (Inverter limiting)</h4>";
-        } else {
-          if (datalayer.battery.settings.user_settings_limit_discharge) {
-            content += " (Settings limiting)</h4>";
-          } else {
-            content += " (Battery limiting)</h4>";
-          }
-        }
-        content += "</h4>";
-      } else {  // > 0 , positive current
-        content += "<h4>Battery charging!";
-        if (datalayer.battery.settings.inverter_limits_charge) {
-          content += " (Inverter limiting)</h4>";
-        } else {
-          if (datalayer.battery.settings.user_settings_limit_charge) {
-            content += " (Settings limiting)</h4>";
-          } else {
-            content += " (Battery limiting)</h4>";
-          }
-        }
-      }
+    // Close the block
+    out.print("</div>");
+  }
+  return true;
+}
 
-      // Close the block
-      content += "</div>";
-
-      if (battery2) {
-        content += "<div style='flex: 1; background-color: ";
-        switch (datalayer.battery.status.bms_status) {
-          case ACTIVE:
-            content += "#2D3F2F;";
-            break;
-          case FAULT:
-            content += "#A70107;";
-            break;
-          default:
-            content += "#2D3F2F;";
-            break;
-        }
-        // Add the common style properties
-        content += "padding: 10px; margin-bottom: 10px; border-radius: 50px;'>";
-
-        // Display battery statistics within this block
-        socRealFloat =
-            static_cast<float>(datalayer.battery2.status.real_soc) / 100.0f;  // Convert to float and divide by 100
-        //socScaledFloat; // Same value used for bat2
-        sohFloat =
-            static_cast<float>(datalayer.battery2.status.soh_pptt) / 100.0f;  // Convert to float and divide by 100
-        voltageFloat =
-            static_cast<float>(datalayer.battery2.status.voltage_dV) / 10.0f;  // Convert to float and divide by 10
-        currentFloat =
-            static_cast<float>(datalayer.battery2.status.current_dA) / 10.0f;       // Convert to float and divide by 10
-        powerFloat = static_cast<float>(datalayer.battery2.status.active_power_W);  // Convert to float
-        tempMaxFloat = static_cast<float>(datalayer.battery2.status.temperature_max_dC) / 10.0f;  // Convert to float
-        tempMinFloat = static_cast<float>(datalayer.battery2.status.temperature_min_dC) / 10.0f;  // Convert to float
-        cell_delta_mv = datalayer.battery2.status.cell_max_voltage_mV - datalayer.battery2.status.cell_min_voltage_mV;
-
-        if (datalayer.battery.settings.soc_scaling_active)
-          content += "<h4 style='color: white;'>Scaled SOC: " + String(socScaledFloat, 2) +
-                     "&percnt; (real: " + String(socRealFloat, 2) + "&percnt;)</h4>";
-        else
-          content += "<h4 style='color: white;'>SOC: " + String(socRealFloat, 2) + "&percnt;</h4>";
-
-        content += "<h4 style='color: white;'>SOH: " + String(sohFloat, 2) + "&percnt;</h4>";
-        content += "<h4 style='color: white;'>Voltage: " + String(voltageFloat, 1) +
-                   " V &nbsp; Current: " + String(currentFloat, 1) + " A</h4>";
-        content += formatPowerValue("Power", powerFloat, "", 1);
-
-        if (datalayer.battery.settings.soc_scaling_active)
-          content += "<h4 style='color: white;'>Scaled total capacity: " +
-                     formatPowerValue(datalayer.battery2.info.reported_total_capacity_Wh, "h", 1) +
-                     " (real: " + formatPowerValue(datalayer.battery2.info.total_capacity_Wh, "h", 1) + ")</h4>";
-        else
-          content += formatPowerValue("Total capacity", datalayer.battery2.info.total_capacity_Wh, "h", 1);
-
-        if (datalayer.battery.settings.soc_scaling_active)
-          content += "<h4 style='color: white;'>Scaled remaining capacity: " +
-                     formatPowerValue(datalayer.battery2.status.reported_remaining_capacity_Wh, "h", 1) +
-                     " (real: " + formatPowerValue(datalayer.battery2.status.remaining_capacity_Wh, "h", 1) + ")</h4>";
-        else
-          content += formatPowerValue("Remaining capacity", datalayer.battery2.status.remaining_capacity_Wh, "h", 1);
-
-        if (datalayer.system.info.equipment_stop_active) {
-          content +=
-              formatPowerValue("Max discharge power", datalayer.battery2.status.max_discharge_power_W, "", 1, "red");
-          content += formatPowerValue("Max charge power", datalayer.battery2.status.max_charge_power_W, "", 1, "red");
-          content +=
-              "<h4 style='color: red;'>Max discharge current: " + String(maxCurrentDischargeFloat, 1) + " A</h4>";
-          content += "<h4 style='color: red;'>Max charge current: " + String(maxCurrentChargeFloat, 1) + " A</h4>";
-        } else {
-          content += formatPowerValue("Max discharge power", datalayer.battery2.status.max_discharge_power_W, "", 1);
-          content += formatPowerValue("Max charge power", datalayer.battery2.status.max_charge_power_W, "", 1);
-          content +=
-              "<h4 style='color: white;'>Max discharge current: " + String(maxCurrentDischargeFloat, 1) + " A</h4>";
-          content += "<h4 style='color: white;'>Max charge current: " + String(maxCurrentChargeFloat, 1) + " A</h4>";
-        }
+// Block of the first battery, in a row with the others if there are more. Color changes depending on system status
+static bool write_battery(HtmlWriter& out, const DATALAYER_SNAPSHOT_TYPE& snapshot) {
+  if (battery2) {
+    // Start a new block with a specific background color. Color changes depending on BMS status
+    out.print("<div style='display: flex; width: 100%;'>");
+    out.print("<div style='flex: 1; background-color: ");
+  } else {
+    // Start a new block with a specific background color. Color changes depending on system status
+    out.print("<div style='background-color: ");
+  }
 
-        content += "<h4>Cell min/max: " + String(datalayer.battery2.status.cell_min_voltage_mV) + " mV / " +
-                   String(datalayer.battery2.status.cell_max_voltage_mV) + " mV</h4>";
-        if (cell_delta_mv > datalayer.battery2.info.max_cell_voltage_deviation_mV) {
-          content += "<h4 style='color: red;'>Cell delta: " + String(cell_delta_mv) + " mV</h4>";
-        } else {
-          content += "<h4>Cell delta: " + String(cell_delta_mv) + " mV</h4>";
-        }
-        content += "<h4>Temperature min/max: " + String(tempMinFloat, 1) + " &deg;C / " + String(tempMaxFloat, 1) +
-                   " &deg;C</h4>";
-        if (datalayer.battery.status.bms_status == ACTIVE) {
-          content += "<h4>System status: OK </h4>";
-        } else if (datalayer.battery.status.bms_status == UPDATING) {
-          content += "<h4>System status: UPDATING </h4>";
-        } else {
-          content += "<h4>System status: FAULT </h4>";
-        }
-        if (datalayer.battery2.status.current_dA == 0) {
-          content += "<h4>Battery idle</h4>";
-        } else if (datalayer.battery2.status.current_dA < 0) {
-          content += "<h4>Battery discharging!</h4>";
-        } else {  // > 0
-          content += "<h4>Battery charging!</h4>";
-        }
-        content += "</div>";
-        if (battery3) {
-          content += "<div style='flex: 1; background-color: ";
-          switch (datalayer.battery.status.bms_status) {
-            case ACTIVE:
-              content += "#2D3F2F;";
-              break;
-            case FAULT:
-              content += "#A70107;";
-              break;
-            default:
-              content += "#2D3F2F;";
-              break;
+  switch (get_emulator_status()) {
+    case EMULATOR_STATUS::STATUS_OK:
+      out.print("#2D3F2F;");
+      break;
+    case EMULATOR_STATUS::STATUS_WARNING:
+      out.print("#F5CC00;");
+      break;
+    case EMULATOR_STATUS::STATUS_ERROR:
+      out.print("#A70107;");
+      break;
+    case EMULATOR_STATUS::STATUS_UPDATING:
+      out.print(
+          "#2B35AF;");  // Blue in test mode
+          break;
           }
+          
           // Add the common style properties
-          content += "padding: 10px; margin-bottom: 10px; border-radius: 50px;'>";
-
-          // Display battery statistics within this block
-          socRealFloat =
-              static_cast<float>(datalayer.battery3.status.real_soc) / 100.0f;  // Convert to float and divide by 100
-          //socScaledFloat; // Same value used for bat2
-          sohFloat =
-              static_cast<float>(datalayer.battery3.status.soh_pptt) / 100.0f;  // Convert to float and divide by 100
-          voltageFloat =
-              static_cast<float>(datalayer.battery3.status.voltage_dV) / 10.0f;  // Convert to float and divide by 10
-          currentFloat =
-              static_cast<float>(datalayer.battery3.status.current_dA) / 10.0f;  // Convert to float and divide by 10
-          powerFloat = static_cast<float>(datalayer.battery3.status.active_power_W);                // Convert to float
-          tempMaxFloat = static_cast<float>(datalayer.battery3.status.temperature_max_dC) / 10.0f;  // Convert to float
-          tempMinFloat = static_cast<float>(datalayer.battery3.status.temperature_min_dC) / 10.0f;  // Convert to float
-          cell_delta_mv = datalayer.battery3.status.cell_max_voltage_mV - datalayer.battery3.status.cell_min_voltage_mV;
-
-          if (datalayer.battery.settings.soc_scaling_active)
-            content += "<h4 style='color: white;'>Scaled SOC: " + String(socScaledFloat, 2) +
-                       "&percnt; (real: " + String(socRealFloat, 2) + "&percnt;)</h4>";
-          else
-            content += "<h4 style='color: white;'>SOC: " + String(socRealFloat, 2) + "&percnt;</h4>";
-
-          content += "<h4 style='color: white;'>SOH: " + String(sohFloat, 2) + "&percnt;</h4>";
-          content += "<h4 style='color: white;'>Voltage: " + String(voltageFloat, 1) +
-                     " V &nbsp; Current: " + String(currentFloat, 1) + " A</h4>";
-          content += formatPowerValue("Power", powerFloat, "", 1);
-
-          if (datalayer.battery.settings.soc_scaling_active)
-            content += "<h4 style='color: white;'>Scaled total capacity: " +
-                       formatPowerValue(datalayer.battery3.info.reported_total_capacity_Wh, "h", 1) +
-                       " (real: " + formatPowerValue(datalayer.battery3.info.total_capacity_Wh, "h", 1) + ")</h4>";
-          else
-            content += formatPowerValue("Total capacity", datalayer.battery3.info.total_capacity_Wh, "h", 1);
-
-          if (datalayer.battery.settings.soc_scaling_active)
-            content += "<h4 style='color: white;'>Scaled remaining capacity: " +
-                       formatPowerValue(datalayer.battery3.status.reported_remaining_capacity_Wh, "h", 1) +
-                       " (real: " + formatPowerValue(datalayer.battery3.status.remaining_capacity_Wh, "h", 1) +
-                       ")</h4>";
-          else
-            content += formatPowerValue("Remaining capacity", datalayer.battery3.status.remaining_capacity_Wh, "h", 1);
-
-          if (datalayer.system.info.equipment_stop_active) {
-            content +=
-                formatPowerValue("Max discharge power", datalayer.battery3.status.max_discharge_power_W, "", 1, "red");
-            content += formatPowerValue("Max charge power", datalayer.battery3.status.max_charge_power_W, "", 1, "red");
-            content +=
-                "<h4 style='color: red;'>Max discharge current: " + String(maxCurrentDischargeFloat, 1) + " A</h4>";
-            content += "<h4 style='color: red;'>Max charge current: " + String(maxCurrentChargeFloat, 1) + " A</h4>";
-          } else {
-            content += formatPowerValue("Max discharge power", datalayer.battery3.status.max_discharge_power_W, "", 1);
-            content += formatPowerValue("Max charge power", datalayer.battery3.status.max_charge_power_W, "", 1);
-            content +=
-                "<h4 style='color: white;'>Max discharge current: " + String(maxCurrentDischargeFloat, 1) + " A</h4>";
-            content += "<h4 style='color: white;'>Max charge current: " + String(maxCurrentChargeFloat, 1) + " A</h4>";
-          }
+          out.print("padding: 10px; margin-bottom: 10px; border-radius: 50px;'>");
+
+  // Display battery statistics within this block
+  float socRealFloat =
+      static_cast<float>(snapshot.battery.status.real_soc) / 100.0f;  // Convert to float and divide by 100
+  float socScaledFloat =
+      static_cast<float>(snapshot.battery.status.reported_soc) / 100.0f;  // Convert to float and divide by 100
+  float sohFloat =
+      static_cast<float>(snapshot.battery.status.soh_pptt) / 100.0f;  // Convert to float and divide by 100
+  float voltageFloat =
+      static_cast<float>(snapshot.battery.status.voltage_dV) / 10.0f;  // Convert to float and divide by 10
+  float currentFloat =
+      static_cast<float>(snapshot.battery.status.current_dA) / 10.0f;  // Convert to float and divide by 10
+  float powerFloat = static_cast<float>(snapshot.battery.status.active_power_W);                // Convert to float
+  float tempMaxFloat = static_cast<float>(snapshot.battery.status.temperature_max_dC) / 10.0f;  // Convert to float
+  float tempMinFloat = static_cast<float>(snapshot.battery.status.temperature_min_dC) / 10.0f;  // Convert to float
+  float maxCurrentChargeFloat =
+      static_cast<float>(snapshot.battery.status.max_charge_current_dA) / 10.0f;  // Convert to float
+  float maxCurrentDischargeFloat =
+      static_cast<float>(snapshot.battery.status.max_discharge_current_dA) / 10.0f;  // Convert to float
+  uint16_t cell_delta_mv =
+      snapshot.battery.status.cell_max_voltage_mV - snapshot.battery.status.cell_min_voltage_mV;
+
+  if (snapshot.battery.settings.soc_scaling_active) {
+    out.print("<h4 style='color: white;'>Scaled SOC: ");
+    out.print(socScaledFloat, 2);
+    out.print("&percnt; (real: ");
+    out.print(socRealFloat, 2);
+    out.print("&percnt;)</h4>");
+  } else {
+    out.print("<h4 style='color: white;'>SOC: ");
+    out.print(socRealFloat, 2);
+    out.print("&percnt;</h4>");
+  }
 
-          content += "<h4>Cell min/max: " + String(datalayer.battery3.status.cell_min_voltage_mV) + " mV / " +
-                     String(datalayer.battery3.status.cell_max_voltage_mV) + " mV</h4>";
-          if (cell_delta_mv > datalayer.battery3.info.max_cell_voltage_deviation_mV) {
-            content += "<h4 style='color: red;'>Cell delta: " + String(cell_delta_mv) + " mV</h4>";
-          } else {
-            content += "<h4>Cell delta: " + String(cell_delta_mv) + " mV</h4>";
-          }
-          content += "<h4>Temperature min/max: " + String(tempMinFloat, 1) + " &deg;C / " + String(tempMaxFloat, 1) +
-                     " &deg;C</h4>";
-          if (datalayer.battery.status.bms_status == ACTIVE) {
-            content += "<h4>System status: OK </h4>";
-          } else if (datalayer.battery.status.bms_status == UPDATING) {
-            content += "<h4>System status: UPDATING </h4>";
-          } else {
-            content += "<h4>System status: FAULT </h4>";
-          }
-          if (datalayer.battery3.status.current_dA == 0) {
-            content += "<h4>Battery idle</h4>";
-          } else if (datalayer.battery3.status.current_dA < 0) {
-            content += "<h4>Battery discharging!</h4>";
-          } else {  // > 0
-            content += "<h4>Battery charging!</h4>";
-          }
-          content += "</div>";
-          content += "</div>";
-        }
-        content += "</div>";
-      }
-    }
-    // Block for Contactor status and component request status
-    // Start a new block with gray background color
-    content += "<div style='background-color: #333; padding: 10px; margin-bottom: 10px;border-radius: 50px'>";
+  out.print("<h4 style='color: white;'>SOH: ");
+  out.print(sohFloat, 2);
+  out.print("&percnt;</h4>");
+  out.print("<h4 style='color: white;'>Voltage: ");
+  out.print(voltageFloat, 1);
+  out.print(" V &nbsp; Current: ");
+  out.print(currentFloat, 1);
+  out.print(" A</h4>");
+  print_power_line(out, "Power", powerFloat, "", 1);
+
+  if (snapshot.battery.settings.soc_scaling_active) {
+    out.print("<h4 style='color: white;'>Scaled total capacity: ");
+    print_power(out, snapshot.battery.info.reported_total_capacity_Wh, "h", 1);
+    out.print(" (real: ");
+    print_power(out, snapshot.battery.info.total_capacity_Wh, "h", 1);
+    out.print(")</h4>");
+  } else {
+    print_power_line(out, "Total capacity", snapshot.battery.info.total_capacity_Wh, "h", 1);
+  }
 
-    if (emulator_pause_status == NORMAL) {
-      content += "<h4>Power status: " + String(get_emulator_pause_status().c_str()) + " </h4>";
-    } else {
-      content += "<h4 style='color: red;'>Power status: " + String(get_emulator_pause_status().c_str()) + " </h4>";
-    }
+  if (snapshot.battery.settings.soc_scaling_active) {
+    out.print("<h4 style='color: white;'>Scaled remaining capacity: ");
+    print_power(out, snapshot.battery.status.reported_remaining_capacity_Wh, "h", 1);
+    out.print(" (real: ");
+    print_power(out, snapshot.battery.status.remaining_capacity_Wh, "h", 1);
+    out.print(")</h4>");
+  } else {
+    print_power_line(out, "Remaining capacity", snapshot.battery.status.remaining_capacity_Wh, "h", 1);
+  }
 
-    content += "<h4>Emulator allows contactor closing: ";
-    if (datalayer.battery.status.bms_status == FAULT) {
-      content += "<span style='color: red;'>&#10005;</span>";
+  if (datalayer.system.info.equipment_stop_active) {
+    print_power_line(out, "Max discharge power", snapshot.battery.status.max_discharge_power_W, "", 1, "red");
+    print_power_line(out, "Max charge power", snapshot.battery.status.max_charge_power_W, "", 1, "red");
+    out.print("<h4 style='color: red;'>Max discharge current: ");
+    out.print(maxCurrentDischargeFloat, 1);
+    out.print(" A</h4>");
+    out.print("<h4 style='color: red;'>Max charge current: ");
+    out.print(maxCurrentChargeFloat, 1);
+    out.print(" A</h4>");
+  } else {
+    print_power_line(out, "Max discharge power", snapshot.battery.status.max_discharge_power_W, "", 1);
+    print_power_line(out, "Max charge power", snapshot.battery.status.max_charge_power_W, "", 1);
+    out.print("<h4 style='color: white;'>Max discharge current: ");
+    out.print(maxCurrentDischargeFloat, 1);
+    out.print(" A");
+    if (snapshot.battery.settings.remote_settings_limit_discharge) {
+      out.print(" (Remote)</h4>");
+    } else if (snapshot.battery.settings.user_settings_limit_discharge) {
+      out.print(" (Manual)</h4>");
     } else {
-      content += "<span>&#10003;</span>";
+      out.print(" (BMS)</h4>");
     }
-    content += " Inverter allows contactor closing: ";
-    if (datalayer.system.status.inverter_allows_contactor_closing == true) {
-      content += "<span>&#10003;</span></h4>";
+    out.print("<h4 style='color: white;'>Max charge current: ");
+    out.print(maxCurrentChargeFloat, 1);
+    out.print(" A");
+    if (snapshot.battery.settings.remote_settings_limit_charge) {
+      out.print(" (Remote)</h4>");
+    } else if (snapshot.battery.settings.user_settings_limit_charge) {
+      out.print(" (Manual)</h4>");
     } else {
-      content += "<span style='color: red;'>&#10005;</span></h4>";
+      out.print(" (BMS)</h4>");
     }
-    if (battery2) {
-      content += "<h4>Secondary battery allowed to join ";
-      if (datalayer.system.status.battery2_allowed_contactor_closing == true) {
-        content += "<span>&#10003;</span>";
-      } else {
-        content += "<span style='color: red;'>&#10005; (voltage mismatch)</span>";
-      }
+  }
+
+  out.print("<h4>Cell min/max: ");
+  out.print(snapshot.battery.status.cell_min_voltage_mV);
+  out.print(" mV / ");
+  out.print(snapshot.battery.status.cell_max_voltage_mV);
+  out.print(" mV</h4>");
+  if (cell_delta_mv > snapshot.battery.info.max_cell_voltage_deviation_mV) {
+    out.print("<h4 style='color: red;'>Cell delta: ");
+    out.print(cell_delta_mv);
+    out.print(" mV</h4>");
+  } else {
+    out.print("<h4>Cell delta: ");
+    out.print(cell_delta_mv);
+    out.print(" mV</h4>");
+  }
+  out.print("<h4>Temperature min/max: ");
+  out.print(tempMinFloat, 1);
+  out.print(" &deg;C / ");
+  out.print(tempMaxFloat, 1);
+  out.print(" &deg;C</h4>");
+
+  out.print("<h4>System status: ");
+  switch (snapshot.battery.status.bms_status) {
+    case ACTIVE:
+      out.print("OK");
+      break;
+    case UPDATING:
+      out.print("UPDATING");
+      break;
+    case FAULT:
+      out.print("FAULT");
+      break;
+    case INACTIVE:
+      out.print("INACTIVE");
+      break;
+    case STANDBY:
+      out.print("STANDBY");
+      break;
+    default:
+      out.print("??");
+      break;
+  }
+  out.print("</h4>");
+
+  if (battery && battery->supports_real_BMS_status()) {
+    out.print("<h4>Battery BMS status: ");
+    switch (snapshot.battery.status.real_bms_status) {
+      case BMS_ACTIVE:
+        out.print("OK");
+        break;
+      case BMS_FAULT:
+        out.print("FAULT");
+        break;
+      case BMS_DISCONNECTED:
+        out.print("DISCONNECTED");
+        break;
+      case BMS_STANDBY:
+        out.print("STANDBY");
+        break;
+      default:
+        out.print("??");
+        break;
     }
+    out.print("</h4>");
+  }
 
-    if (!contactor_control_enabled) {
-      content += "<div class=\"tooltip\">";
-      content += "<h4>Contactors not fully controlled via emulator <span style=\"color:orange\">[?]</span></h4>";
-      content +=
-          "<span class=\"tooltiptext\">This means you are either running CAN controlled contactors OR manually "
-          "powering the contactors. Battery-Emulator will have limited amount of control over the contactors!</span>";
-      content += "</div>";
-    } else {  //contactor_control_enabled TRUE
-      content += "<div class=\"tooltip\"><h4>Contactors controlled by emulator, state: ";
-      if (datalayer.system.status.contactors_engaged == 0) {
-        content += "<span style='color: red;'>OFF (DISCONNECTED)</span>";
-      } else if (datalayer.system.status.contactors_engaged == 1) {
-        content += "<span style='color: green;'>ON</span>";
-      } else if (datalayer.system.status.contactors_engaged == 2) {
-        content += "<span style='color: red;'>OFF (FAULT)</span>";
-        content += "<span class=\"tooltip-icon\"> [!]</span>";
-        content +=
-            "<span class=\"tooltiptext\">Emulator spent too much time in critical FAULT event. Investigate event "
-            "causing this via Events page. Reboot required to resume operation!</span>";
-      } else if (datalayer.system.status.contactors_engaged == 3) {
-        content += "<span style='color: orange;'>PRECHARGE</span>";
+  if (snapshot.battery.status.current_dA == 0) {
+    out.print("<h4>Battery idle</h4>");
+  } else if (snapshot.battery.status.current_dA < 0) {
+    out.print("<h4>Battery discharging!");
+    if (snapshot.battery.settings.inverter_limits_discharge) {
+      out.print(" (Inverter limiting)</h4>");
+    } else {
+      if (snapshot.battery.settings.user_settings_limit_discharge) {
+        out.print(" (Settings limiting)</h4>");
+      } else {
+        out.print(" (Battery limiting)</h4>");
       }
-      content += "</h4></div>";
-      if (contactor_control_enabled_double_battery && battery2) {
-        content += "<h4>Secondary battery contactor, state: ";
-        if (pwm_contactor_control) {
-          if (datalayer.system.status.contactors_battery2_engaged) {
-            content += "<span style='color: green;'>Economized</span>";
-          } else {
-            content += "<span style='color: red;'>OFF</span>";
-          }
-        } else if (
-            esp32hal->SECOND_BATTERY_CONTACTORS_PIN() !=
-            GPIO_NUM_NC) {  // No PWM_CONTACTOR_CONTROL , we can read the pin and see feedback. Helpful if channel overloaded
-          if (digitalRead(esp32hal->SECOND_BATTERY_CONTACTORS_PIN()) == HIGH) {
-            content += "<span style='color: green;'>ON</span>";
-          } else {
-            content += "<span style='color: red;'>OFF</span>";
-          }
-        }  //no PWM_CONTACTOR_CONTROL
-        content += "</h4>";
+    }
+    out.print("</h4>");
+  } else {  // > 0 , positive current
+    out.print("<h4>Battery charging!");
+    if (snapshot.battery.settings.inverter_limits_charge) {
+      out.print(" (Inverter limiting)</h4>");
+    } else {
+      if (snapshot.battery.settings.user_settings_limit_charge) {
+        out.print(" (Settings limiting)</h4>");
+      } else {
+        out.print(" (Battery limiting)</h4>");
       }
     }
+  }
 
-    // Close the block
-    content += "</div>";
+  // Close the block
+  out.print("</div>");
+  return true;
+}
 
-    if (charger) {
-      // Start a new block with orange background color
-      content += "<div style='background-color: #FF6E00; padding: 10px; margin-bottom: 10px;border-radius: 50px'>";
+// Block of the second battery. Color changes depending on BMS status
+static bool write_battery2(HtmlWriter& out, const DATALAYER_SNAPSHOT_TYPE& snapshot) {
+  out.print("<div style='flex: 1; background-color: ");
+  switch (snapshot.battery.status.bms_status) {
+    case ACTIVE:
+      out.print("#2D3F2F;");
+      break;
+    case FAULT:
+      out.print("#A70107;");
+      break;
+    default:
+      out.print("#2D3F2F;");
+      break;
+  }
+  // Add the common style properties
+  out.print("padding: 10px; margin-bottom: 10px; border-radius: 50px;'>");
+
+  // Same as for the first battery
+  float socScaledFloat = static_cast<float>(snapshot.battery.status.reported_soc) / 100.0f;
+  float maxCurrentChargeFloat = static_cast<float>(snapshot.battery.status.max_charge_current_dA) / 10.0f;
+  float maxCurrentDischargeFloat = static_cast<float>(snapshot.battery.status.max_discharge_current_dA) / 10.0f;
+
+  // Display battery statistics within this block
+  float socRealFloat =
+      static_cast<float>(snapshot.battery2.status.real_soc) / 100.0f;  // Convert to float and divide by 100
+  //socScaledFloat; // Same value used for bat2
+  float sohFloat =
+      static_cast<float>(snapshot.battery2.status.soh_pptt) / 100.0f;  // Convert to float and divide by 100
+  float voltageFloat =
+      static_cast<float>(snapshot.battery2.status.voltage_dV) / 10.0f;  // Convert to float and divide by 10
+  float currentFloat =
+      static_cast<float>(snapshot.battery2.status.current_dA) / 10.0f;       // Convert to float and divide by 10
+  float powerFloat = static_cast<float>(snapshot.battery2.status.active_power_W);  // Convert to float
+  float tempMaxFloat = static_cast<float>(snapshot.battery2.status.temperature_max_dC) / 10.0f;  // Convert to float
+  float tempMinFloat = static_cast<float>(snapshot.battery2.status.temperature_min_dC) / 10.0f;  // Convert to float
+  uint16_t cell_delta_mv = snapshot.battery2.status.cell_max_voltage_mV - snapshot.battery2.status.cell_min_voltage_mV;
+
+  if (snapshot.battery.settings.soc_scaling_active) {
+    out.print("<h4 style='color: white;'>Scaled SOC: ");
+    out.print(socScaledFloat, 2);
+    out.print("&percnt; (real: ");
+    out.print(socRealFloat, 2);
+    out.print("&percnt;)</h4>");
+  } else {
+    out.print("<h4 style='color: white;'>SOC: ");
+    out.print(socRealFloat, 2);
+    out.print("&percnt;</h4>");
+  }
 
-      content += "<h4>Charger HV Enabled: ";
-      if (datalayer.charger.charger_HV_enabled) {
-        content += "<span>&#10003;</span>";
-      } else {
-        content += "<span style='color: red;'>&#10005;</span>";
-      }
-      content += "</h4>";
+  out.print("<h4 style='color: white;'>SOH: ");
+  out.print(sohFloat, 2);
+  out.print("&percnt;</h4>");
+  out.print("<h4 style='color: white;'>Voltage: ");
+  out.print(voltageFloat, 1);
+  out.print(" V &nbsp; Current: ");
+  out.print(currentFloat, 1);
+  out.print(" A</h4>");
+  print_power_line(out, "Power", powerFloat, "", 1);
+
+  if (snapshot.battery.settings.soc_scaling_active) {
+    out.print("<h4 style='color: white;'>Scaled total capacity: ");
+    print_power(out, snapshot.battery2.info.reported_total_capacity_Wh, "h", 1);
+    out.print(" (real: ");
+    print_power(out, snapshot.battery2.info.total_capacity_Wh, "h", 1);
+    out.print(")</h4>");
+  } else {
+    print_power_line(out, "Total capacity", snapshot.battery2.info.total_capacity_Wh, "h", 1);
+  }
 
-      content += "<h4>Charger Aux12v Enabled: ";
-      if (datalayer.charger.charger_aux12V_enabled) {
-        content += "<span>&#10003;</span>";
-      } else {
-        content += "<span style='color: red;'>&#10005;</span>";
-      }
-      content += "</h4>";
+  if (snapshot.battery.settings.soc_scaling_active) {
+    out.print("<h4 style='color: white;'>Scaled remaining capacity: ");
+    print_power(out, snapshot.battery2.status.reported_remaining_capacity_Wh, "h", 1);
+    out.print(" (real: ");
+    print_power(out, snapshot.battery2.status.remaining_capacity_Wh, "h", 1);
+    out.print(")</h4>");
+  } else {
+    print_power_line(out, "Remaining capacity", snapshot.battery2.status.remaining_capacity_Wh, "h", 1);
+  }
 
-      auto chgPwrDC = charger->outputPowerDC();
-      auto chgEff = charger->efficiency();
+  if (datalayer.system.info.equipment_stop_active) {
+    print_power_line(out, "Max discharge power", snapshot.battery2.status.max_discharge_power_W, "", 1, "red");
+    print_power_line(out, "Max charge power", snapshot.battery2.status.max_charge_power_W, "", 1, "red");
+    out.print("<h4 style='color: red;'>Max discharge current: ");
+    out.print(maxCurrentDischargeFloat, 1);
+    out.print(" A</h4>");
+    out.print("<h4 style='color: red;'>Max charge current: ");
+    out.print(maxCurrentChargeFloat, 1);
+    out.print(" A</h4>");
+  } else {
+    print_power_line(out, "Max discharge power", snapshot.battery2.status.max_discharge_power_W, "", 1);
+    print_power_line(out, "Max charge power", snapshot.battery2.status.max_charge_power_W, "", 1);
+    out.print("<h4 style='color: white;'>Max discharge current: ");
+    out.print(maxCurrentDischargeFloat, 1);
+    out.print(" A</h4>");
+    out.print("<h4 style='color: white;'>Max charge current: ");
+    out.print(maxCurrentChargeFloat, 1);
+    out.print(" A</h4>");
+  }
 
-      content += formatPowerValue("Charger Output Power", chgPwrDC, "", 1);
-      if (charger->efficiencySupported()) {
-        content += "<h4 style='color: white;'>Charger Efficiency: " + String(chgEff) + "%</h4>";
-      }
+  out.print("<h4>Cell min/max: ");
+  out.print(snapshot.battery2.status.cell_min_voltage_mV);
+  out.print(" mV / ");
+  out.print(snapshot.battery2.status.cell_max_voltage_mV);
+  out.print(" mV</h4>");
+  if (cell_delta_mv > snapshot.battery2.info.max_cell_voltage_deviation_mV) {
+    out.print("<h4 style='color: red;'>Cell delta: ");
+    out.print(cell_delta_mv);
+    out.print(" mV</h4>");
+  } else {
+    out.print("<h4>Cell delta: ");
+    out.print(cell_delta_mv);
+    out.print(" mV</h4>");
+  }
+  out.print("<h4>Temperature min/max: ");
+  out.print(tempMinFloat, 1);
+  out.print(" &deg;C / ");
+  out.print(tempMaxFloat, 1);
+  out.print(" &deg;C</h4>");
+  if (snapshot.battery.status.bms_status == ACTIVE) {
+    out.print("<h4>System status: OK </h4>");
+  } else if (snapshot.battery.status.bms_status == UPDATING) {
+    out.print("<h4>System status: UPDATING </h4>");
+  } else {
+    out.print("<h4>System status: FAULT </h4>");
+  }
+  if (snapshot.battery2.status.current_dA == 0) {
+    out.print("<h4>Battery idle</h4>");
+  } else if (snapshot.battery2.status.current_dA < 0) {
+    out.print("<h4>Battery discharging!</h4>");
+  } else {  // > 0
+    out.print("<h4>Battery charging!</h4>");
+  }
+  out.print("</div>");
+  return true;
+}
 
-      float HVvol = charger->HVDC_output_voltage();
-      float HVcur = charger->HVDC_output_current();
-      float LVvol = charger->LVDC_output_voltage();
-      float LVcur = charger->LVDC_output_current();
+// Block of the third battery
+static bool write_battery3(HtmlWriter& out, const DATALAYER_SNAPSHOT_TYPE& snapshot) {
+  out.print("<div style='flex: 1; background-color: ");
+  switch (snapshot.battery.status.bms_status) {
+    case ACTIVE:
+      out.print("#2D3F2F;");
+      break;
+    case FAULT:
+      out.print("#A70107;");
+      break;
+    default:
+      out.print("#2D3F2F;");
+      break;
+  }
+  // Add the common style properties
+  out.print("padding: 10px; margin-bottom: 10px; border-radius: 50px;'>");
+
+  // Same as for the first battery
+  float socScaledFloat = static_cast<float>(snapshot.battery.status.reported_soc) / 100.0f;
+  float maxCurrentChargeFloat = static_cast<float>(snapshot.battery.status.max_charge_current_dA) / 10.0f;
+  float maxCurrentDischargeFloat = static_cast<float>(snapshot.battery.status.max_discharge_current_dA) / 10.0f;
+
+  // Display battery statistics within this block
+  float socRealFloat =
+      static_cast<float>(snapshot.battery3.status.real_soc) / 100.0f;  // Convert to float and divide by 100
+  //socScaledFloat; // Same value used for bat2
+  float sohFloat =
+      static_cast<float>(snapshot.battery3.status.soh_pptt) / 100.0f;  // Convert to float and divide by 100
+  float voltageFloat =
+      static_cast<float>(snapshot.battery3.status.voltage_dV) / 10.0f;  // Convert to float and divide by 10
+  float currentFloat =
+      static_cast<float>(snapshot.battery3.status.current_dA) / 10.0f;  // Convert to float and divide by 10
+  float powerFloat = static_cast<float>(snapshot.battery3.status.active_power_W);                // Convert to float
+  float tempMaxFloat = static_cast<float>(snapshot.battery3.status.temperature_max_dC) / 10.0f;  // Convert to float
+  float tempMinFloat = static_cast<float>(snapshot.battery3.status.temperature_min_dC) / 10.0f;  // Convert to float
+  uint16_t cell_delta_mv = snapshot.battery3.status.cell_max_voltage_mV - snapshot.battery3.status.cell_min_voltage_mV;
+
+  if (snapshot.battery.settings.soc_scaling_active) {
+    out.print("<h4 style='color: white;'>Scaled SOC: ");
+    out.print(socScaledFloat, 2);
+    out.print("&percnt; (real: ");
+    out.print(socRealFloat, 2);
+    out.print("&percnt;)</h4>");
+  } else {
+    out.print("<h4 style='color: white;'>SOC: ");
+    out.print(socRealFloat, 2);
+    out.print("&percnt;</h4>");
+  }
 
-      content += "<h4 style='color: white;'>Charger HVDC Output V: " + String(HVvol, 2) + " V</h4>";
-      content += "<h4 style='color: white;'>Charger HVDC Output I: " + String(HVcur, 2) + " A</h4>";
-      content += "<h4 style='color: white;'>Charger LVDC Output I: " + String(LVcur, 2) + "</h4>";
-      content += "<h4 style='color: white;'>Charger LVDC Output V: " + String(LVvol, 2) + "</h4>";
+  out.print("<h4 style='color: white;'>SOH: ");
+  out.print(sohFloat, 2);
+  out.print("&percnt;</h4>");
+  out.print("<h4 style='color: white;'>Voltage: ");
+  out.print(voltageFloat, 1);
+  out.print(" V &nbsp; Current: ");
+  out.print(currentFloat, 1);
+  out.print(" A</h4>");
+  print_power_line(out, "Power", powerFloat, "", 1);
+
+  if (snapshot.battery.settings.soc_scaling_active) {
+    out.print("<h4 style='color: white;'>Scaled total capacity: ");
+    print_power(out, snapshot.battery3.info.reported_total_capacity_Wh, "h", 1);
+    out.print(" (real: ");
+    print_power(out, snapshot.battery3.info.total_capacity_Wh, "h", 1);
+    out.print(")</h4>");
+  } else {
+    print_power_line(out, "Total capacity", snapshot.battery3.info.total_capacity_Wh, "h", 1);
+  }
 
-      float ACcur = charger->AC_input_current();
-      float ACvol = charger->AC_input_voltage();
+  if (snapshot.battery.settings.soc_scaling_active) {
+    out.print("<h4 style='color: white;'>Scaled remaining capacity: ");
+    print_power(out, snapshot.battery3.status.reported_remaining_capacity_Wh, "h", 1);
+    out.print(" (real: ");
+    print_power(out, snapshot.battery3.status.remaining_capacity_Wh, "h", 1);
+    out.print(")</h4>");
+  } else {
+    print_power_line(out, "Remaining capacity", snapshot.battery3.status.remaining_capacity_Wh, "h", 1);
+  }
 
-      content += "<h4 style='color: white;'>Charger AC Input V: " + String(ACvol, 2) + " VAC</h4>";
-      content += "<h4 style='color: white;'>Charger AC Input I: " + String(ACcur, 2) + " A</h4>";
+  if (datalayer.system.info.equipment_stop_active) {
+    print_power_line(out, "Max discharge power", snapshot.battery3.status.max_discharge_power_W, "", 1, "red");
+    print_power_line(out, "Max charge power", snapshot.battery3.status.max_charge_power_W, "", 1, "red");
+    out.print("<h4 style='color: red;'>Max discharge current: ");
+    out.print(maxCurrentDischargeFloat, 1);
+    out.print(" A</h4>");
+    out.print("<h4 style='color: red;'>Max charge current: ");
+    out.print(maxCurrentChargeFloat, 1);
+    out.print(" A</h4>");
+  } else {
+    print_power_line(out, "Max discharge power", snapshot.battery3.status.max_discharge_power_W, "", 1);
+    print_power_line(out, "Max charge power", snapshot.battery3.status.max_charge_power_W, "", 1);
+    out.print("<h4 style='color: white;'>Max discharge current: ");
+    out.print(maxCurrentDischargeFloat, 1);
+    out.print(" A</h4>");
+    out.print("<h4 style='color: white;'>Max charge current: ");
+    out.print(maxCurrentChargeFloat, 1);
+    out.print(" A</h4>");
+  }
 
-      content += "</div>";
+  out.print("<h4>Cell min/max: ");
+  out.print(snapshot.battery3.status.cell_min_voltage_mV);
+  out.print(" mV / ");
+  out.print(snapshot.battery3.status.cell_max_voltage_mV);
+  out.print(" mV</h4>");
+  if (cell_delta_mv > snapshot.battery3.info.max_cell_voltage_deviation_mV) {
+    out.print("<h4 style='color: red;'>Cell delta: ");
+    out.print(cell_delta_mv);
+    out.print(" mV</h4>");
+  } else {
+    out.print("<h4>Cell delta: ");
+    out.print(cell_delta_mv);
+    out.print(" mV</h4>");
+  }
+  out.print("<h4>Temperature min/max: ");
+  out.print(tempMinFloat, 1);
+  out.print(" &deg;C / ");
+  out.print(tempMaxFloat, 1);
+  out.print(" &deg;C</h4>");
+  if (snapshot.battery.status.bms_status == ACTIVE) {
+    out.print("<h4>System status: OK </h4>");
+  } else if (snapshot.battery.status.bms_status == UPDATING) {
+    out.print("<h4>System status: UPDATING </h4>");
+  } else {
+    out.print("<h4>System status: FAULT </h4>");
+  }
+  if (snapshot.battery3.status.current_dA == 0) {
+    out.print("<h4>Battery idle</h4>");
+  } else if (snapshot.battery3.status.current_dA < 0) {
+    out.print("<h4>Battery discharging!</h4>");
+  } else {  // > 0
+    out.print("<h4>Battery charging!</h4>");
+  }
+  out.print("</div>");
+  out.print("</div>");
+  return true;
+}
+
+// Contactor status and component request status
+static bool write_contactor_status(HtmlWriter& out, const DATALAYER_SNAPSHOT_TYPE& snapshot) {
+  // Block for Contactor status and component request status
+  // Start a new block with gray background color
+  out.print("<div style='background-color: #333; padding: 10px; margin-bottom: 10px;border-radius: 50px'>");
+
+  if (emulator_pause_status == NORMAL) {
+    out.print("<h4>Power status: ");
+    out.print(get_emulator_pause_status().c_str());
+    out.print(" </h4>");
+  } else {
+    out.print("<h4 style='color: red;'>Power status: ");
+    out.print(get_emulator_pause_status().c_str());
+    out.print(" </h4>");
+  }
+
+  out.print("<h4>Emulator allows contactor closing: ");
+  if (snapshot.battery.status.bms_status == FAULT) {
+    out.print("<span style='color: red;'>&#10005;</span>");
+  } else {
+    out.print("<span>&#10003;</span>");
+  }
+  out.print(" Inverter allows contactor closing: ");
+  if (snapshot.system.status.inverter_allows_contactor_closing == true) {
+    out.print("<span>&#10003;</span></h4>");
+  } else {
+    out.print("<span style='color: red;'>&#10005;</span></h4>");
+  }
+  if (battery2) {
+    out.print("<h4>Secondary battery allowed to join ");
+    if (snapshot.system.status.battery2_allowed_contactor_closing == true) {
+      out.print("<span>&#10003;</span>");
+    } else {
+      out.print("<span style='color: red;'>&#10005; (voltage mismatch)</span>");
     }
+  }
 
-    if (emulator_pause_request_ON)
-      content += "<button onclick='PauseBattery(false)'>Resume charge/discharge</button> ";
-    else
-      content +=
-          "<button onclick=\"if(confirm('Are you sure you want to pause charging and discharging? This will set the "
-          "maximum charge and discharge values to zero, preventing any further power flow.')) { PauseBattery(true); "
-          "}\">Pause charge/discharge</button> ";
-
-    content += "<button onclick='OTA()'>Perform OTA update</button> ";
-    content += "<button onclick='Settings()'>Change Settings</button> ";
-    content += "<button onclick='Advanced()'>More Battery Info</button> ";
-    content += "<button onclick='CANlog()'>CAN logger</button> ";
-    content += "<button onclick='CANreplay()'>CAN replay</button> ";
-    if (datalayer.system.info.web_logging_active || datalayer.system.info.SD_logging_active) {
-      content += "<button onclick='Log()'>Log</button> ";
+  if (!contactor_control_enabled) {
+    out.print("<div class=\"tooltip\">");
+    out.print("<h4>Contactors not fully controlled via emulator <span style=\"color:orange\">[?]</span></h4>");
+    out.print(
+        "<span class=\"tooltiptext\">This means you are either running CAN controlled contactors OR manually "
+        "powering the contactors. Battery-Emulator will have limited amount of control over the contactors!</span>");
+    out.print("</div>");
+  } else {  //contactor_control_enabled TRUE
+    out.print("<div class=\"tooltip\"><h4>Contactors controlled by emulator, state: ");
+    if (snapshot.system.status.contactors_engaged == 0) {
+      out.print("<span style='color: red;'>OFF (DISCONNECTED)</span>");
+    } else if (snapshot.system.status.contactors_engaged == 1) {
+      out.print("<span style='color: green;'>ON</span>");
+    } else if (snapshot.system.status.contactors_engaged == 2) {
+      out.print("<span style='color: red;'>OFF (FAULT)</span>");
+      out.print("<span class=\"tooltip-icon\"> [!]</span>");
+      out.print(
+          "<span class=\"tooltiptext\">Emulator spent too much time in critical FAULT event. Investigate event "
+          "causing this via Events page. Reboot required to resume operation!</span>");
+    } else if (snapshot.system.status.contactors_engaged == 3) {
+      out.print("<span style='color: orange;'>PRECHARGE</span>");
     }
-    content += "<button onclick='Cellmon()'>Cellmonitor</button> ";
-    content += "<button onclick='Events()'>Events</button> ";
-    content += "<button onclick='askReboot()'>Reboot Emulator</button>";
-    if (webserver_auth)
-      content += "<button onclick='logout()'>Logout</button>";
-    if (!datalayer.system.info.equipment_stop_active)
-      content +=
-          "<br/><button style=\"background:red;color:white;cursor:pointer;\""
-          " onclick=\""
-          "if(confirm('This action will attempt to open contactors on the battery. Are you "
-          "sure?')) { estop(true); }\""
-          ">Open Contactors</button><br/>";
-    else
-      content +=
-          "<br/><button style=\"background:green;color:white;cursor:pointer;\""
-          "20px;font-size:16px;font-weight:bold;cursor:pointer;border-radius:5px; margin:10px;"
-          " onclick=\""
-          "if(confirm('This action will attempt to close contactors and enable power transfer. Are you sure?')) { "
-          "estop(false); }\""
-          ">Close Contactors</button><br/>";
-    content += "<script>";
-    content += "function OTA() { window.location.href = '/update'; }";
-    content += "function Cellmon() { window.location.href = '/cellmonitor'; }";
-    content += "function Settings() { window.location.href = '/settings'; }";
-    content += "function Advanced() { window.location.href = '/advanced'; }";
-    content += "function CANlog() { window.location.href = '/canlog'; }";
-    content += "function CANreplay() { window.location.href = '/canreplay'; }";
-    content += "function Log() { window.location.href = '/log'; }";
-    content += "function Events() { window.location.href = '/events'; }";
-    if (webserver_auth) {
-      content += "function logout() {";
-      content += "  var xhr = new XMLHttpRequest();";
-      content += "  xhr.open('GET', '/logout', true);";
-      content += "  xhr.send();";
-      content += "  setTimeout(function(){ window.open(\"/\",\"_self\"); }, 1000);";
-      content += "}";
+    out.print("</h4></div>");
+    if (contactor_control_enabled_double_battery && battery2) {
+      out.print("<h4>Secondary battery contactor, state: ");
+      if (pwm_contactor_control) {
+        if (snapshot.system.status.contactors_battery2_engaged) {
+          out.print("<span style='color: green;'>Economized</span>");
+        } else {
+          out.print("<span style='color: red;'>OFF</span>");
+        }
+      } else if (
+          esp32hal->SECOND_BATTERY_CONTACTORS_PIN() !=
+          GPIO_NUM_NC) {  // No PWM_CONTACTOR_CONTROL , we can read the pin and see feedback. Helpful if channel overloaded
+        if (digitalRead(esp32hal->SECOND_BATTERY_CONTACTORS_PIN()) == HIGH) {
+          out.print("<span style='color: green;'>ON</span>");
+        } else {
+          out.print("<span style='color: red;'>OFF</span>");
+        }
+      }  //no PWM_CONTACTOR_CONTROL
+      out.print("</h4>");
     }
-    content += "function PauseBattery(pause){";
-    content +=
-        "var xhr=new "
-        "XMLHttpRequest();xhr.onload=function() { "
-        "window.location.reload();};xhr.open('GET','/pause?value='+pause,true);xhr.send();";
-    content += "}";
-    content += "function estop(stop){";
-    content +=
-        "var xhr=new "
-        "XMLHttpRequest();xhr.onload=function() { "
-        "window.location.reload();};xhr.open('GET','/equipmentStop?value='+stop,true);xhr.send();";
-    content += "}";
-    content += "</script>";
-
-    //Script for refreshing page
-    content += "<script>";
-    content += "setTimeout(function(){ location.reload(true); }, 15000);";
-    content += "</script>";
+  }
 
-    return content;
+  // Close the block
+  out.print("</div>");
+  return true;
+}
+
+static bool write_charger(HtmlWriter& out, const DATALAYER_SNAPSHOT_TYPE& snapshot) {
+  // Start a new block with orange background color
+  out.print("<div style='background-color: #FF6E00; padding: 10px; margin-bottom: 10px;border-radius: 50px'>");
+
+  out.print("<h4>Charger HV Enabled: ");
+  if (snapshot.charger.charger_HV_enabled) {
+    out.print("<span>&#10003;</span>");
+  } else {
+    out.print("<span style='color: red;'>&#10005;</span>");
   }
-  return String();
+  out.print("</h4>");
+
+  out.print("<h4>Charger Aux12v Enabled: ");
+  if (snapshot.charger.charger_aux12V_enabled) {
+    out.print("<span>&#10003;</span>");
+  } else {
+    out.print("<span style='color: red;'>&#10005;</span>");
+  }
+  out.print("</h4>");
+
+  auto chgPwrDC = charger->outputPowerDC();
+  auto chgEff = charger->efficiency();
+
+  print_power_line(out, "Charger Output Power", chgPwrDC, "", 1);
+  if (charger->efficiencySupported()) {
+    out.print("<h4 style='color: white;'>Charger Efficiency: ");
+    out.print(chgEff);
+    out.print("%</h4>");
+  }
+
+  float HVvol = charger->HVDC_output_voltage();
+  float HVcur = charger->HVDC_output_current();
+  float LVvol = charger->LVDC_output_voltage();
+  float LVcur = charger->LVDC_output_current();
+
+  out.print("<h4 style='color: white;'>Charger HVDC Output V: ");
+  out.print(HVvol, 2);
+  out.print(" V</h4>");
+  out.print("<h4 style='color: white;'>Charger HVDC Output I: ");
+  out.print(HVcur, 2);
+  out.print(" A</h4>");
+  out.print("<h4 style='color: white;'>Charger LVDC Output I: ");
+  out.print(LVcur, 2);
+  out.print("</h4>");
+  out.print("<h4 style='color: white;'>Charger LVDC Output V: ");
+  out.print(LVvol, 2);
+  out.print("</h4>");
+
+  float ACcur = charger->AC_input_current();
+  float ACvol = charger->AC_input_voltage();
+
+  out.print("<h4 style='color: white;'>Charger AC Input V: ");
+  out.print(ACvol, 2);
+  out.print(" VAC</h4>");
+  out.print("<h4 style='color: white;'>Charger AC Input I: ");
+  out.print(ACcur, 2);
+  out.print(" A</h4>");
+
+  out.print("</div>");
+  return true;
+}
+
+// Buttons and the scripts behind them
+static bool write_buttons(HtmlWriter& out) {
+  if (emulator_pause_request_ON)
+    out.print("<button onclick='PauseBattery(false)'>Resume charge/discharge</button> ");
+  else
+    out.print(
+        "<button onclick=\"if(confirm('Are you sure you want to pause charging and discharging? This will set the "
+        "maximum charge and discharge values to zero, preventing any further power flow.')) { PauseBattery(true); "
+        "}\">Pause charge/discharge</button> ");
+
+  out.print("<button onclick='OTA()'>Perform OTA update</button> ");
+  out.print("<button onclick='Settings()'>Change Settings</button> ");
+  out.print("<button onclick='Advanced()'>More Battery Info</button> ");
+  out.print("<button onclick='CANlog()'>CAN logger</button> ");
+  out.print("<button onclick='CANreplay()'>CAN replay</button> ");
+  if (datalayer.system.info.web_logging_active || datalayer.system.info.SD_logging_active) {
+    out.print("<button onclick='Log()'>Log</button> ");
+  }
+  out.print("<button onclick='Cellmon()'>Cellmonitor</button> ");
+  out.print("<button onclick='Events()'>Events</button> ");
+  out.print("<button onclick='askReboot()'>Reboot Emulator</button>");
+  if (webserver_auth)
+    out.print("<button onclick='logout()'>Logout</button>");
+  if (!datalayer.system.info.equipment_stop_active)
+    out.print(
+        "<br/><button style=\"background:red;color:white;cursor:pointer;\""
+        " onclick=\""
+        "if(confirm('This action will attempt to open contactors on the battery. Are you "
+        "sure?')) { estop(true); }\""
+        ">Open Contactors</button><br/>");
+  else
+    out.print(
+        "<br/><button style=\"background:green;color:white;cursor:pointer;\""
+        "20px;font-size:16px;font-weight:bold;cursor:pointer;border-radius:5px; margin:10px;"
+        " onclick=\""
+        "if(confirm('This action will attempt to close contactors and enable power transfer. Are you sure?')) { "
+        "estop(false); }\""
+        ">Close Contactors</button><br/>");
+  out.print("<script>");
+  out.print("function OTA() { window.location.href = '/update'; }");
+  out.print("function Cellmon() { window.location.href = '/cellmonitor'; }");
+  out.print("function Settings() { window.location.href = '/settings'; }");
+  out.print("function Advanced() { window.location.href = '/advanced'; }");
+  out.print("function CANlog() { window.location.href = '/canlog'; }");
+  out.print("function CANreplay() { window.location.href = '/canreplay'; }");
+  out.print("function Log() { window.location.href = '/log'; }");
+  out.print("function Events() { window.location.href = '/events'; }");
+  if (webserver_auth) {
+    out.print("function logout() {");
+    out.print("  var xhr = new XMLHttpRequest();");
+    out.print("  xhr.open('GET', '/logout', true);");
+    out.print("  xhr.send();");
+    out.print("  setTimeout(function(){ window.open(\"/\",\"_self\"); }, 1000);");
+    out.print("}");
+  }
+  out.print("function PauseBattery(pause){");
+  out.print(
+      "var xhr=new "
+      "XMLHttpRequest();xhr.onload=function() { "
+      "window.location.reload();};xhr.open('GET','/pause?value='+pause,true);xhr.send();");
+  out.print("}");
+  out.print("function estop(stop){");
+  out.print(
+      "var xhr=new "
+      "XMLHttpRequest();xhr.onload=function() { "
+      "window.location.reload();};xhr.open('GET','/equipmentStop?value='+stop,true);xhr.send();");
+  out.print("}");
+  out.print("</script>");
+
+  //Script for refreshing page
+  out.print("<script>");
+  out.print("setTimeout(function(){ location.reload(true); }, 15000);");
+  out.print("</script>");
+  return true;
+}
+
+void main_page(HtmlPageStream& page) {
+  // The values of all parts are from one update round, see datalayer_snapshot.h. Owned by the parts of this page
+  // only, as the parts of another request are written in between.
+  auto snapshot = std::make_shared<DATALAYER_SNAPSHOT_TYPE>();
+  read_datalayer_snapshot(*snapshot);
+  auto with_snapshot = [snapshot](bool (*write)(HtmlWriter&, const DATALAYER_SNAPSHOT_TYPE&)) {
+    return [snapshot, write](HtmlWriter& out) { return write(out, *snapshot); };
+  };
+
+  page.add(index_html_header);
+  page.add(common_javascript);
+  page.add("<link rel='stylesheet' href='/main.css'>");
+  page.add(with_snapshot(write_system_info));
+  page.add(with_snapshot(write_comm_stats));
+  page.add(write_wifi_info);
+  page.add(with_snapshot(write_components));
+  if (battery) {
+    page.add(with_snapshot(write_battery));
+    if (battery2) {
+      page.add(with_snapshot(write_battery2));
+      if (battery3) {
+        page.add(with_snapshot(write_battery3));
+      }
+      page.add("</div>");
+    }
+  }
+  page.add(with_snapshot(write_contactor_status));
+  if (charger) {
+    page.add(with_snapshot(write_charger));
+  }
+  page.add(write_buttons);
+  page.add(index_html_footer);
 }
 
 void onOTAStart() {
@@ -1658,28 +2100,3 @@ void onOTAEnd(bool success) {
     setBatteryPause(false, false);
   }
 }
-
-template <typename T>  // This function makes power values appear as W when under 1000, and kW when over
-String formatPowerValue(String label, T value, String unit, int precision, String color) {
-  String result = "<h4 style='color: " + color + ";'>" + label + ": ";
-  result += formatPowerValue(value, unit, precision);
-  result += "</h4>";
-  return result;
-}
-template <typename T>  // This function makes power values appear as W when under 1000, and kW when over
-String formatPowerValue(T value, String unit, int precision) {
-  String result = "";
-
-  if (std::is_same<T, float>::value || std::is_same<T, uint16_t>::value || std::is_same<T, uint32_t>::value) {
-    float convertedValue = static_cast<float>(value);
-
-    if (convertedValue >= 1000.0f || convertedValue <= -1000.0f) {
-      result += String(convertedValue / 1000.0f, precision) + " kW";
-    } else {
-      result += String(convertedValue, 0) + " W";
-    }
-  }
-
-  result += unit;
-  return result;
-}
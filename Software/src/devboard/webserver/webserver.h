@@ -6,6 +6,7 @@
 #include "../../lib/ESP32Async-ESPAsyncWebServer/src/ESPAsyncWebServer.h"
 #include "../../lib/ayushsharma82-ElegantOTA/src/ElegantOTA.h"
 #include "../../lib/mathieucarbou-AsyncTCPSock/src/AsyncTCP.h"
+#include "html_stream.h"
 
 extern const char* version_number;  // The current software version, shown on webserver
 
@@ -48,13 +49,11 @@ void init_webserver();
 void init_ElegantOTA();
 
 /**
- * @brief Replaces placeholder with content section in web page
+ * @brief Adds the parts of the main web page
  *
- * @param[in] var
- *
- * @return String
+ * @param[in] page
  */
-String processor(const String& var);
+void main_page(HtmlPageStream& page);
 String get_firmware_info_processor(const String& var);
 
 /**
@@ -85,19 +84,6 @@ void onOTAProgress(size_t current, size_t final);
  */
 void onOTAEnd(bool success);
 
-/**
- * @brief Formats power values 
- *
- * @param[in] float or uint16_t 
- * 
- * @return string: values
- */
-template <typename T>
-String formatPowerValue(String label, T value, String unit, int precision, String color = "white");
-
-template <typename T>  // This function makes power values appear as W when under 1000, and kW when over
-String formatPowerValue(T value, String unit, int precision);
-
 extern void store_settings();
 
 void ota_monitor();
@@ -135,7 +135,7 @@ void AforeCanInverter::
   */
 }
 
-void AforeCanInverter::map_can_frame_to_variable(CAN_frame rx_frame) {
+void AforeCanInverter::map_can_frame_to_variable(const CAN_frame& rx_frame) {
   switch (rx_frame.ID) {
     case 0x305:  // Every 1s from inverter
       datalayer.system.status.CAN_inverter_still_alive = CAN_STILL_ALIVE;
@@ -22,80 +22,48 @@ void BydCanInverter::
 
   //Map values to CAN messages
   if (datalayer.battery.settings.user_set_voltage_limits_active) {  //If user is requesting a specific voltage
-    //Target charge voltage (eg 400.0V = 4000 , 16bits long)
-    BYD_110.data.u8[0] = (datalayer.battery.settings.max_user_set_charge_voltage_dV >> 8);
-    BYD_110.data.u8[1] = (datalayer.battery.settings.max_user_set_charge_voltage_dV & 0x00FF);
-    //Target discharge voltage (eg 300.0V = 3000 , 16bits long)
-    BYD_110.data.u8[2] = (datalayer.battery.settings.max_user_set_discharge_voltage_dV >> 8);
-    BYD_110.data.u8[3] = (datalayer.battery.settings.max_user_set_discharge_voltage_dV & 0x00FF);
+    //Target charge and discharge voltage (eg 400.0V = 4000 , 16bits long)
+    byd_110_encoder.encode(BYD_110, datalayer.battery.settings.max_user_set_charge_voltage_dV,
+                           datalayer.battery.settings.max_user_set_discharge_voltage_dV,
+                           datalayer.battery.status.max_discharge_current_dA,
+                           datalayer.battery.status.max_charge_current_dA);
   } else {  //Use the voltage based on battery reported design voltage +- offset to avoid triggering events
-    //Target charge voltage (eg 400.0V = 4000 , 16bits long)
-    BYD_110.data.u8[0] = ((datalayer.battery.info.max_design_voltage_dV - VOLTAGE_OFFSET_DV) >> 8);
-    BYD_110.data.u8[1] = ((datalayer.battery.info.max_design_voltage_dV - VOLTAGE_OFFSET_DV) & 0x00FF);
-    //Target discharge voltage (eg 300.0V = 3000 , 16bits long)
-    BYD_110.data.u8[2] = ((datalayer.battery.info.min_design_voltage_dV + VOLTAGE_OFFSET_DV) >> 8);
-    BYD_110.data.u8[3] = ((datalayer.battery.info.min_design_voltage_dV + VOLTAGE_OFFSET_DV) & 0x00FF);
+    byd_110_encoder.encode(BYD_110, datalayer.battery.info.max_design_voltage_dV - VOLTAGE_OFFSET_DV,
+                           datalayer.battery.info.min_design_voltage_dV + VOLTAGE_OFFSET_DV,
+                           datalayer.battery.status.max_discharge_current_dA,
+                           datalayer.battery.status.max_charge_current_dA);
   }
 
-  //Maximum discharge power allowed (Unit: A+1)
-  BYD_110.data.u8[4] = (datalayer.battery.status.max_discharge_current_dA >> 8);
-  BYD_110.data.u8[5] = (datalayer.battery.status.max_discharge_current_dA & 0x00FF);
-  //Maximum charge power allowed (Unit: A+1)
-  BYD_110.data.u8[6] = (datalayer.battery.status.max_charge_current_dA >> 8);
-  BYD_110.data.u8[7] = (datalayer.battery.status.max_charge_current_dA & 0x00FF);
-
   //SOC (100.00%)
-  BYD_150.data.u8[0] = (datalayer.battery.status.reported_soc >> 8);
-  BYD_150.data.u8[1] = (datalayer.battery.status.reported_soc & 0x00FF);
+  uint16_t reported_soc = datalayer.battery.status.reported_soc;
   if (user_selected_inverter_deye_workaround) {
     // Fix for avoiding offgrid Deye inverters to underdischarge batteries
     if (datalayer.battery.status.max_charge_current_dA == 0) {
       //Force to 100.00% incase battery no longer wants to charge
-      BYD_150.data.u8[0] = (10000 >> 8);
-      BYD_150.data.u8[1] = (10000 & 0x00FF);
+      reported_soc = 10000;
     }
     if (datalayer.battery.status.max_discharge_current_dA == 0) {
       //Force to 0% incase battery no longer wants to discharge
-      BYD_150.data.u8[0] = 0;
-      BYD_150.data.u8[1] = 0;
+      reported_soc = 0;
     }
   }
-  //StateOfHealth (100.00%)
-  BYD_150.data.u8[2] = (datalayer.battery.status.soh_pptt >> 8);
-  BYD_150.data.u8[3] = (datalayer.battery.status.soh_pptt & 0x00FF);
-  //Remaining capacity (Ah+1)
-  BYD_150.data.u8[4] = (remaining_capacity_ah >> 8);
-  BYD_150.data.u8[5] = (remaining_capacity_ah & 0x00FF);
-  //Fully charged capacity (Ah+1)
-  BYD_150.data.u8[6] = (fully_charged_capacity_ah >> 8);
-  BYD_150.data.u8[7] = (fully_charged_capacity_ah & 0x00FF);
+  byd_150_encoder.encode(BYD_150, reported_soc, datalayer.battery.status.soh_pptt, remaining_capacity_ah,
+                         fully_charged_capacity_ah);
 
   //Alarms
   //TODO: BYD Alarms are not implemented yet. Investigation needed on the bits in this message
   //BYD_190.data.u8[0] =
 
-  //Voltage (ex 370.0)
-  BYD_1D0.data.u8[0] = (datalayer.battery.status.voltage_dV >> 8);
-  BYD_1D0.data.u8[1] = (datalayer.battery.status.voltage_dV & 0x00FF);
-  //Current (ex 81.0A)
-  BYD_1D0.data.u8[2] = (datalayer.battery.status.current_dA >> 8);
-  BYD_1D0.data.u8[3] = (datalayer.battery.status.current_dA & 0x00FF);
-  //Temperature average
-  BYD_1D0.data.u8[4] = (temperature_average >> 8);
-  BYD_1D0.data.u8[5] = (temperature_average & 0x00FF);
-
-  //Temperature max
-  BYD_210.data.u8[0] = (datalayer.battery.status.temperature_max_dC >> 8);
-  BYD_210.data.u8[1] = (datalayer.battery.status.temperature_max_dC & 0x00FF);
-  //Temperature min
-  BYD_210.data.u8[2] = (datalayer.battery.status.temperature_min_dC >> 8);
-  BYD_210.data.u8[3] = (datalayer.battery.status.temperature_min_dC & 0x00FF);
-  //Capacity
-  BYD_250.data.u8[4] = (uint8_t)((datalayer.battery.info.reported_total_capacity_Wh / 100) >> 8);
-  BYD_250.data.u8[5] = (uint8_t)(datalayer.battery.info.reported_total_capacity_Wh / 100);
+  byd_1d0_encoder.encode(BYD_1D0, datalayer.battery.status.voltage_dV, datalayer.battery.status.current_dA,
+                         temperature_average);
+
+  byd_210_encoder.encode(BYD_210, datalayer.battery.status.temperature_max_dC,
+                         datalayer.battery.status.temperature_min_dC);
+
+  byd_250_encoder.encode(BYD_250, datalayer.battery.info.reported_total_capacity_Wh);
 }
 
-void BydCanInverter::map_can_frame_to_variable(CAN_frame rx_frame) {
+void BydCanInverter::map_can_frame_to_variable(const CAN_frame& rx_frame) {
   switch (rx_frame.ID) {
     case 0x151:  //Message originating from BYD HVS compatible inverter. Reply with CAN identifier!
       inverterStartedUp = true;
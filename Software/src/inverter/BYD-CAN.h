@@ -2,13 +2,15 @@
 #define BYD_CAN_H
 
 #include "../datalayer/datalayer.h"
+#include "../devboard/utils/can_signal.h"
 #include "CanInverterProtocol.h"
 
 class BydCanInverter : public CanInverterProtocol {
  public:
   const char* name() override { return Name; }
   void transmit_can(unsigned long currentMillis);
-  void map_can_frame_to_variable(CAN_frame rx_frame);
+  void map_can_frame_to_variable(const CAN_frame& rx_frame);
+  CanIdFilter can_id_filter() { return {.min_id = 0x091, .max_id = 0x151}; }
   void update_values();
   bool provides_shunt() { return true; }
   void enable_shunt();
@@ -25,6 +27,23 @@ class BydCanInverter : public CanInverterProtocol {
   static const int FW_MINOR_VERSION = 0x29;
   static const int VOLTAGE_OFFSET_DV = 20;
 
+  // Target charge/discharge voltage, max discharge/charge current
+  using Byd110 = CanMessage<CanFieldBE<0>, CanFieldBE<2>, CanFieldBE<4>, CanFieldBE<6>>;
+  // SOC, SOH, remaining and fully charged capacity (Ah)
+  using Byd150 = CanMessage<CanFieldBE<0>, CanFieldBE<2>, CanFieldBE<4>, CanFieldBE<6>>;
+  // Voltage, current, average temperature
+  using Byd1D0 = CanMessage<CanFieldBE<0>, CanFieldBE<2, 2, true>, CanFieldBE<4, 2, true>>;
+  // Max/min temperature
+  using Byd210 = CanMessage<CanFieldBE<0, 2, true>, CanFieldBE<2, 2, true>>;
+  // Capacity (0.1 kWh)
+  using Byd250 = CanMessage<CanFieldBE<4, 2, false, 100>>;
+
+  CanFrameEncoder<Byd110> byd_110_encoder;
+  CanFrameEncoder<Byd150> byd_150_encoder;
+  CanFrameEncoder<Byd1D0> byd_1d0_encoder;
+  CanFrameEncoder<Byd210> byd_210_encoder;
+  CanFrameEncoder<Byd250> byd_250_encoder;
+
   CAN_frame BYD_250 = {.FD = false,
                        .ext_ID = false,
                        .DLC = 8,
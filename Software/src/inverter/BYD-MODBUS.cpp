@@ -1,11 +1,19 @@
 #include "BYD-MODBUS.h"
 #include "../battery/BATTERIES.h"
 #include "../datalayer/datalayer.h"
+#include "../datalayer/pack_array.h"
 #include "../devboard/hal/hal.h"
 #include "../devboard/utils/events.h"
 
 // For modbus register definitions, see https://gitlab.com/pelle8/inverter_resources/-/blob/main/byd_registers_modbus_rtu.md
 
+BydModbusInverter::BydModbusInverter() : ModbusInverterProtocol(21) {
+  mbPV.add_window(100, 68);   // Static data, see handle_static_data
+  mbPV.add_window(200, 13);   // Capacity and voltage limits
+  mbPV.add_window(300, 24);   // Battery status
+  mbPV.add_window(400, 100);  // Written by the inverter, 401 is checked in verify_inverter_modbus
+}
+
 void BydModbusInverter::update_values() {
   verify_temperature();
   verify_inverter_modbus();
@@ -46,12 +54,7 @@ void BydModbusInverter::handle_static_data() {
 }
 
 void BydModbusInverter::handle_update_data_modbusp201_byd() {
-  if (battery2) {
-    mbPV[202] = std::min(datalayer.battery.info.total_capacity_Wh + datalayer.battery2.info.total_capacity_Wh,
-                         static_cast<uint32_t>(60000u));  //Cap to 60kWh
-  } else {
-    mbPV[202] = std::min(datalayer.battery.info.total_capacity_Wh, static_cast<uint32_t>(60000u));  //Cap to 60kWh
-  }
+  mbPV[202] = std::min(battery_packs.totals().total_capacity_Wh, static_cast<uint32_t>(60000u));  //Cap to 60kWh
   mbPV[205] = (datalayer.battery.info.max_design_voltage_dV);  // Max Voltage, if higher Gen24 forces discharge
   mbPV[206] = (datalayer.battery.info.min_design_voltage_dV);  // Min Voltage, if lower Gen24 disables battery
 }
@@ -67,14 +70,14 @@ void BydModbusInverter::handle_update_data_modbusp301_byd() {
   // Convert max discharge Amp value to max Watt
   user_configured_max_discharge_W =
       ((datalayer.battery.settings.max_user_set_discharge_dA * datalayer.battery.info.max_design_voltage_dV) / 100);
-  // Use the smaller value, battery reported value OR user configured value
-  max_discharge_W = std::min(datalayer.battery.status.max_discharge_power_W, user_configured_max_discharge_W);
+  // Use the smaller value, battery reported value OR user configured value. With several batteries, all of them.
+  max_discharge_W = std::min(battery_packs.totals().max_discharge_power_W, user_configured_max_discharge_W);
 
   // Convert max charge Amp value to max Watt
   user_configured_max_charge_W =
       ((datalayer.battery.settings.max_user_set_charge_dA * datalayer.battery.info.max_design_voltage_dV) / 100);
   // Use the smaller value, battery reported value OR user configured value
-  max_charge_W = std::min(datalayer.battery.status.max_charge_power_W, user_configured_max_charge_W);
+  max_charge_W = std::min(battery_packs.totals().max_charge_power_W, user_configured_max_charge_W);
 
   if (datalayer.battery.status.bms_status == ACTIVE) {
     mbPV[308] = datalayer.battery.status.voltage_dV;
@@ -88,20 +91,10 @@ void BydModbusInverter::handle_update_data_modbusp301_byd() {
   } else {
     mbPV[303] = datalayer.battery.status.reported_soc;
   }
-  if (battery2) {
-    mbPV[304] = std::min(datalayer.battery.info.total_capacity_Wh + datalayer.battery2.info.total_capacity_Wh,
-                         static_cast<uint32_t>(60000u));  //Cap to 60kWh
-  } else {
-    mbPV[304] = std::min(datalayer.battery.info.total_capacity_Wh, static_cast<uint32_t>(60000u));  //Cap to 60kWh
-  }
-  if (battery2) {
-    mbPV[305] = std::min(datalayer.battery.status.reported_remaining_capacity_Wh +
-                             datalayer.battery2.status.reported_remaining_capacity_Wh,
-                         static_cast<uint32_t>(60000u));  //Cap to 60kWh
-  } else {
-    mbPV[305] = std::min(datalayer.battery.status.reported_remaining_capacity_Wh,
-                         static_cast<uint32_t>(60000u));  //Cap to 60kWh
-  }
+  mbPV[304] = std::min(battery_packs.totals().total_capacity_Wh, static_cast<uint32_t>(60000u));  //Cap to 60kWh
+  // With several batteries the main battery already reports the remaining capacity of all of them
+  mbPV[305] = std::min(datalayer.battery.status.reported_remaining_capacity_Wh,
+                       static_cast<uint32_t>(60000u));  //Cap to 60kWh
   mbPV[306] = std::min(max_discharge_W, static_cast<uint32_t>(30000u));  //Cap to 30000 if exceeding
   mbPV[307] = std::min(max_charge_W, static_cast<uint32_t>(30000u));     //Cap to 30000 if exceeding
   mbPV[310] = datalayer.battery.status.voltage_dV;
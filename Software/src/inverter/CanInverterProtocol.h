@@ -15,7 +15,7 @@ class CanInverterProtocol : public InverterProtocol, Transmitter, CanReceiver {
   InverterInterfaceType interface_type() { return InverterInterfaceType::Can; }
 
   virtual void transmit_can(unsigned long currentMillis) = 0;
-  virtual void map_can_frame_to_variable(CAN_frame rx_frame) = 0;
+  virtual void map_can_frame_to_variable(const CAN_frame& rx_frame) = 0;
 
   void transmit(unsigned long currentMillis) {
     if (allowed_to_send_CAN) {
@@ -23,15 +23,15 @@ class CanInverterProtocol : public InverterProtocol, Transmitter, CanReceiver {
     }
   }
 
-  void receive_can_frame(CAN_frame* frame) { map_can_frame_to_variable(*frame); }
+  void receive_can_frame(const CAN_frame& frame) { map_can_frame_to_variable(frame); }
 
  protected:
   CAN_Interface can_interface;
 
   explicit CanInverterProtocol(CAN_Speed speed = CAN_Speed::CAN_SPEED_500KBPS) {
     can_interface = can_config.inverter;
-    register_transmitter(this);
-    register_can_receiver(this, can_interface, speed);
+    register_transmitter(this, "inverter");
+    register_can_receiver(this, can_interface, "inverter", speed);
     logging.print("Requesting ");
     logging.print((uint32_t)speed);
     logging.print(" kbps for inverter CAN interface (");
@@ -39,7 +39,7 @@ class CanInverterProtocol : public InverterProtocol, Transmitter, CanReceiver {
     logging.println(")");
   }
 
-  void transmit_can_frame(CAN_frame* frame) { transmit_can_frame_to_interface(frame, can_interface); }
+  void transmit_can_frame(CAN_frame* frame) { queue_can_frame(frame, can_interface); }
 };
 
 #endif
@@ -518,7 +518,7 @@ void FoxessCanInverter::transmit_can(unsigned long currentMillis) {
   }
 }
 
-void FoxessCanInverter::map_can_frame_to_variable(CAN_frame rx_frame) {
+void FoxessCanInverter::map_can_frame_to_variable(const CAN_frame& rx_frame) {
 
   if (rx_frame.ID == 0x1871) {
     datalayer.system.status.CAN_inverter_still_alive = CAN_STILL_ALIVE;
@@ -96,7 +96,7 @@ void GrowattWitInverter::update_values() {
   GROWATT_1AC7XXXX.data.u8[5] = ((datalayer.battery.status.current_dA + 1000) & 0x00FF);
 }
 
-void GrowattWitInverter::map_can_frame_to_variable(CAN_frame rx_frame) {
+void GrowattWitInverter::map_can_frame_to_variable(const CAN_frame& rx_frame) {
 
   uint32_t first4bytes = ((rx_frame.ID & 0xFFFF0000) >> 4);
   //1AB5XXXX becomes 1AB5. Most likely not needed if all PCS messages come from XXXXDFF1
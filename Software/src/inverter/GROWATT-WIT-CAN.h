@@ -8,7 +8,7 @@ class GrowattWitInverter : public CanInverterProtocol {
   const char* name() override { return Name; }
   void update_values();
   void transmit_can(unsigned long currentMillis);
-  void map_can_frame_to_variable(CAN_frame rx_frame);
+  void map_can_frame_to_variable(const CAN_frame& rx_frame);
   static constexpr const char* Name = "Growatt WIT compatible battery via CAN";
 
  private:
@@ -199,7 +199,7 @@ void KostalInverterProtocol::update_values() {
   }
 }
 
-void KostalInverterProtocol::receive()  // Runs as fast as possible to handle the serial stream
+void KostalInverterProtocol::receive()  // Runs every core loop pass to handle the timers
 {
   currentMillis = millis();
 
@@ -216,97 +216,90 @@ void KostalInverterProtocol::receive()  // Runs as fast as possible to handle th
     dbg_message("RX_allow -> true");
     RX_allow = true;
   }
+}
 
-  if (Serial2.available()) {
-    RS485_RXFRAME[rx_index] = Serial2.read();
-    if (RX_allow) {
-      rx_index++;
-      if (RS485_RXFRAME[rx_index - 1] == 0x00) {
-        if ((rx_index > 9) && register_content_ok) {
-          dbg_frame(RS485_RXFRAME, 10, "RX");
-          if (check_kostal_frame_crc(rx_index)) {
-            incoming_message_counter = RS485_HEALTHY;
-
-            if (RS485_RXFRAME[1] == 'c' && info_sent) {
-              if (RS485_RXFRAME[6] == 0x47) {
-                // Set time function - Do nothing.
-                send_kostal(ACK_FRAME, 8);  // ACK
-              }
-              if (RS485_RXFRAME[6] == 0x5E) {
-                // Set State function
-                if (RS485_RXFRAME[7] == 0x00) {
-                  // Allow contactor closing
-                  setInverterAllowsContactorClosing(true);
-                  dbg_message("inverter_allows_contactor_closing -> true (5E 02)");
-                  send_kostal(ACK_FRAME, 8);  // ACK
-                } else if (RS485_RXFRAME[7] == 0x04) {
-                  // contactor test STATE, ACK sent
-                  setInverterAllowsContactorClosing(false);
-                  dbg_message("inverter_allows_contactor_closing -> false (Contactor test start)");
-                  send_kostal(ACK_FRAME, 8);  // ACK
-                  contactortestTimerStart = currentMillis;
-                  contactortestTimerActive = true;
-                } else if (RS485_RXFRAME[7] == 0xFF) {
-                  // no ACK sent
-                } else {
-                  // Battery deep sleep?
-                  send_kostal(ACK_FRAME, 8);  // ACK
-                }
-              }
-            } else if (RS485_RXFRAME[1] == 'b') {
-              if (RS485_RXFRAME[6] == 0x50) {
-                //Reverse polarity, do nothing
-              } else {
-                int code = RS485_RXFRAME[6] + RS485_RXFRAME[7] * 0x100;
-                if (code == 0x44a && info_sent) {
-                  //Send cyclic data
-                  // TODO: Probably not a good idea to use the battery object here like this.
-                  if (battery) {
-                    battery->update_values();
-                  }
-                  update_values();
-                  if (f2_startup_count < 15) {
-                    f2_startup_count++;
-                  }
-                  uint8_t tmpframe[64];  //copy values to prevent data manipulation during rewrite/crc calculation
-                  memcpy(tmpframe, CYCLIC_DATA, 64);
-                  tmpframe[62] = calculate_kostal_crc(tmpframe, 62);
-                  null_stuffer(tmpframe, 64);
-                  send_kostal(tmpframe, 64);
-                  CYCLIC_DATA[61] = 0x00;
-                }
-                if (code == 0x84a) {
-                  //Send  battery info
-                  uint8_t tmpframe[40];  //copy values to prevent data manipulation during rewrite/crc calculation
-                  memcpy(tmpframe, BATTERY_INFO, 40);
-                  tmpframe[38] = calculate_kostal_crc(tmpframe, 38);
-                  null_stuffer(tmpframe, 40);
-                  send_kostal(tmpframe, 40);
-                  setInverterAllowsContactorClosing(false);
-                  dbg_message("inverter_allows_contactor_closing -> false (battery info sent)");
-                  info_sent = true;
-                  if (!startupMillis) {
-                    startupMillis = currentMillis;
-                  }
-                }
-                if (code == 0x353 && info_sent) {
-                  //Send  battery error/status
-                  uint8_t tmpframe[9];  //copy values to prevent data manipulation during rewrite/crc calculation
-                  memcpy(tmpframe, STATUS_FRAME, 9);
-                  tmpframe[7] = calculate_kostal_crc(tmpframe, 7);
-                  null_stuffer(tmpframe, 9);
-                  send_kostal(tmpframe, 9);
-                }
-              }
-            }
-          }
-          rx_index = 0;
-        }
-        rx_index = 0;
+void KostalInverterProtocol::receive_frame(const uint8_t* frame, size_t length) {
+  // Frames end with the zero byte of the byte stuffing, the first 10 bytes hold the header and the request
+  if (!RX_allow || length <= 9 || length > sizeof(RS485_RXFRAME) || !register_content_ok) {
+    return;
+  }
+  memcpy(RS485_RXFRAME, frame, length);
+  dbg_frame(RS485_RXFRAME, 10, "RX");
+  if (!check_kostal_frame_crc(length)) {
+    return;
+  }
+  incoming_message_counter = RS485_HEALTHY;
+
+  if (RS485_RXFRAME[1] == 'c' && info_sent) {
+    if (RS485_RXFRAME[6] == 0x47) {
+      // Set time function - Do nothing.
+      send_kostal(ACK_FRAME, 8);  // ACK
+    }
+    if (RS485_RXFRAME[6] == 0x5E) {
+      // Set State function
+      if (RS485_RXFRAME[7] == 0x00) {
+        // Allow contactor closing
+        setInverterAllowsContactorClosing(true);
+        dbg_message("inverter_allows_contactor_closing -> true (5E 02)");
+        send_kostal(ACK_FRAME, 8);  // ACK
+      } else if (RS485_RXFRAME[7] == 0x04) {
+        // contactor test STATE, ACK sent
+        setInverterAllowsContactorClosing(false);
+        dbg_message("inverter_allows_contactor_closing -> false (Contactor test start)");
+        send_kostal(ACK_FRAME, 8);  // ACK
+        contactortestTimerStart = currentMillis;
+        contactortestTimerActive = true;
+      } else if (RS485_RXFRAME[7] == 0xFF) {
+        // no ACK sent
+      } else {
+        // Battery deep sleep?
+        send_kostal(ACK_FRAME, 8);  // ACK
       }
     }
-    if (rx_index >= 299) {
-      rx_index = 0;
+  } else if (RS485_RXFRAME[1] == 'b') {
+    if (RS485_RXFRAME[6] == 0x50) {
+      //Reverse polarity, do nothing
+    } else {
+      int code = RS485_RXFRAME[6] + RS485_RXFRAME[7] * 0x100;
+      if (code == 0x44a && info_sent) {
+        //Send cyclic data
+        // TODO: Probably not a good idea to use the battery object here like this.
+        if (battery) {
+          battery->update_values();
+        }
+        update_values();
+        if (f2_startup_count < 15) {
+          f2_startup_count++;
+        }
+        uint8_t tmpframe[64];  //copy values to prevent data manipulation during rewrite/crc calculation
+        memcpy(tmpframe, CYCLIC_DATA, 64);
+        tmpframe[62] = calculate_kostal_crc(tmpframe, 62);
+        null_stuffer(tmpframe, 64);
+        send_kostal(tmpframe, 64);
+        CYCLIC_DATA[61] = 0x00;
+      }
+      if (code == 0x84a) {
+        //Send  battery info
+        uint8_t tmpframe[40];  //copy values to prevent data manipulation during rewrite/crc calculation
+        memcpy(tmpframe, BATTERY_INFO, 40);
+        tmpframe[38] = calculate_kostal_crc(tmpframe, 38);
+        null_stuffer(tmpframe, 40);
+        send_kostal(tmpframe, 40);
+        setInverterAllowsContactorClosing(false);
+        dbg_message("inverter_allows_contactor_closing -> false (battery info sent)");
+        info_sent = true;
+        if (!startupMillis) {
+          startupMillis = currentMillis;
+        }
+      }
+      if (code == 0x353 && info_sent) {
+        //Send  battery error/status
+        uint8_t tmpframe[9];  //copy values to prevent data manipulation during rewrite/crc calculation
+        memcpy(tmpframe, STATUS_FRAME, 9);
+        tmpframe[7] = calculate_kostal_crc(tmpframe, 7);
+        null_stuffer(tmpframe, 9);
+        send_kostal(tmpframe, 9);
+      }
     }
   }
 }
@@ -324,5 +317,5 @@ bool KostalInverterProtocol::setup(void) {  // Performs one time setup at startu
 
   Serial2.begin(baud_rate(), SERIAL_8N1, rx_pin, tx_pin);
 
-  return true;
+  return init_rs485_framing(Serial2, Rs485FrameFormat::delimited(0x00, sizeof(RS485_RXFRAME)));
 }
@@ -8,6 +8,7 @@ class KostalInverterProtocol : public Rs485InverterProtocol {
   const char* name() override { return Name; }
   bool setup() override;
   void receive();
+  void receive_frame(const uint8_t* frame, size_t length);
   void update_values();
   static constexpr const char* Name = "BYD battery via Kostal RS485";
 
@@ -33,7 +34,6 @@ class KostalInverterProtocol : public Rs485InverterProtocol {
   unsigned long contactortestTimerStart = 0;
   bool contactortestTimerActive = false;
 
-  uint16_t rx_index = 0;
   bool RX_allow = false;
 
   union f32b {
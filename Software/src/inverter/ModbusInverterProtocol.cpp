@@ -2,6 +2,9 @@
 #include "../devboard/utils/logging.h"
 #include "../lib/eModbus-eModbus/ModbusServerRTU.h"
 
+// Most registers a single read request can return
+#define MODBUS_MAX_READ_WORDS 125
+
 // Creates a ModbusRTU server instance with 2000ms timeout
 ModbusInverterProtocol::ModbusInverterProtocol(int serverId) : MBserver(2000) {
   _serverId = serverId;
@@ -23,6 +26,24 @@ ModbusInverterProtocol::~ModbusInverterProtocol() {
   MBserver.unregisterWorker(_serverId, R_W_MULT_REGISTERS);
 }
 
+// Append registers to a response, MSB first as on the wire
+static void add_registers(ModbusMessage& response, const uint16_t* registers, uint16_t words) {
+  uint8_t bytes[MODBUS_MAX_READ_WORDS * 2];
+  for (uint16_t i = 0; i < words; ++i) {
+    bytes[i * 2] = registers[i] >> 8;
+    bytes[i * 2 + 1] = registers[i] & 0xFF;
+  }
+  response.add(bytes, words * 2);
+}
+
+// Copy the register values of a write request, starting at byte index, into registers
+static void get_registers(ModbusMessage& request, uint16_t index, uint16_t* registers, uint16_t words) {
+  const uint8_t* bytes = request.data() + index;
+  for (uint16_t i = 0; i < words; ++i) {
+    registers[i] = (bytes[i * 2] << 8) | bytes[i * 2 + 1];
+  }
+}
+
 // Server function to handle FC 0x03
 ModbusMessage ModbusInverterProtocol::FC03(ModbusMessage request) {
   ModbusMessage response;  // The Modbus message we are going to give back
@@ -31,9 +52,16 @@ ModbusMessage ModbusInverterProtocol::FC03(ModbusMessage request) {
   request.get(2, addr);    // read address from request
   request.get(4, words);   // read # of words from request
 
-  // Address overflow?
-  if ((addr + words) > MBPV_MAX) {
-    // Yes - send respective error response
+  // # of registers proper?
+  if (words == 0 || words > MODBUS_MAX_READ_WORDS) {
+    response.setError(request.getServerID(), request.getFunctionCode(), ILLEGAL_DATA_VALUE);
+    logging.printf("Modbus FC03 error: bad registers addr=%d words=%d\n", addr, words);
+    return response;
+  }
+  // Registers mapped?
+  const uint16_t* registers = mbPV.find(addr, words);
+  if (registers == nullptr) {
+    // No - send respective error response
     response.setError(request.getServerID(), request.getFunctionCode(), ILLEGAL_DATA_ADDRESS);
     logging.printf("Modbus FC03 error: illegal request addr=%d words=%d\n", addr, words);
     return response;
@@ -41,10 +69,7 @@ ModbusMessage ModbusInverterProtocol::FC03(ModbusMessage request) {
 
   // Set up response
   response.add(request.getServerID(), request.getFunctionCode(), (uint8_t)(words * 2));
-  for (uint8_t i = 0; i < words; ++i) {
-    // send increasing data values
-    response.add((uint16_t)(mbPV[addr + i]));
-  }
+  add_registers(response, registers, words);
 
   return response;
 }
@@ -57,19 +82,20 @@ ModbusMessage ModbusInverterProtocol::FC06(ModbusMessage request) {
   request.get(2, addr);    // read address from request
   request.get(4, val);     // read # of words from request
 
-  // Address overflow?
-  if ((addr) > MBPV_MAX) {
-    // Yes - send respective error response
+  // Register mapped?
+  uint16_t* reg = mbPV.find(addr, 1);
+  if (reg == nullptr) {
+    // No - send respective error response
     response.setError(request.getServerID(), request.getFunctionCode(), ILLEGAL_DATA_ADDRESS);
     logging.printf("Modbus FC06 error: illegal request addr=%d val=%d\n", addr, val);
     return response;
   }
 
   // Do the write
-  mbPV[addr] = val;
+  *reg = val;
 
   // Set up response
-  response.add(request.getServerID(), request.getFunctionCode(), mbPV[addr]);
+  response.add(request.getServerID(), request.getFunctionCode(), *reg);
   return response;
 }
 
@@ -79,32 +105,30 @@ ModbusMessage ModbusInverterProtocol::FC16(ModbusMessage request) {
   uint16_t addr = 0;       // Start address
   uint16_t words = 0;      // total words to write
   uint8_t bytes = 0;       // # of data bytes in request
-  uint16_t val = 0;        // value to be written
   request.get(2, addr);    // read address from request
   request.get(4, words);   // read # of words from request
   request.get(6, bytes);   // read # of data bytes from request (seems redundant with # of words)
 
   // # of registers proper?
-  if ((bytes != (words * 2))  // byte count in request must match # of words in request
-      || (words > 123))       // can't support more than this in request packet
-  {                           // Yes - send respective error response
+  if ((bytes != (words * 2))            // byte count in request must match # of words in request
+      || (words > 123)                  // can't support more than this in request packet
+      || (request.size() < 7 + bytes))  // data must be complete
+  {                                     // Yes - send respective error response
     response.setError(request.getServerID(), request.getFunctionCode(), ILLEGAL_DATA_VALUE);
     logging.printf("Modbus FC16 error: bad registers addr=%d words=%d bytes=%d\n", addr, words, bytes);
     return response;
   }
-  // Address overflow?
-  if ((addr + words) > MBPV_MAX) {
-    // Yes - send respective error response
+  // Registers mapped?
+  uint16_t* registers = mbPV.find(addr, words);
+  if (registers == nullptr) {
+    // No - send respective error response
     response.setError(request.getServerID(), request.getFunctionCode(), ILLEGAL_DATA_ADDRESS);
     logging.printf("Modbus FC16 error: overflow addr=%d words=%d\n", addr, words);
     return response;
   }
 
-  // Do the writes
-  for (uint8_t i = 0; i < words; ++i) {
-    request.get(7 + (i * 2), val);  //data starts at byte 6 in request packet
-    mbPV[addr + i] = val;
-  }
+  // Do the writes, data starts at byte 7 in request packet
+  get_registers(request, 7, registers, words);
 
   // Set up response
   response.add(request.getServerID(), request.getFunctionCode(), addr, words);
@@ -119,7 +143,6 @@ ModbusMessage ModbusInverterProtocol::FC23(ModbusMessage request) {
   uint16_t write_addr = 0;       // Start address for write
   uint16_t write_words = 0;      // total words to write
   uint8_t write_bytes = 0;       // # of data bytes in write request
-  uint16_t write_val = 0;        // value to be written
   request.get(2, read_addr);     // read address from request
   request.get(4, read_words);    // read # of words from request
   request.get(6, write_addr);    // read address from request
@@ -128,18 +151,21 @@ ModbusMessage ModbusInverterProtocol::FC23(ModbusMessage request) {
 
   // ERROR CHECKS
   // # of registers proper?
-  if ((write_bytes != (write_words * 2))  // byte count in request must match # of words in request
-      || (write_words > 121)              // can't fit more than this in the packet for FC23
-      || (read_words > 125))              // can't fit more than this in the response packet
-  {                                       // Yes - send respective error response
+  if ((write_bytes != (write_words * 2))       // byte count in request must match # of words in request
+      || (write_words > 121)                   // can't fit more than this in the packet for FC23
+      || (read_words > 125)                    // can't fit more than this in the response packet
+      || (request.size() < 11 + write_bytes))  // data must be complete
+  {                                            // Yes - send respective error response
     response.setError(request.getServerID(), request.getFunctionCode(), ILLEGAL_DATA_VALUE);
     logging.printf("Modbus FC23 error: bad registers write_addr=%d write_words=%d write_bytes=%d read_words=%d\n",
                    write_addr, write_words, write_bytes, read_words);
     return response;
   }
-  // Address overflow?
-  if (((write_addr + write_words) > MBPV_MAX) ||
-      ((read_addr + read_words) > MBPV_MAX)) {  // Yes - send respective error response
+  // Registers mapped?
+  uint16_t* write_registers = mbPV.find(write_addr, write_words);
+  const uint16_t* read_registers = mbPV.find(read_addr, read_words);
+  if ((write_words > 0 && write_registers == nullptr) ||
+      (read_words > 0 && read_registers == nullptr)) {  // No - send respective error response
     response.setError(request.getServerID(), request.getFunctionCode(), ILLEGAL_DATA_ADDRESS);
     logging.printf("Modbus FC23 error: overflow write_addr=%d write_words=%d read_addr=%d read_words=%d\n", write_addr,
                    write_words, read_addr, read_words);
@@ -147,18 +173,16 @@ ModbusMessage ModbusInverterProtocol::FC23(ModbusMessage request) {
   }
 
   //WRITE SECTION  - write is done before read for FC23
-  // Do the writes
-  for (uint8_t i = 0; i < write_words; ++i) {
-    request.get(11 + (i * 2), write_val);  //data starts at byte 6 in request packet
-    mbPV[write_addr + i] = write_val;
+  // Do the writes, data starts at byte 11 in request packet
+  if (write_words > 0) {
+    get_registers(request, 11, write_registers, write_words);
   }
 
   // READ SECTION
   // Set up response
   response.add(request.getServerID(), request.getFunctionCode(), (uint8_t)(read_words * 2));
-  for (uint8_t i = 0; i < read_words; ++i) {
-    // send increasing data values
-    response.add((uint16_t)(mbPV[read_addr + i]));
+  if (read_words > 0) {
+    add_registers(response, read_registers, read_words);
   }
 
   return response;
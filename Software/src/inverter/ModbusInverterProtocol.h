@@ -4,11 +4,11 @@
 #include "../lib/eModbus-eModbus/ModbusMessage.h"
 #include "../lib/eModbus-eModbus/ModbusServerRTU.h"
 #include "InverterProtocol.h"
+#include "ModbusRegisterBank.h"
 
 #include <HardwareSerial.h>
 
 #include <stdint.h>
-#include <map>
 
 // The abstract base class for all Modbus inverter protocols
 class ModbusInverterProtocol : public InverterProtocol {
@@ -24,12 +24,11 @@ class ModbusInverterProtocol : public InverterProtocol {
   ModbusMessage FC16(ModbusMessage request);
   ModbusMessage FC23(ModbusMessage request);
 
-  // The highest Modbus register we allow reads/writes from
-  static const int MBPV_MAX = 30000;
   // The Modbus server ID we respond to
   int _serverId;
-  // The Modbus registers themselves
-  std::map<uint16_t, uint16_t> mbPV;
+  // The Modbus registers themselves. Derived classes map the address windows the inverter uses in their
+  // constructor, requests for other addresses are answered with ILLEGAL_DATA_ADDRESS.
+  ModbusRegisterBank mbPV;
 
   ModbusServerRTU MBserver;
 };
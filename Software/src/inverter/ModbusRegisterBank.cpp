@@ -0,0 +1,35 @@
+#include "ModbusRegisterBank.h"
+
+bool ModbusRegisterBank::add_window(uint16_t first, uint16_t count) {
+  if (window_count == MODBUS_REGISTER_BANK_MAX_WINDOWS || count == 0 || count > MODBUS_REGISTER_BANK_SIZE - used ||
+      first + count > 0x10000) {
+    return false;
+  }
+  for (uint8_t i = 0; i < window_count; i++) {
+    if (first < windows[i].first + windows[i].count && windows[i].first < first + count) {
+      return false;  // Overlaps an existing window
+    }
+  }
+  windows[window_count++] = {first, count, used};
+  used += count;
+  return true;
+}
+
+uint16_t* ModbusRegisterBank::find(uint16_t addr, uint16_t count) {
+  for (uint8_t i = 0; i < window_count; i++) {
+    const Window& window = windows[i];
+    if (addr >= window.first && (uint32_t)addr + count <= (uint32_t)window.first + window.count) {
+      return &values[window.offset + (addr - window.first)];
+    }
+  }
+  return nullptr;
+}
+
+uint16_t& ModbusRegisterBank::operator[](uint16_t addr) {
+  uint16_t* reg = find(addr, 1);
+  if (reg == nullptr) {
+    unmapped = 0;
+    return unmapped;
+  }
+  return *reg;
+}
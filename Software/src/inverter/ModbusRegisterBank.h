@@ -0,0 +1,40 @@
+#ifndef MODBUS_REGISTER_BANK_H
+#define MODBUS_REGISTER_BANK_H
+
+#include <stdint.h>
+
+// Maximum number of address windows and registers in total a Modbus inverter can map
+#define MODBUS_REGISTER_BANK_MAX_WINDOWS 8
+#define MODBUS_REGISTER_BANK_SIZE 256
+
+// Holding registers of a Modbus server, stored as a few contiguous address windows in a fixed array.
+// Requests are served with one window lookup per request instead of one lookup per register, and addresses
+// outside the windows are rejected instead of being created on first access.
+class ModbusRegisterBank {
+ public:
+  // Map count registers starting at address first, initialized to 0. Windows must not overlap.
+  // Returns false if the window does not fit in the bank.
+  bool add_window(uint16_t first, uint16_t count);
+
+  // The registers [addr, addr + count) if they are all in the same window, nullptr otherwise
+  uint16_t* find(uint16_t addr, uint16_t count);
+
+  // Access to a single register for updating the values served to the inverter. Unmapped addresses read as 0
+  // and writes to them are discarded.
+  uint16_t& operator[](uint16_t addr);
+
+ private:
+  struct Window {
+    uint16_t first;
+    uint16_t count;
+    uint16_t offset;  // Index of the first register of the window in values
+  };
+
+  Window windows[MODBUS_REGISTER_BANK_MAX_WINDOWS];
+  uint8_t window_count = 0;
+  uint16_t used = 0;
+  uint16_t values[MODBUS_REGISTER_BANK_SIZE] = {0};
+  uint16_t unmapped = 0;
+};
+
+#endif
@@ -3,18 +3,26 @@
 #include "../datalayer/datalayer.h"
 #include "../inverter/INVERTERS.h"
 
-void swap_bytes(uint8_t* a, uint8_t* b) {
-  uint8_t temp = *a;
-  *a = *b;
-  *b = temp;
-}
-
-void apply_30koffset(uint8_t* msb, uint8_t* lsb) {
-  uint16_t original_value = (*msb << 8) | *lsb;
-  uint16_t offset_value = original_value + 30000;
-
-  *msb = (offset_value >> 8) & 0xFF;
-  *lsb = offset_value & 0xFF;
+template <CanByteOrder ORDER>
+void PylonInverter::encode_frames(int32_t current_offset) {
+  pylon_421_encoder.encode_as<Pylon421<ORDER>>(
+      PYLON_421X, datalayer.battery.status.voltage_dV, datalayer.battery.status.current_dA + current_offset,
+      // BMS Temperature (We dont have BMS temp, send max cell temperature instead)
+      datalayer.battery.status.temperature_max_dC, datalayer.battery.status.reported_soc,
+      datalayer.battery.status.soh_pptt);
+
+  pylon_422_encoder.encode_as<Pylon422<ORDER>>(PYLON_422X, charge_cutoff_voltage_dV, discharge_cutoff_voltage_dV,
+                                               datalayer.battery.status.max_charge_current_dA + current_offset,
+                                               datalayer.battery.status.max_discharge_current_dA + current_offset);
+
+  pylon_423_encoder.encode_as<Pylon423<ORDER>>(PYLON_423X, datalayer.battery.status.cell_max_voltage_mV,
+                                               datalayer.battery.status.cell_min_voltage_mV);
+
+  pylon_424_encoder.encode_as<PylonTemperatures<ORDER>>(PYLON_424X, datalayer.battery.status.temperature_max_dC,
+                                                        datalayer.battery.status.temperature_min_dC);
+
+  pylon_427_encoder.encode_as<PylonTemperatures<ORDER>>(PYLON_427X, datalayer.battery.status.temperature_max_dC,
+                                                        datalayer.battery.status.temperature_min_dC);
 }
 
 void PylonInverter::
@@ -50,74 +58,13 @@ void PylonInverter::
     PYLON_428X.data.u8[1] = 0xAA;  //Discharge forbidden
   }
 
-  //Voltage (370.0)
-  PYLON_421X.data.u8[0] = (datalayer.battery.status.voltage_dV >> 8);
-  PYLON_421X.data.u8[1] = (datalayer.battery.status.voltage_dV & 0x00FF);
-  //Current (15.0)
-  PYLON_421X.data.u8[2] = (datalayer.battery.status.current_dA >> 8);
-  PYLON_421X.data.u8[3] = (datalayer.battery.status.current_dA & 0x00FF);
-  // BMS Temperature (We dont have BMS temp, send max cell voltage instead)
-  PYLON_421X.data.u8[4] = ((datalayer.battery.status.temperature_max_dC + 1000) >> 8);
-  PYLON_421X.data.u8[5] = ((datalayer.battery.status.temperature_max_dC + 1000) & 0x00FF);
-  //SOC (100.00%)
-  PYLON_421X.data.u8[6] = (datalayer.battery.status.reported_soc / 100);  //Remove decimals
-  //StateOfHealth (100.00%)
-  PYLON_421X.data.u8[7] = (datalayer.battery.status.soh_pptt / 100);
-
-  //Maxvoltage (eg 400.0V = 4000 , 16bits long) Charge Cutoff Voltage
-  PYLON_422X.data.u8[0] = (charge_cutoff_voltage_dV >> 8);
-  PYLON_422X.data.u8[1] = (charge_cutoff_voltage_dV & 0x00FF);
-  //Minvoltage (eg 300.0V = 3000 , 16bits long) Discharge Cutoff Voltage
-  PYLON_422X.data.u8[2] = (discharge_cutoff_voltage_dV >> 8);
-  PYLON_422X.data.u8[3] = (discharge_cutoff_voltage_dV & 0x00FF);
-  //Max ChargeCurrent
-  PYLON_422X.data.u8[4] = (datalayer.battery.status.max_charge_current_dA >> 8);
-  PYLON_422X.data.u8[5] = (datalayer.battery.status.max_charge_current_dA & 0x00FF);
-  //Max DishargeCurrent
-  PYLON_422X.data.u8[6] = (datalayer.battery.status.max_discharge_current_dA >> 8);
-  PYLON_422X.data.u8[7] = (datalayer.battery.status.max_discharge_current_dA & 0x00FF);
-
-  //Max cell voltage
-  PYLON_423X.data.u8[0] = (datalayer.battery.status.cell_max_voltage_mV >> 8);
-  PYLON_423X.data.u8[1] = (datalayer.battery.status.cell_max_voltage_mV & 0x00FF);
-  //Min cell voltage
-  PYLON_423X.data.u8[2] = (datalayer.battery.status.cell_min_voltage_mV >> 8);
-  PYLON_423X.data.u8[3] = (datalayer.battery.status.cell_min_voltage_mV & 0x00FF);
-
-  //Max temperature per cell
-  PYLON_424X.data.u8[0] = (datalayer.battery.status.temperature_max_dC >> 8);
-  PYLON_424X.data.u8[1] = (datalayer.battery.status.temperature_max_dC & 0x00FF);
-  //Min temperature per cell
-  PYLON_424X.data.u8[2] = (datalayer.battery.status.temperature_min_dC >> 8);
-  PYLON_424X.data.u8[3] = (datalayer.battery.status.temperature_min_dC & 0x00FF);
-
-  //Max temperature per module
-  PYLON_427X.data.u8[0] = (datalayer.battery.status.temperature_max_dC >> 8);
-  PYLON_427X.data.u8[1] = (datalayer.battery.status.temperature_max_dC & 0x00FF);
-  //Min temperature per module
-  PYLON_427X.data.u8[2] = (datalayer.battery.status.temperature_min_dC >> 8);
-  PYLON_427X.data.u8[3] = (datalayer.battery.status.temperature_min_dC & 0x00FF);
-
-  if (user_selected_pylon_30koffset) {
-    apply_30koffset(&PYLON_421X.data.u8[2], &PYLON_421X.data.u8[3]);  // Current (15.0)
-    apply_30koffset(&PYLON_422X.data.u8[4], &PYLON_422X.data.u8[5]);  // Max ChargeCurrent
-    apply_30koffset(&PYLON_422X.data.u8[6], &PYLON_422X.data.u8[7]);  // Max DishargeCurrent
-  }
+  // Some inverters expect the currents offset by 3000.0 A
+  const int32_t current_offset = user_selected_pylon_30koffset ? 30000 : 0;
 
   if (user_selected_pylon_invert_byteorder) {
-    swap_bytes(&PYLON_421X.data.u8[0], &PYLON_421X.data.u8[1]);  // Voltage (370.0)
-    swap_bytes(&PYLON_421X.data.u8[2], &PYLON_421X.data.u8[3]);  // Current (15.0)
-    swap_bytes(&PYLON_421X.data.u8[4], &PYLON_421X.data.u8[5]);  // BMS Temperature
-    swap_bytes(&PYLON_422X.data.u8[0], &PYLON_422X.data.u8[1]);  // Maxvoltage
-    swap_bytes(&PYLON_422X.data.u8[2], &PYLON_422X.data.u8[3]);  // Minvoltage
-    swap_bytes(&PYLON_422X.data.u8[4], &PYLON_422X.data.u8[5]);  // Max ChargeCurrent
-    swap_bytes(&PYLON_422X.data.u8[6], &PYLON_422X.data.u8[7]);  // Max DishargeCurrent
-    swap_bytes(&PYLON_423X.data.u8[0], &PYLON_423X.data.u8[1]);  // Max cell voltage
-    swap_bytes(&PYLON_423X.data.u8[2], &PYLON_423X.data.u8[3]);  // Min cell voltage
-    swap_bytes(&PYLON_424X.data.u8[0], &PYLON_424X.data.u8[1]);  // Max temperature per cell
-    swap_bytes(&PYLON_424X.data.u8[2], &PYLON_424X.data.u8[3]);  // Min temperature per cell
-    swap_bytes(&PYLON_427X.data.u8[0], &PYLON_427X.data.u8[1]);  // Max temperature per module
-    swap_bytes(&PYLON_427X.data.u8[2], &PYLON_427X.data.u8[3]);  // Min temperature per module
+    encode_frames<CanByteOrder::LittleEndian>(current_offset);
+  } else {
+    encode_frames<CanByteOrder::BigEndian>(current_offset);
   }
 
   // Status=Bit 0,1,2= 0:Sleep, 1:Charge, 2:Discharge 3:Idle. Bit3 ForceChargeReq. Bit4 Balance charge Request
@@ -132,7 +79,7 @@ void PylonInverter::
   }
 }
 
-void PylonInverter::map_can_frame_to_variable(CAN_frame rx_frame) {
+void PylonInverter::map_can_frame_to_variable(const CAN_frame& rx_frame) {
   switch (rx_frame.ID) {
     case 0x4200:  //Message originating from inverter. Depending on which data is required, act accordingly
       datalayer.system.status.CAN_inverter_still_alive = CAN_STILL_ALIVE;
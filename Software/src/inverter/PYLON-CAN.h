@@ -1,6 +1,7 @@
 #ifndef PYLON_CAN_H
 #define PYLON_CAN_H
 
+#include "../devboard/utils/can_signal.h"
 #include "CanInverterProtocol.h"
 
 class PylonInverter : public CanInverterProtocol {
@@ -9,12 +10,15 @@ class PylonInverter : public CanInverterProtocol {
   bool setup() override;
   void update_values();
   void transmit_can(unsigned long currentMillis);
-  void map_can_frame_to_variable(CAN_frame rx_frame);
+  void map_can_frame_to_variable(const CAN_frame& rx_frame);
+  CanIdFilter can_id_filter() { return {.min_id = 0x4200, .max_id = 0x4200}; }
   static constexpr const char* Name = "Pylontech HV battery over CAN bus";
 
  private:
   void send_system_data();
   void send_setup_info();
+  template <CanByteOrder ORDER>
+  void encode_frames(int32_t current_offset);
 
   /* Some inverters need to see a specific amount of cells/modules to emulate a specific Pylon battery.
      Change the following only if your inverter is generating fault codes about voltage range, in the Settings */
@@ -87,6 +91,29 @@ class PylonInverter : public CanInverterProtocol {
   uint16_t discharge_cutoff_voltage_dV = 0;
   uint16_t charge_cutoff_voltage_dV = 0;
 
+  /* The fields are big endian, unless the user selected the inverted byte order */
+  // Voltage, current, BMS temperature (offset by 100.0 C), SOC and SOH (whole percent)
+  template <CanByteOrder ORDER>
+  using Pylon421 =
+      CanMessage<CanField<0, 2, ORDER>, CanField<2, 2, ORDER, true>, CanField<4, 2, ORDER, true, 1, 1, -1000>,
+                 CanField<6, 1, ORDER, false, 100>, CanField<7, 1, ORDER, false, 100>>;
+  // Charge/discharge cutoff voltage, max charge/discharge current
+  template <CanByteOrder ORDER>
+  using Pylon422 =
+      CanMessage<CanField<0, 2, ORDER>, CanField<2, 2, ORDER>, CanField<4, 2, ORDER>, CanField<6, 2, ORDER>>;
+  // Max/min cell voltage
+  template <CanByteOrder ORDER>
+  using Pylon423 = CanMessage<CanField<0, 2, ORDER>, CanField<2, 2, ORDER>>;
+  // Max/min temperature, per cell (0x424X) and per module (0x427X)
+  template <CanByteOrder ORDER>
+  using PylonTemperatures = CanMessage<CanField<0, 2, ORDER, true>, CanField<2, 2, ORDER, true>>;
+
+  CanFrameEncoder<Pylon421<CanByteOrder::BigEndian>> pylon_421_encoder;
+  CanFrameEncoder<Pylon422<CanByteOrder::BigEndian>> pylon_422_encoder;
+  CanFrameEncoder<Pylon423<CanByteOrder::BigEndian>> pylon_423_encoder;
+  CanFrameEncoder<PylonTemperatures<CanByteOrder::BigEndian>> pylon_424_encoder;
+  CanFrameEncoder<PylonTemperatures<CanByteOrder::BigEndian>> pylon_427_encoder;
+
   static const int VOLTAGE_OFFSET_DV = 20;  // Small offset voltage to avoid generating voltage events
 };
 
@@ -96,7 +96,7 @@ void PylonLvInverter::update_values() {
   // PYLON_35E is pre-filled with the manufacturer name
 }
 
-void PylonLvInverter::map_can_frame_to_variable(CAN_frame rx_frame) {
+void PylonLvInverter::map_can_frame_to_variable(const CAN_frame& rx_frame) {
   switch (rx_frame.ID) {
     case 0x305:  //Message originating from inverter.
       // according to the spec, this message includes only 0-bytes
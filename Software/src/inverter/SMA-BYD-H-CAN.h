@@ -9,7 +9,7 @@ class SmaBydHInverter : public SmaInverterBase {
   const char* name() override { return Name; }
   void update_values();
   void transmit_can(unsigned long currentMillis);
-  void map_can_frame_to_variable(CAN_frame rx_frame);
+  void map_can_frame_to_variable(const CAN_frame& rx_frame);
   static constexpr const char* Name = "SMA compatible BYD H";
 
   virtual bool controls_contactor() { return true; }
@@ -24,69 +24,24 @@ void SmaTripowerInverter::
   }
 
   //Map values to CAN messages
+  sma_358_encoder.encode(SMA_358, datalayer.battery.info.max_design_voltage_dV,
+                         datalayer.battery.info.min_design_voltage_dV,
+                         datalayer.battery.status.max_discharge_current_dA,
+                         datalayer.battery.status.max_charge_current_dA);
 
-  //Maxvoltage (eg 400.0V = 4000 , 16bits long)
-  SMA_358.data.u8[0] = (datalayer.battery.info.max_design_voltage_dV >> 8);
-  SMA_358.data.u8[1] = (datalayer.battery.info.max_design_voltage_dV & 0x00FF);
-  //Minvoltage (eg 300.0V = 3000 , 16bits long)
-  SMA_358.data.u8[2] = (datalayer.battery.info.min_design_voltage_dV >> 8);
-  SMA_358.data.u8[3] = (datalayer.battery.info.min_design_voltage_dV & 0x00FF);
-  //Discharge limited current, 500 = 50A, (0.1, A)
-  SMA_358.data.u8[4] = (datalayer.battery.status.max_discharge_current_dA >> 8);
-  SMA_358.data.u8[5] = (datalayer.battery.status.max_discharge_current_dA & 0x00FF);
-  //Charge limited current, 125 =12.5A (0.1, A)
-  SMA_358.data.u8[6] = (datalayer.battery.status.max_charge_current_dA >> 8);
-  SMA_358.data.u8[7] = (datalayer.battery.status.max_charge_current_dA & 0x00FF);
-
-  //SOC (100.00%)
-  SMA_3D8.data.u8[0] = (datalayer.battery.status.reported_soc >> 8);
-  SMA_3D8.data.u8[1] = (datalayer.battery.status.reported_soc & 0x00FF);
-  //StateOfHealth (100.00%)
-  SMA_3D8.data.u8[2] = (datalayer.battery.status.soh_pptt >> 8);
-  SMA_3D8.data.u8[3] = (datalayer.battery.status.soh_pptt & 0x00FF);
-  //State of charge (AH, 0.1)
-  SMA_3D8.data.u8[4] = (ampere_hours_remaining >> 8);
-  SMA_3D8.data.u8[5] = (ampere_hours_remaining & 0x00FF);
-
-  //Voltage (370.0)
-  SMA_4D8.data.u8[0] = (datalayer.battery.status.voltage_dV >> 8);
-  SMA_4D8.data.u8[1] = (datalayer.battery.status.voltage_dV & 0x00FF);
-  //Current (TODO: signed OK?)
-  SMA_4D8.data.u8[2] = (datalayer.battery.status.current_dA >> 8);
-  SMA_4D8.data.u8[3] = (datalayer.battery.status.current_dA & 0x00FF);
-  //Temperature average
-  SMA_4D8.data.u8[4] = (temperature_average >> 8);
-  SMA_4D8.data.u8[5] = (temperature_average & 0x00FF);
-  //Battery ready
-  if (datalayer.battery.status.bms_status == FAULT) {
-    SMA_4D8.data.u8[6] = STOP_STATE;
-  } else {
-    SMA_4D8.data.u8[6] = READY_STATE;
-  }
+  sma_3d8_encoder.encode(SMA_3D8, datalayer.battery.status.reported_soc, datalayer.battery.status.soh_pptt,
+                         ampere_hours_remaining);
+
+  //Battery stops on a fault, otherwise it is ready
+  sma_4d8_encoder.encode(SMA_4D8, datalayer.battery.status.voltage_dV, datalayer.battery.status.current_dA,
+                         temperature_average, datalayer.battery.status.bms_status == FAULT ? STOP_STATE : READY_STATE);
 
-  //Highest battery temperature
-  SMA_518.data.u8[0] = (datalayer.battery.status.temperature_max_dC >> 8);
-  SMA_518.data.u8[1] = (datalayer.battery.status.temperature_max_dC & 0x00FF);
-  //Lowest battery temperature
-  SMA_518.data.u8[2] = (datalayer.battery.status.temperature_min_dC >> 8);
-  SMA_518.data.u8[3] = (datalayer.battery.status.temperature_min_dC & 0x00FF);
-  //Sum of all cellvoltages
-  SMA_518.data.u8[4] = (datalayer.battery.status.voltage_dV >> 8);
-  SMA_518.data.u8[5] = (datalayer.battery.status.voltage_dV & 0x00FF);
-  //Cell min/max voltage (mV / 25)
-  SMA_518.data.u8[6] = (datalayer.battery.status.cell_min_voltage_mV / 25);
-  SMA_518.data.u8[7] = (datalayer.battery.status.cell_max_voltage_mV / 25);
-
-  //Lifetime charged energy amount
-  SMA_458.data.u8[0] = (datalayer.battery.status.total_charged_battery_Wh & 0xFF000000) >> 24;
-  SMA_458.data.u8[1] = (datalayer.battery.status.total_charged_battery_Wh & 0x00FF0000) >> 16;
-  SMA_458.data.u8[2] = (datalayer.battery.status.total_charged_battery_Wh & 0x0000FF00) >> 8;
-  SMA_458.data.u8[3] = (datalayer.battery.status.total_charged_battery_Wh & 0x000000FF);
-  //Lifetime discharged energy amount
-  SMA_458.data.u8[4] = (datalayer.battery.status.total_discharged_battery_Wh & 0xFF000000) >> 24;
-  SMA_458.data.u8[5] = (datalayer.battery.status.total_discharged_battery_Wh & 0x00FF0000) >> 16;
-  SMA_458.data.u8[6] = (datalayer.battery.status.total_discharged_battery_Wh & 0x0000FF00) >> 8;
-  SMA_458.data.u8[7] = (datalayer.battery.status.total_discharged_battery_Wh & 0x000000FF);
+  sma_518_encoder.encode(SMA_518, datalayer.battery.status.temperature_max_dC,
+                         datalayer.battery.status.temperature_min_dC, datalayer.battery.status.voltage_dV,
+                         datalayer.battery.status.cell_min_voltage_mV, datalayer.battery.status.cell_max_voltage_mV);
+
+  sma_458_encoder.encode(SMA_458, datalayer.battery.status.total_charged_battery_Wh,
+                         datalayer.battery.status.total_discharged_battery_Wh);
 
   control_contactor_led();
 
@@ -102,20 +57,19 @@ void SmaTripowerInverter::
   }
 }
 
-void SmaTripowerInverter::map_can_frame_to_variable(CAN_frame rx_frame) {
+void SmaTripowerInverter::map_can_frame_to_variable(const CAN_frame& rx_frame) {
   switch (rx_frame.ID) {
     case 0x360:  //Message originating from SMA inverter - Voltage and current
       datalayer.system.status.CAN_inverter_still_alive = CAN_STILL_ALIVE;
-      inverter_voltage = (rx_frame.data.u8[0] << 8) | rx_frame.data.u8[1];
-      inverter_current = (rx_frame.data.u8[2] << 8) | rx_frame.data.u8[3];
+      inverter_voltage = CanFieldBE<0>::unpack(rx_frame);
+      inverter_current = CanFieldBE<2, 2, true>::unpack(rx_frame);
       break;
     case 0x3E0:  //Message originating from SMA inverter - ?
       datalayer.system.status.CAN_inverter_still_alive = CAN_STILL_ALIVE;
       break;
     case 0x420:  //Message originating from SMA inverter - Timestamp
       datalayer.system.status.CAN_inverter_still_alive = CAN_STILL_ALIVE;
-      inverter_time =
-          (rx_frame.data.u8[0] << 24) | (rx_frame.data.u8[1] << 16) | (rx_frame.data.u8[2] << 8) | rx_frame.data.u8[3];
+      inverter_time = CanFieldBE<0, 4>::unpack(rx_frame);
       break;
     case 0x560:  //Message originating from SMA inverter - Init
       datalayer.system.status.CAN_inverter_still_alive = CAN_STILL_ALIVE;
@@ -138,10 +92,10 @@ void SmaTripowerInverter::map_can_frame_to_variable(CAN_frame rx_frame) {
 }
 
 void SmaTripowerInverter::pushFrame(CAN_frame* frame, std::function<void(void)> callback) {
-  if (listLength >= 20) {
+  if (listLength >= FRAME_LIST_SIZE) {
     return;  //TODO: scream.
   }
-  framesToSend[listLength] = {
+  framesToSend[(listHead + listLength) % FRAME_LIST_SIZE] = {
       .frame = frame,
       .callback = callback,
   };
@@ -158,12 +112,10 @@ void SmaTripowerInverter::transmit_can(unsigned long currentMillis) {
   if (listLength > 0 && currentMillis - previousMillis250ms >= INTERVAL_250_MS) {
     previousMillis250ms = currentMillis;
     // Send next frame.
-    Frame frame = framesToSend[0];
+    Frame& frame = framesToSend[listHead];
     transmit_can_frame(frame.frame);
     frame.callback();
-    for (int i = 0; i < listLength - 1; i++) {
-      framesToSend[i] = framesToSend[i + 1];
-    }
+    listHead = (listHead + 1) % FRAME_LIST_SIZE;
     listLength--;
   }
 
@@ -195,7 +147,8 @@ void SmaTripowerInverter::completePairing() {
 }
 
 void SmaTripowerInverter::transmit_can_init() {
-  listLength = 0;  // clear all frames
+  listHead = 0;  // clear all frames
+  listLength = 0;
 
   pushFrame(&SMA_558);    //Pairing start - Vendor
   pushFrame(&SMA_598);    //Serial
@@ -2,6 +2,7 @@
 #define SMA_CAN_TRIPOWER_H
 
 #include "../devboard/hal/hal.h"
+#include "../devboard/utils/can_signal.h"
 #include "SmaInverterBase.h"
 
 #include <functional>
@@ -11,7 +12,8 @@ class SmaTripowerInverter : public SmaInverterBase {
   const char* name() override { return Name; }
   void update_values();
   void transmit_can(unsigned long currentMillis);
-  void map_can_frame_to_variable(CAN_frame rx_frame);
+  void map_can_frame_to_variable(const CAN_frame& rx_frame);
+  CanIdFilter can_id_filter() { return {.min_id = 0x360, .max_id = 0x660}; }
   static constexpr const char* Name = "SMA Tripower CAN";
 
   virtual bool controls_contactor() { return true; }
@@ -36,8 +38,11 @@ class SmaTripowerInverter : public SmaInverterBase {
     std::function<void(void)> callback;
   } Frame;
 
+  // Ring of frames sent one every 250ms, listHead is the next one to send
+  static const unsigned short FRAME_LIST_SIZE = 20;
+  unsigned short listHead = 0;
   unsigned short listLength = 0;
-  Frame framesToSend[20];
+  Frame framesToSend[FRAME_LIST_SIZE];
 
   uint32_t inverter_time = 0;
   uint16_t inverter_voltage = 0;
@@ -48,6 +53,24 @@ class SmaTripowerInverter : public SmaInverterBase {
   uint16_t ampere_hours_remaining = 0;
   uint16_t timeWithoutInverterAllowsContactorClosing = 0;
 
+  // Max/min design voltage, max discharge/charge current
+  using Sma358 = CanMessage<CanFieldBE<0>, CanFieldBE<2>, CanFieldBE<4>, CanFieldBE<6>>;
+  // SOC, SOH, remaining capacity (0.1 Ah)
+  using Sma3D8 = CanMessage<CanFieldBE<0>, CanFieldBE<2>, CanFieldBE<4>>;
+  // Lifetime charged/discharged energy (Wh)
+  using Sma458 = CanMessage<CanFieldBE<0, 4>, CanFieldBE<4, 4>>;
+  // Voltage, current, average temperature, battery state
+  using Sma4D8 = CanMessage<CanFieldBE<0>, CanFieldBE<2, 2, true>, CanFieldBE<4, 2, true>, CanFieldBE<6, 1>>;
+  // Max/min temperature, sum of cell voltages, min/max cell voltage (25 mV)
+  using Sma518 = CanMessage<CanFieldBE<0, 2, true>, CanFieldBE<2, 2, true>, CanFieldBE<4>, CanFieldBE<6, 1, false, 25>,
+                            CanFieldBE<7, 1, false, 25>>;
+
+  CanFrameEncoder<Sma358> sma_358_encoder;
+  CanFrameEncoder<Sma3D8> sma_3d8_encoder;
+  CanFrameEncoder<Sma458> sma_458_encoder;
+  CanFrameEncoder<Sma4D8> sma_4d8_encoder;
+  CanFrameEncoder<Sma518> sma_518_encoder;
+
   //Actual content messages
   CAN_frame SMA_358 = {.FD = false,
                        .ext_ID = false,
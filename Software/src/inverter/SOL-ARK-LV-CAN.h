@@ -8,7 +8,7 @@ class SolArkLvInverter : public CanInverterProtocol {
   const char* name() override { return Name; }
   void update_values();
   void transmit_can(unsigned long currentMillis);
-  void map_can_frame_to_variable(CAN_frame rx_frame);
+  void map_can_frame_to_variable(const CAN_frame& rx_frame);
   static constexpr const char* Name = "Sol-Ark LV protocol over CAN bus";
 
  private:
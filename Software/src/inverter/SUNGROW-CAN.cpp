@@ -1,6 +1,7 @@
 #include "SUNGROW-CAN.h"
 #include "../communication/can/comm_can.h"
 #include "../datalayer/datalayer.h"
+#include "../devboard/utils/crc.h"
 
 /* TODO: 
 This protocol is still under development and should be considered beta quality.
@@ -46,20 +47,9 @@ constexpr uint16_t MODBUS_REGISTER_VALUES[SungrowInverter::MODBUS_REGISTER_QTY]
 // Maximum number of Modbus data bytes based on the virtual register window.
 constexpr uint8_t MODBUS_MAX_DATA_BYTES = static_cast<uint8_t>(SungrowInverter::MODBUS_REGISTER_QTY * 2);
 
-// Minimal Modbus RTU CRC16 (poly 0xA001, little-endian output).
+// Modbus RTU CRC16 (poly 0xA001, little-endian output).
 uint16_t modbus_crc(const uint8_t* data, uint8_t length) {
-  uint16_t crc = 0xFFFF;
-  for (uint8_t i = 0; i < length; ++i) {
-    crc ^= data[i];
-    for (uint8_t bit = 0; bit < 8; ++bit) {
-      if (crc & 0x0001) {
-        crc = (crc >> 1) ^ 0xA001;
-      } else {
-        crc >>= 1;
-      }
-    }
-  }
-  return crc;
+  return Crc16Modbus::calculate(data, length);
 }
 
 }  // namespace
@@ -68,8 +58,7 @@ void SungrowInverter::update_values() {
   current_dA = datalayer.battery.status.current_dA;
 
   // Actual SoC
-  SUNGROW_400.data.u8[1] = (datalayer.battery.status.real_soc & 0x00FF);
-  SUNGROW_400.data.u8[2] = (datalayer.battery.status.real_soc >> 8);
+  sungrow_400_encoder.encode(SUNGROW_400, datalayer.battery.status.real_soc);
   // Magic number
   SUNGROW_400.data.u8[3] = 0x01;
 
@@ -79,63 +68,37 @@ void SungrowInverter::update_values() {
   SUNGROW_500.data.u8[2] = 0x03;                                           // Number of modules?
   SUNGROW_500.data.u8[3] = 0xFF;                                           // Magic number
   SUNGROW_500.data.u8[5] = 0x01;                                           // Magic number
-  SUNGROW_500.data.u8[7] = (datalayer.battery.status.reported_soc / 100);  // SoC as a int
-
-  //Maxvoltage (eg 400.0V = 4000 , 16bits long)
-  SUNGROW_701.data.u8[0] = (datalayer.battery.info.max_design_voltage_dV & 0x00FF);
-  SUNGROW_701.data.u8[1] = (datalayer.battery.info.max_design_voltage_dV >> 8);
-  //Minvoltage (eg 300.0V = 3000 , 16bits long)
-  SUNGROW_701.data.u8[2] = (datalayer.battery.info.min_design_voltage_dV & 0x00FF);
-  SUNGROW_701.data.u8[3] = (datalayer.battery.info.min_design_voltage_dV >> 8);
-  // Max Charging Current
-  SUNGROW_701.data.u8[4] = (datalayer.battery.status.max_charge_current_dA & 0x00FF);
-  SUNGROW_701.data.u8[5] = (datalayer.battery.status.max_charge_current_dA >> 8);
-  // Max Discharging Current
-  SUNGROW_701.data.u8[6] = (datalayer.battery.status.max_discharge_current_dA & 0x00FF);
-  SUNGROW_701.data.u8[7] = (datalayer.battery.status.max_discharge_current_dA >> 8);
-
-  //SOC (100.0%)
-  SUNGROW_702.data.u8[0] = (datalayer.battery.status.reported_soc & 0x00FF);
-  SUNGROW_702.data.u8[1] = (datalayer.battery.status.reported_soc >> 8);
-  //SOH (100.00%)
-  SUNGROW_702.data.u8[2] = (datalayer.battery.status.soh_pptt & 0x00FF);
-  SUNGROW_702.data.u8[3] = (datalayer.battery.status.soh_pptt >> 8);
-  // Energy Remaining (Wh), clamped to 16-bit to avoid overflow on large packs
+  // SoC as a int
+  sungrow_500_encoder.encode(SUNGROW_500, datalayer.battery.status.reported_soc);
+
+  // Set when a value of the 7## messages changed, which are copied to the 0## and 5## messages below
+  bool changed = false;
+
+  //Max/min voltage (eg 400.0V = 4000 , 16bits long), max charging and discharging current
+  changed |= sungrow_701_encoder.encode(
+      SUNGROW_701, datalayer.battery.info.max_design_voltage_dV, datalayer.battery.info.min_design_voltage_dV,
+      datalayer.battery.status.max_charge_current_dA, datalayer.battery.status.max_discharge_current_dA);
+
+  // Energy remaining and capacity max (Wh), clamped to 16-bit to avoid overflow on large packs
   remaining_wh = datalayer.battery.status.reported_remaining_capacity_Wh;
   if (remaining_wh > 0xFFFFu)
     remaining_wh = 0xFFFFu;
-  SUNGROW_702.data.u8[4] = static_cast<uint8_t>(remaining_wh & 0x00FF);
-  SUNGROW_702.data.u8[5] = static_cast<uint8_t>((remaining_wh >> 8) & 0x00FF);
-  // Capacity max (Wh), clamped to 16-bit to avoid overflow on large packs
   capacity_wh = datalayer.battery.info.reported_total_capacity_Wh;
   if (capacity_wh > 0xFFFFu)
     capacity_wh = 0xFFFFu;
-  SUNGROW_702.data.u8[6] = static_cast<uint8_t>(capacity_wh & 0x00FF);
-  SUNGROW_702.data.u8[7] = static_cast<uint8_t>((capacity_wh >> 8) & 0x00FF);
-
-  // Energy total charged (Wh)
-  SUNGROW_703.data.u8[0] = (datalayer.battery.status.total_charged_battery_Wh & 0x00FF);
-  SUNGROW_703.data.u8[1] = ((datalayer.battery.status.total_charged_battery_Wh >> 8) & 0x00FF);
-  SUNGROW_703.data.u8[2] = ((datalayer.battery.status.total_charged_battery_Wh >> 16) & 0x00FF);
-  SUNGROW_703.data.u8[3] = ((datalayer.battery.status.total_charged_battery_Wh >> 24) & 0x00FF);
-  // Energy total discharged (Wh)
-  SUNGROW_703.data.u8[4] = (datalayer.battery.status.total_discharged_battery_Wh & 0x00FF);
-  SUNGROW_703.data.u8[5] = ((datalayer.battery.status.total_discharged_battery_Wh >> 8) & 0x00FF);
-  SUNGROW_703.data.u8[6] = ((datalayer.battery.status.total_discharged_battery_Wh >> 16) & 0x00FF);
-  SUNGROW_703.data.u8[7] = ((datalayer.battery.status.total_discharged_battery_Wh >> 24) & 0x00FF);
-
-  //Vbat (eg 400.0V = 4000 , 16bits long)
-  SUNGROW_704.data.u8[0] = (datalayer.battery.status.voltage_dV & 0x00FF);
-  SUNGROW_704.data.u8[1] = (datalayer.battery.status.voltage_dV >> 8);
-  // Current
-  SUNGROW_704.data.u8[2] = static_cast<uint8_t>(current_dA & 0xFF);
-  SUNGROW_704.data.u8[3] = static_cast<uint8_t>((current_dA >> 8) & 0xFF);
-  // Another voltage. Different but similar
-  SUNGROW_704.data.u8[4] = (datalayer.battery.status.voltage_dV & 0x00FF);
-  SUNGROW_704.data.u8[5] = (datalayer.battery.status.voltage_dV >> 8);
-  //Temperature //TODO: Signed correctly? Also should be put AVG here?
-  SUNGROW_704.data.u8[6] = (datalayer.battery.status.temperature_max_dC & 0x00FF);
-  SUNGROW_704.data.u8[7] = (datalayer.battery.status.temperature_max_dC >> 8);
+  //SOC (100.0%), SOH (100.00%)
+  changed |= sungrow_702_encoder.encode(SUNGROW_702, datalayer.battery.status.reported_soc,
+                                        datalayer.battery.status.soh_pptt, remaining_wh, capacity_wh);
+
+  // Energy total charged and discharged (Wh)
+  changed |= sungrow_703_encoder.encode(SUNGROW_703, datalayer.battery.status.total_charged_battery_Wh,
+                                        datalayer.battery.status.total_discharged_battery_Wh);
+
+  //Vbat (eg 400.0V = 4000 , 16bits long), current, another voltage (different but similar) and temperature
+  //TODO: Temperature signed correctly? Also should be put AVG here?
+  changed |= sungrow_704_encoder.encode(SUNGROW_704, datalayer.battery.status.voltage_dV, current_dA,
+                                        datalayer.battery.status.voltage_dV,
+                                        datalayer.battery.status.temperature_max_dC);
 
   //Status bytes?
   SUNGROW_705.data.u8[0] = 0x02;  // Magic number
@@ -144,23 +107,15 @@ void SungrowInverter::update_values() {
   SUNGROW_705.data.u8[3] = 0xE7;  // Magic number
   SUNGROW_705.data.u8[4] = 0x20;  // Magic number
   //Vbat, again (eg 400.0V = 4000 , 16bits long)
-  SUNGROW_705.data.u8[5] = (datalayer.battery.status.voltage_dV & 0x00FF);
-  SUNGROW_705.data.u8[6] = (datalayer.battery.status.voltage_dV >> 8);
+  changed |= sungrow_705_encoder.encode(SUNGROW_705, datalayer.battery.status.voltage_dV);
   // Padding?
   SUNGROW_705.data.u8[7] = 0x00;  // Magic number
 
-  //Temperature Max //TODO: Signed correctly?
-  SUNGROW_706.data.u8[0] = (datalayer.battery.status.temperature_max_dC & 0x00FF);
-  SUNGROW_706.data.u8[1] = (datalayer.battery.status.temperature_max_dC >> 8);
-  //Temperature Min //TODO: Signed correctly?
-  SUNGROW_706.data.u8[2] = (datalayer.battery.status.temperature_min_dC & 0x00FF);
-  SUNGROW_706.data.u8[3] = (datalayer.battery.status.temperature_min_dC >> 8);
-  //Cell voltage max
-  SUNGROW_706.data.u8[4] = (datalayer.battery.status.cell_max_voltage_mV & 0x00FF);
-  SUNGROW_706.data.u8[5] = (datalayer.battery.status.cell_max_voltage_mV >> 8);
-  //Cell voltage min
-  SUNGROW_706.data.u8[6] = (datalayer.battery.status.cell_min_voltage_mV & 0x00FF);
-  SUNGROW_706.data.u8[7] = (datalayer.battery.status.cell_min_voltage_mV >> 8);
+  //Temperature max and min (TODO: Signed correctly?), cell voltage max and min
+  changed |= sungrow_706_encoder.encode(SUNGROW_706, datalayer.battery.status.temperature_max_dC,
+                                        datalayer.battery.status.temperature_min_dC,
+                                        datalayer.battery.status.cell_max_voltage_mV,
+                                        datalayer.battery.status.cell_min_voltage_mV);
 
   // Battery Configuration
   SUNGROW_707.data.u8[0] = 0x26;                     // Magic number
@@ -198,15 +153,9 @@ void SungrowInverter::update_values() {
   SUNGROW_70F_04.data.u8[2] = 0x0C;
   SUNGROW_70F_04.data.u8[3] = 0x06;
 
-  // Module 1 SoC
-  SUNGROW_70F_05.data.u8[2] = (datalayer.battery.status.real_soc & 0xFF);
-  SUNGROW_70F_05.data.u8[3] = (datalayer.battery.status.real_soc >> 8);
-  // Module 2 SoC
-  SUNGROW_70F_05.data.u8[4] = (datalayer.battery.status.real_soc & 0xFF);
-  SUNGROW_70F_05.data.u8[5] = (datalayer.battery.status.real_soc >> 8);
-  // Module 3 SoC
-  SUNGROW_70F_05.data.u8[6] = (datalayer.battery.status.real_soc & 0xFF);
-  SUNGROW_70F_05.data.u8[7] = (datalayer.battery.status.real_soc >> 8);
+  // Module 1, 2 and 3 SoC
+  sungrow_70f_05_encoder.encode(SUNGROW_70F_05, datalayer.battery.status.real_soc,
+                                datalayer.battery.status.real_soc, datalayer.battery.status.real_soc);
 
   //Status bytes?
   SUNGROW_713.data.u8[0] = 0x02;  // Magic number
@@ -221,34 +170,20 @@ void SungrowInverter::update_values() {
   // Overview - Stack overview?
   SUNGROW_714.data.u8[0] = 0x05;  // Enum??
   SUNGROW_714.data.u8[1] = 0x01;  // Magic number
-  // Cell Voltage
-  SUNGROW_714.data.u8[2] = ((datalayer.battery.status.cell_max_voltage_mV * 10) & 0x00FF);
-  SUNGROW_714.data.u8[3] = ((datalayer.battery.status.cell_max_voltage_mV * 10) >> 8);
   SUNGROW_714.data.u8[4] = 0x11;  // Enum???
   SUNGROW_714.data.u8[5] = 0x02;  // Magic number
-  // Cell Voltage
-  SUNGROW_714.data.u8[6] = ((datalayer.battery.status.cell_min_voltage_mV * 10) & 0x00FF);
-  SUNGROW_714.data.u8[7] = ((datalayer.battery.status.cell_min_voltage_mV * 10) >> 8);
-
-  // Module 1 Min Cell voltage
-  SUNGROW_715.data.u8[0] = ((datalayer.battery.status.cell_min_voltage_mV * 10) & 0x00FF);
-  SUNGROW_715.data.u8[1] = ((datalayer.battery.status.cell_min_voltage_mV * 10) >> 8);
-  // Module 1 Max Cell voltage
-  SUNGROW_715.data.u8[2] = ((datalayer.battery.status.cell_max_voltage_mV * 10) & 0x00FF);
-  SUNGROW_715.data.u8[3] = ((datalayer.battery.status.cell_max_voltage_mV * 10) >> 8);
-  // Module 2 Min Cell voltage
-  SUNGROW_715.data.u8[4] = ((datalayer.battery.status.cell_min_voltage_mV * 10) & 0x00FF);
-  SUNGROW_715.data.u8[5] = ((datalayer.battery.status.cell_min_voltage_mV * 10) >> 8);
-  // Module 2 Max Cell voltage
-  SUNGROW_715.data.u8[6] = ((datalayer.battery.status.cell_max_voltage_mV * 10) & 0x00FF);
-  SUNGROW_715.data.u8[7] = ((datalayer.battery.status.cell_max_voltage_mV * 10) >> 8);
-
-  // Module 3 Min Cell voltage
-  SUNGROW_716.data.u8[0] = ((datalayer.battery.status.cell_min_voltage_mV * 10) & 0x00FF);
-  SUNGROW_716.data.u8[1] = ((datalayer.battery.status.cell_min_voltage_mV * 10) >> 8);
-  // Module 3 Max Cell voltage
-  SUNGROW_716.data.u8[2] = ((datalayer.battery.status.cell_max_voltage_mV * 10) & 0x00FF);
-  SUNGROW_716.data.u8[3] = ((datalayer.battery.status.cell_max_voltage_mV * 10) >> 8);
+  // Cell Voltage max and min
+  changed |= sungrow_714_encoder.encode(SUNGROW_714, datalayer.battery.status.cell_max_voltage_mV,
+                                        datalayer.battery.status.cell_min_voltage_mV);
+
+  // Module 1 and 2 Min/Max Cell voltage
+  changed |= sungrow_715_encoder.encode(
+      SUNGROW_715, datalayer.battery.status.cell_min_voltage_mV, datalayer.battery.status.cell_max_voltage_mV,
+      datalayer.battery.status.cell_min_voltage_mV, datalayer.battery.status.cell_max_voltage_mV);
+
+  // Module 3 Min/Max Cell voltage
+  changed |= sungrow_716_encoder.encode(SUNGROW_716, datalayer.battery.status.cell_min_voltage_mV,
+                                        datalayer.battery.status.cell_max_voltage_mV);
 
   SUNGROW_717.data.u8[0] = 0x00;
 
@@ -276,53 +211,55 @@ void SungrowInverter::update_values() {
   SUNGROW_71C.data.u8[2] = 0x6F;  // Magic number
   SUNGROW_71C.data.u8[3] = 0x01;  // Magic number
 
-  //Copy 7## content to 0## messages
-  for (int i = 0; i < 8; i++) {
-    // SUNGROW_000 all bytes 0x00
-    SUNGROW_001.data.u8[i] = SUNGROW_701.data.u8[i];
-    SUNGROW_002.data.u8[i] = SUNGROW_702.data.u8[i];
-    SUNGROW_003.data.u8[i] = SUNGROW_703.data.u8[i];
-    SUNGROW_004.data.u8[i] = SUNGROW_704.data.u8[i];
-    SUNGROW_005.data.u8[i] = SUNGROW_705.data.u8[i];
-    SUNGROW_006.data.u8[i] = SUNGROW_706.data.u8[i];
-    SUNGROW_007.data.u8[i] = SUNGROW_707.data.u8[i];
-    SUNGROW_008_00.data.u8[i] = SUNGROW_708_00.data.u8[i];
-    SUNGROW_008_01.data.u8[i] = SUNGROW_708_01.data.u8[i];
-    // SUNGROW_009 all bytes 0x00
-    SUNGROW_00A_00.data.u8[i] = SUNGROW_70A_00.data.u8[i];
-    SUNGROW_00A_01.data.u8[i] = SUNGROW_70A_01.data.u8[i];
-    SUNGROW_00B.data.u8[i] = SUNGROW_70B.data.u8[i];
-    SUNGROW_00D.data.u8[i] = SUNGROW_70D.data.u8[i];
-    SUNGROW_00E.data.u8[i] = SUNGROW_70E.data.u8[i];
-    SUNGROW_013.data.u8[i] = SUNGROW_713.data.u8[i];
-    SUNGROW_014.data.u8[i] = SUNGROW_714.data.u8[i];
-    SUNGROW_015.data.u8[i] = SUNGROW_715.data.u8[i];
-    SUNGROW_016.data.u8[i] = SUNGROW_716.data.u8[i];
-    SUNGROW_017.data.u8[i] = SUNGROW_717.data.u8[i];
-    SUNGROW_018.data.u8[i] = SUNGROW_718.data.u8[i];
-    SUNGROW_019.data.u8[i] = SUNGROW_719.data.u8[i];
-    SUNGROW_01A.data.u8[i] = SUNGROW_71A.data.u8[i];
-    SUNGROW_01B.data.u8[i] = SUNGROW_71B.data.u8[i];
-    SUNGROW_01C.data.u8[i] = SUNGROW_71C.data.u8[i];
-    SUNGROW_01D.data.u8[i] = SUNGROW_71D.data.u8[i];
-    SUNGROW_01E.data.u8[i] = SUNGROW_71E.data.u8[i];
-  }
+  // The other 7## messages only hold constants, so they only need copying when a value changed
+  if (changed) {
+    //Copy 7## content to 0## messages
+    for (int i = 0; i < 8; i++) {
+      // SUNGROW_000 all bytes 0x00
+      SUNGROW_001.data.u8[i] = SUNGROW_701.data.u8[i];
+      SUNGROW_002.data.u8[i] = SUNGROW_702.data.u8[i];
+      SUNGROW_003.data.u8[i] = SUNGROW_703.data.u8[i];
+      SUNGROW_004.data.u8[i] = SUNGROW_704.data.u8[i];
+      SUNGROW_005.data.u8[i] = SUNGROW_705.data.u8[i];
+      SUNGROW_006.data.u8[i] = SUNGROW_706.data.u8[i];
+      SUNGROW_007.data.u8[i] = SUNGROW_707.data.u8[i];
+      SUNGROW_008_00.data.u8[i] = SUNGROW_708_00.data.u8[i];
+      SUNGROW_008_01.data.u8[i] = SUNGROW_708_01.data.u8[i];
+      // SUNGROW_009 all bytes 0x00
+      SUNGROW_00A_00.data.u8[i] = SUNGROW_70A_00.data.u8[i];
+      SUNGROW_00A_01.data.u8[i] = SUNGROW_70A_01.data.u8[i];
+      SUNGROW_00B.data.u8[i] = SUNGROW_70B.data.u8[i];
+      SUNGROW_00D.data.u8[i] = SUNGROW_70D.data.u8[i];
+      SUNGROW_00E.data.u8[i] = SUNGROW_70E.data.u8[i];
+      SUNGROW_013.data.u8[i] = SUNGROW_713.data.u8[i];
+      SUNGROW_014.data.u8[i] = SUNGROW_714.data.u8[i];
+      SUNGROW_015.data.u8[i] = SUNGROW_715.data.u8[i];
+      SUNGROW_016.data.u8[i] = SUNGROW_716.data.u8[i];
+      SUNGROW_017.data.u8[i] = SUNGROW_717.data.u8[i];
+      SUNGROW_018.data.u8[i] = SUNGROW_718.data.u8[i];
+      SUNGROW_019.data.u8[i] = SUNGROW_719.data.u8[i];
+      SUNGROW_01A.data.u8[i] = SUNGROW_71A.data.u8[i];
+      SUNGROW_01B.data.u8[i] = SUNGROW_71B.data.u8[i];
+      SUNGROW_01C.data.u8[i] = SUNGROW_71C.data.u8[i];
+      SUNGROW_01D.data.u8[i] = SUNGROW_71D.data.u8[i];
+      SUNGROW_01E.data.u8[i] = SUNGROW_71E.data.u8[i];
+    }
 
-  //Copy 7## content to 5## messages
-  for (int i = 0; i < 8; i++) {
-    SUNGROW_501.data.u8[i] = SUNGROW_701.data.u8[i];
-    SUNGROW_502.data.u8[i] = SUNGROW_702.data.u8[i];
-    SUNGROW_503.data.u8[i] = SUNGROW_703.data.u8[i];
-    SUNGROW_504.data.u8[i] = SUNGROW_704.data.u8[i];
-    SUNGROW_505.data.u8[i] = SUNGROW_705.data.u8[i];
-    SUNGROW_506.data.u8[i] = SUNGROW_706.data.u8[i];
-  }
-  // 0x504 cannot be a straight copy: current must be the opposite sign
-  int32_t flipped = -(static_cast<int32_t>(current_dA));
-  int16_t current_dA_flipped = clamp_i32_to_i16(flipped);
+    //Copy 7## content to 5## messages
+    for (int i = 0; i < 8; i++) {
+      SUNGROW_501.data.u8[i] = SUNGROW_701.data.u8[i];
+      SUNGROW_502.data.u8[i] = SUNGROW_702.data.u8[i];
+      SUNGROW_503.data.u8[i] = SUNGROW_703.data.u8[i];
+      SUNGROW_504.data.u8[i] = SUNGROW_704.data.u8[i];
+      SUNGROW_505.data.u8[i] = SUNGROW_705.data.u8[i];
+      SUNGROW_506.data.u8[i] = SUNGROW_706.data.u8[i];
+    }
+    // 0x504 cannot be a straight copy: current must be the opposite sign
+    int32_t flipped = -(static_cast<int32_t>(current_dA));
+    int16_t current_dA_flipped = clamp_i32_to_i16(flipped);
 
-  SUNGROW_504.data.u8[2] = static_cast<uint8_t>(current_dA_flipped & 0xFF);
-  SUNGROW_504.data.u8[3] = static_cast<uint8_t>((current_dA_flipped >> 8) & 0xFF);
+    CanFieldLE<2, 2, true>::pack(SUNGROW_504, current_dA_flipped);
+  }
 
 #ifdef DEBUG_VIA_USB
   if (inverter_sends_000) {
@@ -331,7 +268,7 @@ void SungrowInverter::update_values() {
 #endif
 }
 
-void SungrowInverter::map_can_frame_to_variable(CAN_frame rx_frame) {
+void SungrowInverter::map_can_frame_to_variable(const CAN_frame& rx_frame) {
   switch (rx_frame.ID) {
     case 0x100:
       // SH10RS RUN @ ~1,250ms (group with one message every 250ms)
@@ -1,6 +1,7 @@
 #ifndef SUNGROW_CAN_H
 #define SUNGROW_CAN_H
 
+#include "../devboard/utils/can_signal.h"
 #include "CanInverterProtocol.h"
 
 class SungrowInverter : public CanInverterProtocol {
@@ -10,7 +11,7 @@ class SungrowInverter : public CanInverterProtocol {
   SungrowInverter() : CanInverterProtocol(CAN_Speed::CAN_SPEED_250KBPS) {}
   void update_values();
   void transmit_can(unsigned long currentMillis);
-  void map_can_frame_to_variable(CAN_frame rx_frame);
+  void map_can_frame_to_variable(const CAN_frame& rx_frame);
   static constexpr const char* Name = "Sungrow SBRXXX emulation over CAN bus";
   static constexpr uint8_t MODBUS_SLAVE_ADDR = 0x01;
   static constexpr uint16_t MODBUS_REGISTER_BASE_ADDR = 0x4DE2;
@@ -49,6 +50,45 @@ class SungrowInverter : public CanInverterProtocol {
     return static_cast<int16_t>(value);
   }
 
+  // Actual SoC
+  using Sungrow400 = CanMessage<CanFieldLE<1>>;
+  // SoC as a int
+  using Sungrow500 = CanMessage<CanFieldLE<7, 1, false, 100>>;
+  // Max/min voltage, max charging/discharging current
+  using Sungrow701 = CanMessage<CanFieldLE<0>, CanFieldLE<2>, CanFieldLE<4>, CanFieldLE<6>>;
+  // SOC, SOH, energy remaining and capacity (Wh)
+  using Sungrow702 = CanMessage<CanFieldLE<0>, CanFieldLE<2>, CanFieldLE<4>, CanFieldLE<6>>;
+  // Energy total charged/discharged (Wh)
+  using Sungrow703 = CanMessage<CanFieldLE<0, 4>, CanFieldLE<4, 4>>;
+  // Vbat, current, another voltage, temperature
+  using Sungrow704 = CanMessage<CanFieldLE<0>, CanFieldLE<2, 2, true>, CanFieldLE<4>, CanFieldLE<6, 2, true>>;
+  // Vbat, again
+  using Sungrow705 = CanMessage<CanFieldLE<5>>;
+  // Max/min temperature, max/min cell voltage
+  using Sungrow706 = CanMessage<CanFieldLE<0, 2, true>, CanFieldLE<2, 2, true>, CanFieldLE<4>, CanFieldLE<6>>;
+  // Module 1, 2 and 3 SoC
+  using Sungrow70F05 = CanMessage<CanFieldLE<2>, CanFieldLE<4>, CanFieldLE<6>>;
+  // Max/min cell voltage of the stack
+  using Sungrow714 = CanMessage<CanFieldLE<2, 2, false, 1, 10>, CanFieldLE<6, 2, false, 1, 10>>;
+  // Module 1 and 2 min/max cell voltage
+  using Sungrow715 = CanMessage<CanFieldLE<0, 2, false, 1, 10>, CanFieldLE<2, 2, false, 1, 10>,
+                                CanFieldLE<4, 2, false, 1, 10>, CanFieldLE<6, 2, false, 1, 10>>;
+  // Module 3 min/max cell voltage
+  using Sungrow716 = CanMessage<CanFieldLE<0, 2, false, 1, 10>, CanFieldLE<2, 2, false, 1, 10>>;
+
+  CanFrameEncoder<Sungrow400> sungrow_400_encoder;
+  CanFrameEncoder<Sungrow500> sungrow_500_encoder;
+  CanFrameEncoder<Sungrow701> sungrow_701_encoder;
+  CanFrameEncoder<Sungrow702> sungrow_702_encoder;
+  CanFrameEncoder<Sungrow703> sungrow_703_encoder;
+  CanFrameEncoder<Sungrow704> sungrow_704_encoder;
+  CanFrameEncoder<Sungrow705> sungrow_705_encoder;
+  CanFrameEncoder<Sungrow706> sungrow_706_encoder;
+  CanFrameEncoder<Sungrow70F05> sungrow_70f_05_encoder;
+  CanFrameEncoder<Sungrow714> sungrow_714_encoder;
+  CanFrameEncoder<Sungrow715> sungrow_715_encoder;
+  CanFrameEncoder<Sungrow716> sungrow_716_encoder;
+
   //Actual content messages
   CAN_frame SUNGROW_000 = {.FD = false,
                            .ext_ID = false,
@@ -22,6 +22,14 @@
  * Parameter: TASK_ACAN2515_PRIORITY
  * Description:
  * Defines the priority of ACAN2517FD CAN-FD handling
+ *
+ * Parameter: TASK_CAN_REPLAY_PRIO
+ * Description:
+ * Defines the priority of CAN log replay. Below core, which sends the frames the replay task hands it on time
+ *
+ * Parameter: TASK_JOURNAL_PRIO
+ * Description:
+ * Defines the priority of writing the event journal to flash. Lowest, it waits on flash writes and erases
 */
 #define TASK_CORE_PRIO 4
 #define TASK_CONNECTIVITY_PRIO 3
@@ -29,6 +37,8 @@
 #define TASK_MODBUS_PRIO 8
 #define TASK_ACAN2515_PRIORITY 10
 #define TASK_ACAN2517FD_PRIORITY 10
+#define TASK_CAN_REPLAY_PRIO 3
+#define TASK_JOURNAL_PRIO 1
 
 /** MAX AMOUNT OF CELLS
  * 
@@ -0,0 +1,186 @@
+// Host benchmark of filling inverter CAN frames from datalayer values: byte by byte as the integrations did
+// before, with the CAN signal descriptions, and with the change detecting encoders while most values stay the
+// same. Uses the layout of the SMA Tripower frames. Also checks that all ways give the same bytes.
+//
+// Usage: can_signal_benchmark [iterations]
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "../../Software/src/devboard/utils/can_signal.h"
+
+static const int UPDATES = 256;
+static const int FRAMES = 5;
+
+struct Values {
+  uint16_t max_design_voltage_dV, min_design_voltage_dV, max_discharge_current_dA, max_charge_current_dA;
+  uint16_t reported_soc, soh_pptt, ampere_hours_remaining;
+  uint16_t voltage_dV;
+  int16_t current_dA, temperature_average, temperature_max_dC, temperature_min_dC;
+  uint8_t state;
+  uint16_t cell_min_voltage_mV, cell_max_voltage_mV;
+  uint32_t total_charged_battery_Wh, total_discharged_battery_Wh;
+};
+
+using Sma358 = CanMessage<CanFieldBE<0>, CanFieldBE<2>, CanFieldBE<4>, CanFieldBE<6>>;
+using Sma3D8 = CanMessage<CanFieldBE<0>, CanFieldBE<2>, CanFieldBE<4>>;
+using Sma458 = CanMessage<CanFieldBE<0, 4>, CanFieldBE<4, 4>>;
+using Sma4D8 = CanMessage<CanFieldBE<0>, CanFieldBE<2, 2, true>, CanFieldBE<4, 2, true>, CanFieldBE<6, 1>>;
+using Sma518 = CanMessage<CanFieldBE<0, 2, true>, CanFieldBE<2, 2, true>, CanFieldBE<4>, CanFieldBE<6, 1, false, 25>,
+                          CanFieldBE<7, 1, false, 25>>;
+
+static void pack_by_hand(CAN_frame* frames, const Values& v) {
+  frames[0].data.u8[0] = (v.max_design_voltage_dV >> 8);
+  frames[0].data.u8[1] = (v.max_design_voltage_dV & 0x00FF);
+  frames[0].data.u8[2] = (v.min_design_voltage_dV >> 8);
+  frames[0].data.u8[3] = (v.min_design_voltage_dV & 0x00FF);
+  frames[0].data.u8[4] = (v.max_discharge_current_dA >> 8);
+  frames[0].data.u8[5] = (v.max_discharge_current_dA & 0x00FF);
+  frames[0].data.u8[6] = (v.max_charge_current_dA >> 8);
+  frames[0].data.u8[7] = (v.max_charge_current_dA & 0x00FF);
+
+  frames[1].data.u8[0] = (v.reported_soc >> 8);
+  frames[1].data.u8[1] = (v.reported_soc & 0x00FF);
+  frames[1].data.u8[2] = (v.soh_pptt >> 8);
+  frames[1].data.u8[3] = (v.soh_pptt & 0x00FF);
+  frames[1].data.u8[4] = (v.ampere_hours_remaining >> 8);
+  frames[1].data.u8[5] = (v.ampere_hours_remaining & 0x00FF);
+
+  frames[2].data.u8[0] = (v.voltage_dV >> 8);
+  frames[2].data.u8[1] = (v.voltage_dV & 0x00FF);
+  frames[2].data.u8[2] = (v.current_dA >> 8);
+  frames[2].data.u8[3] = (v.current_dA & 0x00FF);
+  frames[2].data.u8[4] = (v.temperature_average >> 8);
+  frames[2].data.u8[5] = (v.temperature_average & 0x00FF);
+  frames[2].data.u8[6] = v.state;
+
+  frames[3].data.u8[0] = (v.temperature_max_dC >> 8);
+  frames[3].data.u8[1] = (v.temperature_max_dC & 0x00FF);
+  frames[3].data.u8[2] = (v.temperature_min_dC >> 8);
+  frames[3].data.u8[3] = (v.temperature_min_dC & 0x00FF);
+  frames[3].data.u8[4] = (v.voltage_dV >> 8);
+  frames[3].data.u8[5] = (v.voltage_dV & 0x00FF);
+  frames[3].data.u8[6] = (v.cell_min_voltage_mV / 25);
+  frames[3].data.u8[7] = (v.cell_max_voltage_mV / 25);
+
+  frames[4].data.u8[0] = (v.total_charged_battery_Wh & 0xFF000000) >> 24;
+  frames[4].data.u8[1] = (v.total_charged_battery_Wh & 0x00FF0000) >> 16;
+  frames[4].data.u8[2] = (v.total_charged_battery_Wh & 0x0000FF00) >> 8;
+  frames[4].data.u8[3] = (v.total_charged_battery_Wh & 0x000000FF);
+  frames[4].data.u8[4] = (v.total_discharged_battery_Wh & 0xFF000000) >> 24;
+  frames[4].data.u8[5] = (v.total_discharged_battery_Wh & 0x00FF0000) >> 16;
+  frames[4].data.u8[6] = (v.total_discharged_battery_Wh & 0x0000FF00) >> 8;
+  frames[4].data.u8[7] = (v.total_discharged_battery_Wh & 0x000000FF);
+}
+
+static void pack_signals(CAN_frame* frames, const Values& v) {
+  Sma358::pack(frames[0].data.u8, v.max_design_voltage_dV, v.min_design_voltage_dV, v.max_discharge_current_dA,
+               v.max_charge_current_dA);
+  Sma3D8::pack(frames[1].data.u8, v.reported_soc, v.soh_pptt, v.ampere_hours_remaining);
+  Sma4D8::pack(frames[2].data.u8, v.voltage_dV, v.current_dA, v.temperature_average, v.state);
+  Sma518::pack(frames[3].data.u8, v.temperature_max_dC, v.temperature_min_dC, v.voltage_dV, v.cell_min_voltage_mV,
+               v.cell_max_voltage_mV);
+  Sma458::pack(frames[4].data.u8, v.total_charged_battery_Wh, v.total_discharged_battery_Wh);
+}
+
+struct Encoders {
+  CanFrameEncoder<Sma358> sma_358;
+  CanFrameEncoder<Sma3D8> sma_3d8;
+  CanFrameEncoder<Sma4D8> sma_4d8;
+  CanFrameEncoder<Sma518> sma_518;
+  CanFrameEncoder<Sma458> sma_458;
+
+  void encode(CAN_frame* frames, const Values& v) {
+    sma_358.encode(frames[0], v.max_design_voltage_dV, v.min_design_voltage_dV, v.max_discharge_current_dA,
+                   v.max_charge_current_dA);
+    sma_3d8.encode(frames[1], v.reported_soc, v.soh_pptt, v.ampere_hours_remaining);
+    sma_4d8.encode(frames[2], v.voltage_dV, v.current_dA, v.temperature_average, v.state);
+    sma_518.encode(frames[3], v.temperature_max_dC, v.temperature_min_dC, v.voltage_dV, v.cell_min_voltage_mV,
+                   v.cell_max_voltage_mV);
+    sma_458.encode(frames[4], v.total_charged_battery_Wh, v.total_discharged_battery_Wh);
+  }
+};
+
+static Values random_values() {
+  Values v;
+  v.max_design_voltage_dV = rand();
+  v.min_design_voltage_dV = rand();
+  v.max_discharge_current_dA = rand();
+  v.max_charge_current_dA = rand();
+  v.reported_soc = rand() % 10001;
+  v.soh_pptt = rand() % 10001;
+  v.ampere_hours_remaining = rand();
+  v.voltage_dV = rand();
+  v.current_dA = rand();
+  v.temperature_average = rand();
+  v.temperature_max_dC = rand();
+  v.temperature_min_dC = rand();
+  v.state = rand() & 1 ? 0x02 : 0x03;
+  v.cell_min_voltage_mV = rand() % 6000;
+  v.cell_max_voltage_mV = rand() % 6000;
+  v.total_charged_battery_Wh = rand();
+  v.total_discharged_battery_Wh = rand();
+  return v;
+}
+
+template <typename F>
+static double ns_per_frame(const Values* updates, CAN_frame* frames, int iterations, unsigned& sink, F pack) {
+  auto start = std::chrono::steady_clock::now();
+  for (int it = 0; it < iterations; ++it) {
+    for (int i = 0; i < UPDATES; ++i) {
+      pack(frames, updates[i]);
+      sink += frames[i % FRAMES].data.u8[i % 8];
+    }
+  }
+  std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+  return elapsed.count() / ((double)iterations * UPDATES * FRAMES);
+}
+
+int main(int argc, char** argv) {
+  const int iterations = argc > 1 ? atoi(argv[1]) : 20000;
+  static Values changing[UPDATES];
+  static Values mostly_same[UPDATES];
+
+  // Every update new values, or as the core task sees them: the voltage and current change now and then
+  srand(1);
+  for (int i = 0; i < UPDATES; ++i) {
+    changing[i] = random_values();
+    mostly_same[i] = changing[0];
+    if (i % 16 == 0) {
+      mostly_same[i].voltage_dV = changing[i].voltage_dV;
+      mostly_same[i].current_dA = changing[i].current_dA;
+    }
+  }
+
+  int mismatches = 0;
+  CAN_frame by_hand[FRAMES] = {};
+  CAN_frame signals[FRAMES] = {};
+  CAN_frame encoded[FRAMES] = {};
+  Encoders encoders;
+  for (const Values* updates : {changing, mostly_same}) {
+    for (int i = 0; i < UPDATES; ++i) {
+      pack_by_hand(by_hand, updates[i]);
+      pack_signals(signals, updates[i]);
+      encoders.encode(encoded, updates[i]);
+      mismatches += memcmp(by_hand, signals, sizeof(by_hand)) != 0;
+      mismatches += memcmp(by_hand, encoded, sizeof(by_hand)) != 0;
+    }
+  }
+
+  unsigned sink = 0;
+  CAN_frame frames[FRAMES] = {};
+  printf("%-22s %12s %12s %12s\n", "values", "by hand ns", "signals ns", "encoder ns");
+  for (const Values* updates : {changing, mostly_same}) {
+    Encoders timed;
+    printf("%-22s %12.1f %12.1f %12.1f\n", updates == changing ? "all changing" : "mostly unchanged",
+           ns_per_frame(updates, frames, iterations, sink, pack_by_hand),
+           ns_per_frame(updates, frames, iterations, sink, pack_signals),
+           ns_per_frame(updates, frames, iterations, sink,
+                        [&](CAN_frame* f, const Values& v) { timed.encode(f, v); }));
+  }
+  printf("mismatches: %d (checksum %u)\n", mismatches, sink);
+
+  return mismatches == 0 ? 0 : 1;
+}
@@ -0,0 +1,243 @@
+// Host benchmark of the battery integrations, replaying the logs of can_log_based/can_logs through the real
+// handle_incoming_can_frame() and update_values(). The log timestamps drive millis(), and update_values() is
+// called once per second of log time like on the device. Each log is replayed until at least the requested
+// number of frames has been handled, the timestamps continuing after the end of the log.
+//
+// Reports frames/second, ns/frame, ns per update_values() call and heap allocations per frame for each
+// BatteryType. With --json the results are also written as JSON, for comparing runs.
+//
+// Usage: canlog_benchmark [--frames N] [--json results.json] [log directory]
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <new>
+#include <string>
+#include <vector>
+
+#include "../../Software/src/battery/BATTERIES.h"
+#include "../../Software/src/battery/CanBattery.h"
+#include "../../Software/src/datalayer/datalayer.h"
+#include "../../Software/src/devboard/sdcard/can_log_format.h"
+#include "../../Software/src/devboard/utils/events.h"
+
+namespace fs = std::filesystem;
+
+static const uint64_t VALUE_UPDATE_INTERVAL_US = 1000000;
+
+// Heap allocations, counted while a replay is timed
+static bool count_allocations = false;
+static uint64_t allocations = 0;
+
+void* operator new(size_t size) {
+  if (count_allocations) {
+    allocations++;
+  }
+  void* p = malloc(size ? size : 1);
+  if (!p) {
+    throw std::bad_alloc();
+  }
+  return p;
+}
+
+void* operator new[](size_t size) {
+  return operator new(size);
+}
+
+void operator delete(void* p) noexcept {
+  free(p);
+}
+
+void operator delete[](void* p) noexcept {
+  free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+  free(p);
+}
+
+void operator delete[](void* p, size_t) noexcept {
+  free(p);
+}
+
+void store_settings_equipment_stop(void) {}
+
+struct LogFrame {
+  uint64_t timestamp_us;
+  CAN_frame frame;
+};
+
+struct Result {
+  std::vector<std::string> logs;
+  uint64_t frames = 0;
+  uint64_t updates = 0;
+  uint64_t allocations = 0;
+  double frame_ns = 0;
+  double update_ns = 0;
+};
+
+static std::vector<LogFrame> load_log(const fs::path& path) {
+  std::vector<LogFrame> frames;
+  std::ifstream file(path);
+  std::string line;
+  CAN_log_record record;
+
+  while (std::getline(file, line)) {
+    if (!can_log_parse_text(line.data(), line.size(), record)) {
+      continue;
+    }
+    LogFrame entry = {.timestamp_us = record.timestamp_us, .frame = {}};
+    entry.frame.FD = (record.flags & CAN_LOG_FLAG_FD) != 0;
+    entry.frame.ext_ID = (record.flags & CAN_LOG_FLAG_EXT_ID) != 0;
+    entry.frame.DLC = record.dlc;
+    entry.frame.ID = record.id;
+    memcpy(entry.frame.data.u8, record.data, record.dlc);
+    frames.push_back(entry);
+  }
+  return frames;
+}
+
+static void setup(BatteryType type) {
+  datalayer = DataLayer();
+  reset_all_events();
+  if (battery) {
+    delete battery;
+    battery = nullptr;
+  }
+  user_selected_battery_type = type;
+  setup_battery();
+}
+
+static void replay(const std::vector<LogFrame>& log, uint64_t min_frames, Result& result) {
+  using clock = std::chrono::steady_clock;
+  CanBattery* can_battery = dynamic_cast<CanBattery*>(battery);
+  const uint64_t first_us = log.front().timestamp_us;
+  // Keep the log spacing when starting over, with the first frame 1 ms after the last one
+  const uint64_t pass_us = log.back().timestamp_us - first_us + 1000;
+  uint64_t next_update_us = VALUE_UPDATE_INTERVAL_US;
+  uint64_t frames = 0;
+  uint64_t updates = 0;
+  clock::duration update_time{};
+
+  allocations = 0;
+  count_allocations = true;
+  const auto replay_start = clock::now();
+  for (uint64_t pass = 0; frames < min_frames; pass++) {
+    for (const LogFrame& entry : log) {
+      const uint64_t now_us = pass * pass_us + entry.timestamp_us - first_us;
+      set_millis64(now_us / 1000);
+
+      if (now_us >= next_update_us) {
+        const auto start = clock::now();
+        can_battery->update_values();
+        update_time += clock::now() - start;
+        updates++;
+        next_update_us += VALUE_UPDATE_INTERVAL_US;
+      }
+
+      can_battery->handle_incoming_can_frame(entry.frame);
+      frames++;
+    }
+  }
+  // Frames are not timed one by one, reading the clock would cost about as much as handling a frame
+  const clock::duration frame_time = clock::now() - replay_start - update_time;
+  count_allocations = false;
+
+  result.frames += frames;
+  result.updates += updates;
+  result.allocations += allocations;
+  result.frame_ns += std::chrono::duration<double, std::nano>(frame_time).count();
+  result.update_ns += std::chrono::duration<double, std::nano>(update_time).count();
+}
+
+static void write_json(const char* path, const std::map<BatteryType, Result>& results) {
+  FILE* file = fopen(path, "w");
+  if (!file) {
+    fprintf(stderr, "Could not write %s\n", path);
+    return;
+  }
+  fprintf(file, "[\n");
+  for (auto it = results.begin(); it != results.end(); ++it) {
+    const Result& r = it->second;
+    fprintf(file, "  {\"battery_type\": %d, \"name\": \"%s\", \"logs\": [", (int)it->first,
+            name_for_battery_type(it->first));
+    for (size_t i = 0; i < r.logs.size(); i++) {
+      fprintf(file, "%s\"%s\"", i ? ", " : "", r.logs[i].c_str());
+    }
+    fprintf(file,
+            "], \"frames\": %llu, \"frames_per_second\": %.0f, \"ns_per_frame\": %.1f, \"updates\": %llu, "
+            "\"ns_per_update\": %.1f, \"allocations_per_frame\": %.4f}%s\n",
+            (unsigned long long)r.frames, r.frames / (r.frame_ns * 1e-9), r.frame_ns / r.frames,
+            (unsigned long long)r.updates, r.updates ? r.update_ns / r.updates : 0.0,
+            (double)r.allocations / r.frames, std::next(it) == results.end() ? "" : ",");
+  }
+  fprintf(file, "]\n");
+  fclose(file);
+}
+
+int main(int argc, char** argv) {
+  uint64_t min_frames = 1000000;
+  const char* json_path = nullptr;
+  fs::path directory = "../can_log_based/can_logs";
+
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--frames") == 0 && i + 1 < argc) {
+      min_frames = strtoull(argv[++i], nullptr, 10);
+    } else if (strcmp(argv[i], "--json") == 0 && i + 1 < argc) {
+      json_path = argv[++i];
+    } else {
+      directory = argv[i];
+    }
+  }
+
+  std::vector<fs::path> paths;
+  for (const auto& entry : fs::directory_iterator(directory)) {
+    if (entry.is_regular_file() && entry.path().extension() == ".txt") {
+      paths.push_back(entry.path());
+    }
+  }
+  std::sort(paths.begin(), paths.end());
+
+  // Same naming as for the log based tests, <battery_type>_<battery class name>_<flags>.txt
+  std::map<BatteryType, Result> results;
+  for (const fs::path& path : paths) {
+    const std::string name = path.filename().string();
+    const BatteryType type = (BatteryType)atoi(name.c_str());
+    std::vector<LogFrame> log = load_log(path);
+    if (log.empty()) {
+      fprintf(stderr, "No frames in %s\n", name.c_str());
+      continue;
+    }
+
+    setup(type);
+    if (!dynamic_cast<CanBattery*>(battery)) {
+      fprintf(stderr, "%s is not a CAN battery\n", name.c_str());
+      continue;
+    }
+    Result& result = results[type];
+    result.logs.push_back(name);
+    replay(log, min_frames, result);
+  }
+  if (battery) {
+    delete battery;
+    battery = nullptr;
+  }
+
+  printf("%-28s %10s %12s %10s %12s %12s\n", "battery", "frames", "frames/s", "ns/frame", "ns/update",
+         "allocs/frame");
+  for (const auto& [type, r] : results) {
+    printf("%-28.28s %10llu %12.0f %10.1f %12.1f %12.4f\n", name_for_battery_type(type), (unsigned long long)r.frames,
+           r.frames / (r.frame_ns * 1e-9), r.frame_ns / r.frames, r.updates ? r.update_ns / r.updates : 0.0,
+           (double)r.allocations / r.frames);
+  }
+
+  if (json_path) {
+    write_json(json_path, results);
+  }
+  return results.empty() ? 1 : 0;
+}
@@ -0,0 +1,112 @@
+// Host benchmark of the CRC library against the bit-by-bit CRCs several integrations used before, each taking
+// the CAN frame by value as they did. Also checks that both give the same result for every frame.
+//
+// Usage: crc_benchmark [iterations]
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+#include "../../Software/src/devboard/utils/crc.h"
+
+static const int FRAMES = 256;
+
+static uint8_t reverse_bits(uint8_t byte) {
+  uint8_t reversed = 0;
+  for (int i = 0; i < 8; i++) {
+    reversed = (reversed << 1) | (byte & 1);
+    byte >>= 1;
+  }
+  return reversed;
+}
+
+// Former BMW S-Box calculateCRC
+static uint8_t bitwise_maxim(CAN_frame frame) {
+  uint8_t crc = 0;
+  for (size_t i = 0; i < frame.DLC; i++) {
+    crc ^= reverse_bits(frame.data.u8[i]);
+    for (int j = 0; j < 8; j++) {
+      crc = (crc & 0x80) ? (crc << 1) ^ 0x31 : crc << 1;
+    }
+  }
+  return reverse_bits(crc);
+}
+
+// Former MEB vw_crc_calc, without the data ID lookup
+static uint8_t bitwise_profile2(CAN_frame frame, const uint8_t* data_ids) {
+  uint8_t crc = 0xFF;
+  for (uint8_t i = 1; i < frame.DLC + 1; i++) {
+    crc ^= i < frame.DLC ? frame.data.u8[i] : data_ids[frame.data.u8[1] & 0x0F];
+    for (uint8_t j = 0; j < 8; j++) {
+      crc = (crc & 0x80) ? (crc << 1) ^ 0x2F : crc << 1;
+    }
+  }
+  return crc ^ 0xFF;
+}
+
+// Former Sungrow modbus_crc
+static uint16_t bitwise_modbus(CAN_frame frame) {
+  uint16_t crc = 0xFFFF;
+  for (uint8_t i = 0; i < frame.DLC; ++i) {
+    crc ^= frame.data.u8[i];
+    for (uint8_t bit = 0; bit < 8; ++bit) {
+      crc = (crc & 0x0001) ? (crc >> 1) ^ 0xA001 : crc >> 1;
+    }
+  }
+  return crc;
+}
+
+template <typename F>
+static double ns_per_frame(const CAN_frame* frames, int iterations, unsigned& sink, F crc) {
+  auto start = std::chrono::steady_clock::now();
+  for (int it = 0; it < iterations; ++it) {
+    for (int i = 0; i < FRAMES; ++i) {
+      sink += crc(frames[i]);
+    }
+  }
+  std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+  return elapsed.count() / ((double)iterations * FRAMES);
+}
+
+int main(int argc, char** argv) {
+  const int iterations = argc > 1 ? atoi(argv[1]) : 20000;
+  static CAN_frame frames[FRAMES];
+  uint8_t data_ids[16];
+
+  srand(1);
+  for (int i = 0; i < FRAMES; ++i) {
+    frames[i].DLC = 8;
+    for (int j = 0; j < 8; ++j) {
+      frames[i].data.u8[j] = rand();
+    }
+  }
+  for (int i = 0; i < 16; ++i) {
+    data_ids[i] = rand();
+  }
+
+  int mismatches = 0;
+  for (int i = 0; i < FRAMES; ++i) {
+    const CAN_frame& f = frames[i];
+    mismatches += bitwise_maxim(f) != Crc8Maxim::calculate(f.data.u8, f.DLC);
+    mismatches += bitwise_profile2(f, data_ids) != e2e_profile2_crc(f, f.DLC, data_ids);
+    mismatches += bitwise_modbus(f) != Crc16Modbus::calculate(f.data.u8, f.DLC);
+  }
+
+  unsigned sink = 0;
+  printf("%-22s %12s %12s\n", "algorithm", "bitwise ns", "table ns");
+  printf("%-22s %12.1f %12.1f\n", "CRC-8/MAXIM",
+         ns_per_frame(frames, iterations, sink, [](CAN_frame f) { return bitwise_maxim(f); }),
+         ns_per_frame(frames, iterations, sink,
+                      [](const CAN_frame& f) { return Crc8Maxim::calculate(f.data.u8, f.DLC); }));
+  printf("%-22s %12.1f %12.1f\n", "E2E profile 2",
+         ns_per_frame(frames, iterations, sink, [&](CAN_frame f) { return bitwise_profile2(f, data_ids); }),
+         ns_per_frame(frames, iterations, sink,
+                      [&](const CAN_frame& f) { return e2e_profile2_crc(f, f.DLC, data_ids); }));
+  printf("%-22s %12.1f %12.1f\n", "CRC-16/MODBUS",
+         ns_per_frame(frames, iterations, sink, [](CAN_frame f) { return bitwise_modbus(f); }),
+         ns_per_frame(frames, iterations, sink,
+                      [](const CAN_frame& f) { return Crc16Modbus::calculate(f.data.u8, f.DLC); }));
+  printf("mismatches: %d (checksum %u)\n", mismatches, sink);
+
+  return mismatches == 0 ? 0 : 1;
+}
@@ -0,0 +1,225 @@
+// Host benchmark of the compressed history, recording the values the battery integrations decode from the logs
+// of can_log_based/can_logs. Each log is replayed once per second of log time, followed by update_values() and
+// record_history() like on the device, for the requested number of seconds.
+//
+// The logs are a few frames each, so they give the values of a resting pack, which hardly change. For each
+// battery a second run adds a random walk to the current, voltage, SOC, temperatures and cells after
+// update_values(), as a pack in use would show.
+//
+// Reports bytes per sample (B), the ratio to storing the samples as they are (a 64 bit timestamp and 16 bit
+// values), ns per append, and the hours of history the budget of history.h holds.
+//
+// Usage: history_benchmark [--seconds N] [log directory]
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "../../Software/src/battery/BATTERIES.h"
+#include "../../Software/src/battery/CanBattery.h"
+#include "../../Software/src/datalayer/cell_array.h"
+#include "../../Software/src/datalayer/datalayer.h"
+#include "../../Software/src/datalayer/history.h"
+#include "../../Software/src/devboard/sdcard/can_log_format.h"
+#include "../../Software/src/devboard/utils/events.h"
+
+namespace fs = std::filesystem;
+
+void store_settings_equipment_stop(void) {}
+
+struct Result {
+  uint64_t pack_records = 0;
+  uint64_t pack_bytes = 0;
+  uint64_t cell_records = 0;
+  uint64_t cell_bytes = 0;
+  uint64_t cell_values = 0;
+  double pack_ns = 0;
+  double cell_ns = 0;
+};
+
+static std::vector<CAN_frame> load_log(const fs::path& path) {
+  std::vector<CAN_frame> frames;
+  std::ifstream file(path);
+  std::string line;
+  CAN_log_record record;
+
+  while (std::getline(file, line)) {
+    if (!can_log_parse_text(line.data(), line.size(), record)) {
+      continue;
+    }
+    CAN_frame frame = {};
+    frame.FD = (record.flags & CAN_LOG_FLAG_FD) != 0;
+    frame.ext_ID = (record.flags & CAN_LOG_FLAG_EXT_ID) != 0;
+    frame.DLC = record.dlc;
+    frame.ID = record.id;
+    memcpy(frame.data.u8, record.data, record.dlc);
+    frames.push_back(frame);
+  }
+  return frames;
+}
+
+static void setup(BatteryType type) {
+  datalayer = DataLayer();
+  reset_all_events();
+  if (battery) {
+    delete battery;
+    battery = nullptr;
+  }
+  user_selected_battery_type = type;
+  setup_battery();
+  clear_history();
+}
+
+struct PackWalk {
+  int32_t current_dA = 0;
+  int32_t cell_offset_mV = 0;
+  uint16_t cells_mV[MAX_AMOUNT_CELLS] = {};  // As decoded from the log
+};
+
+// A pack charging and discharging, with a little noise on the measurements. The cells follow the current
+// together, each measured with some noise of its own.
+static void walk(std::mt19937& random, PackWalk& state) {
+  DATALAYER_BATTERY_STATUS_TYPE& status = datalayer.battery.status;
+  auto step = [&](int range) { return (int)(random() % (2 * range + 1)) - range; };
+  auto now_and_then = [&](int seconds) { return random() % seconds == 0; };
+
+  state.current_dA = std::clamp<int32_t>(state.current_dA + step(20), -1500, 1500);
+  status.current_dA = state.current_dA;
+  status.voltage_dV += step(1);
+  if (now_and_then(20)) {
+    status.real_soc = std::clamp<int32_t>(status.real_soc + (state.current_dA > 0 ? 1 : -1), 0, 10000);
+    status.reported_soc = status.real_soc;
+  }
+  if (now_and_then(60)) {
+    status.temperature_min_dC += step(1);
+    status.temperature_max_dC += step(1);
+  }
+  if (now_and_then(20)) {
+    state.cell_offset_mV += state.current_dA > 0 ? 1 : -1;
+  }
+  uint16_t min_mV = UINT16_MAX, max_mV = 0;
+  for (uint16_t i = 0; i < datalayer.battery.info.number_of_cells && i < MAX_AMOUNT_CELLS; i++) {
+    if (state.cells_mV[i] == 0) {
+      state.cells_mV[i] = status.cell_voltages_mV[i] ? status.cell_voltages_mV[i] : 3700;
+    }
+    const int noise = now_and_then(10) ? step(1) : 0;
+    const uint16_t voltage = std::clamp<int32_t>(state.cells_mV[i] + state.cell_offset_mV + noise, 2500, 4300);
+    status.cell_voltages_mV[i] = voltage;
+    min_mV = std::min(min_mV, voltage);
+    max_mV = std::max(max_mV, voltage);
+  }
+  status.cell_min_voltage_mV = min_mV;
+  status.cell_max_voltage_mV = max_mV;
+}
+
+static Result run(const std::vector<CAN_frame>& log, uint64_t seconds, bool moving) {
+  using clock = std::chrono::steady_clock;
+  CanBattery* can_battery = dynamic_cast<CanBattery*>(battery);
+  std::mt19937 random(1);
+  PackWalk state;
+  clock::duration pack_time{};
+  clock::duration cell_time{};
+  uint64_t cell_calls = 0;
+  const TimeSeriesStats pack_start = pack_history.stats();
+  const TimeSeriesStats cell_start = cell_history.stats();
+
+  for (uint64_t second = 1; second <= seconds; second++) {
+    set_millis64(second * 1000);
+    for (const CAN_frame& frame : log) {
+      can_battery->handle_incoming_can_frame(frame);
+    }
+    can_battery->update_values();
+    publish_cell_statistics(second * 1000);
+    if (moving) {
+      walk(random, state);
+    }
+
+    const uint32_t cell_records = cell_history.stats().records;
+    const auto start = clock::now();
+    record_history(second * 1000);
+    const clock::duration elapsed = clock::now() - start;
+    if (cell_history.stats().records != cell_records) {
+      cell_time += elapsed;
+      cell_calls++;
+    } else {
+      pack_time += elapsed;
+    }
+  }
+
+  Result result;
+  result.pack_records = pack_history.stats().records - pack_start.records;
+  result.pack_bytes = pack_history.stats().bytes - pack_start.bytes;
+  result.cell_records = cell_history.stats().records - cell_start.records;
+  result.cell_bytes = cell_history.stats().bytes - cell_start.bytes;
+  result.cell_values = std::min<uint16_t>(datalayer.battery.info.number_of_cells, MAX_AMOUNT_CELLS);
+  result.pack_ns = std::chrono::duration<double, std::nano>(pack_time).count() / (seconds - cell_calls);
+  // The calls recording the cells also record the pack
+  result.cell_ns =
+      cell_calls ? std::chrono::duration<double, std::nano>(cell_time).count() / cell_calls - result.pack_ns : 0;
+  return result;
+}
+
+static void print(const char* name, const char* values, const Result& r) {
+  const double pack_sample = r.pack_records ? (double)r.pack_bytes / r.pack_records : 0;
+  const double cell_sample = r.cell_records ? (double)r.cell_bytes / r.cell_records : 0;
+  printf("%-22.22s %-6s %10.2f %7.1f %9.0f %10.1f %7.1f %9.0f %8.1f %8.1f\n", name, values, pack_sample,
+         pack_sample ? (8 + 2.0 * HISTORY_PACK_CHANNEL_COUNT) / pack_sample : 0, r.pack_ns, cell_sample,
+         cell_sample ? (8 + 2.0 * r.cell_values) / cell_sample : 0, r.cell_ns,
+         pack_sample ? HISTORY_PACK_BYTES / pack_sample / 3600 : 0,
+         cell_sample ? HISTORY_CELL_BYTES / cell_sample * HISTORY_CELL_INTERVAL_MS / 3600000 : 0);
+}
+
+int main(int argc, char** argv) {
+  uint64_t seconds = 24 * 3600;
+  fs::path directory = "../can_log_based/can_logs";
+
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--seconds") == 0 && i + 1 < argc) {
+      seconds = std::max<uint64_t>(strtoull(argv[++i], nullptr, 10), 1);
+    } else {
+      directory = argv[i];
+    }
+  }
+
+  std::vector<fs::path> paths;
+  for (const auto& entry : fs::directory_iterator(directory)) {
+    if (entry.is_regular_file() && entry.path().extension() == ".txt") {
+      paths.push_back(entry.path());
+    }
+  }
+  std::sort(paths.begin(), paths.end());
+
+  printf("%-22s %-6s %10s %7s %9s %10s %7s %9s %8s %8s\n", "log", "values", "pack B", "ratio", "ns/append",
+         "cells B", "ratio", "ns/append", "pack h", "cells h");
+  int runs = 0;
+  for (const fs::path& path : paths) {
+    // Same naming as for the log based tests, <battery_type>_<battery class name>_<flags>.txt
+    const std::string name = path.filename().string();
+    const std::vector<CAN_frame> log = load_log(path);
+    if (log.empty()) {
+      fprintf(stderr, "No frames in %s\n", name.c_str());
+      continue;
+    }
+    for (bool moving : {false, true}) {
+      setup((BatteryType)atoi(name.c_str()));
+      if (!dynamic_cast<CanBattery*>(battery)) {
+        fprintf(stderr, "%s is not a CAN battery\n", name.c_str());
+        break;
+      }
+      print(path.stem().string().c_str(), moving ? "walk" : "log", run(log, seconds, moving));
+      runs++;
+    }
+  }
+  if (battery) {
+    delete battery;
+    battery = nullptr;
+  }
+  return runs > 0 ? 0 : 1;
+}
@@ -0,0 +1,122 @@
+// Host benchmark of Modbus request handling, through the same worker dispatch ModbusServerRTU uses for
+// requests received on RS485. Compares the register bank of ModbusInverterProtocol with a std::map based
+// register file, for the polling pattern of a BYD Modbus inverter and for a client scanning the address space.
+//
+// Usage: modbus_benchmark [iterations]
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+
+#include "../../Software/src/inverter/ModbusInverterProtocol.h"
+
+static const uint8_t SERVER_ID = 21;
+
+// Same register windows as BydModbusInverter
+class BankInverter : public ModbusInverterProtocol {
+ public:
+  BankInverter() : ModbusInverterProtocol(SERVER_ID) {
+    mbPV.add_window(100, 68);
+    mbPV.add_window(200, 13);
+    mbPV.add_window(300, 24);
+    mbPV.add_window(400, 100);
+  }
+  const char* name() override { return "bank"; }
+  void update_values() override {}
+  ModbusMessage request(ModbusMessage msg) { return MBserver.localRequest(msg); }
+};
+
+// Register file as a std::map, one lookup per register and a new node for every address accessed
+class MapInverter {
+ public:
+  MapInverter() : server(2000) {
+    server.registerWorker(SERVER_ID, READ_HOLD_REGISTER, [this](ModbusMessage request) -> ModbusMessage {
+      ModbusMessage response;
+      uint16_t addr = 0;
+      uint16_t words = 0;
+      request.get(2, addr, words);
+      response.add(request.getServerID(), request.getFunctionCode(), (uint8_t)(words * 2));
+      for (uint16_t i = 0; i < words; ++i) {
+        response.add((uint16_t)registers[addr + i]);
+      }
+      return response;
+    });
+    server.registerWorker(SERVER_ID, WRITE_MULT_REGISTERS, [this](ModbusMessage request) -> ModbusMessage {
+      ModbusMessage response;
+      uint16_t addr = 0;
+      uint16_t words = 0;
+      uint16_t val = 0;
+      request.get(2, addr, words);
+      for (uint16_t i = 0; i < words; ++i) {
+        request.get(7 + (i * 2), val);
+        registers[addr + i] = val;
+      }
+      response.add(request.getServerID(), request.getFunctionCode(), addr, words);
+      return response;
+    });
+  }
+  ModbusMessage request(ModbusMessage msg) { return server.localRequest(msg); }
+  size_t size() const { return registers.size(); }
+
+ private:
+  ModbusServerRTU server;
+  std::map<uint16_t, uint16_t> registers;
+};
+
+static ModbusMessage read_request(uint16_t addr, uint16_t words) {
+  ModbusMessage msg;
+  msg.add(SERVER_ID, (uint8_t)READ_HOLD_REGISTER, addr, words);
+  return msg;
+}
+
+// One polling cycle of the inverter: read all blocks, then write the heartbeat register
+static const ModbusMessage poll_cycle[] = {
+    read_request(100, 68),
+    read_request(200, 13),
+    read_request(300, 24),
+    [] {
+      ModbusMessage msg;
+      msg.add(SERVER_ID, (uint8_t)WRITE_MULT_REGISTERS, (uint16_t)401, (uint16_t)1, (uint8_t)2, (uint16_t)0x00FF);
+      return msg;
+    }(),
+};
+
+template <typename Inverter>
+static void run(const char* name, Inverter& inverter, int iterations, bool scan) {
+  size_t response_bytes = 0;
+  int requests = 0;
+  auto start = std::chrono::steady_clock::now();
+
+  for (int i = 0; i < iterations; i++) {
+    if (scan) {
+      // Client probing the address space in blocks of 100 registers
+      response_bytes += inverter.request(read_request((i * 100) % 30000, 100)).size();
+      requests++;
+    } else {
+      for (const ModbusMessage& msg : poll_cycle) {
+        response_bytes += inverter.request(msg).size();
+        requests++;
+      }
+    }
+  }
+
+  double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  printf("%-6s %-5s %9d requests %10.0f requests/s %8.2f us/request (%zu response bytes)\n", name,
+         scan ? "scan" : "poll", requests, requests / seconds, seconds * 1e6 / requests, response_bytes);
+}
+
+int main(int argc, char** argv) {
+  int iterations = argc > 1 ? atoi(argv[1]) : 100000;
+
+  BankInverter bank;
+  MapInverter map;
+
+  run("bank", bank, iterations, false);
+  run("map", map, iterations, false);
+  run("bank", bank, iterations, true);
+  run("map", map, iterations, true);
+  printf("std::map register file grew to %zu registers\n", map.size());
+
+  return 0;
+}
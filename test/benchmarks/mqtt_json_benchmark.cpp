@@ -0,0 +1,276 @@
+// Host benchmark of building the MQTT payloads: with a JSON document and String keys as the MQTT code did before,
+// and with the JSON writer. Reports time and heap allocations per payload, for the common info of two batteries and
+// the cell voltages of a 192 cell pack, and checks that both give the same values.
+//
+// Usage: mqtt_json_benchmark [iterations]
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <string>
+
+#include "../../Software/src/devboard/utils/json_writer.h"
+#include "../../Software/src/lib/bblanchon-ArduinoJson/ArduinoJson.h"
+
+static size_t allocations = 0;
+
+void* operator new(size_t size) {
+  allocations++;
+  if (void* p = malloc(size)) {
+    return p;
+  }
+  throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept {
+  free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+  free(p);
+}
+
+// The JSON documents allocate through malloc, count them too
+struct CountingAllocator : ArduinoJson::Allocator {
+  void* allocate(size_t size) override {
+    allocations++;
+    return malloc(size);
+  }
+  void deallocate(void* p) override { free(p); }
+  void* reallocate(void* p, size_t size) override {
+    allocations++;
+    return realloc(p, size);
+  }
+};
+static CountingAllocator counting_allocator;
+
+static const int CELLS = 192;
+static const size_t OLD_BUFFER_SIZE = 1024;
+static const size_t NEW_BUFFER_SIZE = CELLS * 8 + 512;
+
+struct Battery {
+  uint16_t reported_soc, real_soc, soh_pptt, voltage_dV, cell_max_voltage_mV, cell_min_voltage_mV;
+  int16_t temperature_min_dC, temperature_max_dC, current_dA;
+  int32_t active_power_W, total_charged_battery_Wh, total_discharged_battery_Wh;
+  uint32_t total_capacity_Wh, remaining_capacity_Wh, reported_remaining_capacity_Wh, max_discharge_power_W,
+      max_charge_power_W;
+  uint16_t cell_voltages_mV[CELLS];
+  bool cell_balancing_status[CELLS];
+};
+
+static const float cpu_temperature = 41.5f;
+
+// As before, with std::string standing in for the Arduino String keys (same temporary per key)
+static void set_battery_attributes(JsonDocument& doc, const Battery& battery, const std::string& suffix) {
+  doc["SOC" + suffix] = ((float)battery.reported_soc) / 100.0f;
+  doc["SOC_real" + suffix] = ((float)battery.real_soc) / 100.0f;
+  doc["state_of_health" + suffix] = ((float)battery.soh_pptt) / 100.0f;
+  doc["temperature_min" + suffix] = ((float)((int16_t)battery.temperature_min_dC)) / 10.0f;
+  doc["temperature_max" + suffix] = ((float)((int16_t)battery.temperature_max_dC)) / 10.0f;
+  doc["cpu_temp" + suffix] = cpu_temperature;
+  doc["stat_batt_power" + suffix] = ((float)((int32_t)battery.active_power_W));
+  doc["battery_current" + suffix] = ((float)((int16_t)battery.current_dA)) / 10.0f;
+  doc["battery_voltage" + suffix] = ((float)battery.voltage_dV) / 10.0f;
+  doc["cell_max_voltage" + suffix] = ((float)battery.cell_max_voltage_mV) / 1000.0f;
+  doc["cell_min_voltage" + suffix] = ((float)battery.cell_min_voltage_mV) / 1000.0f;
+  doc["cell_voltage_delta" + suffix] = ((float)battery.cell_max_voltage_mV) - ((float)battery.cell_min_voltage_mV);
+  doc["total_capacity" + suffix] = ((float)battery.total_capacity_Wh);
+  doc["remaining_capacity_real" + suffix] = ((float)battery.remaining_capacity_Wh);
+  doc["remaining_capacity" + suffix] = ((float)battery.reported_remaining_capacity_Wh);
+  doc["max_discharge_power" + suffix] = ((float)battery.max_discharge_power_W);
+  doc["max_charge_power" + suffix] = ((float)battery.max_charge_power_W);
+  doc["charged_energy" + suffix] = ((float)battery.total_charged_battery_Wh);
+  doc["discharged_energy" + suffix] = ((float)battery.total_discharged_battery_Wh);
+  uint16_t active_cells = 0;
+  for (int i = 0; i < CELLS; ++i) {
+    active_cells += battery.cell_balancing_status[i];
+  }
+  doc["balancing_active_cells" + suffix] = active_cells;
+  doc["balancing_status" + suffix] = "Active";
+}
+
+static void add_battery_attributes(JsonWriter& json, const Battery& battery, const char* suffix) {
+  json.add_fixed("SOC", suffix, battery.reported_soc, 2);
+  json.add_fixed("SOC_real", suffix, battery.real_soc, 2);
+  json.add_fixed("state_of_health", suffix, battery.soh_pptt, 2);
+  json.add_fixed("temperature_min", suffix, battery.temperature_min_dC, 1);
+  json.add_fixed("temperature_max", suffix, battery.temperature_max_dC, 1);
+  json.add_float("cpu_temp", suffix, cpu_temperature, 1);
+  json.add("stat_batt_power", suffix, battery.active_power_W);
+  json.add_fixed("battery_current", suffix, battery.current_dA, 1);
+  json.add_fixed("battery_voltage", suffix, battery.voltage_dV, 1);
+  json.add_fixed("cell_max_voltage", suffix, battery.cell_max_voltage_mV, 3);
+  json.add_fixed("cell_min_voltage", suffix, battery.cell_min_voltage_mV, 3);
+  json.add("cell_voltage_delta", suffix, (int32_t)battery.cell_max_voltage_mV - (int32_t)battery.cell_min_voltage_mV);
+  json.add_unsigned("total_capacity", suffix, battery.total_capacity_Wh);
+  json.add_unsigned("remaining_capacity_real", suffix, battery.remaining_capacity_Wh);
+  json.add_unsigned("remaining_capacity", suffix, battery.reported_remaining_capacity_Wh);
+  json.add_unsigned("max_discharge_power", suffix, battery.max_discharge_power_W);
+  json.add_unsigned("max_charge_power", suffix, battery.max_charge_power_W);
+  json.add("charged_energy", suffix, battery.total_charged_battery_Wh);
+  json.add("discharged_energy", suffix, battery.total_discharged_battery_Wh);
+  uint16_t active_cells = 0;
+  for (int i = 0; i < CELLS; ++i) {
+    active_cells += battery.cell_balancing_status[i];
+  }
+  json.add("balancing_active_cells", suffix, active_cells);
+  json.add_string("balancing_status", suffix, "Active");
+}
+
+static size_t info_before(const Battery* batteries, char* buffer, size_t size) {
+  static JsonDocument doc(&counting_allocator);
+  doc["bms_status"] = "ACTIVE";
+  set_battery_attributes(doc, batteries[0], "");
+  set_battery_attributes(doc, batteries[1], "_2");
+  doc["event_level"] = "INFO";
+  size_t length = serializeJson(doc, buffer, size);
+  doc.clear();
+  return length;
+}
+
+static size_t info_after(const Battery* batteries, char* buffer, size_t size) {
+  JsonWriter json(buffer, size);
+  json.begin_object();
+  json.add_string("bms_status", "ACTIVE");
+  add_battery_attributes(json, batteries[0], nullptr);
+  add_battery_attributes(json, batteries[1], "_2");
+  json.add_string("event_level", "INFO");
+  json.end_object();
+  return json.overflowed() ? 0 : json.length();
+}
+
+static size_t cells_before(const Battery* batteries, char* buffer, size_t size) {
+  static JsonDocument doc(&counting_allocator);
+  JsonArray cell_voltages = doc["cell_voltages"].to<JsonArray>();
+  for (int i = 0; i < CELLS; ++i) {
+    cell_voltages.add(((float)batteries[0].cell_voltages_mV[i]) / 1000.0f);
+  }
+  size_t length = serializeJson(doc, buffer, size);
+  doc.clear();
+  return length;
+}
+
+static size_t cells_after(const Battery* batteries, char* buffer, size_t size) {
+  JsonWriter json(buffer, size);
+  json.begin_object();
+  json.begin_array("cell_voltages");
+  for (int i = 0; i < CELLS; ++i) {
+    json.element_fixed(batteries[0].cell_voltages_mV[i], 3);
+  }
+  json.end_array();
+  json.end_object();
+  return json.overflowed() ? 0 : json.length();
+}
+
+static size_t cells_compact(const Battery* batteries, char* buffer, size_t size) {
+  JsonWriter json(buffer, size);
+  uint16_t min_mV = batteries[0].cell_voltages_mV[0];
+  for (int i = 1; i < CELLS; ++i) {
+    min_mV = std::min(min_mV, batteries[0].cell_voltages_mV[i]);
+  }
+  json.begin_object();
+  json.add("cell_min_mV", min_mV);
+  json.begin_array("cell_offsets_mV");
+  for (int i = 0; i < CELLS; ++i) {
+    json.element(batteries[0].cell_voltages_mV[i] - min_mV);
+  }
+  json.end_array();
+  json.end_object();
+  return json.overflowed() ? 0 : json.length();
+}
+
+// Compares the values of two payloads, numbers within float precision
+static bool same_values(JsonVariantConst a, JsonVariantConst b) {
+  if (a.is<JsonObjectConst>()) {
+    if (!b.is<JsonObjectConst>() || a.size() != b.size()) {
+      return false;
+    }
+    for (JsonPairConst pair : a.as<JsonObjectConst>()) {
+      if (!same_values(pair.value(), b[pair.key()])) {
+        return false;
+      }
+    }
+    return true;
+  }
+  if (a.is<JsonArrayConst>()) {
+    if (!b.is<JsonArrayConst>() || a.size() != b.size()) {
+      return false;
+    }
+    for (size_t i = 0; i < a.size(); i++) {
+      if (!same_values(a[i], b[i])) {
+        return false;
+      }
+    }
+    return true;
+  }
+  if (a.is<double>()) {
+    const double x = a.as<double>();
+    return b.is<double>() && std::fabs(x - b.as<double>()) <= 1e-3 * std::max(1.0, std::fabs(x));
+  }
+  return a == b;
+}
+
+typedef size_t (*Build)(const Battery*, char*, size_t);
+
+static void measure(const char* name, Build build, size_t size, const Battery* batteries, int iterations) {
+  static char buffer[NEW_BUFFER_SIZE];
+  build(batteries, buffer, size);  // Warm up, the documents keep their pools
+  const size_t before = allocations;
+  size_t length = 0;
+  auto start = std::chrono::steady_clock::now();
+  for (int it = 0; it < iterations; ++it) {
+    length = build(batteries, buffer, size);
+  }
+  std::chrono::duration<double, std::micro> elapsed = std::chrono::steady_clock::now() - start;
+  printf("%-28s %10.2f %14.1f %10zu\n", name, elapsed.count() / iterations,
+         (double)(allocations - before) / iterations, length);
+}
+
+int main(int argc, char** argv) {
+  const int iterations = argc > 1 ? atoi(argv[1]) : 20000;
+
+  static Battery batteries[2];
+  srand(1);
+  for (Battery& b : batteries) {
+    b = {5123, 5087, 9800, 3712, 3412, 3398, -15, 231, -125, -4640, 1234567, 1200345, 77000, 39000, 38000, 10000,
+         9000};
+    for (int i = 0; i < CELLS; ++i) {
+      b.cell_voltages_mV[i] = 3390 + rand() % 25;
+      b.cell_balancing_status[i] = rand() % 4 == 0;
+    }
+  }
+
+  // Same values both ways, given room for the whole payload
+  int mismatches = 0;
+  static char before[4096];
+  static char after[4096];
+  JsonDocument a, b;
+  info_before(batteries, before, sizeof(before));
+  info_after(batteries, after, sizeof(after));
+  deserializeJson(a, before);
+  deserializeJson(b, after);
+  mismatches += !same_values(a, b);
+  cells_before(batteries, before, sizeof(before));
+  cells_after(batteries, after, sizeof(after));
+  deserializeJson(a, before);
+  deserializeJson(b, after);
+  mismatches += !same_values(a, b);
+
+  // What fitted in the shared buffer before
+  const bool info_fits = info_before(batteries, before, OLD_BUFFER_SIZE) < OLD_BUFFER_SIZE - 1;
+  const bool cells_fit = cells_before(batteries, before, OLD_BUFFER_SIZE) < OLD_BUFFER_SIZE - 1;
+
+  printf("%-28s %10s %14s %10s\n", "payload", "us", "allocations", "bytes");
+  measure("info, document", info_before, OLD_BUFFER_SIZE, batteries, iterations);
+  measure("info, writer", info_after, NEW_BUFFER_SIZE, batteries, iterations);
+  measure("cell voltages, document", cells_before, OLD_BUFFER_SIZE, batteries, iterations);
+  measure("cell voltages, writer", cells_after, NEW_BUFFER_SIZE, batteries, iterations);
+  measure("cell voltages, compact", cells_compact, NEW_BUFFER_SIZE, batteries, iterations);
+  printf("in %zu bytes before: info of two batteries %s, %d cell voltages %s\n", OLD_BUFFER_SIZE,
+         info_fits ? "complete" : "cut off", CELLS, cells_fit ? "complete" : "cut off");
+  printf("mismatches: %d\n", mismatches);
+
+  return mismatches == 0 ? 0 : 1;
+}
@@ -0,0 +1,55 @@
+// Host benchmark of the aggregation of 1 to 8 battery packs into the one battery the inverter sees, run once per
+// second by the core task after update_values of all batteries.
+//
+// Usage: pack_benchmark [iterations]
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+#include "../../Software/src/datalayer/pack_array.h"
+
+// Normally defined in Software.cpp, which is not part of the firmware library
+void store_settings_equipment_stop(void) {}
+
+int main(int argc, char** argv) {
+  const int iterations = argc > 1 ? atoi(argv[1]) : 200000;
+  static DATALAYER_BATTERY_TYPE batteries[MAX_PACKS];
+  bool allowed[MAX_PACKS] = {};
+  PackArray packs;
+
+  srand(1);
+  unsigned sink = 0;
+  printf("%-6s %12s %8s\n", "packs", "ns/update", "joined");
+  for (uint8_t count = 1; count <= MAX_PACKS; count++) {
+    packs.clear();
+    for (uint8_t i = 0; i < count; i++) {
+      DATALAYER_BATTERY_TYPE& battery = batteries[i];
+      battery.status.bms_status = ACTIVE;
+      battery.status.voltage_dV = 3700 + rand() % 10;
+      battery.status.real_soc = 1000 + rand() % 8000;
+      battery.status.max_charge_power_W = 5000 + rand() % 5000;
+      battery.status.max_discharge_power_W = 5000 + rand() % 5000;
+      battery.info.total_capacity_Wh = 20000 + rand() % 40000;
+      battery.status.remaining_capacity_Wh = battery.info.total_capacity_Wh * battery.status.real_soc / 10000;
+      battery.settings.max_user_set_charge_dA = 10000;
+      battery.settings.max_user_set_discharge_dA = 10000;
+      battery.settings.soc_scaling_active = true;
+      battery.settings.min_percentage = 500;
+      battery.settings.max_percentage = 9500;
+      packs.add(battery, i == 0 ? nullptr : &allowed[i]);
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    for (int n = 0; n < iterations; ++n) {
+      batteries[n % count].status.current_dA = n % 200 - 100;
+      packs.update();
+      sink += batteries[0].status.reported_soc;
+    }
+    std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+    printf("%-6u %12.1f %8u\n", count, elapsed.count() / iterations, packs.totals().joined);
+  }
+  printf("checksum %u\n", sink);
+
+  return 0;
+}
@@ -0,0 +1,172 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+#include "../Software/src/devboard/sdcard/can_log_format.h"
+
+TEST(CanLogFormatTests, ClassicFrameRecordIs24Bytes) {
+  CAN_frame frame = {.FD = false, .ext_ID = false, .DLC = 8, .ID = 0x1DB, .data = {.u8 = {1, 2, 3, 4, 5, 6, 7, 8}}};
+  CAN_log_record record;
+
+  EXPECT_EQ(can_log_encode(frame, CAN_NATIVE, MSG_RX, 0, record), 24u);
+  EXPECT_EQ(can_log_record_size(0), 16u);
+  EXPECT_EQ(can_log_record_size(64), 80u);
+}
+
+TEST(CanLogFormatTests, RecordSurvivesEncodeAndDecode) {
+  CAN_frame frame = {.FD = true, .ext_ID = true, .DLC = 12, .ID = 0x18DAF105, .data = {.u8 = {0xAA}}};
+  frame.data.u8[11] = 0x55;
+  CAN_log_record record;
+  size_t size = can_log_encode(frame, CANFD_ADDON_MCP2518, MSG_TX, 1234567890123ULL, record);
+
+  CAN_log_record decoded;
+  EXPECT_EQ(can_log_decode((const uint8_t*)&record, size - 1, decoded), 0u);
+  ASSERT_EQ(can_log_decode((const uint8_t*)&record, size, decoded), size);
+  EXPECT_EQ(decoded.timestamp_us, 1234567890123ULL);
+  EXPECT_EQ(decoded.id, 0x18DAF105u);
+  EXPECT_EQ(decoded.interface, CANFD_ADDON_MCP2518);
+  EXPECT_EQ(decoded.direction, MSG_TX);
+  EXPECT_EQ(decoded.flags, CAN_LOG_FLAG_EXT_ID | CAN_LOG_FLAG_FD);
+  EXPECT_EQ(decoded.dlc, 12);
+  EXPECT_EQ(decoded.data[0], 0xAA);
+  EXPECT_EQ(decoded.data[11], 0x55);
+}
+
+TEST(CanLogFormatTests, InvalidRecordIsRejected) {
+  CAN_log_record record = {};
+  record.dlc = 65;
+
+  EXPECT_EQ(can_log_decode((const uint8_t*)&record, sizeof(record), record), SIZE_MAX);
+}
+
+TEST(CanLogFormatTests, TextMatchesCandumpFormatWithInterfaceTags) {
+  CAN_frame frame = {.DLC = 3, .ID = 0x1DB, .data = {.u8 = {0x00, 0xAB, 0x0F}}};
+  CAN_log_record record;
+  char line[CAN_LOG_MAX_TEXT_LINE];
+
+  can_log_encode(frame, CAN_NATIVE, MSG_RX, 12345678, record);
+  can_log_format_text(record, line, sizeof(line));
+  EXPECT_STREQ(line, "(12.345678) RX0 1DB [3] 00 AB 0F\n");
+
+  can_log_encode(frame, CAN_ADDON_MCP2515, MSG_TX, 1000, record);
+  can_log_format_text(record, line, sizeof(line));
+  EXPECT_STREQ(line, "(0.001000) TX5 1DB [3] 00 AB 0F\n");
+
+  frame.DLC = 0;
+  can_log_encode(frame, CAN_ADDON_MCP2515, MSG_RX, 0, record);
+  can_log_format_text(record, line, sizeof(line));
+  EXPECT_STREQ(line, "(0.000000) RX4 1DB [0]\n");
+}
+
+TEST(CanLogFormatTests, ExtendedIdIsPaddedToEightDigits) {
+  CAN_frame frame = {.ext_ID = true, .DLC = 1, .ID = 0x123, .data = {.u8 = {0x42}}};
+  CAN_log_record record;
+  char line[CAN_LOG_MAX_TEXT_LINE];
+
+  can_log_encode(frame, CAN_NATIVE, MSG_RX, 0, record);
+  can_log_format_text(record, line, sizeof(line));
+  EXPECT_STREQ(line, "(0.000000) RX0 00000123 [1] 42\n");
+}
+
+TEST(CanLogFormatTests, ParsesWebserverLogLine) {
+  const char* line = "(12.345) RX0 7ef [8] 00 00 00 08 81 34 ee ee";
+  CAN_log_record record;
+
+  ASSERT_TRUE(can_log_parse_text(line, strlen(line), record));
+  EXPECT_EQ(record.timestamp_us, 12345000u);
+  EXPECT_EQ(record.interface, CAN_NATIVE);
+  EXPECT_EQ(record.direction, MSG_RX);
+  EXPECT_EQ(record.id, 0x7EFu);
+  EXPECT_EQ(record.flags, 0);
+  EXPECT_EQ(record.dlc, 8);
+  EXPECT_EQ(record.data[4], 0x81);
+  EXPECT_EQ(record.data[7], 0xEE);
+}
+
+TEST(CanLogFormatTests, ParsesInterfaceTagAndIdType) {
+  const char* tx_line = "(1.000001) TX5 00000123 [0]";
+  const char* other_tag = "(1.5) can0 18DAF105 [12] 01 02 03 04 05 06 07 08 09 0A 0B 0C";
+  CAN_log_record record;
+
+  ASSERT_TRUE(can_log_parse_text(tx_line, strlen(tx_line), record));
+  EXPECT_EQ(record.timestamp_us, 1000001u);
+  EXPECT_EQ(record.interface, CAN_ADDON_MCP2515);
+  EXPECT_EQ(record.direction, MSG_TX);
+  EXPECT_EQ(record.id, 0x123u);
+  EXPECT_EQ(record.flags, CAN_LOG_FLAG_EXT_ID);
+
+  ASSERT_TRUE(can_log_parse_text(other_tag, strlen(other_tag), record));
+  EXPECT_EQ(record.interface, CAN_NATIVE);
+  EXPECT_EQ(record.flags, CAN_LOG_FLAG_EXT_ID | CAN_LOG_FLAG_FD);
+  EXPECT_EQ(record.data[11], 0x0C);
+}
+
+TEST(CanLogFormatTests, RejectsLinesThatAreNotFrames) {
+  const char* lines[] = {"", "# lowest cell", "(1.0) RX0 1DB [8] 00 11", "(1.0) RX0 [8]", "1DB [0]"};
+  CAN_log_record record;
+
+  for (const char* line : lines) {
+    EXPECT_FALSE(can_log_parse_text(line, strlen(line), record)) << line;
+  }
+}
+
+TEST(CanLogFormatTests, TextSurvivesFormatAndParse) {
+  CAN_frame frame = {.FD = true, .ext_ID = false, .DLC = 16, .ID = 0x7FF, .data = {.u8 = {0xDE, 0xAD}}};
+  CAN_log_record record;
+  CAN_log_record parsed;
+  char line[CAN_LOG_MAX_TEXT_LINE];
+
+  can_log_encode(frame, CANFD_ADDON_MCP2518, MSG_TX, 987654321, record);
+  size_t length = can_log_format_text(record, line, sizeof(line));
+
+  ASSERT_TRUE(can_log_parse_text(line, length, parsed));
+  EXPECT_EQ(memcmp(&record, &parsed, can_log_record_size(record.dlc)), 0);
+}
+
+TEST(CanLogFormatTests, ParserHandlesTextLogInSmallChunks) {
+  const char* log = "# comment\n(0.001) RX0 7ef [2] 01 02\r\n(0.002) RX0 bad line\n(0.0035) TX1 123 [1] FF";
+  std::vector<uint8_t> records;
+  CanLogParser parser;
+  parser.reset();
+
+  for (size_t i = 0; i < strlen(log); i += 3) {
+    ASSERT_TRUE(parser.feed((const uint8_t*)log + i, std::min<size_t>(3, strlen(log) - i), records, 1024));
+  }
+  ASSERT_TRUE(parser.finish(records, 1024));
+
+  ASSERT_EQ(records.size(), 48u);
+  EXPECT_EQ(parser.skipped(), 1u);
+  CAN_log_record record;
+  can_log_decode(records.data() + 24, 24, record);
+  EXPECT_EQ(record.timestamp_us, 3500u);
+  EXPECT_EQ(record.direction, MSG_TX);
+  EXPECT_EQ(record.data[0], 0xFF);
+}
+
+TEST(CanLogFormatTests, ParserHandlesBinaryLogAndSizeLimit) {
+  std::vector<uint8_t> log(CAN_LOG_MAGIC, CAN_LOG_MAGIC + CAN_LOG_MAGIC_SIZE);
+  CAN_log_record record;
+  for (uint32_t i = 0; i < 10; i++) {
+    CAN_frame frame = {.DLC = (uint8_t)(i % 9), .ID = 0x100 + i, .data = {.u8 = {(uint8_t)i}}};
+    size_t size = can_log_encode(frame, CAN_NATIVE, MSG_RX, i * 1000, record);
+    log.insert(log.end(), (uint8_t*)&record, (uint8_t*)&record + size);
+  }
+
+  std::vector<uint8_t> records;
+  CanLogParser parser;
+  parser.reset();
+  for (size_t i = 0; i < log.size(); i += 5) {
+    ASSERT_TRUE(parser.feed(log.data() + i, std::min<size_t>(5, log.size() - i), records, 1024));
+  }
+  ASSERT_TRUE(parser.finish(records, 1024));
+  EXPECT_EQ(records.size(), log.size() - CAN_LOG_MAGIC_SIZE);
+  EXPECT_EQ(memcmp(records.data(), log.data() + CAN_LOG_MAGIC_SIZE, records.size()), 0);
+  EXPECT_EQ(parser.skipped(), 0u);
+
+  records.clear();
+  parser.reset();
+  EXPECT_FALSE(parser.feed(log.data(), log.size(), records, 100));
+  EXPECT_LE(records.size(), 100u);
+}
@@ -0,0 +1,36 @@
+#include <gtest/gtest.h>
+
+#include "../Software/src/communication/can/CanReceiver.h"
+
+TEST(CanIdFilterTests, DefaultFilterAcceptsEverything) {
+  CanIdFilter filter;
+
+  EXPECT_TRUE(filter.accepts(0x000, false));
+  EXPECT_TRUE(filter.accepts(0x7FF, false));
+  EXPECT_TRUE(filter.accepts(0x18DAF105, true));
+}
+
+TEST(CanIdFilterTests, RangeFilterRejectsIdsOutsideRange) {
+  CanIdFilter filter = {.min_id = 0x200, .max_id = 0x220};
+
+  EXPECT_FALSE(filter.accepts(0x1FF, false));
+  EXPECT_TRUE(filter.accepts(0x200, false));
+  EXPECT_TRUE(filter.accepts(0x210, false));
+  EXPECT_TRUE(filter.accepts(0x220, false));
+  EXPECT_FALSE(filter.accepts(0x221, false));
+}
+
+TEST(CanIdFilterTests, BitmapFilterOnlyAcceptsMarkedStandardIds) {
+  static uint8_t bitmap[CAN_ID_BITMAP_BYTES] = {0};
+  bitmap[0x360 >> 3] |= 1 << (0x360 & 7);
+  bitmap[0x5E7 >> 3] |= 1 << (0x5E7 & 7);
+
+  CanIdFilter filter = {.std_id_bitmap = bitmap};
+
+  EXPECT_TRUE(filter.accepts(0x360, false));
+  EXPECT_TRUE(filter.accepts(0x5E7, false));
+  EXPECT_FALSE(filter.accepts(0x361, false));
+  EXPECT_FALSE(filter.accepts(0x5E0, false));
+  // The bitmap only covers standard IDs, extended IDs are subject to the range alone
+  EXPECT_TRUE(filter.accepts(0x360, true));
+}
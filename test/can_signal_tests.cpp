@@ -0,0 +1,127 @@
+#include <gtest/gtest.h>
+
+#include "../Software/src/devboard/utils/can_signal.h"
+
+static CAN_frame empty_frame() {
+  return {.FD = false, .ext_ID = false, .DLC = 8, .ID = 0x100, .data = {.u8 = {0}}};
+}
+
+TEST(CanSignalTests, ByteAlignedBigEndian) {
+  CAN_frame frame = empty_frame();
+  CanFieldBE<2>::pack(frame, 0x1234);
+  CanFieldBE<4, 4>::pack(frame, 0xA1B2C3D4);
+
+  EXPECT_EQ(frame.data.u8[2], 0x12);
+  EXPECT_EQ(frame.data.u8[3], 0x34);
+  EXPECT_EQ(frame.data.u8[4], 0xA1);
+  EXPECT_EQ(frame.data.u8[7], 0xD4);
+  EXPECT_EQ(CanFieldBE<2>::unpack(frame), 0x1234);
+  EXPECT_EQ((CanFieldBE<4, 4>::unpack(frame)), 0xA1B2C3D4);
+}
+
+TEST(CanSignalTests, ByteAlignedLittleEndian) {
+  CAN_frame frame = empty_frame();
+  CanFieldLE<1>::pack(frame, 0x1234);
+
+  EXPECT_EQ(frame.data.u8[0], 0x00);
+  EXPECT_EQ(frame.data.u8[1], 0x34);
+  EXPECT_EQ(frame.data.u8[2], 0x12);
+  EXPECT_EQ(CanFieldLE<1>::unpack(frame), 0x1234);
+}
+
+TEST(CanSignalTests, IntelSignalAcrossBytes) {
+  // 12 bits from bit 4: low nibble in the top of byte 0, the rest in byte 1
+  using Signal = CanSignal<4, 12, CanByteOrder::LittleEndian>;
+  CAN_frame frame = empty_frame();
+  frame.data.u8[0] = 0x0F;
+  Signal::pack(frame, 0xABC);
+
+  EXPECT_EQ(frame.data.u8[0], 0xCF);
+  EXPECT_EQ(frame.data.u8[1], 0xAB);
+  EXPECT_EQ(Signal::unpack(frame), 0xABC);
+}
+
+TEST(CanSignalTests, MotorolaSignalAcrossBytes) {
+  // DBC start bit 11 is bit 3 of byte 1, the 10 bits continue from bit 7 of byte 2
+  using Signal = CanSignal<11, 10, CanByteOrder::BigEndian>;
+  CAN_frame frame = empty_frame();
+  frame.data.u8[1] = 0xF0;
+  Signal::pack(frame, 0x2D5);
+
+  EXPECT_EQ(frame.data.u8[1], 0xFB);
+  EXPECT_EQ(frame.data.u8[2], 0x54);
+  EXPECT_EQ(Signal::unpack(frame), 0x2D5);
+}
+
+TEST(CanSignalTests, SignedValuesWrapAndSignExtend) {
+  CAN_frame frame = empty_frame();
+  CanFieldBE<0, 2, true>::pack(frame, -2);
+  CanSignal<16, 4, CanByteOrder::LittleEndian, true>::pack(frame, -3);
+
+  EXPECT_EQ(frame.data.u8[0], 0xFF);
+  EXPECT_EQ(frame.data.u8[1], 0xFE);
+  EXPECT_EQ(frame.data.u8[2], 0x0D);
+  EXPECT_EQ((CanFieldBE<0, 2, true>::unpack(frame)), -2);
+  EXPECT_EQ((CanSignal<16, 4, CanByteOrder::LittleEndian, true>::unpack(frame)), -3);
+  // The same bytes read unsigned
+  EXPECT_EQ(CanFieldBE<0>::unpack(frame), 0xFFFE);
+}
+
+TEST(CanSignalTests, Scaling) {
+  // Temperature sent in 0.1 C with an offset of -100.0 C, SOC in whole percent from 0.01 %
+  using Temperature = CanFieldBE<0, 2, true, 1, 1, -1000>;
+  using Soc = CanFieldBE<2, 1, false, 100>;
+  using CellVoltage = CanFieldLE<3, 2, false, 1, 10>;
+  CAN_frame frame = empty_frame();
+  Temperature::pack(frame, 215);
+  Soc::pack(frame, 5678);
+  CellVoltage::pack(frame, 3700);
+
+  EXPECT_EQ(CanFieldBE<0>::unpack(frame), 1215);
+  EXPECT_EQ(frame.data.u8[2], 56);
+  EXPECT_EQ(CanFieldLE<3>::unpack(frame), 37000);
+  EXPECT_EQ(Temperature::unpack(frame), 215);
+  EXPECT_EQ(Soc::unpack(frame), 5600);
+  EXPECT_EQ(CellVoltage::unpack(frame), 3700);
+}
+
+TEST(CanSignalTests, PacksAtCompileTime) {
+  constexpr auto packed = [] {
+    CAN_frame frame = {};
+    CanMessage<CanFieldBE<0>, CanSignal<20, 3, CanByteOrder::LittleEndian>>::pack(frame.data.u8, 0x0102, 5);
+    return frame;
+  }();
+  static_assert(packed.data.u8[0] == 0x01 && packed.data.u8[1] == 0x02 && packed.data.u8[2] == 0x50, "");
+}
+
+TEST(CanSignalTests, EncoderPacksOnlyChangedValues) {
+  using Message = CanMessage<CanFieldBE<0>, CanFieldBE<2, 2, true>>;
+  CanFrameEncoder<Message> encoder;
+  CAN_frame frame = empty_frame();
+
+  EXPECT_TRUE(encoder.encode(frame, 3700, -15));
+  EXPECT_EQ(frame.data.u8[0], 0x0E);
+  EXPECT_EQ(frame.data.u8[3], 0xF1);
+
+  // Unchanged values leave the frame alone
+  frame.data.u8[0] = 0;
+  EXPECT_FALSE(encoder.encode(frame, 3700, -15));
+  EXPECT_EQ(frame.data.u8[0], 0);
+
+  EXPECT_TRUE(encoder.encode(frame, 3701, -15));
+  EXPECT_EQ(CanFieldBE<0>::unpack(frame), 3701);
+
+  encoder.invalidate();
+  EXPECT_TRUE(encoder.encode(frame, 3701, -15));
+}
+
+TEST(CanSignalTests, EncoderWithLayoutPickedAtRuntime) {
+  using BigEndian = CanMessage<CanFieldBE<0>>;
+  using LittleEndian = CanMessage<CanFieldLE<0>>;
+  CanFrameEncoder<BigEndian> encoder;
+  CAN_frame frame = empty_frame();
+
+  EXPECT_TRUE(encoder.encode_as<LittleEndian>(frame, 0x1234));
+  EXPECT_EQ(frame.data.u8[0], 0x34);
+  EXPECT_EQ(frame.data.u8[1], 0x12);
+}
@@ -0,0 +1,168 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <vector>
+#include "../Software/src/communication/can/can_tx_scheduler.h"
+
+static CAN_frame frame_with_id(uint32_t id, uint8_t dlc = 8) {
+  return {.FD = false, .ext_ID = false, .DLC = dlc, .ID = id, .data = {.u8 = {0}}};
+}
+
+// Records the IDs handed to the driver, refusing them while full is set
+struct FakeDriver {
+  std::vector<uint32_t> sent;
+  bool full = false;
+
+  CanTxScheduler::SendFunction send() {
+    return [this](const CAN_frame& frame) {
+      if (full) {
+        return false;
+      }
+      sent.push_back(frame.ID);
+      return true;
+    };
+  }
+};
+
+TEST(CanTxSchedulerTests, FrameBits) {
+  EXPECT_EQ(can_frame_bits(frame_with_id(0x100, 0)), 34 + 34 / 8 + 13);
+  EXPECT_EQ(can_frame_bits(frame_with_id(0x100, 8)), 98 + 98 / 8 + 13);
+
+  CAN_frame fd = frame_with_id(0x100, 64);
+  fd.FD = true;
+  const uint16_t arbitration_rate = can_frame_bits(fd, 1);
+  const uint16_t switched_rate = can_frame_bits(fd, 4);
+  EXPECT_LT(switched_rate * 3, arbitration_rate);
+}
+
+TEST(CanTxSchedulerTests, PeriodicFramesKeepTheirPeriod) {
+  FakeDriver driver;
+  CanTxScheduler scheduler(500, driver.send());
+  CAN_frame fast = frame_with_id(0x10);
+  CAN_frame slow = frame_with_id(0x20);
+  ASSERT_TRUE(scheduler.schedule(&fast, 10, CanTxPriority::Normal, nullptr, 0));
+  ASSERT_TRUE(scheduler.schedule(&slow, 100, CanTxPriority::Normal, nullptr, 5));
+
+  for (uint32_t now = 1000; now < 1200; now++) {
+    scheduler.service(now);
+  }
+  EXPECT_EQ(std::count(driver.sent.begin(), driver.sent.end(), 0x10), 20);
+  EXPECT_EQ(std::count(driver.sent.begin(), driver.sent.end(), 0x20), 2);
+  EXPECT_EQ(scheduler.stats().deadline_misses, 0u);
+}
+
+TEST(CanTxSchedulerTests, UpdateRunsOncePerPeriod) {
+  FakeDriver driver;
+  CanTxScheduler scheduler(500, driver.send());
+  CAN_frame frame = frame_with_id(0x10);
+  int updates = 0;
+  scheduler.schedule(&frame, 10, CanTxPriority::Normal, [&] {
+    frame.data.u8[0] = ++updates;
+    return updates != 2;  // The second period is skipped
+  });
+
+  driver.full = true;
+  scheduler.service(0);
+  scheduler.service(1);
+  EXPECT_EQ(updates, 1);  // Retried with the same content
+  EXPECT_EQ(scheduler.stats().retries, 2u);
+
+  driver.full = false;
+  for (uint32_t now = 2; now <= 30; now++) {
+    scheduler.service(now);
+  }
+  EXPECT_EQ(updates, 4);
+  EXPECT_EQ(driver.sent.size(), 3u);
+}
+
+TEST(CanTxSchedulerTests, BurstIsSpreadOverTicks) {
+  FakeDriver driver;
+  CanTxScheduler scheduler(500, driver.send());
+  // 2 ms of a 500 kbit/s bus carry eight full frames, the ninth starts before the time is used up
+  for (uint32_t id = 0; id < 20; id++) {
+    scheduler.queue(frame_with_id(id));
+  }
+  scheduler.service(0);
+  EXPECT_EQ(driver.sent.size(), 9u);
+  EXPECT_EQ(scheduler.stats().queue_depth, 11);
+
+  // Then four per millisecond
+  scheduler.service(1);
+  EXPECT_EQ(driver.sent.size(), 13u);
+  scheduler.service(2);
+  scheduler.service(3);
+  EXPECT_EQ(driver.sent.size(), 20u);
+  EXPECT_EQ(scheduler.stats().queue_high_water, 11);
+
+  // Sent in the order they were queued
+  for (uint32_t id = 0; id < 20; id++) {
+    EXPECT_EQ(driver.sent[id], id);
+  }
+}
+
+TEST(CanTxSchedulerTests, HigherPriorityGoesFirst) {
+  FakeDriver driver;
+  CanTxScheduler scheduler(500, driver.send());
+  CAN_frame periodic = frame_with_id(0x30);
+  scheduler.schedule(&periodic, 100, CanTxPriority::Low, nullptr, 0);
+  scheduler.queue(frame_with_id(0x20), CanTxPriority::Normal);
+  scheduler.queue(frame_with_id(0x10), CanTxPriority::High);
+
+  scheduler.service(0);
+  EXPECT_EQ(driver.sent, (std::vector<uint32_t>{0x10, 0x20, 0x30}));
+}
+
+TEST(CanTxSchedulerTests, BlockedBusCountsMissesAndDrops) {
+  FakeDriver driver;
+  CanTxScheduler scheduler(500, driver.send());
+  CAN_frame periodic = frame_with_id(0x10);
+  scheduler.schedule(&periodic, 10, CanTxPriority::Normal, nullptr, 0);
+
+  driver.full = true;
+  for (uint32_t now = 0; now < 50; now++) {
+    scheduler.service(now);
+  }
+  // Due at 0, then again at 10, 20, 30 and 40 while still waiting
+  EXPECT_EQ(scheduler.stats().deadline_misses, 4u);
+
+  for (int i = 0; i < CAN_TX_QUEUE_SIZE; i++) {
+    EXPECT_TRUE(scheduler.queue(frame_with_id(0x20)));
+  }
+  EXPECT_FALSE(scheduler.queue(frame_with_id(0x20)));
+  EXPECT_EQ(scheduler.stats().dropped, 1u);
+
+  driver.full = false;
+  for (uint32_t now = 50; now < 60; now++) {
+    scheduler.service(now);
+  }
+  EXPECT_EQ(driver.sent.size(), CAN_TX_QUEUE_SIZE + 1u);
+  EXPECT_EQ(scheduler.stats().queue_depth, 0);
+}
+
+TEST(CanTxSchedulerTests, AutoPhaseSpreadsFrames) {
+  FakeDriver driver;
+  CanTxScheduler scheduler(500, driver.send());
+  CAN_frame frames[4] = {frame_with_id(1), frame_with_id(2), frame_with_id(3), frame_with_id(4)};
+  for (CAN_frame& frame : frames) {
+    scheduler.schedule(&frame, 100);
+  }
+  scheduler.service(0);
+  EXPECT_EQ(driver.sent.size(), 1u);
+  scheduler.service(3);
+  EXPECT_EQ(driver.sent.size(), 4u);
+}
+
+TEST(CanTxSchedulerTests, BusLoad) {
+  FakeDriver driver;
+  CanTxScheduler scheduler(500, driver.send());
+  CAN_frame frame = frame_with_id(0x10);
+  const uint16_t bits = can_frame_bits(frame);
+  scheduler.schedule(&frame, 1, CanTxPriority::Normal, nullptr, 0);
+
+  // One frame per millisecond sent, one received
+  for (uint32_t now = 0; now <= 1000; now++) {
+    scheduler.note_received(frame);
+    scheduler.service(now);
+  }
+  EXPECT_EQ(scheduler.stats().bus_load_pct, (2 * bits * 1001) * 100 / (500 * 1000));
+}
@@ -0,0 +1,170 @@
+#include <gtest/gtest.h>
+
+#include <math.h>
+#include <random>
+#include "../Software/src/datalayer/cell_array.h"
+
+class CellArrayTests : public testing::Test {
+ protected:
+  DATALAYER_BATTERY_TYPE battery{};
+  CellArray cells{battery};
+
+  void SetUp() override { battery.info.number_of_cells = 96; }
+
+  // The statistics the integrations used to compute by looping over the cells
+  void expect_same_as_rescan() {
+    const DATALAYER_BATTERY_STATUS_TYPE& status = battery.status;
+    uint16_t max_mV = 0, min_mV = UINT16_MAX, measured = 0, balancing = 0;
+    double sum = 0, sum_of_squares = 0;
+    for (uint16_t i = 0; i < battery.info.number_of_cells; i++) {
+      const uint16_t voltage = status.cell_voltages_mV[i];
+      balancing += status.cell_balancing_status[i];
+      if (voltage == 0) {
+        continue;
+      }
+      measured++;
+      sum += voltage;
+      sum_of_squares += (double)voltage * voltage;
+      max_mV = std::max(max_mV, voltage);
+      min_mV = std::min(min_mV, voltage);
+    }
+    ASSERT_GT(measured, 0);
+    const double mean = sum / measured;
+    EXPECT_EQ(status.cell_max_voltage_mV, max_mV);
+    EXPECT_EQ(status.cell_min_voltage_mV, min_mV);
+    EXPECT_EQ(status.cell_voltages_mV[status.cell_max_voltage_index], max_mV);
+    EXPECT_EQ(status.cell_voltages_mV[status.cell_min_voltage_index], min_mV);
+    EXPECT_EQ(status.cell_mean_voltage_mV, lround(mean));
+    EXPECT_NEAR(status.cell_voltage_stddev_dmV, sqrt(sum_of_squares / measured - mean * mean) * 10, 1);
+    EXPECT_EQ(status.cells_balancing, balancing);
+  }
+};
+
+TEST_F(CellArrayTests, KeepsStatisticsAsCellsAreWritten) {
+  cells.publish(0);
+  for (uint16_t i = 0; i < 96; i++) {
+    cells.set_voltage(i, 3700 + i % 7, 100);
+  }
+  cells.set_voltage(40, 3650, 100);
+  cells.set_voltage(41, 3750, 100);
+  cells.publish(100);
+  expect_same_as_rescan();
+  EXPECT_EQ(battery.status.cell_min_voltage_index, 40);
+  EXPECT_EQ(battery.status.cell_max_voltage_index, 41);
+
+  // The lowest and highest cell moving back towards the others leaves others the lowest and highest
+  cells.set_voltage(40, 3703, 200);
+  cells.set_voltage(41, 3703, 200);
+  cells.publish(200);
+  expect_same_as_rescan();
+  EXPECT_EQ(battery.status.cell_min_voltage_mV, 3700);
+  EXPECT_EQ(battery.status.cell_max_voltage_mV, 3706);
+}
+
+TEST_F(CellArrayTests, MatchesRescanUnderRandomWrites) {
+  std::mt19937 random(7);
+  for (uint16_t i = 0; i < 96; i++) {
+    cells.set_voltage(i, 3600 + random() % 200, 0);
+  }
+  for (int round = 0; round < 200; round++) {
+    for (int write = 0; write < 20; write++) {
+      const uint16_t cell = random() % 96;
+      cells.set_voltage(cell, random() % 10 == 0 ? 0 : 3000 + random() % 1200, round);
+      cells.set_balancing(random() % 96, random() % 2);
+    }
+    cells.publish(round);
+    expect_same_as_rescan();
+  }
+}
+
+TEST_F(CellArrayTests, UnmeasuredCellsAreLeftOut) {
+  cells.set_voltage(0, 3700, 0);
+  cells.set_voltage(1, 3710, 0);
+  cells.publish(0);
+  EXPECT_EQ(battery.status.cell_min_voltage_mV, 3700);
+  EXPECT_EQ(battery.status.cell_mean_voltage_mV, 3705);
+  EXPECT_EQ(battery.status.cell_voltage_stddev_dmV, 50);
+
+  cells.set_voltage(0, 0, 0);
+  cells.set_voltage(1, 0, 0);
+  cells.publish(0);
+  EXPECT_EQ(battery.status.cell_mean_voltage_mV, 0);
+  EXPECT_EQ(battery.status.cell_voltage_stddev_dmV, 0);
+}
+
+TEST_F(CellArrayTests, CountsStaleCells) {
+  battery.info.number_of_cells = 4;
+  for (uint16_t i = 0; i < 4; i++) {
+    cells.set_voltage(i, 3700, 1000);
+  }
+  cells.set_voltage(2, 3701, 5000);
+  cells.publish(1000 + CELL_STALE_DEFAULT_MS - 1);
+  EXPECT_EQ(battery.status.cells_stale, 0);
+
+  cells.publish(1000 + CELL_STALE_DEFAULT_MS);
+  EXPECT_EQ(battery.status.cells_stale, 3);
+  EXPECT_TRUE(cells.stale(0, 1000 + CELL_STALE_DEFAULT_MS));
+  EXPECT_FALSE(cells.stale(2, 1000 + CELL_STALE_DEFAULT_MS));
+}
+
+TEST_F(CellArrayTests, StaleAfterRefreshPeriods) {
+  // Polled every 10 s, and answered a little late
+  cells.set_refresh_period(10000);
+  battery.info.number_of_cells = 2;
+  cells.set_voltage(0, 3700, 0);
+  cells.set_voltage(1, 3700, 0);
+  cells.set_voltage(0, 3701, 10500);
+  cells.publish(12000);
+  EXPECT_EQ(battery.status.cells_stale, 0);
+
+  cells.publish(CELL_STALE_PERIODS * 10000 - 1);
+  EXPECT_EQ(battery.status.cells_stale, 0);
+  cells.publish(CELL_STALE_PERIODS * 10000);
+  EXPECT_EQ(battery.status.cells_stale, 1);
+  EXPECT_TRUE(cells.stale(1, CELL_STALE_PERIODS * 10000));
+}
+
+TEST_F(CellArrayTests, RescansCellsWrittenDirectly) {
+  battery.status.cell_max_voltage_mV = 4000;  // As reported by the BMS
+  for (uint16_t i = 0; i < 96; i++) {
+    battery.status.cell_voltages_mV[i] = 3700 - i;
+    battery.status.cell_balancing_status[i] = i < 5;
+  }
+  cells.publish(0);
+  EXPECT_EQ(battery.status.cell_max_voltage_mV, 4000);
+  EXPECT_EQ(battery.status.cell_max_voltage_index, 0);
+  EXPECT_EQ(battery.status.cell_min_voltage_index, 95);
+  EXPECT_EQ(battery.status.cells_balancing, 5);
+  EXPECT_EQ(battery.status.cells_stale, 0);
+
+  battery.status.cell_voltages_mV[50] = 3800;
+  cells.publish(1000);
+  EXPECT_EQ(battery.status.cell_max_voltage_index, 50);
+}
+
+TEST_F(CellArrayTests, NumberOfCellsChanging) {
+  battery.info.number_of_cells = 108;
+  for (uint16_t i = 0; i < 108; i++) {
+    cells.set_voltage(i, i < 96 ? 3700 : 3900, 0);
+  }
+  cells.publish(0);
+  EXPECT_EQ(battery.status.cell_max_voltage_mV, 3900);
+
+  // Found out to be a 96S pack
+  battery.info.number_of_cells = 96;
+  cells.publish(0);
+  EXPECT_EQ(battery.status.cell_max_voltage_mV, 3700);
+  expect_same_as_rescan();
+}
+
+TEST_F(CellArrayTests, ReportedExtremesAreKept) {
+  cells.keep_reported_extremes();
+  battery.status.cell_max_voltage_mV = 3750;
+  battery.status.cell_min_voltage_mV = 3650;
+  cells.set_voltage(0, 3700, 0);
+  cells.set_voltage(1, 3720, 0);
+  cells.publish(0);
+  EXPECT_EQ(battery.status.cell_max_voltage_mV, 3750);
+  EXPECT_EQ(battery.status.cell_min_voltage_mV, 3650);
+  EXPECT_EQ(battery.status.cell_max_voltage_index, 1);
+}
@@ -0,0 +1,92 @@
+#include <gtest/gtest.h>
+
+#include "../Software/src/devboard/utils/crc.h"
+
+// "123456789", the check value of the CRC catalogue is the CRC of this string
+static const uint8_t CHECK[] = {'1', '2', '3', '4', '5', '6', '7', '8', '9'};
+
+// The expected values below were produced by the per-integration implementations the library replaced
+static const CAN_frame FRAME = {.FD = false,
+                                .ext_ID = false,
+                                .DLC = 8,
+                                .ID = 0x0FC,
+                                .data = {.u8 = {0x00, 0x13, 0x37, 0x42, 0xA5, 0x5A, 0xFF, 0x00}}};
+
+TEST(CrcTests, CatalogueCheckValues) {
+  EXPECT_EQ(Crc8SaeJ1850Zero::calculate(CHECK, sizeof(CHECK)), 0x37);
+  EXPECT_EQ(Crc8Autosar::calculate(CHECK, sizeof(CHECK)), 0xDF);
+  EXPECT_EQ(Crc8Maxim::calculate(CHECK, sizeof(CHECK)), 0xA1);
+  EXPECT_EQ(Crc16Modbus::calculate(CHECK, sizeof(CHECK)), 0x4B37);
+  EXPECT_EQ(Crc32::calculate(CHECK, sizeof(CHECK)), 0xCBF43926u);
+}
+
+TEST(CrcTests, TablesAreGeneratedAtCompileTime) {
+  static_assert(Crc8SaeJ1850Zero::update(0, (uint8_t)1) == 0x1D, "");
+  static_assert(Crc8Nissan::update(0, (uint8_t)1) == 0x85, "");
+  static_assert(Crc8Maxim::update(0, (uint8_t)0x80) == 0x8C, "");
+  static_assert(Crc16Modbus::update(0, (uint8_t)1) == 0xC0C1, "");
+}
+
+TEST(CrcTests, NissanLeaf) {
+  EXPECT_EQ(Crc8Nissan::calculate(FRAME.data.u8, 7), 0xCF);
+}
+
+TEST(CrcTests, GeelyGeometryC) {
+  EXPECT_EQ(Crc8Autosar::calculate(FRAME.data.u8, 7), 0x1E);
+}
+
+TEST(CrcTests, RenaultZoeGen2) {
+  EXPECT_EQ(Crc8SaeJ1850Zero::calculate(FRAME.data.u8, 7) ^ 0xAC, 0xC4);
+}
+
+TEST(CrcTests, BmwSbox) {
+  EXPECT_EQ(Crc8Maxim::calculate(FRAME.data.u8, 8), 0x06);
+}
+
+TEST(CrcTests, SantaFePhev) {
+  EXPECT_EQ(Crc8SantaFe::calculate(FRAME.data.u8, 8), 0x66);
+}
+
+TEST(CrcTests, SungrowModbus) {
+  const uint8_t request[] = {0x01, 0x03, 0x00, 0x00, 0x00, 0x0A};
+  EXPECT_EQ(Crc16Modbus::calculate(request, sizeof(request)), 0xCDC5);
+
+  // Battery response from a Sungrow log, the CRC is sent little endian as BB 8A
+  const uint8_t response[] = {0x01, 0x04, 0x04, 0x01, 0xF4, 0x00, 0x00};
+  EXPECT_EQ(Crc16Modbus::calculate(response, sizeof(response)), 0x8ABB);
+}
+
+TEST(CrcTests, Profile1CoversBytesOneToLength) {
+  EXPECT_EQ(e2e_profile1_crc(FRAME, 3, 0x3F), 0x1B);
+  EXPECT_EQ(e2e_profile1_crc(FRAME, 8, 0x60), 0xCD);
+
+  // The CRC byte itself is not covered
+  CAN_frame frame = FRAME;
+  frame.data.u8[0] = 0xFF;
+  EXPECT_EQ(e2e_profile1_crc(frame, 8, 0x60), 0xCD);
+}
+
+TEST(CrcTests, Profile2UsesDataIdOfCounter) {
+  const uint8_t MB00FC[16] = {0x77, 0x5c, 0xa0, 0x89, 0x4b, 0x7c, 0xbb, 0xd6,
+                              0x1f, 0x6c, 0x4f, 0xf6, 0x20, 0x2b, 0x43, 0xdd};
+  EXPECT_EQ(e2e_profile2_crc(FRAME, FRAME.DLC, MB00FC), 0x94);
+
+  CAN_frame frame = FRAME;
+  frame.data.u8[1] = 0x14;
+  EXPECT_NE(e2e_profile2_crc(frame, frame.DLC, MB00FC), 0x94);
+}
+
+TEST(CrcTests, ProtectSetsCounterAndCrc) {
+  const uint8_t data_ids[16] = {0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40,
+                                0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40};
+  CAN_frame frame = FRAME;
+  frame.data.u8[1] = 0xAF;
+
+  e2e_profile2_protect(frame, 0x13, data_ids);
+  EXPECT_EQ(frame.data.u8[1], 0xA3);
+  EXPECT_EQ(frame.data.u8[0], e2e_profile2_crc(frame, frame.DLC, data_ids));
+
+  e2e_profile1_protect(frame, 5, 8, 0x60);
+  EXPECT_EQ(frame.data.u8[1], 0xA5);
+  EXPECT_EQ(frame.data.u8[0], e2e_profile1_crc(frame, 8, 0x60));
+}
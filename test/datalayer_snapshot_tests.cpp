@@ -0,0 +1,131 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+#include "../Software/src/datalayer/datalayer_snapshot.h"
+#include "../Software/src/devboard/utils/seqlock.h"
+
+// Every field holds the same counter, a torn copy has fields of different publishes
+struct Sample {
+  uint32_t counter;
+  uint32_t fields[255];
+};
+
+static Sample make_sample(uint32_t counter) {
+  Sample sample;
+  sample.counter = counter;
+  for (uint32_t& field : sample.fields) {
+    field = counter;
+  }
+  return sample;
+}
+
+TEST(SeqlockTests, ReadReturnsLastPublish) {
+  static Seqlock<Sample> lock;
+  Sample sample;
+
+  lock.read(sample);
+  EXPECT_EQ(sample.counter, 0u);
+  EXPECT_EQ(lock.version(), 0u);
+
+  lock.publish(make_sample(7));
+  lock.publish(make_sample(8));
+  lock.read(sample);
+  EXPECT_EQ(sample.counter, 8u);
+  EXPECT_EQ(sample.fields[254], 8u);
+  EXPECT_EQ(lock.version(), 2u);
+}
+
+TEST(SeqlockTests, ConcurrentReadersNeverSeeTornValues) {
+  static Seqlock<Sample> lock;
+  const uint32_t PUBLISHES = 20000;
+  const int READERS = 3;
+  std::atomic<bool> done{false};
+  std::atomic<uint32_t> torn{0};
+  std::atomic<uint32_t> backwards{0};
+  std::atomic<uint64_t> reads{0};
+
+  std::vector<std::thread> readers;
+  for (int r = 0; r < READERS; r++) {
+    readers.emplace_back([&] {
+      Sample sample;
+      uint32_t last = 0;
+      while (!done.load()) {
+        lock.read(sample);
+        for (uint32_t field : sample.fields) {
+          if (field != sample.counter) {
+            torn++;
+            break;
+          }
+        }
+        if (sample.counter < last) {
+          backwards++;
+        }
+        last = sample.counter;
+        reads++;
+      }
+    });
+  }
+
+  std::thread writer([&] {
+    for (uint32_t counter = 1; counter <= PUBLISHES; counter++) {
+      lock.publish(make_sample(counter));
+    }
+    done = true;
+  });
+
+  writer.join();
+  for (std::thread& reader : readers) {
+    reader.join();
+  }
+
+  Sample sample;
+  lock.read(sample);
+  EXPECT_EQ(sample.counter, PUBLISHES);
+  EXPECT_EQ(torn.load(), 0u);
+  EXPECT_EQ(backwards.load(), 0u);
+  EXPECT_GT(reads.load(), 0u);
+}
+
+TEST(DatalayerSnapshotTests, ReadersGetValuesOfOneUpdate) {
+  const int UPDATES = 5000;
+  std::atomic<bool> done{false};
+  std::atomic<uint32_t> mixed{0};
+  datalayer.battery.status.voltage_dV = 0;
+  datalayer.battery.status.current_dA = 0;
+  datalayer.battery.status.active_power_W = 0;
+  datalayer.shunt.measured_voltage_mV = 0;
+  publish_datalayer_snapshot();
+
+  // The reader checks that voltage, current and power always belong to the same update
+  std::thread reader([&] {
+    DATALAYER_SNAPSHOT_TYPE snapshot;
+    while (!done.load()) {
+      read_datalayer_snapshot(snapshot);
+      const DATALAYER_BATTERY_STATUS_TYPE& status = snapshot.battery.status;
+      if (status.current_dA != (int16_t)status.voltage_dV || status.active_power_W != status.voltage_dV ||
+          snapshot.shunt.measured_voltage_mV != status.voltage_dV) {
+        mixed++;
+      }
+    }
+  });
+
+  for (int update = 0; update < UPDATES; update++) {
+    datalayer.battery.status.voltage_dV = update;
+    datalayer.battery.status.current_dA = update;
+    datalayer.battery.status.active_power_W = update;
+    datalayer.shunt.measured_voltage_mV = update;
+    publish_datalayer_snapshot();
+  }
+  done = true;
+  reader.join();
+
+  DATALAYER_SNAPSHOT_TYPE snapshot;
+  read_datalayer_snapshot(snapshot);
+  EXPECT_EQ(snapshot.battery.status.voltage_dV, UPDATES - 1);
+  EXPECT_EQ(mixed.load(), 0u);
+
+  datalayer = DataLayer();
+  publish_datalayer_snapshot();
+}
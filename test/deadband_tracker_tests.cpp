@@ -0,0 +1,71 @@
+#include <gtest/gtest.h>
+
+#include "../Software/src/devboard/utils/deadband_tracker.h"
+
+TEST(DeadbandTrackerTests, FirstValueIsAlwaysPublished) {
+  DeadbandTracker tracker;
+  tracker.resize(2);
+  EXPECT_TRUE(tracker.changed(0, 3700, {5, 0}));
+  EXPECT_TRUE(tracker.changed(1, 0, {5, 0}));
+  EXPECT_FALSE(tracker.changed(1, 0, {5, 0}));
+}
+
+TEST(DeadbandTrackerTests, AbsoluteBand) {
+  DeadbandTracker tracker;
+  tracker.resize(1);
+  tracker.changed(0, 3700, {5, 0});
+  EXPECT_FALSE(tracker.changed(0, 3704, {5, 0}));
+  EXPECT_FALSE(tracker.changed(0, 3696, {5, 0}));
+  EXPECT_TRUE(tracker.changed(0, 3705, {5, 0}));
+  EXPECT_TRUE(tracker.changed(0, 3700, {5, 0}));
+}
+
+TEST(DeadbandTrackerTests, DriftIsComparedWithLastPublished) {
+  DeadbandTracker tracker;
+  tracker.resize(1);
+  tracker.changed(0, 3700, {5, 0});
+  EXPECT_FALSE(tracker.changed(0, 3702, {5, 0}));
+  EXPECT_FALSE(tracker.changed(0, 3704, {5, 0}));
+  EXPECT_TRUE(tracker.changed(0, 3706, {5, 0}));
+}
+
+TEST(DeadbandTrackerTests, RelativeBandAppliesWhenLarger) {
+  DeadbandTracker tracker;
+  tracker.resize(1);
+  // 2 % of 10000 W is 200 W, more than the 50 W absolute band
+  tracker.changed(0, -10000, {50, 20});
+  EXPECT_FALSE(tracker.changed(0, -10150, {50, 20}));
+  EXPECT_TRUE(tracker.changed(0, -10200, {50, 20}));
+  // Near zero the absolute band applies
+  tracker.changed(0, 100, {50, 20});
+  EXPECT_FALSE(tracker.changed(0, 140, {50, 20}));
+  EXPECT_TRUE(tracker.changed(0, 150, {50, 20}));
+}
+
+TEST(DeadbandTrackerTests, ZeroBandPublishesEveryChange) {
+  DeadbandTracker tracker;
+  tracker.resize(1);
+  tracker.changed(0, 1, {0, 0});
+  EXPECT_FALSE(tracker.changed(0, 1, {0, 0}));
+  EXPECT_TRUE(tracker.changed(0, 2, {0, 0}));
+}
+
+TEST(DeadbandTrackerTests, ForgetForcesPublish) {
+  DeadbandTracker tracker;
+  tracker.resize(3);
+  for (size_t i = 0; i < 3; i++) {
+    tracker.changed(i, 10, {5, 0});
+  }
+  tracker.forget(1);
+  EXPECT_FALSE(tracker.changed(0, 10, {5, 0}));
+  EXPECT_TRUE(tracker.changed(1, 10, {5, 0}));
+
+  tracker.forget_all();
+  for (size_t i = 0; i < 3; i++) {
+    EXPECT_TRUE(tracker.changed(i, 10, {5, 0}));
+  }
+
+  // Slots beyond the size are not tracked
+  EXPECT_TRUE(tracker.changed(3, 10, {5, 0}));
+  EXPECT_TRUE(tracker.changed(3, 10, {5, 0}));
+}
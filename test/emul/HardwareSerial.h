@@ -3,6 +3,7 @@
 
 #include <stdint.h>
 #include <cstddef>
+#include <functional>
 #include "Print.h"
 #include "Stream.h"
 
@@ -33,6 +34,18 @@ enum SerialConfig {
   SERIAL_8O2 = 0x800003f
 };
 
+typedef enum {
+  UART_NO_ERROR,
+  UART_BREAK_ERROR,
+  UART_BUFFER_FULL_ERROR,
+  UART_FIFO_OVF_ERROR,
+  UART_FRAME_ERROR,
+  UART_PARITY_ERROR
+} hardwareSerial_error_t;
+
+typedef std::function<void(void)> OnReceiveCb;
+typedef std::function<void(hardwareSerial_error_t)> OnReceiveErrorCb;
+
 class HardwareSerial : public Stream {
  public:
   // Implement ALL pure virtual functions from base classes
@@ -49,6 +62,9 @@ class HardwareSerial : public Stream {
   void setTxBufferSize(uint16_t size) {}
   void setRxBufferSize(uint16_t size) {}
   bool setRxFIFOFull(uint8_t fifoBytes) { return false; }
+  bool setRxTimeout(uint8_t symbols_timeout) { return false; }
+  void onReceive(OnReceiveCb function, bool onlyOnTimeout = false) {}
+  void onReceiveError(OnReceiveErrorCb function) {}
 
   // Add the buffer write method
   size_t write(const uint8_t* buffer, size_t size) override {
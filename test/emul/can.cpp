@@ -3,7 +3,14 @@
 
 void transmit_can_frame_to_interface(const CAN_frame* tx_frame, CAN_Interface interface) {}
 
-void register_can_receiver(CanReceiver* receiver, CAN_Interface interface, CAN_Speed speed) {}
+void queue_can_frame(const CAN_frame* tx_frame, CAN_Interface interface, CanTxPriority priority) {}
+
+bool schedule_can_frame(const CAN_frame* frame, CAN_Interface interface, uint16_t period_ms, CanTxPriority priority,
+                        CanTxScheduler::UpdateFunction update, int16_t phase_ms) {
+  return true;
+}
+
+void register_can_receiver(CanReceiver* receiver, CAN_Interface interface, const char* name, CAN_Speed speed) {}
 
 bool change_can_speed(CAN_Interface interface, CAN_Speed speed) {
   return true;
@@ -17,6 +24,6 @@ char const* getCANInterfaceName(CAN_Interface) {
   return "Foobar";
 }
 
-void register_transmitter(Transmitter* transmitter) {}
+void register_transmitter(Transmitter* transmitter, const char* name) {}
 
-void dump_can_frame(CAN_frame& frame, CAN_Interface interface, frameDirection msgDir) {}
+void dump_can_frame(const CAN_frame& frame, CAN_Interface interface, frameDirection msgDir) {}
@@ -0,0 +1,9 @@
+#ifndef _ESP_TIMER_H_
+#define _ESP_TIMER_H_
+
+#include <stdint.h>
+
+// Microseconds since boot
+int64_t esp_timer_get_time();
+
+#endif
@@ -1,4 +1,5 @@
 #include "FreeRTOS.h"
+#include "ringbuf.h"
 
 extern "C" {
 BaseType_t xTaskCreatePinnedToCore(TaskFunction_t pxTaskCode, const char* const pcName, const uint32_t ulStackDepth,
@@ -8,3 +9,15 @@ BaseType_t xTaskCreatePinnedToCore(TaskFunction_t pxTaskCode, const char* const
 }
 void vTaskDelete(TaskHandle_t xTaskToDelete) {}
 }
+
+RingbufHandle_t xRingbufferCreate(size_t xBufferSize, RingbufferType_t xBufferType) {
+  return nullptr;
+}
+BaseType_t xRingbufferSend(RingbufHandle_t xRingbuffer, const void* pvItem, size_t xItemSize,
+                           TickType_t xTicksToWait) {
+  return pdFALSE;
+}
+void* xRingbufferReceive(RingbufHandle_t xRingbuffer, size_t* pxItemSize, TickType_t xTicksToWait) {
+  return nullptr;
+}
+void vRingbufferReturnItem(RingbufHandle_t xRingbuffer, void* pvItem) {}
@@ -10,6 +10,12 @@ typedef unsigned int UBaseType_t;
 
 const BaseType_t tskNO_AFFINITY = -1;
 
+// The tests run on one thread, critical sections do nothing
+typedef int portMUX_TYPE;
+#define portMUX_INITIALIZER_UNLOCKED 0
+#define portENTER_CRITICAL(mux) ((void)(mux))
+#define portEXIT_CRITICAL(mux) ((void)(mux))
+
 extern "C" {
 BaseType_t xTaskCreatePinnedToCore(TaskFunction_t pxTaskCode, const char* const pcName, const uint32_t ulStackDepth,
                                    void* const pvParameters, UBaseType_t uxPriority, TaskHandle_t* const pxCreatedTask,
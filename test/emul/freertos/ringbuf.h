@@ -0,0 +1,22 @@
+#ifndef _FREERTOS_RINGBUF_H_
+#define _FREERTOS_RINGBUF_H_
+
+#include <stddef.h>
+#include "FreeRTOS.h"
+
+typedef void* RingbufHandle_t;
+typedef unsigned int TickType_t;
+
+typedef enum { RINGBUF_TYPE_NOSPLIT = 0, RINGBUF_TYPE_ALLOWSPLIT, RINGBUF_TYPE_BYTEBUF } RingbufferType_t;
+
+#define pdFALSE ((BaseType_t)0)
+#define pdTRUE ((BaseType_t)1)
+
+// No ring buffers on the host, creating one fails
+RingbufHandle_t xRingbufferCreate(size_t xBufferSize, RingbufferType_t xBufferType);
+BaseType_t xRingbufferSend(RingbufHandle_t xRingbuffer, const void* pvItem, size_t xItemSize,
+                           TickType_t xTicksToWait);
+void* xRingbufferReceive(RingbufHandle_t xRingbuffer, size_t* pxItemSize, TickType_t xTicksToWait);
+void vRingbufferReturnItem(RingbufHandle_t xRingbuffer, void* pvItem);
+
+#endif
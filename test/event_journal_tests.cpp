@@ -0,0 +1,279 @@
+#include <gtest/gtest.h>
+
+#include <string.h>
+#include <string>
+#include <vector>
+#include "../Software/src/devboard/utils/event_journal.h"
+#include "../Software/src/devboard/utils/events.h"
+
+// NOR flash in RAM: writing only clears bits, erasing sets a whole sector to 0xFF
+class RamFlash : public JournalFlash {
+ public:
+  explicit RamFlash(size_t sectors) : bytes(sectors * JOURNAL_SECTOR_SIZE, 0xFF) {}
+  uint32_t size() const override { return bytes.size(); }
+  bool read(uint32_t offset, void* data, size_t length) override {
+    memcpy(data, bytes.data() + offset, length);
+    return true;
+  }
+  bool write(uint32_t offset, const void* data, size_t length) override {
+    const uint8_t* source = static_cast<const uint8_t*>(data);
+    for (size_t i = 0; i < length; i++) {
+      bytes[offset + i] &= source[i];
+    }
+    writes++;
+    return true;
+  }
+  bool erase_sector(uint32_t offset) override {
+    memset(bytes.data() + offset, 0xFF, JOURNAL_SECTOR_SIZE);
+    erases++;
+    return true;
+  }
+
+  std::vector<uint8_t> bytes;
+  int writes = 0;
+  int erases = 0;
+};
+
+static JournalRecord event_record(uint8_t event, uint8_t data) {
+  JournalRecord record = {};
+  record.event = event;
+  record.data = data;
+  record.level = EVENT_LEVEL_WARNING;
+  record.timestamp = 1000 + data;
+  record.voltage_dV = 3712;
+  record.current_dA = -15;
+  return record;
+}
+
+static std::vector<JournalRecord> read_all(const EventJournal& journal) {
+  std::vector<JournalRecord> records;
+  JournalRecord record;
+  auto cursor = journal.oldest();
+  while (journal.read(cursor, record)) {
+    records.push_back(record);
+  }
+  return records;
+}
+
+TEST(EventJournalTests, WritesQueuedRecords) {
+  RamFlash flash(4);
+  EventJournal journal;
+  ASSERT_TRUE(journal.begin(&flash));
+  EXPECT_EQ(journal.boot(), 0);
+
+  journal.add(event_record(EVENT_WIFI_CONNECT, 1));
+  journal.add(event_record(EVENT_MQTT_CONNECT, 2));
+  EXPECT_EQ(flash.writes, 0);  // Only queued
+  EXPECT_EQ(journal.flush(), 2u);
+  EXPECT_EQ(journal.flush(), 0u);
+
+  const auto records = read_all(journal);
+  ASSERT_EQ(records.size(), 2u);
+  EXPECT_EQ(records[0].sequence, 0u);
+  EXPECT_EQ(records[0].event, EVENT_WIFI_CONNECT);
+  EXPECT_EQ(records[1].sequence, 1u);
+  EXPECT_EQ(records[1].data, 2);
+  EXPECT_EQ(records[1].timestamp, 1002u);
+  EXPECT_EQ(records[1].current_dA, -15);
+}
+
+TEST(EventJournalTests, FullQueueDropsRecords) {
+  RamFlash flash(4);
+  EventJournal journal;
+  ASSERT_TRUE(journal.begin(&flash));
+  for (int i = 0; i < JOURNAL_QUEUE_SIZE + 3; i++) {
+    journal.add(event_record(EVENT_WIFI_CONNECT, i));
+  }
+  EXPECT_EQ(journal.dropped(), 3u);
+  EXPECT_EQ(journal.flush(), (size_t)JOURNAL_QUEUE_SIZE);
+}
+
+TEST(EventJournalTests, RecoversAfterReboot) {
+  RamFlash flash(4);
+  {
+    EventJournal journal;
+    ASSERT_TRUE(journal.begin(&flash));
+    for (int i = 0; i < 200; i++) {  // Into the second sector
+      journal.add(event_record(EVENT_WIFI_CONNECT, i));
+      journal.flush();
+    }
+  }
+
+  EventJournal journal;
+  ASSERT_TRUE(journal.begin(&flash));
+  EXPECT_EQ(journal.boot(), 1);
+  journal.add(event_record(EVENT_MQTT_CONNECT, 7));
+  journal.flush();
+
+  const auto records = read_all(journal);
+  ASSERT_EQ(records.size(), 201u);
+  EXPECT_EQ(records[199].boot, 0);
+  EXPECT_EQ(records[200].boot, 1);
+  EXPECT_EQ(records[200].sequence, 200u);
+  EXPECT_EQ(records[200].event, EVENT_MQTT_CONNECT);
+}
+
+TEST(EventJournalTests, SkipsTornRecord) {
+  RamFlash flash(4);
+  {
+    EventJournal journal;
+    ASSERT_TRUE(journal.begin(&flash));
+    for (int i = 0; i < 10; i++) {
+      journal.add(event_record(EVENT_WIFI_CONNECT, i));
+    }
+    journal.flush();
+  }
+  // A reset while the next record was written leaves part of it
+  memset(flash.bytes.data() + 10 * JOURNAL_RECORD_SIZE, 0x00, JOURNAL_RECORD_SIZE / 2);
+
+  EventJournal journal;
+  ASSERT_TRUE(journal.begin(&flash));
+  journal.add(event_record(EVENT_MQTT_CONNECT, 0));
+  journal.flush();
+
+  const auto records = read_all(journal);
+  ASSERT_EQ(records.size(), 11u);
+  EXPECT_EQ(records[10].sequence, 10u);
+  EXPECT_EQ(records[10].event, EVENT_MQTT_CONNECT);
+  // The torn slot was left as it is
+  EXPECT_EQ(flash.bytes[10 * JOURNAL_RECORD_SIZE], 0x00);
+}
+
+TEST(EventJournalTests, WrapsOverOldestSector) {
+  const int sectors = 8;
+  const int per_sector = JOURNAL_RECORDS_PER_SECTOR;
+  RamFlash flash(sectors);
+  EventJournal journal;
+  ASSERT_TRUE(journal.begin(&flash));
+  EXPECT_EQ(journal.reserve(), (uint32_t)(sectors - sectors / JOURNAL_KEPT_FRACTION));
+
+  const int total = sectors * per_sector + 5;
+  for (int i = 0; i < total; i++) {
+    journal.add(event_record(EVENT_WIFI_CONNECT, i));
+    journal.erase_ahead();
+    journal.flush();
+  }
+  // The blank sectors were not erased. From the third sector on, entering a sector erased the one two before it.
+  EXPECT_EQ(flash.erases, sectors - 1);
+  EXPECT_EQ(journal.erased(), journal.reserve());
+
+  // The kept sectors, the last one and the 5 records that went to the first one again
+  auto records = read_all(journal);
+  ASSERT_EQ(records.size(), (size_t)(per_sector + 5));
+  EXPECT_EQ(records.front().sequence, (uint32_t)((sectors - 1) * per_sector));
+  EXPECT_EQ(records.back().sequence, (uint32_t)(total - 1));
+
+  // The same after a reboot
+  EventJournal rebooted;
+  ASSERT_TRUE(rebooted.begin(&flash));
+  EXPECT_EQ(rebooted.erased(), rebooted.reserve());
+  records = read_all(rebooted);
+  ASSERT_EQ(records.size(), (size_t)(per_sector + 5));
+  EXPECT_EQ(records.front().sequence, (uint32_t)((sectors - 1) * per_sector));
+  rebooted.add(event_record(EVENT_MQTT_CONNECT, 0));
+  rebooted.flush();
+  EXPECT_EQ(read_all(rebooted).back().sequence, (uint32_t)total);
+}
+
+TEST(EventJournalTests, RecordsWaitForErasedSector) {
+  const int per_sector = JOURNAL_RECORDS_PER_SECTOR;
+  RamFlash flash(4);
+  EventJournal journal;
+  ASSERT_TRUE(journal.begin(&flash));
+  EXPECT_EQ(journal.reserve(), 3u);
+  EXPECT_EQ(journal.erased(), 3u);
+
+  // Without erase_ahead() the blank sectors fill up, and then the records wait
+  const int fit = 3 * per_sector;
+  for (int i = 0; i < fit + 3; i++) {
+    journal.add(event_record(EVENT_WIFI_CONNECT, i));
+    journal.flush();
+  }
+  EXPECT_EQ(journal.erased(), 0u);
+  EXPECT_EQ(read_all(journal).size(), (size_t)fit);
+  EXPECT_EQ(journal.dropped(), 0u);
+  EXPECT_EQ(journal.failed(), 0u);
+
+  // One erase at a time. The last sector was never used, the first one is erased.
+  EXPECT_TRUE(journal.erase_ahead(1));
+  EXPECT_EQ(flash.erases, 1);
+  EXPECT_EQ(journal.erased(), 2u);
+
+  // The waiting records go to the sector erased next, in order
+  EXPECT_EQ(journal.flush(), 3u);
+  auto records = read_all(journal);
+  ASSERT_EQ(records.size(), (size_t)(2 * per_sector + 3));
+  EXPECT_EQ(records.front().sequence, (uint32_t)per_sector);
+  EXPECT_EQ(records.back().sequence, (uint32_t)(fit + 2));
+  EXPECT_EQ(records.back().data, (uint8_t)(fit + 2));
+
+  // Then all but the sector written last
+  EXPECT_TRUE(journal.erase_ahead());
+  EXPECT_EQ(flash.erases, 3);
+  EXPECT_EQ(journal.erased(), 3u);
+  records = read_all(journal);
+  ASSERT_EQ(records.size(), 3u);
+  EXPECT_EQ(records.front().sequence, (uint32_t)fit);
+}
+
+TEST(EventJournalTests, ErasesUsedSectorsAhead) {
+  RamFlash flash(4);
+  {
+    EventJournal journal;
+    ASSERT_TRUE(journal.begin(&flash));
+    journal.add(event_record(EVENT_WIFI_CONNECT, 0));
+    journal.flush();
+  }
+  // Left over from something else than the journal
+  memset(flash.bytes.data() + JOURNAL_SECTOR_SIZE + 100, 0x12, 4);
+
+  EventJournal journal;
+  ASSERT_TRUE(journal.begin(&flash));
+  EXPECT_EQ(journal.erased(), 0u);
+  EXPECT_TRUE(journal.erase_ahead());
+  EXPECT_EQ(flash.erases, 1);
+  EXPECT_EQ(journal.erased(), journal.reserve());
+  EXPECT_EQ(flash.bytes[JOURNAL_SECTOR_SIZE + 100], 0xFF);
+  EXPECT_EQ(read_all(journal).size(), 1u);
+}
+
+TEST(EventJournalTests, FullQueueWaitingForErasedSectorDropsRecords) {
+  RamFlash flash(2);
+  EventJournal journal;
+  ASSERT_TRUE(journal.begin(&flash));
+  EXPECT_EQ(journal.reserve(), 1u);
+  for (int i = 0; i < JOURNAL_RECORDS_PER_SECTOR + JOURNAL_QUEUE_SIZE + 2; i++) {
+    journal.add(event_record(EVENT_WIFI_CONNECT, i));
+    journal.flush();
+  }
+  EXPECT_EQ(journal.dropped(), 2u);
+}
+
+TEST(EventJournalTests, TextExport) {
+  RamFlash flash(2);
+  EventJournal journal;
+  ASSERT_TRUE(journal.begin(&flash));
+  journal.add(event_record(EVENT_WIFI_CONNECT, 3));
+  journal.add(event_record(250, 4));  // Unknown to this firmware
+  journal.flush();
+
+  JournalTextExport text_export(journal);
+  std::string text;
+  uint8_t buffer[16];
+  size_t length;
+  while ((length = text_export.read(buffer, sizeof(buffer))) > 0) {
+    text.append(reinterpret_cast<char*>(buffer), length);
+  }
+  EXPECT_EQ(text,
+            "boot,sequence,millis,event,level,data,voltage_dV,current_dA,soc_pptt,cell_min_mV,cell_max_mV\n"
+            "0,0,1003,WIFI_CONNECT,WARNING,3,3712,-15,0,0,0\n"
+            "0,1,1004,250,WARNING,4,3712,-15,0,0,0\n");
+}
+
+TEST(EventJournalTests, TooSmall) {
+  RamFlash flash(1);
+  EventJournal journal;
+  EXPECT_FALSE(journal.begin(&flash));
+  EXPECT_FALSE(journal.ready());
+  EXPECT_EQ(journal.flush(), 0u);
+}
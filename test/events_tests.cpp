@@ -0,0 +1,133 @@
+#include <gtest/gtest.h>
+
+#include <Arduino.h>
+#include <algorithm>
+#include <vector>
+#include "../Software/src/devboard/utils/events.h"
+
+static std::vector<EVENTS_ENUM_TYPE> newest_first() {
+  std::vector<EVENTS_ENUM_TYPE> list(EVENT_NOF_EVENTS);
+  list.resize(get_events_newest_first(list.data(), list.size()));
+  return list;
+}
+
+static std::vector<EVENTS_ENUM_TYPE> oldest_first() {
+  std::vector<EVENTS_ENUM_TYPE> list = newest_first();
+  std::reverse(list.begin(), list.end());
+  return list;
+}
+
+TEST(EventsTests, LevelFollowsActiveEvents) {
+  init_events();
+  reset_all_events();
+  EXPECT_EQ(get_event_level(), EVENT_LEVEL_INFO);
+
+  set_event(EVENT_CPU_OVERHEATING, 0);  // Warning
+  EXPECT_EQ(get_event_level(), EVENT_LEVEL_WARNING);
+  set_event(EVENT_CAN_BATTERY_MISSING, 0);  // Error
+  set_event(EVENT_CAN_BATTERY_MISSING, 0);
+  EXPECT_EQ(get_event_level(), EVENT_LEVEL_ERROR);
+
+  clear_event(EVENT_CAN_BATTERY_MISSING);
+  EXPECT_EQ(get_event_level(), EVENT_LEVEL_WARNING);
+  clear_event(EVENT_CAN_BATTERY_MISSING);
+  EXPECT_EQ(get_event_level(), EVENT_LEVEL_WARNING);
+  clear_event(EVENT_CPU_OVERHEATING);
+  EXPECT_EQ(get_event_level(), EVENT_LEVEL_INFO);
+
+  // Latched events are not cleared
+  set_event_latched(EVENT_GPIO_CONFLICT, 0);
+  clear_event(EVENT_GPIO_CONFLICT);
+  EXPECT_EQ(get_event_level(), EVENT_LEVEL_ERROR);
+  reset_all_events();
+  EXPECT_EQ(get_event_level(), EVENT_LEVEL_INFO);
+}
+
+TEST(EventsTests, ListIsOrderedByLastSet) {
+  init_events();
+  reset_all_events();
+  EXPECT_TRUE(newest_first().empty());
+
+  set_millis64(1000);
+  set_event(EVENT_WIFI_CONNECT, 0);
+  set_millis64(2000);
+  set_event(EVENT_MQTT_CONNECT, 0);
+  set_millis64(3000);
+  set_event(EVENT_PAUSE_END, 0);
+  EXPECT_EQ(newest_first(), (std::vector<EVENTS_ENUM_TYPE>{EVENT_PAUSE_END, EVENT_MQTT_CONNECT, EVENT_WIFI_CONNECT}));
+
+  // Setting an active event again moves it to the front, clearing it keeps it in the list
+  set_millis64(4000);
+  set_event(EVENT_MQTT_CONNECT, 0);
+  clear_event(EVENT_MQTT_CONNECT);
+  set_millis64(5000);
+  set_event(EVENT_WIFI_CONNECT, 0);
+  EXPECT_EQ(newest_first(), (std::vector<EVENTS_ENUM_TYPE>{EVENT_WIFI_CONNECT, EVENT_MQTT_CONNECT, EVENT_PAUSE_END}));
+  EXPECT_EQ(oldest_first(), (std::vector<EVENTS_ENUM_TYPE>{EVENT_PAUSE_END, EVENT_MQTT_CONNECT, EVENT_WIFI_CONNECT}));
+
+  // At most as many as asked for, the newest ones
+  EVENTS_ENUM_TYPE newest[2];
+  ASSERT_EQ(get_events_newest_first(newest, 2), 2u);
+  EXPECT_EQ(newest[0], EVENT_WIFI_CONNECT);
+  EXPECT_EQ(newest[1], EVENT_MQTT_CONNECT);
+
+  reset_all_events();
+  EXPECT_TRUE(newest_first().empty());
+}
+
+TEST(EventsTests, HistoryKeepsOccurrences) {
+  init_events();
+  reset_all_events();
+  EVENT_OCCURRENCE_TYPE history[8];
+  uint32_t next;
+  EXPECT_EQ(get_event_history(0, history, 8, next), 0u);
+  const uint32_t start = next;
+
+  set_millis64(100);
+  set_event(EVENT_WIFI_CONNECT, 1);
+  set_event(EVENT_WIFI_CONNECT, 2);  // Still active, not a new occurrence
+  clear_event(EVENT_WIFI_CONNECT);
+  set_millis64(200);
+  set_event(EVENT_WIFI_CONNECT, 3);
+  set_event(EVENT_MQTT_CONNECT, 4);
+
+  ASSERT_EQ(get_event_history(start, history, 8, next), 3u);
+  EXPECT_EQ(next, start + 3);
+  EXPECT_EQ(history[0].sequence, start);
+  EXPECT_EQ(history[0].timestamp, 100u);
+  EXPECT_EQ(history[0].event, EVENT_WIFI_CONNECT);
+  EXPECT_EQ(history[0].data, 1);
+  EXPECT_EQ(history[1].timestamp, 200u);
+  EXPECT_EQ(history[2].event, EVENT_MQTT_CONNECT);
+  EXPECT_EQ(history[2].data, 4);
+
+  // Paging
+  ASSERT_EQ(get_event_history(start, history, 2, next), 2u);
+  EXPECT_EQ(next, start + 2);
+  ASSERT_EQ(get_event_history(next, history, 2, next), 1u);
+  EXPECT_EQ(history[0].event, EVENT_MQTT_CONNECT);
+  EXPECT_EQ(get_event_history(next, history, 2, next), 0u);
+  EXPECT_EQ(next, start + 3);
+}
+
+TEST(EventsTests, HistoryDropsOldestWhenFull) {
+  init_events();
+  reset_all_events();
+  uint32_t start;
+  EVENT_OCCURRENCE_TYPE history[EVENT_HISTORY_SIZE / 8];
+  get_event_history(0, history, 0, start);
+
+  const int count = EVENT_HISTORY_SIZE / 10;
+  for (int i = 0; i < count; i++) {
+    set_event(EVENT_WIFI_CONNECT, i);
+    clear_event(EVENT_WIFI_CONNECT);
+  }
+
+  uint32_t next;
+  const size_t kept = get_event_history(start, history, EVENT_HISTORY_SIZE / 8, next);
+  EXPECT_GT(kept, 0u);
+  EXPECT_LT(kept, (size_t)count);
+  EXPECT_EQ(next, start + count);
+  EXPECT_EQ(history[kept - 1].sequence, start + count - 1);
+  EXPECT_EQ(history[kept - 1].data, (uint8_t)(count - 1));
+}
@@ -0,0 +1,132 @@
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <string>
+#include "../Software/src/devboard/webserver/html_stream.h"
+
+// Reads the whole page in chunks of at most chunk bytes
+static std::string read_page(HtmlPageStream& page, size_t chunk) {
+  std::string result;
+  uint8_t buffer[256];
+  size_t length;
+  while ((length = page.read(buffer, chunk)) > 0) {
+    EXPECT_LE(length, chunk);
+    result.append(reinterpret_cast<char*>(buffer), length);
+  }
+  return result;
+}
+
+TEST(HtmlWriterTests, Numbers) {
+  char buffer[128];
+  HtmlWriter out(buffer, sizeof(buffer));
+  out.print(static_cast<int16_t>(-12));
+  out.print(' ');
+  out.print(static_cast<uint32_t>(4000000000u));
+  out.print(' ');
+  out.print(static_cast<uint8_t>(7));
+  out.print(' ');
+  out.print(12.345f, 1);
+  out.print(' ');
+  out.print(-99.0, 0);
+  out.printf(" %s=%d", "x", 3);
+  EXPECT_STREQ(out.c_str(), "-12 4000000000 7 12.3 -99 x=3");
+  EXPECT_EQ(out.length(), strlen(buffer));
+  EXPECT_FALSE(out.overflowed());
+}
+
+TEST(HtmlWriterTests, Escaped) {
+  char buffer[128];
+  HtmlWriter out(buffer, sizeof(buffer));
+  out.print_escaped("<a href=\"x\">Tom & Jerry's</a>");
+  EXPECT_STREQ(out.c_str(), "&lt;a href=&quot;x&quot;&gt;Tom &amp; Jerry&#39;s&lt;/a&gt;");
+}
+
+TEST(HtmlWriterTests, Overflow) {
+  char buffer[8];
+  HtmlWriter out(buffer, sizeof(buffer));
+  out.print("abcd");
+  EXPECT_EQ(out.room(), 3u);
+  out.print("efgh");
+  EXPECT_TRUE(out.overflowed());
+  EXPECT_STREQ(out.c_str(), "abcdefg");
+
+  out.reset();
+  out.printf("%d", 123456789);
+  EXPECT_TRUE(out.overflowed());
+  EXPECT_STREQ(out.c_str(), "1234567");
+  EXPECT_EQ(out.room(), 0u);
+}
+
+TEST(HtmlWriterTests, Rewind) {
+  char buffer[8];
+  HtmlWriter out(buffer, sizeof(buffer));
+  out.print("abc");
+  const size_t mark = out.length();
+  out.print("defghij");
+  EXPECT_TRUE(out.overflowed());
+  out.rewind(mark);
+  EXPECT_FALSE(out.overflowed());
+  EXPECT_STREQ(out.c_str(), "abc");
+}
+
+TEST(HtmlPageStreamTests, StaticAndDynamicParts) {
+  HtmlPageStream page;
+  int value = 42;
+  page.add("<p>");
+  page.add([&value](HtmlWriter& out) {
+    out.print(value);
+    return true;
+  });
+  page.add("</p>");
+
+  // The value is read when its turn comes, not when the page is built
+  value = 43;
+  EXPECT_EQ(read_page(page, 3), "<p>43</p>");
+  EXPECT_EQ(page.overflows(), 0);
+
+  uint8_t buffer[4];
+  EXPECT_EQ(page.read(buffer, sizeof(buffer)), 0u);
+}
+
+TEST(HtmlPageStreamTests, PartOverSeveralTurns) {
+  HtmlPageStream page;
+  std::string expected;
+  for (int i = 0; i < 1000; i++) {
+    expected += std::to_string(i) + ",";
+  }
+
+  int calls = 0;
+  page.add("[");
+  page.add([next = 0, &calls](HtmlWriter& out) mutable {
+    calls++;
+    for (; next < 1000 && out.room() > 8; next++) {
+      out.print(next);
+      out.print(',');
+    }
+    return next >= 1000;
+  });
+  page.add("]");
+
+  EXPECT_EQ(read_page(page, 100), "[" + expected + "]");
+  EXPECT_GT(calls, 1);
+  EXPECT_EQ(page.overflows(), 0);
+}
+
+TEST(HtmlPageStreamTests, EmptyPartsAreSkipped) {
+  HtmlPageStream page;
+  page.add("");
+  page.add([](HtmlWriter& out) { return false; });
+  page.add("end");
+  EXPECT_EQ(read_page(page, 16), "end");
+}
+
+TEST(HtmlPageStreamTests, OverflowIsCounted) {
+  HtmlPageStream page;
+  const std::string text(HTML_STREAM_BUFFER_SIZE + 10, 'x');
+  page.add([&text](HtmlWriter& out) {
+    out.print(text.c_str());
+    return true;
+  });
+  EXPECT_EQ(read_page(page, 256).size(), HTML_STREAM_BUFFER_SIZE - 1u);
+  EXPECT_EQ(page.overflows(), 1);
+}
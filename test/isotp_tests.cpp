@@ -0,0 +1,216 @@
+#include <gtest/gtest.h>
+
+#include <vector>
+#include "../Software/src/communication/can/isotp.h"
+
+static CAN_frame frame(uint32_t id, std::vector<uint8_t> bytes) {
+  CAN_frame result = {};
+  result.ID = id;
+  result.DLC = bytes.size();
+  result.FD = bytes.size() > 8;
+  std::copy(bytes.begin(), bytes.end(), result.data.u8);
+  return result;
+}
+
+static std::vector<uint8_t> bytes(const CAN_frame& frame) {
+  return std::vector<uint8_t>(frame.data.u8, frame.data.u8 + frame.DLC);
+}
+
+static IsoTpConfig obd_config() {
+  IsoTpConfig config;
+  config.tx_id = 0x7E4;
+  config.rx_id = 0x7EC;
+  return config;
+}
+
+class IsoTpTests : public testing::Test {
+ protected:
+  void SetUp() override {
+    session.set_sender([this](const CAN_frame& frame) { sent.push_back(frame); });
+    session.on_receive([this](IsoTpResult result, size_t length, uint32_t) {
+      results.push_back(result);
+      lengths.push_back(length);
+    });
+  }
+
+  IsoTpConfig config = obd_config();
+  uint8_t buffer[64];
+  IsoTpSession session{config, buffer, sizeof(buffer)};
+  std::vector<CAN_frame> sent;
+  std::vector<IsoTpResult> results;
+  std::vector<size_t> lengths;
+};
+
+TEST_F(IsoTpTests, SingleFrames) {
+  const uint8_t request[] = {0x22, 0x01, 0x01};
+  ASSERT_TRUE(session.send(request, sizeof(request), 0));
+  ASSERT_EQ(sent.size(), 1u);
+  EXPECT_EQ(sent[0].ID, 0x7E4u);
+  EXPECT_EQ(bytes(sent[0]), (std::vector<uint8_t>{0x03, 0x22, 0x01, 0x01, 0xAA, 0xAA, 0xAA, 0xAA}));
+  EXPECT_FALSE(session.sending());
+
+  EXPECT_FALSE(session.handle_frame(frame(0x7ED, {0x03, 0x62, 0x01, 0x01}), 20));
+  EXPECT_TRUE(session.handle_frame(frame(0x7EC, {0x05, 0x62, 0x01, 0x01, 0x12, 0x34, 0xAA, 0xAA}), 20));
+  ASSERT_EQ(results.size(), 1u);
+  EXPECT_EQ(results[0], IsoTpResult::Ok);
+  EXPECT_EQ(lengths[0], 5u);
+  EXPECT_EQ(buffer[4], 0x34);
+  EXPECT_EQ(session.stats().last_latency_ms, 20);
+}
+
+TEST_F(IsoTpTests, ReceivesInBlocks) {
+  config.block_size = 2;
+  config.st_min_ms = 5;
+  IsoTpSession blocks(config, buffer, sizeof(buffer));
+  blocks.set_sender([this](const CAN_frame& frame) { sent.push_back(frame); });
+  size_t received = 0;
+  blocks.on_receive([&received](IsoTpResult result, size_t length, uint32_t) { received = length; });
+
+  blocks.handle_frame(frame(0x7EC, {0x10, 0x1A, 0, 1, 2, 3, 4, 5}), 0);
+  ASSERT_EQ(sent.size(), 1u);
+  EXPECT_EQ(bytes(sent[0]), (std::vector<uint8_t>{0x30, 0x02, 0x05, 0xAA, 0xAA, 0xAA, 0xAA, 0xAA}));
+  blocks.handle_frame(frame(0x7EC, {0x21, 6, 7, 8, 9, 10, 11, 12}), 5);
+  EXPECT_EQ(sent.size(), 1u);
+  blocks.handle_frame(frame(0x7EC, {0x22, 13, 14, 15, 16, 17, 18, 19}), 10);
+  EXPECT_EQ(sent.size(), 2u);  // Next block
+  EXPECT_TRUE(blocks.receiving());
+  blocks.handle_frame(frame(0x7EC, {0x23, 20, 21, 22, 23, 24, 25, 0xAA}), 15);
+  EXPECT_FALSE(blocks.receiving());
+  EXPECT_EQ(received, 26u);
+  for (int i = 0; i < 26; i++) {
+    EXPECT_EQ(buffer[i], i);
+  }
+}
+
+TEST_F(IsoTpTests, WrongSequenceAbortsReception) {
+  session.handle_frame(frame(0x7EC, {0x10, 0x10, 0, 1, 2, 3, 4, 5}), 0);
+  session.handle_frame(frame(0x7EC, {0x22, 6, 7, 8, 9, 10, 11, 12}), 5);
+  ASSERT_EQ(results.size(), 1u);
+  EXPECT_EQ(results[0], IsoTpResult::WrongSequence);
+  EXPECT_EQ(session.stats().errors, 1u);
+
+  // Later consecutive frames are ignored
+  session.handle_frame(frame(0x7EC, {0x23, 6, 7, 8, 9, 10, 11, 12}), 10);
+  EXPECT_EQ(results.size(), 1u);
+}
+
+TEST_F(IsoTpTests, TooLongForBuffer) {
+  session.handle_frame(frame(0x7EC, {0x10, 0x41, 0, 1, 2, 3, 4, 5}), 0);  // 65 bytes
+  ASSERT_EQ(sent.size(), 1u);
+  EXPECT_EQ(sent[0].data.u8[0], 0x32);  // Overflow
+  ASSERT_EQ(results.size(), 1u);
+  EXPECT_EQ(results[0], IsoTpResult::Overflow);
+}
+
+TEST_F(IsoTpTests, ReceptionTimesOut) {
+  session.handle_frame(frame(0x7EC, {0x10, 0x10, 0, 1, 2, 3, 4, 5}), 0);
+  session.service(ISOTP_TIMEOUT_MS - 1);
+  EXPECT_TRUE(results.empty());
+  session.service(ISOTP_TIMEOUT_MS);
+  ASSERT_EQ(results.size(), 1u);
+  EXPECT_EQ(results[0], IsoTpResult::Timeout);
+  EXPECT_EQ(session.stats().timeouts, 1u);
+}
+
+TEST_F(IsoTpTests, SendsPacedByFlowControl) {
+  uint8_t message[21];
+  for (int i = 0; i < 21; i++) {
+    message[i] = i;
+  }
+  std::vector<IsoTpResult> sends;
+  session.on_sent([&sends](IsoTpResult result, uint32_t) { sends.push_back(result); });
+
+  ASSERT_TRUE(session.send(message, sizeof(message), 0));
+  EXPECT_FALSE(session.send(message, sizeof(message), 0));  // Busy
+  ASSERT_EQ(sent.size(), 1u);
+  EXPECT_EQ(bytes(sent[0]), (std::vector<uint8_t>{0x10, 0x15, 0, 1, 2, 3, 4, 5}));
+
+  session.service(10);
+  EXPECT_EQ(sent.size(), 1u);  // Waiting for flow control
+  session.handle_frame(frame(0x7EC, {0x31, 0x00, 0x00}), 10);  // Wait
+  session.handle_frame(frame(0x7EC, {0x30, 0x01, 0x14}), 20);  // One frame per block, 20 ms apart
+  session.service(20);
+  ASSERT_EQ(sent.size(), 2u);
+  EXPECT_EQ(bytes(sent[1]), (std::vector<uint8_t>{0x21, 6, 7, 8, 9, 10, 11, 12}));
+  session.service(40);
+  EXPECT_EQ(sent.size(), 2u);
+
+  session.handle_frame(frame(0x7EC, {0x30, 0x00, 0x14}), 50);
+  session.service(50);
+  session.service(60);
+  EXPECT_EQ(sent.size(), 3u);
+  session.service(70);
+  ASSERT_EQ(sent.size(), 4u);
+  EXPECT_EQ(bytes(sent[3]), (std::vector<uint8_t>{0x23, 20, 0xAA, 0xAA, 0xAA, 0xAA, 0xAA, 0xAA}));
+  ASSERT_EQ(sends.size(), 1u);
+  EXPECT_EQ(sends[0], IsoTpResult::Ok);
+  EXPECT_FALSE(session.sending());
+}
+
+TEST_F(IsoTpTests, SendWithoutFlowControlTimesOut) {
+  uint8_t message[10] = {};
+  std::vector<IsoTpResult> sends;
+  session.on_sent([&sends](IsoTpResult result, uint32_t) { sends.push_back(result); });
+  ASSERT_TRUE(session.send(message, sizeof(message), 0));
+  session.service(ISOTP_TIMEOUT_MS);
+  ASSERT_EQ(sends.size(), 1u);
+  EXPECT_EQ(sends[0], IsoTpResult::Timeout);
+  EXPECT_FALSE(session.sending());
+}
+
+TEST_F(IsoTpTests, ExtendedAddressingAndCanFd) {
+  config.tx_id = 0x6F4;
+  config.rx_id = 0x607;
+  config.tx_extension = 0x07;
+  config.rx_extension = 0xF4;
+  config.FD = true;
+  IsoTpSession sme(config, buffer, sizeof(buffer));
+  sme.set_sender([this](const CAN_frame& frame) { sent.push_back(frame); });
+  size_t received = 0;
+  sme.on_receive([&received](IsoTpResult, size_t length, uint32_t) { received = length; });
+
+  const uint8_t request[] = {0x22, 0xE5, 0x61};
+  sme.send(request, sizeof(request), 0);
+  ASSERT_EQ(sent.size(), 1u);
+  EXPECT_TRUE(sent[0].FD);
+  EXPECT_EQ(bytes(sent[0]), (std::vector<uint8_t>{0x07, 0x03, 0x22, 0xE5, 0x61, 0xAA, 0xAA, 0xAA}));
+
+  EXPECT_FALSE(sme.handle_frame(frame(0x607, {0xF5, 0x03, 0x62, 0x00, 0x00}), 5));  // Another address
+  EXPECT_TRUE(sme.handle_frame(frame(0x607, {0xF4, 0x00, 0x07, 0x62, 0xE5, 0x61, 1, 2, 3, 4, 0xAA, 0xAA}), 5));
+  EXPECT_EQ(received, 7u);
+  EXPECT_EQ(buffer[6], 4);
+}
+
+TEST_F(IsoTpTests, TransportDispatchesToSessions) {
+  std::vector<CAN_frame> bus;
+  IsoTpTransport transport([&bus](const CAN_frame& frame) { bus.push_back(frame); });
+  IsoTpConfig first_config;
+  first_config.tx_id = 0x7E0;
+  first_config.rx_id = 0x7E8;
+  IsoTpConfig second_config = first_config;
+  second_config.tx_id = 0x7E1;
+  second_config.rx_id = 0x7E9;
+  uint8_t first_buffer[32];
+  uint8_t second_buffer[32];
+  IsoTpSession first(first_config, first_buffer, sizeof(first_buffer));
+  IsoTpSession second(second_config, second_buffer, sizeof(second_buffer));
+  ASSERT_TRUE(transport.add(&first));
+  ASSERT_TRUE(transport.add(&second));
+
+  // Both receive a multi-frame message at once
+  EXPECT_TRUE(transport.handle_frame(frame(0x7E8, {0x10, 0x08, 1, 1, 1, 1, 1, 1}), 0));
+  EXPECT_TRUE(transport.handle_frame(frame(0x7E9, {0x10, 0x08, 2, 2, 2, 2, 2, 2}), 0));
+  EXPECT_FALSE(transport.handle_frame(frame(0x7EA, {0x02, 0x01, 0x02}), 0));
+  ASSERT_EQ(bus.size(), 2u);
+  EXPECT_EQ(bus[0].ID, 0x7E0u);
+  EXPECT_EQ(bus[1].ID, 0x7E1u);
+  EXPECT_TRUE(first.receiving());
+  EXPECT_TRUE(second.receiving());
+
+  transport.handle_frame(frame(0x7E9, {0x21, 2, 2}), 1);
+  EXPECT_FALSE(second.receiving());
+  transport.service(ISOTP_TIMEOUT_MS);
+  EXPECT_FALSE(first.receiving());
+  EXPECT_EQ(first.stats().timeouts, 1u);
+  EXPECT_EQ(second.stats().received, 1u);
+}
@@ -0,0 +1,86 @@
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <cstring>
+#include "../Software/src/devboard/utils/json_writer.h"
+
+TEST(JsonWriterTests, ObjectsAndArrays) {
+  char buffer[128];
+  JsonWriter json(buffer, sizeof(buffer));
+  json.begin_object();
+  json.add("count", -12);
+  json.add_string("status", "Active");
+  json.begin_object("device");
+  json.add_bool("enabled", true);
+  json.end_object();
+  json.begin_array("cells");
+  json.element(1);
+  json.element_bool(false);
+  json.element_string("x");
+  json.end_array();
+  json.end_object();
+
+  EXPECT_STREQ(json.c_str(), R"({"count":-12,"status":"Active","device":{"enabled":true},"cells":[1,false,"x"]})");
+  EXPECT_EQ(json.length(), strlen(buffer));
+  EXPECT_FALSE(json.overflowed());
+}
+
+TEST(JsonWriterTests, KeySuffix) {
+  char buffer[64];
+  JsonWriter json(buffer, sizeof(buffer));
+  json.begin_object();
+  json.add("SOC", nullptr, 1);
+  json.add("SOC", "_2", 2);
+  json.end_object();
+  EXPECT_STREQ(json.c_str(), R"({"SOC":1,"SOC_2":2})");
+}
+
+TEST(JsonWriterTests, FixedPoint) {
+  char buffer[128];
+  JsonWriter json(buffer, sizeof(buffer));
+  json.begin_array();
+  json.element_fixed(3712, 3);
+  json.element_fixed(3005, 3);
+  json.element_fixed(3700, 3);
+  json.element_fixed(4000, 3);
+  json.element_fixed(-5, 1);
+  json.element_fixed(-215, 1);
+  json.element_fixed(5123, 2);
+  json.element_fixed(7, 0);
+  json.end_array();
+  EXPECT_STREQ(json.c_str(), "[3.712,3.005,3.7,4,-0.5,-21.5,51.23,7]");
+
+  json.reset();
+  json.begin_object();
+  json.add_float("cpu_temp", nullptr, 45.55f, 1);
+  json.add_float("nan", nullptr, NAN, 1);
+  json.add_unsigned("energy", 4000000000u);
+  json.end_object();
+  EXPECT_STREQ(json.c_str(), R"({"cpu_temp":45.6,"nan":null,"energy":4000000000})");
+}
+
+TEST(JsonWriterTests, EscapesStrings) {
+  char buffer[64];
+  JsonWriter json(buffer, sizeof(buffer));
+  json.begin_object();
+  json.add_string("message", "Say \"hi\"\\\n\t");
+  json.end_object();
+  EXPECT_STREQ(json.c_str(), R"({"message":"Say \"hi\"\\\n\u0009"})");
+}
+
+TEST(JsonWriterTests, OverflowIsReported) {
+  char buffer[16];
+  JsonWriter json(buffer, sizeof(buffer));
+  json.begin_array();
+  for (int i = 0; i < 10; i++) {
+    json.element(1000);
+  }
+  json.end_array();
+  EXPECT_TRUE(json.overflowed());
+  // Never written past the end, and still terminated
+  EXPECT_LT(strlen(buffer), sizeof(buffer));
+
+  json.reset();
+  EXPECT_FALSE(json.overflowed());
+  EXPECT_STREQ(json.c_str(), "");
+}
@@ -0,0 +1,71 @@
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <string>
+#include "../Software/src/devboard/webserver/live_data.h"
+
+TEST(LiveDataTests, Json) {
+  static DATALAYER_SNAPSHOT_TYPE snapshot;
+  snapshot.battery.status.real_soc = 5512;
+  snapshot.battery.status.reported_soc = 5000;
+  snapshot.battery.status.voltage_dV = 3712;
+  snapshot.battery.status.current_dA = -15;
+  snapshot.battery.status.cell_min_voltage_mV = 3700;
+  snapshot.battery.status.bms_status = FAULT;
+  snapshot.battery.info.number_of_cells = 96;
+  snapshot.battery2.status.bms_status = ACTIVE;
+  snapshot.system.status.contactors_engaged = 1;
+
+  char json[1024];
+  size_t length = live_data_json(json, sizeof(json), snapshot, 1);
+  ASSERT_GT(length, 0u);
+  EXPECT_EQ(length, strlen(json));
+  std::string text(json);
+  EXPECT_EQ(text.rfind("{\"v\":1,\"contactors\":1,", 0), 0u);
+  EXPECT_NE(text.find("\"soc\":55.12,\"soc_reported\":50,"), std::string::npos);
+  EXPECT_NE(text.find("\"voltage\":371.2,\"current\":-1.5,"), std::string::npos);
+  EXPECT_NE(text.find("\"cell_min\":3.7,"), std::string::npos);
+  EXPECT_NE(text.find("\"cells\":96,\"status\":\"FAULT\""), std::string::npos);
+  EXPECT_EQ(text.find("\"status\":\"OK\""), std::string::npos);
+
+  // One object per configured battery
+  length = live_data_json(json, sizeof(json), snapshot, 2);
+  EXPECT_NE(std::string(json).find("\"status\":\"OK\""), std::string::npos);
+
+  EXPECT_EQ(live_data_json(json, 64, snapshot, 1), 0u);
+}
+
+TEST(LiveDataTests, CellsPacked) {
+  static DATALAYER_BATTERY_TYPE battery;
+  battery.info.number_of_cells = 10;
+  for (int i = 0; i < 10; i++) {
+    battery.status.cell_voltages_mV[i] = 3600 + i;
+    battery.status.cell_balancing_status[i] = (i == 1 || i == 9);
+  }
+  battery.status.balancing_status = BALANCING_STATUS_ACTIVE;
+
+  uint8_t buffer[LIVE_CELLS_MAX_SIZE];
+  const size_t length = live_cells_pack(buffer, sizeof(buffer), battery, 2);
+  ASSERT_EQ(length, LIVE_CELLS_HEADER_SIZE + 20u + 2u);
+  EXPECT_EQ(buffer[0], LIVE_CELLS_VERSION);
+  EXPECT_EQ(buffer[1], 2);
+  EXPECT_EQ(buffer[2], LIVE_CELLS_FLAG_BALANCING_ACTIVE);
+  EXPECT_EQ(buffer[4] | (buffer[5] << 8), 10);
+  // 3609 mV of the last cell, little endian
+  EXPECT_EQ(buffer[6 + 18], 3609 & 0xFF);
+  EXPECT_EQ(buffer[6 + 19], 3609 >> 8);
+  EXPECT_EQ(buffer[26], 0x02);
+  EXPECT_EQ(buffer[27], 0x02);
+
+  EXPECT_EQ(live_cells_pack(buffer, length - 1, battery, 2), 0u);
+}
+
+TEST(LiveDataTests, SequenceCountsChanges) {
+  ChangeSequence sequence;
+  EXPECT_EQ(sequence.sequence(), 0u);
+  EXPECT_EQ(sequence.update("abc", 3), 1u);
+  EXPECT_EQ(sequence.update("abc", 3), 1u);
+  EXPECT_EQ(sequence.update("abd", 3), 2u);
+  EXPECT_EQ(sequence.update("abd", 3), 2u);
+  EXPECT_EQ(sequence.sequence(), 2u);
+}
@@ -0,0 +1,134 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include "../Software/src/devboard/utils/log_ring.h"
+
+typedef LogRing<256> SmallRing;
+
+static std::string read_all(const SmallRing& ring, SmallRing::Cursor& cursor, std::vector<uint32_t>* sequences) {
+  std::string text;
+  char buffer[SmallRing::MAX_RECORD];
+  size_t length;
+  uint32_t sequence;
+  while (ring.read(cursor, buffer, sizeof(buffer), length, sequence)) {
+    text.append(buffer, length);
+    if (sequences) {
+      sequences->push_back(sequence);
+    }
+  }
+  return text;
+}
+
+TEST(LogRingTests, ReadsRecordsInOrder) {
+  SmallRing ring;
+  EXPECT_EQ(ring.append("abc", 3), 0u);
+  EXPECT_EQ(ring.append("defgh", 5), 1u);
+  EXPECT_EQ(ring.append("", 0), 2u);
+  EXPECT_EQ(ring.end_sequence(), 3u);
+
+  SmallRing::Cursor cursor = ring.oldest();
+  std::vector<uint32_t> sequences;
+  EXPECT_EQ(read_all(ring, cursor, &sequences), "abcdefgh");
+  EXPECT_EQ(sequences, (std::vector<uint32_t>{0, 1, 2}));
+  EXPECT_EQ(cursor.sequence, 3u);
+
+  // The cursor continues with records appended later
+  ring.append("ij", 2);
+  EXPECT_EQ(read_all(ring, cursor, nullptr), "ij");
+}
+
+TEST(LogRingTests, OverwritesOldestRecords) {
+  SmallRing ring;
+  SmallRing::Cursor cursor = ring.oldest();
+  char record[12];
+  // 5 words per record, so the 64 word ring holds the last 12 of them
+  for (uint32_t i = 0; i < 30; i++) {
+    snprintf(record, sizeof(record), "%011u", i);
+    ring.append(record, sizeof(record));
+  }
+
+  std::vector<uint32_t> sequences;
+  const std::string text = read_all(ring, cursor, &sequences);
+  ASSERT_EQ(sequences.size(), 12u);
+  for (size_t i = 0; i < sequences.size(); i++) {
+    EXPECT_EQ(sequences[i], 18 + i);
+  }
+  EXPECT_EQ(text.substr(0, 11), "00000000018");
+  EXPECT_EQ(cursor.sequence, 30u);
+}
+
+TEST(LogRingTests, CutsLongRecords) {
+  SmallRing ring;
+  std::string long_record(SmallRing::MAX_RECORD + 10, 'x');
+  ring.append(long_record.data(), long_record.size());
+
+  SmallRing::Cursor cursor = ring.oldest();
+  EXPECT_EQ(read_all(ring, cursor, nullptr).size(), SmallRing::MAX_RECORD);
+}
+
+TEST(LogRingTests, ClearDropsRecords) {
+  SmallRing ring;
+  ring.append("old", 3);
+  SmallRing::Cursor cursor = ring.oldest();
+  ring.clear();
+  EXPECT_EQ(read_all(ring, cursor, nullptr), "");
+
+  ring.append("new", 3);
+  EXPECT_EQ(read_all(ring, cursor, nullptr), "new");
+  // Sequence numbers carry on, so pages polling since a number see the new records
+  EXPECT_EQ(cursor.sequence, 2u);
+}
+
+TEST(LogRingTests, ReaderNeverSeesTornRecords) {
+  static SmallRing ring;
+  std::atomic<bool> done{false};
+
+  // Each record repeats one character, its length and character follow from the sequence number
+  std::thread writer([&] {
+    char record[SmallRing::MAX_RECORD];
+    for (uint32_t i = 0; i < 1000000; i++) {
+      const size_t length = 1 + i % 64;
+      memset(record, 'a' + i % 26, length);
+      ring.append(record, length);
+    }
+    done = true;
+  });
+
+  uint32_t records = 0;
+  uint32_t bad = 0;
+  uint32_t out_of_order = 0;
+  SmallRing::Cursor cursor = ring.oldest();
+  char buffer[SmallRing::MAX_RECORD];
+  size_t length;
+  uint32_t sequence;
+  uint32_t last = 0;
+  bool first = true;
+  while (!done || ring.read(cursor, buffer, sizeof(buffer), length, sequence)) {
+    if (!ring.read(cursor, buffer, sizeof(buffer), length, sequence)) {
+      continue;
+    }
+    records++;
+    if (!first && sequence <= last) {
+      out_of_order++;
+    }
+    first = false;
+    last = sequence;
+    if (length != 1 + sequence % 64) {
+      bad++;
+      continue;
+    }
+    for (size_t i = 0; i < length; i++) {
+      if (buffer[i] != (char)('a' + sequence % 26)) {
+        bad++;
+        break;
+      }
+    }
+  }
+  writer.join();
+
+  EXPECT_GT(records, 0u);
+  EXPECT_EQ(bad, 0u);
+  EXPECT_EQ(out_of_order, 0u);
+}
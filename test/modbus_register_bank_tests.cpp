@@ -0,0 +1,89 @@
+#include <gtest/gtest.h>
+
+#include "../Software/src/inverter/BYD-MODBUS.h"
+#include "../Software/src/inverter/ModbusRegisterBank.h"
+
+TEST(ModbusRegisterBankTests, FindsRangesInsideOneWindow) {
+  ModbusRegisterBank bank;
+  ASSERT_TRUE(bank.add_window(100, 10));
+  ASSERT_TRUE(bank.add_window(200, 5));
+
+  EXPECT_NE(bank.find(100, 10), nullptr);
+  EXPECT_EQ(bank.find(200, 5), bank.find(200, 1));
+  EXPECT_EQ(bank.find(105, 6), nullptr);  // Runs past the end of the window
+  EXPECT_EQ(bank.find(99, 2), nullptr);
+  EXPECT_EQ(bank.find(150, 1), nullptr);
+}
+
+TEST(ModbusRegisterBankTests, RejectsOverlappingAndOversizedWindows) {
+  ModbusRegisterBank bank;
+  ASSERT_TRUE(bank.add_window(100, 10));
+
+  EXPECT_FALSE(bank.add_window(109, 5));
+  EXPECT_FALSE(bank.add_window(90, 11));
+  EXPECT_FALSE(bank.add_window(1000, MODBUS_REGISTER_BANK_SIZE));
+  EXPECT_FALSE(bank.add_window(0xFFFF, 2));
+  EXPECT_TRUE(bank.add_window(110, 1));
+}
+
+TEST(ModbusRegisterBankTests, UnmappedRegistersAreNotStored) {
+  ModbusRegisterBank bank;
+  bank.add_window(300, 2);
+
+  bank[300] = 1234;
+  bank[5000] = 42;
+
+  EXPECT_EQ(bank[300], 1234);
+  EXPECT_EQ(bank[5000], 0);
+}
+
+class TestBydModbusInverter : public BydModbusInverter {
+ public:
+  ModbusMessage request(ModbusMessage msg) { return MBserver.localRequest(msg); }
+  uint16_t& reg(uint16_t addr) { return mbPV[addr]; }
+};
+
+TEST(ModbusRegisterBankTests, ServesReadsAndWrites) {
+  TestBydModbusInverter inverter;
+  inverter.reg(300) = 0x0102;
+  inverter.reg(301) = 0x0304;
+
+  ModbusMessage read;
+  read.add((uint8_t)21, (uint8_t)READ_HOLD_REGISTER, (uint16_t)300, (uint16_t)2);
+  ModbusMessage response = inverter.request(read);
+  ASSERT_EQ(response.getError(), SUCCESS);
+  ASSERT_EQ(response.size(), 7);
+  EXPECT_EQ(response[2], 4);
+  EXPECT_EQ(response[3], 0x01);
+  EXPECT_EQ(response[4], 0x02);
+  EXPECT_EQ(response[5], 0x03);
+  EXPECT_EQ(response[6], 0x04);
+
+  ModbusMessage write;
+  write.add((uint8_t)21, (uint8_t)WRITE_MULT_REGISTERS, (uint16_t)400, (uint16_t)2, (uint8_t)4);
+  write.add((uint16_t)0x00FF, (uint16_t)0xFF00);
+  ASSERT_EQ(inverter.request(write).getError(), SUCCESS);
+  EXPECT_EQ(inverter.reg(400), 0x00FF);
+  EXPECT_EQ(inverter.reg(401), 0xFF00);
+
+  ModbusMessage read_write;
+  read_write.add((uint8_t)21, (uint8_t)R_W_MULT_REGISTERS, (uint16_t)401, (uint16_t)1, (uint16_t)401, (uint16_t)1);
+  read_write.add((uint8_t)2, (uint16_t)0xABCD);
+  response = inverter.request(read_write);
+  ASSERT_EQ(response.getError(), SUCCESS);
+  EXPECT_EQ(response[3], 0xAB);
+  EXPECT_EQ(response[4], 0xCD);
+}
+
+TEST(ModbusRegisterBankTests, RejectsUnmappedAddresses) {
+  TestBydModbusInverter inverter;
+
+  ModbusMessage read;
+  read.add((uint8_t)21, (uint8_t)READ_HOLD_REGISTER, (uint16_t)320, (uint16_t)10);
+  EXPECT_EQ(inverter.request(read).getError(), ILLEGAL_DATA_ADDRESS);
+
+  ModbusMessage write;
+  write.add((uint8_t)21, (uint8_t)WRITE_HOLD_REGISTER, (uint16_t)20000, (uint16_t)1);
+  EXPECT_EQ(inverter.request(write).getError(), ILLEGAL_DATA_ADDRESS);
+  EXPECT_EQ(inverter.reg(20000), 0);
+}
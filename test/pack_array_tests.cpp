@@ -0,0 +1,208 @@
+#include <gtest/gtest.h>
+
+#include "../Software/src/datalayer/pack_array.h"
+#include "../Software/src/devboard/utils/events.h"
+
+class PackArrayTests : public testing::Test {
+ protected:
+  DATALAYER_BATTERY_TYPE batteries[MAX_PACKS]{};
+  bool allowed[MAX_PACKS]{};
+  bool engaged[MAX_PACKS]{};
+  PackArray packs;
+
+  void add_packs(uint8_t count) {
+    for (uint8_t i = 0; i < count; i++) {
+      DATALAYER_BATTERY_TYPE& battery = batteries[i];
+      battery.status.voltage_dV = 3700;
+      battery.status.bms_status = ACTIVE;
+      battery.status.real_soc = 5000;
+      battery.status.max_charge_power_W = 10000;
+      battery.status.max_discharge_power_W = 10000;
+      battery.info.total_capacity_Wh = 30000;
+      battery.status.remaining_capacity_Wh = 15000;
+      battery.settings.max_user_set_charge_dA = 10000;
+      battery.settings.max_user_set_discharge_dA = 10000;
+      battery.settings.soc_scaling_active = false;
+      allowed[i] = false;
+      engaged[i] = false;
+      ASSERT_TRUE(packs.add(battery, i == 0 ? nullptr : &allowed[i], i == 0 ? nullptr : &engaged[i]));
+    }
+  }
+
+  // The contactors of the allowed packs close, as handle_contactors does between two updates
+  void close_allowed() {
+    for (uint8_t i = 0; i < MAX_PACKS; i++) {
+      engaged[i] = allowed[i];
+    }
+  }
+};
+
+TEST_F(PackArrayTests, SinglePackAsBefore) {
+  add_packs(1);
+  batteries[0].status.current_dA = -100;
+  packs.update();
+  EXPECT_EQ(batteries[0].status.max_charge_current_dA, 270);
+  EXPECT_EQ(batteries[0].status.max_discharge_current_dA, 270);
+  EXPECT_EQ(batteries[0].status.active_power_W, -3700);
+  EXPECT_EQ(batteries[0].status.reported_soc, 5000);
+  EXPECT_EQ(batteries[0].info.reported_total_capacity_Wh, 30000);
+  EXPECT_TRUE(batteries[0].settings.inverter_limits_discharge);
+
+  batteries[0].settings.soc_scaling_active = true;
+  batteries[0].settings.min_percentage = 1000;
+  batteries[0].settings.max_percentage = 9000;
+  packs.update();
+  EXPECT_EQ(batteries[0].status.reported_soc, 5000);
+  EXPECT_EQ(batteries[0].info.reported_total_capacity_Wh, 24000);
+  EXPECT_EQ(batteries[0].status.reported_remaining_capacity_Wh, 12000);
+}
+
+TEST_F(PackArrayTests, PacksInSyncJoinUpToEight) {
+  for (uint8_t count = 1; count <= MAX_PACKS; count++) {
+    packs.clear();
+    add_packs(count);
+    packs.update();
+    close_allowed();
+    packs.update();
+    EXPECT_EQ(packs.totals().packs, count);
+    EXPECT_EQ(packs.totals().joined, count);
+    EXPECT_EQ(packs.totals().total_capacity_Wh, 30000u * count);
+    EXPECT_EQ(batteries[0].info.reported_total_capacity_Wh, 30000u * count);
+    EXPECT_EQ(batteries[0].status.reported_remaining_capacity_Wh, 15000u * count);
+    EXPECT_EQ(batteries[0].status.max_charge_current_dA, 270 * count);
+    EXPECT_EQ(packs.totals().max_charge_power_W, 10000u * count);
+  }
+  EXPECT_FALSE(packs.add(batteries[0], &allowed[0]));
+}
+
+TEST_F(PackArrayTests, PackOutOfSyncIsLetGoAfterTimeout) {
+  add_packs(3);
+  packs.update();
+  ASSERT_TRUE(allowed[1]);
+  ASSERT_TRUE(allowed[2]);
+
+  batteries[2].status.voltage_dV = 3750;
+  for (int second = 0; second < PACK_OUT_OF_SYNC_S; second++) {
+    packs.update();
+    EXPECT_TRUE(allowed[2]);
+  }
+  EXPECT_EQ(get_event_pointer(EVENT_VOLTAGE_DIFFERENCE)->data, 5);
+  packs.update();
+  EXPECT_FALSE(allowed[2]);
+  EXPECT_TRUE(allowed[1]);
+  EXPECT_EQ(packs.totals().max_voltage_difference_dV, 50);
+
+  // Back in sync, it may join again
+  batteries[2].status.voltage_dV = 3710;
+  packs.update();
+  EXPECT_TRUE(allowed[2]);
+  EXPECT_EQ(packs.totals().max_voltage_difference_dV, 0);
+}
+
+TEST_F(PackArrayTests, MainPackInFaultLetsOthersGo) {
+  add_packs(4);
+  packs.update();
+  batteries[0].status.bms_status = FAULT;
+  packs.update();
+  for (uint8_t i = 1; i < 4; i++) {
+    EXPECT_FALSE(allowed[i]);
+  }
+}
+
+TEST_F(PackArrayTests, CurrentLimitIsWeakestPackTimesJoined) {
+  add_packs(3);
+  batteries[1].status.max_charge_power_W = 3700;
+  batteries[2].status.voltage_dV = 3710;
+  packs.update();
+  close_allowed();
+  packs.update();
+  EXPECT_EQ(batteries[0].status.max_charge_current_dA, 100 * 3);
+  EXPECT_EQ(batteries[0].status.max_discharge_current_dA, 269 * 3);
+  // The same for power, each pack keeps its own
+  EXPECT_EQ(packs.totals().max_charge_power_W, 3700u * 3);
+  EXPECT_EQ(packs.totals().max_discharge_power_W, 10000u * 3);
+  EXPECT_EQ(batteries[0].status.max_charge_power_W, 10000u);
+
+  batteries[0].settings.remote_settings_limit_discharge = true;
+  batteries[0].settings.max_remote_set_discharge_dA = 500;
+  batteries[0].settings.max_remote_set_charge_dA = 1000;
+  packs.update();
+  EXPECT_EQ(batteries[0].status.max_discharge_current_dA, 500);
+
+  // A pack not allowed to close its contactors does not count
+  allowed[1] = false;
+  batteries[1].status.voltage_dV = 3500;
+  packs.update();
+  EXPECT_EQ(batteries[0].status.max_charge_current_dA, 269 * 2);
+}
+
+TEST_F(PackArrayTests, AllowedButNotEngagedDoesNotCount) {
+  add_packs(2);
+  packs.update();
+  ASSERT_TRUE(allowed[1]);
+  // Still open or precharging, the main pack would carry all of the current
+  EXPECT_EQ(packs.totals().joined, 1);
+  EXPECT_EQ(batteries[0].status.max_charge_current_dA, 270);
+  EXPECT_EQ(packs.totals().max_discharge_power_W, 10000u);
+
+  close_allowed();
+  packs.update();
+  EXPECT_EQ(packs.totals().joined, 2);
+  EXPECT_EQ(batteries[0].status.max_charge_current_dA, 270 * 2);
+
+  // Not allowed any more, no matter whether the contactors opened yet
+  allowed[1] = false;
+  batteries[1].status.voltage_dV = 3500;
+  packs.update();
+  EXPECT_EQ(packs.totals().joined, 1);
+}
+
+TEST_F(PackArrayTests, PackClosingItsOwnContactorsJoinsAfterDelay) {
+  add_packs(1);
+  DATALAYER_BATTERY_TYPE& battery = batteries[1];
+  battery = batteries[0];
+  ASSERT_TRUE(packs.add(battery, &allowed[1]));
+
+  for (int second = 1; second < PACK_JOIN_DELAY_S; second++) {
+    packs.update();
+    ASSERT_TRUE(allowed[1]);
+    EXPECT_EQ(packs.totals().joined, 1);
+  }
+  packs.update();
+  EXPECT_EQ(packs.totals().joined, 2);
+
+  // The delay starts over once it is let go
+  batteries[0].status.bms_status = FAULT;
+  packs.update();
+  EXPECT_EQ(packs.totals().joined, 1);
+  batteries[0].status.bms_status = ACTIVE;
+  packs.update();
+  EXPECT_EQ(packs.totals().joined, 1);
+}
+
+TEST_F(PackArrayTests, SocIsWeightedByCapacity) {
+  add_packs(2);
+  batteries[1].info.total_capacity_Wh = 10000;
+  batteries[1].status.real_soc = 9000;
+  batteries[1].status.remaining_capacity_Wh = 9000;
+  packs.update();
+  EXPECT_EQ(batteries[0].status.reported_soc, (5000 * 30000 + 9000 * 10000) / 40000);
+  EXPECT_EQ(batteries[0].status.reported_remaining_capacity_Wh, 24000);
+  EXPECT_EQ(packs.totals().remaining_capacity_Wh, 24000);
+}
+
+TEST_F(PackArrayTests, NearlyEmptyOrFullPackIsReported) {
+  add_packs(3);
+  batteries[2].status.real_soc = 50;
+  batteries[2].status.remaining_capacity_Wh = 15;
+  packs.update();
+  EXPECT_EQ(batteries[0].status.reported_soc, 50);
+  EXPECT_EQ(batteries[0].status.reported_remaining_capacity_Wh, 15);
+
+  // A full pack wins, to stop charging
+  batteries[1].status.real_soc = 9950;
+  batteries[1].status.remaining_capacity_Wh = 29850;
+  packs.update();
+  EXPECT_EQ(batteries[0].status.reported_soc, 9950);
+  EXPECT_EQ(batteries[0].status.reported_remaining_capacity_Wh, 29850);
+}
@@ -0,0 +1,81 @@
+#include <gtest/gtest.h>
+
+#include <string>
+#include "../Software/src/devboard/utils/perf_stats.h"
+
+TEST(CycleHistogramTests, BucketsAreContiguous) {
+  for (int i = 0; i < CycleHistogram::BUCKETS; i++) {
+    const uint64_t start = CycleHistogram::bucket_start(i);
+    const uint64_t end = CycleHistogram::bucket_start(i + 1) - 1;
+    EXPECT_EQ(CycleHistogram::bucket((uint32_t)start), i);
+    EXPECT_EQ(CycleHistogram::bucket((uint32_t)end), i);
+  }
+  EXPECT_EQ(CycleHistogram::bucket_start(CycleHistogram::BUCKETS), 1ull << 32);
+  EXPECT_EQ(CycleHistogram::bucket(0xFFFFFFFF), CycleHistogram::BUCKETS - 1);
+}
+
+TEST(CycleHistogramTests, EmptyHistogram) {
+  CycleHistogram histogram;
+
+  EXPECT_EQ(histogram.count(), 0u);
+  EXPECT_EQ(histogram.max(), 0u);
+  EXPECT_EQ(histogram.percentile(50), 0u);
+}
+
+TEST(CycleHistogramTests, PercentilesWithinBucketResolution) {
+  CycleHistogram histogram;
+  // 1..1000, p50 is 500 and p99 is 990
+  for (uint32_t value = 1; value <= 1000; value++) {
+    histogram.record(value);
+  }
+
+  EXPECT_EQ(histogram.count(), 1000u);
+  EXPECT_EQ(histogram.max(), 1000u);
+  EXPECT_GE(histogram.percentile(50), 500u);
+  EXPECT_LE(histogram.percentile(50), 500u * 5 / 4);
+  EXPECT_GE(histogram.percentile(99), 990u);
+  EXPECT_LE(histogram.percentile(99), 1000u);
+  EXPECT_EQ(histogram.percentile(100), 1000u);
+}
+
+TEST(CycleHistogramTests, RareOutlierOnlyShowsInMax) {
+  CycleHistogram histogram;
+  for (int i = 0; i < 999; i++) {
+    histogram.record(240);
+  }
+  histogram.record(2400000);
+
+  EXPECT_LE(histogram.percentile(99), 255u);
+  EXPECT_EQ(histogram.max(), 2400000u);
+
+  histogram.reset();
+  EXPECT_EQ(histogram.count(), 0u);
+  EXPECT_EQ(histogram.max(), 0u);
+}
+
+TEST(PerfStatsTests, SerializesStagesAndComponents) {
+  char json[1024];
+  const int8_t first = perf_register_transmitter("battery");
+  const int8_t second = perf_register_transmitter("battery");
+  perf_register_receiver("inverter");
+  EXPECT_GE(first, 0);
+  EXPECT_EQ(second, first + 1);
+
+  perf_count_task_overrun();
+  perf_record_transmitter(first, perf_cycles());
+  ASSERT_GT(perf_stats_serialize(json, sizeof(json)), 0u);
+  // Nothing is measured until performance measurement is enabled
+  EXPECT_EQ(std::string(json).find("stages"), std::string::npos);
+
+  perf_stats_init();
+  perf_record_stage(PERF_STAGE_COMM, perf_cycles() - 1000);
+  ASSERT_GT(perf_stats_serialize(json, sizeof(json)), 0u);
+  const std::string text = json;
+  EXPECT_NE(text.find("\"overruns\":1"), std::string::npos) << text;
+  EXPECT_NE(text.find("\"comm\":[1,"), std::string::npos) << text;
+  EXPECT_NE(text.find("\"battery\":[0,"), std::string::npos) << text;
+  EXPECT_NE(text.find("\"battery2\":[0,"), std::string::npos) << text;
+  EXPECT_NE(text.find("\"rx\":{\"inverter\":[0,"), std::string::npos) << text;
+
+  EXPECT_EQ(perf_stats_serialize(json, 16), 0u);
+}
@@ -0,0 +1,146 @@
+#include <gtest/gtest.h>
+
+#include <deque>
+#include <map>
+#include <vector>
+#include "../Software/src/communication/can/poll_scheduler.h"
+
+// An ECU that answers every ReadDataByIdentifier after a fixed delay, with the identifier as the value
+class FakeEcu {
+ public:
+  explicit FakeEcu(uint32_t delay_ms) : delay_ms(delay_ms) {}
+
+  void receive(const CAN_frame& frame) {
+    const uint16_t identifier = (frame.data.u8[2] << 8) | frame.data.u8[3];
+    requests.push_back(identifier);
+    pending.push_back({now + delay_ms, identifier});
+  }
+
+  void tick(IsoTpTransport& transport) {
+    while (!pending.empty() && pending.front().due_ms <= now) {
+      const uint16_t identifier = pending.front().identifier;
+      pending.pop_front();
+      if (silent.count(identifier)) {
+        continue;
+      }
+      CAN_frame frame = {};
+      frame.ID = 0x7EC;
+      frame.DLC = 8;
+      const uint8_t data[] = {0x05, 0x62, (uint8_t)(identifier >> 8), (uint8_t)identifier,
+                              (uint8_t)(identifier >> 8), (uint8_t)identifier, 0xAA, 0xAA};
+      memcpy(frame.data.u8, data, sizeof(data));
+      transport.handle_frame(frame, now);
+    }
+  }
+
+  struct Pending {
+    uint32_t due_ms;
+    uint16_t identifier;
+  };
+  uint32_t now = 0;
+  uint32_t delay_ms;
+  std::deque<Pending> pending;
+  std::vector<uint16_t> requests;
+  std::map<uint16_t, bool> silent;  // Identifiers never answered
+};
+
+static IsoTpConfig obd_config() {
+  IsoTpConfig config;
+  config.tx_id = 0x7E4;
+  config.rx_id = 0x7EC;
+  return config;
+}
+
+class PollSchedulerTests : public testing::Test {
+ protected:
+  PollSchedulerTests() { transport.add(&session); }
+
+  PollItem::ParseFunction keep() {
+    return [this](uint16_t identifier, const uint8_t* value, size_t) {
+      values[identifier] = (value[0] << 8) | value[1];
+    };
+  }
+
+  void run_until(uint32_t end_ms) {
+    for (; ecu.now <= end_ms; ecu.now++) {
+      ecu.tick(transport);
+      poller.service(ecu.now);
+      client.service(ecu.now);
+      transport.service(ecu.now);
+    }
+  }
+
+  FakeEcu ecu{10};
+  uint8_t buffer[64];
+  IsoTpSession session{obd_config(), buffer, sizeof(buffer)};
+  IsoTpTransport transport{[this](const CAN_frame& frame) { ecu.receive(frame); }};
+  UdsClient client{session};
+  PollScheduler poller{client};
+  std::map<uint16_t, uint16_t> values;
+};
+
+TEST_F(PollSchedulerTests, PollsAsFastAsTheEcuAnswers) {
+  poller.add({"Cells", 0x1E40, 100, 2, 60000, PollPriority::Normal, keep()});
+  run_until(1100);
+  // One request in flight at a time, answered after 10 ms
+  EXPECT_GE(ecu.requests.size(), 99u);
+  EXPECT_LE(ecu.requests.size(), 101u);
+  EXPECT_EQ(values[0x1E40], 0x1E40);
+  EXPECT_EQ(values[0x1E40 + 99], 0x1E40 + 99);
+  EXPECT_EQ(poller.stats().responses, 100u);
+  EXPECT_LT(poller.row_age_ms(0, ecu.now), 1100u);
+
+  // Then nothing while the values are fresh
+  const size_t sent = ecu.requests.size();
+  run_until(5000);
+  EXPECT_EQ(ecu.requests.size(), sent);
+}
+
+TEST_F(PollSchedulerTests, HighPriorityStaysFresh) {
+  const size_t soc = poller.add({"SOC", 0x028C, 1, 1, 200, PollPriority::High, keep()});
+  const size_t cells = poller.add({"Cells", 0x1E40, 108, 2, 1000, PollPriority::Normal, keep()});
+  run_until(10000);
+
+  // The cells cannot all be polled every second, the SOC still is every 200 ms
+  EXPECT_LE(poller.row_achieved_period_ms(soc), 220u);
+  EXPECT_LE(poller.row_age_ms(soc, ecu.now), 220u);
+  EXPECT_GT(poller.row_achieved_period_ms(cells), 1000u);
+  EXPECT_LT(poller.row_achieved_period_ms(cells), 1300u);
+  EXPECT_LE(poller.age_ms(0x028C, ecu.now), 220u);
+}
+
+TEST_F(PollSchedulerTests, MostOverdueFirst) {
+  poller.add({"Fast", 0x0100, 1, 0, 100, PollPriority::Normal, keep()});
+  poller.add({"Slow", 0x0200, 1, 0, 1000, PollPriority::Normal, keep()});
+  run_until(50);
+  ASSERT_EQ(ecu.requests, (std::vector<uint16_t>{0x0100, 0x0200}));
+  run_until(3000);
+  int fast = 0;
+  int slow = 0;
+  for (auto identifier : ecu.requests) {
+    (identifier == 0x0100 ? fast : slow)++;
+  }
+  EXPECT_NEAR(fast, 30, 2);
+  EXPECT_NEAR(slow, 3, 1);
+}
+
+TEST_F(PollSchedulerTests, LimitAndFailures) {
+  const size_t cells = poller.add({"Cells", 0x1E40, 108, 2, 1000, PollPriority::Normal, keep()});
+  poller.limit(cells, 96);
+  ecu.silent[0x1E40] = true;
+  run_until(1000 + UDS_TIMEOUT_MS + 100);
+
+  EXPECT_EQ(values.count(0x1E40 + 96), 0u);
+  EXPECT_EQ(values.count(0x1E40 + 95), 1u);
+  EXPECT_EQ(poller.stats().failures, 1u);
+  EXPECT_EQ(poller.age_ms(0x1E40, ecu.now), POLL_NEVER);
+  EXPECT_EQ(poller.row_age_ms(cells, ecu.now), POLL_NEVER);
+  EXPECT_EQ(poller.row_count(cells), 96);
+}
+
+TEST_F(PollSchedulerTests, ShortResponsesAreNotParsed) {
+  poller.add({"Long", 0x0300, 1, 4, 1000, PollPriority::Normal, keep()});
+  run_until(100);
+  EXPECT_EQ(poller.stats().malformed, 1u);
+  EXPECT_TRUE(values.empty());
+}
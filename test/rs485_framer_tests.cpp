@@ -0,0 +1,90 @@
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+#include "../Software/src/communication/rs485/rs485_framer.h"
+
+typedef std::vector<uint8_t> Bytes;
+
+// Feed bytes to the framer and collect the frames it completes
+static std::vector<Bytes> feed(Rs485Framer& framer, const Bytes& bytes) {
+  std::vector<Bytes> frames;
+  for (uint8_t byte : bytes) {
+    if (framer.push(byte)) {
+      frames.emplace_back(framer.frame(), framer.frame() + framer.frame_length());
+    }
+  }
+  return frames;
+}
+
+TEST(Rs485FramerTests, DelimiterEndsFrame) {
+  Rs485Framer framer(Rs485FrameFormat::delimited(0x00, 300));
+  auto frames = feed(framer, {0x07, 0x62, 0xFF, 0x00, 0x03, 0x11, 0x00, 0x05});
+  ASSERT_EQ(frames.size(), 2u);
+  EXPECT_EQ(frames[0], (Bytes{0x07, 0x62, 0xFF, 0x00}));
+  EXPECT_EQ(frames[1], (Bytes{0x03, 0x11, 0x00}));
+
+  // The partial frame is continued by later bytes
+  frames = feed(framer, {0x06, 0x00});
+  ASSERT_EQ(frames.size(), 1u);
+  EXPECT_EQ(frames[0], (Bytes{0x05, 0x06, 0x00}));
+  EXPECT_EQ(framer.framing_errors(), 0u);
+}
+
+TEST(Rs485FramerTests, DelimiterDropsOverlongFrames) {
+  Rs485Framer framer(Rs485FrameFormat::delimited(0x00, 4));
+  auto frames = feed(framer, {1, 2, 3, 4, 5, 6, 0x00, 7, 0x00});
+  // The first four bytes are dropped, the rest is read as a frame
+  ASSERT_EQ(frames.size(), 2u);
+  EXPECT_EQ(frames[0], (Bytes{5, 6, 0x00}));
+  EXPECT_EQ(frames[1], (Bytes{7, 0x00}));
+  EXPECT_EQ(framer.framing_errors(), 1u);
+}
+
+TEST(Rs485FramerTests, LengthFramesSyncOnStartByte) {
+  // Same layout as the DALY BMS: sync, address, command, payload length, payload, checksum
+  Rs485Framer framer(Rs485FrameFormat::length_prefixed(0xA5, 3, 5, 13));
+  Bytes daly = {0xA5, 0x01, 0x90, 0x08, 1, 2, 3, 4, 5, 6, 7, 8, 0x7E};
+  Bytes bytes = {0x11, 0x22};
+  bytes.insert(bytes.end(), daly.begin(), daly.end());
+  bytes.insert(bytes.end(), daly.begin(), daly.end());
+
+  auto frames = feed(framer, bytes);
+  ASSERT_EQ(frames.size(), 2u);
+  EXPECT_EQ(frames[0], daly);
+  EXPECT_EQ(frames[1], daly);
+  // The run of noise before the first frame counts once
+  EXPECT_EQ(framer.framing_errors(), 1u);
+}
+
+TEST(Rs485FramerTests, LengthResyncsAfterGarbledLength) {
+  Rs485Framer framer(Rs485FrameFormat::length_prefixed(0xA5, 3, 5, 13));
+  auto frames = feed(framer, {0xA5, 0x01, 0x90, 0xF0, 0x33, 0xA5, 0x01, 0x90, 0x00, 0x01});
+  ASSERT_EQ(frames.size(), 1u);
+  EXPECT_EQ(frames[0], (Bytes{0xA5, 0x01, 0x90, 0x00, 0x01}));
+  EXPECT_EQ(framer.framing_errors(), 1u);
+}
+
+TEST(Rs485FramerTests, IdleDropsPartialLengthFrame) {
+  Rs485Framer framer(Rs485FrameFormat::length_prefixed(0xA5, 3, 5, 13));
+  EXPECT_TRUE(feed(framer, {0xA5, 0x01, 0x90}).empty());
+  EXPECT_FALSE(framer.idle());
+  EXPECT_EQ(framer.framing_errors(), 1u);
+
+  auto frames = feed(framer, {0xA5, 0x01, 0x90, 0x00, 0x01});
+  ASSERT_EQ(frames.size(), 1u);
+}
+
+TEST(Rs485FramerTests, TimeoutEndsFrameOnIdle) {
+  Rs485Framer framer(Rs485FrameFormat::idle_terminated(256));
+  EXPECT_FALSE(framer.idle());  // Nothing received yet
+
+  EXPECT_TRUE(feed(framer, {0x01, 0x03, 0x00, 0x10}).empty());
+  ASSERT_TRUE(framer.idle());
+  EXPECT_EQ(Bytes(framer.frame(), framer.frame() + framer.frame_length()), (Bytes{0x01, 0x03, 0x00, 0x10}));
+
+  EXPECT_TRUE(feed(framer, {0x02}).empty());
+  ASSERT_TRUE(framer.idle());
+  EXPECT_EQ(framer.frame_length(), 1u);
+  EXPECT_EQ(framer.framing_errors(), 0u);
+}
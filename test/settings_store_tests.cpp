@@ -0,0 +1,101 @@
+#include <gtest/gtest.h>
+
+#include <string.h>
+#include <vector>
+#include "../Software/src/communication/nvm/settings_store.h"
+#include "../Software/src/devboard/utils/crc.h"
+
+static std::vector<uint8_t> encode(const SettingsShadow& shadow) {
+  std::vector<uint8_t> blob(SETTINGS_BLOB_MAX_SIZE);
+  blob.resize(shadow.encode(blob.data(), blob.size()));
+  return blob;
+}
+
+TEST(SettingsStoreTests, RoundTrip) {
+  static SettingsShadow shadow;
+  shadow.clear();
+  const int batttype = SettingsShadow::find("BATTTYPE");
+  const int minpercentage = SettingsShadow::find("MINPERCENTAGE");
+  const int ssid = SettingsShadow::find("SSID");
+  const int staticip = SettingsShadow::find("STATICIP");
+  ASSERT_GE(batttype, 0);
+  ASSERT_GE(ssid, 0);
+  EXPECT_EQ(SettingsShadow::find("NOSUCHSETTING"), -1);
+
+  shadow.set_number(batttype, 12);
+  shadow.set_number(minpercentage, (uint32_t)-5);
+  shadow.set_string(ssid, "network");
+  const auto blob = encode(shadow);
+  ASSERT_GT(blob.size(), 0u);
+
+  static SettingsShadow loaded;
+  ASSERT_TRUE(loaded.decode(blob.data(), blob.size()));
+  EXPECT_TRUE(loaded.exists(batttype));
+  EXPECT_EQ(loaded.get_number(batttype, 0), 12u);
+  EXPECT_EQ((int32_t)loaded.get_number(minpercentage, 0), -5);
+  EXPECT_STREQ(loaded.get_string(ssid, ""), "network");
+  EXPECT_FALSE(loaded.exists(staticip));
+  EXPECT_EQ(loaded.get_number(staticip, 7), 7u);
+}
+
+TEST(SettingsStoreTests, SetReportsChanges) {
+  static SettingsShadow shadow;
+  shadow.clear();
+  const int port = SettingsShadow::find("MQTTPORT");
+  const int server = SettingsShadow::find("MQTTSERVER");
+
+  EXPECT_TRUE(shadow.set_number(port, 0));  // Not stored before
+  EXPECT_FALSE(shadow.set_number(port, 0));
+  EXPECT_TRUE(shadow.set_number(port, 1883));
+  EXPECT_TRUE(shadow.set_string(server, ""));
+  EXPECT_FALSE(shadow.set_string(server, ""));
+  EXPECT_TRUE(shadow.set_string(server, "broker"));
+  EXPECT_FALSE(shadow.set_string(server, "broker"));
+}
+
+TEST(SettingsStoreTests, RejectsDamagedBlob) {
+  static SettingsShadow shadow;
+  shadow.clear();
+  shadow.set_string(SettingsShadow::find("HOSTNAME"), "emulator");
+  auto blob = encode(shadow);
+
+  blob[blob.size() / 2] ^= 0x01;
+  EXPECT_FALSE(shadow.decode(blob.data(), blob.size()));
+  EXPECT_FALSE(shadow.exists(SettingsShadow::find("HOSTNAME")));
+
+  EXPECT_FALSE(shadow.decode(blob.data(), 3));
+  EXPECT_FALSE(shadow.decode(nullptr, 0));
+}
+
+TEST(SettingsStoreTests, DropsUnknownSettings) {
+  // A blob from a firmware with one more setting, and one stored as another type
+  std::vector<uint8_t> blob = {0x42, 0x45, 0x45, 0x53, SETTINGS_BLOB_VERSION, 0, 3, 0};
+  auto add = [&blob](const char* key, SettingType type, uint32_t value) {
+    blob.push_back(strlen(key));
+    blob.insert(blob.end(), key, key + strlen(key));
+    blob.push_back((uint8_t)type);
+    for (int i = 0; i < 4; i++) {
+      blob.push_back(value >> (8 * i));
+    }
+  };
+  add("NEWSETTING", SettingType::UInt, 1);
+  add("STATICIP", SettingType::UInt, 2);
+  add("MQTTPORT", SettingType::UInt, 1883);
+  const uint32_t crc = Crc32::calculate(blob.data(), blob.size());
+  for (int i = 0; i < 4; i++) {
+    blob.push_back(crc >> (8 * i));
+  }
+
+  static SettingsShadow shadow;
+  ASSERT_TRUE(shadow.decode(blob.data(), blob.size()));
+  EXPECT_FALSE(shadow.exists(SettingsShadow::find("STATICIP")));
+  EXPECT_EQ(shadow.get_number(SettingsShadow::find("MQTTPORT"), 0), 1883u);
+}
+
+TEST(SettingsStoreTests, TooSmallBuffer) {
+  static SettingsShadow shadow;
+  shadow.clear();
+  shadow.set_string(SettingsShadow::find("MQTTSERVER"), std::string(200, 'x').c_str());
+  uint8_t buffer[64];
+  EXPECT_EQ(shadow.encode(buffer, sizeof(buffer)), 0u);
+}
@@ -0,0 +1,249 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <random>
+#include <string>
+#include <vector>
+#include "../Software/src/devboard/utils/time_series.h"
+
+struct Sample {
+  uint64_t timestamp_ms;
+  std::vector<int32_t> values;
+};
+
+class TimeSeriesTests : public testing::Test {
+ protected:
+  uint8_t storage[8 * TIME_SERIES_BLOCK_SIZE];
+  TimeSeries series{storage, sizeof(storage)};
+
+  std::vector<Sample> decode_all() {
+    std::vector<Sample> samples;
+    uint8_t block[TIME_SERIES_BLOCK_SIZE];
+    TimeSeriesDecoder decoder;
+    for (uint32_t sequence = series.oldest(); sequence != series.end(); sequence++) {
+      EXPECT_TRUE(series.copy_block(sequence, block));
+      decoder.start(block);
+      EXPECT_EQ(decoder.header().sequence, sequence);
+      while (decoder.next()) {
+        const int32_t* values = decoder.values();
+        samples.push_back({decoder.timestamp_ms(), {values, values + decoder.header().channels}});
+      }
+    }
+    return samples;
+  }
+
+  std::string export_all(uint64_t from_ms, uint64_t to_ms, TimeSeriesFormat format, const char* const* names) {
+    TimeSeriesExport history_export(series, from_ms, to_ms, format, names, "cell_");
+    std::string text;
+    uint8_t chunk[7];  // Smaller than a field, to cut them
+    size_t length;
+    while ((length = history_export.read(chunk, sizeof(chunk))) > 0) {
+      text.append((const char*)chunk, length);
+    }
+    return text;
+  }
+};
+
+TEST_F(TimeSeriesTests, DecodesWhatWasAppended) {
+  std::mt19937 random(3);
+  std::vector<Sample> appended;
+  uint64_t now = 5000;
+  int32_t values[8] = {3700, 0, 5000, 5000, 200, 250, 3650, 3700};
+  for (int i = 0; i < 300; i++) {
+    now += 1000 + (i % 50 == 0 ? random() % 300 : 0);  // Now and then a late sample
+    values[0] += (int32_t)(random() % 5) - 2;
+    values[1] = (int32_t)(random() % 4000) - 2000;
+    values[7] = i % 3 == 0 ? INT32_MIN : INT32_MAX;  // Largest possible changes
+    ASSERT_TRUE(series.append(now, values, 8));
+    appended.push_back({now, {values, values + 8}});
+  }
+
+  const std::vector<Sample> decoded = decode_all();
+  ASSERT_EQ(decoded.size(), appended.size());
+  for (size_t i = 0; i < decoded.size(); i++) {
+    EXPECT_EQ(decoded[i].timestamp_ms, appended[i].timestamp_ms);
+    EXPECT_EQ(decoded[i].values, appended[i].values);
+  }
+  EXPECT_EQ(series.stats().records, 300);
+  EXPECT_EQ(series.stats().dropped_blocks, 0);
+}
+
+TEST_F(TimeSeriesTests, UnchangedSamplesTakeThreeBytes) {
+  int32_t values[96];
+  for (int i = 0; i < 96; i++) {
+    values[i] = 3700 + i % 5;
+  }
+  series.append(0, values, 96);
+  const uint64_t first_bytes = series.stats().bytes;
+  for (int i = 1; i < 100; i++) {
+    series.append(60000 * i, values, 96);
+  }
+  EXPECT_EQ(series.stats().blocks, 1);
+  // The first interval takes three bytes, as the change from none
+  EXPECT_EQ(series.stats().bytes - first_bytes, 99 * 3 + 2);
+
+  // One value changing splits the run
+  values[50]++;
+  series.append(100 * 60000, values, 96);
+  EXPECT_EQ(series.stats().bytes - first_bytes, 99 * 3 + 2 + 6);
+  EXPECT_EQ(decode_all().back().values, std::vector<int32_t>(values, values + 96));
+}
+
+TEST_F(TimeSeriesTests, OldestBlocksAreDropped) {
+  int32_t values[192];
+  for (int i = 0; i < 100; i++) {
+    for (int j = 0; j < 192; j++) {
+      values[j] = 3600 + j + i * 3;  // All changing
+    }
+    series.append(i * 60000ull, values, 192);
+  }
+  EXPECT_GT(series.stats().dropped_blocks, 0);
+  EXPECT_EQ(series.end() - series.oldest(), series.capacity_blocks());
+  uint8_t block[TIME_SERIES_BLOCK_SIZE];
+  EXPECT_FALSE(series.copy_block(series.oldest() - 1, block));
+
+  const std::vector<Sample> decoded = decode_all();
+  ASSERT_FALSE(decoded.empty());
+  EXPECT_EQ(decoded.back().timestamp_ms, 99 * 60000ull);
+  EXPECT_EQ(decoded.back().values[191], 3600 + 191 + 99 * 3);
+  for (size_t i = 1; i < decoded.size(); i++) {
+    EXPECT_EQ(decoded[i].timestamp_ms, decoded[i - 1].timestamp_ms + 60000);
+  }
+}
+
+TEST_F(TimeSeriesTests, CorrelatedChannelsShareChanges) {
+  TimeSeries cells(storage, sizeof(storage), TIME_SERIES_CORRELATED);
+  std::mt19937 random(5);
+  int32_t values[96];
+  for (int j = 0; j < 96; j++) {
+    values[j] = 3700 + random() % 20;
+  }
+  cells.append(0, values, 96);
+  const uint64_t first_bytes = cells.stats().bytes;
+  // All cells rising together, one of them a little more
+  for (int j = 0; j < 96; j++) {
+    values[j] += 4;
+  }
+  values[10] += 1;
+  cells.append(60000, values, 96);
+  EXPECT_LE(cells.stats().bytes - first_bytes, 3 + 1 + 2 + 2 + 2);
+
+  std::vector<std::vector<int32_t>> appended = {};
+  for (int i = 0; i < 30; i++) {
+    for (int j = 0; j < 96; j++) {
+      values[j] = j % 7 == 0 ? (int32_t)random() : values[j] + (int)(random() % 3) - 1;
+    }
+    cells.append(120000 + 60000 * i, values, 96);
+    appended.push_back({values, values + 96});
+  }
+  uint8_t block[TIME_SERIES_BLOCK_SIZE];
+  TimeSeriesDecoder decoder;
+  std::vector<std::vector<int32_t>> decoded;
+  for (uint32_t sequence = cells.oldest(); sequence != cells.end(); sequence++) {
+    ASSERT_TRUE(cells.copy_block(sequence, block));
+    decoder.start(block);
+    while (decoder.next()) {
+      decoded.push_back({decoder.values(), decoder.values() + 96});
+    }
+  }
+  ASSERT_GE(decoded.size(), appended.size());
+  EXPECT_TRUE(std::equal(appended.begin(), appended.end(), decoded.end() - appended.size()));
+}
+
+TEST_F(TimeSeriesTests, ChannelCountChangeStartsBlock) {
+  const int32_t values[4] = {1, 2, 3, 4};
+  series.append(0, values, 4);
+  series.append(1000, values, 4);
+  series.append(2000, values, 3);
+  EXPECT_EQ(series.stats().blocks, 2);
+  EXPECT_FALSE(series.append(3000, values, 0));
+
+  const std::vector<Sample> decoded = decode_all();
+  ASSERT_EQ(decoded.size(), 3);
+  EXPECT_EQ(decoded[2].values, std::vector<int32_t>({1, 2, 3}));
+}
+
+TEST_F(TimeSeriesTests, ExportsRangeAsCsv) {
+  const char* const names[] = {"voltage_dV", "current_dA"};
+  for (int i = 0; i < 5; i++) {
+    const int32_t values[2] = {3700 + i, -10 * i};
+    series.append(1000 * i, values, 2);
+  }
+  EXPECT_EQ(export_all(1000, 3000, TimeSeriesFormat::Csv, names),
+            "millis,voltage_dV,current_dA\n1000,3701,-10\n2000,3702,-20\n3000,3703,-30\n");
+  EXPECT_EQ(export_all(0, 0, TimeSeriesFormat::Csv, nullptr), "millis,cell_1,cell_2\n0,3700,0\n");
+  EXPECT_EQ(export_all(5000, UINT64_MAX, TimeSeriesFormat::Csv, names), "");
+}
+
+TEST_F(TimeSeriesTests, CsvHeaderFollowsChannelCount) {
+  const int32_t values[3] = {3700, 3701, 3702};
+  series.append(0, values, 2);
+  series.append(60000, values, 2);
+  series.append(120000, values, 3);  // A cell more
+  EXPECT_EQ(export_all(0, UINT64_MAX, TimeSeriesFormat::Csv, nullptr),
+            "millis,cell_1,cell_2\n0,3700,3701\n60000,3700,3701\n"
+            "millis,cell_1,cell_2,cell_3\n120000,3700,3701,3702\n");
+}
+
+TEST_F(TimeSeriesTests, ExportsBlocksAsBinary) {
+  int32_t values[96];
+  for (int i = 0; i < 60; i++) {
+    for (int j = 0; j < 96; j++) {
+      values[j] = 3700 + j + i;
+    }
+    series.append(60000 * i, values, 96);
+  }
+  ASSERT_GT(series.end() - series.oldest(), 2);
+
+  const std::string binary = export_all(0, UINT64_MAX, TimeSeriesFormat::Binary, nullptr);
+  TimeSeriesDecoder decoder;
+  size_t position = 0;
+  int records = 0;
+  while (position < binary.size()) {
+    uint8_t block[TIME_SERIES_BLOCK_SIZE];
+    TimeSeriesBlockHeader header;
+    memcpy(&header, binary.data() + position, sizeof(header));
+    ASSERT_LE(position + sizeof(header) + header.used, binary.size());
+    memcpy(block, binary.data() + position, sizeof(header) + header.used);
+    position += sizeof(header) + header.used;
+    decoder.start(block);
+    while (decoder.next()) {
+      EXPECT_EQ(decoder.timestamp_ms(), 60000ull * records);
+      records++;
+    }
+  }
+  EXPECT_EQ(records, 60);
+  EXPECT_EQ(decoder.values()[95], 3700 + 95 + 59);
+}
+
+TEST_F(TimeSeriesTests, ExportSkipsBlocksDroppedWhileStreaming) {
+  int32_t values[192];
+  for (int i = 0; i < 40; i++) {
+    std::fill(values, values + 192, i);
+    series.append(i, values, 192);
+  }
+  TimeSeriesExport history_export(series, 0, UINT64_MAX, TimeSeriesFormat::Csv, nullptr, "cell_");
+  uint8_t chunk[64];
+  ASSERT_GT(history_export.read(chunk, sizeof(chunk)), 0);
+  for (int i = 40; i < 200; i++) {
+    std::fill(values, values + 192, i);
+    series.append(i, values, 192);
+  }
+  std::string text;
+  size_t length;
+  while ((length = history_export.read(chunk, sizeof(chunk))) > 0) {
+    text.append((const char*)chunk, length);
+  }
+  EXPECT_NE(text.find("\n199,199,"), std::string::npos);
+}
+
+TEST_F(TimeSeriesTests, ClearDropsAllSamples) {
+  const int32_t values[1] = {1};
+  series.append(0, values, 1);
+  series.clear();
+  EXPECT_EQ(series.oldest(), series.end());
+  series.append(1000, values, 1);
+  const std::vector<Sample> decoded = decode_all();
+  ASSERT_EQ(decoded.size(), 1);
+  EXPECT_EQ(decoded[0].timestamp_ms, 1000);
+}
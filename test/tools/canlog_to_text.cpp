@@ -0,0 +1,59 @@
+// Offline converter for binary CAN logs recorded to SD card (canlog.bin).
+// Writes the log as candump/SavvyCAN compatible text, same as the webserver CAN log export.
+//
+// Usage: canlog_to_text canlog.bin [canlog.txt]
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+#include "../../Software/src/devboard/sdcard/can_log_format.h"
+
+int main(int argc, char** argv) {
+  if (argc < 2) {
+    std::cerr << "Usage: " << argv[0] << " canlog.bin [canlog.txt]" << std::endl;
+    return 1;
+  }
+
+  std::ifstream in(argv[1], std::ios::binary);
+  if (!in) {
+    std::cerr << "Could not open " << argv[1] << std::endl;
+    return 1;
+  }
+  std::vector<uint8_t> log((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+
+  if (log.size() < CAN_LOG_MAGIC_SIZE || memcmp(log.data(), CAN_LOG_MAGIC, CAN_LOG_MAGIC_SIZE) != 0) {
+    std::cerr << argv[1] << " is not a binary CAN log" << std::endl;
+    return 1;
+  }
+
+  FILE* out = argc > 2 ? fopen(argv[2], "w") : stdout;
+  if (out == nullptr) {
+    std::cerr << "Could not open " << argv[2] << std::endl;
+    return 1;
+  }
+
+  size_t pos = CAN_LOG_MAGIC_SIZE;
+  size_t frames = 0;
+  CAN_log_record record;
+  char line[CAN_LOG_MAX_TEXT_LINE];
+
+  while (pos < log.size()) {
+    size_t used = can_log_decode(log.data() + pos, log.size() - pos, record);
+    if (used == 0 || used == SIZE_MAX) {
+      std::cerr << "Log ends with an incomplete or invalid record at offset " << pos << std::endl;
+      break;
+    }
+    fwrite(line, 1, can_log_format_text(record, line, sizeof(line)), out);
+    pos += used;
+    frames++;
+  }
+
+  if (out != stdout) {
+    fclose(out);
+  }
+  std::cerr << frames << " frames converted" << std::endl;
+  return 0;
+}
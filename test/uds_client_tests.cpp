@@ -0,0 +1,151 @@
+#include <gtest/gtest.h>
+
+#include <vector>
+#include "../Software/src/communication/can/uds_client.h"
+#include "utils/utils.h"
+
+struct Response {
+  UdsResult result;
+  std::vector<uint8_t> data;
+};
+
+// The BMW iX SME
+static IsoTpConfig sme_config() {
+  IsoTpConfig config;
+  config.tx_id = 0x6F4;
+  config.rx_id = 0x607;
+  config.tx_extension = 0x07;
+  config.rx_extension = 0xF4;
+  config.FD = true;
+  config.block_size = 2;
+  return config;
+}
+
+class UdsClientTests : public testing::Test {
+ protected:
+  UdsClientTests() { transport.add(&session); }
+
+  UdsClient::ResponseFunction keep() {
+    return [this](UdsResult result, const uint8_t* data, size_t length) {
+      responses.push_back({result, std::vector<uint8_t>(data, data + length)});
+    };
+  }
+
+  void tick(uint32_t now_ms) {
+    client.service(now_ms);
+    transport.service(now_ms);
+  }
+
+  uint8_t buffer[128];
+  IsoTpSession session{sme_config(), buffer, sizeof(buffer)};
+  std::vector<CAN_frame> sent;
+  IsoTpTransport transport{[this](const CAN_frame& frame) { sent.push_back(frame); }};
+  UdsClient client{session};
+  std::vector<Response> responses;
+};
+
+// Replays the responses of a BMW iX SME to three queued requests
+TEST_F(UdsClientTests, BmwIxLog) {
+  const auto log = parse_can_log_file("../can_log_based/uds_logs/bmw_ix_sme.txt");
+  ASSERT_EQ(log.size(), 7u);
+
+  ASSERT_TRUE(client.read_data_by_identifier(0xE561, keep()));
+  ASSERT_TRUE(client.read_data_by_identifier(0xE554, keep()));
+  ASSERT_TRUE(client.read_data_by_identifier(0xE5FF, keep()));
+  EXPECT_EQ(client.pending(), 3u);
+
+  uint32_t now = 0;
+  for (const auto& frame : log) {
+    tick(now);
+    now += 10;
+    transport.handle_frame(frame, now);
+  }
+  tick(now);
+
+  ASSERT_EQ(responses.size(), 3u);
+  EXPECT_EQ(responses[0].result, UdsResult::Positive);
+  ASSERT_EQ(responses[0].data.size(), 7u);
+  const int32_t current_dA = (responses[0].data[3] << 24) | (responses[0].data[4] << 16) |
+                             (responses[0].data[5] << 8) | responses[0].data[6];
+  EXPECT_EQ(current_dA, -123);
+
+  EXPECT_EQ(responses[1].result, UdsResult::Positive);
+  ASSERT_EQ(responses[1].data.size(), 19u);
+  for (int cell = 0; cell < 8; cell++) {
+    EXPECT_EQ((responses[1].data[3 + 2 * cell] << 8) | responses[1].data[4 + 2 * cell], 3600 + cell);
+  }
+
+  // Response pending was waited out
+  EXPECT_EQ(responses[2].result, UdsResult::Negative);
+  EXPECT_EQ(responses[2].data, (std::vector<uint8_t>{0x7F, 0x22, 0x31}));
+
+  // Requests, and the flow control after the first frame and after each block of two
+  std::vector<std::vector<uint8_t>> starts;
+  for (const auto& frame : sent) {
+    starts.push_back(std::vector<uint8_t>(frame.data.u8, frame.data.u8 + 5));
+  }
+  EXPECT_EQ(starts, (std::vector<std::vector<uint8_t>>{{0x07, 0x03, 0x22, 0xE5, 0x61},
+                                                       {0x07, 0x03, 0x22, 0xE5, 0x54},
+                                                       {0x07, 0x30, 0x02, 0x00, 0xAA},
+                                                       {0x07, 0x30, 0x02, 0x00, 0xAA},
+                                                       {0x07, 0x03, 0x22, 0xE5, 0xFF}}));
+
+  const UdsStats& stats = client.stats();
+  EXPECT_EQ(stats.requests, 3u);
+  EXPECT_EQ(stats.positive, 2u);
+  EXPECT_EQ(stats.negative, 1u);
+  EXPECT_EQ(stats.last_negative_code, 0x31);
+  EXPECT_EQ(stats.last_latency_ms, 20);  // The pending response took a frame longer
+  EXPECT_EQ(stats.max_latency_ms, 40);
+  EXPECT_EQ(session.stats().received, 4u);
+  EXPECT_TRUE(client.idle());
+}
+
+TEST_F(UdsClientTests, TimeoutMovesToNextRequest) {
+  client.read_data_by_identifier(0xE561, keep(), 100);
+  client.read_data_by_identifier(0xE554, keep());
+  tick(0);
+  EXPECT_EQ(sent.size(), 1u);
+  tick(99);
+  EXPECT_TRUE(responses.empty());
+  tick(100);
+  ASSERT_EQ(responses.size(), 1u);
+  EXPECT_EQ(responses[0].result, UdsResult::Timeout);
+  EXPECT_EQ(sent.size(), 2u);  // The next request went out in the same tick
+  EXPECT_EQ(client.stats().timeouts, 1u);
+
+  // A late answer to the first request is not taken for the second
+  CAN_frame late = {};
+  late.ID = 0x607;
+  late.DLC = 8;
+  const uint8_t data[] = {0xF4, 0x05, 0x62, 0xE5, 0x61, 0x00, 0x01, 0xAA};
+  memcpy(late.data.u8, data, sizeof(data));
+  transport.handle_frame(late, 110);
+  EXPECT_EQ(responses.size(), 1u);
+  EXPECT_EQ(client.pending(), 1u);
+}
+
+TEST_F(UdsClientTests, CallbackCanQueueNext) {
+  int answered = 0;
+  std::function<void(UdsResult, const uint8_t*, size_t)> again = [&](UdsResult, const uint8_t*, size_t) {
+    if (++answered < 3) {
+      client.read_data_by_identifier(0x1234, again, 10);
+    }
+  };
+  client.read_data_by_identifier(0x1234, again, 10);
+  for (uint32_t now = 0; now <= 40; now += 10) {
+    tick(now);
+  }
+  EXPECT_EQ(answered, 3);
+  EXPECT_EQ(client.stats().timeouts, 3u);
+}
+
+TEST_F(UdsClientTests, QueueFull) {
+  for (int i = 0; i < UDS_QUEUE_SIZE; i++) {
+    EXPECT_TRUE(client.read_data_by_identifier(i, keep()));
+  }
+  EXPECT_FALSE(client.read_data_by_identifier(0xFFFF, keep()));
+  uint8_t too_long[UDS_MAX_REQUEST_LENGTH + 1] = {};
+  EXPECT_FALSE(client.request(too_long, sizeof(too_long), keep()));
+  EXPECT_EQ(client.stats().dropped, 2u);
+}
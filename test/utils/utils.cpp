@@ -74,7 +74,7 @@ CAN_frame parse_can_log_line(const std::string& logLine) {
   if (ss.fail() || dummy != '[') {
     throw std::runtime_error("Invalid format: Missing opening bracket for data length.");
   }
-  ss >> dlc_val;
+  ss >> std::dec >> dlc_val;
   frame.DLC = static_cast<uint8_t>(dlc_val);
   ss >> dummy;  // Consume ']'
   if (ss.fail() || dummy != ']') {